@@ -0,0 +1,88 @@
+/*
+ * Measures the cost of the mat4/vec4 operations performed per frame and per
+ * tile; for profiling purposes only.
+ */
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "math/linear_algebra.h"
+
+using namespace std;
+
+
+namespace
+{
+
+// Keeps the compiler from discarding the benchmarked computations
+volatile float sink;
+
+// Camera and buffer poses, as rendered by the stages
+const int pose_count = 1024;
+mat4 poses[pose_count];
+vec4 points[pose_count];
+
+
+template <typename Operation>
+void run(const string& name, int iterations, Operation operation)
+{
+    const auto start = chrono::steady_clock::now();
+
+    for (int i = 0; i < iterations; ++i) {
+        operation(i);
+    }
+
+    const auto end = chrono::steady_clock::now();
+
+    cout << name << ": "
+         << chrono::duration<double, nano>(end - start).count() / iterations
+         << " ns" << endl;
+}
+
+
+void make_poses(const mat4& projection)
+{
+    for (int i = 0; i < pose_count; ++i) {
+        mat4 pose;
+        pose.set_from_srt(
+            2.f + i % 7, 3.f, 1.f, 0.1f * (i % 5), 10.f, -4.f, 0.f);
+        poses[i]  = projection * pose;
+        points[i] = vec4(static_cast<float>(i), 1.f, 0.f, 1.f);
+    }
+}
+
+} // namespace
+
+
+int main()
+{
+    const int iterations = 10000000;
+
+    mat4 projection;
+    projection.set_ortho_projection(640.f, 480.f, -1.f, 1.f);
+    make_poses(projection);
+
+    run("mat4 * mat4", iterations, [](int i) {
+        sink = (poses[i % pose_count] * poses[(i + 1) % pose_count]).data()[0];
+    });
+
+    run("mat4 * vec4", iterations, [](int i) {
+        sink = (poses[i % pose_count] * points[(i + 1) % pose_count]).x();
+    });
+
+    run("vec4 arithmetic", iterations, [](int i) {
+        const vec4& a = points[i % pose_count];
+        const vec4& b = points[(i + 1) % pose_count];
+        sink          = (a + b - a * 0.5f).x();
+    });
+
+    run("mat4::inv", iterations, [](int i) {
+        sink = poses[i % pose_count].inv().data()[0];
+    });
+
+    run("mat4::affine_inv", iterations, [](int i) {
+        sink = poses[i % pose_count].affine_inv().data()[0];
+    });
+
+    return 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * Measures the cost of building and sending a SetAvailableSymbols message;
+ * for profiling purposes only.
+ */
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <string>
+
+#include <QBuffer>
+
+#include "ipc/message_exchange.h"
+
+using namespace std;
+
+
+namespace
+{
+
+deque<string> make_symbols(size_t count)
+{
+    deque<string> symbols;
+    for (size_t i = 0; i < count; ++i) {
+        symbols.push_back("frame_buffer_" + to_string(i));
+    }
+    return symbols;
+}
+
+
+void run(size_t symbol_count, int iterations)
+{
+    const deque<string> symbols = make_symbols(symbol_count);
+
+    QByteArray output;
+    QBuffer device(&output);
+    device.open(QIODevice::WriteOnly);
+
+    chrono::nanoseconds build_time(0);
+    chrono::nanoseconds send_time(0);
+
+    for (int i = 0; i < iterations; ++i) {
+        device.seek(0);
+
+        const auto start = chrono::steady_clock::now();
+
+        MessageComposer message_composer;
+        message_composer.push(MessageType::SetAvailableSymbols).push(symbols);
+
+        const auto built = chrono::steady_clock::now();
+
+        message_composer.send(&device);
+
+        const auto sent = chrono::steady_clock::now();
+
+        build_time += built - start;
+        send_time += sent - built;
+    }
+
+    const auto per_message = [iterations](chrono::nanoseconds total) {
+        return chrono::duration<double, micro>(total).count() / iterations;
+    };
+
+    cout << symbol_count << " symbols: build " << per_message(build_time)
+         << " us, send " << per_message(send_time) << " us ("
+         << output.size() << " bytes)" << endl;
+}
+
+} // namespace
+
+
+int main()
+{
+    run(1000, 1000);
+    run(10000, 100);
+    run(100000, 10);
+
+    return 0;
+}
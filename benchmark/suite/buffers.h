@@ -0,0 +1,133 @@
+/*
+ * Buffers shared by the benchmarks of the suite, with sizes ranging from
+ * 640x480 up to 16Kx16K.
+ */
+#ifndef BENCHMARK_BUFFERS_H_
+#define BENCHMARK_BUFFERS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "ipc/raw_data_decode.h"
+
+
+// Largest buffer generated, so that the widest types skip the largest sizes
+const std::size_t max_benchmark_buffer_size = std::size_t(1) << 30;
+
+
+template <typename T>
+BufferType buffer_type_of();
+
+template <>
+inline BufferType buffer_type_of<std::uint8_t>()
+{
+    return BufferType::UnsignedByte;
+}
+
+template <>
+inline BufferType buffer_type_of<std::uint16_t>()
+{
+    return BufferType::UnsignedShort;
+}
+
+template <>
+inline BufferType buffer_type_of<std::int16_t>()
+{
+    return BufferType::Short;
+}
+
+template <>
+inline BufferType buffer_type_of<std::int32_t>()
+{
+    return BufferType::Int32;
+}
+
+template <>
+inline BufferType buffer_type_of<float>()
+{
+    return BufferType::Float32;
+}
+
+template <>
+inline BufferType buffer_type_of<double>()
+{
+    return BufferType::Float64;
+}
+
+
+/**
+ * Registers the {width, height, channels} arguments of the buffers of type
+ * T that fit in max_benchmark_buffer_size
+ */
+template <typename T>
+void buffer_arguments(benchmark::internal::Benchmark* b, int max_channels)
+{
+    const int sizes[][2] = {{640, 480}, {1920, 1080}, {4096, 4096},
+                            {16384, 16384}};
+
+    for (const auto& size : sizes) {
+        for (int channels = 1; channels <= max_channels; ++channels) {
+            const std::size_t length = static_cast<std::size_t>(size[0]) *
+                                      size[1] * channels * sizeof(T);
+            if (length <= max_benchmark_buffer_size) {
+                b->Args({size[0], size[1], channels});
+            }
+        }
+    }
+
+    b->ArgNames({"width", "height", "channels"});
+    b->Unit(benchmark::kMillisecond);
+}
+
+
+template <typename T>
+void rgba_buffer_arguments(benchmark::internal::Benchmark* b)
+{
+    buffer_arguments<T>(b, 4);
+}
+
+
+template <typename T>
+void single_channel_buffer_arguments(benchmark::internal::Benchmark* b)
+{
+    buffer_arguments<T>(b, 1);
+}
+
+
+/**
+ * Buffer of count values spread over the range of T, in a pattern which
+ * doesn't repeat along the rows
+ */
+template <typename T>
+std::vector<T> make_buffer(std::size_t count)
+{
+    std::vector<T> buffer(count);
+
+    std::uint32_t state = 2463534242u;
+    for (auto& value : buffer) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        if (std::numeric_limits<T>::is_integer) {
+            value = static_cast<T>(state);
+        } else {
+            value = static_cast<T>(state) / 65536 - 32768;
+        }
+    }
+
+    return buffer;
+}
+
+
+inline std::size_t buffer_value_count(const benchmark::State& state)
+{
+    return static_cast<std::size_t>(state.range(0)) * state.range(1) *
+           state.range(2);
+}
+
+#endif // BENCHMARK_BUFFERS_H_
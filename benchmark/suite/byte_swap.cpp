@@ -0,0 +1,80 @@
+/*
+ * Measures the packing of the buffers of targets with another byte order,
+ * against the plain copy made for all other buffers.
+ */
+#include <benchmark/benchmark.h>
+
+#include "buffers.h"
+#include "ipc/buffer_tiles.h"
+#include "math/byte_swap.h"
+
+
+namespace
+{
+
+template <typename T>
+void BM_copy_region_swapping_bytes(benchmark::State& state)
+{
+    const int width    = static_cast<int>(state.range(0));
+    const int height   = static_cast<int>(state.range(1));
+    const int channels = static_cast<int>(state.range(2));
+
+    const std::vector<T> buffer = make_buffer<T>(buffer_value_count(state));
+    std::vector<T> packed(buffer.size());
+
+    const std::size_t pitch = static_cast<std::size_t>(width) * channels *
+                              sizeof(T);
+
+    for (auto _ : state) {
+        copy_region_swapping_bytes(
+            reinterpret_cast<const uint8_t*>(buffer.data()),
+            pitch,
+            reinterpret_cast<uint8_t*>(packed.data()),
+            pitch,
+            {0, 0, width, height},
+            channels * sizeof(T),
+            sizeof(T));
+        benchmark::DoNotOptimize(packed.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * buffer.size() * sizeof(T));
+}
+
+
+template <typename T>
+void BM_copy_buffer_region(benchmark::State& state)
+{
+    const int width    = static_cast<int>(state.range(0));
+    const int height   = static_cast<int>(state.range(1));
+    const int channels = static_cast<int>(state.range(2));
+
+    const std::vector<T> buffer = make_buffer<T>(buffer_value_count(state));
+    std::vector<T> packed(buffer.size());
+
+    const std::size_t pitch = static_cast<std::size_t>(width) * channels *
+                              sizeof(T);
+
+    for (auto _ : state) {
+        copy_buffer_region(reinterpret_cast<const uint8_t*>(buffer.data()),
+                           pitch,
+                           reinterpret_cast<uint8_t*>(packed.data()),
+                           pitch,
+                           {0, 0, width, height},
+                           channels * sizeof(T));
+        benchmark::DoNotOptimize(packed.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * buffer.size() * sizeof(T));
+}
+
+} // namespace
+
+
+BENCHMARK_TEMPLATE(BM_copy_region_swapping_bytes, uint16_t)
+    ->Apply(rgba_buffer_arguments<uint16_t>);
+BENCHMARK_TEMPLATE(BM_copy_region_swapping_bytes, float)
+    ->Apply(rgba_buffer_arguments<float>);
+BENCHMARK_TEMPLATE(BM_copy_region_swapping_bytes, double)
+    ->Apply(rgba_buffer_arguments<double>);
+BENCHMARK_TEMPLATE(BM_copy_buffer_region, float)
+    ->Apply(rgba_buffer_arguments<float>);
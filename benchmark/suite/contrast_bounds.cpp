@@ -0,0 +1,157 @@
+/*
+ * Measures the computation of the buffer contrast bounds on the CPU, as done
+ * by Buffer::recompute_min_max_color_values when the bounds can't be reduced
+ * on the GPU: the value range, then the percentiles of the histogram when
+ * outliers are discarded. The bounds after a partial update are taken from
+ * the block statistics index instead.
+ */
+#include <algorithm>
+
+#include <benchmark/benchmark.h>
+
+#include "buffers.h"
+#include "math/block_statistics.h"
+#include "math/histogram.h"
+#include "math/min_max.h"
+
+
+namespace
+{
+
+template <typename T>
+void BM_compute_min_max(benchmark::State& state)
+{
+    const int width    = static_cast<int>(state.range(0));
+    const int height   = static_cast<int>(state.range(1));
+    const int channels = static_cast<int>(state.range(2));
+
+    const std::vector<T> buffer = make_buffer<T>(buffer_value_count(state));
+
+    float lowest[4];
+    float upper[4];
+    for (auto _ : state) {
+        compute_min_max(reinterpret_cast<const uint8_t*>(buffer.data()),
+                        buffer_type_of<T>(),
+                        width,
+                        height,
+                        channels,
+                        width,
+                        lowest,
+                        upper);
+        benchmark::DoNotOptimize(lowest);
+        benchmark::DoNotOptimize(upper);
+    }
+
+    state.SetBytesProcessed(state.iterations() * buffer.size() * sizeof(T));
+}
+
+
+template <typename T>
+void BM_histogram_percentiles(benchmark::State& state)
+{
+    const int width    = static_cast<int>(state.range(0));
+    const int height   = static_cast<int>(state.range(1));
+    const int channels = static_cast<int>(state.range(2));
+
+    const std::vector<T> buffer = make_buffer<T>(buffer_value_count(state));
+    const uint8_t* contents = reinterpret_cast<const uint8_t*>(buffer.data());
+
+    float lowest[4];
+    float upper[4];
+    compute_min_max(contents,
+                    buffer_type_of<T>(),
+                    width,
+                    height,
+                    channels,
+                    width,
+                    lowest,
+                    upper);
+
+    Histogram histogram;
+    for (auto _ : state) {
+        histogram.compute(contents,
+                          buffer_type_of<T>(),
+                          width,
+                          height,
+                          channels,
+                          width,
+                          0,
+                          lowest,
+                          upper);
+
+        for (int c = 0; c < channels; ++c) {
+            benchmark::DoNotOptimize(histogram.percentile(c, 1.f));
+            benchmark::DoNotOptimize(histogram.percentile(c, 99.f));
+        }
+    }
+
+    state.SetBytesProcessed(state.iterations() * buffer.size() * sizeof(T));
+}
+
+
+/**
+ * Bounds after an update of a tenth of the buffer rows, once the statistics
+ * of all blocks are known
+ */
+template <typename T>
+void BM_block_statistics_update(benchmark::State& state)
+{
+    const int width    = static_cast<int>(state.range(0));
+    const int height   = static_cast<int>(state.range(1));
+    const int channels = static_cast<int>(state.range(2));
+
+    const std::vector<T> buffer = make_buffer<T>(buffer_value_count(state));
+    const uint8_t* contents = reinterpret_cast<const uint8_t*>(buffer.data());
+
+    BlockStatistics block_statistics;
+    block_statistics.reset(
+        buffer_type_of<T>(), width, height, channels, width, 0);
+    block_statistics.statistics(contents);
+
+    const int changed_rows = std::max(height / 10, 1);
+
+    float lowest[4];
+    float upper[4];
+    int first_row = 0;
+    for (auto _ : state) {
+        block_statistics.invalidate(0, first_row, width, changed_rows);
+        block_statistics.statistics(contents).bounds(channels, lowest, upper);
+        benchmark::DoNotOptimize(lowest);
+        benchmark::DoNotOptimize(upper);
+
+        first_row = (first_row + changed_rows) % height;
+    }
+
+    state.SetBytesProcessed(state.iterations() * width * changed_rows *
+                            channels * sizeof(T));
+}
+
+} // namespace
+
+
+BENCHMARK_TEMPLATE(BM_compute_min_max, uint8_t)
+    ->Apply(rgba_buffer_arguments<uint8_t>);
+BENCHMARK_TEMPLATE(BM_compute_min_max, uint16_t)
+    ->Apply(rgba_buffer_arguments<uint16_t>);
+BENCHMARK_TEMPLATE(BM_compute_min_max, int16_t)
+    ->Apply(rgba_buffer_arguments<int16_t>);
+BENCHMARK_TEMPLATE(BM_compute_min_max, int32_t)
+    ->Apply(rgba_buffer_arguments<int32_t>);
+BENCHMARK_TEMPLATE(BM_compute_min_max, float)
+    ->Apply(rgba_buffer_arguments<float>);
+
+BENCHMARK_TEMPLATE(BM_histogram_percentiles, uint8_t)
+    ->Apply(rgba_buffer_arguments<uint8_t>);
+BENCHMARK_TEMPLATE(BM_histogram_percentiles, uint16_t)
+    ->Apply(rgba_buffer_arguments<uint16_t>);
+BENCHMARK_TEMPLATE(BM_histogram_percentiles, int16_t)
+    ->Apply(rgba_buffer_arguments<int16_t>);
+BENCHMARK_TEMPLATE(BM_histogram_percentiles, int32_t)
+    ->Apply(rgba_buffer_arguments<int32_t>);
+BENCHMARK_TEMPLATE(BM_histogram_percentiles, float)
+    ->Apply(rgba_buffer_arguments<float>);
+
+BENCHMARK_TEMPLATE(BM_block_statistics_update, uint8_t)
+    ->Apply(rgba_buffer_arguments<uint8_t>);
+BENCHMARK_TEMPLATE(BM_block_statistics_update, float)
+    ->Apply(rgba_buffer_arguments<float>);
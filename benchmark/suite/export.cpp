@@ -0,0 +1,91 @@
+/*
+ * Measures the encoders behind the buffer exports: the normalization and
+ * deflating of bitmaps, and the packing of the rows of binary exports.
+ * Files are written to /dev/null, so that the disk isn't measured.
+ */
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "buffers.h"
+#include "io/array_file.h"
+#include "io/export_encoding.h"
+
+
+namespace
+{
+
+const char* const null_device = "/dev/null";
+
+
+template <typename T>
+void BM_write_bitmap(benchmark::State& state)
+{
+    const std::vector<T> buffer = make_buffer<T>(buffer_value_count(state));
+
+    NormalizationParameters params;
+    params.contents     = reinterpret_cast<const uint8_t*>(buffer.data());
+    params.width        = static_cast<std::size_t>(state.range(0));
+    params.height       = static_cast<std::size_t>(state.range(1));
+    params.channels     = static_cast<int>(state.range(2));
+    params.input_stride = params.width * params.channels;
+    for (int c = 0; c < 4; ++c) {
+        params.scale[c]        = 255.f / 65536.f;
+        params.offset[c]       = 127.5f;
+        params.pixel_layout[c] = static_cast<uint8_t>(c);
+    }
+    params.is_layout_remapped = false;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(write_bitmap<T>(params, null_device));
+    }
+
+    state.SetBytesProcessed(state.iterations() * buffer.size() * sizeof(T));
+}
+
+
+template <typename T>
+void BM_write_binary(benchmark::State& state)
+{
+    const int width    = static_cast<int>(state.range(0));
+    const int height   = static_cast<int>(state.range(1));
+    const int channels = static_cast<int>(state.range(2));
+
+    // Rows are padded, as those of buffers with a larger row stride, so that
+    // they are packed before being written
+    const std::size_t row_length =
+        static_cast<std::size_t>(width) * channels * sizeof(T);
+    const std::size_t input_stride = row_length + 64;
+    const std::vector<uint8_t> buffer =
+        make_buffer<uint8_t>(input_stride * height);
+
+    BinaryLayout layout;
+    layout.contents     = buffer.data();
+    layout.height       = static_cast<std::size_t>(height);
+    layout.row_length   = row_length;
+    layout.input_stride = input_stride;
+
+    const std::string header =
+        make_npy_header(buffer_type_of<T>(), width, height, channels, false);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(write_binary(layout, header, null_device));
+    }
+
+    state.SetBytesProcessed(state.iterations() * row_length * height);
+}
+
+} // namespace
+
+
+BENCHMARK_TEMPLATE(BM_write_bitmap, uint8_t)
+    ->Apply(rgba_buffer_arguments<uint8_t>);
+BENCHMARK_TEMPLATE(BM_write_bitmap, uint16_t)
+    ->Apply(rgba_buffer_arguments<uint16_t>);
+BENCHMARK_TEMPLATE(BM_write_bitmap, float)
+    ->Apply(rgba_buffer_arguments<float>);
+
+BENCHMARK_TEMPLATE(BM_write_binary, uint8_t)
+    ->Apply(rgba_buffer_arguments<uint8_t>);
+BENCHMARK_TEMPLATE(BM_write_binary, float)
+    ->Apply(rgba_buffer_arguments<float>);
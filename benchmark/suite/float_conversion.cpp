@@ -0,0 +1,37 @@
+/*
+ * Measures the float copies made of the Float64 and Int32 buffers when they
+ * are received, which replaced make_float_buffer_from_double.
+ */
+#include <benchmark/benchmark.h>
+
+#include "buffers.h"
+#include "math/float_conversion.h"
+
+
+namespace
+{
+
+template <typename T>
+void BM_make_float_buffer(benchmark::State& state)
+{
+    const std::vector<T> buffer = make_buffer<T>(buffer_value_count(state));
+    const std::size_t length    = buffer.size() * sizeof(T);
+
+    for (auto _ : state) {
+        HostBuffer converted =
+            make_float_buffer(reinterpret_cast<const uint8_t*>(buffer.data()),
+                              buffer_type_of<T>(),
+                              length);
+        benchmark::DoNotOptimize(converted.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * length);
+}
+
+} // namespace
+
+
+BENCHMARK_TEMPLATE(BM_make_float_buffer, double)
+    ->Apply(rgba_buffer_arguments<double>);
+BENCHMARK_TEMPLATE(BM_make_float_buffer, int32_t)
+    ->Apply(rgba_buffer_arguments<int32_t>);
@@ -0,0 +1,102 @@
+/*
+ * Measures the mat4 and vec4 operations done for every stage and every drawn
+ * tile.
+ */
+#include <benchmark/benchmark.h>
+
+#include "math/linear_algebra.h"
+
+
+namespace
+{
+
+// Camera and buffer poses, as rendered by the stages
+const int pose_count = 1024;
+
+
+struct Poses
+{
+    Poses()
+    {
+        mat4 projection;
+        projection.set_ortho_projection(640.f, 480.f, -1.f, 1.f);
+
+        for (int i = 0; i < pose_count; ++i) {
+            mat4 pose;
+            pose.set_from_srt(
+                2.f + i % 7, 3.f, 1.f, 0.1f * (i % 5), 10.f, -4.f, 0.f);
+            poses[i]  = projection * pose;
+            points[i] = vec4(static_cast<float>(i), 1.f, 0.f, 1.f);
+        }
+    }
+
+    mat4 poses[pose_count];
+    vec4 points[pose_count];
+};
+
+
+const Poses& poses()
+{
+    static const Poses instance;
+    return instance;
+}
+
+
+void BM_mat4_product(benchmark::State& state)
+{
+    const Poses& p = poses();
+
+    int i = 0;
+    for (auto _ : state) {
+        mat4 product = p.poses[i] * p.poses[(i + 1) % pose_count];
+        benchmark::DoNotOptimize(product);
+        i = (i + 1) % pose_count;
+    }
+}
+
+
+void BM_mat4_vec4_product(benchmark::State& state)
+{
+    const Poses& p = poses();
+
+    int i = 0;
+    for (auto _ : state) {
+        vec4 product = p.poses[i] * p.points[(i + 1) % pose_count];
+        benchmark::DoNotOptimize(product);
+        i = (i + 1) % pose_count;
+    }
+}
+
+
+void BM_mat4_inv(benchmark::State& state)
+{
+    const Poses& p = poses();
+
+    int i = 0;
+    for (auto _ : state) {
+        mat4 inverse = p.poses[i].inv();
+        benchmark::DoNotOptimize(inverse);
+        i = (i + 1) % pose_count;
+    }
+}
+
+
+void BM_mat4_affine_inv(benchmark::State& state)
+{
+    const Poses& p = poses();
+
+    int i = 0;
+    for (auto _ : state) {
+        mat4 inverse = p.poses[i].affine_inv();
+        benchmark::DoNotOptimize(inverse);
+        i = (i + 1) % pose_count;
+    }
+}
+
+} // namespace
+
+
+BENCHMARK(BM_mat4_product);
+BENCHMARK(BM_mat4_vec4_product);
+BENCHMARK(BM_mat4_inv);
+BENCHMARK(BM_mat4_affine_inv);
@@ -0,0 +1,183 @@
+/*
+ * Measures plot messages making a round trip between a sender and a receiver
+ * thread over a socket pair: composing and sending them, then receiving and
+ * decoding them, as the bridge and the network worker do.
+ */
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <QIODevice>
+
+#include "buffers.h"
+#include "ipc/message_exchange.h"
+
+
+namespace
+{
+
+/**
+ * Blocking, unbuffered device over one end of a socket pair, which doesn't
+ * need an event loop
+ */
+class SocketDevice : public QIODevice
+{
+  public:
+    explicit SocketDevice(int fd)
+        : fd_(fd)
+    {
+        open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+    }
+
+    bool isSequential() const override
+    {
+        return true;
+    }
+
+    qint64 bytesAvailable() const override
+    {
+        int available = 0;
+        if (ioctl(fd_, FIONREAD, &available) < 0) {
+            available = 0;
+        }
+        return available + QIODevice::bytesAvailable();
+    }
+
+    bool waitForReadyRead(int msecs) override
+    {
+        pollfd descriptor = {fd_, POLLIN, 0};
+        return poll(&descriptor, 1, msecs) > 0;
+    }
+
+  protected:
+    qint64 readData(char* data, qint64 max_size) override
+    {
+        return ::read(fd_, data, static_cast<size_t>(max_size));
+    }
+
+    qint64 writeData(const char* data, qint64 max_size) override
+    {
+        return ::write(fd_, data, static_cast<size_t>(max_size));
+    }
+
+  private:
+    int fd_;
+};
+
+
+template <bool IsCompressed>
+void BM_plot_round_trip(benchmark::State& state)
+{
+    const std::vector<float> contents =
+        make_buffer<float>(buffer_value_count(state));
+    const uint8_t* contents_ptr =
+        reinterpret_cast<const uint8_t*>(contents.data());
+    const size_t length = contents.size() * sizeof(float);
+
+    BufferMetadata metadata;
+    metadata.variable_name    = "buffer";
+    metadata.display_name     = "buffer";
+    metadata.pixel_layout     = "rgba";
+    metadata.transpose_buffer = false;
+    metadata.width            = static_cast<int>(state.range(0));
+    metadata.height           = static_cast<int>(state.range(1));
+    metadata.channels         = static_cast<int>(state.range(2));
+    metadata.row_stride       = metadata.width;
+    metadata.type             = BufferType::Float32;
+
+    const CompressionSettings settings{CompressionCodec::Zlib, 1, 0};
+
+    // Messages go through the first pair, and are acknowledged through the
+    // second one
+    int message_fds[2];
+    int ack_fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, message_fds) != 0 ||
+        socketpair(AF_UNIX, SOCK_STREAM, 0, ack_fds) != 0) {
+        state.SkipWithError("Could not create the socket pairs");
+        return;
+    }
+
+    // The receiver stops at the first message which isn't a plot
+    std::thread receiver([&]() {
+        SocketDevice device(message_fds[1]);
+        MessageStreamReader message_reader;
+
+        while (message_reader.wait_for_message(&device, -1)) {
+            const MessageType type = message_reader.message_type();
+            if (type != MessageType::PlotBufferContents &&
+                type != MessageType::PlotBufferCompressedContents) {
+                break;
+            }
+
+            MessageDecoder message_decoder = message_reader.message_decoder();
+            BufferMetadata received_metadata;
+            message_decoder.read(received_metadata);
+
+            HostBuffer received;
+            if (IsCompressed) {
+                message_decoder.read_compressed(received);
+            } else {
+                size_t received_length;
+                const uint8_t* payload =
+                    message_decoder.read_payload(received_length);
+                received = HostBuffer(received_length);
+                memcpy(received.data(), payload, received_length);
+            }
+            benchmark::DoNotOptimize(received.data());
+
+            message_reader.pop_message();
+
+            const char ack = 0;
+            if (::write(ack_fds[1], &ack, 1) != 1) {
+                break;
+            }
+        }
+    });
+
+    SocketDevice device(message_fds[0]);
+    for (auto _ : state) {
+        MessageComposer message_composer;
+        if (IsCompressed) {
+            message_composer.push(MessageType::PlotBufferCompressedContents)
+                .push(metadata)
+                .push_compressed(contents_ptr, length, settings);
+        } else {
+            message_composer.push(MessageType::PlotBufferContents)
+                .push(metadata)
+                .push(contents_ptr, length);
+        }
+        message_composer.send(&device);
+
+        char ack;
+        if (::read(ack_fds[0], &ack, 1) != 1) {
+            state.SkipWithError("The receiver stopped");
+            break;
+        }
+    }
+
+    MessageComposer stop_composer;
+    stop_composer.push(MessageType::GetObservedSymbols).send(&device);
+    receiver.join();
+
+    close(message_fds[0]);
+    close(message_fds[1]);
+    close(ack_fds[0]);
+    close(ack_fds[1]);
+
+    state.SetBytesProcessed(state.iterations() * length);
+}
+
+} // namespace
+
+
+BENCHMARK_TEMPLATE(BM_plot_round_trip, false)
+    ->Apply(single_channel_buffer_arguments<float>);
+BENCHMARK_TEMPLATE(BM_plot_round_trip, true)
+    ->Apply(single_channel_buffer_arguments<float>);
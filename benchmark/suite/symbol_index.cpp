@@ -0,0 +1,74 @@
+/*
+ * Measures the filtering of the symbol completions over 10k symbols, as the
+ * SymbolCompleter does while a symbol name is typed.
+ */
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "ui/symbol_index.h"
+
+
+namespace
+{
+
+const std::size_t symbol_count = 10000;
+
+
+std::vector<std::string> make_symbols()
+{
+    const char* const prefixes[] = {
+        "frame_buffer_", "this->image_", "depth_map_", "m_Texture", "mask"};
+
+    std::vector<std::string> symbols;
+    for (std::size_t i = 0; i < symbol_count; ++i) {
+        symbols.push_back(prefixes[i % 5] + std::to_string(i));
+    }
+    return symbols;
+}
+
+
+void BM_symbol_index_build(benchmark::State& state)
+{
+    const std::vector<std::string> symbols = make_symbols();
+
+    for (auto _ : state) {
+        SymbolIndex index(symbols, false);
+        benchmark::DoNotOptimize(index.size());
+    }
+}
+
+
+// Each keystroke refines the matches of the previous ones
+void BM_symbol_index_typing(benchmark::State& state)
+{
+    const SymbolIndex index(make_symbols(), false);
+    const std::string word = "depth_map_12";
+
+    for (auto _ : state) {
+        std::vector<SymbolIndex::SymbolId> matches =
+            index.find(word.substr(0, 1));
+        for (std::size_t length = 2; length <= word.size(); ++length) {
+            matches = index.refine(matches, word.substr(0, length));
+        }
+        benchmark::DoNotOptimize(matches.data());
+    }
+}
+
+
+void BM_symbol_index_find(benchmark::State& state)
+{
+    const SymbolIndex index(make_symbols(), false);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(index.find("buffer").data());
+    }
+}
+
+} // namespace
+
+
+BENCHMARK(BM_symbol_index_build)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_symbol_index_typing)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_symbol_index_find)->Unit(benchmark::kMicrosecond);
@@ -33,5 +33,6 @@ set(CMAKE_CXX_EXTENSIONS False)
 
 find_package(Threads REQUIRED)
 find_package(Qt5 COMPONENTS Network REQUIRED)
+find_package(ZLIB REQUIRED)
 
 add_compile_options(-Wall -Wextra -pedantic -fvisibility=hidden)
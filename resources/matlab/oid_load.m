@@ -6,15 +6,44 @@ function buffer = oid_load(fname)
     fid = fopen(fname, 'r');
 
     type = fgets(fid);
+    type = type(1:length(type)-1);
     dimensions = fread(fid, 3, 'int32')';
 
-    buffer = fread(fid, prod(dimensions), type(1:length(type)-1));
+    % Planar matrices store each channel as a plane of its own
+    planar_suffix = ' planar';
+    is_planar = length(type) > length(planar_suffix) && ...
+                strcmp(type(end-length(planar_suffix)+1:end), planar_suffix);
+    if is_planar
+        type = type(1:end-length(planar_suffix));
+    end
+
+    if strcmp(type, 'half')
+        % Half precision values are decoded from their bits
+        bits = fread(fid, prod(dimensions), 'uint16');
+        sign_factor = 1 - 2 * bitshift(bits, -15);
+        exponent = bitand(bitshift(bits, -10), 31);
+        mantissa = bitand(bits, 1023);
+
+        buffer = sign_factor .* (1 + mantissa / 1024) .* 2 .^ (exponent - 15);
+        subnormal = exponent == 0;
+        buffer(subnormal) = sign_factor(subnormal) .* ...
+                            mantissa(subnormal) / 1024 * 2 ^ -14;
+        infinite = exponent == 31 & mantissa == 0;
+        buffer(infinite) = sign_factor(infinite) * Inf;
+        buffer(exponent == 31 & mantissa ~= 0) = NaN;
+    else
+        buffer = fread(fid, prod(dimensions), type);
+    end
 
     rows = dimensions(1);
     cols = dimensions(2);
     channels = dimensions(3);
 
-    buffer_t = reshape(reshape(buffer, channels, rows*cols)', [cols,rows,channels]);
+    if is_planar
+        buffer_t = reshape(buffer, [cols,rows,channels]);
+    else
+        buffer_t = reshape(reshape(buffer, channels, rows*cols)', [cols,rows,channels]);
+    end
 
     buffer = zeros(dimensions);
     for c = 1:channels
@@ -4,8 +4,8 @@
 
 """
 Open Image Debugger entry point. Can be called with --test for opening the plugin
-window with a couple of sample buffers; otherwise, should be invoked by the
-debugger.
+window with a couple of sample buffers, or with --load-test for measuring a
+headless window; otherwise, should be invoked by the debugger.
 """
 
 import argparse
@@ -20,6 +20,7 @@ sys.path.append(script_path)
 # Load dependency modules
 from oidscripts.oidwindow import OpenImageDebuggerWindow
 from oidscripts.test import oidtest
+from oidscripts import loadtest
 from oidscripts.debuggers.interfaces import BridgeInterface
 from oidscripts.events import OpenImageDebuggerEvents
 
@@ -121,11 +122,14 @@ def main():
     parser.add_argument('--test',
                         help='Open a test window with sample buffers',
                         action='store_true')
+    loadtest.add_arguments(parser)
     args = parser.parse_args()
 
     if args is not None and args.test:
         # Test application
         oidtest(script_path)
+    elif args is not None and args.load_test:
+        loadtest.oidloadtest(script_path, args)
     else:
         # Setup GDB interface
         debugger = get_debugger_bridge()
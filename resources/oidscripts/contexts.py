@@ -0,0 +1,113 @@
+# -*- coding: utf-8 -*-
+
+"""
+Names of the variables evaluated in a context of their own, instead of the
+thread and frame selected in the debugger. The context is appended to the
+expression, as in 'image [thread 1.2, frame 0]', where 1.2 is the thread 2 of
+the inferior 1 and 0 the innermost frame of that thread. Without a frame, the
+innermost frame where the expression can be evaluated is used. The thread '*'
+stands for every thread where it can be evaluated.
+
+Such names are the names of the buffers in the window, so that the same
+expression can be plotted from several threads at once.
+"""
+
+import re
+
+ANY_THREAD = '*'
+
+_CONTEXT_PATTERN = re.compile(
+    r'^(?P<expression>.*?)\s*'
+    r'\[\s*thread\s+(?:(?P<inferior>\d+)\.)?(?P<thread>\d+|\*)\s*'
+    r'(?:,\s*frame\s+(?P<frame>\d+)\s*)?\]$')
+
+
+class EvaluationContext(object):
+    """
+    Thread and frame an expression is evaluated in. The inferior and the frame
+    are None if they weren't given, and the thread is ANY_THREAD for every
+    thread.
+    """
+    def __init__(self, inferior, thread, frame):
+        self.inferior = inferior
+        self.thread = thread
+        self.frame = frame
+
+    def __eq__(self, other):
+        return isinstance(other, EvaluationContext) and \
+            self._key() == other._key()
+
+    def __ne__(self, other):
+        return not self == other
+
+    def __hash__(self):
+        return hash(self._key())
+
+    def __str__(self):
+        thread = str(self.thread)
+        if self.inferior is not None:
+            thread = '%d.%s' % (self.inferior, thread)
+        if self.frame is None:
+            return 'thread %s' % thread
+        return 'thread %s, frame %d' % (thread, self.frame)
+
+    def _key(self):
+        return self.inferior, self.thread, self.frame
+
+    def is_any_thread(self):
+        return self.thread == ANY_THREAD
+
+    def with_thread(self, inferior, thread):
+        """
+        Same context in the given thread
+        """
+        return EvaluationContext(inferior, thread, self.frame)
+
+
+def parse(variable):
+    # type: (str) -> tuple
+    """
+    Split the name of a variable into its expression and its context, which
+    is None for variables evaluated in the frame selected in the debugger
+    """
+    match = _CONTEXT_PATTERN.match(variable)
+    if match is None or match.group('expression') == '':
+        return variable, None
+
+    inferior = match.group('inferior')
+    thread = match.group('thread')
+    frame = match.group('frame')
+    context = EvaluationContext(
+        int(inferior) if inferior is not None else None,
+        thread if thread == ANY_THREAD else int(thread),
+        int(frame) if frame is not None else None)
+
+    return match.group('expression'), context
+
+
+def qualify(expression, context):
+    # type: (str, EvaluationContext) -> str
+    """
+    Name of the expression evaluated in the given context
+    """
+    if context is None:
+        return expression
+    return '%s [%s]' % (expression, context)
+
+
+def group_by_context(variables):
+    # type: (list) -> list
+    """
+    Group the variables by the context they are evaluated in, as a list of
+    (context, variables) kept in the order their contexts first appear
+    """
+    groups = []
+    group_of_context = {}
+    for variable in variables:
+        context = parse(variable)[1]
+        if context not in group_of_context:
+            group_of_context[context] = len(groups)
+            groups.append((context, []))
+        groups[group_of_context[context]][1].append(variable)
+
+    return groups
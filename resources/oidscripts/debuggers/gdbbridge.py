@@ -5,9 +5,9 @@ Code responsible with directly interacting with GDB
 """
 
 import gdb
-import time
-import threading
+from sys import platform
 
+from oidscripts import contexts
 from oidscripts import sysinfo
 from oidscripts.debuggers.interfaces import BridgeInterface
 from oidscripts.events import BridgeEventHandlerInterface
@@ -22,39 +22,30 @@ class GdbBridge(BridgeInterface):
         self._type_bridge = type_bridge
         self._commands = dict(plot=PlotterCommand(self))
         self._event_handler = None  # type: BridgeEventHandlerInterface
-
-        self._pending_requests = []
-        self._lock = threading.Lock()
+        # Observable symbols of each scope, keyed by (function, block range)
+        self._scope_symbols = {}
+        # Observable members of each class type, including its base classes
+        self._type_fields = {}
+        # Context given to select_context, and the (inferior, thread, frame)
+        # selected by the user before it
+        self._context = None
+        self._user_context = None
 
         gdb.events.stop.connect(self._event_stop_handler)
         gdb.events.exited.connect(self._event_exit_handler)
-
-        event_loop_thread = threading.Thread(target=self.event_loop)
-        event_loop_thread.daemon = True
-        event_loop_thread.start()
-
-    def event_loop(self):
-        while True:
-            requests_to_process = []
-            with self._lock:
-                requests_to_process = self._pending_requests
-                self._pending_requests = []
-
-            while requests_to_process:
-                callback = requests_to_process.pop(0)
-                gdb.post_event(callback)
-
-            time.sleep(0.1)
+        gdb.events.new_objfile.connect(self._event_objfiles_handler)
+        gdb.events.clear_objfiles.connect(self._event_objfiles_handler)
 
     def queue_request(self, callable_request):
-        with self._lock:
-            self._pending_requests.append(callable_request)
+        # gdb.post_event is thread safe and wakes GDB up immediately
+        gdb.post_event(callable_request)
 
     def get_backend_name(self):
         return 'gdb'
 
     def get_buffer_metadata(self, variable):
-        picked_obj = gdb.parse_and_eval(variable)
+        expression = contexts.parse(variable)[0]
+        picked_obj = self._evaluate(expression)
 
         buffer_metadata = self._type_bridge.get_buffer_metadata(
             variable, picked_obj, self)
@@ -78,23 +69,169 @@ class GdbBridge(BridgeInterface):
         elif bufsize >= sysinfo.get_available_memory() / 10:
             raise Exception('Invalid buffer size larger than available memory')
 
+        inferior = gdb.selected_inferior()
+        buffer_metadata['variable_name'] = variable
+
+        # Inspectors reading the buffer header directly already provide the
+        # address as an integer
+        if isinstance(buffer_metadata['pointer'], gdb.Value):
+            buffer_metadata['pointer'] = int(buffer_metadata['pointer'].cast(
+                gdb.lookup_type('unsigned long')))
+
+        # Only the selected slice of tensors is read
+        buffer_metadata['pointer'] += buffer_metadata.pop('slice_offset', 0)
+
+        # Local inferiors are read by the bridge library itself, which also
+        # reports invalid buffers. Device memory isn't mapped in the address
+        # space of the inferior, so CUDA buffers are copied to the host by
+        # the debugger (e.g. cuda-gdb) instead.
+        is_device_buffer = buffer_metadata.pop('device', False)
+        inferior_pid = GdbBridge._get_local_inferior_pid(inferior)
+        if inferior_pid != 0 and not is_device_buffer:
+            buffer_metadata['inferior_pid'] = inferior_pid
+            return buffer_metadata
+
         # Check if buffer is valid. If it isn't, this function will throw an
         # exception
-        gdb.execute('x ' + str(int(buffer_metadata['pointer'].cast(gdb.lookup_type('long')))))
+        gdb.execute('x ' + str(buffer_metadata['pointer']))
+
+        # Remote targets may not share the byte order of the host, which the
+        # bridge library converts the values to
+        buffer_metadata.setdefault('endianness',
+                                   GdbBridge._get_target_endianness())
 
-        inferior = gdb.selected_inferior()
-        buffer_metadata['variable_name'] = variable
         buffer_metadata['pointer'] = inferior.read_memory(
             buffer_metadata['pointer'], bufsize)
 
         return buffer_metadata
 
+    def _evaluate(self, expression):
+        """
+        Evaluate the expression in the selected context. Contexts without a
+        frame evaluate it in the innermost frame where it is defined.
+        """
+        if self._context is None or self._context.frame is not None:
+            return gdb.parse_and_eval(expression)
+
+        frame = gdb.newest_frame()
+        while True:
+            frame.select()
+            try:
+                return gdb.parse_and_eval(expression)
+            except gdb.error:
+                frame = frame.older()
+                if frame is None:
+                    raise
+
+    def select_context(self, context):
+        if context is None:
+            self._restore_user_context()
+            return
+
+        if self._user_context is None:
+            try:
+                frame = gdb.selected_frame()
+            except gdb.error:
+                frame = None
+            self._user_context = (gdb.selected_inferior(),
+                                  gdb.selected_thread(),
+                                  frame)
+
+        # Switching threads and frames doesn't raise any stop event
+        self._context = None
+        GdbBridge._find_thread(context, self._user_context[0]).switch()
+        if context.frame is not None:
+            frame = gdb.newest_frame()
+            for _ in range(context.frame):
+                frame = frame.older()
+                if frame is None:
+                    raise Exception('No frame %d in thread %s' %
+                                    (context.frame, context))
+            frame.select()
+        self._context = context
+
+    def _restore_user_context(self):
+        if self._user_context is None:
+            return
+
+        inferior, thread, frame = self._user_context
+        self._context = None
+        self._user_context = None
+
+        if thread is not None and thread.is_valid():
+            thread.switch()
+            if frame is not None and frame.is_valid():
+                frame.select()
+        elif inferior.is_valid():
+            gdb.execute('inferior %d' % inferior.num, to_string=True)
+
+    @staticmethod
+    def _find_thread(context, user_inferior):
+        """
+        Get the thread of the context. Threads given without their inferior
+        belong to the one selected by the user.
+        """
+        inferior_num = context.inferior
+        if inferior_num is None:
+            inferior_num = user_inferior.num
+
+        for inferior in gdb.inferiors():
+            if inferior.num != inferior_num:
+                continue
+            for thread in inferior.threads():
+                if thread.num == context.thread:
+                    return thread
+
+        raise Exception('No thread %d.%d' % (inferior_num, context.thread))
+
+    def get_thread_contexts(self, context):
+        thread_contexts = []
+        for inferior in gdb.inferiors():
+            for thread in sorted(inferior.threads(),
+                                 key=lambda thread: thread.num):
+                thread_contexts.append(
+                    context.with_thread(inferior.num, thread.num))
+        return thread_contexts
+
+    @staticmethod
+    def _get_target_endianness():
+        """
+        Get the byte order of the target, either 'little' or 'big'
+        """
+        # e.g. "The target endianness is set automatically (currently little
+        # endian)."
+        description = gdb.execute('show endian', to_string=True)
+        return 'big' if 'big endian' in description else 'little'
+
+    @staticmethod
+    def _get_local_inferior_pid(inferior):
+        """
+        Get the pid of the inferior if its memory can be read directly by the
+        bridge library, or 0 otherwise.
+        """
+        if not platform.startswith('linux'):
+            return 0
+
+        # Remote inferiors (e.g. through gdbserver) may live in another host.
+        # GDB versions without inferior connections are not trusted either.
+        connection = getattr(inferior, 'connection', None)
+        if connection is None or connection.type != 'native':
+            return 0
+
+        return inferior.pid
+
     def _event_stop_handler(self, event):
         self._event_handler.stop_handler()
 
     def _event_exit_handler(self, event):
         self._event_handler.exit_handler()
 
+    def _event_objfiles_handler(self, event):
+        # Scopes and types may be redefined by the new symbol tables
+        self._scope_symbols.clear()
+        self._type_fields.clear()
+        self._type_bridge.clear_cache()
+
     def register_event_handlers(self, event_handler):
         self._event_handler = event_handler
         self._commands['plot'].set_command_listener(event_handler.plot_handler)
@@ -103,19 +240,22 @@ class GdbBridge(BridgeInterface):
         """
         Given a class/struct type "this_type", fetch all members of that
         particular type and test them against the observable buffer check.
+        The members found are memoized per type.
         """
-        for field_name, field_val in this_type.iteritems():
-            if field_val.is_base_class:
-                type_fields = self.get_fields_from_type(field_val.type,
-                                                        observable_symbols)
-                observable_symbols.update(type_fields)
-            elif ((field_name not in observable_symbols) and
-                  (self._type_bridge.is_symbol_observable(field_val, field_name))):
-                try:
-                    observable_symbols.add(field_name)
-                except Exception:
-                    print('[OpenImageDebugger] Info: Member %s is not observable'
-                          % field_name)
+        type_name = str(this_type)
+        type_fields = self._type_fields.get(type_name)
+        if type_fields is None:
+            type_fields = set()
+            for field_name, field_val in this_type.iteritems():
+                if field_val.is_base_class:
+                    self.get_fields_from_type(field_val.type, type_fields)
+                elif ((field_name not in type_fields) and
+                      (self._type_bridge.is_symbol_observable(field_val,
+                                                              field_name))):
+                    type_fields.add(field_name)
+            self._type_fields[type_name] = type_fields
+
+        observable_symbols.update(type_fields)
         return observable_symbols
 
     def get_casted_pointer(self, typename, gdb_object):
@@ -123,12 +263,101 @@ class GdbBridge(BridgeInterface):
         typename_pointer_obj = typename_obj.pointer()
         return gdb_object.cast(typename_pointer_obj)
 
+    @staticmethod
+    def _get_referenced_object(gdb_object):
+        """
+        Get the object pointed or referred to by gdb_object, or gdb_object
+        itself if it is neither a pointer nor a reference.
+        """
+        type_code = gdb_object.type.strip_typedefs().code
+        if type_code == gdb.TYPE_CODE_PTR:
+            return gdb_object.dereference()
+        elif type_code in (gdb.TYPE_CODE_REF,
+                           getattr(gdb, 'TYPE_CODE_RVALUE_REF', None)):
+            return gdb_object.referenced_value()
+        return gdb_object
+
+    @staticmethod
+    def _get_address(gdb_object):
+        address = gdb_object.address
+        if address is None:
+            return None
+        return int(address.cast(gdb.lookup_type('unsigned long')))
+
+    def select_tensor_slice(self, variable, tensor_index):
+        self._type_bridge.select_tensor_slice(variable, tensor_index)
+
+    def get_member_layout(self, gdb_object, member_paths):
+        try:
+            gdb_object = GdbBridge._get_referenced_object(gdb_object)
+            object_address = GdbBridge._get_address(gdb_object)
+            if object_address is None:
+                return None
+
+            members = []
+            for member_path in member_paths:
+                member = gdb_object
+                for key in member_path:
+                    member = member[key]
+
+                member_type = member.type.strip_typedefs()
+                member_size = member_type.sizeof
+                member_address = GdbBridge._get_address(member)
+                if (member_address is None or
+                        member_size not in (1, 2, 4, 8) or
+                        member_type.code not in (gdb.TYPE_CODE_INT,
+                                                 gdb.TYPE_CODE_PTR,
+                                                 gdb.TYPE_CODE_ENUM,
+                                                 gdb.TYPE_CODE_BOOL)):
+                    return None
+
+                is_signed = (member_type.code != gdb.TYPE_CODE_PTR and
+                             bool(gdb.Value(-1).cast(member_type) < 0))
+                members.append((member_address - object_address,
+                                member_size,
+                                is_signed))
+            return members
+        except gdb.error:
+            return None
+
+    def read_object_header(self, gdb_object, size):
+        try:
+            address = GdbBridge._get_address(
+                GdbBridge._get_referenced_object(gdb_object))
+            if address is None:
+                return None
+            return bytes(gdb.selected_inferior().read_memory(address, size))
+        except gdb.error:
+            return None
+
     def get_available_symbols(self):
+        observable_symbols = set()
+        for observable_symbols in self.iter_available_symbols():
+            pass
+        return observable_symbols
+
+    def iter_available_symbols(self):
         frame = gdb.selected_frame()
         block = frame.block()
+
+        # The symbols visible from a block never change, so stepping within
+        # the same scope reuses the previous result
+        function = frame.function()
+        scope = (str(function) if function is not None else frame.name(),
+                 block.start, block.end)
+        scope_symbols = self._scope_symbols.get(scope)
+        if scope_symbols is not None:
+            yield set(scope_symbols)
+            return
+
         observable_symbols = set()
 
+        # Each block is a step. The listing is abandoned once another frame is
+        # selected, as the remaining blocks would be evaluated in it.
         while block is not None:
+            if not frame.is_valid() or gdb.selected_frame() != frame:
+                return
+
             for symbol in block:
                 if symbol.is_argument or symbol.is_variable:
                     name = symbol.name
@@ -153,8 +382,11 @@ class GdbBridge(BridgeInterface):
                                   'observable' % name)
 
             block = block.superblock
+            if block is not None:
+                yield set(observable_symbols)
 
-        return observable_symbols
+        self._scope_symbols[scope] = observable_symbols
+        yield set(observable_symbols)
 
 
 class PlotterCommand(gdb.Command):
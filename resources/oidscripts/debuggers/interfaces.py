@@ -42,6 +42,13 @@ class BridgeInterface(object):
             row_stride:int,
             pixel_layout:str,
         }
+
+        Tensors additionally describe their leading axes with tensor_shape and
+        tensor_strides (in values), and are narrowed down to the slice chosen
+        with select_tensor_slice. The pointer then addresses that slice.
+
+        Variables named after a context (see contexts.py) are evaluated in the
+        context selected with select_context, which matches theirs.
         """
         raise NotImplementedError("Method is not implemented")
 
@@ -82,6 +89,62 @@ class BridgeInterface(object):
         """
         raise NotImplementedError("Method is not implemented")
 
+    def iter_available_symbols(self):
+        """
+        Yield the symbols found so far in the current context of debugging,
+        the last set yielded being all visible symbols. Bridges able to list
+        them in steps yield after each one, so that more urgent work can run
+        in between.
+        """
+        yield self.get_available_symbols()
+
+    def get_member_layout(self, debugger_object, member_paths):
+        # type: (object, list) -> list
+        """
+        Given an object and a list of member paths (lists of member names and
+        array indices), return the (offset, size, is_signed) of each member
+        relative to the start of the object, looking through pointers and
+        references. Bridges that can't compute offsets return None, and type
+        inspectors are then queried member by member instead.
+        """
+        return None
+
+    def select_tensor_slice(self, variable, tensor_index):
+        # type: (str, list) -> None
+        """
+        Select the slice of the tensor 'variable' returned by the next calls
+        to get_buffer_metadata. Bridges without tensor buffers ignore it.
+        """
+        pass
+
+    def select_context(self, context):
+        # type: (EvaluationContext) -> None
+        """
+        Evaluate the next calls to get_buffer_metadata in the thread and frame
+        of 'context', without changing the ones shown by the debugger. None
+        goes back to the thread and frame selected by the user. Bridges
+        raise an exception if the context doesn't exist.
+        """
+        if context is not None:
+            raise Exception('Evaluation contexts are not supported by %s' %
+                            self.get_backend_name())
+
+    def get_thread_contexts(self, context):
+        # type: (EvaluationContext) -> list
+        """
+        Return the context of each thread of the debugged inferiors, in the
+        frame of 'context'. Bridges without threads return an empty list.
+        """
+        return []
+
+    def read_object_header(self, debugger_object, size):
+        # type: (object, int) -> bytes
+        """
+        Return the first 'size' bytes of the object, looking through pointers
+        and references, or None if they could not be read.
+        """
+        return None
+
 
 class BridgeEventHandlerInterface(object):
     __metaclass__ = abc.ABCMeta
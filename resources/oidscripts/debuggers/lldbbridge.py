@@ -5,9 +5,11 @@ Code responsible with directly interacting with LLDB
 """
 
 import lldb
-import time
+import os
 import threading
+import time
 
+from oidscripts import contexts
 from oidscripts import sysinfo
 from oidscripts.typebridge import TypeInspectorInterface
 from oidscripts.debuggers.interfaces import BridgeInterface, \
@@ -15,6 +17,26 @@ from oidscripts.debuggers.interfaces import BridgeInterface, \
 
 instance = None
 
+# Events of the broadcaster waking up the event loop
+_REQUEST_QUEUED_EVENT = 1 << 0
+_STOP_HOOK_EVENT = 1 << 1
+
+# Buffers are read from the inferior in chunks of this many bytes, unless
+# OID_READ_CHUNK_SIZE is set
+_DEFAULT_READ_CHUNK_SIZE = 4 << 20
+
+# Seconds between the progress reports of long buffer reads
+_READ_PROGRESS_INTERVAL = 1.0
+
+
+def _get_read_chunk_size():
+    try:
+        chunk_size = int(os.environ.get('OID_READ_CHUNK_SIZE', ''))
+    except ValueError:
+        return _DEFAULT_READ_CHUNK_SIZE
+
+    return chunk_size if chunk_size > 0 else _DEFAULT_READ_CHUNK_SIZE
+
 
 class LldbBridge(BridgeInterface):
     """
@@ -31,15 +53,26 @@ class LldbBridge(BridgeInterface):
         self._lock = threading.Lock()
         self._event_queue = []
         self._event_handler = None
+        self._last_stop_id = 0
         self._last_thread_id = 0
         self._last_frame_idx = 0
+        # lldb.debugger is only guaranteed to be set while the script is
+        # being imported
+        self._debugger = lldb.debugger
+        self._wakeup_broadcaster = lldb.SBBroadcaster('OpenImageDebugger')
+        self._read_chunk_size = _get_read_chunk_size()
+        # Observable symbols of each scope, keyed by (module, function, block
+        # range)
+        self._scope_symbols = {}
+        # Context given to select_context
+        self._context = None
         event_loop_thread = threading.Thread(target=self.event_loop)
         event_loop_thread.daemon = True
         event_loop_thread.start()
 
     def get_lldb_backend(self):
         # type: () -> lldb.SBDebugger
-        return lldb.debugger
+        return self._debugger
 
     def get_backend_name(self):
         return 'lldb'
@@ -50,12 +83,17 @@ class LldbBridge(BridgeInterface):
             thread = self._get_thread(process)
             frame = self._get_frame(thread)
 
+            # Stops and frame selections are notified both by the listener
+            # and the stop hook, but are only handled once
+            stop_id = process.GetStopID()
             thread_id = thread.id if thread is not None else 0
             frame_idx = frame.idx if thread is not None else 0
 
-            frame_was_updated = thread_id != self._last_thread_id or \
+            frame_was_updated = stop_id != self._last_stop_id or \
+                                thread_id != self._last_thread_id or \
                                 frame_idx != self._last_frame_idx
 
+            self._last_stop_id = stop_id
             self._last_thread_id = thread_id
             self._last_frame_idx = frame_idx
 
@@ -63,9 +101,47 @@ class LldbBridge(BridgeInterface):
                 with self._lock:
                     self._event_queue.append('stop')
 
+    def _create_listener(self):
+        # type: () -> lldb.SBListener
+        listener = lldb.SBListener('OpenImageDebugger')
+        listener.StartListeningForEventClass(
+            self.get_lldb_backend(),
+            lldb.SBProcess.GetBroadcasterClassName(),
+            lldb.SBProcess.eBroadcastBitStateChanged)
+        listener.StartListeningForEventClass(
+            self.get_lldb_backend(),
+            lldb.SBThread.GetBroadcasterClassName(),
+            lldb.SBThread.eBroadcastBitSelectedFrameChanged |
+            lldb.SBThread.eBroadcastBitThreadSelected)
+        listener.StartListeningForEvents(
+            self._wakeup_broadcaster,
+            _REQUEST_QUEUED_EVENT | _STOP_HOOK_EVENT)
+        return listener
+
+    def _handle_event(self, event):
+        # type: (lldb.SBEvent) -> None
+        if event.BroadcasterMatchesRef(self._wakeup_broadcaster):
+            if event.GetType() & _STOP_HOOK_EVENT:
+                self._check_frame_modification()
+        elif lldb.SBProcess.EventIsProcessEvent(event):
+            # Stops which resume right away aren't shown
+            if lldb.SBProcess.GetStateFromEvent(event) == lldb.eStateStopped \
+                    and not lldb.SBProcess.GetRestartedFromEvent(event):
+                self._check_frame_modification()
+        elif lldb.SBThread.EventIsThreadEvent(event):
+            self._check_frame_modification()
+
     def event_loop(self):
+        listener = self._create_listener()
+        event = lldb.SBEvent()
+
         while True:
-            self._check_frame_modification()
+            # Sleeps until the debugger stops, a frame is selected or a
+            # request is queued
+            if listener.WaitForEvent(lldb.UINT32_MAX, event):
+                self._handle_event(event)
+            while listener.GetNextEvent(event):
+                self._handle_event(event)
 
             requests_to_process = []
             with self._lock:
@@ -86,12 +162,12 @@ class LldbBridge(BridgeInterface):
                 callback = requests_to_process.pop(0)
                 callback()
 
-            time.sleep(0.1)
-
     def queue_request(self, callable_request):
         # type: (Callable[[None],None]) -> None
         with self._lock:
             self._pending_requests.append(callable_request)
+        self._wakeup_broadcaster.BroadcastEventByType(_REQUEST_QUEUED_EVENT,
+                                                      True)
 
     def _get_process(self, debugger):
         # type: (lldb.SBDebugger) -> lldb.SBProcess
@@ -111,17 +187,72 @@ class LldbBridge(BridgeInterface):
             return None
         return thread.GetSelectedFrame()
 
+    def select_context(self, context):
+        self._context = context
+
+    def get_thread_contexts(self, context):
+        debugger = self.get_lldb_backend()
+        thread_contexts = []
+        for target_index in range(debugger.GetNumTargets()):
+            process = debugger.GetTargetAtIndex(target_index).process
+            thread_ids = sorted(thread.GetIndexID() for thread in process)
+            for thread_id in thread_ids:
+                thread_contexts.append(
+                    context.with_thread(target_index + 1, thread_id))
+        return thread_contexts
+
+    def _get_context_frame(self, expression):
+        # type: (str) -> lldb.SBFrame
+        """
+        Get the frame the expression is evaluated in, or None if the debugger
+        state has none. Frames of the selected context are looked up rather
+        than selected, as their selection would be handled as a new stop.
+        Contexts without a frame use the innermost frame defining the
+        variable path of the expression.
+        """
+        context = self._context
+        if context is None:
+            return self._get_frame(
+                self._get_thread(self._get_process(self.get_lldb_backend())))
+
+        debugger = self.get_lldb_backend()
+        if context.inferior is not None:
+            target = debugger.GetTargetAtIndex(context.inferior - 1)
+        else:
+            target = debugger.GetSelectedTarget()
+
+        thread = target.process.GetThreadByIndexID(context.thread) \
+            if target.IsValid() else lldb.SBThread()
+        if not thread.IsValid():
+            raise Exception('No thread %s' % context)
+
+        if context.frame is not None:
+            frame = thread.GetFrameAtIndex(context.frame)
+            if not frame.IsValid():
+                raise Exception('No frame %d in thread %s' %
+                                (context.frame, context))
+            return frame
+
+        for frame_index in range(thread.GetNumFrames()):
+            frame = thread.GetFrameAtIndex(frame_index)
+            if frame.GetValueForVariablePath(expression).IsValid():
+                return frame
+
+        # Expressions besides variable paths are evaluated by the innermost
+        # frame
+        return thread.GetFrameAtIndex(0)
+
     def get_buffer_metadata(self, variable):
         # type: (str) -> dict
-        process = self._get_process(self.get_lldb_backend())
-        thread = self._get_thread(process)
-        frame = self._get_frame(thread)
+        expression = contexts.parse(variable)[0]
+        frame = self._get_context_frame(expression)
 
         if frame is None:
             # Could not fetch frame from debugger state
             return None
 
-        picked_obj = frame.EvaluateExpression(variable)  # type: lldb.SBValue
+        process = frame.GetThread().GetProcess()
+        picked_obj = frame.EvaluateExpression(expression)  # type: lldb.SBValue
 
         buffer_metadata = self._type_bridge.get_buffer_metadata(
             variable, SymbolWrapper(picked_obj), self)
@@ -145,18 +276,115 @@ class LldbBridge(BridgeInterface):
         elif bufsize >= sysinfo.get_available_memory() / 10:
             raise Exception('Invalid buffer size larger than available memory')
 
+        if buffer_metadata.pop('device', False):
+            raise Exception('Buffers in device memory require cuda-gdb')
+
         buffer_metadata['variable_name'] = variable
-        buffer_metadata['pointer'] = memoryview(process.ReadMemory(
-            buffer_metadata['pointer'], bufsize, lldb.SBError()))
+
+        # Remote targets may not share the byte order of the host, which the
+        # bridge library converts the values to
+        is_big_endian = process.GetByteOrder() == lldb.eByteOrderBig
+        buffer_metadata.setdefault('endianness',
+                                   'big' if is_big_endian else 'little')
+
+        # Only the selected slice of tensors is read
+        address = buffer_metadata['pointer'] + \
+            buffer_metadata.pop('slice_offset', 0)
+        buffer_metadata['pointer'] = self._read_memory(
+            process, address, bufsize, variable)
 
         return buffer_metadata
 
+    def _read_memory(self, process, address, size, variable):
+        # type: (lldb.SBProcess, int, int, str) -> memoryview
+        """
+        Read the buffer chunk by chunk, straight into the memory handed over
+        to the bridge library. Reads taking long, such as those of remote
+        targets, report their progress.
+        """
+        contents = memoryview(bytearray(size))
+
+        last_report = time.time()
+        offset = 0
+        while offset < size:
+            length = min(self._read_chunk_size, size - offset)
+            error = lldb.SBError()
+            chunk = process.ReadMemory(address + offset, length, error)
+            if not error.Success():
+                raise Exception('Could not read buffer: %s' %
+                                error.GetCString())
+
+            contents[offset:offset + length] = chunk
+            offset += length
+
+            now = time.time()
+            if offset < size and now - last_report >= _READ_PROGRESS_INTERVAL:
+                print('[OpenImageDebugger] Reading %s: %d%%' %
+                      (variable, 100 * offset // size))
+                last_report = now
+
+        return contents
+
     def register_event_handlers(self, event_handler):
         self._event_handler = event_handler
 
     def get_casted_pointer(self, typename, lldb_object):
         return lldb_object.get_casted_pointer()
 
+    @staticmethod
+    def _get_referenced_value(symbol):
+        # type: (lldb.SBValue) -> lldb.SBValue
+        if symbol.TypeIsPointerType() or symbol.GetType().IsReferenceType():
+            return symbol.Dereference()
+        return symbol
+
+    def select_tensor_slice(self, variable, tensor_index):
+        self._type_bridge.select_tensor_slice(variable, tensor_index)
+
+    def get_member_layout(self, lldb_object, member_paths):
+        symbol = LldbBridge._get_referenced_value(lldb_object.get_value())
+        object_address = symbol.GetLoadAddress()
+        if object_address == lldb.LLDB_INVALID_ADDRESS:
+            return None
+
+        members = []
+        for member_path in member_paths:
+            expression_path = ''.join(
+                '[%d]' % key if isinstance(key, int) else '.' + key
+                for key in member_path)
+            member = symbol.GetValueForExpressionPath(expression_path)
+            member_address = member.GetLoadAddress()
+            member_size = member.GetByteSize()
+            type_flags = member.GetType().GetTypeFlags()
+            if (not member.IsValid() or
+                    member_address == lldb.LLDB_INVALID_ADDRESS or
+                    member_size not in (1, 2, 4, 8) or
+                    not type_flags & (lldb.eTypeIsInteger |
+                                      lldb.eTypeIsPointer |
+                                      lldb.eTypeIsEnumeration)):
+                return None
+
+            is_signed = (not type_flags & lldb.eTypeIsPointer and
+                         bool(type_flags & lldb.eTypeIsSigned))
+            members.append((member_address - object_address,
+                            member_size,
+                            is_signed))
+        return members
+
+    def read_object_header(self, lldb_object, size):
+        symbol = LldbBridge._get_referenced_value(lldb_object.get_value())
+        address = symbol.GetLoadAddress()
+        if address == lldb.LLDB_INVALID_ADDRESS:
+            return None
+
+        # The object may live in another inferior than the selected one
+        process = symbol.GetProcess()
+        error = lldb.SBError()
+        header = process.ReadMemory(address, size, error)
+        if not error.Success():
+            return None
+        return header
+
     def _get_observable_children_members(self, symbol, member_name_chain,
                                          output_set, visited_typenames=set()):
         # type: (lldb.SBValue, list[str], set, set) -> None
@@ -190,6 +418,17 @@ class LldbBridge(BridgeInterface):
         if not frame:
             return set()
 
+        # The symbols visible from a block never change, so stepping within
+        # the same scope reuses the previous result
+        block = frame.GetBlock()
+        scope = (frame.GetModule().GetUUIDString(),
+                 frame.GetFunctionName(),
+                 block.GetRangeStartAddress(0).GetFileAddress(),
+                 block.GetRangeEndAddress(0).GetFileAddress())
+        scope_symbols = self._scope_symbols.get(scope)
+        if scope_symbols is not None:
+            return set(scope_symbols)
+
         available_symbols = set()
 
         for symbol in frame.GetVariables(True, True, True, True):
@@ -202,11 +441,13 @@ class LldbBridge(BridgeInterface):
             self._get_observable_children_members(symbol, member_name_chain,
                                                   available_symbols)
 
-        return available_symbols
+        self._scope_symbols[scope] = available_symbols
+        return set(available_symbols)
 
     def stop_hook(self, *args):
-        with self._lock:
-            self._event_queue.append('stop')
+        # The stop is inspected by the event loop, which may have been
+        # notified of it already
+        self._wakeup_broadcaster.BroadcastEventByType(_STOP_HOOK_EVENT, True)
 
 
 class SymbolWrapper(DebuggerSymbolReference):
@@ -241,6 +482,10 @@ class SymbolWrapper(DebuggerSymbolReference):
         symbol_child = get_symbol_child(member)
         return SymbolWrapper(symbol_child)
 
+    def get_value(self):
+        # type: () -> lldb.SBValue
+        return self._symbol
+
     def get_casted_pointer(self):
         if self._symbol.TypeIsPointerType():
             buff_addr = self._symbol.GetValueAsUnsigned()
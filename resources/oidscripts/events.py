@@ -6,6 +6,7 @@ Implementation of handlers for events raised by the debugger
 
 import time
 
+from oidscripts import scheduler
 from oidscripts.debuggers.interfaces import BridgeEventHandlerInterface
 
 
@@ -17,14 +18,20 @@ class OpenImageDebuggerEvents(BridgeEventHandlerInterface):
         self._window = window
         self._debugger = debugger
 
-    def _set_symbol_complete_list(self):
+    def _discover_symbols(self):
         """
-        Retrieve the list of available symbols and provide it to the OID window
-        for autocompleting.
+        Retrieve the list of available symbols one step at a time, and provide
+        it to the OID window for autocompleting. Plots requested by the window
+        meanwhile run between the steps.
         """
-        observable_symbols = list(self._debugger.get_available_symbols())
-        if self._window.is_ready():
-            self._window.set_available_symbols(observable_symbols)
+        discovery_begin = time.time()
+        observable_symbols = None
+        for observable_symbols in self._debugger.iter_available_symbols():
+            yield
+
+        self._window.trace_span('get_available_symbols', discovery_begin)
+        if observable_symbols is not None and self._window.is_ready():
+            self._window.set_available_symbols(list(observable_symbols))
 
     def exit_handler(self):
         self._window.terminate()
@@ -34,19 +41,42 @@ class OpenImageDebuggerEvents(BridgeEventHandlerInterface):
         The debugger has stopped (e.g. a breakpoint was hit). We must list all
         available buffers and pass it to the Open Image Debugger window.
         """
-        # Block until the window is up and running
+        # Initializing the window blocks until it has connected to the bridge
         if not self._window.is_ready():
             self._window.initialize_window()
-            while not self._window.is_ready():
-                time.sleep(0.1)
+            if not self._window.is_ready():
+                print('[OpenImageDebugger] Error: Could not connect to the '
+                      'OpenImageDebugger window')
+                return
 
-        # Update buffers being visualized
+        # Update buffers being visualized, after dropping the transfers of the
+        # previous stop which are still in flight. The displayed buffers are
+        # plotted right away, and everything else is scheduled after them.
+        self._window.begin_stop()
         observed_buffers = self._window.get_observed_buffers()
-        for buffer_name in observed_buffers:
-            self._window.plot_variable(buffer_name)
+        displayed_buffers = [buffer for buffer
+                             in self._window.get_displayed_buffers()
+                             if buffer in observed_buffers]
+        self._window.plot_variables(displayed_buffers)
+
+        # Work left from the previous stop is out of date
+        self._window.cancel_scheduled(scheduler.PRIORITY_OBSERVED)
+        self._window.cancel_scheduled(scheduler.PRIORITY_DISCOVERY)
+        self._window.cancel_prefetches()
+
+        hidden_buffers = [buffer for buffer in observed_buffers
+                          if buffer not in displayed_buffers]
+        if len(hidden_buffers) > 0:
+            self._window.schedule(
+                scheduler.PRIORITY_OBSERVED,
+                lambda: self._window.plot_variables(hidden_buffers))
 
         # Set list of available symbols
-        self._set_symbol_complete_list()
+        self._window.schedule(scheduler.PRIORITY_DISCOVERY,
+                              self._discover_symbols())
+
+        # Report plots that failed since the last stop
+        self._window.run_event_loop()
 
     def plot_handler(self, variable_name):
         """
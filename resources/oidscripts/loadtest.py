@@ -0,0 +1,332 @@
+# -*- coding: utf-8 -*-
+
+"""
+Headless load generator for the OpenImageDebugger shared library. Plots
+synthetic buffers without a debugger, at a fixed rate and with a given fraction
+of their pixels changed between updates, and reports the latency and the
+throughput of the window for each combination of transport and update mode.
+"""
+
+import json
+import math
+import os
+import sys
+import time
+
+from oidscripts import oidwindow
+from oidscripts import symbols
+from oidscripts.debuggers.interfaces import BridgeInterface
+
+
+# Element size in bytes and OID type of each supported buffer type
+_TYPES = {
+    'uint8': (1, symbols.OID_TYPES_UINT8),
+    'int8': (1, symbols.OID_TYPES_INT8),
+    'uint16': (2, symbols.OID_TYPES_UINT16),
+    'int16': (2, symbols.OID_TYPES_INT16),
+    'int32': (4, symbols.OID_TYPES_INT32),
+    'uint32': (4, symbols.OID_TYPES_UINT32),
+    'float16': (2, symbols.OID_TYPES_FLOAT16),
+    'float32': (4, symbols.OID_TYPES_FLOAT32),
+    'float64': (8, symbols.OID_TYPES_FLOAT64),
+    'bool': (1, symbols.OID_TYPES_BOOL),
+}
+
+TYPE_NAMES = sorted(_TYPES)
+
+# Bridge options of each transport and update mode
+_TRANSPORTS = {
+    'tcp': {'shared_memory': False},
+    'shm': {'shared_memory': True},
+}
+
+_MODES = {
+    'full': {'delta_updates': False},
+    'delta': {'delta_updates': True},
+}
+
+TRANSPORT_NAMES = sorted(_TRANSPORTS)
+MODE_NAMES = sorted(_MODES)
+
+
+def add_arguments(parser):
+    """
+    Add the options of the load test to the argparse parser of oid.py
+    """
+    group = parser.add_argument_group('load test')
+    group.add_argument('--load-test',
+                       help='Plot synthetic buffers in a headless window and '
+                            'print the measurements as JSON lines',
+                       action='store_true')
+    group.add_argument('--buffers', type=int, default=4,
+                       help='Amount of buffers plotted at each update')
+    group.add_argument('--width', type=int, default=1920)
+    group.add_argument('--height', type=int, default=1080)
+    group.add_argument('--channels', type=int, default=3,
+                       choices=[1, 2, 3, 4])
+    group.add_argument('--type', default='uint8', choices=TYPE_NAMES)
+    group.add_argument('--rate', type=float, default=10.0,
+                       help='Updates per second; 0 updates as fast as the '
+                            'window allows')
+    group.add_argument('--updates', type=int, default=100,
+                       help='Amount of measured updates of each combination')
+    group.add_argument('--changed-fraction', type=float, default=0.1,
+                       help='Fraction of the rows of each buffer changed '
+                            'between updates')
+    group.add_argument('--transport', default='all',
+                       choices=TRANSPORT_NAMES + ['all'])
+    group.add_argument('--mode', default='all',
+                       choices=MODE_NAMES + ['all'])
+    group.add_argument('--output',
+                       help='File the results are written to, instead of the '
+                            'standard output')
+
+
+def oidloadtest(script_path, args):
+    """
+    Entry point for the load test mode. Every combination of transport and
+    update mode is measured with a window of its own.
+    """
+    # The window doesn't need a display, unless one is explicitly chosen (e.g.
+    # if the offscreen platform has no OpenGL support on this host)
+    os.environ.setdefault('QT_QPA_PLATFORM', 'offscreen')
+
+    transports = TRANSPORT_NAMES if args.transport == 'all' \
+        else [args.transport]
+    modes = MODE_NAMES if args.mode == 'all' else [args.mode]
+
+    output = open(args.output, 'w') if args.output else sys.stdout
+    try:
+        for transport in transports:
+            for mode in modes:
+                result = _run(script_path, args, transport, mode)
+                output.write(json.dumps(result, sort_keys=True) + '\n')
+                output.flush()
+    finally:
+        if output is not sys.stdout:
+            output.close()
+
+
+def _run(script_path, args, transport, mode):
+    """
+    Measure the updates of a single combination of transport and update mode
+    """
+    generator = LoadGenerator(args.buffers,
+                              args.width,
+                              args.height,
+                              args.channels,
+                              args.type,
+                              args.changed_fraction)
+
+    bridge_options = {}
+    bridge_options.update(_TRANSPORTS[transport])
+    bridge_options.update(_MODES[mode])
+
+    window = oidwindow.OpenImageDebuggerWindow(script_path,
+                                               generator,
+                                               bridge_options)
+    window.initialize_window()
+
+    while not window.is_ready():
+        time.sleep(0.1)
+
+    names = generator.get_available_symbols()
+    window.set_available_symbols(names)
+
+    # The first plot always sends the whole buffers, and isn't measured
+    _update(window, generator, names)
+
+    period = 1.0 / args.rate if args.rate > 0 else 0.0
+    latencies = []
+    begin = time.time()
+    next_update = begin
+    for _ in range(args.updates):
+        if not window.is_ready():
+            break
+
+        generator.mutate()
+        latencies.append(_update(window, generator, names))
+
+        next_update += period
+        delay = next_update - time.time()
+        if delay > 0:
+            time.sleep(delay)
+    elapsed = time.time() - begin
+
+    window.terminate()
+    generator.kill()
+
+    updates = len(latencies)
+    throughput = updates / elapsed if elapsed > 0 else 0.0
+    latencies.sort()
+    return {
+        'transport': transport,
+        'mode': mode,
+        'buffers': args.buffers,
+        'width': args.width,
+        'height': args.height,
+        'channels': args.channels,
+        'type': args.type,
+        'changed_fraction': args.changed_fraction,
+        'target_rate': args.rate,
+        'updates': updates,
+        'elapsed_s': elapsed,
+        'updates_per_s': throughput,
+        'bytes_per_s': throughput * generator.update_size(),
+        'latency_ms': {
+            'mean': _to_ms(sum(latencies) / updates if updates else None),
+            'p50': _to_ms(_percentile(latencies, 0.5)),
+            'p95': _to_ms(_percentile(latencies, 0.95)),
+            'max': _to_ms(latencies[-1] if updates else None),
+        },
+    }
+
+
+def _update(window, generator, names):
+    """
+    Plot all buffers of the generator as a new stop, and return the seconds
+    until the window has received them.
+    """
+    begin = time.time()
+    window.begin_stop()
+    window.plot_variables(names)
+
+    # The window answers in the same order it processes its messages, so the
+    # response only arrives after the plots were received
+    window.get_observed_buffers()
+    latency = time.time() - begin
+
+    # Handles the buffers requested by the window meanwhile
+    generator.run_event_loop()
+
+    return latency
+
+
+def _to_ms(seconds):
+    return 1e3 * seconds if seconds is not None else None
+
+
+def _percentile(sorted_values, fraction):
+    if not sorted_values:
+        return None
+
+    position = int(math.ceil(fraction * len(sorted_values))) - 1
+    return sorted_values[max(0, min(position, len(sorted_values) - 1))]
+
+
+class LoadGenerator(BridgeInterface):
+    """
+    Implementation of a debugger bridge whose buffers are generated, and
+    partially rewritten by mutate() between the updates.
+    """
+    def __init__(self, buffer_count, width, height, channels, type_name,
+                 changed_fraction):
+        element_size, oid_type = _TYPES[type_name]
+        self._row_length = width * channels * element_size
+        self._changed_rows = min(height,
+                                 int(math.ceil(changed_fraction * height)))
+        self._height = height
+        self._update_counter = 0
+
+        self._contents = {}
+        self._buffers = {}
+        for index in range(buffer_count):
+            name = 'load_buffer_%d' % index
+            contents = bytearray(self._row_length * height)
+            self._contents[name] = contents
+            self._buffers[name] = {
+                'variable_name': name,
+                'display_name': '%s* %s' % (type_name, name),
+                'pointer': memoryview(contents),
+                'width': width,
+                'height': height,
+                'channels': channels,
+                'type': oid_type,
+                'row_stride': width,
+                'pixel_layout': 'rgba',
+                'transpose_buffer': False
+            }
+        self._buffer_names = sorted(self._buffers)
+
+        self._is_running = True
+        self._incoming_request_queue = []
+
+    def mutate(self):
+        """
+        Rewrite a band of changed_fraction of the rows of every buffer. The
+        band moves at each update, so consecutive updates differ.
+        """
+        if self._changed_rows == 0:
+            return
+
+        self._update_counter += 1
+
+        # Bytes in [1, 64] are finite and positive in every element type
+        pattern = bytes(bytearray([self._update_counter % 64 + 1]))
+        first_row = (self._update_counter * self._changed_rows) % self._height
+        for contents in self._contents.values():
+            for band in self._row_bands(first_row):
+                begin = band[0] * self._row_length
+                end = band[1] * self._row_length
+                contents[begin:end] = pattern * (end - begin)
+
+    def update_size(self):
+        """
+        Size in bytes of all buffers plotted at each update
+        """
+        return len(self._contents) * self._row_length * self._height
+
+    def _row_bands(self, first_row):
+        last_row = first_row + self._changed_rows
+        if last_row <= self._height:
+            return [(first_row, last_row)]
+
+        return [(first_row, self._height), (0, last_row - self._height)]
+
+    def run_event_loop(self):
+        if self._is_running:
+            request_queue = self._incoming_request_queue
+            self._incoming_request_queue = []
+
+            while len(request_queue) > 0:
+                latest_request = request_queue.pop(-1)
+                latest_request()
+
+    def kill(self):
+        """
+        Request consumer thread to finish its execution
+        """
+        self._is_running = False
+
+    def get_casted_pointer(self, typename, debugger_object):
+        """
+        No need to cast anything in the load test
+        """
+        return debugger_object
+
+    def register_event_handlers(self, events):
+        """
+        No need to register events in the load test
+        """
+        pass
+
+    def get_available_symbols(self):
+        """
+        Return the names of the generated buffers
+        """
+        return self._buffer_names
+
+    def get_buffer_metadata(self, var_name):
+        """
+        Search in the list of generated buffers and return the requested one
+        """
+        if var_name in self._buffers:
+            return self._buffers[var_name]
+
+        return None
+
+    def get_backend_name(self):  # type: () -> str
+        return 'loadtest'
+
+    def queue_request(self, callable_request):
+        self._incoming_request_queue.append(callable_request)
@@ -12,6 +12,9 @@ from oidscripts import symbols
 from oidscripts.oidtypes import interface
 
 
+EIGEN_TYPE_REGEX = re.compile(r'(const\s+)?Eigen::(\s+?[*&])?')
+
+
 class EigenXX(interface.TypeInspectorInterface):
     """
     Implementation for inspecting Eigen::Matrix and Eigen::Map
@@ -68,6 +71,14 @@ class EigenXX(interface.TypeInspectorInterface):
             type_value = symbols.OID_TYPES_FLOAT64
         elif current_type == 'int':
             type_value = symbols.OID_TYPES_INT32
+        elif current_type == 'unsigned int':
+            type_value = symbols.OID_TYPES_UINT32
+        elif current_type == 'signed char':
+            type_value = symbols.OID_TYPES_INT8
+        elif current_type == 'bool':
+            type_value = symbols.OID_TYPES_BOOL
+        elif current_type == 'Eigen::half':
+            type_value = symbols.OID_TYPES_FLOAT16
 
         # Differentiate between Map and dynamic/static Matrices
         if is_eigen_map:
@@ -104,5 +115,4 @@ class EigenXX(interface.TypeInspectorInterface):
         """
         # Check if symbol type is the expected buffer
         symbol_type = str(symbol.type)
-        type_regex = r'(const\s+)?Eigen::(\s+?[*&])?'
-        return re.match(type_regex, symbol_type) is not None
+        return EIGEN_TYPE_REGEX.match(symbol_type) is not None
@@ -7,6 +7,8 @@ plotted in the OpenImageDebugger window.
 """
 
 import abc
+import re
+import struct
 
 
 def debug_buffer_metadata(func):
@@ -44,12 +46,79 @@ def debug_symbol_observable(func):
     return wrapper
 
 
+class BufferLayout(object):
+    """
+    Declares the members of a buffer type that hold its metadata, as a
+    mapping from a header field name to the path of the member within the
+    type, e.g. BufferLayout(rows='rows', step='step.buf[0]'). Only integer
+    and pointer members are supported.
+    """
+    _PATH_TOKEN_REGEX = re.compile(r'\.?([A-Za-z_]\w*)|\[(\d+)\]')
+
+    def __init__(self, **member_paths):
+        self.field_names = sorted(member_paths)
+        self.member_paths = [BufferLayout.parse_member_path(member_paths[name])
+                             for name in self.field_names]
+
+    @staticmethod
+    def parse_member_path(path):
+        """
+        Splits a member path such as 'step.buf[0]' into the list of member
+        names and array indices ['step', 'buf', 0]
+        """
+        keys = []
+        for name, index in BufferLayout._PATH_TOKEN_REGEX.findall(path):
+            keys.append(name if name else int(index))
+        return keys
+
+
+class ResolvedBufferLayout(object):
+    """
+    BufferLayout bound to the member offsets of one concrete type, which can
+    decode the header fields from a single read of the object memory
+    """
+    _INTEGER_FORMATS = {1: 'b', 2: 'h', 4: 'i', 8: 'q'}
+
+    def __init__(self, field_names, members):
+        # type: (list, list) -> None
+        """
+        members holds the (offset, size, is_signed) of each field in
+        field_names, as given by the debugger bridge
+        """
+        self._fields = []
+        self.header_size = 0
+        for name, (offset, size, is_signed) in zip(field_names, members):
+            integer_format = ResolvedBufferLayout._INTEGER_FORMATS[size]
+            if not is_signed:
+                integer_format = integer_format.upper()
+            self._fields.append(
+                (name, offset, struct.Struct('=' + integer_format)))
+            self.header_size = max(self.header_size, offset + size)
+
+    def decode(self, header):
+        # type: (bytes) -> dict
+        """
+        Unpacks the header fields from the first header_size bytes of an
+        object
+        """
+        return {name: field.unpack_from(header, offset)[0]
+                for name, offset, field in self._fields}
+
+
 class TypeInspectorInterface(object):
     """
     This interface defines methods to be implemented by type inspectors that
     extract information required for plotting buffers.
+
+    Inspectors may also declare a buffer_layout, in which case the TypeBridge
+    resolves the member offsets once per type and reads each buffer header
+    with a single memory read, handing the decoded fields to
+    get_buffer_metadata_from_header. Debuggers that can't resolve the layout
+    fall back to get_buffer_metadata.
     """
 
+    buffer_layout = None  # type: BufferLayout
+
     @abc.abstractmethod
     def get_buffer_metadata(self,
                             obj_name,  # type: str
@@ -71,6 +140,7 @@ class TypeInspectorInterface(object):
          * row_stride
          * pixel_layout
          * transpose_buffer
+         * endianness (optional, the byte order of the target by default)
 
          For information about these fields, consult the documentation for
          oid_plot_buffer in the file $ROOT/src/oid_window.h. The module
@@ -79,6 +149,19 @@ class TypeInspectorInterface(object):
         """
         pass
 
+    def get_buffer_metadata_from_header(self,
+                                        obj_name,  # type: str
+                                        picked_obj,  # type: DebuggerSymbolReference
+                                        header  # type: dict
+                                        ):
+        # type: (...) -> dict
+        """
+        Same as get_buffer_metadata, but the buffer fields are given in the
+        dictionary header, whose keys are the fields of buffer_layout. The
+        pointer field must be returned as an integer address.
+        """
+        raise NotImplementedError("Method is not implemented")
+
     @abc.abstractmethod
     def is_symbol_observable(self, symbol_obj, symbol_name):
         # type: (DebuggerSymbolReference, str) -> bool
@@ -86,6 +169,7 @@ class TypeInspectorInterface(object):
         Given the debugger symbol object symbol_obj, and its name
         symbol_name, this method must return True if the symbol corresponds
         to an observable variable (i.e. if its type corresponds to the type
-        of the buffers that you want to plot).
+        of the buffers that you want to plot). The result must only depend on
+        the symbol type, since it is memoized per type by the TypeBridge.
         """
         pass
@@ -19,50 +19,83 @@ CV_MAT_CN_MASK = ((CV_CN_MAX - 1) << CV_CN_SHIFT)
 CV_DEPTH_MAX = (1 << CV_CN_SHIFT)
 CV_MAT_TYPE_MASK = (CV_DEPTH_MAX * CV_CN_MAX - 1)
 
+MAT_TYPE_REGEX = re.compile(r'(const\s+)?cv::Mat(\s+?[*&])?$')
+CVMAT_TYPE_REGEX = re.compile(r'(const\s+)?CvMat(\s+?[*&])?')
+
+
+
+def _get_cv_buffer_metadata(obj_name, picked_obj, buffer, width, height,
+                            flags, step):
+    """
+    Builds the metadata of an OpenCV buffer from the members shared by its
+    Mat and CvMat representations
+    """
+    channels = ((((flags) & CV_MAT_CN_MASK) >> CV_CN_SHIFT) + 1)
+    row_stride = int(int(step)/channels)
+
+    if channels >= 3:
+        pixel_layout = 'bgra'
+    else:
+        pixel_layout = 'rgba'
+
+    cvtype = ((flags) & CV_MAT_TYPE_MASK)
+
+    # Depths map to the OID types of the same value, including CV_8S and
+    # CV_16F
+    type_value = (cvtype & 7)
+
+    if (type_value == symbols.OID_TYPES_UINT16 or
+        type_value == symbols.OID_TYPES_INT16 or
+        type_value == symbols.OID_TYPES_FLOAT16):
+        row_stride = int(row_stride / 2)
+    elif (type_value == symbols.OID_TYPES_INT32 or
+          type_value == symbols.OID_TYPES_FLOAT32):
+        row_stride = int(row_stride / 4)
+    elif type_value == symbols.OID_TYPES_FLOAT64:
+        row_stride = int(row_stride / 8)
+
+    return {
+        'display_name':  obj_name + ' (' + str(picked_obj.type) + ')',
+        'pointer': buffer,
+        'width': width,
+        'height': height,
+        'channels': channels,
+        'type': type_value,
+        'row_stride': row_stride,
+        'pixel_layout': pixel_layout,
+        'transpose_buffer' : False
+    }
+
 
 class Mat(interface.TypeInspectorInterface):
     """
     Implementation for inspecting OpenCV Mat classes
     """
+    buffer_layout = interface.BufferLayout(data='data',
+                                           cols='cols',
+                                           rows='rows',
+                                           flags='flags',
+                                           step='step.buf[0]')
+
     def get_buffer_metadata(self, obj_name, picked_obj, debugger_bridge):
         buffer = debugger_bridge.get_casted_pointer('char', picked_obj['data'])
 
-        width = int(picked_obj['cols'])
-        height = int(picked_obj['rows'])
-        flags = int(picked_obj['flags'])
-
-        channels = ((((flags) & CV_MAT_CN_MASK) >> CV_CN_SHIFT) + 1)
-        row_stride = int(int(picked_obj['step']['buf'][0])/channels)
-
-        if channels >= 3:
-            pixel_layout = 'bgra'
-        else:
-            pixel_layout = 'rgba'
-
-        cvtype = ((flags) & CV_MAT_TYPE_MASK)
-
-        type_value = (cvtype & 7)
-
-        if (type_value == symbols.OID_TYPES_UINT16 or
-            type_value == symbols.OID_TYPES_INT16):
-            row_stride = int(row_stride / 2)
-        elif (type_value == symbols.OID_TYPES_INT32 or
-              type_value == symbols.OID_TYPES_FLOAT32):
-            row_stride = int(row_stride / 4)
-        elif type_value == symbols.OID_TYPES_FLOAT64:
-            row_stride = int(row_stride / 8)
-
-        return {
-            'display_name':  obj_name + ' (' + str(picked_obj.type) + ')',
-            'pointer': buffer,
-            'width': width,
-            'height': height,
-            'channels': channels,
-            'type': type_value,
-            'row_stride': row_stride,
-            'pixel_layout': pixel_layout,
-            'transpose_buffer' : False
-        }
+        return _get_cv_buffer_metadata(obj_name,
+                                       picked_obj,
+                                       buffer,
+                                       int(picked_obj['cols']),
+                                       int(picked_obj['rows']),
+                                       int(picked_obj['flags']),
+                                       picked_obj['step']['buf'][0])
+
+    def get_buffer_metadata_from_header(self, obj_name, picked_obj, header):
+        return _get_cv_buffer_metadata(obj_name,
+                                       picked_obj,
+                                       header['data'],
+                                       header['cols'],
+                                       header['rows'],
+                                       header['flags'],
+                                       header['step'])
 
     def is_symbol_observable(self, symbol, symbol_name):
         """
@@ -72,56 +105,43 @@ class Mat(interface.TypeInspectorInterface):
         """
         # Check if symbol type is the expected buffer
         symbol_type = str(symbol.type)
-        type_regex = r'(const\s+)?cv::Mat(\s+?[*&])?$'
-        return re.match(type_regex, symbol_type) is not None
+        return MAT_TYPE_REGEX.match(symbol_type) is not None
 
 class CvMat(interface.TypeInspectorInterface):
     """
     Implementation for inspecting OpenCV CvMat structs
     """
+    buffer_layout = interface.BufferLayout(data='data.ptr',
+                                           cols='cols',
+                                           rows='rows',
+                                           type='type',
+                                           step='step')
+
     def get_buffer_metadata(self, obj_name, picked_obj, debugger_bridge):
         buffer = debugger_bridge.get_casted_pointer('char', picked_obj['data'])
         if buffer == 0x0:
             raise Exception('Received null buffer!')
 
-        width = int(picked_obj['cols'])
-        height = int(picked_obj['rows'])
-        flags = int(picked_obj['type'])
-
-        channels = ((((flags) & CV_MAT_CN_MASK) >> CV_CN_SHIFT) + 1)
-        row_stride = int(int(picked_obj['step'])/channels)
-
-        if channels >= 3:
-            pixel_layout = 'bgra'
-        else:
-            pixel_layout = 'rgba'
-
-        cvtype = ((flags) & CV_MAT_TYPE_MASK)
-
-        type_value = (cvtype & 7)
-
-        if (type_value == symbols.OID_TYPES_UINT16 or
-            type_value == symbols.OID_TYPES_INT16):
-            row_stride = int(row_stride / 2)
-        elif (type_value == symbols.OID_TYPES_INT32 or
-              type_value == symbols.OID_TYPES_FLOAT32):
-            row_stride = int(row_stride / 4)
-        elif type_value == symbols.OID_TYPES_FLOAT64:
-            row_stride = int(row_stride / 8)
-
-        return {
-            'display_name':  obj_name + ' (' + str(picked_obj.type) + ')',
-            'pointer': buffer,
-            'width': width,
-            'height': height,
-            'channels': channels,
-            'type': type_value,
-            'row_stride': row_stride,
-            'pixel_layout': pixel_layout,
-            'transpose_buffer': False
-        }
+        return _get_cv_buffer_metadata(obj_name,
+                                       picked_obj,
+                                       buffer,
+                                       int(picked_obj['cols']),
+                                       int(picked_obj['rows']),
+                                       int(picked_obj['type']),
+                                       picked_obj['step'])
+
+    def get_buffer_metadata_from_header(self, obj_name, picked_obj, header):
+        if header['data'] == 0x0:
+            raise Exception('Received null buffer!')
+
+        return _get_cv_buffer_metadata(obj_name,
+                                       picked_obj,
+                                       header['data'],
+                                       header['cols'],
+                                       header['rows'],
+                                       header['type'],
+                                       header['step'])
 
     def is_symbol_observable(self, symbol, symbol_name):
         symbol_type = str(symbol.type)
-        type_regex = r'(const\s+)?CvMat(\s+?[*&])?'
-        return re.match(type_regex, symbol_type) is not None
+        return CVMAT_TYPE_REGEX.match(symbol_type) is not None
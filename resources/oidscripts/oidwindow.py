@@ -6,25 +6,90 @@ Classes related to exposing an interface to the OpenImageDebugger window
 
 import ctypes
 import ctypes.util
+import os
 import platform
 import sys
+import threading
 import time
 
+from oidscripts import contexts
+from oidscripts import scheduler
+
 FETCH_BUFFER_CBK_TYPE = ctypes.CFUNCTYPE(ctypes.c_int,
-                                         ctypes.c_char_p)
+                                         ctypes.c_char_p,
+                                         ctypes.c_int)
 
 
 PLATFORM_NAME = platform.system().lower()
 
+# Must match OID_MAX_TENSOR_AXES in oid_bridge.h
+MAX_TENSOR_AXES = 8
+
+
+class BufferDescriptor(ctypes.Structure):
+    """
+    Buffer metadata handed over to oid_plot_buffer_descriptors, which must
+    match OidBufferDescriptor in oid_bridge.h
+    """
+    _fields_ = [('variable_name', ctypes.c_char_p),
+                ('display_name', ctypes.c_char_p),
+                ('pixel_layout', ctypes.c_char_p),
+                ('address', ctypes.c_uint64),
+                ('inferior_pid', ctypes.c_int64),
+                ('width', ctypes.c_int32),
+                ('height', ctypes.c_int32),
+                ('channels', ctypes.c_int32),
+                ('type', ctypes.c_int32),
+                ('row_stride', ctypes.c_int32),
+                ('transpose_buffer', ctypes.c_int32),
+                ('planar', ctypes.c_int32),
+                ('tensor_axes', ctypes.c_int32),
+                ('tensor_shape', ctypes.c_int32 * MAX_TENSOR_AXES),
+                ('tensor_index', ctypes.c_int32 * MAX_TENSOR_AXES)]
+
+    @staticmethod
+    def from_metadata(buffer_metadata):
+        """
+        Builds the descriptor of a buffer read by the bridge library from the
+        memory of a local inferior, or returns None for any other buffer
+        """
+        if 'inferior_pid' not in buffer_metadata:
+            return None
+
+        tensor_shape = buffer_metadata.get('tensor_shape', [])
+        tensor_index = buffer_metadata.get('tensor_index', [])
+        if len(tensor_shape) > MAX_TENSOR_AXES:
+            raise Exception('Tensors of more than %d leading axes are not '
+                            'supported' % MAX_TENSOR_AXES)
+
+        axes_type = ctypes.c_int32 * MAX_TENSOR_AXES
+        return BufferDescriptor(
+            buffer_metadata['variable_name'].encode('utf-8'),
+            buffer_metadata['display_name'].encode('utf-8'),
+            buffer_metadata['pixel_layout'].encode('utf-8'),
+            buffer_metadata['pointer'],
+            buffer_metadata['inferior_pid'],
+            buffer_metadata['width'],
+            buffer_metadata['height'],
+            buffer_metadata['channels'],
+            buffer_metadata['type'],
+            buffer_metadata['row_stride'],
+            buffer_metadata.get('transpose_buffer', False),
+            buffer_metadata.get('planar', False),
+            len(tensor_shape),
+            axes_type(*tensor_shape),
+            axes_type(*tensor_index))
+
 
 class OpenImageDebuggerWindow(object):
     """
     Python interface for the OpenImageDebugger window, which is implemented as a
     shared library.
     """
-    def __init__(self, script_path, bridge):
+    def __init__(self, script_path, bridge, bridge_options=None):
         self._bridge = bridge
         self._script_path = script_path
+        self._bridge_options = bridge_options or {}
 
         # Request ctypes to load libGL before the native oidwindow does; this
         # fixes an issue on Ubuntu machines with nvidia drivers. For more
@@ -59,6 +124,15 @@ class OpenImageDebuggerWindow(object):
         ]
         self._lib.oid_set_available_symbols.restype = None
 
+        self._lib.oid_get_tensor_slice.argtypes = [
+            ctypes.c_void_p,
+            ctypes.c_char_p
+        ]
+        self._lib.oid_get_tensor_slice.restype = ctypes.py_object
+
+        self._lib.oid_get_displayed_buffers.argtypes = [ctypes.c_void_p]
+        self._lib.oid_get_displayed_buffers.restype = ctypes.py_object
+
         self._lib.oid_run_event_loop.argtypes = [ctypes.c_void_p]
         self._lib.oid_run_event_loop.restype = None
 
@@ -68,17 +142,54 @@ class OpenImageDebuggerWindow(object):
         ]
         self._lib.oid_plot_buffer.restype = None
 
+        self._lib.oid_plot_buffer_descriptor.argtypes = [
+            ctypes.c_void_p,
+            ctypes.POINTER(BufferDescriptor)
+        ]
+        self._lib.oid_plot_buffer_descriptor.restype = None
+
+        self._lib.oid_plot_buffer_descriptors.argtypes = [
+            ctypes.c_void_p,
+            ctypes.POINTER(BufferDescriptor),
+            ctypes.c_int
+        ]
+        self._lib.oid_plot_buffer_descriptors.restype = None
+
+        self._lib.oid_trace_span.argtypes = [
+            ctypes.c_void_p,
+            ctypes.c_char_p,
+            ctypes.c_double,
+            ctypes.c_double
+        ]
+        self._lib.oid_trace_span.restype = None
+
+        self._lib.oid_begin_stop.argtypes = [ctypes.c_void_p]
+        self._lib.oid_begin_stop.restype = None
+
+        self._lib.oid_begin_plot_batch.argtypes = [ctypes.c_void_p]
+        self._lib.oid_begin_plot_batch.restype = None
+
+        self._lib.oid_end_plot_batch.argtypes = [ctypes.c_void_p]
+        self._lib.oid_end_plot_batch.restype = None
+
+        # Variables waiting for the queued DeferredVariablePlotter, requested
+        # by the user or prefetched by the window. Requests arrive from a
+        # thread owned by the native library
+        self._pending_plots = []
+        self._pending_prefetches = []
+        self._pending_plots_lock = threading.Lock()
+
+        # Work of the debugger thread, run by order of priority
+        self._scheduler = scheduler.StopScheduler(bridge)
+
+        # Traces are written by the OID library, see OID_TRACE_DIR
+        self._is_tracing = bool(os.environ.get('OID_TRACE_DIR'))
+
         # UI handler
         self._native_handler = None
-        self._event_loop_wait_time = 1.0/30.0
-        self._previous_evloop_time = OpenImageDebuggerWindow.__get_time_ms()
         self._plot_variable_c_callback = FETCH_BUFFER_CBK_TYPE(self.plot_variable)
 
 
-    @staticmethod
-    def __get_time_ms():
-        return int(time.time() * 1000.0)
-
     @staticmethod
     def __get_library_name():
         """
@@ -94,14 +205,17 @@ class OpenImageDebuggerWindow(object):
         elif PLATFORM_NAME == 'windows':
             return 'liboidbridge%s.dll' % python_version
 
-    def plot_variable(self, requested_symbol):
+    def plot_variable(self, requested_symbol, is_prefetch=0):
         """
         Plot a variable whose name is 'requested_symbol'.
 
         This will result in the creation of a callable object of type
         DeferredVariablePlotter, where the actual code for plotting the buffer
-        will be executed. This object will be given to the debugger bridge so
-        that it can schedule its execution in a thread safe context.
+        will be executed. This object is scheduled to run in the debugger
+        thread, after the buffers displayed and observed at the last stop.
+        Variables requested before it runs are plotted by the same object, as
+        a single batch. Prefetched variables are plotted after any other work
+        of the stop.
         """
         if self._bridge is None:
             print('[OpenImageDebugger] Could not plot symbol %s: Not a debugging'
@@ -114,11 +228,22 @@ class OpenImageDebuggerWindow(object):
             else:
                 variable = requested_symbol
 
-            plot_callable = DeferredVariablePlotter(variable,
-                                                    self._lib,
-                                                    self._bridge,
-                                                    self._native_handler)
-            self._bridge.queue_request(plot_callable)
+            if is_prefetch:
+                pending_plots = self._pending_prefetches
+                priority = scheduler.PRIORITY_PREFETCH
+            else:
+                pending_plots = self._pending_plots
+                priority = scheduler.PRIORITY_REQUESTED
+
+            with self._pending_plots_lock:
+                is_plot_queued = len(pending_plots) > 0
+                if variable not in pending_plots:
+                    pending_plots.append(variable)
+
+            if not is_plot_queued:
+                self._scheduler.schedule(
+                    priority,
+                    DeferredVariablePlotter(self, bool(is_prefetch)))
             return 1
         except Exception as err:
             print('[OpenImageDebugger] Error: Could not plot variable')
@@ -126,6 +251,152 @@ class OpenImageDebuggerWindow(object):
 
         return 0
 
+    def plot_pending_variables(self, is_prefetch=False):
+        """
+        Plot all variables requested through plot_variable so far, or all
+        prefetched ones. Must be called from the debugger thread.
+        """
+        with self._pending_plots_lock:
+            if is_prefetch:
+                variables = self._pending_prefetches
+                self._pending_prefetches = []
+            else:
+                variables = self._pending_plots
+                self._pending_plots = []
+
+        self.plot_variables(variables)
+
+    def cancel_prefetches(self):
+        """
+        Drop the prefetched variables not plotted yet, which the window evicts
+        at the next stop anyway. Must be called from the debugger thread.
+        """
+        self._scheduler.cancel(scheduler.PRIORITY_PREFETCH)
+        with self._pending_plots_lock:
+            self._pending_prefetches = []
+
+    def plot_variables(self, variables):
+        """
+        Plot all variables in the list 'variables' as a single batch, which is
+        shown at once by the window. Must be called from the debugger thread.
+
+        Variables named after a context (see contexts.py) are evaluated in
+        it, each context being selected once for all of its variables.
+        """
+        # Buffers of remote inferiors are handed over as soon as their symbol
+        # is resolved, and sent by the bridge library in the background while
+        # the next ones are read by the debugger. Buffers of local inferiors
+        # are read by the bridge library in parallel, once all symbols of the
+        # batch are resolved.
+        discovery_begin = time.time()
+        is_batch_started = False
+        descriptors = []
+        try:
+            for context, group in self._group_by_context(variables):
+                try:
+                    self._bridge.select_context(context)
+                except Exception as err:
+                    print('[OpenImageDebugger] Error: Could not plot variable')
+                    print(err)
+                    continue
+
+                for variable, is_quiet in group:
+                    buffer_metadata = self._get_buffer_metadata(variable,
+                                                                is_quiet)
+                    if buffer_metadata is None:
+                        continue
+
+                    if not is_batch_started:
+                        self._lib.oid_begin_plot_batch(self._native_handler)
+                        is_batch_started = True
+
+                    try:
+                        descriptor = BufferDescriptor.from_metadata(
+                            buffer_metadata)
+                        if descriptor is not None:
+                            descriptors.append(descriptor)
+                        else:
+                            self._lib.oid_plot_buffer(self._native_handler,
+                                                      buffer_metadata)
+                    except Exception as err:
+                        print('[OpenImageDebugger] Error: Could not plot '
+                              'variable')
+                        print(err)
+        finally:
+            self._bridge.select_context(None)
+
+        self.trace_span('symbol discovery', discovery_begin)
+
+        if len(descriptors) > 0:
+            try:
+                self._lib.oid_plot_buffer_descriptors(
+                    self._native_handler,
+                    (BufferDescriptor * len(descriptors))(*descriptors),
+                    len(descriptors))
+            except Exception as err:
+                print('[OpenImageDebugger] Error: Could not plot variable')
+                print(err)
+
+        if is_batch_started:
+            self._lib.oid_end_plot_batch(self._native_handler)
+
+    def _group_by_context(self, variables):
+        """
+        Group the variables by the context they are evaluated in, as a list of
+        (context, [(variable, is_quiet)]). Variables of the thread '*' are
+        replaced by the same expression in each thread, and fail quietly as
+        it isn't expected to be defined in all of them.
+        """
+        groups = []
+        group_of_context = {}
+        listed_variables = set()
+
+        def add(context, variable, is_quiet):
+            if variable in listed_variables:
+                return
+            listed_variables.add(variable)
+
+            if context not in group_of_context:
+                group_of_context[context] = len(groups)
+                groups.append((context, []))
+            groups[group_of_context[context]][1].append((variable, is_quiet))
+
+        for context, group in contexts.group_by_context(variables):
+            if context is None or not context.is_any_thread():
+                for variable in group:
+                    add(context, variable, False)
+                continue
+
+            expressions = [contexts.parse(variable)[0] for variable in group]
+            for thread_context in self._bridge.get_thread_contexts(context):
+                for expression in expressions:
+                    add(thread_context,
+                        contexts.qualify(expression, thread_context),
+                        True)
+
+        return groups
+
+    def _get_buffer_metadata(self, variable, is_quiet):
+        """
+        Get the metadata of the variable from the bridge, or None if it can't
+        be plotted
+        """
+        try:
+            # Tensors are read from the slice selected in the window
+            self._bridge.select_tensor_slice(
+                variable,
+                self._lib.oid_get_tensor_slice(self._native_handler,
+                                               variable.encode('utf-8')))
+            return self._bridge.get_buffer_metadata(variable)
+        except Exception as err:
+            if not is_quiet:
+                import traceback
+                print('[OpenImageDebugger] Error: Could not plot variable')
+                print(err)
+                traceback.print_exc()
+
+        return None
+
     def is_ready(self):
         """
         Returns True if the OpenImageDebugger window has been loaded; False otherwise.
@@ -156,19 +427,34 @@ class OpenImageDebuggerWindow(object):
             self._native_handler,
             sorted_observable_symbols)
 
-    def run_event_loop(self):
+    def trace_span(self, name, begin_time):
         """
-        Run the debugger-side event loop, which consists of checking for new
-        user requests coming from the UI
+        Record the span of the debugger scripts started at begin_time (as
+        returned by time.time()) and ending now, if tracing is enabled in the
+        OID library.
         """
-        current_time = OpenImageDebuggerWindow.__get_time_ms()
-        dt = current_time - self._previous_evloop_time
-        if dt > self._event_loop_wait_time:
-            self._lib.oid_run_event_loop(self._native_handler)
-            self._previous_evloop_time = current_time
+        if not self._is_tracing or self._native_handler is None:
+            return
 
-        # Schedule next run of the event loop
-        self._bridge.queue_request(self.run_event_loop)
+        self._lib.oid_trace_span(self._native_handler,
+                                 name.encode('utf-8'),
+                                 begin_time,
+                                 time.time())
+
+    def begin_stop(self):
+        """
+        Notify the OID library of a new debugger stop. Buffers of the previous
+        stops still being sent to the window are superseded by the next plots.
+        """
+        self._lib.oid_begin_stop(self._native_handler)
+
+    def run_event_loop(self):
+        """
+        Run the debugger-side event loop, which reports plots that failed
+        after being handed over to the OID library. Requests coming from the
+        UI are forwarded to plot_variable as soon as they arrive.
+        """
+        self._lib.oid_run_event_loop(self._native_handler)
 
     def get_observed_buffers(self):
         """
@@ -176,44 +462,54 @@ class OpenImageDebuggerWindow(object):
         """
         return self._lib.oid_get_observed_buffers(self._native_handler)
 
+    def get_displayed_buffers(self):
+        """
+        Get a list with the buffers displayed in the OID window, the selected
+        one first
+        """
+        return self._lib.oid_get_displayed_buffers(self._native_handler)
+
+    def schedule(self, priority, task):
+        """
+        Run 'task' in the debugger thread once the more urgent work is done.
+        See StopScheduler for the priorities and the supported tasks.
+        """
+        self._scheduler.schedule(priority, task)
+
+    def cancel_scheduled(self, priority):
+        """
+        Drop the scheduled tasks of the given priority not finished yet
+        """
+        self._scheduler.cancel(priority)
+
     def initialize_window(self):
         # Initialize OID lib
+        optional_parameters = dict(self._bridge_options)
+        optional_parameters['oid_path'] = self._script_path
+        # Sessions attach to a long-lived window, see OID_WINDOW_DAEMON
+        optional_parameters.setdefault(
+            'window_daemon', bool(os.environ.get('OID_WINDOW_DAEMON')))
+        # The window runs on another host, see OID_REMOTE_PORT
+        if os.environ.get('OID_REMOTE_PORT'):
+            optional_parameters.setdefault(
+                'remote_port', int(os.environ['OID_REMOTE_PORT']))
         self._native_handler = self._lib.oid_initialize(
             self._plot_variable_c_callback,
-            {'oid_path': self._script_path})
+            optional_parameters)
 
         # Launch UI
         self._lib.oid_exec(self._native_handler)
 
-        # Schedule event loop
-        self._bridge.queue_request(self.run_event_loop)
-
 
 class DeferredVariablePlotter(object):
     """
-    Instances of this class are callable objects whose __call__ method triggers
-    a buffer plot command. Useful for deferring the plot command to a safe
-    thread.
+    Instances of this class are callable objects whose __call__ method plots
+    the variables requested to the window so far, or the prefetched ones.
+    Useful for deferring the plot command to a safe thread.
     """
-    def __init__(self, variable, lib, bridge, native_handler):
-        self._variable = variable
-        self._lib = lib
-        self._bridge = bridge
-        self._native_handler = native_handler
+    def __init__(self, window, is_prefetch=False):
+        self._window = window
+        self._is_prefetch = is_prefetch
 
     def __call__(self):
-        try:
-            buffer_metadata = self._bridge.get_buffer_metadata(self._variable)
-
-            if buffer_metadata is None:
-                return
-
-            self._lib.oid_plot_buffer(
-                self._native_handler,
-                buffer_metadata)
-
-        except Exception as err:
-            import traceback
-            print('[OpenImageDebugger] Error: Could not plot variable')
-            print(err)
-            traceback.print_exc()
+        self._window.plot_pending_variables(self._is_prefetch)
@@ -0,0 +1,89 @@
+# -*- coding: utf-8 -*-
+
+"""
+Scheduling of the work done by the debugger scripts at each stop
+"""
+
+import heapq
+import itertools
+import threading
+
+
+# Priorities of the scheduled tasks, the most urgent first
+PRIORITY_DISPLAYED = 0
+PRIORITY_OBSERVED = 1
+PRIORITY_REQUESTED = 2
+PRIORITY_DISCOVERY = 3
+PRIORITY_PREFETCH = 4
+
+
+class StopScheduler(object):
+    """
+    Runs tasks in the debugger thread by order of priority, and by order of
+    arrival within the same priority. Tasks are either callables, run once, or
+    iterators, run one step at a time so that more urgent tasks scheduled
+    meanwhile are run in between.
+
+    A single task step is queued to the debugger bridge at a time, so the
+    order of the tasks is only decided when the bridge runs it.
+    """
+    def __init__(self, bridge):
+        self._bridge = bridge
+        self._tasks = []
+        self._counter = itertools.count()
+        self._is_step_queued = False
+        # Tasks are scheduled from the debugger thread and from a thread owned
+        # by the native library
+        self._lock = threading.Lock()
+
+    def schedule(self, priority, task):
+        """
+        Run 'task' after the scheduled tasks of the same or a more urgent
+        priority. Can be called from any thread.
+        """
+        with self._lock:
+            heapq.heappush(self._tasks, (priority, next(self._counter), task))
+            is_step_queued = self._is_step_queued
+            self._is_step_queued = True
+
+        if not is_step_queued:
+            self._bridge.queue_request(self._run_step)
+
+    def cancel(self, priority):
+        """
+        Drop the tasks of the given priority which haven't finished yet
+        """
+        with self._lock:
+            self._tasks = [entry for entry in self._tasks
+                           if entry[0] != priority]
+            heapq.heapify(self._tasks)
+
+    def _run_step(self):
+        with self._lock:
+            if len(self._tasks) == 0:
+                self._is_step_queued = False
+                return
+            entry = heapq.heappop(self._tasks)
+
+        task = entry[2]
+        try:
+            if callable(task):
+                task()
+            else:
+                next(task)
+
+                # The iterator keeps its place among the tasks of its priority
+                with self._lock:
+                    heapq.heappush(self._tasks, entry)
+        except StopIteration:
+            pass
+        except Exception as err:
+            print('[OpenImageDebugger] Error: Could not run scheduled task')
+            print(err)
+
+        with self._lock:
+            is_step_queued = len(self._tasks) > 0
+            self._is_step_queued = is_step_queued
+
+        if is_step_queued:
+            self._bridge.queue_request(self._run_step)
@@ -6,8 +6,12 @@ Definition of global constants and symbols.
 
 # Enum values for supported buffer types
 OID_TYPES_UINT8 = 0
+OID_TYPES_INT8 = 1
 OID_TYPES_UINT16 = 2
 OID_TYPES_INT16 = 3
 OID_TYPES_INT32 = 4
 OID_TYPES_FLOAT32 = 5
 OID_TYPES_FLOAT64 = 6
+OID_TYPES_FLOAT16 = 7
+OID_TYPES_UINT32 = 8
+OID_TYPES_BOOL = 9
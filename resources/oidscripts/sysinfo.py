@@ -99,18 +99,26 @@ def get_available_memory():
         raise Exception('Platform %s not supported' % platform)
 
 
-def get_buffer_size(height, channels, typevalue, rowstride):
+def get_type_size(typevalue):
     """
-    Compute the buffer size in bytes
+    Compute the size in bytes of a single value of the given type
     """
-    channel_size = 1
     if (typevalue == symbols.OID_TYPES_UINT16 or
-            typevalue == symbols.OID_TYPES_INT16):
-        channel_size = 2  # 2 bytes per element
+            typevalue == symbols.OID_TYPES_INT16 or
+            typevalue == symbols.OID_TYPES_FLOAT16):
+        return 2  # 2 bytes per element
     elif (typevalue == symbols.OID_TYPES_INT32 or
+          typevalue == symbols.OID_TYPES_UINT32 or
           typevalue == symbols.OID_TYPES_FLOAT32):
-        channel_size = 4  # 4 bytes per element
+        return 4  # 4 bytes per element
     elif typevalue == symbols.OID_TYPES_FLOAT64:
-        channel_size = 8  # 8 bytes per element
+        return 8  # 8 bytes per element
+
+    return 1
+
 
-    return channel_size * channels * rowstride * height
+def get_buffer_size(height, channels, typevalue, rowstride):
+    """
+    Compute the buffer size in bytes
+    """
+    return get_type_size(typevalue) * channels * rowstride * height
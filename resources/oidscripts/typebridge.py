@@ -10,8 +10,10 @@ import importlib
 import pkgutil
 
 from oidscripts import oidtypes
+from oidscripts import sysinfo
 
-from oidscripts.oidtypes.interface import TypeInspectorInterface
+from oidscripts.oidtypes.interface import ResolvedBufferLayout, \
+    TypeInspectorInterface
 
 
 class TypeBridge(object):
@@ -21,6 +23,13 @@ class TypeBridge(object):
     """
     def __init__(self):
         self._type_inspectors = []
+        # Observability of each type name seen so far
+        self._observable_types = {}
+        # Resolved buffer_layout of each (inspector, type name), or None if
+        # the debugger couldn't resolve it
+        self._buffer_layouts = {}
+        # Slice selected in the window for each tensor symbol
+        self._tensor_slices = {}
 
         # Import all modules within oidtypes
         for (_, mod_name, _) in pkgutil.iter_modules(oidtypes.__path__):
@@ -37,19 +46,103 @@ class TypeBridge(object):
         """
         for module in self._type_inspectors:
             if module.is_symbol_observable(picked_obj, symbol_name):
-                return module.get_buffer_metadata(symbol_name,
-                                                  picked_obj,
-                                                  debugger_bridge)
+                layout = self._get_buffer_layout(module,
+                                                 picked_obj,
+                                                 debugger_bridge)
+                header = None
+                if layout is not None:
+                    header = debugger_bridge.read_object_header(
+                        picked_obj, layout.header_size)
+
+                if header is not None:
+                    buffer_metadata = module.get_buffer_metadata_from_header(
+                        symbol_name, picked_obj, layout.decode(header))
+                else:
+                    buffer_metadata = module.get_buffer_metadata(
+                        symbol_name, picked_obj, debugger_bridge)
+
+                return self._select_tensor_slice(symbol_name, buffer_metadata)
 
         return None
 
+    def select_tensor_slice(self, symbol_name, tensor_index):
+        """
+        Selects the slice of a tensor read by the next calls to
+        get_buffer_metadata for that symbol. None selects the first slice.
+        """
+        if tensor_index is None:
+            self._tensor_slices.pop(symbol_name, None)
+        else:
+            self._tensor_slices[symbol_name] = list(tensor_index)
+
+    def _select_tensor_slice(self, symbol_name, buffer_metadata):
+        """
+        Narrows the metadata of a tensor down to its selected slice. The
+        debugger bridge then only reads the slice, which starts slice_offset
+        bytes after the pointer.
+        """
+        if buffer_metadata is None or \
+                not buffer_metadata.get('tensor_shape'):
+            return buffer_metadata
+
+        shape = list(buffer_metadata['tensor_shape'])
+        strides = list(buffer_metadata['tensor_strides'])
+
+        # Selections from a tensor of another rank start over
+        index = self._tensor_slices.get(symbol_name, [])
+        if len(index) != len(shape):
+            index = [0] * len(shape)
+        index = [min(max(position, 0), size - 1)
+                 for position, size in zip(index, shape)]
+
+        type_size = sysinfo.get_type_size(buffer_metadata['type'])
+        buffer_metadata['tensor_shape'] = shape
+        buffer_metadata['tensor_index'] = index
+        buffer_metadata['slice_offset'] = type_size * sum(
+            position * stride for position, stride in zip(index, strides))
+
+        return buffer_metadata
+
+    def _get_buffer_layout(self, module, picked_obj, debugger_bridge):
+        """
+        Returns the buffer_layout of module resolved for the type of
+        picked_obj, or None if it has no layout
+        """
+        if module.buffer_layout is None:
+            return None
+
+        layout_key = (type(module), str(picked_obj.type))
+        if layout_key not in self._buffer_layouts:
+            layout = module.buffer_layout
+            members = debugger_bridge.get_member_layout(picked_obj,
+                                                        layout.member_paths)
+            resolved_layout = None
+            if members is not None:
+                resolved_layout = ResolvedBufferLayout(layout.field_names,
+                                                       members)
+            self._buffer_layouts[layout_key] = resolved_layout
+
+        return self._buffer_layouts[layout_key]
+
     def is_symbol_observable(self, symbol_obj, symbol_name):
         """
         Returns true if any available module is able to process this particular
         symbol
         """
-        for module in self._type_inspectors:
-            if module.is_symbol_observable(symbol_obj, symbol_name):
-                return True
+        type_name = str(symbol_obj.type)
+        is_observable = self._observable_types.get(type_name)
+        if is_observable is None:
+            is_observable = any(
+                module.is_symbol_observable(symbol_obj, symbol_name)
+                for module in self._type_inspectors)
+            self._observable_types[type_name] = is_observable
+
+        return is_observable
 
-        return False
+    def clear_cache(self):
+        """
+        Forgets the memoized type observability, e.g. after new object files
+        are loaded by the debugger
+        """
+        self._observable_types.clear()
+        self._buffer_layouts.clear()
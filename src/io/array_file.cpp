@@ -0,0 +1,363 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <utility>
+
+#include "array_file.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+const char npy_magic[]        = "\x93NUMPY";
+const size_t npy_magic_length = 6;
+const size_t npy_alignment    = 64;
+
+
+const char* get_npy_descriptor(BufferType type)
+{
+    switch (type) {
+    case BufferType::UnsignedByte:
+        return "|u1";
+    case BufferType::Int8:
+        return "|i1";
+    case BufferType::UnsignedShort:
+        return "<u2";
+    case BufferType::Short:
+        return "<i2";
+    case BufferType::Int32:
+        return "<i4";
+    case BufferType::UInt32:
+        return "<u4";
+    case BufferType::Float16:
+        return "<f2";
+    case BufferType::Float32:
+        return "<f4";
+    case BufferType::Float64:
+        return "<f8";
+    case BufferType::Bool:
+        return "|b1";
+    }
+
+    return "|u1";
+}
+
+
+bool parse_npy_descriptor(const string& descriptor, BufferType& type)
+{
+    const BufferType types[] = {BufferType::UnsignedByte,
+                                BufferType::Int8,
+                                BufferType::UnsignedShort,
+                                BufferType::Short,
+                                BufferType::Int32,
+                                BufferType::UInt32,
+                                BufferType::Float16,
+                                BufferType::Float32,
+                                BufferType::Float64,
+                                BufferType::Bool};
+
+    for (const BufferType candidate : types) {
+        // Single byte types may be stored with any byte order mark
+        const string expected = get_npy_descriptor(candidate);
+        if (descriptor == expected ||
+            (typesize(candidate) == 1 && descriptor == expected.substr(1))) {
+            type = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+// Returns the text following the given key of the header dictionary
+bool find_npy_value(const string& dictionary,
+                    const char* key,
+                    string& value)
+{
+    const string quoted_key = string("'") + key + "'";
+
+    size_t position = dictionary.find(quoted_key);
+    if (position == string::npos) {
+        return false;
+    }
+
+    position = dictionary.find(':', position + quoted_key.size());
+    if (position == string::npos) {
+        return false;
+    }
+
+    value = dictionary.substr(position + 1);
+    value.erase(0, value.find_first_not_of(' '));
+
+    return true;
+}
+
+
+/**
+ * True if the values of the array fit in the file after its header. The
+ * dimensions are read from the file, so their product is checked for
+ * overflow.
+ */
+bool is_data_contained(const ArrayFileHeader& header, size_t length)
+{
+    if (header.data_offset > length) {
+        return false;
+    }
+
+    const size_t available_length = length - header.data_offset;
+    const size_t dimensions[]     = {static_cast<size_t>(header.width),
+                                     static_cast<size_t>(header.height),
+                                     static_cast<size_t>(header.channels)};
+
+    size_t data_length = typesize(header.type);
+    for (const size_t dimension : dimensions) {
+        if (data_length > available_length / dimension) {
+            return false;
+        }
+        data_length *= dimension;
+    }
+
+    return true;
+}
+
+} // namespace
+
+
+string make_npy_header(BufferType type,
+                       int width,
+                       int height,
+                       int channels,
+                       bool is_planar)
+{
+    stringstream dictionary;
+    dictionary << "{'descr': '" << get_npy_descriptor(type)
+               << "', 'fortran_order': False, 'shape': (";
+    if (channels > 1 && is_planar) {
+        dictionary << channels << ", " << height << ", " << width;
+    } else {
+        dictionary << height << ", " << width;
+        if (channels > 1) {
+            dictionary << ", " << channels;
+        }
+    }
+    dictionary << "), }";
+
+    // Magic string, version and header length, then the dictionary padded
+    // with spaces and terminated by a newline
+    const size_t prefix_length = npy_magic_length + 4;
+    string header_dictionary   = dictionary.str();
+    const size_t unpadded_length =
+        prefix_length + header_dictionary.size() + 1;
+    header_dictionary.append(
+        (npy_alignment - unpadded_length % npy_alignment) % npy_alignment,
+        ' ');
+    header_dictionary += '\n';
+
+    const size_t dictionary_length = header_dictionary.size();
+
+    string header(npy_magic, npy_magic_length);
+    header += '\x01';
+    header += '\x00';
+    header += static_cast<char>(dictionary_length & 0xff);
+    header += static_cast<char>((dictionary_length >> 8) & 0xff);
+    header += header_dictionary;
+
+    return header;
+}
+
+
+bool parse_npy_header(const uint8_t* data,
+                      size_t length,
+                      ArrayFileHeader& header)
+{
+    if (length < npy_magic_length + 4 ||
+        memcmp(data, npy_magic, npy_magic_length) != 0) {
+        return false;
+    }
+
+    // Version 1.0 has a 2 byte header length, later versions a 4 byte one
+    const uint8_t major_version = data[npy_magic_length];
+    size_t dictionary_offset;
+    size_t dictionary_length;
+    if (major_version == 1) {
+        dictionary_offset = npy_magic_length + 4;
+        dictionary_length = static_cast<size_t>(data[8]) |
+                            static_cast<size_t>(data[9]) << 8;
+    } else if ((major_version == 2 || major_version == 3) &&
+               length >= npy_magic_length + 6) {
+        dictionary_offset = npy_magic_length + 6;
+        dictionary_length = static_cast<size_t>(data[8]) |
+                            static_cast<size_t>(data[9]) << 8 |
+                            static_cast<size_t>(data[10]) << 16 |
+                            static_cast<size_t>(data[11]) << 24;
+    } else {
+        return false;
+    }
+
+    if (dictionary_offset + dictionary_length > length) {
+        return false;
+    }
+
+    const string dictionary(
+        reinterpret_cast<const char*>(data + dictionary_offset),
+        dictionary_length);
+
+    string descriptor;
+    string fortran_order;
+    string shape;
+    if (!find_npy_value(dictionary, "descr", descriptor) ||
+        !find_npy_value(dictionary, "fortran_order", fortran_order) ||
+        !find_npy_value(dictionary, "shape", shape)) {
+        return false;
+    }
+
+    // Only C ordered arrays have rows laid out like the viewer buffers
+    if (fortran_order.compare(0, 5, "False") != 0 || descriptor.empty() ||
+        descriptor[0] != '\'' ||
+        !parse_npy_descriptor(
+            descriptor.substr(1, descriptor.find('\'', 1) - 1),
+            header.type)) {
+        return false;
+    }
+
+    if (shape.empty() || shape[0] != '(') {
+        return false;
+    }
+
+    long long dimensions[3];
+    int dimension_count = 0;
+    stringstream shape_stream(shape.substr(1, shape.find(')') - 1));
+    string dimension;
+    while (getline(shape_stream, dimension, ',')) {
+        if (dimension.find_first_not_of(' ') == string::npos) {
+            continue;
+        }
+        if (dimension_count == 3) {
+            return false;
+        }
+
+        char* dimension_end;
+        dimensions[dimension_count] =
+            strtoll(dimension.c_str(), &dimension_end, 10);
+        if (dimensions[dimension_count] <= 0 ||
+            dimensions[dimension_count] > (1 << 30)) {
+            return false;
+        }
+        ++dimension_count;
+    }
+
+    // Planar arrays are told apart by their last dimension, which is too
+    // large to be a channel count
+    header.is_planar = dimension_count == 3 && dimensions[2] > 4 &&
+                       dimensions[0] <= 4;
+
+    if (dimension_count < 2 ||
+        (dimension_count == 3 && dimensions[2] > 4 && !header.is_planar)) {
+        return false;
+    }
+
+    if (header.is_planar) {
+        header.channels = static_cast<int>(dimensions[0]);
+        header.height   = static_cast<int>(dimensions[1]);
+        header.width    = static_cast<int>(dimensions[2]);
+    } else {
+        header.height = static_cast<int>(dimensions[0]);
+        header.width  = static_cast<int>(dimensions[1]);
+        header.channels =
+            dimension_count == 3 ? static_cast<int>(dimensions[2]) : 1;
+    }
+    header.data_offset = dictionary_offset + dictionary_length;
+
+    return is_data_contained(header, length);
+}
+
+
+bool parse_octave_matrix_header(const uint8_t* data,
+                                size_t length,
+                                ArrayFileHeader& header)
+{
+    // Type name line, followed by the height, width and channels
+    const uint8_t* type_end = static_cast<const uint8_t*>(
+        memchr(data, '\n', min<size_t>(length, 16)));
+    if (type_end == nullptr) {
+        return false;
+    }
+
+    string type_name(reinterpret_cast<const char*>(data),
+                     static_cast<size_t>(type_end - data));
+
+    const string planar_suffix = " planar";
+    const size_t suffix_position =
+        type_name.size() - min(type_name.size(), planar_suffix.size());
+    header.is_planar =
+        type_name.compare(suffix_position, string::npos, planar_suffix) == 0;
+    if (header.is_planar) {
+        type_name.resize(suffix_position);
+    }
+    const pair<const char*, BufferType> types[] = {
+        {"uint8", BufferType::UnsignedByte},
+        {"int8", BufferType::Int8},
+        {"uint16", BufferType::UnsignedShort},
+        {"int16", BufferType::Short},
+        {"int32", BufferType::Int32},
+        {"uint32", BufferType::UInt32},
+        {"half", BufferType::Float16},
+        {"float", BufferType::Float32}};
+
+    bool is_type_known = false;
+    for (const auto& type : types) {
+        if (type_name == type.first) {
+            header.type   = type.second;
+            is_type_known = true;
+        }
+    }
+
+    const size_t dimensions_offset = static_cast<size_t>(type_end - data) + 1;
+    if (!is_type_known || dimensions_offset + 3 * sizeof(int32_t) > length) {
+        return false;
+    }
+
+    int32_t dimensions[3];
+    memcpy(dimensions, data + dimensions_offset, sizeof(dimensions));
+    if (dimensions[0] <= 0 || dimensions[1] <= 0 || dimensions[2] <= 0 ||
+        dimensions[2] > 4) {
+        return false;
+    }
+
+    header.height      = dimensions[0];
+    header.width       = dimensions[1];
+    header.channels    = dimensions[2];
+    header.data_offset = dimensions_offset + sizeof(dimensions);
+
+    return is_data_contained(header, length);
+}
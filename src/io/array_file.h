@@ -0,0 +1,83 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef ARRAY_FILE_H_
+#define ARRAY_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "ipc/raw_data_decode.h"
+
+
+/**
+ * Geometry of an image stored in an exported array file, with its rows
+ * tightly packed
+ */
+struct ArrayFileHeader
+{
+    BufferType type;
+    int width;
+    int height;
+    int channels;
+    // Whether the channels are stored as consecutive planes
+    bool is_planar;
+    // Offset of the array data from the start of the file
+    std::size_t data_offset;
+};
+
+/**
+ * Builds a version 1.0 .npy header. It is padded so that the array data
+ * starts at a 64 byte boundary, which lets the file be memory mapped.
+ * Planar arrays have the shape (channels, height, width).
+ */
+std::string make_npy_header(BufferType type,
+                            int width,
+                            int height,
+                            int channels,
+                            bool is_planar);
+
+/**
+ * Parses the header at the start of a .npy file. Returns false if the file
+ * isn't a C ordered array of shape (height, width), (height, width,
+ * channels) or (channels, height, width) and of a supported type, or if it
+ * is truncated. The last shape is only recognized as planar if its width
+ * couldn't be a channel count.
+ */
+bool parse_npy_header(const std::uint8_t* data,
+                      std::size_t length,
+                      ArrayFileHeader& header);
+
+/**
+ * Parses the header of a raw matrix written by the Octave matrix export.
+ * Returns false if the type is unknown, or if the file is truncated. The
+ * type name of planar matrices is followed by " planar".
+ */
+bool parse_octave_matrix_header(const std::uint8_t* data,
+                                std::size_t length,
+                                ArrayFileHeader& header);
+
+#endif // ARRAY_FILE_H_
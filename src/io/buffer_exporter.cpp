@@ -23,18 +23,40 @@
  * IN THE SOFTWARE.
  */
 
+#include <limits>
 #include <memory>
-
-#include <QPixmap>
+#include <vector>
 
 #include "buffer_exporter.h"
-
-#include "math/assorted.h"
+#include "array_file.h"
+#include "export_encoding.h"
+#include "math/buffer_type_dispatch.h"
+#include "math/half_float.h"
 
 
 using namespace std;
 
 
+namespace
+{
+
+/**
+ * Copies the bytes spanned by the given rows, so that the export task keeps
+ * its own contents while the buffer is released or rewritten in place
+ */
+shared_ptr<const vector<uint8_t>> copy_rows(const uint8_t* contents,
+                                            size_t rows,
+                                            size_t row_length,
+                                            size_t input_stride)
+{
+    const size_t length = (rows - 1) * input_stride + row_length;
+
+    return make_shared<const vector<uint8_t>>(contents, contents + length);
+}
+
+} // namespace
+
+
 template <typename T>
 float get_multiplier()
 {
@@ -49,6 +71,13 @@ float get_multiplier<float>()
 }
 
 
+template <>
+float get_multiplier<HalfFloat>()
+{
+    return 255.f;
+}
+
+
 template <typename T>
 T get_max_intensity()
 {
@@ -63,89 +92,85 @@ float get_max_intensity<float>()
 }
 
 
-template <typename T>
-void export_bitmap(const char* fname, const Buffer* buffer)
+template <>
+HalfFloat get_max_intensity<HalfFloat>()
 {
-    const auto width_i  = static_cast<size_t>(buffer->buffer_width_f);
-    const auto height_i = static_cast<size_t>(buffer->buffer_height_f);
+    return HalfFloat(1.f);
+}
 
-    vector<uint8_t> processed_buffer(4 * width_i * height_i);
-    uint8_t default_channel_vals[] = {0, 0, 0, 255};
 
-    uint8_t* out_ptr = processed_buffer.data();
+template <typename T>
+BufferExporter::ExportTask export_bitmap(const char* fname,
+                                         const Buffer* buffer)
+{
+    NormalizationParameters params;
+    params.contents = buffer->buffer;
+    params.width    = static_cast<size_t>(buffer->buffer_width_f);
+    params.height   = static_cast<size_t>(buffer->buffer_height_f);
+    params.channels = buffer->channels;
+
+    // The planes of planar buffers are read in place
+    if (buffer->is_planar) {
+        params.input_stride = static_cast<size_t>(buffer->step);
+        params.plane_stride = params.input_stride * params.height;
+    } else {
+        params.input_stride =
+            static_cast<size_t>(buffer->channels) * buffer->step;
+        params.plane_stride = 0;
+    }
 
-    const float* bc_comp = buffer->auto_buffer_contrast_brightness();
-    float color_scale    = get_multiplier<T>();
+    if (params.contents == nullptr || params.width == 0 ||
+        params.height == 0) {
+        return nullptr;
+    }
 
+    // The planes of planar buffers are copied as the rows of a single plane
+    const size_t rows = buffer->is_planar
+                            ? params.height * params.channels
+                            : params.height;
+    const size_t row_length =
+        buffer->is_planar ? params.width : params.width * params.channels;
+
+    const auto contents = copy_rows(params.contents,
+                                    rows,
+                                    row_length * sizeof(T),
+                                    params.input_stride * sizeof(T));
+    params.contents     = contents->data();
+
+    const float* bc_comp      = buffer->auto_buffer_contrast_brightness();
+    const float color_scale   = get_multiplier<T>();
     const float max_intensity = get_max_intensity<T>();
 
-    uint8_t pixel_layout[4];
+    for (int c = 0; c < 4; ++c) {
+        params.scale[c]  = bc_comp[c] * color_scale;
+        params.offset[c] = bc_comp[4 + c] * max_intensity * color_scale;
+    }
+
     for (int c = 0; c < 4; ++c) {
         switch (buffer->get_pixel_layout()[c]) {
         case 'r':
-            pixel_layout[c] = 0;
+            params.pixel_layout[c] = 0;
             break;
         case 'g':
-            pixel_layout[c] = 1;
+            params.pixel_layout[c] = 1;
             break;
         case 'b':
-            pixel_layout[c] = 2;
+            params.pixel_layout[c] = 2;
             break;
         case 'a':
-            pixel_layout[c] = 3;
+            params.pixel_layout[c] = 3;
             break;
         }
     }
 
-    const T* in_ptr  = reinterpret_cast<const T*>(buffer->buffer);
-    int input_stride = buffer->channels * buffer->step;
-    uint8_t unformatted_pixel[4];
-
-    for (size_t y = 0; y < height_i; ++y) {
-        for (size_t x = 0; x < width_i; ++x) {
-            int col_offset = x * buffer->channels;
-            int c;
-
-            // Perform contrast normalization
-            for (c = 0; c < buffer->channels; ++c) {
-                float in_val = static_cast<float>(in_ptr[col_offset + c]);
-
-                unformatted_pixel[c] = static_cast<uint8_t>(clamp(
-                    (in_val * bc_comp[c] + bc_comp[4 + c] * max_intensity) *
-                        color_scale,
-                    0.f,
-                    255.f));
-            }
-
-            // Grayscale: Repeat first channel into G and B
-            if (buffer->channels == 1) {
-                for (; c < 3; ++c) {
-                    unformatted_pixel[c] = unformatted_pixel[0];
-                }
-            }
-
-            // The remaining, non-filled channels will be set to a default value
-            for (; c < 4; ++c) {
-                unformatted_pixel[c] = default_channel_vals[c];
-            }
-
-            // Reorganize pixel layout according to user provided format
-            for (int c = 0; c < 4; ++c) {
-                out_ptr[pixel_layout[c]] = unformatted_pixel[c];
-            }
-            out_ptr += 4;
-        }
+    params.is_layout_remapped =
+        params.pixel_layout[0] != 0 || params.pixel_layout[1] != 1 ||
+        params.pixel_layout[2] != 2 || params.pixel_layout[3] != 3;
 
-        in_ptr += input_stride;
-    }
-
-    const int bytes_per_line = width_i * 4;
-    QImage output_image(processed_buffer.data(),
-                        width_i,
-                        height_i,
-                        bytes_per_line,
-                        QImage::Format_RGBA8888);
-    output_image.save(fname, "png");
+    const string file_name = fname;
+    return [params, contents, file_name]() {
+        return write_bitmap<T>(params, file_name);
+    };
 }
 
 
@@ -160,6 +185,13 @@ const char* get_type_descriptor<uint8_t>()
 }
 
 
+template <>
+const char* get_type_descriptor<int8_t>()
+{
+    return "int8";
+}
+
+
 template <>
 const char* get_type_descriptor<uint16_t>()
 {
@@ -181,6 +213,21 @@ const char* get_type_descriptor<int32_t>()
 }
 
 
+template <>
+const char* get_type_descriptor<uint32_t>()
+{
+    return "uint32";
+}
+
+
+// Loaded as uint16 bits and decoded by oid_load.m
+template <>
+const char* get_type_descriptor<HalfFloat>()
+{
+    return "half";
+}
+
+
 template <>
 const char* get_type_descriptor<float>()
 {
@@ -188,74 +235,124 @@ const char* get_type_descriptor<float>()
 }
 
 
+/**
+ * Writes the given header followed by the buffer rows, tightly packed. The
+ * planes of planar buffers follow each other with the same row pitch, so
+ * they are written as the rows of a single plane.
+ */
 template <typename T>
-void export_binary(const char* fname, const Buffer* buffer)
+BufferExporter::ExportTask export_binary(const char* fname,
+                                         const Buffer* buffer,
+                                         const string& header)
 {
-    int width_i  = static_cast<int>(buffer->buffer_width_f);
-    int height_i = static_cast<int>(buffer->buffer_height_f);
-
-    const T* in_ptr = reinterpret_cast<const T*>(buffer->buffer);
-
-    FILE* fhandle = fopen(fname, "wb");
-
-    if (fhandle != NULL) {
-        fprintf(fhandle, "%s\n", get_type_descriptor<T>());
-        fwrite(&height_i, sizeof(int), 1, fhandle);
-        fwrite(&width_i, sizeof(int), 1, fhandle);
-        fwrite(&buffer->channels, sizeof(int), 1, fhandle);
-        for (int y = 0; y < height_i; ++y) {
-            fwrite(in_ptr + y * buffer->step * buffer->channels,
-                   sizeof(T),
-                   static_cast<size_t>(width_i) * static_cast<size_t>(buffer->channels),
-                   fhandle);
-        }
-        fclose(fhandle);
+    const T* in_ptr    = reinterpret_cast<const T*>(buffer->buffer);
+    const int width_i  = static_cast<int>(buffer->buffer_width_f);
+    const int height_i = static_cast<int>(buffer->buffer_height_f);
+    const int channels = buffer->channels;
+
+    if (in_ptr == nullptr || width_i <= 0 || height_i <= 0) {
+        return nullptr;
     }
+
+    const size_t pixel_values =
+        buffer->is_planar ? 1 : static_cast<size_t>(channels);
+    const size_t rows = buffer->is_planar
+                            ? static_cast<size_t>(height_i) * channels
+                            : static_cast<size_t>(height_i);
+
+    const size_t row_length   = static_cast<size_t>(width_i) * pixel_values;
+    const size_t input_stride =
+        static_cast<size_t>(buffer->step) * pixel_values;
+
+    BinaryLayout layout;
+    layout.height       = rows;
+    layout.row_length   = row_length * sizeof(T);
+    layout.input_stride = input_stride * sizeof(T);
+
+    const auto contents = copy_rows(
+        buffer->buffer, rows, layout.row_length, layout.input_stride);
+    layout.contents = contents->data();
+
+    const string file_name = fname;
+    return [layout, contents, header, file_name]() {
+        return write_binary(layout, header, file_name);
+    };
 }
 
 
-void BufferExporter::export_buffer(const Buffer* buffer,
-                                   const std::string& path,
-                                   BufferExporter::OutputType type)
+template <typename T>
+BufferExporter::ExportTask export_octave_matrix(const char* fname,
+                                                const Buffer* buffer)
 {
-    if (type == OutputType::Bitmap) {
-        switch (buffer->type) {
-        case BufferType::UnsignedByte:
-            export_bitmap<uint8_t>(path.c_str(), buffer);
-            break;
-        case BufferType::UnsignedShort:
-            export_bitmap<uint16_t>(path.c_str(), buffer);
-            break;
-        case BufferType::Short:
-            export_bitmap<int16_t>(path.c_str(), buffer);
-            break;
-        case BufferType::Int32:
-            export_bitmap<int32_t>(path.c_str(), buffer);
-            break;
-        case BufferType::Float32:
-        case BufferType::Float64:
-            export_bitmap<float>(path.c_str(), buffer);
-            break;
-        }
-    } else {
+    const int width_i  = static_cast<int>(buffer->buffer_width_f);
+    const int height_i = static_cast<int>(buffer->buffer_height_f);
+
+    string header = string(get_type_descriptor<T>()) +
+                    (buffer->is_planar ? " planar\n" : "\n");
+    header.append(reinterpret_cast<const char*>(&height_i), sizeof(int));
+    header.append(reinterpret_cast<const char*>(&width_i), sizeof(int));
+    header.append(reinterpret_cast<const char*>(&buffer->channels),
+                  sizeof(int));
+
+    return export_binary<T>(fname, buffer, header);
+}
+
+
+template <typename T>
+BufferExporter::ExportTask export_npy(const char* fname, const Buffer* buffer)
+{
+    // Float64 buffers are displayed, and exported, as Float32
+    const BufferType type = held_buffer_type(buffer->type);
+
+    return export_binary<T>(
+        fname,
+        buffer,
+        make_npy_header(type,
+                        static_cast<int>(buffer->buffer_width_f),
+                        static_cast<int>(buffer->buffer_height_f),
+                        buffer->channels,
+                        buffer->is_planar));
+}
+
+
+template <typename T>
+BufferExporter::ExportTask export_as(const char* fname,
+                                     const Buffer* buffer,
+                                     BufferExporter::OutputType type)
+{
+    switch (type) {
+    case BufferExporter::OutputType::Bitmap:
+        return export_bitmap<T>(fname, buffer);
+    case BufferExporter::OutputType::OctaveMatrix:
         // Matlab/Octave matrix (load with the oid_load.m function)
-        switch (buffer->type) {
-        case BufferType::UnsignedByte:
-            export_binary<uint8_t>(path.c_str(), buffer);
-            break;
-        case BufferType::UnsignedShort:
-            export_binary<uint16_t>(path.c_str(), buffer);
-            break;
-        case BufferType::Short:
-            export_binary<int16_t>(path.c_str(), buffer);
-            break;
-        case BufferType::Int32:
-            export_binary<int32_t>(path.c_str(), buffer);
-            break;
-        case BufferType::Float32:
-        case BufferType::Float64:
-            export_binary<float>(path.c_str(), buffer);
-            break;
-        }
+        return export_octave_matrix<T>(fname, buffer);
+    case BufferExporter::OutputType::NumpyArray:
+        // Can be loaded with numpy.load(fname, mmap_mode='r')
+        return export_npy<T>(fname, buffer);
     }
+
+    return nullptr;
+}
+
+
+BufferExporter::ExportTask
+BufferExporter::prepare_export(const Buffer* buffer,
+                               const std::string& path,
+                               BufferExporter::OutputType type)
+{
+    // Double buffers are converted to float by the UI
+    return visit_held_value_type(buffer->type, [&](auto value_type) {
+        using T = typename decltype(value_type)::type;
+        return export_as<T>(path.c_str(), buffer, type);
+    });
+}
+
+
+bool BufferExporter::export_buffer(const Buffer* buffer,
+                                   const std::string& path,
+                                   BufferExporter::OutputType type)
+{
+    const ExportTask task = prepare_export(buffer, path, type);
+
+    return task != nullptr && task();
 }
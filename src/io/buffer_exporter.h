@@ -26,15 +26,35 @@
 #ifndef BUFFER_EXPORTER_H_
 #define BUFFER_EXPORTER_H_
 
+#include <functional>
+#include <string>
+
 #include "visualization/components/buffer.h"
 
 
 class BufferExporter
 {
   public:
-    enum class OutputType { Bitmap, OctaveMatrix };
+    enum class OutputType { Bitmap, OctaveMatrix, NumpyArray };
+
+    /**
+     * Streams the buffer contents to the file, a strip at a time, and
+     * returns whether it succeeded. It may run on any thread, as it owns a
+     * copy of the buffer contents.
+     */
+    using ExportTask = std::function<bool()>;
+
+    /**
+     * Captures the buffer geometry, contrast settings and contents, which
+     * the caller must keep from being modified meanwhile, and returns the
+     * task that encodes and writes the buffer to path, or an empty task if
+     * the buffer can't be exported.
+     */
+    static ExportTask prepare_export(const Buffer* buffer,
+                                     const std::string& path,
+                                     OutputType type);
 
-    static void export_buffer(const Buffer* buffer,
+    static bool export_buffer(const Buffer* buffer,
                               const std::string& path,
                               OutputType type);
 };
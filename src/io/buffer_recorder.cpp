@@ -0,0 +1,251 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "buffer_recorder.h"
+
+
+using namespace std;
+
+
+const char BufferRecorder::magic[8] =
+    {'O', 'I', 'D', 'R', 'E', 'C', '\0', '\1'};
+constexpr size_t BufferRecorder::header_size;
+constexpr size_t BufferRecorder::alignment;
+constexpr size_t BufferRecorder::max_queued_bytes;
+constexpr uint32_t BufferRecorder::format_version;
+
+
+BufferRecorder::BufferRecorder()
+    : file_(nullptr)
+    , file_offset_(0)
+    , is_ok_(false)
+    , queued_bytes_(0)
+    , queued_frames_(0)
+    , is_stopping_(false)
+{
+}
+
+
+BufferRecorder::~BufferRecorder()
+{
+    stop();
+}
+
+
+bool BufferRecorder::start(const string& path, const string& variable_name)
+{
+    if (file_ != nullptr) {
+        return false;
+    }
+
+    file_ = fopen(path.c_str(), "wb");
+    if (file_ == nullptr) {
+        return false;
+    }
+
+    is_ok_       = true;
+    file_offset_ = 0;
+    frame_offsets_.clear();
+
+    // The frame count and index offset are filled in by stop()
+    uint8_t header[header_size] = {};
+    const uint32_t name_length  = static_cast<uint32_t>(variable_name.size());
+    memcpy(header, magic, sizeof(magic));
+    memcpy(header + 8, &format_version, sizeof(uint32_t));
+    memcpy(header + 12, &name_length, sizeof(uint32_t));
+
+    write(header, sizeof(header));
+    write(variable_name.data(), variable_name.size());
+
+    is_stopping_ = false;
+    writer_      = thread(&BufferRecorder::writer_loop, this);
+
+    return is_ok_;
+}
+
+
+bool BufferRecorder::stop()
+{
+    if (file_ == nullptr) {
+        return false;
+    }
+
+    {
+        lock_guard<mutex> lock(mutex_);
+        is_stopping_ = true;
+    }
+    frame_queued_.notify_one();
+    writer_.join();
+
+    pad_to_alignment();
+    const uint64_t index_offset = file_offset_;
+    const uint64_t frame_count  = frame_offsets_.size();
+    write(frame_offsets_.data(), frame_offsets_.size() * sizeof(uint64_t));
+
+    if (fseek(file_, 16, SEEK_SET) == 0) {
+        write(&frame_count, sizeof(uint64_t));
+        write(&index_offset, sizeof(uint64_t));
+    } else {
+        is_ok_ = false;
+    }
+
+    const bool closed = fclose(file_) == 0;
+    file_             = nullptr;
+
+    return closed && is_ok_;
+}
+
+
+bool BufferRecorder::is_recording() const
+{
+    return file_ != nullptr;
+}
+
+
+size_t BufferRecorder::frame_count() const
+{
+    lock_guard<mutex> lock(mutex_);
+    return queued_frames_;
+}
+
+
+void BufferRecorder::record(const BufferMetadata& metadata,
+                            const uint8_t* contents,
+                            size_t length)
+{
+    if (file_ == nullptr) {
+        return;
+    }
+
+    QueuedFrame frame;
+    frame.record = FrameRecord();
+    frame.record.timestamp_ms = static_cast<uint64_t>(
+        chrono::duration_cast<chrono::milliseconds>(
+            chrono::system_clock::now().time_since_epoch())
+            .count());
+    frame.record.width      = metadata.width;
+    frame.record.height     = metadata.height;
+    frame.record.channels   = metadata.channels;
+    frame.record.row_stride = metadata.row_stride;
+    frame.record.type       = static_cast<uint8_t>(metadata.type);
+    frame.record.transpose  = metadata.transpose_buffer ? 1 : 0;
+    frame.record.planar     = metadata.is_planar ? 1 : 0;
+    frame.record.length     = length;
+    memcpy(frame.record.pixel_layout,
+           metadata.pixel_layout.data(),
+           min(metadata.pixel_layout.size(),
+               sizeof(frame.record.pixel_layout)));
+
+    frame.contents.assign(contents, contents + length);
+
+    unique_lock<mutex> lock(mutex_);
+    frame_written_.wait(lock, [this]() {
+        return queued_bytes_ < max_queued_bytes || queue_.empty();
+    });
+
+    queued_bytes_ += length;
+    ++queued_frames_;
+    queue_.push_back(std::move(frame));
+    lock.unlock();
+
+    frame_queued_.notify_one();
+}
+
+
+void BufferRecorder::writer_loop()
+{
+    unique_lock<mutex> lock(mutex_);
+
+    while (true) {
+        frame_queued_.wait(
+            lock, [this]() { return is_stopping_ || !queue_.empty(); });
+
+        if (queue_.empty()) {
+            // Only stops after every queued frame is written
+            return;
+        }
+
+        QueuedFrame frame = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+
+        write_frame(frame);
+
+        lock.lock();
+        queued_bytes_ -= frame.record.length;
+        frame_written_.notify_all();
+    }
+}
+
+
+void BufferRecorder::write_frame(QueuedFrame& frame)
+{
+    const CompressionSettings settings{CompressionCodec::Zlib, 1, 4096};
+    vector<uint8_t> compressed;
+
+    const uint8_t* payload = frame.contents.data();
+    CompressionCodec codec = CompressionCodec::None;
+    frame.record.stored_length = frame.contents.size();
+
+    // Incompressible frames are stored raw
+    if (compress_block(frame.contents.data(),
+                       frame.contents.size(),
+                       settings,
+                       compressed)) {
+        codec                      = CompressionCodec::Zlib;
+        frame.record.stored_length = compressed.size();
+        payload                    = compressed.data();
+    }
+    frame.record.codec = static_cast<uint8_t>(codec);
+
+    pad_to_alignment();
+    frame_offsets_.push_back(file_offset_);
+
+    write(&frame.record, sizeof(frame.record));
+    pad_to_alignment();
+    write(payload, frame.record.stored_length);
+}
+
+
+void BufferRecorder::write(const void* data, size_t length)
+{
+    if (length == 0) {
+        return;
+    }
+
+    is_ok_ = is_ok_ && fwrite(data, 1, length, file_) == length;
+    file_offset_ += length;
+}
+
+
+void BufferRecorder::pad_to_alignment()
+{
+    const uint8_t padding[alignment] = {};
+    write(padding, (alignment - file_offset_ % alignment) % alignment);
+}
@@ -0,0 +1,152 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef BUFFER_RECORDER_H_
+#define BUFFER_RECORDER_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ipc/compression.h"
+#include "ipc/raw_data_decode.h"
+
+
+/**
+ * Appends every update of a buffer to a recording file. Frames are
+ * compressed and written by a background thread.
+ *
+ * Recording file layout (all integers little endian):
+ *
+ *   Header, 64 bytes:
+ *     char[8]   magic "OIDREC\0\1"
+ *     uint32    version
+ *     uint32    length of the variable name following the header
+ *     uint64    frame count
+ *     uint64    offset of the frame index, 0 if the recording was not closed
+ *     (padding)
+ *   Variable name
+ *   Frames, each starting at a 64 byte boundary:
+ *     FrameRecord, then its payload at the next 64 byte boundary
+ *   Frame index: one uint64 frame offset per frame
+ *
+ * Frame i is found by reading the index entry at index_offset + 8 * i. The
+ * frames of a recording that wasn't closed can still be found by walking
+ * them from the start of the file.
+ */
+class BufferRecorder
+{
+  public:
+    struct FrameRecord
+    {
+        std::uint64_t timestamp_ms;
+        std::int32_t width;
+        std::int32_t height;
+        std::int32_t channels;
+        std::int32_t row_stride;
+        std::uint8_t type;
+        std::uint8_t transpose;
+        std::uint8_t codec;
+        // Zero in recordings written before planar buffers were supported
+        std::uint8_t planar;
+        char pixel_layout[4];
+        // Length of the buffer contents, and of the payload that stores them
+        std::uint64_t length;
+        std::uint64_t stored_length;
+    };
+
+    static const char magic[8];
+    static constexpr std::size_t header_size = 64;
+    // Alignment of the frame records and payloads
+    static constexpr std::size_t alignment = 64;
+
+    BufferRecorder();
+
+    ~BufferRecorder();
+
+    BufferRecorder(const BufferRecorder&) = delete;
+
+    BufferRecorder& operator=(const BufferRecorder&) = delete;
+
+    bool start(const std::string& path, const std::string& variable_name);
+
+    /**
+     * Writes the queued frames and the frame index, and closes the file
+     */
+    bool stop();
+
+    bool is_recording() const;
+
+    std::size_t frame_count() const;
+
+    /**
+     * Queues a copy of the buffer contents. Blocks if the writer has fallen
+     * too far behind, instead of growing the queue indefinitely.
+     */
+    void record(const BufferMetadata& metadata,
+                const std::uint8_t* contents,
+                std::size_t length);
+
+  private:
+    struct QueuedFrame
+    {
+        FrameRecord record;
+        std::vector<std::uint8_t> contents;
+    };
+
+    static constexpr std::size_t max_queued_bytes = 256 << 20;
+    static constexpr std::uint32_t format_version = 1;
+
+    FILE* file_;
+    std::uint64_t file_offset_;
+    std::vector<std::uint64_t> frame_offsets_;
+    bool is_ok_;
+
+    std::thread writer_;
+    std::deque<QueuedFrame> queue_;
+    std::size_t queued_bytes_;
+    std::size_t queued_frames_;
+    bool is_stopping_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable frame_queued_;
+    std::condition_variable frame_written_;
+
+    void writer_loop();
+
+    void write_frame(QueuedFrame& frame);
+
+    void write(const void* data, std::size_t length);
+
+    void pad_to_alignment();
+};
+
+#endif // BUFFER_RECORDER_H_
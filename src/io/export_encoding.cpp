@@ -0,0 +1,268 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "export_encoding.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "png_writer.h"
+
+#include "math/assorted.h"
+#include "math/half_float.h"
+#include "system/thread/thread_pool.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+// Size of the staging buffers used by the streaming exports
+constexpr size_t export_strip_size = 4 << 20;
+
+
+/**
+ * Normalizes a row of a buffer into RGBA8 pixels. The channel count and
+ * whether the pixel layout needs to be remapped are resolved at compile
+ * time, so the inner loop has no branches and can be vectorized.
+ */
+template <typename T, int Channels, bool IsLayoutRemapped>
+void normalize_row(const T* in_ptr,
+                   size_t width,
+                   size_t plane_stride,
+                   const float* scale,
+                   const float* offset,
+                   const uint8_t* pixel_layout,
+                   uint8_t* out_ptr)
+{
+    const size_t pixel_stride   = plane_stride == 0 ? Channels : 1;
+    const size_t channel_stride = plane_stride == 0 ? 1 : plane_stride;
+
+    for (size_t x = 0; x < width; ++x) {
+        // The remaining, non-filled channels are set to a default value
+        uint8_t pixel[4] = {0, 0, 0, 255};
+
+        // Perform contrast normalization
+        for (int c = 0; c < Channels; ++c) {
+            const T input = in_ptr[x * pixel_stride + c * channel_stride];
+            const float value =
+                static_cast<float>(input) * scale[c] + offset[c];
+            pixel[c] = static_cast<uint8_t>(clamp(value, 0.f, 255.f));
+        }
+
+        // Grayscale: Repeat first channel into G and B
+        if (Channels == 1) {
+            pixel[1] = pixel[2] = pixel[0];
+        }
+
+        // Reorganize pixel layout according to user provided format
+        for (int c = 0; c < 4; ++c) {
+            out_ptr[x * 4 + (IsLayoutRemapped ? pixel_layout[c] : c)] =
+                pixel[c];
+        }
+    }
+}
+
+
+template <typename T, int Channels, bool IsLayoutRemapped>
+void normalize_strip(const NormalizationParameters& params,
+                     size_t first_row,
+                     size_t row_count,
+                     uint8_t* out_ptr)
+{
+    const T* in_ptr = reinterpret_cast<const T*>(params.contents);
+
+    ThreadPool::instance().parallel_for(
+        row_count, [&](size_t row_begin, size_t row_end) {
+            for (size_t y = row_begin; y < row_end; ++y) {
+                normalize_row<T, Channels, IsLayoutRemapped>(
+                    in_ptr + (first_row + y) * params.input_stride,
+                    params.width,
+                    params.plane_stride,
+                    params.scale,
+                    params.offset,
+                    params.pixel_layout,
+                    out_ptr + y * params.width * 4);
+            }
+        });
+}
+
+
+template <typename T, int Channels>
+void normalize_strip(const NormalizationParameters& params,
+                     size_t first_row,
+                     size_t row_count,
+                     uint8_t* out_ptr)
+{
+    if (params.is_layout_remapped) {
+        normalize_strip<T, Channels, true>(
+            params, first_row, row_count, out_ptr);
+    } else {
+        normalize_strip<T, Channels, false>(
+            params, first_row, row_count, out_ptr);
+    }
+}
+
+
+template <typename T>
+void normalize_strip(const NormalizationParameters& params,
+                     size_t first_row,
+                     size_t row_count,
+                     uint8_t* out_ptr)
+{
+    switch (params.channels) {
+    case 1:
+        normalize_strip<T, 1>(params, first_row, row_count, out_ptr);
+        break;
+    case 2:
+        normalize_strip<T, 2>(params, first_row, row_count, out_ptr);
+        break;
+    case 3:
+        normalize_strip<T, 3>(params, first_row, row_count, out_ptr);
+        break;
+    default:
+        normalize_strip<T, 4>(params, first_row, row_count, out_ptr);
+        break;
+    }
+}
+
+} // namespace
+
+
+template <typename T>
+bool write_bitmap(const NormalizationParameters& params, const string& path)
+{
+    PngWriter writer;
+    if (!writer.open(path,
+                     static_cast<int>(params.width),
+                     static_cast<int>(params.height))) {
+        return false;
+    }
+
+    const size_t row_length = params.width * 4;
+    const size_t strip_rows =
+        max<size_t>(1, export_strip_size / row_length);
+
+    // The strip is normalized on the thread pool, and deflated here
+    vector<uint8_t> strip(strip_rows * row_length);
+
+    bool succeeded = true;
+    for (size_t y = 0; y < params.height && succeeded; y += strip_rows) {
+        const size_t row_count = min(strip_rows, params.height - y);
+
+        normalize_strip<T>(params, y, row_count, strip.data());
+        succeeded =
+            writer.write_rows(strip.data(), static_cast<int>(row_count));
+    }
+
+    return writer.close() && succeeded;
+}
+
+
+template bool write_bitmap<uint8_t>(const NormalizationParameters&,
+                                    const string&);
+template bool write_bitmap<int8_t>(const NormalizationParameters&,
+                                   const string&);
+template bool write_bitmap<uint16_t>(const NormalizationParameters&,
+                                     const string&);
+template bool write_bitmap<int16_t>(const NormalizationParameters&,
+                                    const string&);
+template bool write_bitmap<int32_t>(const NormalizationParameters&,
+                                    const string&);
+template bool write_bitmap<uint32_t>(const NormalizationParameters&,
+                                     const string&);
+template bool write_bitmap<HalfFloat>(const NormalizationParameters&,
+                                      const string&);
+template bool write_bitmap<float>(const NormalizationParameters&,
+                                  const string&);
+
+
+bool write_binary(const BinaryLayout& layout,
+                  const string& header,
+                  const string& path)
+{
+    FILE* fhandle = fopen(path.c_str(), "wb");
+
+    if (fhandle == NULL) {
+        return false;
+    }
+
+    // The rows are packed into a staging buffer and written in large
+    // blocks, bypassing the stdio buffer
+    setvbuf(fhandle, NULL, _IONBF, 0);
+
+    vector<uint8_t> staging;
+    staging.reserve(export_strip_size);
+
+    bool succeeded = true;
+    const auto stage = [&](const void* data, size_t length) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+        while (length > 0 && succeeded) {
+            // Whole blocks are written straight from the buffer
+            if (staging.empty() && length >= export_strip_size) {
+                const size_t direct = length - length % export_strip_size;
+                succeeded = fwrite(bytes, 1, direct, fhandle) == direct;
+                bytes += direct;
+                length -= direct;
+                continue;
+            }
+
+            const size_t staged =
+                min(length, export_strip_size - staging.size());
+            staging.insert(staging.end(), bytes, bytes + staged);
+            bytes += staged;
+            length -= staged;
+
+            if (staging.size() == export_strip_size) {
+                succeeded =
+                    fwrite(staging.data(), 1, staging.size(), fhandle) ==
+                    staging.size();
+                staging.clear();
+            }
+        }
+    };
+
+    stage(header.data(), header.size());
+
+    if (layout.row_length == layout.input_stride) {
+        stage(layout.contents, layout.row_length * layout.height);
+    } else {
+        for (size_t y = 0; y < layout.height; ++y) {
+            stage(layout.contents + y * layout.input_stride,
+                  layout.row_length);
+        }
+    }
+
+    if (succeeded && !staging.empty()) {
+        succeeded = fwrite(staging.data(), 1, staging.size(), fhandle) ==
+                    staging.size();
+    }
+
+    return fclose(fhandle) == 0 && succeeded;
+}
@@ -0,0 +1,83 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef EXPORT_ENCODING_H_
+#define EXPORT_ENCODING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+/**
+ * Snapshot of the parameters needed to normalize a buffer, taken when the
+ * export is prepared. The contents are the copy owned by the export task.
+ */
+struct NormalizationParameters
+{
+    const std::uint8_t* contents;
+    std::size_t width;
+    std::size_t height;
+    std::size_t input_stride;
+    // Distance between the channel planes of planar buffers, 0 if the
+    // channels are interleaved
+    std::size_t plane_stride;
+    int channels;
+    float scale[4];
+    float offset[4];
+    std::uint8_t pixel_layout[4];
+    bool is_layout_remapped;
+};
+
+
+/**
+ * Rows of a buffer written by write_binary
+ */
+struct BinaryLayout
+{
+    const std::uint8_t* contents;
+    std::size_t height;
+    // Bytes of each row, and distance between the rows, in bytes
+    std::size_t row_length;
+    std::size_t input_stride;
+};
+
+
+/**
+ * Normalizes the buffer contents into RGBA8 a strip at a time, and streams
+ * them to a PNG file. Instantiated for all the types of exported buffers.
+ */
+template <typename T>
+bool write_bitmap(const NormalizationParameters& params,
+                  const std::string& path);
+
+/**
+ * Writes the given header followed by the buffer rows, tightly packed
+ */
+bool write_binary(const BinaryLayout& layout,
+                  const std::string& header,
+                  const std::string& path);
+
+#endif // EXPORT_ENCODING_H_
@@ -0,0 +1,233 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include "png_writer.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+void store_be32(uint32_t value, uint8_t* dst)
+{
+    dst[0] = static_cast<uint8_t>(value >> 24);
+    dst[1] = static_cast<uint8_t>(value >> 16);
+    dst[2] = static_cast<uint8_t>(value >> 8);
+    dst[3] = static_cast<uint8_t>(value);
+}
+
+} // namespace
+
+
+constexpr size_t PngWriter::idat_chunk_size;
+
+
+PngWriter::PngWriter()
+    : file_(nullptr)
+    , is_stream_initialized_(false)
+    , is_ok_(false)
+    , width_(0)
+    , height_(0)
+    , written_rows_(0)
+{
+}
+
+
+PngWriter::~PngWriter()
+{
+    if (is_stream_initialized_) {
+        deflateEnd(&stream_);
+    }
+
+    if (file_ != nullptr) {
+        fclose(file_);
+    }
+}
+
+
+bool PngWriter::open(const string& path, int width, int height)
+{
+    if (file_ != nullptr || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    file_ = fopen(path.c_str(), "wb");
+    if (file_ == nullptr) {
+        return false;
+    }
+
+    width_        = width;
+    height_       = height;
+    written_rows_ = 0;
+
+    stream_        = z_stream();
+    stream_.zalloc = Z_NULL;
+    stream_.zfree  = Z_NULL;
+    stream_.opaque = Z_NULL;
+
+    // Favour speed: every row uses the None filter type, and the rows are
+    // deflated with a fast compression level
+    if (deflateInit(&stream_, 3) != Z_OK) {
+        return false;
+    }
+    is_stream_initialized_ = true;
+
+    idat_buffer_.resize(idat_chunk_size);
+    stream_.next_out  = idat_buffer_.data();
+    stream_.avail_out = static_cast<uInt>(idat_buffer_.size());
+
+    const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    is_ok_ = fwrite(signature, 1, sizeof(signature), file_) ==
+             sizeof(signature);
+
+    // 8 bits per channel, RGBA, default compression/filter, no interlacing
+    uint8_t header[13] = {};
+    store_be32(static_cast<uint32_t>(width), header);
+    store_be32(static_cast<uint32_t>(height), header + 4);
+    header[8] = 8;
+    header[9] = 6;
+
+    return write_chunk("IHDR", header, sizeof(header));
+}
+
+
+bool PngWriter::write_rows(const uint8_t* rows, int row_count)
+{
+    if (!is_stream_initialized_ || written_rows_ + row_count > height_) {
+        return false;
+    }
+
+    const size_t row_length = static_cast<size_t>(width_) * 4;
+    const uint8_t filter_type = 0;
+
+    for (int y = 0; y < row_count && is_ok_; ++y) {
+        deflate_input(&filter_type, 1, Z_NO_FLUSH);
+        deflate_input(rows + y * row_length, row_length, Z_NO_FLUSH);
+    }
+
+    written_rows_ += row_count;
+
+    return is_ok_;
+}
+
+
+bool PngWriter::close()
+{
+    if (file_ == nullptr) {
+        return false;
+    }
+
+    if (is_stream_initialized_) {
+        deflate_input(nullptr, 0, Z_FINISH);
+
+        const size_t pending = idat_buffer_.size() - stream_.avail_out;
+        if (pending > 0) {
+            write_chunk("IDAT", idat_buffer_.data(), pending);
+        }
+
+        deflateEnd(&stream_);
+        is_stream_initialized_ = false;
+    }
+
+    write_chunk("IEND", nullptr, 0);
+
+    const bool closed = fclose(file_) == 0;
+    file_             = nullptr;
+
+    return closed && is_ok_ && written_rows_ == height_;
+}
+
+
+bool PngWriter::deflate_input(const uint8_t* data, size_t length, int flush)
+{
+    // The input is fed in pieces that fit in the zlib length type
+    do {
+        const size_t piece_length =
+            min(length, static_cast<size_t>(numeric_limits<uInt>::max()));
+
+        stream_.next_in  = const_cast<Bytef*>(data);
+        stream_.avail_in = static_cast<uInt>(piece_length);
+
+        data += piece_length;
+        length -= piece_length;
+
+        const int piece_flush = length == 0 ? flush : Z_NO_FLUSH;
+
+        int result;
+        do {
+            result = deflate(&stream_, piece_flush);
+            if (result == Z_STREAM_ERROR) {
+                is_ok_ = false;
+                return false;
+            }
+
+            // Emit a chunk every time the output buffer fills up
+            if (stream_.avail_out == 0) {
+                write_chunk("IDAT", idat_buffer_.data(), idat_buffer_.size());
+                stream_.next_out  = idat_buffer_.data();
+                stream_.avail_out = static_cast<uInt>(idat_buffer_.size());
+            }
+        } while (stream_.avail_in > 0 ||
+                 (piece_flush == Z_FINISH && result != Z_STREAM_END));
+    } while (length > 0);
+
+    return is_ok_;
+}
+
+
+bool PngWriter::write_chunk(const char* type,
+                            const uint8_t* data,
+                            size_t length)
+{
+    uint8_t prefix[8];
+    store_be32(static_cast<uint32_t>(length), prefix);
+    for (int i = 0; i < 4; ++i) {
+        prefix[4 + i] = static_cast<uint8_t>(type[i]);
+    }
+
+    uLong crc = crc32(0L, Z_NULL, 0);
+    crc       = crc32(crc, prefix + 4, 4);
+    if (length > 0) {
+        crc = crc32(crc, data, static_cast<uInt>(length));
+    }
+
+    uint8_t suffix[4];
+    store_be32(static_cast<uint32_t>(crc), suffix);
+
+    is_ok_ = is_ok_ && fwrite(prefix, 1, sizeof(prefix), file_) ==
+                           sizeof(prefix);
+    if (length > 0) {
+        is_ok_ = is_ok_ && fwrite(data, 1, length, file_) == length;
+    }
+    is_ok_ = is_ok_ && fwrite(suffix, 1, sizeof(suffix), file_) ==
+                           sizeof(suffix);
+
+    return is_ok_;
+}
@@ -0,0 +1,87 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef PNG_WRITER_H_
+#define PNG_WRITER_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+
+/**
+ * Writes RGBA8 PNG files a few rows at a time. The rows are deflated as they
+ * arrive and emitted as IDAT chunks of bounded size, so memory use does not
+ * depend on the image size.
+ */
+class PngWriter
+{
+  public:
+    PngWriter();
+
+    ~PngWriter();
+
+    PngWriter(const PngWriter&) = delete;
+
+    PngWriter& operator=(const PngWriter&) = delete;
+
+    bool open(const std::string& path, int width, int height);
+
+    /**
+     * Appends row_count tightly packed RGBA8 rows
+     */
+    bool write_rows(const std::uint8_t* rows, int row_count);
+
+    /**
+     * Flushes the last chunks. Returns false if any write failed, or if fewer
+     * rows than the image height were written.
+     */
+    bool close();
+
+  private:
+    static constexpr std::size_t idat_chunk_size = 1 << 18;
+
+    FILE* file_;
+    z_stream stream_;
+    bool is_stream_initialized_;
+    bool is_ok_;
+
+    int width_;
+    int height_;
+    int written_rows_;
+
+    std::vector<std::uint8_t> idat_buffer_;
+
+    bool deflate_input(const std::uint8_t* data, std::size_t length, int flush);
+
+    bool write_chunk(const char* type,
+                     const std::uint8_t* data,
+                     std::size_t length);
+};
+
+#endif // PNG_WRITER_H_
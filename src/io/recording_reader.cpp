@@ -0,0 +1,190 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstring>
+
+#include "recording_reader.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+const size_t header_size = BufferRecorder::header_size;
+
+
+size_t align(size_t offset)
+{
+    const size_t alignment = BufferRecorder::alignment;
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+
+/**
+ * Checks that the record describes a buffer its contents can hold, and that
+ * the payload of uncompressed frames holds all of it
+ */
+bool is_valid_record(const BufferRecorder::FrameRecord& record)
+{
+    if (record.type > static_cast<uint8_t>(BufferType::Bool) ||
+        record.channels < 1 || record.channels > 4 || record.width <= 0 ||
+        record.height <= 0 || record.row_stride < record.width) {
+        return false;
+    }
+
+    const uint64_t value_size = typesize(static_cast<BufferType>(record.type));
+    const uint64_t pitch_area = static_cast<uint64_t>(record.row_stride) *
+                                static_cast<uint64_t>(record.height);
+    const uint64_t values_per_area =
+        static_cast<uint64_t>(record.channels) * value_size;
+    if (record.length / values_per_area < pitch_area) {
+        return false;
+    }
+
+    const auto codec = static_cast<CompressionCodec>(record.codec);
+    return codec != CompressionCodec::None ||
+           record.stored_length == record.length;
+}
+
+} // namespace
+
+
+RecordingReader::RecordingReader()
+    : data_(nullptr)
+    , length_(0)
+    , index_(nullptr)
+    , frame_count_(0)
+{
+}
+
+
+bool RecordingReader::open(const uint8_t* data, size_t length)
+{
+    data_        = data;
+    length_      = length;
+    index_       = nullptr;
+    frame_count_ = 0;
+    frame_offsets_.clear();
+
+    const size_t magic_length = sizeof(BufferRecorder::magic);
+    if (length < header_size ||
+        memcmp(data, BufferRecorder::magic, magic_length) != 0) {
+        return false;
+    }
+
+    uint32_t name_length;
+    uint64_t frame_count;
+    uint64_t index_offset;
+    memcpy(&name_length, data + 12, sizeof(uint32_t));
+    memcpy(&frame_count, data + 16, sizeof(uint64_t));
+    memcpy(&index_offset, data + 24, sizeof(uint64_t));
+
+    if (header_size + name_length > length) {
+        return false;
+    }
+    variable_name_.assign(reinterpret_cast<const char*>(data + header_size),
+                          name_length);
+
+    if (index_offset != 0 && index_offset <= length &&
+        frame_count <= (length - index_offset) / sizeof(uint64_t)) {
+        index_       = data + index_offset;
+        frame_count_ = static_cast<size_t>(frame_count);
+        return true;
+    }
+
+    // The recording wasn't closed: walk the frames that were fully written
+    size_t offset = align(header_size + name_length);
+    while (offset + sizeof(BufferRecorder::FrameRecord) <= length) {
+        BufferRecorder::FrameRecord record;
+        memcpy(&record, data + offset, sizeof(record));
+
+        const size_t payload_offset = align(offset + sizeof(record));
+        if (record.stored_length > length ||
+            payload_offset + record.stored_length > length) {
+            break;
+        }
+
+        frame_offsets_.push_back(offset);
+        offset = align(payload_offset + record.stored_length);
+    }
+    frame_count_ = frame_offsets_.size();
+
+    return true;
+}
+
+
+const string& RecordingReader::variable_name() const
+{
+    return variable_name_;
+}
+
+
+size_t RecordingReader::frame_count() const
+{
+    return frame_count_;
+}
+
+
+bool RecordingReader::read_frame(size_t index,
+                                 BufferRecorder::FrameRecord& record,
+                                 const uint8_t*& payload) const
+{
+    if (index >= frame_count_) {
+        return false;
+    }
+
+    const uint64_t offset = frame_offset(index);
+    if (offset > length_ || length_ - offset < sizeof(record)) {
+        return false;
+    }
+    memcpy(&record, data_ + offset, sizeof(record));
+
+    if (!is_valid_record(record)) {
+        return false;
+    }
+
+    const size_t payload_offset = align(offset + sizeof(record));
+    if (payload_offset > length_ ||
+        record.stored_length > length_ - payload_offset) {
+        return false;
+    }
+    payload = data_ + payload_offset;
+
+    return true;
+}
+
+
+uint64_t RecordingReader::frame_offset(size_t index) const
+{
+    if (index_ == nullptr) {
+        return frame_offsets_[index];
+    }
+
+    uint64_t offset;
+    memcpy(&offset, index_ + index * sizeof(uint64_t), sizeof(uint64_t));
+    return offset;
+}
@@ -0,0 +1,80 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef RECORDING_READER_H_
+#define RECORDING_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "buffer_recorder.h"
+
+
+/**
+ * Reads the frames of a recording written by BufferRecorder from its
+ * memory mapped contents. Only the header and the frame index are read when
+ * opening it; frames are read when requested.
+ */
+class RecordingReader
+{
+  public:
+    RecordingReader();
+
+    /**
+     * @param data  Contents of the recording file, which must outlive the
+     *              reader
+     */
+    bool open(const std::uint8_t* data, std::size_t length);
+
+    const std::string& variable_name() const;
+
+    std::size_t frame_count() const;
+
+    /**
+     * Finds the record and payload of a frame. Returns false if the frame
+     * doesn't exist, is truncated, or describes an invalid buffer.
+     */
+    bool read_frame(std::size_t index,
+                    BufferRecorder::FrameRecord& record,
+                    const std::uint8_t*& payload) const;
+
+  private:
+    const std::uint8_t* data_;
+    std::size_t length_;
+
+    std::string variable_name_;
+
+    // Points into the file for closed recordings. Recordings that weren't
+    // closed have their frames walked into frame_offsets_ instead.
+    const std::uint8_t* index_;
+    std::size_t frame_count_;
+    std::vector<std::uint64_t> frame_offsets_;
+
+    std::uint64_t frame_offset(std::size_t index) const;
+};
+
+#endif // RECORDING_READER_H_
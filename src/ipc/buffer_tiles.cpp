@@ -0,0 +1,115 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "buffer_tiles.h"
+
+#include "content_hash.h"
+
+
+int buffer_tile_count(int width, int height)
+{
+    const int tiles_x = (width + buffer_tile_size - 1) / buffer_tile_size;
+    const int tiles_y = (height + buffer_tile_size - 1) / buffer_tile_size;
+
+    return tiles_x * tiles_y;
+}
+
+
+BufferRegion buffer_tile_region(int width, int height, int tile_index)
+{
+    const int tiles_x = (width + buffer_tile_size - 1) / buffer_tile_size;
+
+    BufferRegion region;
+    region.x      = (tile_index % tiles_x) * buffer_tile_size;
+    region.y      = (tile_index / tiles_x) * buffer_tile_size;
+    region.width  = std::min(buffer_tile_size, width - region.x);
+    region.height = std::min(buffer_tile_size, height - region.y);
+
+    return region;
+}
+
+
+std::vector<std::uint64_t> compute_tile_hashes(const std::uint8_t* buffer,
+                                               const BufferMetadata& metadata)
+{
+    const size_t pixel_size =
+        static_cast<size_t>(metadata.channels) * typesize(metadata.type);
+    const size_t pitch = static_cast<size_t>(metadata.row_stride) * pixel_size;
+
+    const int tile_count = buffer_tile_count(metadata.width, metadata.height);
+
+    std::vector<std::uint64_t> tile_hashes(static_cast<size_t>(tile_count));
+
+    for (int tile = 0; tile < tile_count; ++tile) {
+        const BufferRegion region =
+            buffer_tile_region(metadata.width, metadata.height, tile);
+
+        const std::uint8_t* row =
+            buffer + static_cast<size_t>(region.y) * pitch +
+            static_cast<size_t>(region.x) * pixel_size;
+
+        std::uint64_t hash = 0;
+        for (int y = 0; y < region.height; ++y) {
+            hash = content_hash(
+                row, static_cast<size_t>(region.width) * pixel_size, hash);
+            row += pitch;
+        }
+
+        tile_hashes[static_cast<size_t>(tile)] = hash;
+    }
+
+    return tile_hashes;
+}
+
+
+bool has_same_layout(const BufferMetadata& a, const BufferMetadata& b)
+{
+    return a.width == b.width && a.height == b.height &&
+           a.channels == b.channels && a.row_stride == b.row_stride &&
+           a.type == b.type && a.pixel_layout == b.pixel_layout &&
+           a.transpose_buffer == b.transpose_buffer &&
+           a.is_planar == b.is_planar;
+}
+
+
+void copy_buffer_region(const std::uint8_t* src,
+                        std::size_t src_pitch,
+                        std::uint8_t* dst,
+                        std::size_t dst_pitch,
+                        const BufferRegion& region,
+                        std::size_t pixel_size)
+{
+    const size_t row_length = static_cast<size_t>(region.width) * pixel_size;
+
+    for (int y = 0; y < region.height; ++y) {
+        memcpy(dst, src, row_length);
+
+        src += src_pitch;
+        dst += dst_pitch;
+    }
+}
@@ -0,0 +1,80 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef IPC_BUFFER_TILES_H_
+#define IPC_BUFFER_TILES_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "raw_data_decode.h"
+
+/**
+ * Side of the square blocks used to send partial buffer updates. It divides
+ * Buffer::max_texture_size, so a block never straddles two textures.
+ */
+const int buffer_tile_size = 256;
+
+/**
+ * Coarsest level tiles are sent at, with one pixel per tile
+ * (log2(buffer_tile_size))
+ */
+const int buffer_tile_max_level = 8;
+
+struct BufferRegion
+{
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+int buffer_tile_count(int width, int height);
+
+BufferRegion buffer_tile_region(int width, int height, int tile_index);
+
+/**
+ * Hashes each tile of the buffer independently, in row major tile order.
+ */
+std::vector<std::uint64_t> compute_tile_hashes(const std::uint8_t* buffer,
+                                               const BufferMetadata& metadata);
+
+/**
+ * True if both buffers can share textures, i.e. only their contents differ.
+ */
+bool has_same_layout(const BufferMetadata& a, const BufferMetadata& b);
+
+/**
+ * Copies the rows of a region between two buffers. Pitches are in bytes.
+ */
+void copy_buffer_region(const std::uint8_t* src,
+                        std::size_t src_pitch,
+                        std::uint8_t* dst,
+                        std::size_t dst_pitch,
+                        const BufferRegion& region,
+                        std::size_t pixel_size);
+
+#endif // IPC_BUFFER_TILES_H_
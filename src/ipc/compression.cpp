@@ -0,0 +1,80 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <limits>
+
+#include <zlib.h>
+
+#include "compression.h"
+
+
+bool compress_block(const std::uint8_t* src,
+                    std::size_t length,
+                    const CompressionSettings& settings,
+                    std::vector<std::uint8_t>& dst)
+{
+    if (settings.codec != CompressionCodec::Zlib ||
+        length < settings.threshold ||
+        length > std::numeric_limits<uLong>::max()) {
+        return false;
+    }
+
+    uLongf compressed_length = compressBound(static_cast<uLong>(length));
+    dst.resize(compressed_length);
+
+    if (compress2(dst.data(),
+                  &compressed_length,
+                  src,
+                  static_cast<uLong>(length),
+                  settings.level) != Z_OK ||
+        compressed_length >= length) {
+        return false;
+    }
+
+    dst.resize(compressed_length);
+
+    return true;
+}
+
+
+bool decompress_block(CompressionCodec codec,
+                      const std::uint8_t* src,
+                      std::size_t length,
+                      std::uint8_t* dst,
+                      std::size_t dst_length)
+{
+    if (codec != CompressionCodec::Zlib ||
+        dst_length > std::numeric_limits<uLong>::max()) {
+        return false;
+    }
+
+    uLongf uncompressed_length = static_cast<uLongf>(dst_length);
+
+    return uncompress(dst,
+                      &uncompressed_length,
+                      src,
+                      static_cast<uLong>(length)) == Z_OK &&
+           uncompressed_length == dst_length;
+}
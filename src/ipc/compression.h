@@ -0,0 +1,70 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef IPC_COMPRESSION_H_
+#define IPC_COMPRESSION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class CompressionCodec { None = 0, Zlib = 1 };
+
+/**
+ * Largest ratio between the uncompressed and compressed lengths of a block
+ * that deflate can reach
+ */
+const std::size_t max_compression_ratio = 1032;
+
+struct CompressionSettings
+{
+    CompressionCodec codec;
+    int level;
+    // Payloads smaller than this are always sent raw
+    std::size_t threshold;
+};
+
+/**
+ * Compresses a block with the given codec.
+ *
+ * @return false if the codec is unavailable or didn't make the block smaller,
+ * in which case it should be sent raw.
+ */
+bool compress_block(const std::uint8_t* src,
+                    std::size_t length,
+                    const CompressionSettings& settings,
+                    std::vector<std::uint8_t>& dst);
+
+/**
+ * Decompresses a block straight into dst, which must be exactly as large as
+ * the uncompressed contents.
+ */
+bool decompress_block(CompressionCodec codec,
+                      const std::uint8_t* src,
+                      std::size_t length,
+                      std::uint8_t* dst,
+                      std::size_t dst_length);
+
+#endif // IPC_COMPRESSION_H_
@@ -0,0 +1,144 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstring>
+
+#include "content_hash.h"
+
+
+namespace
+{
+
+const std::uint64_t prime_1 = 11400714785074694791ULL;
+const std::uint64_t prime_2 = 14029467366897019727ULL;
+const std::uint64_t prime_3 = 1609587929392839161ULL;
+const std::uint64_t prime_4 = 9650029242287828579ULL;
+const std::uint64_t prime_5 = 2870177450012600261ULL;
+
+
+inline std::uint64_t rotate_left(std::uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+
+inline std::uint64_t read_u64(const std::uint8_t* data)
+{
+    std::uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+
+inline std::uint32_t read_u32(const std::uint8_t* data)
+{
+    std::uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+
+inline std::uint64_t round(std::uint64_t accumulator, std::uint64_t input)
+{
+    accumulator += input * prime_2;
+    accumulator = rotate_left(accumulator, 31);
+    return accumulator * prime_1;
+}
+
+
+inline std::uint64_t merge_round(std::uint64_t accumulator,
+                                 std::uint64_t value)
+{
+    accumulator ^= round(0, value);
+    return accumulator * prime_1 + prime_4;
+}
+
+} // namespace
+
+
+std::uint64_t
+content_hash(const void* data, std::size_t length, std::uint64_t seed)
+{
+    const std::uint8_t* input = static_cast<const std::uint8_t*>(data);
+    const std::uint8_t* end   = input + length;
+
+    std::uint64_t hash;
+
+    if (length >= 32) {
+        // Four independent lanes keep the multipliers busy; this is what
+        // makes the hash run close to memory bandwidth
+        std::uint64_t v1 = seed + prime_1 + prime_2;
+        std::uint64_t v2 = seed + prime_2;
+        std::uint64_t v3 = seed;
+        std::uint64_t v4 = seed - prime_1;
+
+        const std::uint8_t* limit = end - 32;
+        do {
+            v1 = round(v1, read_u64(input));
+            v2 = round(v2, read_u64(input + 8));
+            v3 = round(v3, read_u64(input + 16));
+            v4 = round(v4, read_u64(input + 24));
+            input += 32;
+        } while (input <= limit);
+
+        hash = rotate_left(v1, 1) + rotate_left(v2, 7) + rotate_left(v3, 12) +
+               rotate_left(v4, 18);
+
+        hash = merge_round(hash, v1);
+        hash = merge_round(hash, v2);
+        hash = merge_round(hash, v3);
+        hash = merge_round(hash, v4);
+    } else {
+        hash = seed + prime_5;
+    }
+
+    hash += static_cast<std::uint64_t>(length);
+
+    while (input + 8 <= end) {
+        hash ^= round(0, read_u64(input));
+        hash = rotate_left(hash, 27) * prime_1 + prime_4;
+        input += 8;
+    }
+
+    if (input + 4 <= end) {
+        hash ^= static_cast<std::uint64_t>(read_u32(input)) * prime_1;
+        hash = rotate_left(hash, 23) * prime_2 + prime_3;
+        input += 4;
+    }
+
+    while (input < end) {
+        hash ^= (*input) * prime_5;
+        hash = rotate_left(hash, 11) * prime_1;
+        ++input;
+    }
+
+    hash ^= hash >> 33;
+    hash *= prime_2;
+    hash ^= hash >> 29;
+    hash *= prime_3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
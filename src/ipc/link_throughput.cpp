@@ -0,0 +1,130 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include "link_throughput.h"
+
+
+namespace
+{
+
+// Transfers smaller than this only measure the latency of the link
+const std::size_t min_sample_length = 256 << 10;
+
+// Weight of each new sample in the estimate
+const double sample_weight = 0.3;
+
+// Longest time a single message may keep the link busy, delaying the
+// messages queued behind it
+const double interactive_seconds = 0.25;
+
+// Buffers taking longer than this to be sent in full are sent progressively
+const double full_transfer_seconds = 0.5;
+
+// Buffers taking longer than this to be sent at all are fetched on demand
+const double lazy_transfer_seconds = 8.0;
+
+// Links slower than this spend less time compressing than sending
+const double compressed_link_bytes_per_second = 100e6;
+const double slow_link_bytes_per_second       = 4e6;
+
+// Bounds of the messages tiles are sent in
+const std::size_t shortest_message_length = 256 << 10;
+const std::size_t longest_message_length  = 8 << 20;
+
+
+std::size_t transfer_length(double bytes_per_second, double seconds)
+{
+    return static_cast<std::size_t>(bytes_per_second * seconds);
+}
+
+} // namespace
+
+
+LinkThroughput::LinkThroughput(double initial_bytes_per_second)
+    : bytes_per_second_(initial_bytes_per_second)
+    , has_samples_(false)
+{
+}
+
+
+void LinkThroughput::add_sample(std::size_t bytes, double seconds)
+{
+    if (bytes < min_sample_length || seconds <= 0.0) {
+        return;
+    }
+
+    const double sample = static_cast<double>(bytes) / seconds;
+
+    // The initial estimate is only a guess, and is replaced right away
+    if (!has_samples_) {
+        bytes_per_second_ = sample;
+        has_samples_      = true;
+        return;
+    }
+
+    bytes_per_second_ += sample_weight * (sample - bytes_per_second_);
+}
+
+
+double LinkThroughput::bytes_per_second() const
+{
+    return bytes_per_second_;
+}
+
+
+RemoteTransportSettings
+choose_remote_transport_settings(double bytes_per_second)
+{
+    RemoteTransportSettings settings;
+
+    settings.compression.codec = CompressionCodec::None;
+    settings.compression.level = 1;
+    // Small payloads gain little from compression
+    settings.compression.threshold = 64 << 10;
+    if (bytes_per_second < compressed_link_bytes_per_second) {
+        settings.compression.codec = CompressionCodec::Zlib;
+    }
+    if (bytes_per_second < slow_link_bytes_per_second) {
+        settings.compression.level = 6;
+    }
+
+    settings.max_message_length =
+        std::min(std::max(transfer_length(bytes_per_second,
+                                          interactive_seconds),
+                          shortest_message_length),
+                 longest_message_length);
+
+    settings.progressive_threshold = std::max(
+        transfer_length(bytes_per_second, full_transfer_seconds),
+        settings.max_message_length);
+    settings.preview_length = settings.max_message_length;
+    settings.lazy_threshold =
+        std::max(transfer_length(bytes_per_second, lazy_transfer_seconds),
+                 settings.progressive_threshold);
+
+    return settings;
+}
@@ -0,0 +1,74 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef IPC_LINK_THROUGHPUT_H_
+#define IPC_LINK_THROUGHPUT_H_
+
+#include <cstddef>
+
+#include "compression.h"
+
+/**
+ * Estimates the throughput of the link to a remote window from the time the
+ * large transfers through it took. Small transfers are dominated by the
+ * latency of the link, and are ignored.
+ */
+class LinkThroughput
+{
+  public:
+    explicit LinkThroughput(double initial_bytes_per_second);
+
+    void add_sample(std::size_t bytes, double seconds);
+
+    double bytes_per_second() const;
+
+  private:
+    double bytes_per_second_;
+    bool has_samples_;
+};
+
+
+/**
+ * Transport settings of a remote session, chosen for the throughput of its
+ * link so that no message keeps the link busy for long
+ */
+struct RemoteTransportSettings
+{
+    CompressionSettings compression;
+    // Buffers at least this large are sent progressively
+    std::size_t progressive_threshold;
+    // Largest preview of a buffer sent progressively, from which its
+    // reduction factor is chosen
+    std::size_t preview_length;
+    // Buffers of the inferior at least this large are sent lazily
+    std::size_t lazy_threshold;
+    // Tiles are sent in messages of about this many bytes
+    std::size_t max_message_length;
+};
+
+RemoteTransportSettings
+choose_remote_transport_settings(double bytes_per_second);
+
+#endif // IPC_LINK_THROUGHPUT_H_
@@ -27,21 +27,331 @@
 
 #include "message_exchange.h"
 
-MessageBlock::~MessageBlock()
+#include <QAbstractSocket>
+
+#include "system/trace/tracer.h"
+
+namespace
+{
+
+// Enough for the header of any plot message without reallocating
+const size_t composer_initial_arena_capacity = 256;
+
+
+// Returns false if the device failed before all of the data was written
+bool write_all(QIODevice* socket, const uint8_t* data, size_t size)
+{
+    qint64 offset = 0;
+    while (offset < static_cast<qint64>(size)) {
+        const qint64 written =
+            socket->write(reinterpret_cast<const char*>(data) + offset,
+                          static_cast<qint64>(size) - offset);
+
+        // A device which accepts nothing and never drains would otherwise
+        // be retried forever
+        if (written < 0 || (written == 0 && !socket->waitForBytesWritten())) {
+            std::cerr << "[OpenImageDebugger] Could not write message: "
+                      << socket->errorString().toStdString() << std::endl;
+            return false;
+        }
+
+        offset += written;
+    }
+
+    return true;
+}
+
+
+// Drops the connection, along with the data still buffered for it
+void abort_device(QIODevice* socket)
+{
+    QAbstractSocket* abstract_socket = qobject_cast<QAbstractSocket*>(socket);
+    if (abstract_socket != nullptr) {
+        abstract_socket->abort();
+    } else {
+        socket->close();
+    }
+}
+
+} // namespace
+
+
+MessageComposer::MessageComposer()
+    : correlation_id_(TraceCorrelation::current())
 {
+    arena_.reserve(composer_initial_arena_capacity);
 }
 
-StringBlock::StringBlock(const std::string &value)
-    : data_(value)
+
+void MessageComposer::send(QIODevice* socket) const
 {
+    TraceSpan span("MessageComposer::send", correlation_id_);
+    Tracer::instance().flow_begin(correlation_id_, Tracer::now());
+
+    // Every message is prefixed by the length of its body, so receivers can
+    // buffer it without knowing its structure in advance
+    size_t body_length = arena_.size();
+    for (const auto& segment : segments_) {
+        if (segment.external != nullptr) {
+            body_length += segment.size;
+        }
+    }
+
+    bool is_written =
+        write_all(socket,
+                  reinterpret_cast<const uint8_t*>(&body_length),
+                  sizeof(body_length)) &&
+        write_all(socket,
+                  reinterpret_cast<const uint8_t*>(&correlation_id_),
+                  sizeof(correlation_id_));
+
+    for (auto segment = segments_.begin();
+         is_written && segment != segments_.end();
+         ++segment) {
+        const uint8_t* data = segment->external != nullptr
+                                  ? segment->external
+                                  : arena_.data() + segment->offset;
+        is_written = write_all(socket, data, segment->size);
+    }
+
+    // The receiver could never find the start of the next message after a
+    // partial one, so the connection is dropped instead
+    if (!is_written) {
+        abort_device(socket);
+        return;
+    }
+
+    // All segments are buffered by the device at this point
+    while (socket->bytesToWrite() > 0 && socket->waitForBytesWritten()) {
+    }
 }
 
-size_t StringBlock::size() const
+
+void MessageComposer::clear()
 {
-    return data_.size();
+    arena_.clear();
+    segments_.clear();
+    owned_buffers_.clear();
 }
 
-const uint8_t *StringBlock::data() const
+
+void MessageComposer::append_to_arena(const void* data, size_t size)
+{
+    const size_t offset  = arena_.size();
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+    arena_.insert(arena_.end(), bytes, bytes + size);
+
+    // Consecutive small fields end up in a single segment
+    if (!segments_.empty() && segments_.back().external == nullptr) {
+        segments_.back().size += size;
+    } else {
+        segments_.push_back({nullptr, offset, size});
+    }
+}
+
+
+void MessageComposer::append_external(const uint8_t* data, size_t size)
+{
+    segments_.push_back({data, 0, size});
+}
+
+
+template <typename Container>
+MessageDecoder& MessageDecoder::read_compressed_into(Container& container)
+{
+    CompressionCodec codec;
+    size_t uncompressed_length;
+    size_t stored_length;
+
+    read(codec).read(uncompressed_length).read(stored_length);
+    stored_length = std::min(stored_length, remaining());
+
+    if (codec == CompressionCodec::None) {
+        container.resize(stored_length);
+        read_impl(reinterpret_cast<char*>(container.data()), stored_length);
+        return *this;
+    }
+
+    // The uncompressed length is read from the peer, so it is bounded before
+    // being allocated. The block must then decompress to exactly that length.
+    if (uncompressed_length > max_message_length ||
+        uncompressed_length / max_compression_ratio > stored_length) {
+        container.clear();
+        offset_ += stored_length;
+        return *this;
+    }
+
+    container.resize(uncompressed_length);
+    if (!decompress_block(codec,
+                          data_ + offset_,
+                          stored_length,
+                          container.data(),
+                          container.size())) {
+        container.clear();
+    }
+    offset_ += stored_length;
+
+    return *this;
+}
+
+
+MessageDecoder& MessageDecoder::read_compressed(std::vector<uint8_t>& container)
+{
+    return read_compressed_into(container);
+}
+
+
+MessageDecoder& MessageDecoder::read_compressed(HostBuffer& container)
+{
+    return read_compressed_into(container);
+}
+
+
+const uint8_t* MessageDecoder::read_payload(size_t& size)
+{
+    read(size);
+    size = std::min(size, remaining());
+
+    const uint8_t* payload = data_ + offset_;
+    offset_ += size;
+
+    return payload;
+}
+
+
+namespace
+{
+
+// Buffers larger than this are released once their message is consumed, so
+// a single huge plot doesn't stay pinned in memory
+const size_t reader_retained_capacity = 64 * 1024 * 1024;
+
+const size_t reader_initial_capacity = 64 * 1024;
+
+} // namespace
+
+
+MessageStreamReader::MessageStreamReader()
+    : state_(State::ReadingLength)
+    , body_length_(0)
+    , correlation_id_(0)
+    , received_(0)
+    , capacity_(0)
+{
+    reserve(reader_initial_capacity);
+}
+
+
+bool MessageStreamReader::read_available(QIODevice* device)
+{
+    if (state_ == State::ReadingLength) {
+        const qint64 length_size = static_cast<qint64>(sizeof(body_length_));
+        const qint64 id_size = static_cast<qint64>(sizeof(correlation_id_));
+        if (device->bytesAvailable() < length_size + id_size) {
+            return false;
+        }
+
+        device->read(reinterpret_cast<char*>(&body_length_), length_size);
+        device->read(reinterpret_cast<char*>(&correlation_id_), id_size);
+
+        if (body_length_ > max_message_length) {
+            std::cerr << "[OpenImageDebugger] Dropped connection sending a "
+                      << body_length_ << " byte message" << std::endl;
+            body_length_    = 0;
+            correlation_id_ = 0;
+            abort_device(device);
+            return false;
+        }
+
+        reserve(body_length_);
+
+        received_ = 0;
+        state_    = State::ReadingBody;
+    }
+
+    if (state_ == State::ReadingBody) {
+        while (received_ < body_length_) {
+            const qint64 read_length = device->read(
+                reinterpret_cast<char*>(body_.get() + received_),
+                static_cast<qint64>(body_length_ - received_));
+
+            if (read_length <= 0) {
+                return false;
+            }
+
+            received_ += static_cast<size_t>(read_length);
+        }
+
+        state_ = State::MessageReady;
+    }
+
+    return true;
+}
+
+
+bool MessageStreamReader::wait_for_message(QIODevice* device, int msecs)
+{
+    while (!read_available(device)) {
+        if (!device->waitForReadyRead(msecs)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+MessageType MessageStreamReader::message_type() const
+{
+    assert(state_ == State::MessageReady);
+
+    MessageType header;
+    MessageDecoder(body_.get(), body_length_).read(header);
+
+    return header;
+}
+
+
+std::uint64_t MessageStreamReader::correlation_id() const
+{
+    assert(state_ == State::MessageReady);
+
+    return correlation_id_;
+}
+
+
+MessageDecoder MessageStreamReader::message_decoder() const
+{
+    assert(state_ == State::MessageReady);
+
+    const size_t header_size = std::min(sizeof(MessageType), body_length_);
+
+    return MessageDecoder(body_.get() + header_size,
+                          body_length_ - header_size);
+}
+
+
+void MessageStreamReader::pop_message()
+{
+    state_       = State::ReadingLength;
+    body_length_    = 0;
+    correlation_id_ = 0;
+    received_       = 0;
+
+    if (capacity_ > reader_retained_capacity) {
+        body_.reset();
+        capacity_ = 0;
+        reserve(reader_initial_capacity);
+    }
+}
+
+
+void MessageStreamReader::reserve(size_t length)
 {
-    return reinterpret_cast<const uint8_t*>(data_.data());
+    if (length > capacity_) {
+        // Left uninitialized on purpose, it is about to be overwritten
+        body_.reset(new uint8_t[length]);
+        capacity_ = length;
+    }
 }
@@ -26,85 +26,50 @@
 #ifndef IPC_MESSAGE_EXCHANGE_H_
 #define IPC_MESSAGE_EXCHANGE_H_
 
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <deque>
 #include <memory>
+#include <string>
 
-#include <QTcpSocket>
+#include <QIODevice>
+#include <QString>
 
+#include "compression.h"
 #include "raw_data_decode.h"
+#include "system/memory/host_buffer_pool.h"
 
 enum class MessageType {
-    GetObservedSymbols         = 0,
-    GetObservedSymbolsResponse = 1,
-    SetAvailableSymbols        = 2,
-    PlotBufferContents         = 3,
-    PlotBufferRequest          = 4
+    GetObservedSymbols           = 0,
+    GetObservedSymbolsResponse   = 1,
+    SetAvailableSymbols          = 2,
+    PlotBufferContents           = 3,
+    PlotBufferRequest            = 4,
+    PlotBufferSharedContents     = 5,
+    PlotBufferTiles              = 6,
+    PlotBufferSharedTiles        = 7,
+    PlotBufferCompressedContents = 8,
+    SetTransportSettings         = 9,
+    PlotBufferUnchanged          = 10,
+    UpdateAvailableSymbols       = 11,
+    PlotBufferBatch              = 12,
+    PlotBufferPreview            = 13,
+    PlotBufferLazy               = 14,
+    PlotBufferTilesRequest       = 15,
+    PlotBufferLevelTiles         = 16,
+    PlotBufferStop               = 17,
+    PlotBufferSliceRequest       = 18,
+    SetDisplayedBuffers          = 19,
+    PlotBufferPrefetchRequest    = 20
 };
 
-struct MessageBlock
-{
-    virtual size_t size() const         = 0;
-    virtual const uint8_t* data() const = 0;
-    virtual ~MessageBlock();
-};
-
-template <typename Primitive>
-struct PrimitiveBlock : public MessageBlock
-{
-    PrimitiveBlock(Primitive value)
-        : data_(value)
-    {
-    }
-
-    virtual size_t size() const
-    {
-        return sizeof(Primitive);
-    }
-
-    virtual const uint8_t* data() const
-    {
-        return reinterpret_cast<const uint8_t*>(&data_);
-    }
-
-  private:
-    Primitive data_;
-};
-
-
-struct StringBlock : public MessageBlock
-{
-    StringBlock(const std::string& value);
-
-    virtual size_t size() const;
-
-    virtual const uint8_t* data() const;
-
-  private:
-    std::string data_;
-};
-
-struct BufferBlock : public MessageBlock
-{
-    BufferBlock(const uint8_t* buffer, size_t length)
-        : buffer_(buffer)
-        , length_(length)
-    {
-    }
-
-    virtual size_t size() const
-    {
-        return length_;
-    }
-
-    virtual const uint8_t* data() const
-    {
-        return buffer_;
-    }
-
-  private:
-    const uint8_t* buffer_;
-    size_t length_;
-};
+/**
+ * Largest message body accepted from a peer. Longer messages can only come
+ * from a corrupted stream, whose connection is then dropped.
+ */
+const std::size_t max_message_length = std::size_t(1) << 31;
 
 template <typename PrimitiveType>
 void assert_primitive_type()
@@ -113,64 +78,109 @@ void assert_primitive_type()
                       std::is_same<PrimitiveType, int>::value ||
                       std::is_same<PrimitiveType, unsigned char>::value ||
                       std::is_same<PrimitiveType, BufferType>::value ||
+                      std::is_same<PrimitiveType, CompressionCodec>::value ||
                       std::is_same<PrimitiveType, bool>::value ||
                       std::is_same<PrimitiveType, std::size_t>::value,
                   "this function must only be called with primitives");
 }
 
+/**
+ * Serializes a message into a contiguous arena, referencing large payloads in
+ * place instead of copying them.
+ *
+ * The message is sent as a short list of segments (arena ranges and external
+ * payloads) written back to back, waiting only once for the device to flush.
+ */
 class MessageComposer
 {
   public:
+    MessageComposer();
+
     template <typename PrimitiveType>
     MessageComposer& push(const PrimitiveType& value)
     {
         assert_primitive_type<PrimitiveType>();
 
-        message_blocks_.emplace_back(new PrimitiveBlock<PrimitiveType>(value));
+        append_to_arena(&value, sizeof(PrimitiveType));
 
         return *this;
     }
 
-    MessageComposer& push(uint8_t* buffer, size_t size)
+    MessageComposer& push(const uint8_t* buffer, size_t size)
     {
         push(size);
-        message_blocks_.emplace_back(new BufferBlock(buffer, size));
+        append_external(buffer, size);
 
         return *this;
     }
 
-    void send(QTcpSocket* socket) const
+    /**
+     * Pushes a payload, compressed if the settings allow it and it pays off.
+     * It must be read back with MessageDecoder::read_compressed.
+     */
+    MessageComposer& push_compressed(const uint8_t* buffer,
+                                     size_t size,
+                                     const CompressionSettings& settings)
     {
-        for (const auto& block : message_blocks_) {
-            qint64 offset = 0;
-            do {
-                offset +=
-                    socket->write(reinterpret_cast<const char*>(block->data()),
-                                  static_cast<qint64>(block->size()));
-
-                if (offset < static_cast<qint64>(block->size())) {
-                    socket->waitForBytesWritten();
-                }
-            } while (offset < static_cast<qint64>(block->size()));
+        std::vector<uint8_t> compressed;
+        if (compress_block(buffer, size, settings, compressed)) {
+            owned_buffers_.emplace_back(std::move(compressed));
+            const std::vector<uint8_t>& owned = owned_buffers_.back();
+
+            push(CompressionCodec::Zlib).push(size).push(owned.data(),
+                                                         owned.size());
+        } else {
+            push(CompressionCodec::None).push(size).push(buffer, size);
         }
 
-        socket->waitForBytesWritten();
+        return *this;
     }
 
-    void clear()
+    /**
+     * Writes the message, prefixed by its length and correlation id. If the
+     * socket fails partway, the connection is aborted rather than left with
+     * a partial message.
+     */
+    void send(QIODevice* socket) const;
+
+    void clear();
+
+    /**
+     * Id attributing the message to a traced operation. Defaults to the
+     * current correlation id of the thread that created the composer.
+     */
+    void set_correlation_id(std::uint64_t correlation_id)
     {
-        message_blocks_.clear();
+        correlation_id_ = correlation_id;
     }
 
   private:
-    std::deque<std::unique_ptr<MessageBlock>> message_blocks_;
+    struct Segment
+    {
+        // Arena ranges are kept as offsets (with a null external pointer),
+        // since the arena may be reallocated while the message is composed
+        const uint8_t* external;
+        size_t offset;
+        size_t size;
+    };
+
+    std::vector<uint8_t> arena_;
+    std::vector<Segment> segments_;
+    std::deque<std::vector<uint8_t>> owned_buffers_;
+    std::uint64_t correlation_id_;
+
+    void append_to_arena(const void* data, size_t size);
+
+    void append_external(const uint8_t* data, size_t size);
 };
 
 class MessageDecoder
 {
   public:
-    MessageDecoder(QTcpSocket* socket)
-        : socket_(socket)
+    MessageDecoder(const uint8_t* data, size_t size)
+        : data_(data)
+        , size_(size)
+        , offset_(0)
     {
     }
 
@@ -200,28 +210,110 @@ class MessageDecoder
         return *this;
     }
 
+    /**
+     * Reads a payload pushed with MessageComposer::push_compressed,
+     * decompressing it straight into the container. The container is left
+     * empty if the payload can't be decoded.
+     */
+    MessageDecoder& read_compressed(std::vector<uint8_t>& container);
+
+    MessageDecoder& read_compressed(HostBuffer& container);
+
+    /**
+     * Reads a payload pushed with MessageComposer::push(buffer, size)
+     * without copying it. The returned memory belongs to the message.
+     */
+    const uint8_t* read_payload(size_t& size);
+
+    size_t remaining() const
+    {
+        return size_ - offset_;
+    }
+
+    /**
+     * Bytes not read yet, which belong to the message
+     */
+    const uint8_t* unread_data() const
+    {
+        return data_ + offset_;
+    }
+
   private:
-    QTcpSocket* socket_;
+    const uint8_t* data_;
+    size_t size_;
+    size_t offset_;
 
     void read_impl(char* dst, size_t read_length)
     {
-        size_t offset = 0;
-        do {
-            offset += socket_->read(dst + offset,
-                                    static_cast<qint64>(read_length - offset));
-
-            if (offset < read_length) {
-                socket_->waitForReadyRead();
-            }
-        } while (offset < read_length);
+        assert(read_length <= remaining());
+
+        // Truncated messages leave the missing bytes zeroed
+        const size_t available = std::min(read_length, remaining());
+        memcpy(dst, data_ + offset_, available);
+        memset(dst + available, 0, read_length - available);
+
+        offset_ += available;
     }
+
+    template <typename Container>
+    MessageDecoder& read_compressed_into(Container& container);
+};
+
+/**
+ * Accumulates length-prefixed messages from a device without ever blocking.
+ *
+ * Partial messages are kept in a preallocated buffer across calls, so it can
+ * be driven directly from the readyRead signal of a socket.
+ */
+class MessageStreamReader
+{
+  public:
+    MessageStreamReader();
+
+    /**
+     * Consumes the bytes currently available in the device.
+     *
+     * @return true once a complete message is buffered. It stays available
+     * until pop_message() is called.
+     */
+    bool read_available(QIODevice* device);
+
+    /**
+     * Blocking variant of read_available, for callers without an event loop.
+     *
+     * @param msecs timeout for each wait on new data
+     */
+    bool wait_for_message(QIODevice* device, int msecs);
+
+    MessageType message_type() const;
+
+    // Correlation id the message was sent with, zero if it wasn't traced
+    std::uint64_t correlation_id() const;
+
+    MessageDecoder message_decoder() const;
+
+    void pop_message();
+
+  private:
+    enum class State { ReadingLength, ReadingBody, MessageReady };
+
+    State state_;
+
+    size_t body_length_;
+    std::uint64_t correlation_id_;
+    size_t received_;
+
+    size_t capacity_;
+    std::unique_ptr<uint8_t[]> body_;
+
+    void reserve(size_t length);
 };
 
 template <> inline
 MessageComposer& MessageComposer::push<std::string>(const std::string& value)
 {
     push(value.size());
-    message_blocks_.emplace_back(new StringBlock(value));
+    append_to_arena(value.data(), value.size());
     return *this;
 }
 
@@ -236,14 +328,55 @@ MessageComposer::push<std::deque<std::string>>(const std::deque<std::string>& co
     return *this;
 }
 
+template <> inline
+MessageComposer&
+MessageComposer::push<std::vector<std::string>>(const std::vector<std::string>& container)
+{
+    push(container.size());
+    for (const auto& value : container) {
+        push(value);
+    }
+    return *this;
+}
+
+template <> inline
+MessageComposer&
+MessageComposer::push<std::vector<int>>(const std::vector<int>& container)
+{
+    push(container.size());
+    for (int value : container) {
+        push(value);
+    }
+    return *this;
+}
+
+template <> inline
+MessageComposer&
+MessageComposer::push<BufferMetadata>(const BufferMetadata& metadata)
+{
+    push(metadata.variable_name)
+        .push(metadata.display_name)
+        .push(metadata.pixel_layout)
+        .push(metadata.transpose_buffer)
+        .push(metadata.is_planar)
+        .push(metadata.width)
+        .push(metadata.height)
+        .push(metadata.channels)
+        .push(metadata.row_stride)
+        .push(metadata.type)
+        .push(metadata.tensor_shape)
+        .push(metadata.tensor_index);
+    return *this;
+}
+
 template <> inline
 MessageDecoder& MessageDecoder::read<std::vector<uint8_t>>(std::vector<uint8_t>& container)
 {
     size_t container_size;
     read(container_size);
 
-    container.resize(container_size);
-    read_impl(reinterpret_cast<char*>(container.data()), container_size);
+    container.resize(std::min(container_size, remaining()));
+    read_impl(reinterpret_cast<char*>(container.data()), container.size());
 
     return *this;
 }
@@ -254,8 +387,8 @@ MessageDecoder& MessageDecoder::read<std::string>(std::string& value)
     size_t symbol_length;
     read(symbol_length);
 
-    value.resize(symbol_length);
-    read_impl(&value.front(), static_cast<qint64>(symbol_length));
+    value.resize(std::min(symbol_length, remaining()));
+    read_impl(&value.front(), value.size());
 
     return *this;
 }
@@ -265,6 +398,7 @@ MessageDecoder& MessageDecoder::read<QString>(QString& value)
 {
     size_t symbol_length;
     read(symbol_length);
+    symbol_length = std::min(symbol_length, remaining());
 
     std::vector<char> temp_string;
     temp_string.resize(symbol_length + 1, '\0');
@@ -274,5 +408,27 @@ MessageDecoder& MessageDecoder::read<QString>(QString& value)
     return *this;
 }
 
+template <> inline
+MessageDecoder& MessageDecoder::read<BufferMetadata>(BufferMetadata& metadata)
+{
+    // The metadata of received messages may be reused
+    metadata.tensor_shape.clear();
+    metadata.tensor_index.clear();
+
+    read(metadata.variable_name)
+        .read(metadata.display_name)
+        .read(metadata.pixel_layout)
+        .read(metadata.transpose_buffer)
+        .read(metadata.is_planar)
+        .read(metadata.width)
+        .read(metadata.height)
+        .read(metadata.channels)
+        .read(metadata.row_stride)
+        .read(metadata.type)
+        .read<std::vector<int>, int>(metadata.tensor_shape)
+        .read<std::vector<int>, int>(metadata.tensor_index);
+    return *this;
+}
+
 
 #endif // IPC_MESSAGE_EXCHANGE_H_
@@ -23,43 +23,32 @@
  * IN THE SOFTWARE.
  */
 
+#include <cstring>
+
 #include "raw_data_decode.h"
 
-#include <cassert>
+#include "math/buffer_type_dispatch.h"
 
-std::vector<std::uint8_t>
-    make_float_buffer_from_double(const std::vector<std::uint8_t>& buff_double)
+ByteOrder host_byte_order()
 {
-    int element_count = buff_double.size() / sizeof(double);
-    std::vector<std::uint8_t> buff_float(element_count);
-
-    // Cast from double to float
-    const double* src = reinterpret_cast<const double*>(buff_double.data());
-    float* dst = reinterpret_cast<float*>(buff_float.data());
-    for (int i = 0; i < element_count; ++i) {
-        dst[i] = static_cast<float>(src[i]);
-    }
+    const std::uint16_t probe = 1;
+    std::uint8_t first_byte;
+    std::memcpy(&first_byte, &probe, 1);
 
-    return buff_float;
+    return first_byte == 1 ? ByteOrder::LittleEndian : ByteOrder::BigEndian;
 }
 
 
 size_t typesize(BufferType type)
 {
-    switch(type) {
-    case BufferType::Int32:
-        return sizeof(int32_t);
-    case BufferType::Short: // fall-through
-    case BufferType::UnsignedShort:
-        return sizeof(int16_t);
-    case BufferType::Float32:
-        return sizeof(float);
-    case BufferType::Float64:
-        return sizeof(double);
-    case BufferType::UnsignedByte:
-        return sizeof(std::uint8_t);
-    default:
-        assert("unknow BufferType received");
-        return sizeof(std::uint8_t);
-    }
+    return visit_value_type(type, [](auto value_type) {
+        return sizeof(typename decltype(value_type)::type);
+    });
+}
+
+
+bool is_byte_swapped(const BufferMetadata& metadata)
+{
+    return metadata.byte_order != host_byte_order() &&
+           typesize(metadata.type) > 1;
 }
@@ -29,20 +29,61 @@
 #include <cstddef> // for std::size_t
 #include <cstdint> // for std::uint8_t
 
+#include <string> // for std::string
 #include <vector> // for std::vector
 
+// Values up to Float16 match the depths of OpenCV matrices
 enum class BufferType {
     UnsignedByte  = 0,
+    Int8          = 1,
     UnsignedShort = 2,
     Short         = 3,
     Int32         = 4,
     Float32       = 5,
-    Float64       = 6
+    Float64       = 6,
+    Float16       = 7,
+    UInt32        = 8,
+    // One byte per value, either 0 or 1
+    Bool          = 9
 };
 
-std::vector<std::uint8_t>
-    make_float_buffer_from_double(const std::vector<std::uint8_t>& buff_double);
+enum class ByteOrder {
+    LittleEndian = 0,
+    BigEndian    = 1
+};
+
+ByteOrder host_byte_order();
+
+struct BufferMetadata
+{
+    std::string variable_name;
+    std::string display_name;
+    std::string pixel_layout;
+    bool transpose_buffer;
+    // Channels stored as consecutive planes of row_stride * height values,
+    // instead of interleaved in each pixel
+    bool is_planar;
+    int width;
+    int height;
+    int channels;
+    int row_stride;
+    BufferType type;
+    // Sizes of the leading axes of a tensor, outermost first, of which this
+    // buffer is the slice at tensor_index. Both are empty for plain buffers.
+    std::vector<int> tensor_shape;
+    std::vector<int> tensor_index;
+    // Byte order of the values in the memory of the debugged target. The
+    // bridge converts them to the host order while packing the buffer, so
+    // it isn't sent to the window.
+    ByteOrder byte_order = host_byte_order();
+};
 
 std::size_t typesize(BufferType type);
 
+/**
+ * True if the bytes of the buffer values must be reversed to be read by the
+ * host
+ */
+bool is_byte_swapped(const BufferMetadata& metadata);
+
 #endif // RAW_DATA_DECODE_H_
@@ -0,0 +1,118 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QByteArray>
+#include <QDir>
+#include <QLocalSocket>
+#include <QStandardPaths>
+
+#include "window_daemon.h"
+
+
+namespace
+{
+
+// Answers of the daemon to a session request
+const char session_accepted = '1';
+const char session_refused  = '0';
+
+const char server_file_name[] = "OpenImageDebugger-window-daemon";
+
+} // namespace
+
+
+QString window_daemon_server_name()
+{
+#if defined(_WIN32)
+    // Named pipes aren't files, and the daemon restricts its pipe to the
+    // current user when listening
+    return QString(server_file_name);
+#else
+    // Qt only returns a runtime directory owned by the current user and
+    // accessible to no one else, so the socket can't be taken over
+    const QString runtime_directory =
+        QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (runtime_directory.isEmpty()) {
+        return QString();
+    }
+
+    return QDir(runtime_directory).filePath(server_file_name);
+#endif
+}
+
+
+WindowDaemonAnswer request_window_daemon_session(std::uint16_t port,
+                                                 int timeout_ms)
+{
+    const QString server_name = window_daemon_server_name();
+    if (server_name.isEmpty()) {
+        return WindowDaemonAnswer::Unavailable;
+    }
+
+    QLocalSocket socket;
+    socket.connectToServer(server_name);
+    if (!socket.waitForConnected(timeout_ms)) {
+        return WindowDaemonAnswer::Unavailable;
+    }
+
+    // A daemon which doesn't answer is as good as a busy one, and leaves the
+    // session with a window of its own
+    socket.write(QByteArray::number(port) + '\n');
+    if (!socket.waitForBytesWritten(timeout_ms)) {
+        return WindowDaemonAnswer::Refused;
+    }
+
+    char answer = session_refused;
+    if (!socket.waitForReadyRead(timeout_ms) || !socket.getChar(&answer)) {
+        return WindowDaemonAnswer::Refused;
+    }
+
+    return answer == session_accepted ? WindowDaemonAnswer::Accepted
+                                      : WindowDaemonAnswer::Refused;
+}
+
+
+bool read_window_daemon_request(QLocalSocket* socket, std::uint16_t& port)
+{
+    if (!socket->canReadLine()) {
+        return false;
+    }
+
+    bool is_valid = false;
+    const unsigned int value = socket->readLine().trimmed().toUInt(&is_valid);
+    if (!is_valid || value > 0xffff) {
+        return false;
+    }
+
+    port = static_cast<std::uint16_t>(value);
+    return true;
+}
+
+
+void answer_window_daemon_request(QLocalSocket* socket, bool is_accepted)
+{
+    socket->putChar(is_accepted ? session_accepted : session_refused);
+    socket->flush();
+}
@@ -0,0 +1,77 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef IPC_WINDOW_DAEMON_H_
+#define IPC_WINDOW_DAEMON_H_
+
+#include <cstdint>
+
+#include <QString>
+
+class QLocalSocket;
+
+/*
+ * A window started in daemon mode outlives the debugging sessions, which
+ * attach to it through a local socket instead of starting a window of their
+ * own. The bridge only sends the port of its TCP server there, to which the
+ * window then connects as usual.
+ */
+
+/**
+ * Full path of the local socket the window daemon of the current user listens
+ * on, in the private runtime directory of the user. Empty if the user has
+ * none, in which case sessions can't attach to a daemon.
+ */
+QString window_daemon_server_name();
+
+enum class WindowDaemonAnswer {
+    Accepted,
+    // The daemon is serving another session
+    Refused,
+    // No daemon is running
+    Unavailable
+};
+
+/**
+ * Asks the window daemon to start a session with the bridge listening on
+ * port. Blocks for at most timeout_ms at each step of the request.
+ */
+WindowDaemonAnswer request_window_daemon_session(std::uint16_t port,
+                                                 int timeout_ms);
+
+/**
+ * Reads the session request received by the daemon. Must only be called once
+ * a whole line is available in the socket.
+ *
+ * @return false if the request is incomplete or invalid
+ */
+bool read_window_daemon_request(QLocalSocket* socket, std::uint16_t& port);
+
+/**
+ * Tells the bridge whether the daemon will connect to it
+ */
+void answer_window_daemon_request(QLocalSocket* socket, bool is_accepted);
+
+#endif // IPC_WINDOW_DAEMON_H_
@@ -0,0 +1,279 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "block_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "math/buffer_type_dispatch.h"
+#include "system/thread/thread_pool.h"
+#include "system/trace/tracer.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+// Outdated blocks smaller than this in total, in channel values, are not
+// worth splitting across threads
+const size_t min_parallel_size = 1 << 18;
+
+
+template <typename T, int Channels>
+void accumulate_values(const uint8_t* buffer,
+                       int step,
+                       size_t plane_stride,
+                       int x0,
+                       int y0,
+                       int x1,
+                       int y1,
+                       ValueStatistics& statistics)
+{
+    const T* typed_buffer = reinterpret_cast<const T*>(buffer);
+
+    const size_t pixel_stride =
+        plane_stride == 0 ? static_cast<size_t>(Channels) : 1;
+    const size_t channel_stride = plane_stride == 0 ? 1 : plane_stride;
+
+    for (int c = 0; c < Channels; ++c) {
+        float lowest        = numeric_limits<float>::max();
+        float upper         = numeric_limits<float>::lowest();
+        double sum          = 0.0;
+        size_t finite_count = 0;
+        size_t nan_count    = 0;
+
+        const T* channel_values = typed_buffer + c * channel_stride;
+        for (int y = y0; y < y1; ++y) {
+            const T* row = channel_values + y * step * pixel_stride;
+            for (int x = x0; x < x1; ++x) {
+                const float value = static_cast<float>(row[x * pixel_stride]);
+                if (std::isfinite(value)) {
+                    lowest = min(lowest, value);
+                    upper  = max(upper, value);
+                    sum += value;
+                    ++finite_count;
+                } else if (std::isnan(value)) {
+                    ++nan_count;
+                }
+            }
+        }
+
+        statistics.lowest[c]       = lowest;
+        statistics.upper[c]        = upper;
+        statistics.sum[c]          = sum;
+        statistics.finite_count[c] = finite_count;
+        statistics.nan_count[c]    = nan_count;
+    }
+}
+
+} // namespace
+
+
+ValueStatistics::ValueStatistics()
+{
+    fill_n(lowest, 4, numeric_limits<float>::max());
+    fill_n(upper, 4, numeric_limits<float>::lowest());
+    fill_n(sum, 4, 0.0);
+    fill_n(finite_count, 4, 0);
+    fill_n(nan_count, 4, 0);
+}
+
+
+void ValueStatistics::merge(const ValueStatistics& other)
+{
+    for (int c = 0; c < 4; ++c) {
+        lowest[c] = min(lowest[c], other.lowest[c]);
+        upper[c]  = max(upper[c], other.upper[c]);
+        sum[c] += other.sum[c];
+        finite_count[c] += other.finite_count[c];
+        nan_count[c] += other.nan_count[c];
+    }
+}
+
+
+void ValueStatistics::bounds(int channels,
+                             float* channel_lowest,
+                             float* channel_upper) const
+{
+    for (int c = 0; c < 4; ++c) {
+        if (c >= channels || finite_count[c] == 0) {
+            channel_lowest[c] = channel_upper[c] = 0.0f;
+        } else {
+            channel_lowest[c] = lowest[c];
+            channel_upper[c]  = upper[c];
+        }
+    }
+}
+
+
+void BlockStatistics::reset(BufferType type,
+                            int width,
+                            int height,
+                            int channels,
+                            int step,
+                            size_t plane_stride)
+{
+    type_         = type;
+    width_        = max(width, 0);
+    height_       = max(height, 0);
+    channels_     = min(max(channels, 1), 4);
+    step_         = step;
+    plane_stride_ = plane_stride;
+
+    blocks_x_ = (width_ + block_size - 1) / block_size;
+    blocks_y_ = (height_ + block_size - 1) / block_size;
+
+    const size_t num_blocks = static_cast<size_t>(blocks_x_) * blocks_y_;
+    blocks_.assign(num_blocks, ValueStatistics());
+    is_block_outdated_.assign(num_blocks, true);
+}
+
+
+void BlockStatistics::invalidate(int x, int y, int width, int height)
+{
+    const int x1 = min(x + width, width_);
+    const int y1 = min(y + height, height_);
+    x            = max(x, 0);
+    y            = max(y, 0);
+    if (x >= x1 || y >= y1) {
+        return;
+    }
+
+    for (int by = y / block_size; by <= (y1 - 1) / block_size; ++by) {
+        for (int bx = x / block_size; bx <= (x1 - 1) / block_size; ++bx) {
+            is_block_outdated_[by * blocks_x_ + bx] = true;
+        }
+    }
+}
+
+
+ValueStatistics BlockStatistics::statistics(const uint8_t* buffer)
+{
+    if (blocks_.empty()) {
+        return ValueStatistics();
+    }
+
+    return merge_blocks(buffer, 0, 0, blocks_x_ - 1, blocks_y_ - 1);
+}
+
+
+ValueStatistics BlockStatistics::region_statistics(const uint8_t* buffer,
+                                                   int x,
+                                                   int y,
+                                                   int width,
+                                                   int height)
+{
+    const int x1 = min(x + width, width_);
+    const int y1 = min(y + height, height_);
+    x            = max(x, 0);
+    y            = max(y, 0);
+    if (x >= x1 || y >= y1) {
+        return ValueStatistics();
+    }
+
+    return merge_blocks(buffer,
+                        x / block_size,
+                        y / block_size,
+                        (x1 - 1) / block_size,
+                        (y1 - 1) / block_size);
+}
+
+
+ValueStatistics BlockStatistics::merge_blocks(const uint8_t* buffer,
+                                              int first_bx,
+                                              int first_by,
+                                              int last_bx,
+                                              int last_by)
+{
+    vector<int> outdated_blocks;
+    for (int by = first_by; by <= last_by; ++by) {
+        for (int bx = first_bx; bx <= last_bx; ++bx) {
+            const int block_index = by * blocks_x_ + bx;
+            if (is_block_outdated_[block_index]) {
+                outdated_blocks.push_back(block_index);
+            }
+        }
+    }
+
+    if (!outdated_blocks.empty()) {
+        TraceSpan span("compute_block_statistics");
+
+        const size_t size = outdated_blocks.size() * block_size * block_size *
+                            static_cast<size_t>(channels_);
+        const auto compute_blocks = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                compute_block(buffer, outdated_blocks[i]);
+            }
+        };
+
+        // Each block is written by a single thread
+        if (size < min_parallel_size) {
+            compute_blocks(0, outdated_blocks.size());
+        } else {
+            ThreadPool::instance().parallel_for(outdated_blocks.size(),
+                                                compute_blocks);
+        }
+
+        for (const int block_index : outdated_blocks) {
+            is_block_outdated_[block_index] = false;
+        }
+    }
+
+    ValueStatistics statistics;
+    for (int by = first_by; by <= last_by; ++by) {
+        for (int bx = first_bx; bx <= last_bx; ++bx) {
+            statistics.merge(blocks_[by * blocks_x_ + bx]);
+        }
+    }
+
+    return statistics;
+}
+
+
+void BlockStatistics::compute_block(const uint8_t* buffer, int block_index)
+{
+    const int x0 = (block_index % blocks_x_) * block_size;
+    const int y0 = (block_index / blocks_x_) * block_size;
+    const int x1 = min(x0 + block_size, width_);
+    const int y1 = min(y0 + block_size, height_);
+
+    visit_held_value_layout(
+        type_, channels_, [&](auto value_type, auto channel_count) {
+            using T = typename decltype(value_type)::type;
+            accumulate_values<T, decltype(channel_count)::value>(
+                buffer,
+                step_,
+                plane_stride_,
+                x0,
+                y0,
+                x1,
+                y1,
+                blocks_[block_index]);
+        });
+}
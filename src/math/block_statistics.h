@@ -0,0 +1,141 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef BLOCK_STATISTICS_H_
+#define BLOCK_STATISTICS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ipc/raw_data_decode.h"
+
+/**
+ * Statistics of the values of each channel of a buffer region. Infinite and
+ * NaN values are left out of the bounds and of the sum.
+ */
+struct ValueStatistics
+{
+    float lowest[4];
+    float upper[4];
+    double sum[4];
+    std::size_t finite_count[4];
+    std::size_t nan_count[4];
+
+    /**
+     * Statistics of an empty region
+     */
+    ValueStatistics();
+
+    void merge(const ValueStatistics& other);
+
+    /**
+     * Bounds of the values, with 0 as both bounds of channels without any
+     * finite value, as given by compute_min_max
+     */
+    void bounds(int channels, float* lowest, float* upper) const;
+};
+
+
+/**
+ * Index of the value statistics of a buffer, split in square blocks.
+ *
+ * Blocks are outdated when their contents change, and only those are read
+ * again when statistics are requested. Any statistics after a partial update
+ * of the buffer thus cost in proportion to the changed blocks, plus a merge of
+ * the statistics of the blocks involved.
+ */
+class BlockStatistics
+{
+  public:
+    static const int block_size = 128;
+
+    /**
+     * Sets the geometry of the buffer described by the index, outdating all
+     * blocks. The buffer contents are given to each query, as they may be
+     * moved in memory in the meantime.
+     *
+     * Float64 buffers are expected to have been converted to Float32, as
+     * done by the UI when the buffer is received.
+     *
+     * @param step  Distance between the buffer rows, in pixels
+     * @param plane_stride  Distance between the channel planes of planar
+     *     buffers, in values; 0 if the channels are interleaved
+     */
+    void reset(BufferType type,
+               int width,
+               int height,
+               int channels,
+               int step,
+               std::size_t plane_stride);
+
+    /**
+     * Outdates the blocks intersecting the given region
+     */
+    void invalidate(int x, int y, int width, int height);
+
+    /**
+     * Statistics of the whole buffer
+     */
+    ValueStatistics statistics(const uint8_t* buffer);
+
+    /**
+     * Statistics of the blocks intersecting the given region, which may thus
+     * include values around it
+     */
+    ValueStatistics region_statistics(const uint8_t* buffer,
+                                      int x,
+                                      int y,
+                                      int width,
+                                      int height);
+
+  private:
+    /**
+     * Computes the outdated blocks in the given range of blocks, and merges
+     * the statistics of all of them
+     */
+    ValueStatistics merge_blocks(const uint8_t* buffer,
+                                 int first_bx,
+                                 int first_by,
+                                 int last_bx,
+                                 int last_by);
+
+    void compute_block(const uint8_t* buffer, int block_index);
+
+    BufferType type_          = BufferType::UnsignedByte;
+    int width_                = 0;
+    int height_               = 0;
+    int channels_             = 0;
+    int step_                 = 0;
+    std::size_t plane_stride_ = 0;
+
+    int blocks_x_ = 0;
+    int blocks_y_ = 0;
+
+    std::vector<ValueStatistics> blocks_;
+    std::vector<bool> is_block_outdated_;
+};
+
+#endif // BLOCK_STATISTICS_H_
@@ -0,0 +1,179 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef BUFFER_TYPE_DISPATCH_H_
+#define BUFFER_TYPE_DISPATCH_H_
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "ipc/raw_data_decode.h"
+#include "math/half_float.h"
+
+/**
+ * Tag naming the C++ type of the values of a buffer, passed to the visitors
+ */
+template <typename T>
+struct ValueType
+{
+    using type = T;
+};
+
+
+/**
+ * Tag with the number of channels of a buffer, passed to the visitors
+ */
+template <int Channels>
+using ChannelCount = std::integral_constant<int, Channels>;
+
+
+/**
+ * Calls visitor(ValueType<T>()) with the C++ type of the values of buffers of
+ * the given type, as sent by the bridge.
+ *
+ * Code reading the buffer values dispatches once per buffer, or per block of
+ * values, to a kernel instantiated for each type, so that its loops don't
+ * branch on the type. New buffer types only need a case here.
+ *
+ * @return  The result of the visitor, which must be of the same type for all
+ *     value types
+ */
+template <typename Visitor>
+auto visit_value_type(BufferType type, Visitor&& visitor)
+    -> decltype(visitor(ValueType<uint8_t>()))
+{
+    switch (type) {
+    case BufferType::UnsignedByte: // fall-through
+    case BufferType::Bool:
+        return visitor(ValueType<uint8_t>());
+    case BufferType::Int8:
+        return visitor(ValueType<int8_t>());
+    case BufferType::UnsignedShort:
+        return visitor(ValueType<uint16_t>());
+    case BufferType::Short:
+        return visitor(ValueType<int16_t>());
+    case BufferType::Int32:
+        return visitor(ValueType<int32_t>());
+    case BufferType::UInt32:
+        return visitor(ValueType<uint32_t>());
+    case BufferType::Float16:
+        return visitor(ValueType<HalfFloat>());
+    case BufferType::Float64:
+        return visitor(ValueType<double>());
+    case BufferType::Float32:
+        break;
+    }
+
+    return visitor(ValueType<float>());
+}
+
+
+/**
+ * Type of the values of buffers of the given type as held by the UI, which
+ * converts Float64 buffers to Float32 when they are received
+ */
+inline BufferType held_buffer_type(BufferType type)
+{
+    return type == BufferType::Float64 ? BufferType::Float32 : type;
+}
+
+
+/**
+ * Same as visit_value_type, with the types of the values held by the UI
+ */
+template <typename Visitor>
+auto visit_held_value_type(BufferType type, Visitor&& visitor)
+    -> decltype(visitor(ValueType<uint8_t>()))
+{
+    return visit_value_type(held_buffer_type(type),
+                            std::forward<Visitor>(visitor));
+}
+
+
+/**
+ * Calls visitor(ValueType<T>(), ChannelCount<C>()) with the held value type
+ * of the buffer type and its number of channels, clamped to [1, 4]
+ */
+template <typename Visitor>
+auto visit_held_value_layout(BufferType type, int channels, Visitor&& visitor)
+    -> decltype(visitor(ValueType<uint8_t>(), ChannelCount<1>()))
+{
+    return visit_held_value_type(type, [&](auto value_type) {
+        if (channels <= 1) {
+            return visitor(value_type, ChannelCount<1>());
+        } else if (channels == 2) {
+            return visitor(value_type, ChannelCount<2>());
+        } else if (channels == 3) {
+            return visitor(value_type, ChannelCount<3>());
+        }
+
+        return visitor(value_type, ChannelCount<4>());
+    });
+}
+
+
+/**
+ * Value of type T sampled as 1 from normalized textures: the largest value
+ * of integer types, and 1 for floating point types
+ */
+template <typename T>
+float normalized_value_scale()
+{
+    return std::numeric_limits<T>::is_integer
+               ? static_cast<float>(std::numeric_limits<T>::max())
+               : 1.0f;
+}
+
+
+/**
+ * Value as written to streams: 8 bit integers as numbers rather than as
+ * characters, and half floats as floats
+ */
+template <typename T>
+T printable_value(T value)
+{
+    return value;
+}
+
+
+inline int printable_value(uint8_t value)
+{
+    return value;
+}
+
+
+inline int printable_value(int8_t value)
+{
+    return value;
+}
+
+
+inline float printable_value(HalfFloat value)
+{
+    return value;
+}
+
+#endif // BUFFER_TYPE_DISPATCH_H_
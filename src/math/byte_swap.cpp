@@ -0,0 +1,292 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "byte_swap.h"
+
+#include <cstring>
+
+// The SSSE3 kernel is built regardless of the flags of the build, and only
+// run once the CPU is known to support it
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define OID_SSSE3_KERNEL
+#define OID_SSSE3_TARGET __attribute__((target("ssse3")))
+#include <tmmintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "system/thread/thread_pool.h"
+#include "system/trace/tracer.h"
+
+
+namespace
+{
+
+// Copies smaller than this, in bytes, are not worth splitting across threads
+const std::size_t min_parallel_size = 1 << 20;
+
+
+#if defined(OID_SSSE3_KERNEL)
+bool is_ssse3_supported()
+{
+#if defined(__SSSE3__)
+    return true;
+#else
+    static const bool is_supported = __builtin_cpu_supports("ssse3");
+    return is_supported;
+#endif
+}
+
+
+// Reverses the bytes of each value of a block of 16 bytes, by shuffling them
+// from the index of their source byte
+template <std::size_t ValueSize>
+OID_SSSE3_TARGET __m128i reverse_value_bytes(__m128i block);
+
+
+template <>
+OID_SSSE3_TARGET __m128i reverse_value_bytes<2>(__m128i block)
+{
+    return _mm_shuffle_epi8(
+        block,
+        _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));
+}
+
+
+template <>
+OID_SSSE3_TARGET __m128i reverse_value_bytes<4>(__m128i block)
+{
+    return _mm_shuffle_epi8(
+        block,
+        _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+}
+
+
+template <>
+OID_SSSE3_TARGET __m128i reverse_value_bytes<8>(__m128i block)
+{
+    return _mm_shuffle_epi8(
+        block,
+        _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8));
+}
+
+
+// Swaps the whole blocks of 16 bytes, returning the number of bytes swapped
+template <std::size_t ValueSize>
+OID_SSSE3_TARGET std::size_t swap_blocks(const std::uint8_t* src,
+                                         std::size_t length,
+                                         std::uint8_t* dst)
+{
+    std::size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        const __m128i block =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                         reverse_value_bytes<ValueSize>(block));
+    }
+
+    return i;
+}
+#elif defined(__ARM_NEON)
+template <std::size_t ValueSize>
+uint8x16_t reverse_value_bytes(uint8x16_t block);
+
+
+template <>
+uint8x16_t reverse_value_bytes<2>(uint8x16_t block)
+{
+    return vrev16q_u8(block);
+}
+
+
+template <>
+uint8x16_t reverse_value_bytes<4>(uint8x16_t block)
+{
+    return vrev32q_u8(block);
+}
+
+
+template <>
+uint8x16_t reverse_value_bytes<8>(uint8x16_t block)
+{
+    return vrev64q_u8(block);
+}
+#endif
+
+
+// Unsigned integer of each value size, whose bytes are reversed at once
+template <std::size_t ValueSize>
+struct SwappedInteger;
+
+
+template <>
+struct SwappedInteger<2>
+{
+    using type = std::uint16_t;
+
+    static type reverse(type value)
+    {
+        return static_cast<type>((value << 8) | (value >> 8));
+    }
+};
+
+
+template <>
+struct SwappedInteger<4>
+{
+    using type = std::uint32_t;
+
+    static type reverse(type value)
+    {
+#if defined(__GNUC__)
+        return __builtin_bswap32(value);
+#else
+        return (value << 24) | ((value & 0xff00u) << 8) |
+               ((value >> 8) & 0xff00u) | (value >> 24);
+#endif
+    }
+};
+
+
+template <>
+struct SwappedInteger<8>
+{
+    using type = std::uint64_t;
+
+    static type reverse(type value)
+    {
+#if defined(__GNUC__)
+        return __builtin_bswap64(value);
+#else
+        const std::uint32_t low  = static_cast<std::uint32_t>(value);
+        const std::uint32_t high = static_cast<std::uint32_t>(value >> 32);
+
+        return (static_cast<type>(SwappedInteger<4>::reverse(low)) << 32) |
+               SwappedInteger<4>::reverse(high);
+#endif
+    }
+};
+
+
+template <std::size_t ValueSize>
+void swap_values(const std::uint8_t* src, std::size_t length, std::uint8_t* dst)
+{
+    std::size_t i = 0;
+
+#if defined(OID_SSSE3_KERNEL)
+    if (is_ssse3_supported()) {
+        i = swap_blocks<ValueSize>(src, length, dst);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= length; i += 16) {
+        vst1q_u8(dst + i, reverse_value_bytes<ValueSize>(vld1q_u8(src + i)));
+    }
+#endif
+
+    // Each value is read whole before being written, so that the copy can
+    // be made in place
+    using Integer = SwappedInteger<ValueSize>;
+    for (; i + ValueSize <= length; i += ValueSize) {
+        typename Integer::type value;
+        std::memcpy(&value, src + i, ValueSize);
+        value = Integer::reverse(value);
+        std::memcpy(dst + i, &value, ValueSize);
+    }
+}
+
+
+void swap_range(const std::uint8_t* src,
+                std::size_t value_size,
+                std::size_t length,
+                std::uint8_t* dst)
+{
+    if (value_size == 2) {
+        swap_values<2>(src, length, dst);
+    } else if (value_size == 4) {
+        swap_values<4>(src, length, dst);
+    } else if (value_size == 8) {
+        swap_values<8>(src, length, dst);
+    } else if (src != dst) {
+        std::memcpy(dst, src, length);
+    }
+}
+
+} // namespace
+
+
+void copy_swapping_bytes(const std::uint8_t* src,
+                         std::size_t value_size,
+                         std::size_t count,
+                         std::uint8_t* dst)
+{
+    TraceSpan span("copy_swapping_bytes");
+
+    const std::size_t length = count * value_size;
+    if (length < min_parallel_size) {
+        swap_range(src, value_size, length, dst);
+        return;
+    }
+
+    ThreadPool::instance().parallel_for(
+        count, [&](std::size_t begin, std::size_t end) {
+            swap_range(src + begin * value_size,
+                       value_size,
+                       (end - begin) * value_size,
+                       dst + begin * value_size);
+        });
+}
+
+
+void copy_region_swapping_bytes(const std::uint8_t* src,
+                                std::size_t src_pitch,
+                                std::uint8_t* dst,
+                                std::size_t dst_pitch,
+                                const BufferRegion& region,
+                                std::size_t pixel_size,
+                                std::size_t value_size)
+{
+    TraceSpan span("copy_region_swapping_bytes");
+
+    const std::size_t row_length =
+        static_cast<std::size_t>(region.width) * pixel_size;
+
+    const auto swap_rows = [&](std::size_t row_begin, std::size_t row_end) {
+        for (std::size_t y = row_begin; y < row_end; ++y) {
+            swap_range(src + y * src_pitch,
+                       value_size,
+                       row_length,
+                       dst + y * dst_pitch);
+        }
+    };
+
+    const std::size_t rows = static_cast<std::size_t>(region.height);
+    if (row_length * rows < min_parallel_size) {
+        swap_rows(0, rows);
+        return;
+    }
+
+    ThreadPool::instance().parallel_for(rows, swap_rows);
+}
@@ -0,0 +1,61 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef BYTE_SWAP_H_
+#define BYTE_SWAP_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ipc/buffer_tiles.h"
+
+/**
+ * Copies count values of value_size bytes (1, 2, 4 or 8), reversing the
+ * order of the bytes of each one, with SSSE3 or NEON where available. src and
+ * dst may be the same buffer. Large copies are split across the threads of
+ * the pool.
+ */
+void copy_swapping_bytes(const std::uint8_t* src,
+                         std::size_t value_size,
+                         std::size_t count,
+                         std::uint8_t* dst);
+
+/**
+ * Same as copy_buffer_region, reversing the bytes of each value of
+ * value_size bytes on the way
+ *
+ * @param src_pitch  Distance between the source rows, in bytes
+ * @param dst_pitch  Distance between the destination rows, in bytes
+ * @param pixel_size  Size of each pixel of the region, in bytes
+ */
+void copy_region_swapping_bytes(const std::uint8_t* src,
+                                std::size_t src_pitch,
+                                std::uint8_t* dst,
+                                std::size_t dst_pitch,
+                                const BufferRegion& region,
+                                std::size_t pixel_size,
+                                std::size_t value_size);
+
+#endif // BYTE_SWAP_H_
@@ -0,0 +1,291 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "downsample.h"
+
+#include "math/buffer_type_dispatch.h"
+#include "math/half_float.h"
+#include "system/thread/thread_pool.h"
+
+using namespace std;
+
+
+namespace
+{
+
+// Output rows processed by a single thread
+const size_t min_rows_per_task = 16;
+
+
+template <typename T>
+bool is_finite(T value)
+{
+    return std::isfinite(static_cast<double>(value));
+}
+
+
+template <typename T>
+T round_to(double value)
+{
+    return static_cast<T>(std::round(value));
+}
+
+
+template <>
+float round_to<float>(double value)
+{
+    return static_cast<float>(value);
+}
+
+
+template <>
+double round_to<double>(double value)
+{
+    return value;
+}
+
+
+template <>
+HalfFloat round_to<HalfFloat>(double value)
+{
+    return HalfFloat(static_cast<float>(value));
+}
+
+
+template <typename T>
+void downsample_rows(const T* buffer,
+                     int width,
+                     int height,
+                     int channels,
+                     int step,
+                     int out_width,
+                     int out_height,
+                     DownsampleFilter filter,
+                     size_t row_begin,
+                     size_t row_end,
+                     T* output)
+{
+    for (size_t out_y = row_begin; out_y < row_end; ++out_y) {
+        // Integer block bounds cover every input pixel exactly once, with
+        // blocks one pixel larger where the dimensions aren't multiples
+        const int y_begin = static_cast<int>(out_y * height / out_height);
+        const int y_end   = static_cast<int>((out_y + 1) * height / out_height);
+
+        T* out_row = output + out_y * out_width * channels;
+
+        const size_t row_stride = static_cast<size_t>(step) * channels;
+
+        for (int out_x = 0; out_x < out_width; ++out_x) {
+            const int x_begin = out_x * width / out_width;
+            const int x_end   = (out_x + 1) * width / out_width;
+
+            const T* block =
+                buffer +
+                (static_cast<size_t>(y_begin) * step + x_begin) * channels;
+
+            for (int c = 0; c < channels; ++c) {
+                double sum = 0.0;
+                int count  = 0;
+
+                for (int y = 0; y < y_end - y_begin; ++y) {
+                    const T* row = block + y * row_stride;
+                    for (int x = 0; x < x_end - x_begin; ++x) {
+                        const T value = row[x * channels + c];
+                        if (is_finite(value)) {
+                            sum += static_cast<double>(value);
+                            ++count;
+                        }
+                    }
+                }
+
+                T& result = out_row[out_x * channels + c];
+
+                if (count == 0) {
+                    result = block[c];
+                    continue;
+                }
+
+                const double mean = sum / count;
+
+                if (filter == DownsampleFilter::Average) {
+                    result = round_to<T>(mean);
+                    continue;
+                }
+
+                double farthest_distance = -1.0;
+                for (int y = 0; y < y_end - y_begin; ++y) {
+                    const T* row = block + y * row_stride;
+                    for (int x = 0; x < x_end - x_begin; ++x) {
+                        const T value = row[x * channels + c];
+                        const double distance =
+                            std::abs(static_cast<double>(value) - mean);
+                        if (is_finite(value) && distance > farthest_distance) {
+                            farthest_distance = distance;
+                            result            = value;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+template <typename T>
+void downsample_typed(const uint8_t* buffer,
+                      int width,
+                      int height,
+                      int channels,
+                      int step,
+                      int out_width,
+                      int out_height,
+                      DownsampleFilter filter,
+                      uint8_t* output)
+{
+    const T* typed_buffer = reinterpret_cast<const T*>(buffer);
+    T* typed_output       = reinterpret_cast<T*>(output);
+
+    const size_t rows = static_cast<size_t>(out_height);
+
+    if (rows < 2 * min_rows_per_task) {
+        downsample_rows(typed_buffer,
+                        width,
+                        height,
+                        channels,
+                        step,
+                        out_width,
+                        out_height,
+                        filter,
+                        0,
+                        rows,
+                        typed_output);
+        return;
+    }
+
+    // Output rows are independent, so no synchronization is needed
+    ThreadPool::instance().parallel_for(
+        rows, [&](size_t row_begin, size_t row_end) {
+            downsample_rows(typed_buffer,
+                            width,
+                            height,
+                            channels,
+                            step,
+                            out_width,
+                            out_height,
+                            filter,
+                            row_begin,
+                            row_end,
+                            typed_output);
+        });
+}
+
+} // namespace
+
+
+void downsample(const uint8_t* buffer,
+                BufferType type,
+                int width,
+                int height,
+                int channels,
+                int step,
+                int out_width,
+                int out_height,
+                DownsampleFilter filter,
+                uint8_t* output)
+{
+    if (width <= 0 || height <= 0 || out_width <= 0 || out_height <= 0) {
+        return;
+    }
+
+    visit_value_type(type, [&](auto value_type) {
+        using T = typename decltype(value_type)::type;
+        downsample_typed<T>(buffer,
+                            width,
+                            height,
+                            channels,
+                            step,
+                            out_width,
+                            out_height,
+                            filter,
+                            output);
+    });
+}
+
+
+void upsample(const uint8_t* buffer,
+              int width,
+              int height,
+              size_t pixel_size,
+              int out_width,
+              int out_height,
+              int out_step,
+              uint8_t* output)
+{
+    if (width <= 0 || height <= 0 || out_width <= 0 || out_height <= 0) {
+        return;
+    }
+
+    const size_t out_pitch = static_cast<size_t>(out_step) * pixel_size;
+    const size_t in_pitch  = static_cast<size_t>(width) * pixel_size;
+
+    // Inverse of the block bounds used by downsample, so that each output
+    // pixel takes the value of the block that covered it
+    vector<size_t> source_offsets(static_cast<size_t>(out_width));
+    for (int x = 0; x < out_width; ++x) {
+        source_offsets[static_cast<size_t>(x)] =
+            static_cast<size_t>(
+                (static_cast<int64_t>(x) * width + width - 1) / out_width) *
+            pixel_size;
+    }
+
+    const auto upsample_rows = [&](size_t row_begin, size_t row_end) {
+        for (size_t y = row_begin; y < row_end; ++y) {
+            const uint8_t* in_row =
+                buffer + static_cast<size_t>(
+                             (static_cast<int64_t>(y) * height + height - 1) /
+                             out_height) *
+                             in_pitch;
+            uint8_t* out_row = output + y * out_pitch;
+
+            for (size_t x = 0; x < source_offsets.size(); ++x) {
+                memcpy(out_row + x * pixel_size,
+                       in_row + source_offsets[x],
+                       pixel_size);
+            }
+        }
+    };
+
+    const size_t rows = static_cast<size_t>(out_height);
+    if (rows < 2 * min_rows_per_task) {
+        upsample_rows(0, rows);
+        return;
+    }
+
+    ThreadPool::instance().parallel_for(rows, upsample_rows);
+}
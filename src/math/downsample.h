@@ -0,0 +1,79 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef DOWNSAMPLE_H_
+#define DOWNSAMPLE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ipc/raw_data_decode.h"
+
+
+enum class DownsampleFilter {
+    // Mean of the pixels covered by each output pixel
+    Average,
+    // Value of the covered pixel farthest from their mean, so that isolated
+    // bright and dark pixels survive the reduction
+    Extremum
+};
+
+/**
+ * Reduces a buffer to the given dimensions, each output pixel covering a
+ * block of the input. Infinite and NaN values are ignored unless all values
+ * of a block are.
+ *
+ * @param step  Distance between the buffer rows, in pixels
+ * @param output  Receives out_width * out_height tightly packed pixels, of
+ *                the same type and channels as the buffer
+ */
+void downsample(const uint8_t* buffer,
+                BufferType type,
+                int width,
+                int height,
+                int channels,
+                int step,
+                int out_width,
+                int out_height,
+                DownsampleFilter filter,
+                uint8_t* output);
+
+/**
+ * Enlarges a tightly packed buffer to the given dimensions by replicating
+ * its pixels, each of them filling the block it was reduced from by
+ * downsample
+ *
+ * @param out_step  Distance between the output rows, in pixels
+ */
+void upsample(const uint8_t* buffer,
+              int width,
+              int height,
+              size_t pixel_size,
+              int out_width,
+              int out_height,
+              int out_step,
+              uint8_t* output);
+
+#endif // DOWNSAMPLE_H_
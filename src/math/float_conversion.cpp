@@ -0,0 +1,197 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "float_conversion.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "system/thread/thread_pool.h"
+#include "system/trace/tracer.h"
+
+
+namespace
+{
+
+// Conversions smaller than this, in values, are not worth splitting across
+// threads
+const std::size_t min_parallel_size = 1 << 18;
+
+
+void convert_doubles(const double* src, std::size_t count, float* dst)
+{
+    std::size_t i = 0;
+
+#if defined(__AVX__)
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(dst + i, _mm256_cvtpd_ps(_mm256_loadu_pd(src + i)));
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+        const __m128 low  = _mm_cvtpd_ps(_mm_loadu_pd(src + i));
+        const __m128 high = _mm_cvtpd_ps(_mm_loadu_pd(src + i + 2));
+        _mm_storeu_ps(dst + i, _mm_movelh_ps(low, high));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= count; i += 4) {
+        const float32x2_t low = vcvt_f32_f64(vld1q_f64(src + i));
+        vst1q_f32(dst + i, vcvt_high_f32_f64(low, vld1q_f64(src + i + 2)));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        dst[i] = static_cast<float>(src[i]);
+    }
+}
+
+
+void convert_ints(const int32_t* src, std::size_t count, float* dst)
+{
+    std::size_t i = 0;
+
+#if defined(__AVX__)
+    for (; i + 8 <= count; i += 8) {
+        const __m256i values =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtepi32_ps(values));
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+        const __m128i values =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_ps(dst + i, _mm_cvtepi32_ps(values));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(dst + i, vcvtq_f32_s32(vld1q_s32(src + i)));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        dst[i] = static_cast<float>(src[i]);
+    }
+}
+
+
+void convert_uints(const uint32_t* src, std::size_t count, float* dst)
+{
+    // Without an unsigned conversion instruction, the loop is left to the
+    // compiler's vectorizer
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] = static_cast<float>(src[i]);
+    }
+}
+
+
+void convert_range(const std::uint8_t* src,
+                   BufferType type,
+                   std::size_t count,
+                   float* dst)
+{
+    if (type == BufferType::Float64) {
+        convert_doubles(reinterpret_cast<const double*>(src), count, dst);
+    } else if (type == BufferType::Int32) {
+        convert_ints(reinterpret_cast<const int32_t*>(src), count, dst);
+    } else if (type == BufferType::UInt32) {
+        convert_uints(reinterpret_cast<const uint32_t*>(src), count, dst);
+    }
+}
+
+} // namespace
+
+
+void convert_to_float(const std::uint8_t* src,
+                      BufferType type,
+                      std::size_t count,
+                      float* dst)
+{
+    if (count < min_parallel_size) {
+        convert_range(src, type, count, dst);
+        return;
+    }
+
+    const std::size_t value_size = typesize(type);
+
+    ThreadPool::instance().parallel_for(
+        count, [&](std::size_t begin, std::size_t end) {
+            convert_range(
+                src + begin * value_size, type, end - begin, dst + begin);
+        });
+}
+
+
+HostBuffer make_float_buffer(const std::uint8_t* src,
+                             BufferType type,
+                             std::size_t length)
+{
+    TraceSpan span("make_float_buffer");
+
+    const std::size_t count = length / typesize(type);
+    HostBuffer buffer(count * sizeof(float));
+
+    convert_to_float(
+        src, type, count, reinterpret_cast<float*>(buffer.data()));
+
+    return buffer;
+}
+
+
+void convert_region_to_float(const std::uint8_t* src,
+                             std::size_t src_pitch,
+                             std::uint8_t* dst,
+                             std::size_t dst_pitch,
+                             const BufferRegion& region,
+                             int channels,
+                             BufferType type)
+{
+    const std::size_t row_values =
+        static_cast<std::size_t>(region.width) * channels;
+
+    const auto convert_rows = [&](std::size_t row_begin, std::size_t row_end) {
+        for (std::size_t y = row_begin; y < row_end; ++y) {
+            convert_range(src + y * src_pitch,
+                          type,
+                          row_values,
+                          reinterpret_cast<float*>(dst + y * dst_pitch));
+        }
+    };
+
+    const std::size_t rows = static_cast<std::size_t>(region.height);
+    if (row_values * rows < min_parallel_size) {
+        convert_rows(0, rows);
+        return;
+    }
+
+    ThreadPool::instance().parallel_for(rows, convert_rows);
+}
@@ -0,0 +1,69 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FLOAT_CONVERSION_H_
+#define FLOAT_CONVERSION_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ipc/buffer_tiles.h"
+#include "ipc/raw_data_decode.h"
+#include "system/memory/host_buffer_pool.h"
+
+/**
+ * Converts count Float64, Int32 or UInt32 values to float, with SSE2/AVX or
+ * NEON where available. Large conversions are split across the threads of
+ * the pool. Values of other types are left untouched.
+ */
+void convert_to_float(const std::uint8_t* src,
+                      BufferType type,
+                      std::size_t count,
+                      float* dst);
+
+/**
+ * Float copy of a Float64, Int32 or UInt32 buffer of the given length, in
+ * bytes
+ */
+HostBuffer make_float_buffer(const std::uint8_t* src,
+                             BufferType type,
+                             std::size_t length);
+
+/**
+ * Converts a region of a Float64, Int32 or UInt32 buffer into the same
+ * region of its float copy
+ *
+ * @param src_pitch  Distance between the source rows, in bytes
+ * @param dst_pitch  Distance between the destination rows, in bytes
+ */
+void convert_region_to_float(const std::uint8_t* src,
+                             std::size_t src_pitch,
+                             std::uint8_t* dst,
+                             std::size_t dst_pitch,
+                             const BufferRegion& region,
+                             int channels,
+                             BufferType type);
+
+#endif // FLOAT_CONVERSION_H_
@@ -0,0 +1,159 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef HALF_FLOAT_H_
+#define HALF_FLOAT_H_
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+/**
+ * IEEE 754 half precision value, as stored in Float16 buffers. Converts to
+ * and from float, so that the typed kernels can process it like the other
+ * buffer types.
+ */
+struct HalfFloat
+{
+    HalfFloat() = default;
+
+    explicit HalfFloat(float value)
+        : bits{from_float(value)}
+    {
+    }
+
+    operator float() const
+    {
+        return to_float(bits);
+    }
+
+    static HalfFloat from_bits(std::uint16_t value)
+    {
+        HalfFloat result;
+        result.bits = value;
+        return result;
+    }
+
+    static float to_float(std::uint16_t value)
+    {
+        const std::uint32_t sign     = (value & 0x8000u) << 16;
+        const std::uint32_t exponent = (value >> 10) & 0x1Fu;
+        const std::uint32_t mantissa = value & 0x3FFu;
+
+        std::uint32_t result;
+        if (exponent == 0) {
+            // Zero or subnormal, exactly representable as float
+            const float magnitude = static_cast<float>(mantissa) / 16777216.f;
+            return sign != 0 ? -magnitude : magnitude;
+        } else if (exponent == 0x1F) {
+            result = sign | 0x7F800000u | (mantissa << 13);
+        } else {
+            result = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        }
+
+        float output;
+        std::memcpy(&output, &result, sizeof(output));
+        return output;
+    }
+
+    // Rounds to the nearest half, ties to even
+    static std::uint16_t from_float(float value)
+    {
+        std::uint32_t input;
+        std::memcpy(&input, &value, sizeof(input));
+
+        const std::uint16_t sign =
+            static_cast<std::uint16_t>((input >> 16) & 0x8000u);
+        const int exponent     = static_cast<int>((input >> 23) & 0xFFu);
+        std::uint32_t mantissa = input & 0x7FFFFFu;
+
+        if (exponent == 0xFF) {
+            // Infinity, or a NaN which must stay one
+            return sign | 0x7C00u | (mantissa != 0 ? 0x200u : 0u);
+        }
+
+        const int half_exponent = exponent - 127 + 15;
+        if (half_exponent >= 0x1F) {
+            return sign | 0x7C00u;
+        }
+
+        int shift;
+        std::uint32_t result;
+        if (half_exponent <= 0) {
+            if (half_exponent < -10) {
+                return sign;
+            }
+            mantissa |= 0x800000u;
+            shift  = 14 - half_exponent;
+            result = mantissa >> shift;
+        } else {
+            shift  = 13;
+            result = (static_cast<std::uint32_t>(half_exponent) << 10) |
+                     (mantissa >> shift);
+        }
+
+        // Carries into the exponent, up to infinity, are the correct result
+        const std::uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const std::uint32_t halfway   = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (result & 1))) {
+            ++result;
+        }
+
+        return static_cast<std::uint16_t>(sign | result);
+    }
+
+    std::uint16_t bits;
+};
+
+static_assert(sizeof(HalfFloat) == sizeof(std::uint16_t),
+              "Float16 buffers are arrays of HalfFloat");
+
+
+namespace std
+{
+
+// Bounds used by the reductions over typed buffers
+template <>
+class numeric_limits<HalfFloat>
+{
+  public:
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed      = true;
+    static constexpr bool is_integer     = false;
+
+    static HalfFloat max()
+    {
+        return HalfFloat::from_bits(0x7BFFu);
+    }
+
+    static HalfFloat lowest()
+    {
+        return HalfFloat::from_bits(0xFBFFu);
+    }
+};
+
+} // namespace std
+
+#endif // HALF_FLOAT_H_
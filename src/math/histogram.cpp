@@ -0,0 +1,291 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <mutex>
+
+#include "math/buffer_type_dispatch.h"
+#include "math/half_float.h"
+#include "math/value_kernels.h"
+#include "system/thread/thread_pool.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+template <typename T, int Channels>
+void fill_bins(const T* buffer,
+               const ValueLayout& layout,
+               size_t row_begin,
+               size_t row_end,
+               const float* lowest,
+               const float* scale,
+               vector<uint32_t>* bins)
+{
+    const size_t pixel_stride =
+        layout.plane_stride == 0 ? static_cast<size_t>(Channels) : 1;
+    const size_t channel_stride =
+        layout.plane_stride == 0 ? 1 : layout.plane_stride;
+
+    for (size_t y = row_begin; y < row_end; ++y) {
+        const T* row = buffer + y * layout.step * pixel_stride;
+        for (int x = 0; x < layout.width; ++x) {
+            for (int c = 0; c < Channels; ++c) {
+                const T value = row[x * pixel_stride + c * channel_stride];
+                if (!is_finite(value)) {
+                    continue;
+                }
+
+                const int last_bin = static_cast<int>(bins[c].size()) - 1;
+                const int bin      = static_cast<int>(
+                    (static_cast<float>(value) - lowest[c]) * scale[c]);
+                ++bins[c][min(max(bin, 0), last_bin)];
+            }
+        }
+    }
+}
+
+
+template <typename T, int Channels>
+void fill_histogram(const uint8_t* buffer,
+                    const ValueLayout& layout,
+                    const float* lowest,
+                    const float* scale,
+                    vector<uint32_t>* bins)
+{
+    const T* typed_buffer = reinterpret_cast<const T*>(buffer);
+    const size_t rows     = static_cast<size_t>(layout.height);
+
+    const size_t size = static_cast<size_t>(layout.width) * rows * Channels;
+    if (size < min_parallel_size) {
+        fill_bins<T, Channels>(
+            typed_buffer, layout, 0, rows, lowest, scale, bins);
+        return;
+    }
+
+    mutex bins_mutex;
+    ThreadPool::instance().parallel_for(
+        rows, [&](size_t row_begin, size_t row_end) {
+            vector<uint32_t> range_bins[4];
+            for (int c = 0; c < Channels; ++c) {
+                range_bins[c].assign(bins[c].size(), 0);
+            }
+
+            fill_bins<T, Channels>(typed_buffer,
+                                   layout,
+                                   row_begin,
+                                   row_end,
+                                   lowest,
+                                   scale,
+                                   range_bins);
+
+            lock_guard<mutex> lock(bins_mutex);
+            for (int c = 0; c < Channels; ++c) {
+                for (size_t b = 0; b < bins[c].size(); ++b) {
+                    bins[c][b] += range_bins[c][b];
+                }
+            }
+        });
+}
+
+} // namespace
+
+
+void Histogram::compute(const uint8_t* buffer,
+                        BufferType type,
+                        int width,
+                        int height,
+                        int channels,
+                        int step,
+                        size_t plane_stride,
+                        const float* lowest,
+                        const float* upper)
+{
+    channels_      = min(max(channels, 1), 4);
+    has_unit_bins_ = type == BufferType::UnsignedByte ||
+                     type == BufferType::Int8 ||
+                     type == BufferType::UnsignedShort ||
+                     type == BufferType::Short || type == BufferType::Bool;
+
+    float range_lowest[4];
+    float range_upper[4];
+    for (int c = 0; c < channels_; ++c) {
+        value_lowest_[c] = range_lowest[c] = lowest[c];
+        value_upper_[c] = range_upper[c] = max(upper[c], lowest[c]);
+    }
+    for (int c = channels_; c < 4; ++c) {
+        bins_[c].clear();
+        total_[c] = 0;
+    }
+
+    // A few outliers can squeeze most values in a handful of adaptive bins.
+    // In that case, the bins are spread again over the range that holds
+    // nearly all the values, with the outliers counted in the outer bins.
+    const int max_passes = has_unit_bins_ ? 1 : 3;
+    for (int pass = 0; pass < max_passes; ++pass) {
+        fill(buffer,
+             type,
+             width,
+             height,
+             step,
+             plane_stride,
+             range_lowest,
+             range_upper);
+
+        bool is_refined = false;
+        for (int c = 0; c < channels_; ++c) {
+            const float range = range_upper[c] - range_lowest[c];
+            const float inner_lowest =
+                bin_value(c, floor(bin_at(c, outlier_percentage)));
+            const float inner_upper =
+                bin_value(c, floor(bin_at(c, 100.f - outlier_percentage)) + 1);
+
+            if (inner_upper - inner_lowest < range / 16.f) {
+                range_lowest[c] = inner_lowest;
+                range_upper[c]  = inner_upper;
+                is_refined      = true;
+            }
+        }
+
+        if (!is_refined) {
+            break;
+        }
+    }
+}
+
+
+void Histogram::fill(const uint8_t* buffer,
+                     BufferType type,
+                     int width,
+                     int height,
+                     int step,
+                     size_t plane_stride,
+                     const float* lowest,
+                     const float* upper)
+{
+    float scale[4];
+    for (int c = 0; c < channels_; ++c) {
+        const float range = upper[c] - lowest[c];
+
+        int num_bins;
+        if (has_unit_bins_) {
+            num_bins      = static_cast<int>(range) + 1;
+            bin_width_[c] = 1.f;
+        } else {
+            num_bins      = range > 0.f ? adaptive_bins : 1;
+            bin_width_[c] = range > 0.f ? range / adaptive_bins : 1.f;
+        }
+
+        lowest_[c] = lowest[c];
+        scale[c]   = 1.f / bin_width_[c];
+        bins_[c].assign(static_cast<size_t>(num_bins), 0);
+    }
+
+    const ValueLayout layout = {width, height, step, plane_stride};
+
+    // Double buffers are converted to float by the UI
+    visit_held_value_layout(
+        type, channels_, [&](auto value_type, auto channel_count) {
+            using T = typename decltype(value_type)::type;
+            fill_histogram<T, decltype(channel_count)::value>(
+                buffer, layout, lowest_, scale, bins_);
+        });
+
+    for (int c = 0; c < channels_; ++c) {
+        total_[c] = 0;
+        for (const uint32_t count : bins_[c]) {
+            total_[c] += count;
+        }
+    }
+}
+
+
+int Histogram::channels() const
+{
+    return channels_;
+}
+
+
+const vector<uint32_t>& Histogram::bins(int channel) const
+{
+    return bins_[channel];
+}
+
+
+float Histogram::bin_value(int channel, float bin) const
+{
+    return lowest_[channel] + bin * bin_width_[channel];
+}
+
+
+float Histogram::percentile(int channel, float percentage) const
+{
+    // The outer bins may hold outliers, whose exact bounds are known
+    if (percentage <= 0.f) {
+        return value_lowest_[channel];
+    } else if (percentage >= 100.f) {
+        return value_upper_[channel];
+    }
+
+    const float value = bin_value(channel, bin_at(channel, percentage));
+    return min(max(value, value_lowest_[channel]), value_upper_[channel]);
+}
+
+
+float Histogram::bin_at(int channel, float percentage) const
+{
+    const vector<uint32_t>& bins = bins_[channel];
+    if (bins.empty() || total_[channel] == 0) {
+        return 0.f;
+    }
+
+    const double target =
+        min(max(percentage, 0.f), 100.f) / 100.0 * total_[channel];
+
+    uint64_t accumulated = 0;
+    for (size_t b = 0; b < bins.size(); ++b) {
+        if (bins[b] == 0 || accumulated + bins[b] < target) {
+            accumulated += bins[b];
+            continue;
+        }
+
+        // Unit bins hold a single value, which is returned as is
+        if (has_unit_bins_) {
+            return static_cast<float>(b);
+        }
+
+        const double fraction = (target - accumulated) / bins[b];
+        return static_cast<float>(b + fraction);
+    }
+
+    return static_cast<float>(bins.size() - 1);
+}
@@ -0,0 +1,112 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ipc/raw_data_decode.h"
+
+/**
+ * Per channel histogram of a buffer.
+ *
+ * 8 and 16 bit integer buffers get one bin per value in the channel range.
+ * Other types get a fixed number of bins spread over the finite range of
+ * each channel, so the bins adapt to the values found in the buffer.
+ */
+class Histogram
+{
+  public:
+    static const int adaptive_bins = 4096;
+
+    /**
+     * Builds the histogram, splitting the rows across threads.
+     *
+     * @param step  Distance between the buffer rows, in pixels
+     * @param plane_stride  Distance between the channel planes of planar
+     *     buffers, in values; 0 if the channels are interleaved
+     * @param lowest  Lowest finite value of each channel
+     * @param upper  Highest finite value of each channel
+     */
+    void compute(const uint8_t* buffer,
+                 BufferType type,
+                 int width,
+                 int height,
+                 int channels,
+                 int step,
+                 std::size_t plane_stride,
+                 const float* lowest,
+                 const float* upper);
+
+    int channels() const;
+
+    const std::vector<uint32_t>& bins(int channel) const;
+
+    /**
+     * Value of the lower edge of the given bin
+     */
+    float bin_value(int channel, float bin) const;
+
+    /**
+     * Value below which the given percentage of the finite channel values
+     * fall, interpolated inside its bin
+     */
+    float percentile(int channel, float percentage) const;
+
+  private:
+    // Share of the values, at each end, considered outliers when spreading
+    // the adaptive bins
+    static constexpr float outlier_percentage = 0.01f;
+
+    void fill(const uint8_t* buffer,
+              BufferType type,
+              int width,
+              int height,
+              int step,
+              std::size_t plane_stride,
+              const float* lowest,
+              const float* upper);
+
+    /**
+     * Fractional bin below which the given percentage of the values fall
+     */
+    float bin_at(int channel, float percentage) const;
+
+    int channels_ = 0;
+
+    bool has_unit_bins_ = false;
+
+    std::vector<uint32_t> bins_[4];
+    uint64_t total_[4]     = {0, 0, 0, 0};
+    float lowest_[4]       = {0.f, 0.f, 0.f, 0.f};
+    float bin_width_[4]    = {1.f, 1.f, 1.f, 1.f};
+    float value_lowest_[4] = {0.f, 0.f, 0.f, 0.f};
+    float value_upper_[4]  = {0.f, 0.f, 0.f, 0.f};
+};
+
+#endif // HISTOGRAM_H_
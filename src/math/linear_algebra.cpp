@@ -28,138 +28,18 @@
 #include "linear_algebra.h"
 
 
-vec4::vec4()
-{
-}
-
-
-vec4::vec4(float x, float y, float z, float w)
-    : vec(x, y, z, w)
-{
-}
-
-vec4::vec4(const vec4& b)
-{
-    vec = b.vec;
-}
-
-
-vec4& vec4::operator=(const vec4& b)
-{
-    if (this != &b) {
-        vec = b.vec;
-    }
-    return *this;
-}
-
-
-vec4& vec4::operator+=(const vec4& b)
-{
-    for (int i = 0; i < 4; ++i)
-        vec[i] += b.vec[i];
-    return *this;
-}
-
-
-vec4 vec4::operator+(const vec4& b) const
-{
-    return vec4(vec[0] + b.vec[0],
-                vec[1] + b.vec[1],
-                vec[2] + b.vec[2],
-                vec[3] + b.vec[3]);
-}
-
-
-vec4 vec4::operator-(const vec4& b) const
-{
-    return vec4(vec[0] - b.vec[0],
-                vec[1] - b.vec[1],
-                vec[2] - b.vec[2],
-                vec[3] - b.vec[3]);
-}
-
-
-vec4 vec4::operator*(float scalar) const
-{
-    vec4 result(*this);
-    result.vec *= scalar;
-
-    return result;
-}
-
-
 void vec4::print() const
 {
     std::cout << vec.transpose() << std::endl;
 }
 
 
-float* vec4::data()
-{
-    return vec.data();
-}
-
-
-float& vec4::x()
-{
-    return vec[0];
-}
-
-
-float& vec4::y()
-{
-    return vec[1];
-}
-
-
-float& vec4::z()
-{
-    return vec[2];
-}
-
-
-float& vec4::w()
-{
-    return vec[3];
-}
-
-
-const float& vec4::x() const
-{
-    return vec[0];
-}
-
-
-const float& vec4::y() const
-{
-    return vec[1];
-}
-
-
-const float& vec4::z() const
-{
-    return vec[2];
-}
-
-
-const float& vec4::w() const
-{
-    return vec[3];
-}
-
-
 vec4 vec4::zero()
 {
     return vec4(0, 0, 0, 0);
 }
 
 
-vec4 operator-(const vec4& vector)
-{
-    return {-vector.x(), -vector.y(), -vector.z(), -vector.w()};
-}
-
-
 void mat4::set_identity()
 {
     // clang-format off
@@ -212,12 +92,6 @@ void mat4::set_from_srt(float scaleX,
 }
 
 
-float* mat4::data()
-{
-    return mat_.data();
-}
-
-
 void mat4::operator<<(const std::initializer_list<float>& data)
 {
     memcpy(mat_.data(), data.begin(), sizeof(float) * data.size());
@@ -300,25 +174,6 @@ mat4 mat4::inv() const
 }
 
 
-vec4 mat4::operator*(const vec4& b) const
-{
-    vec4 res;
-    res.vec = this->mat_ * b.vec;
-
-    return res;
-}
-
-
 float&mat4::operator()(int row, int col) {
     return mat_(row, col);
 }
-
-
-mat4 mat4::operator*(const mat4& b) const
-{
-    mat4 res;
-
-    res.mat_ = this->mat_ * b.mat_;
-
-    return res;
-}
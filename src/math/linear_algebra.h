@@ -44,11 +44,11 @@ class vec4
 
     ~vec4() = default;
 
-    vec4(const vec4& b);
+    vec4(const vec4& b) = default;
 
     vec4(vec4&& b) = default;
 
-    vec4& operator=(const vec4& b);
+    vec4& operator=(const vec4& b) = default;
 
     vec4& operator=(vec4&& b) = default;
 
@@ -78,7 +78,10 @@ class vec4
 
     static vec4 zero();
 
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
   private:
+    // 16-byte aligned, so that Eigen operates on it with SSE/NEON packets
     Eigen::Vector4f vec;
 };
 
@@ -115,6 +118,12 @@ class mat4
 
     mat4 inv() const;
 
+    /**
+     * Inverse of a matrix whose last row is (0, 0, 0, 1), such as the poses
+     * and orthographic projections used for rendering. Cheaper than inv().
+     */
+    mat4 affine_inv() const;
+
     mat4 operator*(const mat4& b) const;
 
     vec4 operator*(const vec4& b) const;
@@ -127,8 +136,183 @@ class mat4
 
     static mat4 scale(const vec4& factor);
 
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
   private:
     Eigen::Matrix4f mat_;
 };
 
+
+// The accessors and arithmetic operators are called per tile and per label,
+// so they are defined here to let them be inlined into vectorized code
+
+inline vec4::vec4()
+{
+}
+
+
+inline vec4::vec4(float x, float y, float z, float w)
+    : vec(x, y, z, w)
+{
+}
+
+
+inline float* vec4::data()
+{
+    return vec.data();
+}
+
+
+inline float& vec4::x()
+{
+    return vec[0];
+}
+
+
+inline float& vec4::y()
+{
+    return vec[1];
+}
+
+
+inline float& vec4::z()
+{
+    return vec[2];
+}
+
+
+inline float& vec4::w()
+{
+    return vec[3];
+}
+
+
+inline const float& vec4::x() const
+{
+    return vec[0];
+}
+
+
+inline const float& vec4::y() const
+{
+    return vec[1];
+}
+
+
+inline const float& vec4::z() const
+{
+    return vec[2];
+}
+
+
+inline const float& vec4::w() const
+{
+    return vec[3];
+}
+
+inline vec4& vec4::operator+=(const vec4& b)
+{
+    vec += b.vec;
+    return *this;
+}
+
+
+inline vec4 vec4::operator+(const vec4& b) const
+{
+    vec4 result;
+    result.vec = vec + b.vec;
+
+    return result;
+}
+
+
+inline vec4 vec4::operator-(const vec4& b) const
+{
+    vec4 result;
+    result.vec = vec - b.vec;
+
+    return result;
+}
+
+
+inline vec4 vec4::operator*(float scalar) const
+{
+    vec4 result;
+    result.vec = vec * scalar;
+
+    return result;
+}
+
+
+inline vec4 operator-(const vec4& vector)
+{
+    return vector * -1.f;
+}
+
+
+inline float* mat4::data()
+{
+    return mat_.data();
+}
+
+
+inline vec4 mat4::operator*(const vec4& b) const
+{
+    vec4 res;
+    res.vec = this->mat_ * b.vec;
+
+    return res;
+}
+
+
+inline mat4 mat4::operator*(const mat4& b) const
+{
+    mat4 res;
+    res.mat_ = this->mat_ * b.mat_;
+
+    return res;
+}
+
+
+inline mat4 mat4::affine_inv() const
+{
+    // The inverse of [A t; 0 1] is [A^-1 -A^-1*t; 0 1], which only requires
+    // inverting the 3x3 linear part. The storage is column major.
+    const float* m = mat_.data();
+
+    const float c00 = m[5] * m[10] - m[9] * m[6];
+    const float c01 = m[9] * m[2] - m[1] * m[10];
+    const float c02 = m[1] * m[6] - m[5] * m[2];
+    const float c10 = m[8] * m[6] - m[4] * m[10];
+    const float c11 = m[0] * m[10] - m[8] * m[2];
+    const float c12 = m[4] * m[2] - m[0] * m[6];
+    const float c20 = m[4] * m[9] - m[8] * m[5];
+    const float c21 = m[8] * m[1] - m[0] * m[9];
+    const float c22 = m[0] * m[5] - m[4] * m[1];
+
+    const float inv_det = 1.f / (m[0] * c00 + m[4] * c01 + m[8] * c02);
+
+    mat4 res;
+    float* r = res.mat_.data();
+
+    r[0]  = c00 * inv_det;
+    r[1]  = c01 * inv_det;
+    r[2]  = c02 * inv_det;
+    r[3]  = 0.f;
+    r[4]  = c10 * inv_det;
+    r[5]  = c11 * inv_det;
+    r[6]  = c12 * inv_det;
+    r[7]  = 0.f;
+    r[8]  = c20 * inv_det;
+    r[9]  = c21 * inv_det;
+    r[10] = c22 * inv_det;
+    r[11] = 0.f;
+    r[12] = -(r[0] * m[12] + r[4] * m[13] + r[8] * m[14]);
+    r[13] = -(r[1] * m[12] + r[5] * m[13] + r[9] * m[14]);
+    r[14] = -(r[2] * m[12] + r[6] * m[13] + r[10] * m[14]);
+    r[15] = 1.f;
+
+    return res;
+}
+
 #endif // LINEAR_ALGEBRA_H_
@@ -0,0 +1,551 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "min_max.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "math/buffer_type_dispatch.h"
+#include "math/half_float.h"
+#include "math/value_kernels.h"
+#include "system/thread/thread_pool.h"
+#include "system/trace/tracer.h"
+
+
+namespace
+{
+
+/**
+ * Vector operations used by the reduction kernels. Types without a
+ * specialization for the target instruction set use the scalar kernel.
+ */
+template <typename T>
+struct SimdOps
+{
+    static constexpr bool available = false;
+    static constexpr int lanes      = 1;
+};
+
+
+#if defined(__SSE2__)
+
+template <>
+struct SimdOps<float>
+{
+    using Vec = __m128;
+
+    static constexpr bool available = true;
+    static constexpr int lanes      = 4;
+
+    static Vec load(const float* src)
+    {
+        return _mm_loadu_ps(src);
+    }
+
+    static void store(float* dst, Vec value)
+    {
+        _mm_storeu_ps(dst, value);
+    }
+
+    static Vec splat(float value)
+    {
+        return _mm_set1_ps(value);
+    }
+
+    static Vec min(Vec a, Vec b)
+    {
+        return _mm_min_ps(a, b);
+    }
+
+    static Vec max(Vec a, Vec b)
+    {
+        return _mm_max_ps(a, b);
+    }
+
+    // Replaces the infinite and NaN lanes of value by those of fallback
+    static Vec finite_or(Vec value, Vec fallback)
+    {
+        // x - x is 0 for finite values, and NaN otherwise
+        Vec is_finite =
+            _mm_cmpeq_ps(_mm_sub_ps(value, value), _mm_setzero_ps());
+        return _mm_or_ps(_mm_and_ps(is_finite, value),
+                         _mm_andnot_ps(is_finite, fallback));
+    }
+};
+
+
+template <typename T>
+struct SimdIntegerOps
+{
+    using Vec = __m128i;
+
+    static constexpr bool available = true;
+    static constexpr int lanes      = 16 / sizeof(T);
+
+    static Vec load(const T* src)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    }
+
+    static void store(T* dst, Vec value)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), value);
+    }
+
+    static Vec finite_or(Vec value, Vec)
+    {
+        return value;
+    }
+};
+
+
+template <>
+struct SimdOps<uint8_t> : SimdIntegerOps<uint8_t>
+{
+    static Vec splat(uint8_t value)
+    {
+        return _mm_set1_epi8(static_cast<char>(value));
+    }
+
+    static Vec min(Vec a, Vec b)
+    {
+        return _mm_min_epu8(a, b);
+    }
+
+    static Vec max(Vec a, Vec b)
+    {
+        return _mm_max_epu8(a, b);
+    }
+};
+
+
+template <>
+struct SimdOps<int16_t> : SimdIntegerOps<int16_t>
+{
+    static Vec splat(int16_t value)
+    {
+        return _mm_set1_epi16(value);
+    }
+
+    static Vec min(Vec a, Vec b)
+    {
+        return _mm_min_epi16(a, b);
+    }
+
+    static Vec max(Vec a, Vec b)
+    {
+        return _mm_max_epi16(a, b);
+    }
+};
+
+#if defined(__SSE4_1__)
+
+template <>
+struct SimdOps<int8_t> : SimdIntegerOps<int8_t>
+{
+    static Vec splat(int8_t value)
+    {
+        return _mm_set1_epi8(value);
+    }
+
+    static Vec min(Vec a, Vec b)
+    {
+        return _mm_min_epi8(a, b);
+    }
+
+    static Vec max(Vec a, Vec b)
+    {
+        return _mm_max_epi8(a, b);
+    }
+};
+
+
+template <>
+struct SimdOps<uint16_t> : SimdIntegerOps<uint16_t>
+{
+    static Vec splat(uint16_t value)
+    {
+        return _mm_set1_epi16(static_cast<short>(value));
+    }
+
+    static Vec min(Vec a, Vec b)
+    {
+        return _mm_min_epu16(a, b);
+    }
+
+    static Vec max(Vec a, Vec b)
+    {
+        return _mm_max_epu16(a, b);
+    }
+};
+
+
+template <>
+struct SimdOps<int32_t> : SimdIntegerOps<int32_t>
+{
+    static Vec splat(int32_t value)
+    {
+        return _mm_set1_epi32(value);
+    }
+
+    static Vec min(Vec a, Vec b)
+    {
+        return _mm_min_epi32(a, b);
+    }
+
+    static Vec max(Vec a, Vec b)
+    {
+        return _mm_max_epi32(a, b);
+    }
+};
+
+
+template <>
+struct SimdOps<uint32_t> : SimdIntegerOps<uint32_t>
+{
+    static Vec splat(uint32_t value)
+    {
+        return _mm_set1_epi32(static_cast<int>(value));
+    }
+
+    static Vec min(Vec a, Vec b)
+    {
+        return _mm_min_epu32(a, b);
+    }
+
+    static Vec max(Vec a, Vec b)
+    {
+        return _mm_max_epu32(a, b);
+    }
+};
+
+#endif // __SSE4_1__
+
+#elif defined(__ARM_NEON)
+
+template <>
+struct SimdOps<float>
+{
+    using Vec = float32x4_t;
+
+    static constexpr bool available = true;
+    static constexpr int lanes      = 4;
+
+    static Vec load(const float* src)
+    {
+        return vld1q_f32(src);
+    }
+
+    static void store(float* dst, Vec value)
+    {
+        vst1q_f32(dst, value);
+    }
+
+    static Vec splat(float value)
+    {
+        return vdupq_n_f32(value);
+    }
+
+    static Vec min(Vec a, Vec b)
+    {
+        return vminq_f32(a, b);
+    }
+
+    static Vec max(Vec a, Vec b)
+    {
+        return vmaxq_f32(a, b);
+    }
+
+    // Replaces the infinite and NaN lanes of value by those of fallback
+    static Vec finite_or(Vec value, Vec fallback)
+    {
+        // x - x is 0 for finite values, and NaN otherwise
+        uint32x4_t is_finite =
+            vceqq_f32(vsubq_f32(value, value), vdupq_n_f32(0.f));
+        return vbslq_f32(is_finite, value, fallback);
+    }
+};
+
+
+#define OID_NEON_INTEGER_OPS(T, VEC, SUFFIX)                                   \
+    template <>                                                                \
+    struct SimdOps<T>                                                          \
+    {                                                                          \
+        using Vec = VEC;                                                       \
+                                                                               \
+        static constexpr bool available = true;                                \
+        static constexpr int lanes      = 16 / sizeof(T);                      \
+                                                                               \
+        static Vec load(const T* src)                                          \
+        {                                                                      \
+            return vld1q_##SUFFIX(src);                                        \
+        }                                                                      \
+                                                                               \
+        static void store(T* dst, Vec value)                                   \
+        {                                                                      \
+            vst1q_##SUFFIX(dst, value);                                        \
+        }                                                                      \
+                                                                               \
+        static Vec splat(T value)                                              \
+        {                                                                      \
+            return vdupq_n_##SUFFIX(value);                                    \
+        }                                                                      \
+                                                                               \
+        static Vec min(Vec a, Vec b)                                           \
+        {                                                                      \
+            return vminq_##SUFFIX(a, b);                                       \
+        }                                                                      \
+                                                                               \
+        static Vec max(Vec a, Vec b)                                           \
+        {                                                                      \
+            return vmaxq_##SUFFIX(a, b);                                       \
+        }                                                                      \
+                                                                               \
+        static Vec finite_or(Vec value, Vec)                                   \
+        {                                                                      \
+            return value;                                                      \
+        }                                                                      \
+    };
+
+OID_NEON_INTEGER_OPS(uint8_t, uint8x16_t, u8)
+OID_NEON_INTEGER_OPS(int8_t, int8x16_t, s8)
+OID_NEON_INTEGER_OPS(uint16_t, uint16x8_t, u16)
+OID_NEON_INTEGER_OPS(int16_t, int16x8_t, s16)
+OID_NEON_INTEGER_OPS(int32_t, int32x4_t, s32)
+OID_NEON_INTEGER_OPS(uint32_t, uint32x4_t, u32)
+
+#undef OID_NEON_INTEGER_OPS
+
+#endif
+
+
+template <typename T>
+struct Bounds
+{
+    T lowest[4];
+    T upper[4];
+
+    Bounds()
+    {
+        std::fill_n(lowest, 4, std::numeric_limits<T>::max());
+        std::fill_n(upper, 4, std::numeric_limits<T>::lowest());
+    }
+
+    void update(int channel, T value)
+    {
+        update(channel, value, value);
+    }
+
+    void update(int channel, T channel_lowest, T channel_upper)
+    {
+        lowest[channel] = std::min(lowest[channel], channel_lowest);
+        upper[channel]  = std::max(upper[channel], channel_upper);
+    }
+
+    void merge(const Bounds& other)
+    {
+        for (int c = 0; c < 4; ++c) {
+            update(c, other.lowest[c], other.upper[c]);
+        }
+    }
+};
+
+
+template <typename T, int Channels>
+void reduce_rows(const T* buffer,
+                 int width,
+                 int step,
+                 std::size_t row_begin,
+                 std::size_t row_end,
+                 Bounds<T>& bounds,
+                 std::false_type /* vectorized */)
+{
+    for (std::size_t y = row_begin; y < row_end; ++y) {
+        const T* row = buffer + y * step * Channels;
+        for (int x = 0; x < width; ++x) {
+            for (int c = 0; c < Channels; ++c) {
+                const T value = row[x * Channels + c];
+                if (is_finite(value)) {
+                    bounds.update(c, value);
+                }
+            }
+        }
+    }
+}
+
+
+template <typename T, int Channels>
+void reduce_rows(const T* buffer,
+                 int width,
+                 int step,
+                 std::size_t row_begin,
+                 std::size_t row_end,
+                 Bounds<T>& bounds,
+                 std::true_type /* vectorized */)
+{
+    using Ops = SimdOps<T>;
+
+    // Lanes map to the same channel on every vector, since the number of
+    // lanes is a multiple of the number of channels
+    const int row_size    = width * Channels;
+    const int vector_size = row_size - row_size % Ops::lanes;
+
+    typename Ops::Vec lowest = Ops::splat(std::numeric_limits<T>::max());
+    typename Ops::Vec upper  = Ops::splat(std::numeric_limits<T>::lowest());
+
+    for (std::size_t y = row_begin; y < row_end; ++y) {
+        const T* row = buffer + y * step * Channels;
+
+        for (int i = 0; i < vector_size; i += Ops::lanes) {
+            typename Ops::Vec value = Ops::load(row + i);
+            lowest = Ops::min(lowest, Ops::finite_or(value, lowest));
+            upper  = Ops::max(upper, Ops::finite_or(value, upper));
+        }
+
+        for (int i = vector_size; i < row_size; ++i) {
+            if (is_finite(row[i])) {
+                bounds.update(i % Channels, row[i]);
+            }
+        }
+    }
+
+    T lanes_lowest[Ops::lanes];
+    T lanes_upper[Ops::lanes];
+    Ops::store(lanes_lowest, lowest);
+    Ops::store(lanes_upper, upper);
+
+    for (int lane = 0; lane < Ops::lanes; ++lane) {
+        bounds.update(lane % Channels, lanes_lowest[lane], lanes_upper[lane]);
+    }
+}
+
+
+template <typename T, int Channels>
+Bounds<T>
+reduce_buffer(const uint8_t* buffer, int width, int height, int step)
+{
+    using Vectorized = std::integral_constant<
+        bool,
+        SimdOps<T>::available && SimdOps<T>::lanes % Channels == 0>;
+
+    const T* typed_buffer = reinterpret_cast<const T*>(buffer);
+    const std::size_t rows = static_cast<std::size_t>(height);
+
+    Bounds<T> bounds;
+
+    const std::size_t size =
+        static_cast<std::size_t>(width) * rows * Channels;
+    if (size < min_parallel_size) {
+        reduce_rows<T, Channels>(
+            typed_buffer, width, step, 0, rows, bounds, Vectorized());
+        return bounds;
+    }
+
+    std::mutex bounds_mutex;
+    ThreadPool::instance().parallel_for(
+        rows, [&](std::size_t row_begin, std::size_t row_end) {
+            Bounds<T> range_bounds;
+            reduce_rows<T, Channels>(typed_buffer,
+                                     width,
+                                     step,
+                                     row_begin,
+                                     row_end,
+                                     range_bounds,
+                                     Vectorized());
+
+            std::lock_guard<std::mutex> lock(bounds_mutex);
+            bounds.merge(range_bounds);
+        });
+
+    return bounds;
+}
+
+
+template <typename T, int Channels>
+void compute_typed_min_max(const uint8_t* buffer,
+                           int width,
+                           int height,
+                           int step,
+                           float* lowest,
+                           float* upper)
+{
+    const Bounds<T> bounds =
+        reduce_buffer<T, Channels>(buffer, width, height, step);
+
+    for (int c = 0; c < Channels; ++c) {
+        // Channels without a single finite value
+        if (bounds.lowest[c] > bounds.upper[c]) {
+            lowest[c] = upper[c] = 0.0f;
+            continue;
+        }
+
+        lowest[c] = static_cast<float>(bounds.lowest[c]);
+        upper[c]  = static_cast<float>(bounds.upper[c]);
+    }
+}
+
+} // namespace
+
+
+void compute_min_max(const uint8_t* buffer,
+                     BufferType type,
+                     int width,
+                     int height,
+                     int channels,
+                     int step,
+                     float* lowest,
+                     float* upper)
+{
+    TraceSpan span("compute_min_max");
+
+    channels = std::min(std::max(channels, 1), 4);
+
+    visit_held_value_layout(
+        type, channels, [&](auto value_type, auto channel_count) {
+            using T = typename decltype(value_type)::type;
+            compute_typed_min_max<T, decltype(channel_count)::value>(
+                buffer, width, height, step, lowest, upper);
+        });
+
+    // Unused channels are filled with 0
+    for (int c = channels; c < 4; ++c) {
+        lowest[c] = upper[c] = 0.0f;
+    }
+}
@@ -0,0 +1,54 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MIN_MAX_H_
+#define MIN_MAX_H_
+
+#include <cstdint>
+
+#include "ipc/raw_data_decode.h"
+
+/**
+ * Lowest and highest value of each channel of a buffer, computed in a single
+ * pass split across the rows of the buffer.
+ *
+ * Infinite and NaN values are ignored, and channels without any finite value
+ * get 0 as both bounds. Float64 buffers are expected to have been converted
+ * to Float32, as done by the UI when the buffer is received.
+ *
+ * @param step  Distance between the buffer rows, in pixels
+ * @param lowest  Receives the lowest value of each of the channels
+ * @param upper  Receives the highest value of each of the channels
+ */
+void compute_min_max(const uint8_t* buffer,
+                     BufferType type,
+                     int width,
+                     int height,
+                     int channels,
+                     int step,
+                     float* lowest,
+                     float* upper);
+
+#endif // MIN_MAX_H_
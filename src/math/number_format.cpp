@@ -0,0 +1,171 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "number_format.h"
+
+
+namespace
+{
+
+// Largest number of decimals written by the fixed notation fast path
+const int max_fast_precision = 9;
+
+const int64_t powers_of_ten[max_fast_precision + 1] = {1,
+                                                       10,
+                                                       100,
+                                                       1000,
+                                                       10000,
+                                                       100000,
+                                                       1000000,
+                                                       10000000,
+                                                       100000000,
+                                                       1000000000};
+
+
+// Writes the digits of a non-negative value, left padded with zeros to the
+// given width
+int format_digits(uint64_t value, int min_width, char* output)
+{
+    char digits[20];
+    int length = 0;
+
+    do {
+        digits[length++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    while (length < min_width) {
+        digits[length++] = '0';
+    }
+
+    for (int i = 0; i < length; ++i) {
+        output[i] = digits[length - 1 - i];
+    }
+
+    return length;
+}
+
+
+int format_shortest(float value, char* output, std::size_t output_size)
+{
+    // Nine significant digits always suffice to read floats back exactly
+    int length = 0;
+    for (int digits = 1; digits <= 9; ++digits) {
+        length = snprintf(output, output_size, "%.*g", digits, value);
+        if (std::strtof(output, nullptr) == value) {
+            break;
+        }
+    }
+
+    return length;
+}
+
+} // namespace
+
+
+int format_integer(int64_t value, char* output)
+{
+    int length = 0;
+
+    uint64_t magnitude = static_cast<uint64_t>(value);
+    if (value < 0) {
+        output[length++] = '-';
+        magnitude        = 0 - magnitude;
+    }
+
+    length += format_digits(magnitude, 1, output + length);
+    output[length] = '\0';
+
+    return length;
+}
+
+
+int format_float(float value,
+                 int precision,
+                 int max_length,
+                 char* output,
+                 std::size_t output_size)
+{
+    if (!std::isfinite(value)) {
+        return snprintf(output, output_size, "%.*f", 0, value);
+    }
+
+    if (precision < 0) {
+        return format_shortest(value, output, output_size);
+    }
+
+    const double magnitude = std::fabs(static_cast<double>(value));
+
+    // The fast path covers the values short enough to be written in fixed
+    // notation, which are the ones labels usually show. It rounds the
+    // scaled value, which may be off by half an ulp, so values close to a
+    // tie are left to printf, which rounds them to even from their exact
+    // binary value.
+    const double scaled_value =
+        precision <= max_fast_precision
+            ? magnitude * static_cast<double>(powers_of_ten[precision])
+            : 0.0;
+    const double tie_distance =
+        std::fabs(scaled_value - std::floor(scaled_value) - 0.5);
+    if (precision <= max_fast_precision && output_size > 32 &&
+        scaled_value < 1e15 && tie_distance > scaled_value * DBL_EPSILON) {
+        const uint64_t scaled =
+            static_cast<uint64_t>(std::llround(scaled_value));
+        const uint64_t integer_part = scaled / powers_of_ten[precision];
+        const uint64_t decimals     = scaled % powers_of_ten[precision];
+
+        int length = 0;
+        if (std::signbit(value)) {
+            output[length++] = '-';
+        }
+
+        length += format_digits(integer_part, 1, output + length);
+        if (precision > 0) {
+            output[length++] = '.';
+            length += format_digits(decimals, precision, output + length);
+        }
+        output[length] = '\0';
+
+        if (length <= max_length) {
+            return length;
+        }
+
+        return snprintf(output, output_size, "%.*e", precision, value);
+    }
+
+    const int length =
+        snprintf(output, output_size, "%.*f", precision, value);
+    if (length <= max_length) {
+        return length;
+    }
+
+    return snprintf(output, output_size, "%.*e", precision, value);
+}
@@ -0,0 +1,55 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef NUMBER_FORMAT_H_
+#define NUMBER_FORMAT_H_
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Writes the decimal representation of an integer, returning its length.
+ * The output must hold at least 21 characters.
+ */
+int format_integer(int64_t value, char* output);
+
+/**
+ * Writes a float with the given number of decimals, as printf's "%.*f"
+ * would. Values whose representation is longer than max_length are written
+ * in scientific notation instead, and infinite and NaN values as "inf" and
+ * "nan".
+ *
+ * A negative precision writes the shortest representation that reads back
+ * as the same float.
+ *
+ * @return The length of the written string, excluding its terminator
+ */
+int format_float(float value,
+                 int precision,
+                 int max_length,
+                 char* output,
+                 std::size_t output_size);
+
+#endif // NUMBER_FORMAT_H_
@@ -0,0 +1,499 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "pixel_search.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+#include "math/buffer_type_dispatch.h"
+#include "math/half_float.h"
+#include "math/value_kernels.h"
+#include "system/thread/thread_pool.h"
+#include "system/trace/tracer.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+using PixelRuns = vector<pair<size_t, size_t>>;
+
+
+void append_pixel(PixelRuns& runs, size_t pixel)
+{
+    if (!runs.empty() && runs.back().second == pixel) {
+        ++runs.back().second;
+    } else {
+        runs.emplace_back(pixel, pixel + 1);
+    }
+}
+
+
+void append_runs(PixelRuns& runs, const PixelRuns& other)
+{
+    for (const auto& run : other) {
+        if (!runs.empty() && runs.back().second == run.first) {
+            runs.back().second = run.second;
+        } else {
+            runs.push_back(run);
+        }
+    }
+}
+
+
+// Notable pixels of a range of rows, which are merged in row order
+template <typename T>
+struct RowsIndex
+{
+    size_t row_begin = 0;
+
+    bool has_finite_values = false;
+    size_t lowest_pixel    = 0;
+    size_t upper_pixel     = 0;
+    T lowest               = T();
+    T upper                = T();
+
+    PixelRuns nan_runs;
+    PixelRuns inf_runs;
+
+    void update(size_t pixel, T value)
+    {
+        if (!has_finite_values) {
+            has_finite_values = true;
+            lowest = upper = value;
+            lowest_pixel = upper_pixel = pixel;
+            return;
+        }
+
+        if (value < lowest) {
+            lowest       = value;
+            lowest_pixel = pixel;
+        }
+        if (value > upper) {
+            upper       = value;
+            upper_pixel = pixel;
+        }
+    }
+
+    // Merges the index of the rows following these
+    void append(const RowsIndex& other)
+    {
+        if (other.has_finite_values) {
+            if (!has_finite_values || other.lowest < lowest) {
+                lowest       = other.lowest;
+                lowest_pixel = other.lowest_pixel;
+            }
+            if (!has_finite_values || other.upper > upper) {
+                upper       = other.upper;
+                upper_pixel = other.upper_pixel;
+            }
+            has_finite_values = true;
+        }
+
+        append_runs(nan_runs, other.nan_runs);
+        append_runs(inf_runs, other.inf_runs);
+    }
+};
+
+
+template <typename T, int Channels>
+void index_rows(const T* buffer,
+                const ValueLayout& layout,
+                size_t row_begin,
+                size_t row_end,
+                RowsIndex<T>& index)
+{
+    const size_t pixel_stride =
+        layout.plane_stride == 0 ? static_cast<size_t>(Channels) : 1;
+    const size_t channel_stride =
+        layout.plane_stride == 0 ? 1 : layout.plane_stride;
+
+    index.row_begin = row_begin;
+
+    for (size_t y = row_begin; y < row_end; ++y) {
+        const T* row = buffer + y * layout.step * pixel_stride;
+        for (int x = 0; x < layout.width; ++x) {
+            const size_t pixel = y * layout.width + x;
+
+            bool has_nan = false;
+            bool has_inf = false;
+            for (int c = 0; c < Channels; ++c) {
+                const T value = row[x * pixel_stride + c * channel_stride];
+                if (is_nan(value)) {
+                    has_nan = true;
+                } else if (is_inf(value)) {
+                    has_inf = true;
+                } else {
+                    index.update(pixel, value);
+                }
+            }
+
+            if (has_nan) {
+                append_pixel(index.nan_runs, pixel);
+            }
+            if (has_inf) {
+                append_pixel(index.inf_runs, pixel);
+            }
+        }
+    }
+}
+
+
+template <typename T, int Channels>
+RowsIndex<T> index_buffer(const uint8_t* buffer, const ValueLayout& layout)
+{
+    const T* typed_buffer = reinterpret_cast<const T*>(buffer);
+    const size_t rows     = static_cast<size_t>(layout.height);
+
+    RowsIndex<T> index;
+
+    const size_t size = static_cast<size_t>(layout.width) * rows * Channels;
+    if (size < min_parallel_size) {
+        index_rows<T, Channels>(typed_buffer, layout, 0, rows, index);
+        return index;
+    }
+
+    // The runs of each range are joined in row order, whatever order the
+    // ranges finish in
+    vector<RowsIndex<T>> range_indices;
+    mutex indices_mutex;
+    ThreadPool::instance().parallel_for(
+        rows, [&](size_t row_begin, size_t row_end) {
+            RowsIndex<T> range_index;
+            index_rows<T, Channels>(
+                typed_buffer, layout, row_begin, row_end, range_index);
+
+            lock_guard<mutex> lock(indices_mutex);
+            range_indices.push_back(std::move(range_index));
+        });
+
+    sort(range_indices.begin(),
+         range_indices.end(),
+         [](const RowsIndex<T>& a, const RowsIndex<T>& b) {
+             return a.row_begin < b.row_begin;
+         });
+    for (const auto& range_index : range_indices) {
+        index.append(range_index);
+    }
+
+    return index;
+}
+
+
+template <typename T>
+bool compare_value(T value, PixelComparison comparison, float reference)
+{
+    // NaN values compare false to anything
+    const float converted = static_cast<float>(value);
+    switch (comparison) {
+    case PixelComparison::Above:
+        return converted > reference;
+    case PixelComparison::Below:
+        return converted < reference;
+    case PixelComparison::Equal:
+        break;
+    }
+
+    return converted == reference;
+}
+
+
+// First matching pixel after the given one, and first matching pixel of all
+struct RowsMatch
+{
+    bool has_next  = false;
+    size_t next    = 0;
+    bool has_first = false;
+    size_t first   = 0;
+
+    void merge(const RowsMatch& other)
+    {
+        if (other.has_next && (!has_next || other.next < next)) {
+            has_next = true;
+            next     = other.next;
+        }
+        if (other.has_first && (!has_first || other.first < first)) {
+            has_first = true;
+            first     = other.first;
+        }
+    }
+};
+
+
+template <typename T, int Channels>
+void match_rows(const T* buffer,
+                const ValueLayout& layout,
+                size_t row_begin,
+                size_t row_end,
+                PixelComparison comparison,
+                float reference,
+                size_t from,
+                RowsMatch& match)
+{
+    const size_t pixel_stride =
+        layout.plane_stride == 0 ? static_cast<size_t>(Channels) : 1;
+    const size_t channel_stride =
+        layout.plane_stride == 0 ? 1 : layout.plane_stride;
+
+    for (size_t y = row_begin; y < row_end && !match.has_next; ++y) {
+        const T* row = buffer + y * layout.step * pixel_stride;
+        for (int x = 0; x < layout.width; ++x) {
+            const size_t pixel = y * layout.width + x;
+
+            // Only the first match of the range matters before the pixel
+            if (pixel <= from && match.has_first) {
+                continue;
+            }
+
+            bool is_match = false;
+            for (int c = 0; c < Channels && !is_match; ++c) {
+                is_match = compare_value(
+                    row[x * pixel_stride + c * channel_stride],
+                    comparison,
+                    reference);
+            }
+
+            if (!is_match) {
+                continue;
+            }
+
+            if (!match.has_first) {
+                match.has_first = true;
+                match.first     = pixel;
+            }
+            if (pixel > from) {
+                match.has_next = true;
+                match.next     = pixel;
+                break;
+            }
+        }
+    }
+}
+
+
+template <typename T, int Channels>
+RowsMatch match_buffer(const uint8_t* buffer,
+                       const ValueLayout& layout,
+                       PixelComparison comparison,
+                       float reference,
+                       size_t from)
+{
+    const T* typed_buffer = reinterpret_cast<const T*>(buffer);
+    const size_t rows     = static_cast<size_t>(layout.height);
+
+    RowsMatch match;
+
+    const size_t size = static_cast<size_t>(layout.width) * rows * Channels;
+    if (size < min_parallel_size) {
+        match_rows<T, Channels>(
+            typed_buffer, layout, 0, rows, comparison, reference, from, match);
+        return match;
+    }
+
+    mutex match_mutex;
+    ThreadPool::instance().parallel_for(
+        rows, [&](size_t row_begin, size_t row_end) {
+            RowsMatch range_match;
+            match_rows<T, Channels>(typed_buffer,
+                                    layout,
+                                    row_begin,
+                                    row_end,
+                                    comparison,
+                                    reference,
+                                    from,
+                                    range_match);
+
+            lock_guard<mutex> lock(match_mutex);
+            match.merge(range_match);
+        });
+
+    return match;
+}
+
+} // namespace
+
+
+void PixelIndex::compute(const uint8_t* buffer,
+                         BufferType type,
+                         int width,
+                         int height,
+                         int channels,
+                         int step,
+                         size_t plane_stride)
+{
+    TraceSpan span("index pixels");
+
+    type_         = type;
+    width_        = width;
+    height_       = height;
+    channels_     = min(max(channels, 1), 4);
+    step_         = step;
+    plane_stride_ = plane_stride;
+
+    const ValueLayout layout = {width, height, step, plane_stride};
+
+    visit_held_value_layout(
+        type, channels_, [&](auto value_type, auto channel_count) {
+            using T          = typename decltype(value_type)::type;
+            const int Channels = decltype(channel_count)::value;
+            RowsIndex<T> index = index_buffer<T, Channels>(buffer, layout);
+
+            has_finite_values_ = index.has_finite_values;
+            lowest_pixel_      = index.lowest_pixel;
+            upper_pixel_       = index.upper_pixel;
+            lowest_value_      = static_cast<float>(index.lowest);
+            upper_value_       = static_cast<float>(index.upper);
+            nan_runs_          = std::move(index.nan_runs);
+            inf_runs_          = std::move(index.inf_runs);
+        });
+}
+
+
+bool PixelIndex::lowest(PixelLocation& location, float& value) const
+{
+    location = location_of(lowest_pixel_);
+    value    = lowest_value_;
+    return has_finite_values_;
+}
+
+
+bool PixelIndex::upper(PixelLocation& location, float& value) const
+{
+    location = location_of(upper_pixel_);
+    value    = upper_value_;
+    return has_finite_values_;
+}
+
+
+bool PixelIndex::next_nan(const PixelLocation& from,
+                          PixelLocation& location) const
+{
+    size_t pixel;
+    if (!next_in_runs(nan_runs_, pixel_at(from), pixel)) {
+        return false;
+    }
+
+    location = location_of(pixel);
+    return true;
+}
+
+
+bool PixelIndex::next_inf(const PixelLocation& from,
+                          PixelLocation& location) const
+{
+    size_t pixel;
+    if (!next_in_runs(inf_runs_, pixel_at(from), pixel)) {
+        return false;
+    }
+
+    location = location_of(pixel);
+    return true;
+}
+
+
+bool PixelIndex::next_matching(const uint8_t* buffer,
+                               PixelComparison comparison,
+                               float value,
+                               const PixelLocation& from,
+                               PixelLocation& location) const
+{
+    if (width_ <= 0 || height_ <= 0) {
+        return false;
+    }
+
+    TraceSpan span("match pixels");
+
+    const ValueLayout layout = {width_, height_, step_, plane_stride_};
+    const size_t from_pixel  = pixel_at(from);
+
+    const RowsMatch match = visit_held_value_layout(
+        type_, channels_, [&](auto value_type, auto channel_count) {
+            using T = typename decltype(value_type)::type;
+            return match_buffer<T, decltype(channel_count)::value>(
+                buffer, layout, comparison, value, from_pixel);
+        });
+
+    if (match.has_next) {
+        location = location_of(match.next);
+    } else if (match.has_first) {
+        location = location_of(match.first);
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+
+bool PixelIndex::next_in_runs(const PixelRuns& runs,
+                              size_t from,
+                              size_t& pixel)
+{
+    if (runs.empty()) {
+        return false;
+    }
+
+    // First run ending after the pixel that follows
+    auto run = upper_bound(
+        runs.begin(),
+        runs.end(),
+        from + 1,
+        [](size_t next, const pair<size_t, size_t>& candidate) {
+            return next < candidate.second;
+        });
+
+    if (run == runs.end()) {
+        pixel = runs.front().first;
+    } else {
+        pixel = max(run->first, from + 1);
+    }
+
+    return true;
+}
+
+
+size_t PixelIndex::pixel_at(const PixelLocation& location) const
+{
+    const int x = min(max(location.x, 0), max(width_ - 1, 0));
+    const int y = min(max(location.y, 0), max(height_ - 1, 0));
+
+    return static_cast<size_t>(y) * static_cast<size_t>(width_) +
+           static_cast<size_t>(x);
+}
+
+
+PixelLocation PixelIndex::location_of(size_t pixel) const
+{
+    if (width_ <= 0) {
+        return {0, 0};
+    }
+
+    const size_t width = static_cast<size_t>(width_);
+    return {static_cast<int>(pixel % width), static_cast<int>(pixel / width)};
+}
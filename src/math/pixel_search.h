@@ -0,0 +1,143 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef PIXEL_SEARCH_H_
+#define PIXEL_SEARCH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "ipc/raw_data_decode.h"
+
+/**
+ * Coordinates of a pixel in a buffer, before any rotation or transposition
+ */
+struct PixelLocation
+{
+    int x;
+    int y;
+};
+
+
+enum class PixelComparison { Equal, Above, Below };
+
+
+/**
+ * Index of the notable pixels of a buffer: those with its lowest and highest
+ * finite values, over all channels, and those with a NaN or an infinite value
+ * in any channel.
+ *
+ * The index is built in a single pass split across the rows of the buffer,
+ * and answers searches without reading the buffer again. Searches for the
+ * next pixel go in row order from the given pixel, and wrap around at the
+ * end of the buffer.
+ */
+class PixelIndex
+{
+  public:
+    /**
+     * Indexes the buffer. Float64 buffers are expected to have been
+     * converted to Float32, as done by the UI when the buffer is received.
+     *
+     * @param step  Distance between the buffer rows, in pixels
+     * @param plane_stride  Distance between the channel planes of planar
+     *     buffers, in values; 0 if the channels are interleaved
+     */
+    void compute(const uint8_t* buffer,
+                 BufferType type,
+                 int width,
+                 int height,
+                 int channels,
+                 int step,
+                 std::size_t plane_stride);
+
+    /**
+     * Pixel with the lowest finite value, the first one in row order if
+     * several have it. Returns false if the buffer has no finite value.
+     */
+    bool lowest(PixelLocation& location, float& value) const;
+
+    /**
+     * Pixel with the highest finite value, the first one in row order if
+     * several have it. Returns false if the buffer has no finite value.
+     */
+    bool upper(PixelLocation& location, float& value) const;
+
+    /**
+     * Next pixel after the given one with a NaN value in any channel.
+     * Returns false if there is none.
+     */
+    bool next_nan(const PixelLocation& from, PixelLocation& location) const;
+
+    /**
+     * Next pixel after the given one with an infinite value in any channel.
+     * Returns false if there is none.
+     */
+    bool next_inf(const PixelLocation& from, PixelLocation& location) const;
+
+    /**
+     * Next pixel after the given one with a value in any channel comparing
+     * as requested with the given one. Such pixels aren't indexed, so the
+     * buffer indexed last is read again, in parallel across its rows.
+     */
+    bool next_matching(const uint8_t* buffer,
+                       PixelComparison comparison,
+                       float value,
+                       const PixelLocation& from,
+                       PixelLocation& location) const;
+
+  private:
+    // Ranges [first, last) of consecutive pixels, in row order
+    using PixelRuns = std::vector<std::pair<std::size_t, std::size_t>>;
+
+    static bool next_in_runs(const PixelRuns& runs,
+                             std::size_t from,
+                             std::size_t& pixel);
+
+    // Index of the pixel, in row order, clamped to the buffer
+    std::size_t pixel_at(const PixelLocation& location) const;
+
+    PixelLocation location_of(std::size_t pixel) const;
+
+    BufferType type_          = BufferType::UnsignedByte;
+    int width_                = 0;
+    int height_               = 0;
+    int channels_             = 0;
+    int step_                 = 0;
+    std::size_t plane_stride_ = 0;
+
+    bool has_finite_values_     = false;
+    std::size_t lowest_pixel_   = 0;
+    std::size_t upper_pixel_    = 0;
+    float lowest_value_         = 0.f;
+    float upper_value_          = 0.f;
+
+    PixelRuns nan_runs_;
+    PixelRuns inf_runs_;
+};
+
+#endif // PIXEL_SEARCH_H_
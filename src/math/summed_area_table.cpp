@@ -0,0 +1,382 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "summed_area_table.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "math/buffer_type_dispatch.h"
+#include "math/half_float.h"
+#include "math/value_kernels.h"
+#include "system/thread/thread_pool.h"
+#include "system/trace/tracer.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+// Sum, sum of squares and number of finite values of each channel
+const int moments_per_channel = 3;
+
+
+// Integer values up to 32 bits are exact in double precision
+template <typename T>
+inline double to_double(T value)
+{
+    return static_cast<double>(value);
+}
+
+
+inline double to_double(HalfFloat value)
+{
+    return static_cast<double>(static_cast<float>(value));
+}
+
+
+/**
+ * Adds the moments of the values of the given row span to the Channels *
+ * moments_per_channel moments at 'moments'
+ */
+template <typename T, int Channels>
+inline void accumulate_span(const T* row,
+                            const ValueLayout& layout,
+                            int x_begin,
+                            int x_end,
+                            double* moments)
+{
+    const size_t pixel_stride =
+        layout.plane_stride == 0 ? static_cast<size_t>(Channels) : 1;
+    const size_t channel_stride =
+        layout.plane_stride == 0 ? 1 : layout.plane_stride;
+
+    for (int x = x_begin; x < x_end; ++x) {
+        for (int c = 0; c < Channels; ++c) {
+            const T value = row[x * pixel_stride + c * channel_stride];
+            if (!is_finite(value)) {
+                continue;
+            }
+
+            const double converted = to_double(value);
+            double* channel_moments = moments + c * moments_per_channel;
+            channel_moments[0] += converted;
+            channel_moments[1] += converted * converted;
+            channel_moments[2] += 1.0;
+        }
+    }
+}
+
+
+template <typename T, int Channels>
+void accumulate_region(const T* buffer,
+                       const ValueLayout& layout,
+                       int x_begin,
+                       int y_begin,
+                       int x_end,
+                       int y_end,
+                       double* moments)
+{
+    const size_t pixel_stride =
+        layout.plane_stride == 0 ? static_cast<size_t>(Channels) : 1;
+
+    for (int y = y_begin; y < y_end; ++y) {
+        const T* row =
+            buffer + static_cast<size_t>(y) * layout.step * pixel_stride;
+        accumulate_span<T, Channels>(row, layout, x_begin, x_end, moments);
+    }
+}
+
+
+/**
+ * Sums the cells of the given rows of cells into the table row below each
+ * of them, and accumulates each table row from left to right
+ */
+template <typename T, int Channels>
+void sum_cell_rows(const T* buffer,
+                   const ValueLayout& layout,
+                   int cell_size,
+                   int cells_x,
+                   size_t cell_row_begin,
+                   size_t cell_row_end,
+                   double* table)
+{
+    const size_t corner_size  = Channels * moments_per_channel;
+    const size_t table_stride = (cells_x + 1) * corner_size;
+    const size_t pixel_stride =
+        layout.plane_stride == 0 ? static_cast<size_t>(Channels) : 1;
+
+    for (size_t cy = cell_row_begin; cy < cell_row_end; ++cy) {
+        double* table_row = table + (cy + 1) * table_stride;
+
+        const int y_begin = static_cast<int>(cy) * cell_size;
+        const int y_end   = min(y_begin + cell_size, layout.height);
+        for (int y = y_begin; y < y_end; ++y) {
+            const T* row =
+                buffer + static_cast<size_t>(y) * layout.step * pixel_stride;
+            for (int cx = 0; cx < cells_x; ++cx) {
+                const int x_begin = cx * cell_size;
+                const int x_end   = min(x_begin + cell_size, layout.width);
+                accumulate_span<T, Channels>(row,
+                                             layout,
+                                             x_begin,
+                                             x_end,
+                                             table_row +
+                                                 (cx + 1) * corner_size);
+            }
+        }
+
+        for (size_t i = corner_size; i < table_stride; ++i) {
+            table_row[i] += table_row[i - corner_size];
+        }
+    }
+}
+
+} // namespace
+
+
+void SummedAreaTable::compute(const uint8_t* buffer,
+                              BufferType type,
+                              int width,
+                              int height,
+                              int channels,
+                              int step,
+                              size_t plane_stride)
+{
+    TraceSpan span("sum buffer areas");
+
+    type_         = type;
+    width_        = max(width, 0);
+    height_       = max(height, 0);
+    channels_     = min(max(channels, 1), 4);
+    step_         = step;
+    plane_stride_ = plane_stride;
+
+    // Smallest cells whose tables fit in the budget
+    const size_t corner_size =
+        static_cast<size_t>(channels_) * moments_per_channel * sizeof(double);
+    cell_size_ = 1;
+    while (true) {
+        cells_x_ = (width_ + cell_size_ - 1) / cell_size_;
+        cells_y_ = (height_ + cell_size_ - 1) / cell_size_;
+
+        const size_t corners = static_cast<size_t>(cells_x_ + 1) *
+                               static_cast<size_t>(cells_y_ + 1);
+        if (corners * corner_size <= table_memory_budget ||
+            cell_size_ >= max(width_, height_)) {
+            break;
+        }
+        cell_size_ *= 2;
+    }
+
+    const size_t table_stride =
+        static_cast<size_t>(cells_x_ + 1) * channels_ * moments_per_channel;
+    table_.assign(table_stride * (cells_y_ + 1), 0.0);
+
+    if (buffer == nullptr || cells_x_ == 0 || cells_y_ == 0) {
+        return;
+    }
+
+    const ValueLayout layout = {width_, height_, step, plane_stride};
+    const size_t size = static_cast<size_t>(width_) * height_ * channels_;
+    double* table     = table_.data();
+
+    visit_held_value_layout(
+        type, channels_, [&](auto value_type, auto channel_count) {
+            using T            = typename decltype(value_type)::type;
+            const int Channels = decltype(channel_count)::value;
+
+            const T* typed_buffer = reinterpret_cast<const T*>(buffer);
+            const size_t cell_rows = static_cast<size_t>(cells_y_);
+
+            if (size < min_parallel_size) {
+                sum_cell_rows<T, Channels>(typed_buffer,
+                                           layout,
+                                           cell_size_,
+                                           cells_x_,
+                                           0,
+                                           cell_rows,
+                                           table);
+                return;
+            }
+
+            // Each row of cells is written by a single range
+            ThreadPool::instance().parallel_for(
+                cell_rows, [&](size_t cell_row_begin, size_t cell_row_end) {
+                    sum_cell_rows<T, Channels>(typed_buffer,
+                                               layout,
+                                               cell_size_,
+                                               cells_x_,
+                                               cell_row_begin,
+                                               cell_row_end,
+                                               table);
+                });
+        });
+
+    // Accumulates the table rows from top to bottom, split in ranges of
+    // columns
+    const auto accumulate_columns = [&](size_t column_begin,
+                                        size_t column_end) {
+        for (int cy = 1; cy <= cells_y_; ++cy) {
+            double* table_row      = table + cy * table_stride;
+            const double* previous = table_row - table_stride;
+            for (size_t i = column_begin; i < column_end; ++i) {
+                table_row[i] += previous[i];
+            }
+        }
+    };
+
+    if (size < min_parallel_size) {
+        accumulate_columns(0, table_stride);
+    } else {
+        ThreadPool::instance().parallel_for(table_stride, accumulate_columns);
+    }
+}
+
+
+RegionMoments SummedAreaTable::region_moments(const uint8_t* buffer,
+                                              int x,
+                                              int y,
+                                              int width,
+                                              int height) const
+{
+    RegionMoments result;
+    fill(begin(result.finite_count), end(result.finite_count), 0);
+    fill(begin(result.mean), end(result.mean), 0.0);
+    fill(begin(result.deviation), end(result.deviation), 0.0);
+
+    const int x_begin = max(x, 0);
+    const int y_begin = max(y, 0);
+    const int x_end   = min(x + width, width_);
+    const int y_end   = min(y + height, height_);
+    if (buffer == nullptr || x_begin >= x_end || y_begin >= y_end ||
+        table_.empty()) {
+        return result;
+    }
+
+    // Corners of the cells inside the region. Cells of the last row and
+    // column may be cut by the buffer edges.
+    const int cx_begin = (x_begin + cell_size_ - 1) / cell_size_;
+    const int cy_begin = (y_begin + cell_size_ - 1) / cell_size_;
+    const int cx_end   = x_end == width_ ? cells_x_ : x_end / cell_size_;
+    const int cy_end   = y_end == height_ ? cells_y_ : y_end / cell_size_;
+
+    double moments[4 * moments_per_channel] = {};
+    const int corner_size = channels_ * moments_per_channel;
+
+    const ValueLayout layout = {width_, height_, step_, plane_stride_};
+    const bool has_cells     = cx_begin < cx_end && cy_begin < cy_end;
+
+    visit_held_value_layout(
+        type_, channels_, [&](auto value_type, auto channel_count) {
+            using T            = typename decltype(value_type)::type;
+            const int Channels = decltype(channel_count)::value;
+
+            const T* typed_buffer = reinterpret_cast<const T*>(buffer);
+
+            if (!has_cells) {
+                accumulate_region<T, Channels>(typed_buffer,
+                                               layout,
+                                               x_begin,
+                                               y_begin,
+                                               x_end,
+                                               y_end,
+                                               moments);
+                return;
+            }
+
+            const int cells_x_begin = cx_begin * cell_size_;
+            const int cells_y_begin = cy_begin * cell_size_;
+            const int cells_x_end   = min(cx_end * cell_size_, width_);
+            const int cells_y_end   = min(cy_end * cell_size_, height_);
+
+            // Strips above, below, left and right of the cells
+            accumulate_region<T, Channels>(typed_buffer,
+                                           layout,
+                                           x_begin,
+                                           y_begin,
+                                           x_end,
+                                           cells_y_begin,
+                                           moments);
+            accumulate_region<T, Channels>(typed_buffer,
+                                           layout,
+                                           x_begin,
+                                           cells_y_end,
+                                           x_end,
+                                           y_end,
+                                           moments);
+            accumulate_region<T, Channels>(typed_buffer,
+                                           layout,
+                                           x_begin,
+                                           cells_y_begin,
+                                           cells_x_begin,
+                                           cells_y_end,
+                                           moments);
+            accumulate_region<T, Channels>(typed_buffer,
+                                           layout,
+                                           cells_x_end,
+                                           cells_y_begin,
+                                           x_end,
+                                           cells_y_end,
+                                           moments);
+        });
+
+    if (has_cells) {
+        const size_t table_stride = (cells_x_ + 1) * corner_size;
+        const auto corner         = [&](int cx, int cy) {
+            return table_.data() + cy * table_stride + cx * corner_size;
+        };
+
+        const double* top_left     = corner(cx_begin, cy_begin);
+        const double* top_right    = corner(cx_end, cy_begin);
+        const double* bottom_left  = corner(cx_begin, cy_end);
+        const double* bottom_right = corner(cx_end, cy_end);
+        for (int i = 0; i < corner_size; ++i) {
+            moments[i] += bottom_right[i] - bottom_left[i] - top_right[i] +
+                          top_left[i];
+        }
+    }
+
+    for (int c = 0; c < channels_; ++c) {
+        const double* channel_moments = moments + c * moments_per_channel;
+
+        // Counts are sums of ones, exact in double precision
+        const double count = channel_moments[2];
+        if (count <= 0.0) {
+            continue;
+        }
+
+        const double mean     = channel_moments[0] / count;
+        const double variance = channel_moments[1] / count - mean * mean;
+
+        result.finite_count[c] = static_cast<size_t>(count);
+        result.mean[c]         = mean;
+        result.deviation[c]    = sqrt(max(variance, 0.0));
+    }
+
+    return result;
+}
@@ -0,0 +1,116 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef SUMMED_AREA_TABLE_H_
+#define SUMMED_AREA_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ipc/raw_data_decode.h"
+
+/**
+ * Mean and standard deviation of the values of each channel of a buffer
+ * region. Infinite and NaN values are left out.
+ */
+struct RegionMoments
+{
+    std::size_t finite_count[4];
+    double mean[4];
+    double deviation[4];
+};
+
+
+/**
+ * Summed-area tables of the values of a buffer and of their squares, for
+ * each channel, in double precision.
+ *
+ * The tables sum square cells of pixels rather than single pixels, so that
+ * they stay within table_memory_budget on the largest buffers. The part of a
+ * region made of whole cells is answered in constant time from the tables,
+ * and only the strips along its borders, narrower than a cell, are read
+ * from the buffer.
+ */
+class SummedAreaTable
+{
+  public:
+    // Memory the tables may take, which sets the size of their cells
+    static const std::size_t table_memory_budget =
+        static_cast<std::size_t>(64) << 20;
+
+    /**
+     * Builds the tables of the buffer. Float64 buffers are expected to have
+     * been converted to Float32, as done by the UI when the buffer is
+     * received. The buffer contents are given again to each query, as they
+     * may be moved in memory in the meantime.
+     *
+     * @param step  Distance between the buffer rows, in pixels
+     * @param plane_stride  Distance between the channel planes of planar
+     *     buffers, in values; 0 if the channels are interleaved
+     */
+    void compute(const uint8_t* buffer,
+                 BufferType type,
+                 int width,
+                 int height,
+                 int channels,
+                 int step,
+                 std::size_t plane_stride);
+
+    /**
+     * Moments of the given region, clamped to the buffer
+     */
+    RegionMoments region_moments(const uint8_t* buffer,
+                                 int x,
+                                 int y,
+                                 int width,
+                                 int height) const;
+
+    /**
+     * Width and height of the cells summed by the tables, in pixels
+     */
+    int cell_size() const
+    {
+        return cell_size_;
+    }
+
+  private:
+    BufferType type_          = BufferType::UnsignedByte;
+    int width_                = 0;
+    int height_               = 0;
+    int channels_             = 0;
+    int step_                 = 0;
+    std::size_t plane_stride_ = 0;
+
+    int cell_size_ = 1;
+    int cells_x_   = 0;
+    int cells_y_   = 0;
+
+    // Sum, sum of squares and number of finite values of each channel above
+    // and left of each cell corner, with an empty first row and column
+    std::vector<double> table_;
+};
+
+#endif // SUMMED_AREA_TABLE_H_
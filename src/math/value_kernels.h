@@ -0,0 +1,114 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef VALUE_KERNELS_H_
+#define VALUE_KERNELS_H_
+
+#include <cmath>
+#include <cstddef>
+
+#include "math/half_float.h"
+
+/**
+ * Helpers shared by the kernels that scan the values of a buffer, once
+ * dispatched to their value type by buffer_type_dispatch.h.
+ */
+
+// Buffers smaller than this, in channel values, are not worth splitting
+// across threads
+const std::size_t min_parallel_size = 1 << 18;
+
+
+// Geometry of the values of a buffer, whose channels are given to the
+// kernels as a template parameter
+struct ValueLayout
+{
+    int width;
+    int height;
+    // Distance between the rows, in pixels
+    int step;
+    // Distance between the channel planes of planar buffers, in values; 0
+    // if the channels are interleaved
+    std::size_t plane_stride;
+};
+
+
+template <typename T>
+inline bool is_finite(T)
+{
+    return true;
+}
+
+
+inline bool is_finite(float value)
+{
+    return std::isfinite(value);
+}
+
+
+inline bool is_finite(HalfFloat value)
+{
+    return std::isfinite(static_cast<float>(value));
+}
+
+
+template <typename T>
+inline bool is_nan(T)
+{
+    return false;
+}
+
+
+inline bool is_nan(float value)
+{
+    return std::isnan(value);
+}
+
+
+inline bool is_nan(HalfFloat value)
+{
+    return std::isnan(static_cast<float>(value));
+}
+
+
+template <typename T>
+inline bool is_inf(T)
+{
+    return false;
+}
+
+
+inline bool is_inf(float value)
+{
+    return std::isinf(value);
+}
+
+
+inline bool is_inf(HalfFloat value)
+{
+    return std::isinf(static_cast<float>(value));
+}
+
+#endif // VALUE_KERNELS_H_
@@ -31,6 +31,7 @@
 #include <QCommandLineParser>
 
 #include "debuggerinterface/preprocessor_directives.h"
+#include "system/trace/tracer.h"
 #include "ui/main_window/main_window.h"
 
 using namespace std;
@@ -40,18 +41,39 @@ int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
 
+    Tracer::instance().initialize("oidwindow");
+
     QCommandLineParser parser;
     parser.addOptions({
         {"h", "hostname", "hostname", "127.0.0.1"},
         {"p", "port", "port", "9588"},
+        {"daemon",
+         "Keep running between debugging sessions, which attach to this "
+         "window instead of starting their own"},
     });
+    parser.addPositionalArgument(
+        "files",
+        "Recordings (.oidrec) or exported buffers (.npy, .oct) to open "
+        "without a debugger",
+        "[files...]");
     parser.parse(QCoreApplication::arguments());
 
+    const QStringList offline_files = parser.positionalArguments();
+
     ConnectionSettings host_settings;
     host_settings.url = parser.value("h").toStdString();
     host_settings.port = static_cast<uint16_t>(parser.value("p").toUInt());
+    host_settings.is_offline = !offline_files.isEmpty();
+    host_settings.is_daemon =
+        parser.isSet("daemon") && !host_settings.is_offline;
+
+    // A daemon started ahead of the debugger waits for its first session
+    if (host_settings.is_daemon && !parser.isSet("p")) {
+        host_settings.port = 0;
+    }
 
     MainWindow window(host_settings);
+    window.open_buffer_files(offline_files);
     window.show();
     return app.exec();
 }
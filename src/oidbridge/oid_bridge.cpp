@@ -23,17 +23,50 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
 #include <deque>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "debuggerinterface/preprocessor_directives.h"
 #include "debuggerinterface/python_native_interface.h"
 #include "oid_bridge.h"
+#include "ipc/buffer_tiles.h"
+#include "ipc/content_hash.h"
+#include "ipc/link_throughput.h"
 #include "ipc/message_exchange.h"
+#include "ipc/window_daemon.h"
+#include "math/byte_swap.h"
+#include "math/downsample.h"
+#include "system/memory/process_memory.h"
 #include "system/process/process.h"
+#include "system/thread/thread_pool.h"
+#include "system/trace/tracer.h"
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#include <QCoreApplication>
 #include <QDataStream>
+#include <QSharedMemory>
 #include <QString>
 #include <QTcpServer>
 #include <QTcpSocket>
@@ -60,15 +93,23 @@ GetObservedSymbolsResponseMessage::~GetObservedSymbolsResponseMessage()
 {
 }
 
-struct PlotBufferRequestMessage : public UiMessage
+struct SentBuffer
 {
-    std::string buffer_name;
-    ~PlotBufferRequestMessage();
+    BufferMetadata metadata;
+    std::vector<uint64_t> tile_hashes;
+    uint64_t content_hash;
 };
 
-PlotBufferRequestMessage::~PlotBufferRequestMessage()
+/**
+ * Buffer living in the memory of a local inferior
+ */
+struct ProcessBuffer
 {
-}
+    // With the row stride of the buffer in the inferior
+    BufferMetadata metadata;
+    int64_t pid;
+    uint64_t address;
+};
 
 class PyGILRAII
 {
@@ -92,132 +133,1666 @@ class PyGILRAII
     PyGILState_STATE _py_gil_state;
 };
 
+class PyGILReleaseRAII
+{
+  public:
+    PyGILReleaseRAII()
+    {
+        _py_thread_state = PyEval_SaveThread();
+    }
+    PyGILReleaseRAII(const PyGILReleaseRAII&)  = delete;
+    PyGILReleaseRAII(const PyGILReleaseRAII&&) = delete;
+
+    PyGILReleaseRAII& operator=(const PyGILReleaseRAII&) = delete;
+    PyGILReleaseRAII& operator=(const PyGILReleaseRAII&&) = delete;
+
+    ~PyGILReleaseRAII()
+    {
+        PyEval_RestoreThread(_py_thread_state);
+    }
+
+  private:
+    PyThreadState* _py_thread_state;
+};
+
+/**
+ * Number of buffers that may wait for the io thread before oid_plot_buffer
+ * blocks its caller
+ */
+const size_t max_pending_plots = 2;
+
+/**
+ * Most bytes of the buffers read at once by oid_plot_buffer_descriptors,
+ * besides those of the staging buffers
+ */
+const size_t max_parallel_read_length = 256 << 20;
+
+/**
+ * Buffers sent progressively are first shown from a preview reduced by this
+ * factor. Their full resolution tiles follow in messages of at most
+ * max_refinement_length bytes.
+ */
+const int preview_reduction_factor = 8;
+const size_t max_refinement_length = 8 << 20;
+
+// Longest wait for each step of a session request to the window daemon
+const int window_daemon_timeout_ms = 1000;
+
+// Longest wait for the window to connect. Remote windows are started by the
+// user, and get more time.
+const int client_timeout_ms        = 10000;
+const int remote_client_timeout_ms = 120000;
+
+// Throughput assumed for the link to a remote window until it is measured.
+// Remote sessions usually go through slow tunnels.
+const double initial_remote_bytes_per_second = 1e6;
+
+// Kernel buffer of the connection to a remote window. A small one keeps the
+// messages queued behind bulk transfers from waiting long, and lets the
+// transfers measure the link instead of the buffer.
+const int remote_send_buffer_size = 256 << 10;
+
+// Previews of remote sessions are reduced further on slow links
+const int max_preview_reduction_factor = 64;
+
 class OidBridge
 {
   public:
-    OidBridge(int (*plot_callback)(const char*))
+    OidBridge(int (*plot_callback)(const char*, int))
         : ui_proc_{}
         , client_{nullptr}
+        , allow_shared_memory_{true}
+        , use_shared_memory_{false}
+        , allow_delta_updates_{true}
+        , use_window_daemon_{false}
+        , is_window_shared_{false}
+        , shared_buffer_counter_{0}
+        , compression_settings_{CompressionCodec::None, 1, 0}
+        , progressive_threshold_{0}
+        , refinement_counter_{0}
+        , lazy_threshold_{0}
+        , remote_port_{0}
+        , link_throughput_{initial_remote_bytes_per_second}
+        , written_bytes_{0}
+        , preview_length_{0}
+        , max_refinement_length_{max_refinement_length}
+        , stop_generation_{0}
         , plot_callback_{plot_callback}
+        , available_symbols_version_{0}
+        , pending_plots_{0}
+        , stop_io_thread_{false}
     {
+#if !defined(_WIN32)
+        if (pipe(wakeup_pipe_) != 0) {
+            wakeup_pipe_[0] = wakeup_pipe_[1] = -1;
+        } else {
+            fcntl(wakeup_pipe_[0], F_SETFL, O_NONBLOCK);
+            fcntl(wakeup_pipe_[1], F_SETFL, O_NONBLOCK);
+        }
+#endif
+
+        // Qt sockets can only be used by the thread that created them, so
+        // all the communication with the window happens in the io thread
+        io_thread_ = std::thread(&OidBridge::run_io_thread, this);
     }
 
     bool start()
     {
-        // Initialize server
-        if (!server_.listen(QHostAddress::Any)) {
-            // TODO escalate error
-            cerr << "[OpenImageDebugger] Could not start TCP server" << endl;
-            return false;
-        }
+        return run_io_task([this]() {
+            // Initialize server
+            server_.reset(new QTcpServer());
+            if (!server_->listen(QHostAddress::Any, remote_port_)) {
+                // TODO escalate error
+                cerr << "[OpenImageDebugger] Could not start TCP server"
+                     << endl;
+                return false;
+            }
 
-        string windowBinaryPath = this->oid_path_ + "/oidwindow";
-        string portStdString    = std::to_string(server_.serverPort());
+            string windowBinaryPath = this->oid_path_ + "/oidwindow";
+            string portStdString    = std::to_string(server_->serverPort());
+
+            const vector<string> command{
+                windowBinaryPath, "-style", "fusion", "-p", portStdString};
+
+            if (is_remote()) {
+                cerr << "[OpenImageDebugger] Waiting for the window to "
+                        "connect to port "
+                     << portStdString << " (e.g. oidwindow -h <host> -p "
+                     << portStdString << ")" << endl;
+            } else if (use_window_daemon_) {
+                start_window_daemon_session(command);
+            } else {
+                ui_proc_.start(command);
+                ui_proc_.waitForStart();
+            }
 
-        const vector<string> command {windowBinaryPath, "-style", "fusion", "-p", portStdString};
+            wait_for_client(is_remote() ? remote_client_timeout_ms
+                                        : client_timeout_ms);
+
+            // Buffer contents can only be handed over through shared memory
+            // if the window runs on the same host as the debugger. Remote
+            // windows may connect through a tunnel from the loopback.
+            use_shared_memory_ = allow_shared_memory_ && !is_remote() &&
+                                 client_ != nullptr &&
+                                 client_->peerAddress().isLoopback();
+
+            if (client_ != nullptr && is_remote()) {
+                client_->setSocketOption(
+                    QAbstractSocket::SendBufferSizeSocketOption,
+                    remote_send_buffer_size);
+                QObject::connect(client_,
+                                 &QTcpSocket::bytesWritten,
+                                 [this](qint64 bytes) {
+                                     written_bytes_ +=
+                                         static_cast<uint64_t>(bytes);
+                                 });
+                adapt_to_link();
+            }
 
-        ui_proc_.start(command);
+            return client_ != nullptr;
+        });
+    }
 
-        ui_proc_.waitForStart();
+    void set_path(const string& oid_path)
+    {
+        oid_path_ = oid_path;
+    }
 
-        wait_for_client();
+    /**
+     * Must be called before start(). Without shared memory, buffer contents
+     * are always sent through the socket.
+     */
+    void set_shared_memory_allowed(bool is_allowed)
+    {
+        allow_shared_memory_ = is_allowed;
+    }
 
-        return client_ != nullptr;
+    /**
+     * Must be called before start(). Without delta updates, every plot sends
+     * the whole buffer, even if the window already displays it.
+     */
+    void set_delta_updates_allowed(bool is_allowed)
+    {
+        allow_delta_updates_ = is_allowed;
     }
 
-    void set_path(const string& oid_path)
+    /**
+     * Must be called before start(). Sessions attach to the long-lived
+     * window daemon, which is started by the first of them, instead of
+     * starting a window of their own.
+     */
+    void set_window_daemon_used(bool is_used)
     {
-        oid_path_ = oid_path;
+        use_window_daemon_ = is_used;
+    }
+
+    /**
+     * Must be called before start(). Instead of starting the window, waits
+     * for one to connect to port from another host, and adapts the
+     * transport settings to the throughput of the link.
+     */
+    void set_remote_port(uint16_t port)
+    {
+        remote_port_ = port;
     }
 
     bool is_window_ready()
     {
-        return client_ != nullptr && ui_proc_.isRunning();
+        return run_io_task([this]() {
+            if (client_ == nullptr) {
+                return false;
+            }
+
+            // Neither the window daemon nor remote windows are owned by
+            // this session
+            if (is_window_shared_ || is_remote()) {
+                return client_->state() == QAbstractSocket::ConnectedState;
+            }
+
+            return ui_proc_.isRunning();
+        });
     }
 
     deque<string> get_observed_symbols()
     {
-        assert(client_ != nullptr);
+        return run_io_task([this]() {
+            assert(client_ != nullptr);
 
-        MessageComposer message_composer;
-        message_composer.push(MessageType::GetObservedSymbols).send(client_);
+            MessageComposer message_composer;
+            message_composer.push(MessageType::GetObservedSymbols)
+                .send(client_);
+
+            auto response =
+                fetch_message(MessageType::GetObservedSymbolsResponse);
+            if (response == nullptr) {
+                return deque<string>();
+            }
+
+            const deque<string>& observed_symbols =
+                static_cast<GetObservedSymbolsResponseMessage*>(response.get())
+                    ->observed_symbols;
+
+            // Buffers removed from the window must be sent in full again
+            const set<string> observed_set(observed_symbols.begin(),
+                                           observed_symbols.end());
+            for (auto it = sent_buffers_.begin(); it != sent_buffers_.end();) {
+                if (observed_set.find(it->first) == observed_set.end()) {
+                    it = sent_buffers_.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+
+            return observed_symbols;
+        });
+    }
+
+    /**
+     * Slice of the tensor buffer last selected in the window, empty if none
+     * was selected
+     */
+    vector<int> get_tensor_slice(const string& variable_name)
+    {
+        lock_guard<mutex> lock(io_mutex_);
+
+        auto tensor_slice = tensor_slices_.find(variable_name);
+        if (tensor_slice == tensor_slices_.end()) {
+            return vector<int>();
+        }
+
+        return tensor_slice->second;
+    }
+
+    /**
+     * Buffers last reported as displayed by the window, the selected one
+     * first
+     */
+    deque<string> get_displayed_buffers()
+    {
+        lock_guard<mutex> lock(io_mutex_);
+        return displayed_buffers_;
+    }
+
+
+    /**
+     * Sends the names added and removed since the previous call, tagged with
+     * the version they apply on top of. Version 0 is the empty list, so the
+     * first update carries every symbol. An unchanged list (e.g. stepping
+     * within the same frame) is sent as an empty update whose version is
+     * equal to its base.
+     */
+    void set_available_symbols(vector<string> available_vars)
+    {
+        auto vars = make_shared<vector<string>>(move(available_vars));
+        post_io_task([this, vars]() {
+            assert(client_ != nullptr);
+
+            set<string> current_symbols(vars->begin(), vars->end());
+
+            vector<string> removed_symbols;
+            set_difference(available_symbols_.begin(),
+                           available_symbols_.end(),
+                           current_symbols.begin(),
+                           current_symbols.end(),
+                           back_inserter(removed_symbols));
+
+            vector<string> added_symbols;
+            set_difference(current_symbols.begin(),
+                           current_symbols.end(),
+                           available_symbols_.begin(),
+                           available_symbols_.end(),
+                           back_inserter(added_symbols));
+
+            const size_t base_version = available_symbols_version_;
+            if (!removed_symbols.empty() || !added_symbols.empty()) {
+                ++available_symbols_version_;
+                available_symbols_.swap(current_symbols);
+            }
+
+            MessageComposer message_composer;
+            message_composer.push(MessageType::UpdateAvailableSymbols)
+                .push(base_version)
+                .push(available_symbols_version_)
+                .push(removed_symbols)
+                .push(added_symbols)
+                .send(client_);
+        });
+    }
+
+    /**
+     * Marks the start (or the end) of a batch of plots, which the window
+     * shows at once. Buffers queued in between are always sent back to back,
+     * as the io thread runs its tasks in order.
+     */
+    void send_plot_batch_marker(bool batch_begins)
+    {
+        post_plot_stream_task([this, batch_begins]() {
+            if (client_ == nullptr) {
+                return;
+            }
+
+            MessageComposer message_composer;
+            message_composer.push(MessageType::PlotBufferBatch)
+                .push(batch_begins)
+                .send(client_);
+        });
+    }
+
+    /**
+     * Supersedes the plots of the previous stops which haven't been sent
+     * yet, and tells the window to drop those it hasn't uploaded yet
+     */
+    void begin_stop()
+    {
+        ++stop_generation_;
+
+        post_plot_stream_task([this]() {
+            if (client_ == nullptr) {
+                return;
+            }
 
-        auto response = fetch_message(MessageType::GetObservedSymbolsResponse);
-        if (response != nullptr) {
-            return static_cast<GetObservedSymbolsResponseMessage*>(
-                       response.get())
-                ->observed_symbols;
+            MessageComposer message_composer;
+            message_composer.push(MessageType::PlotBufferStop).send(client_);
+        });
+    }
+
+    void run_event_loop()
+    {
+        deque<string> plot_errors;
+        {
+            lock_guard<mutex> lock(io_mutex_);
+            plot_errors.swap(plot_errors_);
+        }
+        for (const auto& plot_error : plot_errors) {
+            cerr << "[OpenImageDebugger] " << plot_error << endl;
+        }
+    }
+
+    /**
+     * Copies the buffer into a staging buffer and hands it over to the io
+     * thread, blocking only if max_pending_plots buffers are still queued.
+     * Failures are reported by the next call to run_event_loop().
+     *
+     * Only the width valid pixels of each row are copied, so the buffer is
+     * always sent packed (with row_stride == width) regardless of the
+     * padding between the rows of the source. Values of a target with
+     * another byte order are converted by the same copy.
+     */
+    void queue_plot_buffer(const BufferMetadata& metadata,
+                           const uint8_t* buff_ptr)
+    {
+        size_t pixel_size;
+        int rows;
+        packed_rows(metadata, pixel_size, rows);
+
+        const size_t row_length =
+            static_cast<size_t>(metadata.width) * pixel_size;
+        const size_t pitch =
+            static_cast<size_t>(metadata.row_stride) * pixel_size;
+
+        // Everything done for this plot, in both processes, is traced under
+        // the same id
+        TraceCorrelation correlation(Tracer::instance().next_correlation_id());
+        TraceSpan span("queue_plot_buffer");
+
+        auto contents = acquire_staging_buffer();
+
+        // The source buffer is owned by the debugger and only valid during
+        // the call to oid_plot_buffer
+        contents->resize(row_length * static_cast<size_t>(rows));
+        if (is_byte_swapped(metadata)) {
+            copy_region_swapping_bytes(buff_ptr,
+                                       pitch,
+                                       contents->data(),
+                                       row_length,
+                                       {0, 0, metadata.width, rows},
+                                       pixel_size,
+                                       typesize(metadata.type));
         } else {
-            return {};
+            copy_buffer_region(buff_ptr,
+                               pitch,
+                               contents->data(),
+                               row_length,
+                               {0, 0, metadata.width, rows},
+                               pixel_size);
+        }
+
+        post_plot_task(packed_metadata(metadata), contents, contents->size());
+    }
+
+    /**
+     * Same as queue_plot_buffer, but gathers the rows of the buffer straight
+     * from the memory of a local inferior process.
+     *
+     * @return false, with the reason in error, if part of the buffer could
+     *     not be read
+     */
+    bool queue_plot_process_buffer(const BufferMetadata& metadata,
+                                   int64_t pid,
+                                   uint64_t address,
+                                   string& error)
+    {
+        TraceCorrelation correlation(Tracer::instance().next_correlation_id());
+        TraceSpan span("queue_plot_process_buffer");
+
+        const ProcessBuffer buffer = {metadata, pid, address};
+        if (is_sent_lazily(metadata, packed_length(metadata))) {
+            post_lazy_plot(buffer);
+            return true;
+        }
+
+        auto contents = acquire_staging_buffer();
+
+        if (!read_process_buffer(buffer, *contents, error)) {
+            release_staging_buffer(contents);
+            return false;
         }
+
+        swap_read_bytes(metadata, contents->data(), contents->size());
+
+        post_plot_task(packed_metadata(metadata), contents, contents->size());
+
+        return true;
     }
 
+    /**
+     * Same as queue_plot_process_buffer for several buffers, whose rows are
+     * read in parallel. The buffers are read in groups of at most
+     * max_parallel_read_length bytes, and each group is handed over to the
+     * io thread in the given order once all of its reads are done.
+     *
+     * @return false, with the reasons in error, if any of the buffers could
+     *     not be read. The other ones are queued nonetheless.
+     */
+    bool queue_plot_process_buffers(const vector<ProcessBuffer>& buffers,
+                                    string& error)
+    {
+        TraceSpan span("queue_plot_process_buffers");
+
+        const size_t count = buffers.size();
+
+        vector<size_t> lengths(count);
+        vector<bool> is_lazy(count);
+        for (size_t i = 0; i < count; ++i) {
+            lengths[i] = packed_length(buffers[i].metadata);
+            is_lazy[i] = is_sent_lazily(buffers[i].metadata, lengths[i]);
+        }
+
+        vector<string> errors(count);
+        size_t begin = 0;
+        while (begin < count) {
+            // Buffers sent lazily aren't read, and never end a group
+            size_t end         = begin + 1;
+            size_t read_length = is_lazy[begin] ? 0 : lengths[begin];
+            while (end < count &&
+                   (is_lazy[end] ||
+                    read_length + lengths[end] <= max_parallel_read_length)) {
+                if (!is_lazy[end]) {
+                    read_length += lengths[end];
+                }
+                ++end;
+            }
+
+            // The io thread only holds max_pending_plots staging buffers at
+            // once, so the group is read into buffers of its own
+            vector<vector<uint8_t>> contents(end - begin);
+            vector<char> is_read(end - begin, 0);
+            {
+                TraceSpan read_span("read_process_buffers");
+                ThreadPool::instance().parallel_for(
+                    end - begin, [&](size_t first, size_t last) {
+                        for (size_t i = first; i < last; ++i) {
+                            const size_t index = begin + i;
+                            if (!is_lazy[index]) {
+                                is_read[i] = read_process_buffer(
+                                    buffers[index], contents[i], errors[index]);
+                            }
+                        }
+                    });
+            }
+
+            for (size_t i = 0; i < end - begin; ++i) {
+                const ProcessBuffer& buffer = buffers[begin + i];
+
+                TraceCorrelation correlation(
+                    Tracer::instance().next_correlation_id());
+
+                if (is_lazy[begin + i]) {
+                    post_lazy_plot(buffer);
+                } else if (is_read[i]) {
+                    auto staging = acquire_staging_buffer();
+                    staging->swap(contents[i]);
+
+                    swap_read_bytes(
+                        buffer.metadata, staging->data(), staging->size());
+
+                    post_plot_task(packed_metadata(buffer.metadata),
+                                   staging,
+                                   staging->size());
+                }
+            }
+
+            begin = end;
+        }
 
-    void set_available_symbols(const deque<string>& available_vars)
+        error.clear();
+        for (size_t i = 0; i < count; ++i) {
+            if (!errors[i].empty()) {
+                if (!error.empty()) {
+                    error += '\n';
+                }
+                error += buffers[i].metadata.variable_name + ": " + errors[i];
+            }
+        }
+
+        return error.empty();
+    }
+
+    ~OidBridge()
     {
-        assert(client_ != nullptr);
+        // Transfers to a remote window could keep the debugger waiting for
+        // long, so the plots still queued are dropped
+        if (is_remote()) {
+            ++stop_generation_;
+        }
+
+        // Qt objects must be destroyed by the thread that created them, once
+        // the plot stream is done with the connection
+        std::promise<void> connection_closed;
+        post_plot_stream_task([this, &connection_closed]() {
+            shared_buffers_.clear();
+            client_ = nullptr;
+            server_.reset();
+            connection_closed.set_value();
+        });
+        connection_closed.get_future().wait();
+
+        {
+            lock_guard<mutex> lock(io_mutex_);
+            stop_io_thread_ = true;
+        }
+        io_condition_.notify_all();
+        wake_io_thread();
+        io_thread_.join();
+
+#if !defined(_WIN32)
+        close(wakeup_pipe_[0]);
+        close(wakeup_pipe_[1]);
+#endif
+
+        ui_proc_.kill();
+    }
+
+  private:
+    Process ui_proc_;
+    std::unique_ptr<QTcpServer> server_;
+    QTcpSocket* client_;
+    string oid_path_;
+
+    bool allow_shared_memory_;
+    bool use_shared_memory_;
+    bool allow_delta_updates_;
+    bool use_window_daemon_;
+    // Set if the window is the daemon, which outlives this session
+    bool is_window_shared_;
+    int shared_buffer_counter_;
+    CompressionSettings compression_settings_;
+    std::map<std::string, std::unique_ptr<QSharedMemory>> shared_buffers_;
+
+    std::map<std::string, SentBuffer> sent_buffers_;
+
+    // Buffers at least this large are sent progressively. Zero disables it.
+    size_t progressive_threshold_;
+    // Pending full resolution transfer of each buffer sent progressively.
+    // Only touched by the io thread.
+    std::map<std::string, uint64_t> pending_refinements_;
+    uint64_t refinement_counter_;
+
+    // Buffers of the inferior at least this large are sent lazily. Zero
+    // disables it. Set by the io thread, read by the debugger thread.
+    std::atomic<size_t> lazy_threshold_;
+    // Only touched by the io thread
+    std::map<std::string, ProcessBuffer> lazy_buffers_;
+
+    // Port remote windows connect to, zero if the window is started by the
+    // bridge
+    uint16_t remote_port_;
+    // Remote sessions choose their transport settings from the throughput
+    // of the link, measured by counting the bytes written meanwhile. Only
+    // touched by the io thread.
+    LinkThroughput link_throughput_;
+    uint64_t written_bytes_;
+    // Previews of up to this many bytes are sent. Zero reduces them by
+    // preview_reduction_factor.
+    size_t preview_length_;
+    size_t max_refinement_length_;
+
+    // Bumped by the debugger thread at every stop. Plots queued during a
+    // previous stop are superseded, and dropped before their next message.
+    std::atomic<uint64_t> stop_generation_;
+
+    int (*plot_callback_)(const char*, int);
+
+    MessageStreamReader message_reader_;
+    std::map<MessageType, std::unique_ptr<UiMessage>> received_messages_;
+
+    // Last symbol list sent to the UI. Only touched by the io thread
+    std::set<std::string> available_symbols_;
+    size_t available_symbols_version_;
+
+    // Everything below is shared with the io thread, guarded by io_mutex_
+    std::mutex io_mutex_;
+    std::condition_variable io_condition_;
+    std::deque<std::function<void()>> io_tasks_;
+    // Plots, and the markers ordered with them, of remote sessions. They
+    // only run once no other task is queued.
+    std::deque<std::function<void()>> plot_stream_tasks_;
+    std::deque<std::vector<uint8_t>> staging_buffers_;
+    std::deque<std::string> plot_errors_;
+    // Slice of each tensor buffer selected in the window
+    std::map<std::string, std::vector<int>> tensor_slices_;
+    // Buffers displayed in the window, the selected one first
+    std::deque<std::string> displayed_buffers_;
+    size_t pending_plots_;
+    bool stop_io_thread_;
+
+#if !defined(_WIN32)
+    // Written to whenever a task is queued, so the io thread can sleep on
+    // both the socket and the task queue
+    int wakeup_pipe_[2];
+#endif
+
+    std::thread io_thread_;
+
+    void run_io_thread()
+    {
+        while (true) {
+            std::function<void()> task;
+            bool is_plot_stream_task = false;
+            {
+                lock_guard<mutex> lock(io_mutex_);
+
+                // Queued tasks are always completed before stopping
+                if (!io_tasks_.empty()) {
+                    task = std::move(io_tasks_.front());
+                    io_tasks_.pop_front();
+                } else if (!plot_stream_tasks_.empty()) {
+                    task = std::move(plot_stream_tasks_.front());
+                    plot_stream_tasks_.pop_front();
+                    is_plot_stream_task = true;
+                } else if (stop_io_thread_) {
+                    return;
+                }
+            }
+
+            if (is_plot_stream_task) {
+                run_plot_stream_task(task);
+                continue;
+            }
+
+            if (task) {
+                task();
+                continue;
+            }
+
+            wait_for_io_activity();
+
+            // Requests from the window are handled as soon as they arrive
+            if (client_ != nullptr &&
+                client_->state() == QAbstractSocket::ConnectedState) {
+                try_read_incoming_messages(0);
+            }
+        }
+    }
+
+
+    /**
+     * Blocks the io thread until a task is queued or the window sends data
+     */
+    void wait_for_io_activity()
+    {
+        const bool has_client =
+            client_ != nullptr &&
+            client_->state() == QAbstractSocket::ConnectedState;
+
+        // Data already buffered by the socket doesn't wake poll() up
+        if (has_client && client_->bytesAvailable() > 0) {
+            return;
+        }
+
+#if !defined(_WIN32)
+        if (wakeup_pipe_[0] >= 0) {
+            pollfd fds[2];
+            fds[0].fd      = wakeup_pipe_[0];
+            fds[0].events  = POLLIN;
+            fds[0].revents = 0;
+
+            nfds_t fd_count = 1;
+            if (has_client) {
+                fds[1].fd      = static_cast<int>(client_->socketDescriptor());
+                fds[1].events  = POLLIN;
+                fds[1].revents = 0;
+                fd_count       = 2;
+            }
+
+            poll(fds, fd_count, -1);
+
+            char drained[64];
+            while (read(wakeup_pipe_[0], drained, sizeof(drained)) > 0) {
+            }
+
+            return;
+        }
+#endif
+
+        // Without a wakeup pipe, the socket is checked at short intervals
+        unique_lock<mutex> lock(io_mutex_);
+        io_condition_.wait_for(lock, std::chrono::milliseconds(10), [this]() {
+            return !io_tasks_.empty() || !plot_stream_tasks_.empty() ||
+                   stop_io_thread_;
+        });
+    }
+
+
+    void wake_io_thread()
+    {
+#if !defined(_WIN32)
+        if (wakeup_pipe_[1] >= 0) {
+            const char wakeup = 0;
+            // A full pipe already guarantees a wakeup, so errors are ignored
+            if (write(wakeup_pipe_[1], &wakeup, 1) < 0) {
+            }
+        }
+#endif
+    }
+
+
+    void post_io_task(std::function<void()> task)
+    {
+        {
+            lock_guard<mutex> lock(io_mutex_);
+            io_tasks_.push_back(std::move(task));
+        }
+        io_condition_.notify_all();
+        wake_io_thread();
+    }
+
+
+    /**
+     * Posts a task sending plots, or the markers which must stay ordered
+     * with them. Those of remote sessions let the other tasks run first, so
+     * that interactive requests don't wait behind the transfers of bulk
+     * pixel data.
+     */
+    void post_plot_stream_task(std::function<void()> task)
+    {
+        if (!is_remote()) {
+            post_io_task(std::move(task));
+            return;
+        }
+
+        {
+            lock_guard<mutex> lock(io_mutex_);
+            plot_stream_tasks_.push_back(std::move(task));
+        }
+        io_condition_.notify_all();
+        wake_io_thread();
+    }
+
+
+    /**
+     * Runs a task of the plot stream, measuring the link of remote sessions
+     * with the bytes it sent
+     */
+    void run_plot_stream_task(const std::function<void()>& task)
+    {
+        // Requests of the window arrived meanwhile go first
+        if (client_ != nullptr &&
+            client_->state() == QAbstractSocket::ConnectedState) {
+            try_read_incoming_messages(0);
+        }
+
+        const uint64_t written_before = written_bytes_;
+        const auto begin              = std::chrono::steady_clock::now();
+
+        task();
+
+        const std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - begin;
+        link_throughput_.add_sample(
+            static_cast<size_t>(written_bytes_ - written_before),
+            elapsed.count());
+        adapt_to_link();
+    }
+
+
+    /**
+     * Runs the tasks posted meanwhile between the messages of a long
+     * transfer to a remote window, which would otherwise delay them until
+     * it is complete
+     */
+    void run_priority_io_tasks()
+    {
+        if (!is_remote()) {
+            return;
+        }
+
+        while (true) {
+            std::function<void()> task;
+            {
+                lock_guard<mutex> lock(io_mutex_);
+                if (io_tasks_.empty()) {
+                    return;
+                }
+                task = std::move(io_tasks_.front());
+                io_tasks_.pop_front();
+            }
+
+            task();
+        }
+    }
+
+
+    bool is_remote() const
+    {
+        return remote_port_ != 0;
+    }
+
+
+    /**
+     * Replaces the transport settings of a remote session with those chosen
+     * for the current throughput of its link
+     */
+    void adapt_to_link()
+    {
+        if (!is_remote()) {
+            return;
+        }
+
+        const RemoteTransportSettings settings =
+            choose_remote_transport_settings(
+                link_throughput_.bytes_per_second());
+
+        compression_settings_  = settings.compression;
+        progressive_threshold_ = settings.progressive_threshold;
+        preview_length_        = settings.preview_length;
+        lazy_threshold_        = settings.lazy_threshold;
+        max_refinement_length_ = settings.max_message_length;
+    }
+
+
+    /**
+     * Factor by which the preview of a buffer sent progressively is reduced
+     */
+    int preview_reduction(const BufferMetadata& metadata) const
+    {
+        if (preview_length_ == 0) {
+            return preview_reduction_factor;
+        }
+
+        const double length = static_cast<double>(metadata.width) *
+                              static_cast<double>(metadata.height) *
+                              metadata.channels * typesize(metadata.type);
+        const double ratio = length / static_cast<double>(preview_length_);
+        const int reduction = static_cast<int>(std::ceil(std::sqrt(ratio)));
+
+        return min(max(reduction, preview_reduction_factor),
+                   max_preview_reduction_factor);
+    }
+
+
+    /**
+     * Size of the values copied by the packing of a buffer, and the number
+     * of rows copied. The planes of planar buffers follow each other with
+     * the same row pitch, so they are packed as a single channel image with
+     * the rows of all planes.
+     */
+    static void packed_rows(const BufferMetadata& metadata,
+                            size_t& pixel_size,
+                            int& rows)
+    {
+        pixel_size = typesize(metadata.type);
+        rows       = metadata.height;
+
+        if (metadata.is_planar) {
+            rows *= metadata.channels;
+        } else {
+            pixel_size *= static_cast<size_t>(metadata.channels);
+        }
+    }
+
+
+    static size_t packed_length(const BufferMetadata& metadata)
+    {
+        size_t pixel_size;
+        int rows;
+        packed_rows(metadata, pixel_size, rows);
+
+        return static_cast<size_t>(metadata.width) * pixel_size *
+               static_cast<size_t>(rows);
+    }
+
+
+    /**
+     * Reads the packed rows of a buffer of a local inferior. Can be called
+     * from any thread.
+     */
+    static bool read_process_buffer(const ProcessBuffer& buffer,
+                                    vector<uint8_t>& contents,
+                                    string& error)
+    {
+        const BufferMetadata& metadata = buffer.metadata;
+
+        size_t pixel_size;
+        int rows;
+        packed_rows(metadata, pixel_size, rows);
+
+        const size_t row_length =
+            static_cast<size_t>(metadata.width) * pixel_size;
+        const size_t pitch =
+            static_cast<size_t>(metadata.row_stride) * pixel_size;
+
+        contents.resize(row_length * static_cast<size_t>(rows));
+        return read_process_memory_rows(buffer.pid,
+                                        buffer.address,
+                                        pitch,
+                                        row_length,
+                                        static_cast<size_t>(rows),
+                                        contents.data(),
+                                        error);
+    }
+
+
+    /**
+     * Buffers of the inferior too large to ever be inspected in full are
+     * only announced; the window then requests the tiles it views, which
+     * only address interleaved buffers
+     */
+    bool is_sent_lazily(const BufferMetadata& metadata, size_t length) const
+    {
+        const size_t lazy_threshold = lazy_threshold_;
+        return lazy_threshold > 0 && !metadata.is_planar &&
+               length >= lazy_threshold;
+    }
+
+
+    void post_lazy_plot(const ProcessBuffer& buffer)
+    {
+        const uint64_t generation     = stop_generation_;
+        const uint64_t correlation_id = TraceCorrelation::current();
+
+        post_plot_stream_task([this, buffer, generation, correlation_id]() {
+            TraceCorrelation correlation(correlation_id);
+            if (generation == stop_generation_) {
+                plot_buffer_lazy(buffer.metadata, buffer.pid, buffer.address);
+            }
+        });
+    }
+
+
+    static BufferMetadata packed_metadata(const BufferMetadata& metadata)
+    {
+        BufferMetadata result = metadata;
+        result.row_stride     = metadata.width;
+        result.byte_order     = host_byte_order();
+        return result;
+    }
+
+
+    /**
+     * Converts values read from the memory of a process to the host byte
+     * order, in place. The system calls copying them can't reorder their
+     * bytes, so this takes a pass of its own; local inferiors share the byte
+     * order of the host anyway, unless they are emulated.
+     */
+    static void swap_read_bytes(const BufferMetadata& metadata,
+                                uint8_t* contents,
+                                size_t length)
+    {
+        if (is_byte_swapped(metadata)) {
+            const size_t value_size = typesize(metadata.type);
+            copy_swapping_bytes(
+                contents, value_size, length / value_size, contents);
+        }
+    }
+
+
+    shared_ptr<vector<uint8_t>> acquire_staging_buffer()
+    {
+        auto contents = make_shared<vector<uint8_t>>();
+
+        unique_lock<mutex> lock(io_mutex_);
+        io_condition_.wait(
+            lock, [this]() { return pending_plots_ < max_pending_plots; });
+
+        ++pending_plots_;
+        if (!staging_buffers_.empty()) {
+            contents->swap(staging_buffers_.back());
+            staging_buffers_.pop_back();
+        }
+
+        return contents;
+    }
+
+
+    void release_staging_buffer(const shared_ptr<vector<uint8_t>>& contents)
+    {
+        lock_guard<mutex> lock(io_mutex_);
+
+        staging_buffers_.push_back(std::move(*contents));
+        --pending_plots_;
+        io_condition_.notify_all();
+    }
+
+
+    void post_plot_task(const BufferMetadata& metadata,
+                        const shared_ptr<vector<uint8_t>>& contents,
+                        size_t buff_length)
+    {
+        const uint64_t generation     = stop_generation_;
+        const uint64_t correlation_id = TraceCorrelation::current();
+
+        post_plot_stream_task([this,
+                               metadata,
+                               contents,
+                               buff_length,
+                               generation,
+                               correlation_id]() {
+            TraceCorrelation correlation(correlation_id);
+
+            // The window still holds the contents last sent, which the
+            // plots of the current stop are compared against
+            if (generation != stop_generation_) {
+                release_staging_buffer(contents);
+                return;
+            }
+
+            bool is_preview;
+            {
+                TraceSpan span("plot_buffer");
+                is_preview =
+                    plot_buffer(metadata, contents->data(), buff_length);
+            }
+
+            if (client_ == nullptr ||
+                client_->state() != QAbstractSocket::ConnectedState) {
+                lock_guard<mutex> lock(io_mutex_);
+                plot_errors_.push_back("Could not plot buffer " +
+                                       metadata.display_name +
+                                       ": connection to the window lost");
+            }
+
+            if (!is_preview) {
+                release_staging_buffer(contents);
+                return;
+            }
+
+            // The full resolution tiles are queued behind the tasks already
+            // posted, so that all buffers of a batch show their preview
+            // first
+            const uint64_t refinement = ++refinement_counter_;
+            pending_refinements_[metadata.variable_name] = refinement;
+
+            post_plot_stream_task([this,
+                                   metadata,
+                                   contents,
+                                   refinement,
+                                   generation,
+                                   correlation_id]() {
+                TraceCorrelation correlation(correlation_id);
+                TraceSpan span("plot_buffer_refinement");
+
+                auto pending =
+                    pending_refinements_.find(metadata.variable_name);
+                if (pending != pending_refinements_.end() &&
+                    pending->second == refinement) {
+                    pending_refinements_.erase(pending);
+                    plot_buffer_refinement(
+                        metadata, contents->data(), generation);
+                }
+
+                release_staging_buffer(contents);
+            });
+        });
+    }
+
+
+    template <typename Task>
+    auto run_io_task(Task task) -> decltype(task())
+    {
+        auto packaged_task =
+            make_shared<std::packaged_task<decltype(task())()>>(task);
+        auto result = packaged_task->get_future();
+
+        post_io_task([packaged_task]() { (*packaged_task)(); });
+
+        return result.get();
+    }
+
+
+    /**
+     * @return true if only a preview of the buffer was sent, in which case
+     *     plot_buffer_refinement must send the rest
+     */
+    bool plot_buffer(const BufferMetadata& metadata,
+                     const uint8_t* buff_ptr,
+                     size_t buff_length)
+    {
+        // A newer version replaces the one still being refined, and the
+        // window doesn't have the contents its delta would be based on
+        if (pending_refinements_.erase(metadata.variable_name) > 0) {
+            sent_buffers_.erase(metadata.variable_name);
+        }
+        lazy_buffers_.erase(metadata.variable_name);
+
+        vector<int> dirty_tiles;
+        bool unchanged = false;
+        const bool send_delta =
+            allow_delta_updates_ &&
+            find_dirty_tiles(metadata, buff_ptr, dirty_tiles, unchanged);
+
+        // The window already displays these exact contents
+        if (unchanged) {
+            MessageComposer message_composer;
+            message_composer.push(MessageType::PlotBufferUnchanged)
+                .push(metadata.variable_name)
+                .send(client_);
+            return false;
+        }
+
+        if (use_shared_memory_) {
+            if (send_delta &&
+                plot_buffer_shared_tiles(
+                    metadata, buff_ptr, buff_length, dirty_tiles)) {
+                return false;
+            }
+            if (plot_buffer_shared(metadata, buff_ptr, buff_length)) {
+                return false;
+            }
+        }
+
+        if (send_delta) {
+            plot_buffer_tiles(metadata, buff_ptr, dirty_tiles);
+            return false;
+        }
+
+        // Tiles are addressed through the row stride, so only packed
+        // interleaved buffers can be refined with them
+        if (progressive_threshold_ > 0 &&
+            buff_length >= progressive_threshold_ &&
+            metadata.row_stride == metadata.width && !metadata.is_planar) {
+            plot_buffer_preview(metadata, buff_ptr);
+            return true;
+        }
 
         MessageComposer message_composer;
-        message_composer.push(MessageType::SetAvailableSymbols)
-            .push(available_vars)
+        if (compression_settings_.codec != CompressionCodec::None) {
+            message_composer.push(MessageType::PlotBufferCompressedContents)
+                .push(metadata)
+                .push_compressed(buff_ptr, buff_length, compression_settings_)
+                .send(client_);
+        } else {
+            message_composer.push(MessageType::PlotBufferContents)
+                .push(metadata)
+                .push(buff_ptr, buff_length)
+                .send(client_);
+        }
+
+        return false;
+    }
+
+
+    void plot_buffer_preview(const BufferMetadata& metadata,
+                             const uint8_t* buff_ptr)
+    {
+        const int reduction     = preview_reduction(metadata);
+        const int preview_width = (metadata.width + reduction - 1) / reduction;
+        const int preview_height =
+            (metadata.height + reduction - 1) / reduction;
+        const size_t pixel_size =
+            static_cast<size_t>(metadata.channels) * typesize(metadata.type);
+        const size_t preview_length = static_cast<size_t>(preview_width) *
+                                      static_cast<size_t>(preview_height) *
+                                      pixel_size;
+
+        // Extrema are kept, so isolated outliers are visible from the start
+        vector<uint8_t> preview(preview_length);
+        downsample(buff_ptr,
+                   metadata.type,
+                   metadata.width,
+                   metadata.height,
+                   metadata.channels,
+                   metadata.row_stride,
+                   preview_width,
+                   preview_height,
+                   DownsampleFilter::Extremum,
+                   preview.data());
+
+        MessageComposer message_composer;
+        message_composer.push(MessageType::PlotBufferPreview)
+            .push(metadata)
+            .push(preview_width)
+            .push(preview_height)
+            .push(static_cast<size_t>(
+                buffer_tile_count(metadata.width, metadata.height)))
+            .push_compressed(
+                preview.data(), preview_length, compression_settings_)
             .send(client_);
     }
 
-    void run_event_loop()
+
+    void plot_buffer_lazy(const BufferMetadata& metadata,
+                          int64_t pid,
+                          uint64_t address)
+    {
+        const BufferMetadata packed = packed_metadata(metadata);
+
+        // Nothing the window holds can be the base of a delta anymore
+        pending_refinements_.erase(metadata.variable_name);
+        sent_buffers_.erase(metadata.variable_name);
+        lazy_buffers_[metadata.variable_name] = {metadata, pid, address};
+
+        MessageComposer message_composer;
+        message_composer.push(MessageType::PlotBufferLazy)
+            .push(packed)
+            .send(client_);
+    }
+
+
+    /**
+     * Reads the requested tiles of a lazy buffer from the inferior, keeping
+     * one row and column out of 2^level. Columns are reduced with the
+     * extremum filter, while rows are only sampled, since reading them is
+     * what the level saves.
+     */
+    void handle_plot_buffer_tiles_request(MessageDecoder& message_decoder)
     {
-        try_read_incoming_messages(static_cast<int>(1000.0 / 5.0));
+        string buffer_name;
+        int level;
+        vector<int> tiles;
+        message_decoder.read(buffer_name).read(level).read<vector<int>, int>(
+            tiles);
+
+        auto lazy_buffer = lazy_buffers_.find(buffer_name);
+        if (lazy_buffer == lazy_buffers_.end()) {
+            return;
+        }
+
+        const ProcessBuffer& lazy      = lazy_buffer->second;
+        const BufferMetadata& metadata = lazy.metadata;
+
+        const size_t pixel_size =
+            static_cast<size_t>(metadata.channels) * typesize(metadata.type);
+        const size_t pitch =
+            static_cast<size_t>(metadata.row_stride) * pixel_size;
+        const int tile_count =
+            buffer_tile_count(metadata.width, metadata.height);
+
+        level              = min(max(level, 0), buffer_tile_max_level);
+        const int sampling = 1 << level;
+
+        // Tiles are read and sent in batches of about max_refinement_length_
+        // bytes, which stay alive until their message is sent
+        vector<int> batch_tiles;
+        vector<vector<uint8_t>> batch_contents;
+        size_t batch_length = 0;
+
+        const auto send_batch = [&]() {
+            MessageComposer message_composer;
+            message_composer.push(MessageType::PlotBufferLevelTiles)
+                .push(packed_metadata(metadata))
+                .push(level)
+                .push(batch_tiles.size());
+            for (size_t i = 0; i < batch_tiles.size(); ++i) {
+                message_composer.push(batch_tiles[i])
+                    .push_compressed(batch_contents[i].data(),
+                                     batch_contents[i].size(),
+                                     compression_settings_);
+            }
+            message_composer.send(client_);
+
+            batch_tiles.clear();
+            batch_contents.clear();
+            batch_length = 0;
+
+            run_priority_io_tasks();
+        };
+
+        vector<uint8_t> rows;
+        for (int tile : tiles) {
+            if (tile < 0 || tile >= tile_count) {
+                continue;
+            }
+
+            const BufferRegion region =
+                buffer_tile_region(metadata.width, metadata.height, tile);
+            const size_t row_length =
+                static_cast<size_t>(region.width) * pixel_size;
+            const int sampled_rows  = (region.height + sampling - 1) / sampling;
+            const int reduced_width = (region.width + sampling - 1) / sampling;
+
+            rows.resize(row_length * static_cast<size_t>(sampled_rows));
+
+            string error;
+            if (!read_process_memory_rows(
+                    lazy.pid,
+                    lazy.address + static_cast<uint64_t>(region.y) * pitch +
+                        static_cast<uint64_t>(region.x) * pixel_size,
+                    pitch * static_cast<size_t>(sampling),
+                    row_length,
+                    static_cast<size_t>(sampled_rows),
+                    rows.data(),
+                    error)) {
+                cerr << "[OpenImageDebugger] Could not read tiles of buffer "
+                     << metadata.display_name << ": " << error << endl;
+                break;
+            }
+
+            swap_read_bytes(metadata, rows.data(), rows.size());
+
+            vector<uint8_t> contents;
+            if (level > 0) {
+                contents.resize(static_cast<size_t>(reduced_width) *
+                                static_cast<size_t>(sampled_rows) *
+                                pixel_size);
+                downsample(rows.data(),
+                           metadata.type,
+                           region.width,
+                           sampled_rows,
+                           metadata.channels,
+                           region.width,
+                           reduced_width,
+                           sampled_rows,
+                           DownsampleFilter::Extremum,
+                           contents.data());
+            } else {
+                contents.swap(rows);
+            }
 
-        unique_ptr<UiMessage> plot_request_message;
-        while ((plot_request_message = try_get_stored_message(
-                    MessageType::PlotBufferRequest)) != nullptr) {
-            const PlotBufferRequestMessage* msg =
-                dynamic_cast<PlotBufferRequestMessage*>(
-                    plot_request_message.get());
-            plot_callback_(msg->buffer_name.c_str());
+            batch_length += contents.size();
+            batch_tiles.push_back(tile);
+            batch_contents.push_back(std::move(contents));
+
+            if (batch_length >= max_refinement_length_) {
+                send_batch();
+            }
+        }
+
+        if (!batch_tiles.empty()) {
+            send_batch();
         }
     }
 
-    void plot_buffer(const string& variable_name_str,
-                     const string& display_name_str,
-                     const string& pixel_layout_str,
-                     bool transpose_buffer,
-                     int buff_width,
-                     int buff_height,
-                     int buff_channels,
-                     int buff_stride,
-                     BufferType buff_type,
-                     uint8_t* buff_ptr,
-                     size_t buff_length)
+
+    /**
+     * Sends all tiles of a buffer whose preview was sent, in row major
+     * order, so that the window refines it from the top down. Stops between
+     * two messages once the stop the buffer was plotted in is superseded.
+     */
+    void plot_buffer_refinement(const BufferMetadata& metadata,
+                                const uint8_t* buff_ptr,
+                                uint64_t generation)
+    {
+        const size_t pixel_size =
+            static_cast<size_t>(metadata.channels) * typesize(metadata.type);
+        const int tile_count =
+            buffer_tile_count(metadata.width, metadata.height);
+
+        vector<int> tiles;
+        size_t tiles_length = 0;
+        for (int tile = 0; tile < tile_count; ++tile) {
+            const BufferRegion region =
+                buffer_tile_region(metadata.width, metadata.height, tile);
+
+            tiles.push_back(tile);
+            tiles_length += static_cast<size_t>(region.width) *
+                            static_cast<size_t>(region.height) * pixel_size;
+
+            if (tiles_length >= max_refinement_length_ ||
+                tile + 1 == tile_count) {
+                // The window only holds part of these contents
+                if (generation != stop_generation_) {
+                    sent_buffers_.erase(metadata.variable_name);
+                    return;
+                }
+
+                plot_buffer_tiles(metadata, buff_ptr, tiles);
+                tiles.clear();
+                tiles_length = 0;
+
+                run_priority_io_tasks();
+            }
+        }
+    }
+
+
+
+    QSharedMemory* get_shared_buffer(const string& variable_name,
+                                     size_t buff_length)
+    {
+        auto segment = shared_buffers_.find(variable_name);
+        if (segment != shared_buffers_.end() &&
+            static_cast<size_t>(segment->second->size()) >= buff_length) {
+            return segment->second.get();
+        }
+
+        if (buff_length > static_cast<size_t>(numeric_limits<int>::max())) {
+            return nullptr;
+        }
+
+        // Segments can't be resized, so a bigger buffer gets a new segment
+        // with a fresh key. The UI keeps the previous one mapped until it
+        // has attached to the new segment.
+        const QString key = QString("oid_%1_%2")
+                                .arg(QCoreApplication::applicationPid())
+                                .arg(shared_buffer_counter_++);
+
+        unique_ptr<QSharedMemory> new_segment(new QSharedMemory(key));
+        if (!new_segment->create(static_cast<int>(buff_length))) {
+            cerr << "[OpenImageDebugger] Could not create shared memory "
+                    "segment: "
+                 << new_segment->errorString().toStdString() << endl;
+            return nullptr;
+        }
+
+        QSharedMemory* result         = new_segment.get();
+        shared_buffers_[variable_name] = std::move(new_segment);
+
+        return result;
+    }
+
+
+    bool plot_buffer_shared(const BufferMetadata& metadata,
+                            const uint8_t* buff_ptr,
+                            size_t buff_length)
     {
+        QSharedMemory* segment =
+            get_shared_buffer(metadata.variable_name, buff_length);
+
+        if (segment == nullptr) {
+            return false;
+        }
+
+        segment->lock();
+        memcpy(segment->data(), buff_ptr, buff_length);
+        segment->unlock();
+
         MessageComposer message_composer;
-        message_composer.push(MessageType::PlotBufferContents)
-            .push(variable_name_str)
-            .push(display_name_str)
-            .push(pixel_layout_str)
-            .push(transpose_buffer)
-            .push(buff_width)
-            .push(buff_height)
-            .push(buff_channels)
-            .push(buff_stride)
-            .push(buff_type)
-            .push(buff_ptr, buff_length)
+        message_composer.push(MessageType::PlotBufferSharedContents)
+            .push(metadata)
+            .push(segment->key().toStdString())
+            .push(buff_length)
             .send(client_);
+
+        return true;
     }
 
-    ~OidBridge()
+
+    /**
+     * Compares the tiles of the buffer with the ones last sent for the same
+     * symbol.
+     *
+     * @param unchanged  Set if the window already has the same contents and
+     *     metadata, in which case nothing needs to be sent
+     * @return true if sending only dirty_tiles is enough to update the window
+     */
+    bool find_dirty_tiles(const BufferMetadata& metadata,
+                          const uint8_t* buff_ptr,
+                          vector<int>& dirty_tiles,
+                          bool& unchanged)
     {
-        ui_proc_.kill();
+        unchanged = false;
+
+        // Tiles are addressed through the row stride, which is only covered by
+        // the payload of packed buffers. Planar buffers are always replaced
+        // as a whole, since their tiles don't match regions of the image.
+        if (metadata.row_stride != metadata.width || metadata.is_planar) {
+            sent_buffers_.erase(metadata.variable_name);
+            return false;
+        }
+
+        vector<uint64_t> tile_hashes = compute_tile_hashes(buff_ptr, metadata);
+        const uint64_t buffer_hash =
+            content_hash(tile_hashes.data(),
+                         tile_hashes.size() * sizeof(uint64_t));
+
+        auto previous   = sent_buffers_.find(metadata.variable_name);
+        bool send_delta = previous != sent_buffers_.end() &&
+                          has_same_layout(previous->second.metadata, metadata);
+
+        if (send_delta && previous->second.content_hash == buffer_hash &&
+            previous->second.metadata.display_name == metadata.display_name) {
+            unchanged = true;
+            return true;
+        }
+
+        if (send_delta) {
+            const vector<uint64_t>& previous_hashes =
+                previous->second.tile_hashes;
+            for (size_t tile = 0; tile < tile_hashes.size(); ++tile) {
+                if (tile_hashes[tile] != previous_hashes[tile]) {
+                    dirty_tiles.push_back(static_cast<int>(tile));
+                }
+            }
+
+            // With most of the tiles changed, a full update is just as cheap
+            send_delta = dirty_tiles.size() * 2 <= tile_hashes.size();
+        }
+
+        SentBuffer& sent_buffer = sent_buffers_[metadata.variable_name];
+        sent_buffer.metadata    = metadata;
+        sent_buffer.tile_hashes  = std::move(tile_hashes);
+        sent_buffer.content_hash = buffer_hash;
+
+        return send_delta;
     }
 
-  private:
-    Process ui_proc_;
-    QTcpServer server_;
-    QTcpSocket* client_;
-    string oid_path_;
 
-    int (*plot_callback_)(const char*);
+    void plot_buffer_tiles(const BufferMetadata& metadata,
+                           const uint8_t* buff_ptr,
+                           const vector<int>& dirty_tiles)
+    {
+        const size_t pixel_size =
+            static_cast<size_t>(metadata.channels) * typesize(metadata.type);
+        const size_t pitch =
+            static_cast<size_t>(metadata.row_stride) * pixel_size;
+
+        vector<BufferRegion> regions;
+        size_t tiles_length = 0;
+        for (int tile : dirty_tiles) {
+            regions.push_back(
+                buffer_tile_region(metadata.width, metadata.height, tile));
+            tiles_length += static_cast<size_t>(regions.back().width *
+                                                regions.back().height) *
+                            pixel_size;
+        }
+
+        // Each tile is packed contiguously, so the window doesn't need to
+        // know the stride of the source buffer
+        vector<uint8_t> tiles_contents(tiles_length);
+
+        MessageComposer message_composer;
+        message_composer.push(MessageType::PlotBufferTiles)
+            .push(metadata)
+            .push(dirty_tiles.size());
+
+        uint8_t* tile_contents = tiles_contents.data();
+        for (size_t i = 0; i < dirty_tiles.size(); ++i) {
+            const BufferRegion& region = regions[i];
+            const size_t tile_pitch =
+                static_cast<size_t>(region.width) * pixel_size;
+            const size_t tile_length =
+                tile_pitch * static_cast<size_t>(region.height);
+
+            copy_buffer_region(buff_ptr +
+                                   static_cast<size_t>(region.y) * pitch +
+                                   static_cast<size_t>(region.x) * pixel_size,
+                               pitch,
+                               tile_contents,
+                               tile_pitch,
+                               region,
+                               pixel_size);
+
+            message_composer.push(dirty_tiles[i])
+                .push_compressed(
+                    tile_contents, tile_length, compression_settings_);
+            tile_contents += tile_length;
+        }
+
+        message_composer.send(client_);
+    }
+
+
+    bool plot_buffer_shared_tiles(const BufferMetadata& metadata,
+                                  const uint8_t* buff_ptr,
+                                  size_t buff_length,
+                                  const vector<int>& dirty_tiles)
+    {
+        // Tiles can only be patched into the segment the window already has
+        auto segment = shared_buffers_.find(metadata.variable_name);
+        if (segment == shared_buffers_.end() ||
+            static_cast<size_t>(segment->second->size()) < buff_length) {
+            return false;
+        }
+
+        const size_t pixel_size =
+            static_cast<size_t>(metadata.channels) * typesize(metadata.type);
+        const size_t pitch =
+            static_cast<size_t>(metadata.row_stride) * pixel_size;
+
+        uint8_t* segment_contents =
+            reinterpret_cast<uint8_t*>(segment->second->data());
+
+        MessageComposer message_composer;
+        message_composer.push(MessageType::PlotBufferSharedTiles)
+            .push(metadata)
+            .push(segment->second->key().toStdString())
+            .push(buff_length)
+            .push(dirty_tiles.size());
+
+        segment->second->lock();
+        for (int tile : dirty_tiles) {
+            const BufferRegion region =
+                buffer_tile_region(metadata.width, metadata.height, tile);
+            const size_t offset = static_cast<size_t>(region.y) * pitch +
+                                  static_cast<size_t>(region.x) * pixel_size;
+
+            copy_buffer_region(buff_ptr + offset,
+                               pitch,
+                               segment_contents + offset,
+                               pitch,
+                               region,
+                               pixel_size);
+
+            message_composer.push(tile);
+        }
+        segment->second->unlock();
+
+        message_composer.send(client_);
+
+        return true;
+    }
 
-    std::map<MessageType, std::unique_ptr<UiMessage>> received_messages_;
 
     std::unique_ptr<UiMessage>
     try_get_stored_message(const MessageType& msg_type)
@@ -238,50 +1813,138 @@ class OidBridge
     {
         assert(client_ != nullptr);
 
-        do {
-            client_->waitForReadyRead(msecs);
+        if (!message_reader_.wait_for_message(client_, msecs)) {
+            return;
+        }
 
-            if (client_->bytesAvailable() == 0) {
-                break;
-            }
+        do {
+            MessageDecoder message_decoder = message_reader_.message_decoder();
+            const MessageType header       = message_reader_.message_type();
 
-            MessageType header;
-            client_->read(reinterpret_cast<char*>(&header),
-                          static_cast<qint64>(sizeof(header)));
+            // Work requested by the window is traced under its id
+            TraceCorrelation correlation(message_reader_.correlation_id());
 
             switch (header) {
             case MessageType::PlotBufferRequest:
-                received_messages_[header] = decode_plot_buffer_request();
+                handle_plot_buffer_request(message_decoder);
+                break;
+            case MessageType::PlotBufferTilesRequest:
+                handle_plot_buffer_tiles_request(message_decoder);
+                break;
+            case MessageType::PlotBufferSliceRequest:
+                handle_plot_buffer_slice_request(message_decoder);
+                break;
+            case MessageType::PlotBufferPrefetchRequest:
+                handle_plot_buffer_prefetch_request(message_decoder);
+                break;
+            case MessageType::SetDisplayedBuffers:
+                decode_set_displayed_buffers(message_decoder);
                 break;
             case MessageType::GetObservedSymbolsResponse:
                 received_messages_[header] =
-                    decode_get_observed_symbols_response();
+                    decode_get_observed_symbols_response(message_decoder);
+                break;
+            case MessageType::SetTransportSettings:
+                decode_set_transport_settings(message_decoder);
                 break;
             default:
                 cerr << "[OpenImageDebugger] Received message with incorrect header" << endl;
                 break;
             }
-        } while (client_->bytesAvailable() > 0);
+
+            message_reader_.pop_message();
+        } while (message_reader_.read_available(client_));
     }
 
 
-    unique_ptr<UiMessage> decode_plot_buffer_request()
+    void handle_plot_buffer_request(MessageDecoder& message_decoder)
     {
-        assert(client_ != nullptr);
+        string buffer_name;
+        message_decoder.read(buffer_name);
 
-        auto response = new PlotBufferRequestMessage();
-        MessageDecoder message_decoder(client_);
-        message_decoder.read(response->buffer_name);
-        return unique_ptr<UiMessage>(response);
+        // Buffers requested by the user may not be present in the window
+        // anymore, so they can't be sent as a delta
+        sent_buffers_.erase(buffer_name);
+
+        // The callback only schedules the plot in the debugger thread, which
+        // acquires the GIL by itself
+        plot_callback_(buffer_name.c_str(), 0);
+    }
+
+    /**
+     * Schedules the plot of buffers the window expects to be requested next,
+     * after any other work of the stop
+     */
+    void handle_plot_buffer_prefetch_request(MessageDecoder& message_decoder)
+    {
+        deque<string> buffer_names;
+        message_decoder.read<deque<string>, string>(buffer_names);
+
+        for (const string& buffer_name : buffer_names) {
+            sent_buffers_.erase(buffer_name);
+            plot_callback_(buffer_name.c_str(), 1);
+        }
     }
 
-    unique_ptr<UiMessage> decode_get_observed_symbols_response()
+    /**
+     * Records the slice of a tensor buffer selected in the window, which the
+     * debugger scripts read from then on. It is plotted right away, unless
+     * the window already held it.
+     */
+    void handle_plot_buffer_slice_request(MessageDecoder& message_decoder)
     {
-        assert(client_ != nullptr);
+        string buffer_name;
+        vector<int> tensor_index;
+        bool is_cached;
+        message_decoder.read(buffer_name)
+            .read<vector<int>, int>(tensor_index)
+            .read(is_cached);
+
+        {
+            lock_guard<mutex> lock(io_mutex_);
+            tensor_slices_[buffer_name] = tensor_index;
+        }
 
+        // The window displays another slice than the one last sent, which
+        // can't be the base of a delta nor be refined anymore
+        sent_buffers_.erase(buffer_name);
+        pending_refinements_.erase(buffer_name);
+        lazy_buffers_.erase(buffer_name);
+
+        if (!is_cached) {
+            plot_callback_(buffer_name.c_str(), 0);
+        }
+    }
+
+    void decode_set_displayed_buffers(MessageDecoder& message_decoder)
+    {
+        deque<string> displayed_buffers;
+        message_decoder.read<deque<string>, string>(displayed_buffers);
+
+        lock_guard<mutex> lock(io_mutex_);
+        displayed_buffers_ = move(displayed_buffers);
+    }
+
+    void decode_set_transport_settings(MessageDecoder& message_decoder)
+    {
+        message_decoder.read(compression_settings_.codec)
+            .read(compression_settings_.level)
+            .read(compression_settings_.threshold)
+            .read(progressive_threshold_);
+
+        size_t lazy_threshold;
+        message_decoder.read(lazy_threshold);
+        lazy_threshold_ = lazy_threshold;
+
+        // The link of remote sessions dictates their settings instead
+        adapt_to_link();
+    }
+
+    unique_ptr<UiMessage>
+    decode_get_observed_symbols_response(MessageDecoder& message_decoder)
+    {
         auto response = new GetObservedSymbolsResponseMessage();
 
-        MessageDecoder message_decoder(client_);
         message_decoder.read<std::deque<std::string>, std::string>(
             response->observed_symbols);
 
@@ -304,20 +1967,91 @@ class OidBridge
     }
 
 
-    void wait_for_client()
+    /**
+     * Attaches to the window daemon, or starts it if it isn't running yet. A
+     * daemon busy with another session leaves this one with a window of its
+     * own.
+     */
+    void start_window_daemon_session(vector<string> command)
+    {
+        const WindowDaemonAnswer answer = request_window_daemon_session(
+            server_->serverPort(), window_daemon_timeout_ms);
+
+        if (answer == WindowDaemonAnswer::Accepted) {
+            is_window_shared_ = true;
+            return;
+        }
+
+        if (answer == WindowDaemonAnswer::Refused) {
+            ui_proc_.start(command);
+            ui_proc_.waitForStart();
+            return;
+        }
+
+        // The new daemon serves this session first
+        command.push_back("--daemon");
+        ui_proc_.startDetached(command);
+        is_window_shared_ = true;
+    }
+
+
+    void wait_for_client(int timeout_ms)
     {
         if (client_ == nullptr) {
-            if (!server_.waitForNewConnection(10000)) {
+            if (!server_->waitForNewConnection(timeout_ms)) {
                 cerr << "[OpenImageDebugger] No clients connected to OpenImageDebugger server"
                      << endl;
             }
-            client_ = server_.nextPendingConnection();
+            client_ = server_->nextPendingConnection();
         }
     }
 };
 
 
-AppHandler oid_initialize(int (*plot_callback)(const char*),
+/**
+ * Copies a python list of integers, failing if any element isn't one
+ */
+static bool copy_py_int_list(vector<int>& dst, PyObject* src)
+{
+    const Py_ssize_t size = PyList_Size(src);
+
+    dst.resize(static_cast<size_t>(size));
+    for (Py_ssize_t pos = 0; pos < size; ++pos) {
+        PyObject* item = PyList_GetItem(src, pos);
+        if (PY_INT_CHECK_FUNC(item) == 0) {
+            return false;
+        }
+        dst[static_cast<size_t>(pos)] = static_cast<int>(get_py_int(item));
+    }
+
+    return true;
+}
+
+
+/**
+ * Whether the slice index of a tensor buffer lies within its shape
+ */
+static bool is_valid_tensor_slice(const BufferMetadata& metadata)
+{
+    const vector<int>& shape = metadata.tensor_shape;
+    const vector<int>& index = metadata.tensor_index;
+
+    if (shape.size() != index.size() || shape.size() > OID_MAX_TENSOR_AXES) {
+        return false;
+    }
+
+    for (size_t axis = 0; axis < shape.size(); ++axis) {
+        if (shape[axis] <= 0 || index[axis] < 0 ||
+            index[axis] >= shape[axis]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+AppHandler oid_initialize(int (*plot_callback)(const char*, int),
                           PyObject* optional_parameters)
 {
     PyGILRAII py_gil_raii;
@@ -335,6 +2069,16 @@ AppHandler oid_initialize(int (*plot_callback)(const char*),
      */
     PyObject* py_oid_path =
         PyDict_GetItemString(optional_parameters, "oid_path");
+    PyObject* py_shared_memory =
+        PyDict_GetItemString(optional_parameters, "shared_memory");
+    PyObject* py_delta_updates =
+        PyDict_GetItemString(optional_parameters, "delta_updates");
+    PyObject* py_window_daemon =
+        PyDict_GetItemString(optional_parameters, "window_daemon");
+    PyObject* py_remote_port =
+        PyDict_GetItemString(optional_parameters, "remote_port");
+
+    Tracer::instance().initialize("oid_bridge");
 
     OidBridge* app = new OidBridge(plot_callback);
 
@@ -344,6 +2088,22 @@ AppHandler oid_initialize(int (*plot_callback)(const char*),
         app->set_path(oid_path_str);
     }
 
+    if (py_shared_memory) {
+        app->set_shared_memory_allowed(PyObject_IsTrue(py_shared_memory) == 1);
+    }
+
+    if (py_delta_updates) {
+        app->set_delta_updates_allowed(PyObject_IsTrue(py_delta_updates) == 1);
+    }
+
+    if (py_window_daemon) {
+        app->set_window_daemon_used(PyObject_IsTrue(py_window_daemon) == 1);
+    }
+
+    if (py_remote_port && PY_INT_CHECK_FUNC(py_remote_port)) {
+        app->set_remote_port(static_cast<uint16_t>(get_py_int(py_remote_port)));
+    }
+
     return static_cast<AppHandler>(app);
 }
 
@@ -360,7 +2120,12 @@ void oid_cleanup(AppHandler handler)
         return;
     }
 
+    // The io thread may be waiting for the GIL to call plot_callback
+    PyGILReleaseRAII py_gil_release_raii;
+
     delete app;
+
+    Tracer::instance().finish();
 }
 
 
@@ -376,6 +2141,8 @@ void oid_exec(AppHandler handler)
         return;
     }
 
+    PyGILReleaseRAII py_gil_release_raii;
+
     app->start();
 }
 
@@ -392,6 +2159,8 @@ int oid_is_window_ready(AppHandler handler)
         return 0;
     }
 
+    PyGILReleaseRAII py_gil_release_raii;
+
     return app->is_window_ready();
 }
 
@@ -409,7 +2178,12 @@ PyObject* oid_get_observed_buffers(AppHandler handler)
         return nullptr;
     }
 
-    auto observed_symbols = app->get_observed_symbols();
+    deque<string> observed_symbols;
+    {
+        PyGILReleaseRAII py_gil_release_raii;
+        observed_symbols = app->get_observed_symbols();
+    }
+
     PyObject* py_observed_symbols =
         PyList_New(static_cast<Py_ssize_t>(observed_symbols.size()));
 
@@ -445,15 +2219,87 @@ void oid_set_available_symbols(AppHandler handler, PyObject* available_vars_py)
         return;
     }
 
-    deque<string> available_vars_stl;
-    for (Py_ssize_t pos = 0; pos < PyList_Size(available_vars_py); ++pos) {
-        string var_name_str;
+    const Py_ssize_t symbol_count = PyList_Size(available_vars_py);
+    vector<string> available_vars_stl(static_cast<size_t>(symbol_count));
+    for (Py_ssize_t pos = 0; pos < symbol_count; ++pos) {
         PyObject* listItem = PyList_GetItem(available_vars_py, pos);
-        copy_py_string(var_name_str, listItem);
-        available_vars_stl.push_back(var_name_str);
+        copy_py_string(available_vars_stl[static_cast<size_t>(pos)], listItem);
+    }
+
+    app->set_available_symbols(move(available_vars_stl));
+}
+
+
+PyObject* oid_get_tensor_slice(AppHandler handler, const char* variable_name)
+{
+    PyGILRAII py_gil_raii;
+
+    OidBridge* app = static_cast<OidBridge*>(handler);
+
+    if (app == nullptr || variable_name == nullptr) {
+        RAISE_PY_EXCEPTION(PyExc_RuntimeError,
+                           "oid_get_tensor_slice received null application "
+                           "handler or variable name");
+        return nullptr;
+    }
+
+    const vector<int> tensor_index = app->get_tensor_slice(variable_name);
+    if (tensor_index.empty()) {
+        Py_RETURN_NONE;
+    }
+
+    PyObject* py_tensor_index =
+        PyList_New(static_cast<Py_ssize_t>(tensor_index.size()));
+    if (py_tensor_index == nullptr) {
+        return nullptr;
+    }
+
+    for (size_t axis = 0; axis < tensor_index.size(); ++axis) {
+        PyList_SetItem(py_tensor_index,
+                       static_cast<Py_ssize_t>(axis),
+                       PyLong_FromLong(tensor_index[axis]));
+    }
+
+    return py_tensor_index;
+}
+
+
+PyObject* oid_get_displayed_buffers(AppHandler handler)
+{
+    PyGILRAII py_gil_raii;
+
+    OidBridge* app = static_cast<OidBridge*>(handler);
+
+    if (app == nullptr) {
+        RAISE_PY_EXCEPTION(PyExc_RuntimeError,
+                           "oid_get_displayed_buffers received null "
+                           "application handler");
+        return nullptr;
+    }
+
+    const deque<string> displayed_buffers = app->get_displayed_buffers();
+
+    PyObject* py_displayed_buffers =
+        PyList_New(static_cast<Py_ssize_t>(displayed_buffers.size()));
+    if (py_displayed_buffers == nullptr) {
+        return nullptr;
+    }
+
+    for (size_t i = 0; i < displayed_buffers.size(); ++i) {
+        PyObject* py_buffer_name =
+            PyBytes_FromString(displayed_buffers[i].c_str());
+
+        if (py_buffer_name == nullptr) {
+            Py_DECREF(py_displayed_buffers);
+            return nullptr;
+        }
+
+        PyList_SetItem(py_displayed_buffers,
+                       static_cast<Py_ssize_t>(i),
+                       py_buffer_name);
     }
 
-    app->set_available_symbols(available_vars_stl);
+    return py_displayed_buffers;
 }
 
 
@@ -474,6 +2320,71 @@ void oid_run_event_loop(AppHandler handler)
 }
 
 
+void oid_trace_span(AppHandler handler,
+                    const char* name,
+                    double begin_time,
+                    double end_time)
+{
+    if (handler == nullptr || name == nullptr) {
+        RAISE_PY_EXCEPTION(PyExc_RuntimeError,
+                           "oid_trace_span received null application "
+                           "handler or name");
+        return;
+    }
+
+    Tracer::instance().complete_span(
+        name,
+        TraceCorrelation::current(),
+        static_cast<int64_t>(begin_time * 1e6),
+        static_cast<int64_t>(end_time * 1e6));
+}
+
+
+void oid_begin_stop(AppHandler handler)
+{
+    OidBridge* app = static_cast<OidBridge*>(handler);
+
+    if (app == nullptr) {
+        RAISE_PY_EXCEPTION(PyExc_RuntimeError,
+                           "oid_begin_stop received null application "
+                           "handler");
+        return;
+    }
+
+    app->begin_stop();
+}
+
+
+void oid_begin_plot_batch(AppHandler handler)
+{
+    OidBridge* app = static_cast<OidBridge*>(handler);
+
+    if (app == nullptr) {
+        RAISE_PY_EXCEPTION(PyExc_RuntimeError,
+                           "oid_begin_plot_batch received null application "
+                           "handler");
+        return;
+    }
+
+    app->send_plot_batch_marker(true);
+}
+
+
+void oid_end_plot_batch(AppHandler handler)
+{
+    OidBridge* app = static_cast<OidBridge*>(handler);
+
+    if (app == nullptr) {
+        RAISE_PY_EXCEPTION(PyExc_RuntimeError,
+                           "oid_end_plot_batch received null application "
+                           "handler");
+        return;
+    }
+
+    app->send_plot_batch_marker(false);
+}
+
+
 void oid_plot_buffer(AppHandler handler, PyObject* buffer_metadata)
 {
     PyGILRAII py_gil_raii;
@@ -522,6 +2433,61 @@ void oid_plot_buffer(AppHandler handler, PyObject* buffer_metadata)
         transpose_buffer = PyObject_IsTrue(py_transpose_buffer);
     }
 
+    PyObject* py_planar = PyDict_GetItemString(buffer_metadata, "planar");
+    bool is_planar      = false;
+    if (py_planar != nullptr) {
+        CHECK_FIELD_TYPE(planar, PyBool_Check, "planar");
+        is_planar = PyObject_IsTrue(py_planar);
+    }
+
+    PyObject* py_endianness =
+        PyDict_GetItemString(buffer_metadata, "endianness");
+    ByteOrder byte_order = host_byte_order();
+    if (py_endianness != nullptr) {
+        CHECK_FIELD_TYPE(endianness, check_py_string_type, "plot_buffer");
+
+        string endianness;
+        copy_py_string(endianness, py_endianness);
+        if (endianness == "little") {
+            byte_order = ByteOrder::LittleEndian;
+        } else if (endianness == "big") {
+            byte_order = ByteOrder::BigEndian;
+        } else {
+            RAISE_PY_EXCEPTION(PyExc_ValueError,
+                               "Invalid buffer given to plot_buffer "
+                               "(endianness must be 'little' or 'big')");
+            return;
+        }
+    }
+
+    PyObject* py_inferior_pid =
+        PyDict_GetItemString(buffer_metadata, "inferior_pid");
+    int64_t inferior_pid = 0;
+    if (py_inferior_pid != nullptr) {
+        CHECK_FIELD_TYPE(inferior_pid, PY_INT_CHECK_FUNC, "plot_buffer");
+        inferior_pid = get_py_int(py_inferior_pid);
+    }
+
+    PyObject* py_tensor_shape =
+        PyDict_GetItemString(buffer_metadata, "tensor_shape");
+    PyObject* py_tensor_index =
+        PyDict_GetItemString(buffer_metadata, "tensor_index");
+    vector<int> tensor_shape;
+    vector<int> tensor_index;
+    if (py_tensor_shape != nullptr) {
+        CHECK_FIELD_PROVIDED(tensor_index, "plot_buffer");
+        CHECK_FIELD_TYPE(tensor_shape, PyList_Check, "plot_buffer");
+        CHECK_FIELD_TYPE(tensor_index, PyList_Check, "plot_buffer");
+
+        if (!copy_py_int_list(tensor_shape, py_tensor_shape) ||
+            !copy_py_int_list(tensor_index, py_tensor_index)) {
+            RAISE_PY_EXCEPTION(PyExc_TypeError,
+                               "Elements of tensor_shape and tensor_index "
+                               "given to plot_buffer must be integers");
+            return;
+        }
+    }
+
     /*
      * Check if expected fields were provided
      */
@@ -557,8 +2523,20 @@ void oid_plot_buffer(AppHandler handler, PyObject* buffer_metadata)
 #endif
 
     // Retrieve pointer to buffer
-    uint8_t* buff_ptr;
-    if (PyMemoryView_Check(py_pointer) != 0) {
+    uint8_t* buff_ptr     = nullptr;
+    uint64_t buff_address = 0;
+    if (inferior_pid != 0) {
+        // The pointer is an address in the inferior, read by the bridge
+        PyObject* py_address = PyNumber_Long(py_pointer);
+        if (py_address == nullptr) {
+            RAISE_PY_EXCEPTION(PyExc_TypeError,
+                               "Could not retrieve address of provided "
+                               "buffer");
+            return;
+        }
+        buff_address = PyLong_AsUnsignedLongLong(py_address);
+        Py_DECREF(py_address);
+    } else if (PyMemoryView_Check(py_pointer) != 0) {
         buff_ptr =
             reinterpret_cast<uint8_t*>(get_c_ptr_from_py_buffer(py_pointer));
     }
@@ -578,34 +2556,175 @@ void oid_plot_buffer(AppHandler handler, PyObject* buffer_metadata)
     /*
      * Send buffer contents
      */
-    string variable_name_str;
-    string display_name_str;
-    string pixel_layout_str;
-
-    copy_py_string(variable_name_str, py_variable_name);
-    copy_py_string(display_name_str, py_display_name);
-    copy_py_string(pixel_layout_str, py_pixel_layout);
-
-    auto buff_width    = static_cast<int>(get_py_int(py_width));
-    auto buff_height   = static_cast<int>(get_py_int(py_height));
-    auto buff_channels = static_cast<int>(get_py_int(py_channels));
-    auto buff_stride   = static_cast<int>(get_py_int(py_row_stride));
-
-    BufferType buff_type = static_cast<BufferType>(get_py_int(py_type));
-
-    size_t buff_length =
-        static_cast<size_t>(buff_width * buff_height * buff_channels) *
-        typesize(buff_type);
-
-    app->plot_buffer(variable_name_str,
-                     display_name_str,
-                     pixel_layout_str,
-                     transpose_buffer,
-                     buff_width,
-                     buff_height,
-                     buff_channels,
-                     buff_stride,
-                     buff_type,
-                     buff_ptr,
-                     buff_length);
+    BufferMetadata metadata;
+
+    copy_py_string(metadata.variable_name, py_variable_name);
+    copy_py_string(metadata.display_name, py_display_name);
+    copy_py_string(metadata.pixel_layout, py_pixel_layout);
+
+    metadata.transpose_buffer = transpose_buffer;
+    metadata.is_planar        = is_planar;
+    metadata.width            = static_cast<int>(get_py_int(py_width));
+    metadata.height           = static_cast<int>(get_py_int(py_height));
+    metadata.channels         = static_cast<int>(get_py_int(py_channels));
+    metadata.row_stride       = static_cast<int>(get_py_int(py_row_stride));
+    metadata.type             = static_cast<BufferType>(get_py_int(py_type));
+    metadata.tensor_shape     = std::move(tensor_shape);
+    metadata.tensor_index     = std::move(tensor_index);
+    metadata.byte_order       = byte_order;
+
+    if (metadata.row_stride < metadata.width) {
+        RAISE_PY_EXCEPTION(PyExc_ValueError,
+                           "Invalid buffer given to plot_buffer (row_stride "
+                           "is smaller than width)");
+        return;
+    }
+
+    if (!is_valid_tensor_slice(metadata)) {
+        RAISE_PY_EXCEPTION(PyExc_ValueError,
+                           "Invalid buffer given to plot_buffer "
+                           "(tensor_index is out of tensor_shape)");
+        return;
+    }
+
+    if (inferior_pid != 0) {
+        string error;
+        bool queued;
+        {
+            PyGILReleaseRAII py_gil_release_raii;
+            queued = app->queue_plot_process_buffer(
+                metadata, inferior_pid, buff_address, error);
+        }
+
+        if (!queued) {
+            RAISE_PY_EXCEPTION(PyExc_RuntimeError, error.c_str());
+        }
+        return;
+    }
+
+    PyGILReleaseRAII py_gil_release_raii;
+
+    app->queue_plot_buffer(metadata, buff_ptr);
+}
+
+
+/**
+ * Builds the metadata of a buffer described by an OidBufferDescriptor
+ *
+ * @return nullptr, or the reason why the descriptor is invalid
+ */
+static const char* parse_buffer_descriptor(
+    const OidBufferDescriptor* descriptor,
+    BufferMetadata& metadata)
+{
+    if (descriptor == nullptr || descriptor->variable_name == nullptr ||
+        descriptor->display_name == nullptr ||
+        descriptor->pixel_layout == nullptr || descriptor->inferior_pid == 0) {
+        return "Invalid buffer descriptor";
+    }
+
+    metadata.variable_name    = descriptor->variable_name;
+    metadata.display_name     = descriptor->display_name;
+    metadata.pixel_layout     = descriptor->pixel_layout;
+    metadata.transpose_buffer = descriptor->transpose_buffer != 0;
+    metadata.is_planar        = descriptor->planar != 0;
+    metadata.width            = descriptor->width;
+    metadata.height           = descriptor->height;
+    metadata.channels         = descriptor->channels;
+    metadata.row_stride       = descriptor->row_stride;
+    metadata.type             = static_cast<BufferType>(descriptor->type);
+
+    if (descriptor->tensor_axes < 0 ||
+        descriptor->tensor_axes > OID_MAX_TENSOR_AXES) {
+        return "Invalid buffer descriptor (too many tensor axes)";
+    }
+    metadata.tensor_shape.assign(
+        descriptor->tensor_shape,
+        descriptor->tensor_shape + descriptor->tensor_axes);
+    metadata.tensor_index.assign(
+        descriptor->tensor_index,
+        descriptor->tensor_index + descriptor->tensor_axes);
+
+    if (metadata.row_stride < metadata.width) {
+        return "Invalid buffer descriptor (row_stride is smaller than width)";
+    }
+
+    if (!is_valid_tensor_slice(metadata)) {
+        return "Invalid buffer descriptor (tensor_index is out of "
+               "tensor_shape)";
+    }
+
+    return nullptr;
+}
+
+
+void oid_plot_buffer_descriptor(AppHandler handler,
+                                const OidBufferDescriptor* descriptor)
+{
+    OidBridge* app = static_cast<OidBridge*>(handler);
+
+    if (app == nullptr) {
+        RAISE_PY_EXCEPTION(PyExc_RuntimeError,
+                           "oid_plot_buffer_descriptor received null "
+                           "application handler");
+        return;
+    }
+
+    BufferMetadata metadata;
+    const char* invalid_reason = parse_buffer_descriptor(descriptor, metadata);
+    if (invalid_reason != nullptr) {
+        RAISE_PY_EXCEPTION(PyExc_ValueError, invalid_reason);
+        return;
+    }
+
+    string error;
+    if (!app->queue_plot_process_buffer(metadata,
+                                        descriptor->inferior_pid,
+                                        descriptor->address,
+                                        error)) {
+        RAISE_PY_EXCEPTION(PyExc_RuntimeError, error.c_str());
+    }
+}
+
+
+void oid_plot_buffer_descriptors(AppHandler handler,
+                                 const OidBufferDescriptor* descriptors,
+                                 int count)
+{
+    OidBridge* app = static_cast<OidBridge*>(handler);
+
+    if (app == nullptr) {
+        RAISE_PY_EXCEPTION(PyExc_RuntimeError,
+                           "oid_plot_buffer_descriptors received null "
+                           "application handler");
+        return;
+    }
+
+    if (count < 0 || (descriptors == nullptr && count > 0)) {
+        RAISE_PY_EXCEPTION(PyExc_ValueError,
+                           "Invalid descriptors given to "
+                           "oid_plot_buffer_descriptors");
+        return;
+    }
+
+    // Nothing is plotted if any of the descriptors is invalid
+    vector<ProcessBuffer> buffers(static_cast<size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        ProcessBuffer& buffer = buffers[static_cast<size_t>(i)];
+
+        const char* invalid_reason =
+            parse_buffer_descriptor(&descriptors[i], buffer.metadata);
+        if (invalid_reason != nullptr) {
+            RAISE_PY_EXCEPTION(PyExc_ValueError, invalid_reason);
+            return;
+        }
+
+        buffer.pid     = descriptors[i].inferior_pid;
+        buffer.address = descriptors[i].address;
+    }
+
+    string error;
+    if (!app->queue_plot_process_buffers(buffers, error)) {
+        RAISE_PY_EXCEPTION(PyExc_RuntimeError, error.c_str());
+    }
 }
@@ -46,17 +46,63 @@ extern "C" {
 typedef void* AppHandler;
 
 
+/**
+ * Most leading axes of a tensor buffer, beyond the two or three of its slices
+ */
+#define OID_MAX_TENSOR_AXES 8
+
+
+/**
+ * Compact description of a buffer living in the memory of a local inferior,
+ * given to oid_plot_buffer_descriptor and oid_plot_buffer_descriptors. The
+ * fields have the same meaning as the homonymous elements of the dictionary
+ * given to oid_plot_buffer.
+ */
+typedef struct OidBufferDescriptor
+{
+    const char* variable_name;
+    const char* display_name;
+    const char* pixel_layout;
+    uint64_t address;
+    int64_t inferior_pid;
+    int32_t width;
+    int32_t height;
+    int32_t channels;
+    int32_t type;
+    int32_t row_stride;
+    int32_t transpose_buffer;
+    int32_t planar;
+    // Leading axes of tensor buffers, zero for plain buffers
+    int32_t tensor_axes;
+    int32_t tensor_shape[OID_MAX_TENSOR_AXES];
+    int32_t tensor_index[OID_MAX_TENSOR_AXES];
+} OidBufferDescriptor;
+
+
 /**
  * Initialize OID application
  *
  * @param plot_callback  Callback function to be called when the user requests
- *     a symbol name from the OpenImageDebugger window
+ *     a symbol name from the OpenImageDebugger window. It is called from a
+ *     thread owned by the bridge as soon as the request arrives, and must
+ *     only schedule the plot in the debugger thread. Its second argument is
+ *     nonzero for buffers the window prefetches while the user types their
+ *     name, which are plotted after any other work of the stop.
  * @param optional_parameters  Dictionary with the following optional members:
  *   - oid_path  Path where the plugin is located
+ *   - shared_memory  If false, buffers are always sent through the socket,
+ *       even to a window running on the same host. Defaults to true
+ *   - delta_updates  If false, every plot sends the whole buffer instead of
+ *       only the tiles changed since it was last sent. Defaults to true
+ *   - window_daemon  If true, the session attaches to the window daemon,
+ *       which outlives it, and starts it if needed. Defaults to false
+ *   - remote_port  If given, no window is started. The bridge waits for one
+ *       to connect to this port from another host, and adapts its
+ *       transport settings to the throughput of the link
  * @return  Application context
  */
 OID_API
-AppHandler oid_initialize(int (*plot_callback)(const char*),
+AppHandler oid_initialize(int (*plot_callback)(const char*, int),
                           PyObject* optional_parameters);
 
 /**
@@ -118,11 +164,40 @@ void oid_set_available_symbols(AppHandler handler,
                                PyObject* available_vars);
 
 
+/**
+ * Get the slice of a tensor buffer selected in the window
+ *
+ * The debugger scripts read this slice, and only this one, the next time the
+ * buffer is plotted.
+ *
+ * @param handler  Window handler, generated by oid_initialize()
+ * @param variable_name  Name of the tensor buffer
+ * @return  Python list with the index of the slice along each leading axis,
+ *     or None if no slice of the buffer was selected
+ */
+OID_API
+PyObject* oid_get_tensor_slice(AppHandler handler, const char* variable_name);
+
+
+/**
+ * Get the buffers displayed in the window
+ *
+ * The debugger scripts plot these buffers before any other at each stop.
+ *
+ * @param handler  Window handler, generated by oid_initialize()
+ * @return  Python list with the names of the displayed buffers, the selected
+ *     one first
+ */
+OID_API
+PyObject* oid_get_displayed_buffers(AppHandler handler);
+
+
 /**
  * Process pending events related to communication with UI
  *
- * Must be called in order for requests from the UI to reach the debugger
- * bridge.
+ * Reports failures of previous calls to oid_plot_buffer, which are completed
+ * asynchronously. Requests from the UI don't depend on this function, as they
+ * are forwarded to plot_callback as soon as they arrive.
  *
  * @param handler  Window handler, generated by oid_initialize()
  */
@@ -130,12 +205,66 @@ OID_API
 void oid_run_event_loop(AppHandler handler);
 
 
+/**
+ * Record a span of the debugger scripts in the trace of the bridge
+ *
+ * Spans are only written if OID_TRACE_DIR was set when the bridge was
+ * initialized.
+ *
+ * @param handler     Window handler, generated by oid_initialize()
+ * @param name        Name of the span
+ * @param begin_time  Start of the span, in seconds since the epoch
+ * @param end_time    End of the span, in seconds since the epoch
+ */
+OID_API
+void oid_trace_span(AppHandler handler,
+                    const char* name,
+                    double begin_time,
+                    double end_time);
+
+
+/**
+ * Notify the bridge that the debugger has stopped again
+ *
+ * Buffers plotted in the previous stops that are still being sent are
+ * superseded by the plots of the new stop, and dropped at the next message
+ * boundary.
+ *
+ * @param handler  Window handler, generated by oid_initialize()
+ */
+OID_API
+void oid_begin_stop(AppHandler handler);
+
+
+/**
+ * Start a batch of plots
+ *
+ * Buffers given to oid_plot_buffer and oid_plot_buffer_descriptor until the
+ * matching call to oid_end_plot_batch are streamed back to back, and shown
+ * by the window in a single update.
+ *
+ * @param handler  Window handler, generated by oid_initialize()
+ */
+OID_API
+void oid_begin_plot_batch(AppHandler handler);
+
+
+/**
+ * Finish the batch of plots started by oid_begin_plot_batch
+ *
+ * @param handler  Window handler, generated by oid_initialize()
+ */
+OID_API
+void oid_end_plot_batch(AppHandler handler);
+
+
 /**
  * Add a buffer to the plot list
  *
  * @param handler  Handler of the window where the buffer should be plotted
  * @param buffer_metadata  Python dictionary with the following elements:
- *     - [pointer     ] PyMemoryView object wrapping the target buffer
+ *     - [pointer     ] PyMemoryView object wrapping the target buffer, or
+ *                      its address if inferior_pid is given
  *     - [display_name] Variable name as it shall be displayed
  *     - [width       ] Buffer width, in pixels
  *     - [height      ] Buffer height, in pixels
@@ -143,10 +272,55 @@ void oid_run_event_loop(AppHandler handler);
  *     - [type        ] Buffer type (see symbols.py for details)
  *     - [row_stride  ] Row stride, in pixels
  *     - [pixel_layout] String defining pixel channel layout (e.g. 'rgba')
+ *     - [planar      ] Optional boolean, set if each channel is stored in
+ *                      its own plane of row_stride * height values, the
+ *                      planes following each other (e.g. CHW tensors)
+ *     - [endianness  ] Optional byte order of the values, either 'little' or
+ *                      'big'. Defaults to the one of the host
+ *     - [inferior_pid] Optional id of a local process whose memory contains
+ *                      the buffer, which is then read by the bridge itself
+ *     - [tensor_shape] Optional list with the sizes of the leading axes of a
+ *                      tensor, outermost first, of which the buffer is a
+ *                      slice. At most OID_MAX_TENSOR_AXES axes are allowed
+ *     - [tensor_index] Index of the slice along each axis of tensor_shape,
+ *                      required along with it
  * */
 OID_API
 void oid_plot_buffer(AppHandler handler, PyObject* bufffer_metadata);
 
+/**
+ * Add a buffer to the plot list, reading its contents from the memory of a
+ * local inferior
+ *
+ * Same as oid_plot_buffer with the inferior_pid element, but without the
+ * cost of building and parsing a python dictionary for each buffer.
+ *
+ * @param handler  Handler of the window where the buffer should be plotted
+ * @param descriptor  Metadata of the buffer, where address is the location
+ *     of its contents in the memory of the process inferior_pid
+ */
+OID_API
+void oid_plot_buffer_descriptor(AppHandler handler,
+                                const OidBufferDescriptor* descriptor);
+
+/**
+ * Add several buffers to the plot list, reading their contents from the
+ * memory of local inferiors
+ *
+ * Same as calling oid_plot_buffer_descriptor for each of them in order, but
+ * their contents are read in parallel. If a descriptor is invalid, none of
+ * the buffers is plotted. Buffers that can't be read are reported together
+ * by a single exception, once the other ones are queued.
+ *
+ * @param handler  Handler of the window where the buffers should be plotted
+ * @param descriptors  Array with the metadata of each buffer
+ * @param count  Number of descriptors in the array
+ */
+OID_API
+void oid_plot_buffer_descriptors(AppHandler handler,
+                                 const OidBufferDescriptor* descriptors,
+                                 int count);
+
 #ifdef __cplusplus
 }
 #endif
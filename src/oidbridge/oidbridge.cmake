@@ -26,9 +26,20 @@ cmake_minimum_required(VERSION 3.10.0)
 add_library(${PROJECT_NAME} SHARED
             ../oid_bridge.cpp
             ../../debuggerinterface/python_native_interface.cpp
+            ../../ipc/buffer_tiles.cpp
+            ../../ipc/compression.cpp
+            ../../ipc/content_hash.cpp
+            ../../ipc/link_throughput.cpp
             ../../ipc/message_exchange.cpp
             ../../ipc/raw_data_decode.cpp
+            ../../ipc/window_daemon.cpp
+            ../../math/byte_swap.cpp
+            ../../math/downsample.cpp
+            ../../system/memory/host_buffer_pool.cpp
+            ../../system/memory/process_memory.cpp
             ../../system/process/process.cpp
+            ../../system/thread/thread_pool.cpp
+            ../../system/trace/tracer.cpp
             $<$<BOOL:${UNIX}>:../../system/process/process_unix.cpp>
             $<$<BOOL:${WIN32}>:../../system/process/process_win32.cpp>)
 
@@ -45,6 +56,7 @@ target_link_libraries(${PROJECT_NAME} PRIVATE
                       Qt5::Core
                       Qt5::Network
                       Threads::Threads
+                      ZLIB::ZLIB
                       ${PYTHON_LIBRARY})
 
 install(TARGETS ${PROJECT_NAME} DESTINATION OpenImageDebugger)
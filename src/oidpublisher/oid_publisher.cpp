@@ -0,0 +1,625 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "oid_publisher.h"
+#include "ipc/message_exchange.h"
+#include "system/memory/device_memory.h"
+#include "system/process/process.h"
+
+#include <QCoreApplication>
+#include <QSharedMemory>
+#include <QString>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+
+using namespace std;
+
+namespace {
+
+const int client_timeout_ms = 10000;
+
+// Interval at which the io thread checks for new frames and for messages of
+// the window while it is idle
+const int poll_interval_ms = 5;
+
+// Buffers that can be published during the lifetime of the publisher
+const int max_streams = 256;
+
+// Set in Stream::ready_frame when the frame it points to wasn't taken yet
+const unsigned fresh_frame = 4;
+
+
+struct Frame
+{
+    // Always packed, so row_stride == width
+    BufferMetadata metadata;
+    vector<uint8_t> contents;
+};
+
+
+/**
+ * Frames of a published buffer, handed over from the producer to the io
+ * thread without locks. The producer fills write_frame and the io thread
+ * sends sent_frame, while ready_frame holds the latest complete frame. Either
+ * side swaps its frame with the ready one atomically, so frames published
+ * while the window is busy replace each other.
+ */
+struct Stream
+{
+    explicit Stream(const string& stream_name)
+        : name{stream_name}
+        , ready_frame{1}
+        , write_frame{0}
+        , sent_frame{2}
+        , has_sent_frame{false}
+        , is_observed{true}
+        , is_requested{false}
+    {
+    }
+
+    const string name;
+    Frame frames[3];
+    atomic<unsigned> ready_frame;
+
+    // Only accessed by the producer
+    unsigned write_frame;
+
+    // Only accessed by the io thread
+    unsigned sent_frame;
+    bool has_sent_frame;
+    // Closed buffers are only sent again once the window requests them
+    bool is_observed;
+    bool is_requested;
+    unique_ptr<QSharedMemory> segment;
+};
+
+
+class OidPublisher
+{
+  public:
+    OidPublisher()
+        : client_{nullptr}
+        , use_shared_memory_{false}
+        , is_waiting_for_window_{false}
+        , shared_buffer_counter_{0}
+        , available_symbols_version_{0}
+        , announced_streams_{0}
+        , stream_count_{0}
+        , is_connected_{false}
+        , stop_io_thread_{false}
+    {
+    }
+
+    ~OidPublisher()
+    {
+        if (io_thread_.joinable()) {
+            stop_io_thread_ = true;
+            io_thread_.join();
+        }
+
+        ui_proc_.kill();
+    }
+
+    bool start(const string& oid_path)
+    {
+        promise<bool> is_started;
+        future<bool> result = is_started.get_future();
+
+        // Qt sockets can only be used by the thread that created them, so
+        // all the communication with the window happens in the io thread
+        io_thread_ = std::thread([this, oid_path, &is_started]() {
+            const bool is_connected = connect_window(oid_path);
+            is_connected_           = is_connected;
+            is_started.set_value(is_connected);
+
+            if (is_connected) {
+                run_io_loop();
+            }
+
+            is_connected_ = false;
+            for (int s = 0; s < stream_count_; ++s) {
+                streams_[s]->segment.reset();
+            }
+            client_ = nullptr;
+            server_.reset();
+        });
+
+        return result.get();
+    }
+
+    bool publish(const char* name,
+                 const uint8_t* buffer,
+                 int width,
+                 int height,
+                 int channels,
+                 BufferType type,
+                 int row_stride,
+                 bool is_device_buffer)
+    {
+        if (!is_connected_) {
+            return false;
+        }
+
+        Stream* stream = find_stream(name);
+        if (stream == nullptr) {
+            return false;
+        }
+
+        Frame& frame = stream->frames[stream->write_frame];
+
+        BufferMetadata& metadata  = frame.metadata;
+        metadata.variable_name    = name;
+        metadata.display_name     = name;
+        metadata.pixel_layout     = "rgba";
+        metadata.transpose_buffer = false;
+        metadata.is_planar        = false;
+        metadata.width            = width;
+        metadata.height           = height;
+        metadata.channels         = channels;
+        metadata.row_stride       = width;
+        metadata.type             = type;
+
+        // Only the valid pixels of each row are copied. The capacity of the
+        // frame is kept, so frames of the same size don't allocate.
+        const size_t pixel_size =
+            static_cast<size_t>(channels) * typesize(type);
+        const size_t row_length = static_cast<size_t>(width) * pixel_size;
+        const size_t src_stride = static_cast<size_t>(row_stride) * pixel_size;
+
+        frame.contents.resize(row_length * static_cast<size_t>(height));
+
+        // Device buffers take a single copy from the GPU into the frame
+        if (is_device_buffer) {
+            string error;
+            if (!read_device_memory_rows(reinterpret_cast<uintptr_t>(buffer),
+                                         src_stride,
+                                         row_length,
+                                         static_cast<size_t>(height),
+                                         frame.contents.data(),
+                                         error)) {
+                cerr << "[OpenImageDebugger] Could not publish buffer "
+                     << name << ": " << error << endl;
+                return false;
+            }
+        } else {
+            for (int row = 0; row < height; ++row) {
+                const size_t r = static_cast<size_t>(row);
+                memcpy(frame.contents.data() + r * row_length,
+                       buffer + r * src_stride,
+                       row_length);
+            }
+        }
+
+        stream->write_frame =
+            stream->ready_frame.exchange(stream->write_frame | fresh_frame,
+                                         memory_order_acq_rel) &
+            ~fresh_frame;
+
+        return true;
+    }
+
+  private:
+    Process ui_proc_;
+    unique_ptr<QTcpServer> server_;
+    QTcpSocket* client_;
+    MessageStreamReader message_reader_;
+
+    // Only accessed by the io thread
+    bool use_shared_memory_;
+    bool is_waiting_for_window_;
+    int shared_buffer_counter_;
+    size_t available_symbols_version_;
+    int announced_streams_;
+
+    // Streams are only ever appended, and published through stream_count_
+    unique_ptr<Stream> streams_[max_streams];
+    atomic<int> stream_count_;
+    mutex streams_mutex_;
+
+    atomic<bool> is_connected_;
+    atomic<bool> stop_io_thread_;
+
+    std::thread io_thread_;
+
+    bool connect_window(const string& oid_path)
+    {
+        server_.reset(new QTcpServer());
+        if (!server_->listen(QHostAddress::LocalHost)) {
+            cerr << "[OpenImageDebugger] Could not start TCP server" << endl;
+            return false;
+        }
+
+        const string port = std::to_string(server_->serverPort());
+        ui_proc_.start(
+            {oid_path + "/oidwindow", "-style", "fusion", "-p", port});
+        ui_proc_.waitForStart();
+
+        if (!server_->waitForNewConnection(client_timeout_ms)) {
+            cerr << "[OpenImageDebugger] No clients connected to "
+                    "OpenImageDebugger server"
+                 << endl;
+            return false;
+        }
+        client_ = server_->nextPendingConnection();
+
+        use_shared_memory_ = client_->peerAddress().isLoopback();
+
+        return true;
+    }
+
+
+    /**
+     * Sends the latest frames of all streams, and waits for the window to
+     * have processed them before sending the next ones. The window answers
+     * GetObservedSymbols in the same order it processes its messages, so its
+     * response also tells when it is ready for more frames.
+     */
+    void run_io_loop()
+    {
+        while (!stop_io_thread_ &&
+               client_->state() == QAbstractSocket::ConnectedState) {
+            if (!is_waiting_for_window_) {
+                send_frames();
+            }
+
+            read_incoming_messages();
+        }
+    }
+
+
+    void send_frames()
+    {
+        announce_streams();
+
+        bool has_sent_frames = false;
+        const int stream_count = stream_count_.load(memory_order_acquire);
+        for (int s = 0; s < stream_count; ++s) {
+            Stream& stream = *streams_[s];
+
+            const bool is_fresh =
+                (stream.ready_frame.load(memory_order_relaxed) &
+                 fresh_frame) != 0;
+            if (is_fresh) {
+                stream.sent_frame =
+                    stream.ready_frame.exchange(stream.sent_frame,
+                                                memory_order_acq_rel) &
+                    ~fresh_frame;
+                stream.has_sent_frame = true;
+            }
+
+            const bool is_sent = stream.is_requested ||
+                                 (is_fresh && stream.is_observed);
+            if (!is_sent || !stream.has_sent_frame) {
+                continue;
+            }
+
+            send_frame(stream);
+            stream.is_requested = false;
+            stream.is_observed  = true;
+            has_sent_frames     = true;
+        }
+
+        if (has_sent_frames) {
+            MessageComposer message_composer;
+            message_composer.push(MessageType::GetObservedSymbols)
+                .send(client_);
+            is_waiting_for_window_ = true;
+        }
+    }
+
+
+    /**
+     * Adds the streams created since the previous call to the symbols the
+     * window can search for
+     */
+    void announce_streams()
+    {
+        const int stream_count = stream_count_.load(memory_order_acquire);
+        if (announced_streams_ == stream_count) {
+            return;
+        }
+
+        vector<string> added_symbols;
+        for (int s = announced_streams_; s < stream_count; ++s) {
+            added_symbols.push_back(streams_[s]->name);
+        }
+        announced_streams_ = stream_count;
+
+        const size_t base_version = available_symbols_version_++;
+
+        MessageComposer message_composer;
+        message_composer.push(MessageType::UpdateAvailableSymbols)
+            .push(base_version)
+            .push(available_symbols_version_)
+            .push(vector<string>())
+            .push(added_symbols)
+            .send(client_);
+    }
+
+
+    void send_frame(Stream& stream)
+    {
+        const Frame& frame = stream.frames[stream.sent_frame];
+
+        if (use_shared_memory_ && send_frame_shared(stream, frame)) {
+            return;
+        }
+
+        MessageComposer message_composer;
+        message_composer.push(MessageType::PlotBufferContents)
+            .push(frame.metadata)
+            .push(frame.contents.data(), frame.contents.size())
+            .send(client_);
+    }
+
+
+    bool send_frame_shared(Stream& stream, const Frame& frame)
+    {
+        const size_t buff_length = frame.contents.size();
+
+        if (stream.segment == nullptr ||
+            static_cast<size_t>(stream.segment->size()) < buff_length) {
+            if (buff_length > static_cast<size_t>(numeric_limits<int>::max())) {
+                return false;
+            }
+
+            // Segments can't be resized, so a bigger frame gets a new
+            // segment with a fresh key
+            const QString key = QString("oid_publisher_%1_%2")
+                                    .arg(QCoreApplication::applicationPid())
+                                    .arg(shared_buffer_counter_++);
+
+            unique_ptr<QSharedMemory> segment(new QSharedMemory(key));
+            if (!segment->create(static_cast<int>(buff_length))) {
+                cerr << "[OpenImageDebugger] Could not create shared memory "
+                        "segment: "
+                     << segment->errorString().toStdString() << endl;
+                return false;
+            }
+            stream.segment = std::move(segment);
+        }
+
+        stream.segment->lock();
+        memcpy(stream.segment->data(), frame.contents.data(), buff_length);
+        stream.segment->unlock();
+
+        MessageComposer message_composer;
+        message_composer.push(MessageType::PlotBufferSharedContents)
+            .push(frame.metadata)
+            .push(stream.segment->key().toStdString())
+            .push(buff_length)
+            .send(client_);
+
+        return true;
+    }
+
+
+    void read_incoming_messages()
+    {
+        if (!message_reader_.wait_for_message(client_, poll_interval_ms)) {
+            return;
+        }
+
+        do {
+            MessageDecoder message_decoder = message_reader_.message_decoder();
+
+            switch (message_reader_.message_type()) {
+            case MessageType::GetObservedSymbolsResponse:
+                decode_get_observed_symbols_response(message_decoder);
+                break;
+            case MessageType::PlotBufferRequest:
+                decode_plot_buffer_request(message_decoder);
+                break;
+            default:
+                // Transport settings and the requests of lazy buffers don't
+                // apply to the frames of the publisher
+                break;
+            }
+
+            message_reader_.pop_message();
+        } while (message_reader_.read_available(client_));
+    }
+
+
+    void decode_get_observed_symbols_response(MessageDecoder& message_decoder)
+    {
+        deque<string> observed_symbols;
+        message_decoder.read<deque<string>, string>(observed_symbols);
+
+        const set<string> observed_set(observed_symbols.begin(),
+                                       observed_symbols.end());
+
+        const int stream_count = stream_count_.load(memory_order_acquire);
+        for (int s = 0; s < stream_count; ++s) {
+            Stream& stream = *streams_[s];
+            stream.is_observed =
+                observed_set.find(stream.name) != observed_set.end();
+        }
+
+        is_waiting_for_window_ = false;
+    }
+
+
+    void decode_plot_buffer_request(MessageDecoder& message_decoder)
+    {
+        string buffer_name;
+        message_decoder.read(buffer_name);
+
+        const int stream_count = stream_count_.load(memory_order_acquire);
+        for (int s = 0; s < stream_count; ++s) {
+            if (streams_[s]->name == buffer_name) {
+                streams_[s]->is_requested = true;
+                break;
+            }
+        }
+    }
+
+
+    Stream* find_stream(const char* name)
+    {
+        int stream_count = stream_count_.load(memory_order_acquire);
+        for (int s = 0; s < stream_count; ++s) {
+            if (streams_[s]->name == name) {
+                return streams_[s].get();
+            }
+        }
+
+        // Only the first frame of each buffer takes the lock
+        lock_guard<mutex> lock(streams_mutex_);
+
+        stream_count = stream_count_.load(memory_order_relaxed);
+        for (int s = 0; s < stream_count; ++s) {
+            if (streams_[s]->name == name) {
+                return streams_[s].get();
+            }
+        }
+
+        if (stream_count == max_streams) {
+            cerr << "[OpenImageDebugger] Could not publish buffer " << name
+                 << ": too many buffers" << endl;
+            return nullptr;
+        }
+
+        streams_[stream_count].reset(new Stream(name));
+        stream_count_.store(stream_count + 1, memory_order_release);
+
+        return streams_[stream_count].get();
+    }
+};
+
+
+OidPublisher* publisher = nullptr;
+
+} // namespace
+
+
+int oid_publisher_start(const char* oid_path)
+{
+    if (publisher != nullptr) {
+        return 1;
+    }
+
+    if (oid_path == nullptr) {
+        oid_path = getenv("OID_PATH");
+    }
+    if (oid_path == nullptr) {
+        cerr << "[OpenImageDebugger] oid_publisher_start requires the path of "
+                "the oidwindow binary, or OID_PATH to be set"
+             << endl;
+        return 0;
+    }
+
+    unique_ptr<OidPublisher> new_publisher(new OidPublisher());
+    if (!new_publisher->start(oid_path)) {
+        return 0;
+    }
+
+    publisher = new_publisher.release();
+
+    return 1;
+}
+
+
+void oid_publisher_stop(void)
+{
+    delete publisher;
+    publisher = nullptr;
+}
+
+
+/**
+ * Validates the arguments shared by oid_publish and oid_publish_device
+ */
+static int publish_frame(const char* name,
+                         const void* buffer,
+                         int width,
+                         int height,
+                         int channels,
+                         int type,
+                         int row_stride,
+                         bool is_device_buffer)
+{
+    if (publisher == nullptr || name == nullptr || buffer == nullptr) {
+        return 0;
+    }
+
+    if (width <= 0 || height <= 0 || channels < 1 || channels > 4 ||
+        row_stride < width || type < OID_PUBLISH_UINT8 ||
+        type > OID_PUBLISH_BOOL) {
+        return 0;
+    }
+
+    return publisher->publish(name,
+                              static_cast<const uint8_t*>(buffer),
+                              width,
+                              height,
+                              channels,
+                              static_cast<BufferType>(type),
+                              row_stride,
+                              is_device_buffer)
+               ? 1
+               : 0;
+}
+
+
+int oid_publish(const char* name,
+                const void* buffer,
+                int width,
+                int height,
+                int channels,
+                int type,
+                int row_stride)
+{
+    return publish_frame(
+        name, buffer, width, height, channels, type, row_stride, false);
+}
+
+
+int oid_publish_device(const char* name,
+                       const void* device_buffer,
+                       int width,
+                       int height,
+                       int channels,
+                       int type,
+                       int row_stride)
+{
+    return publish_frame(
+        name, device_buffer, width, height, channels, type, row_stride, true);
+}
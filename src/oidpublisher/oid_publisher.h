@@ -0,0 +1,133 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef OID_PUBLISHER_H_
+#define OID_PUBLISHER_H_
+
+#include <stdint.h>
+
+#ifndef OID_API
+#  if __GNUC__ >= 4
+#    define OID_API __attribute__((visibility("default")))
+#  else
+#    define OID_API
+#  endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * Element types of published buffers, with the same values as the types of
+ * the debugger scripts (see symbols.py)
+ */
+#define OID_PUBLISH_UINT8   0
+#define OID_PUBLISH_INT8    1
+#define OID_PUBLISH_UINT16  2
+#define OID_PUBLISH_INT16   3
+#define OID_PUBLISH_INT32   4
+#define OID_PUBLISH_FLOAT32 5
+#define OID_PUBLISH_FLOAT64 6
+#define OID_PUBLISH_FLOAT16 7
+#define OID_PUBLISH_UINT32  8
+#define OID_PUBLISH_BOOL    9
+
+
+/**
+ * Start the OpenImageDebugger window and connect to it
+ *
+ * Buffers published afterwards are streamed to the window while the program
+ * keeps running, without a debugger. Blocks until the window has connected.
+ *
+ * @param oid_path  Directory holding the oidwindow binary, or NULL to read it
+ *     from the OID_PATH environment variable
+ * @return  1 if the window is connected, 0 otherwise
+ */
+OID_API
+int oid_publisher_start(const char* oid_path);
+
+/**
+ * Close the window and release the resources of the publisher
+ *
+ * Must not be called while other threads are publishing buffers.
+ */
+OID_API
+void oid_publisher_stop(void);
+
+/**
+ * Publish a new frame of a buffer
+ *
+ * The frame is copied, and sent to the window once it has shown the previous
+ * frames. Frames published meanwhile replace the ones not sent yet, so this
+ * call never waits for the window. Each buffer must be published from one
+ * thread at a time.
+ *
+ * @param name        Name the buffer is listed under in the window
+ * @param buffer      Pointer to the first element of the buffer
+ * @param width       Buffer width, in pixels
+ * @param height      Buffer height, in pixels
+ * @param channels    Number of channels (1 to 4)
+ * @param type        Element type (one of the OID_PUBLISH_* values)
+ * @param row_stride  Row stride, in pixels
+ * @return  1 if the frame was accepted, 0 if the arguments are invalid or the
+ *     window isn't connected
+ */
+OID_API
+int oid_publish(const char* name,
+                const void* buffer,
+                int width,
+                int height,
+                int channels,
+                int type,
+                int row_stride);
+
+/**
+ * Publish a new frame of a buffer in CUDA device memory
+ *
+ * Same as oid_publish, except that the buffer is copied from the GPU with the
+ * CUDA context current to the calling thread. The CUDA driver is loaded at
+ * runtime, so programs without device buffers don't depend on it.
+ *
+ * @param device_buffer  Device pointer to the first element of the buffer
+ * @return  1 if the frame was accepted, 0 if the arguments are invalid, the
+ *     window isn't connected or the buffer couldn't be copied
+ */
+OID_API
+int oid_publish_device(const char* name,
+                       const void* device_buffer,
+                       int width,
+                       int height,
+                       int channels,
+                       int type,
+                       int row_stride);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OID_PUBLISHER_H_
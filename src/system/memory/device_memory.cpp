@@ -0,0 +1,176 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "device_memory.h"
+
+#include <mutex>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <dlfcn.h>
+#endif
+
+
+namespace
+{
+
+// Subset of the CUDA driver API, declared here so that the driver is only
+// needed at runtime, by the programs which plot device buffers
+typedef int CUresult;
+typedef unsigned long long CUdeviceptr;
+
+const CUresult CUDA_SUCCESS = 0;
+
+enum CUmemorytype {
+    CU_MEMORYTYPE_HOST   = 1,
+    CU_MEMORYTYPE_DEVICE = 2
+};
+
+struct CUDA_MEMCPY2D
+{
+    size_t srcXInBytes;
+    size_t srcY;
+    CUmemorytype srcMemoryType;
+    const void* srcHost;
+    CUdeviceptr srcDevice;
+    void* srcArray;
+    size_t srcPitch;
+
+    size_t dstXInBytes;
+    size_t dstY;
+    CUmemorytype dstMemoryType;
+    void* dstHost;
+    CUdeviceptr dstDevice;
+    void* dstArray;
+    size_t dstPitch;
+
+    size_t WidthInBytes;
+    size_t Height;
+};
+
+typedef CUresult (*CuMemcpy2D)(const CUDA_MEMCPY2D*);
+typedef CUresult (*CuGetErrorString)(CUresult, const char**);
+
+
+struct CudaDriver
+{
+    CuMemcpy2D memcpy_2d;
+    CuGetErrorString get_error_string;
+};
+
+
+template <typename Function>
+Function find_symbol(void* library, const char* name)
+{
+#if defined(_WIN32)
+    return reinterpret_cast<Function>(
+        GetProcAddress(static_cast<HMODULE>(library), name));
+#elif defined(__linux__)
+    return reinterpret_cast<Function>(dlsym(library, name));
+#else
+    (void)library;
+    (void)name;
+    return nullptr;
+#endif
+}
+
+
+/**
+ * Loads the CUDA driver the first time it is called. The library is never
+ * unloaded, as the program keeps using it for its own buffers.
+ */
+const CudaDriver* cuda_driver()
+{
+    static CudaDriver driver{nullptr, nullptr};
+    static std::once_flag is_loaded;
+
+    std::call_once(is_loaded, []() {
+#if defined(_WIN32)
+        void* library = LoadLibraryA("nvcuda.dll");
+#elif defined(__linux__)
+        void* library = dlopen("libcuda.so.1", RTLD_NOW | RTLD_LOCAL);
+#else
+        void* library = nullptr;
+#endif
+        if (library == nullptr) {
+            return;
+        }
+
+        driver.memcpy_2d = find_symbol<CuMemcpy2D>(library, "cuMemcpy2D_v2");
+        driver.get_error_string =
+            find_symbol<CuGetErrorString>(library, "cuGetErrorString");
+    });
+
+    return driver.memcpy_2d != nullptr ? &driver : nullptr;
+}
+
+} // namespace
+
+
+bool is_device_memory_readable()
+{
+    return cuda_driver() != nullptr;
+}
+
+
+bool read_device_memory_rows(uint64_t address,
+                             size_t pitch,
+                             size_t row_length,
+                             size_t rows,
+                             uint8_t* dst,
+                             std::string& error)
+{
+    const CudaDriver* driver = cuda_driver();
+    if (driver == nullptr) {
+        error = "Could not load the CUDA driver";
+        return false;
+    }
+
+    CUDA_MEMCPY2D copy = {};
+    copy.srcMemoryType = CU_MEMORYTYPE_DEVICE;
+    copy.srcDevice     = static_cast<CUdeviceptr>(address);
+    copy.srcPitch      = pitch;
+    copy.dstMemoryType = CU_MEMORYTYPE_HOST;
+    copy.dstHost       = dst;
+    copy.dstPitch      = row_length;
+    copy.WidthInBytes  = row_length;
+    copy.Height        = rows;
+
+    const CUresult result = driver->memcpy_2d(&copy);
+    if (result != CUDA_SUCCESS) {
+        const char* description = nullptr;
+        if (driver->get_error_string == nullptr ||
+            driver->get_error_string(result, &description) != CUDA_SUCCESS ||
+            description == nullptr) {
+            description = "unknown error";
+        }
+
+        error = "Could not read device memory: " + std::string(description);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,61 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef SYSTEM_DEVICE_MEMORY_H_
+#define SYSTEM_DEVICE_MEMORY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Check if the CUDA driver could be loaded, so that read_device_memory_rows
+ * is supported. It is loaded at runtime, and only once.
+ */
+bool is_device_memory_readable();
+
+/**
+ * Copy the rows of a strided buffer in CUDA device memory into a packed one
+ *
+ * The copy runs in the CUDA context current to the calling thread, which
+ * must own the buffer. It is done with a single 2D copy, so the padding
+ * between the rows is never transferred.
+ *
+ * @param address  Device address of the first byte of the buffer
+ * @param pitch  Distance between the start of two rows, in bytes
+ * @param row_length  Number of bytes to copy from each row
+ * @param rows  Number of rows to copy
+ * @param dst  Host buffer, with at least rows * row_length bytes
+ * @param error  Description of the failure, if the memory couldn't be read
+ * @return true if all rows were copied
+ */
+bool read_device_memory_rows(uint64_t address,
+                             size_t pitch,
+                             size_t row_length,
+                             size_t rows,
+                             uint8_t* dst,
+                             std::string& error);
+
+#endif // SYSTEM_DEVICE_MEMORY_H_
@@ -0,0 +1,387 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "host_buffer_pool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+
+namespace
+{
+
+const std::size_t min_block_size = 4096;
+const std::size_t huge_page_size = 2 << 20;
+
+// Free blocks beyond this are returned to the system
+const std::size_t max_cached_bytes = 512 << 20;
+
+
+std::size_t round_up(std::size_t size, std::size_t multiple)
+{
+    return (size + multiple - 1) / multiple * multiple;
+}
+
+
+#if defined(__linux__)
+/**
+ * Anonymous mapping aligned to the huge page size, so that transparent huge
+ * pages can back all of it
+ */
+void* map_aligned(std::size_t capacity)
+{
+    const std::size_t mapped_size = capacity + huge_page_size;
+
+    void* mapping = mmap(nullptr,
+                         mapped_size,
+                         PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS,
+                         -1,
+                         0);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+
+    std::uint8_t* begin = static_cast<std::uint8_t*>(mapping);
+    std::uint8_t* aligned =
+        begin + (huge_page_size -
+                 reinterpret_cast<std::uintptr_t>(begin) % huge_page_size) %
+                    huge_page_size;
+
+    // Unmap the parts beyond the aligned block
+    if (aligned > begin) {
+        munmap(begin, static_cast<std::size_t>(aligned - begin));
+    }
+    const std::size_t tail_size =
+        mapped_size - static_cast<std::size_t>(aligned - begin) - capacity;
+    if (tail_size > 0) {
+        munmap(aligned + capacity, tail_size);
+    }
+
+    return aligned;
+}
+#endif
+
+} // namespace
+
+
+HostBufferPool::HostBufferPool()
+{
+}
+
+
+HostBufferPool::~HostBufferPool()
+{
+    trim();
+}
+
+
+HostBlock HostBufferPool::acquire(std::size_t size, bool is_zeroed)
+{
+    if (size == 0) {
+        return HostBlock();
+    }
+
+    const std::size_t capacity = size_class(size);
+    const bool is_sparse       = is_zeroed && capacity >= huge_page_size;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    stats_.used_bytes += capacity;
+
+    auto free_list = free_blocks_.find(capacity);
+    if (!is_sparse && free_list != free_blocks_.end() &&
+        !free_list->second.empty()) {
+        HostBlock block = free_list->second.back();
+        free_list->second.pop_back();
+
+        stats_.cached_bytes -= capacity;
+        ++stats_.reuses;
+
+        if (is_zeroed) {
+            std::memset(block.data, 0, capacity);
+        }
+        return block;
+    }
+
+    ++stats_.allocations;
+
+    HostBlock block = allocate_block(capacity, is_sparse);
+    if (is_zeroed && !block.is_mapped) {
+        std::memset(block.data, 0, capacity);
+    }
+
+    return block;
+}
+
+
+void HostBufferPool::release(HostBlock block)
+{
+    if (block.data == nullptr) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    stats_.used_bytes -= block.capacity;
+
+    // Make room by dropping the largest cached blocks of other sizes, which
+    // are the least likely to be requested again
+    for (auto free_list = free_blocks_.rbegin();
+         free_list != free_blocks_.rend() &&
+         stats_.cached_bytes + block.capacity > max_cached_bytes;
+         ++free_list) {
+        if (free_list->first == block.capacity) {
+            continue;
+        }
+
+        while (!free_list->second.empty() &&
+               stats_.cached_bytes + block.capacity > max_cached_bytes) {
+            free_block(free_list->second.back());
+            free_list->second.pop_back();
+            stats_.cached_bytes -= free_list->first;
+        }
+    }
+
+    if (stats_.cached_bytes + block.capacity > max_cached_bytes) {
+        free_block(block);
+        return;
+    }
+
+    free_blocks_[block.capacity].push_back(block);
+    stats_.cached_bytes += block.capacity;
+}
+
+
+void HostBufferPool::trim()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (const auto& free_list : free_blocks_) {
+        for (const auto& block : free_list.second) {
+            free_block(block);
+        }
+    }
+
+    free_blocks_.clear();
+    stats_.cached_bytes = 0;
+}
+
+
+void HostBufferPool::set_reserved_huge_pages(bool is_enabled)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_reserved_huge_pages_ = is_enabled;
+}
+
+
+HostBufferPoolStats HostBufferPool::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+
+HostBufferPool& HostBufferPool::instance()
+{
+    static HostBufferPool pool;
+    return pool;
+}
+
+
+std::size_t HostBufferPool::size_class(std::size_t size)
+{
+    if (size <= min_block_size) {
+        return min_block_size;
+    }
+
+    // Classes are a quarter of the largest power of two below the size
+    // apart, which wastes at most a fifth of each block
+    std::size_t power = min_block_size;
+    while (power * 2 < size) {
+        power *= 2;
+    }
+
+    const std::size_t capacity = round_up(size, power / 4);
+    if (capacity >= huge_page_size) {
+        return round_up(capacity, huge_page_size);
+    }
+
+    return capacity;
+}
+
+
+HostBlock HostBufferPool::allocate_block(std::size_t capacity, bool is_sparse)
+{
+    HostBlock block;
+    block.capacity = capacity;
+
+#if defined(__linux__)
+    if (is_sparse) {
+        void* data = mmap(nullptr,
+                          capacity,
+                          PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS,
+                          -1,
+                          0);
+        if (data != MAP_FAILED) {
+            block.data      = static_cast<std::uint8_t*>(data);
+            block.is_mapped = true;
+            return block;
+        }
+    } else if (capacity >= huge_page_size) {
+        void* data = MAP_FAILED;
+
+        if (is_reserved_huge_pages_) {
+            data = mmap(nullptr,
+                        capacity,
+                        PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                        -1,
+                        0);
+        }
+
+        if (data != MAP_FAILED) {
+            block.is_huge_page = true;
+        } else {
+            data = map_aligned(capacity);
+            if (data == nullptr) {
+                data = MAP_FAILED;
+            } else {
+                // Effective only if transparent huge pages are enabled
+                block.is_huge_page =
+                    madvise(data, capacity, MADV_HUGEPAGE) == 0;
+            }
+        }
+
+        if (data != MAP_FAILED) {
+            block.data      = static_cast<std::uint8_t*>(data);
+            block.is_mapped = true;
+
+            if (block.is_huge_page) {
+                stats_.huge_page_bytes += capacity;
+            }
+            return block;
+        }
+    }
+#endif
+
+    block.data = static_cast<std::uint8_t*>(std::malloc(capacity));
+    if (block.data == nullptr) {
+        stats_.used_bytes -= capacity;
+        throw std::bad_alloc();
+    }
+
+    return block;
+}
+
+
+void HostBufferPool::free_block(const HostBlock& block)
+{
+    if (block.is_huge_page) {
+        stats_.huge_page_bytes -= block.capacity;
+    }
+
+#if defined(__linux__)
+    if (block.is_mapped) {
+        munmap(block.data, block.capacity);
+        return;
+    }
+#endif
+
+    std::free(block.data);
+}
+
+
+HostBuffer::HostBuffer(std::size_t size, bool is_zeroed)
+    : block_(HostBufferPool::instance().acquire(size, is_zeroed))
+    , size_(size)
+{
+}
+
+
+HostBuffer::HostBuffer(HostBuffer&& other) noexcept
+    : block_(other.block_)
+    , size_(other.size_)
+{
+    other.block_ = HostBlock();
+    other.size_  = 0;
+}
+
+
+HostBuffer& HostBuffer::operator=(HostBuffer&& other) noexcept
+{
+    if (this != &other) {
+        clear();
+        swap(other);
+    }
+
+    return *this;
+}
+
+
+HostBuffer::~HostBuffer()
+{
+    clear();
+}
+
+
+void HostBuffer::resize(std::size_t size)
+{
+    if (size <= block_.capacity) {
+        size_ = size;
+        return;
+    }
+
+    HostBuffer resized(size);
+    if (size_ > 0) {
+        std::memcpy(resized.data(), data(), size_);
+    }
+
+    swap(resized);
+}
+
+
+void HostBuffer::clear()
+{
+    HostBufferPool::instance().release(block_);
+
+    block_ = HostBlock();
+    size_  = 0;
+}
+
+
+void HostBuffer::swap(HostBuffer& other) noexcept
+{
+    std::swap(block_, other.block_);
+    std::swap(size_, other.size_);
+}
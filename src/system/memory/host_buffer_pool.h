@@ -0,0 +1,190 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef SYSTEM_HOST_BUFFER_POOL_H_
+#define SYSTEM_HOST_BUFFER_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+/**
+ * Counters of the host buffer pool, in bytes unless stated otherwise
+ */
+struct HostBufferPoolStats
+{
+    // Held by live buffers, and kept in the free lists for reuse
+    std::size_t used_bytes   = 0;
+    std::size_t cached_bytes = 0;
+    // Part of the above backed by huge pages, or eligible for transparent
+    // ones
+    std::size_t huge_page_bytes = 0;
+    // Number of blocks requested from the system, and served from the free
+    // lists instead
+    std::size_t allocations = 0;
+    std::size_t reuses      = 0;
+};
+
+
+/**
+ * Memory block of the pool. Its capacity is the size class it belongs to.
+ */
+struct HostBlock
+{
+    std::uint8_t* data   = nullptr;
+    std::size_t capacity = 0;
+    bool is_mapped       = false;
+    bool is_huge_page    = false;
+};
+
+
+/**
+ * Process wide allocator for the buffer contents held by the UI
+ *
+ * Requests are rounded up to size classes a quarter of a power of two
+ * apart, and released blocks are kept in per class free lists, so that
+ * updates of a buffer keep reusing the same memory instead of faulting in
+ * new pages. Blocks of 2 MB and above are mapped directly and backed by huge
+ * pages where the platform allows it.
+ */
+class HostBufferPool
+{
+  public:
+    HostBufferPool();
+
+    ~HostBufferPool();
+
+    /**
+     * Block with at least size bytes. Its contents are uninitialized, unless
+     * is_zeroed is set. Large zeroed blocks are freshly mapped without huge
+     * pages, so that only the pages written to take memory.
+     */
+    HostBlock acquire(std::size_t size, bool is_zeroed = false);
+
+    /**
+     * Returns a block to its free list, or to the system if the cached
+     * blocks already exceed their limit
+     */
+    void release(HostBlock block);
+
+    /**
+     * Returns the cached blocks to the system
+     */
+    void trim();
+
+    /**
+     * Whether large blocks are first requested from the reserved huge pages
+     * (MAP_HUGETLB), before falling back to transparent huge pages. Only
+     * available on Linux, and only useful if the system reserves them.
+     */
+    void set_reserved_huge_pages(bool is_enabled);
+
+    HostBufferPoolStats stats() const;
+
+    /**
+     * Pool shared by the whole process
+     */
+    static HostBufferPool& instance();
+
+  private:
+    static std::size_t size_class(std::size_t size);
+
+    HostBlock allocate_block(std::size_t capacity, bool is_sparse);
+
+    void free_block(const HostBlock& block);
+
+    // Free lists, by capacity. Blocks are reused last released first.
+    std::map<std::size_t, std::vector<HostBlock>> free_blocks_;
+
+    bool is_reserved_huge_pages_ = false;
+    HostBufferPoolStats stats_;
+
+    mutable std::mutex mutex_;
+};
+
+
+/**
+ * Contiguous bytes allocated from the host buffer pool, returned to it when
+ * destroyed. Unlike std::vector, growing it leaves the new bytes
+ * uninitialized.
+ */
+class HostBuffer
+{
+  public:
+    HostBuffer() = default;
+
+    explicit HostBuffer(std::size_t size, bool is_zeroed = false);
+
+    HostBuffer(HostBuffer&& other) noexcept;
+
+    HostBuffer& operator=(HostBuffer&& other) noexcept;
+
+    HostBuffer(const HostBuffer&) = delete;
+
+    HostBuffer& operator=(const HostBuffer&) = delete;
+
+    ~HostBuffer();
+
+    std::uint8_t* data()
+    {
+        return block_.data;
+    }
+
+    const std::uint8_t* data() const
+    {
+        return block_.data;
+    }
+
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    /**
+     * Keeps the first min(size, size()) bytes. Reallocates only if the size
+     * exceeds the capacity of the current block.
+     */
+    void resize(std::size_t size);
+
+    /**
+     * Gives the memory back to the pool
+     */
+    void clear();
+
+    void swap(HostBuffer& other) noexcept;
+
+  private:
+    HostBlock block_;
+    std::size_t size_ = 0;
+};
+
+#endif // SYSTEM_HOST_BUFFER_POOL_H_
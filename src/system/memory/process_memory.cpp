@@ -0,0 +1,318 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "process_memory.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "system/trace/tracer.h"
+
+
+namespace
+{
+
+// Large reads are split so each system call stays within ssize_t and the
+// kernel doesn't pin too many pages at once
+const size_t max_read_chunk_size = 64 * 1024 * 1024;
+
+
+// Strided reads are split in batches of at most IOV_MAX rows
+const size_t max_rows_per_read = 1024;
+
+
+std::string describe_partial_read(uint64_t failed_address,
+                                  size_t length,
+                                  size_t copied,
+                                  int error_number)
+{
+    char address_text[32];
+    snprintf(address_text,
+             sizeof(address_text),
+             "0x%llx",
+             static_cast<unsigned long long>(failed_address));
+
+    return "Could not read memory at " + std::string(address_text) +
+           " (only " + std::to_string(copied) + " of " +
+           std::to_string(length) +
+           " bytes are accessible): " + strerror(error_number);
+}
+
+#if defined(__linux__)
+
+size_t read_with_process_vm_readv(int64_t pid,
+                                  uint64_t address,
+                                  uint8_t* dst,
+                                  size_t length,
+                                  int& error_number)
+{
+    size_t copied = 0;
+    while (copied < length) {
+        const size_t chunk_size =
+            std::min(length - copied, max_read_chunk_size);
+
+        iovec local_iov;
+        local_iov.iov_base = dst + copied;
+        local_iov.iov_len  = chunk_size;
+
+        iovec remote_iov;
+        remote_iov.iov_base = reinterpret_cast<void*>(address + copied);
+        remote_iov.iov_len  = chunk_size;
+
+        const ssize_t chunk_copied = process_vm_readv(
+            static_cast<pid_t>(pid), &local_iov, 1, &remote_iov, 1, 0);
+
+        if (chunk_copied <= 0) {
+            // A short read stops at the first unmapped page, which makes the
+            // next call fail with the actual reason
+            error_number = chunk_copied < 0 ? errno : EFAULT;
+            break;
+        }
+
+        copied += static_cast<size_t>(chunk_copied);
+    }
+
+    return copied;
+}
+
+
+size_t read_with_proc_mem(int64_t pid,
+                          uint64_t address,
+                          uint8_t* dst,
+                          size_t length,
+                          int& error_number)
+{
+    const std::string path = "/proc/" + std::to_string(pid) + "/mem";
+
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error_number = errno;
+        return 0;
+    }
+
+    size_t copied = 0;
+    while (copied < length) {
+        const size_t chunk_size =
+            std::min(length - copied, max_read_chunk_size);
+
+        const ssize_t chunk_copied =
+            pread(fd,
+                  dst + copied,
+                  chunk_size,
+                  static_cast<off_t>(address + copied));
+
+        if (chunk_copied < 0 && errno == EINTR) {
+            continue;
+        } else if (chunk_copied <= 0) {
+            error_number = chunk_copied < 0 ? errno : EFAULT;
+            break;
+        }
+
+        copied += static_cast<size_t>(chunk_copied);
+    }
+
+    close(fd);
+
+    return copied;
+}
+
+
+size_t read_rows_with_process_vm_readv(int64_t pid,
+                                       uint64_t address,
+                                       size_t pitch,
+                                       size_t row_length,
+                                       size_t rows,
+                                       uint8_t* dst,
+                                       int& error_number)
+{
+    std::vector<iovec> remote_iov;
+
+    size_t copied = 0;
+    for (size_t row = 0; row < rows; row += max_rows_per_read) {
+        const size_t batch_rows   = std::min(rows - row, max_rows_per_read);
+        const size_t batch_length = batch_rows * row_length;
+
+        // Rows are scattered in the target process, but packed in dst
+        remote_iov.resize(batch_rows);
+        for (size_t i = 0; i < batch_rows; ++i) {
+            remote_iov[i].iov_base =
+                reinterpret_cast<void*>(address + (row + i) * pitch);
+            remote_iov[i].iov_len = row_length;
+        }
+
+        iovec local_iov;
+        local_iov.iov_base = dst + copied;
+        local_iov.iov_len  = batch_length;
+
+        const ssize_t batch_copied = process_vm_readv(static_cast<pid_t>(pid),
+                                                      &local_iov,
+                                                      1,
+                                                      remote_iov.data(),
+                                                      batch_rows,
+                                                      0);
+
+        if (batch_copied < 0) {
+            error_number = errno;
+            break;
+        }
+
+        copied += static_cast<size_t>(batch_copied);
+
+        if (static_cast<size_t>(batch_copied) < batch_length) {
+            error_number = EFAULT;
+            break;
+        }
+    }
+
+    return copied;
+}
+
+
+size_t read_rows_with_proc_mem(int64_t pid,
+                               uint64_t address,
+                               size_t pitch,
+                               size_t row_length,
+                               size_t rows,
+                               uint8_t* dst,
+                               int& error_number)
+{
+    size_t copied = 0;
+    for (size_t row = 0; row < rows; ++row) {
+        const size_t row_copied = read_with_proc_mem(
+            pid, address + row * pitch, dst + copied, row_length, error_number);
+
+        copied += row_copied;
+
+        if (row_copied < row_length) {
+            break;
+        }
+    }
+
+    return copied;
+}
+
+#endif
+
+} // namespace
+
+
+bool is_process_memory_readable()
+{
+#if defined(__linux__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+bool read_process_memory(int64_t pid,
+                         uint64_t address,
+                         uint8_t* dst,
+                         size_t length,
+                         std::string& error)
+{
+#if defined(__linux__)
+    int error_number = 0;
+    size_t copied =
+        read_with_process_vm_readv(pid, address, dst, length, error_number);
+
+    // Kernels without process_vm_readv or with it restricted by a security
+    // module may still provide access through procfs
+    if (copied == 0 && (error_number == ENOSYS || error_number == EPERM)) {
+        error_number = 0;
+        copied =
+            read_with_proc_mem(pid, address, dst, length, error_number);
+    }
+
+    if (copied < length) {
+        error = describe_partial_read(
+            address + copied, length, copied, error_number);
+        return false;
+    }
+
+    return true;
+#else
+    (void)pid;
+    (void)dst;
+    error = describe_partial_read(address, length, 0, ENOSYS);
+    return false;
+#endif
+}
+
+
+bool read_process_memory_rows(int64_t pid,
+                              uint64_t address,
+                              size_t pitch,
+                              size_t row_length,
+                              size_t rows,
+                              uint8_t* dst,
+                              std::string& error)
+{
+    TraceSpan span("read_process_memory");
+
+    if (pitch == row_length) {
+        return read_process_memory(pid, address, dst, rows * row_length, error);
+    }
+
+#if defined(__linux__)
+    int error_number = 0;
+    size_t copied    = read_rows_with_process_vm_readv(
+        pid, address, pitch, row_length, rows, dst, error_number);
+
+    if (copied == 0 && (error_number == ENOSYS || error_number == EPERM)) {
+        error_number = 0;
+        copied       = read_rows_with_proc_mem(
+            pid, address, pitch, row_length, rows, dst, error_number);
+    }
+
+    const size_t length = rows * row_length;
+    if (copied < length) {
+        const uint64_t failed_address = address +
+                                        (copied / row_length) * pitch +
+                                        copied % row_length;
+        error = describe_partial_read(
+            failed_address, length, copied, error_number);
+        return false;
+    }
+
+    return true;
+#else
+    (void)pid;
+    (void)pitch;
+    (void)dst;
+    error = describe_partial_read(address, rows * row_length, 0, ENOSYS);
+    return false;
+#endif
+}
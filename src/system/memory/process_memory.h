@@ -0,0 +1,78 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef SYSTEM_PROCESS_MEMORY_H_
+#define SYSTEM_PROCESS_MEMORY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Check if read_process_memory is supported by the current platform
+ */
+bool is_process_memory_readable();
+
+/**
+ * Copy memory from another process running in the same host
+ *
+ * Reads go through process_vm_readv, falling back to /proc/<pid>/mem if the
+ * kernel doesn't provide it. The caller must be allowed to trace the target
+ * process, which is always the case for the debugger of that process.
+ *
+ * @param pid  Id of the process to be read
+ * @param address  Address of the first byte in the target process
+ * @param dst  Destination buffer, with at least length bytes
+ * @param length  Number of bytes to copy
+ * @param error  Description of the failure, if the memory couldn't be read
+ * @return true if all length bytes were copied
+ */
+bool read_process_memory(int64_t pid,
+                         uint64_t address,
+                         uint8_t* dst,
+                         size_t length,
+                         std::string& error);
+
+/**
+ * Copy the rows of a strided buffer from another process into a packed one
+ *
+ * Only row_length bytes of each row are read, so the padding between rows is
+ * never copied. Rows are gathered with as few system calls as possible.
+ *
+ * @param pitch  Distance between the start of two rows, in bytes
+ * @param row_length  Number of bytes to copy from each row
+ * @param rows  Number of rows to copy
+ * @param dst  Destination buffer, with at least rows * row_length bytes
+ * @return true if all rows were copied
+ */
+bool read_process_memory_rows(int64_t pid,
+                              uint64_t address,
+                              size_t pitch,
+                              size_t row_length,
+                              size_t rows,
+                              uint8_t* dst,
+                              std::string& error);
+
+#endif // SYSTEM_PROCESS_MEMORY_H_
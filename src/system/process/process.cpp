@@ -40,6 +40,12 @@ void Process::start(const std::vector<std::string>& command)
 }
 
 
+void Process::startDetached(const std::vector<std::string>& command)
+{
+    impl_->startDetached(command);
+}
+
+
 bool Process::isRunning()
 {
     return impl_->isRunning();
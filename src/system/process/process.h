@@ -42,6 +42,14 @@ public:
      */
     void start(const std::vector<std::string>& command);
 
+    /**
+     * Start a process which outlives this object and is never killed by it.
+     * It doesn't receive the signals sent to the process group of the
+     * caller, such as the interrupts of its terminal.
+     * @param command binary and path and its arguments
+     */
+    void startDetached(const std::vector<std::string>& command);
+
     /**
      * Check if the process is running
      * @return true if running, false otherwise
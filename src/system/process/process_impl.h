@@ -41,6 +41,12 @@ public:
      */
     virtual void start(const std::vector<std::string>& command) = 0;
 
+    /**
+     * Start a process which is not killed by kill() nor on destruction
+     * @param command binary and path and its arguments
+     */
+    virtual void startDetached(const std::vector<std::string>& command) = 0;
+
     /**
      * Check if the process is running
      * @return true if running, false otherwise
@@ -44,6 +44,43 @@ public:
     }
 
     void start(const std::vector<std::string>& command) override
+    {
+        spawn(command, nullptr);
+    }
+
+    void startDetached(const std::vector<std::string>& command) override
+    {
+        // In a process group of its own, the interrupts of the debugger's
+        // terminal don't reach it
+        posix_spawnattr_t attributes;
+        posix_spawnattr_init(&attributes);
+        posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+        posix_spawnattr_setpgroup(&attributes, 0);
+
+        spawn(command, &attributes);
+        is_detached_ = true;
+
+        posix_spawnattr_destroy(&attributes);
+    }
+
+    bool isRunning() const override
+    {
+        return pid_ != 0 && ::kill(pid_, 0) == 0;
+    }
+
+    void kill() override
+    {
+        if (pid_ != 0 && !is_detached_) {
+            ::kill(pid_, SIGTERM);
+        }
+    }
+
+private:
+    pid_t pid_{0};
+    bool is_detached_{false};
+
+    void spawn(const std::vector<std::string>& command,
+               const posix_spawnattr_t* attributes)
     {
         const auto windowBinaryPath = command[0];
 
@@ -59,23 +96,10 @@ public:
         posix_spawn(&pid_,
                     windowBinaryPath.c_str(),
                     nullptr, // TODO consider passing something here
-                    nullptr, // and here
+                    attributes,
                     &argv[0],
                     environ);
     }
-
-    bool isRunning() const override
-    {
-        return pid_ != 0 && ::kill(pid_, 0) == 0;
-    }
-
-    void kill() override
-    {
-        ::kill(pid_, SIGTERM);
-    }
-
-private:
-    pid_t pid_{0};
 };
 
 void Process::createImpl()
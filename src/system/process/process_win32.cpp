@@ -52,9 +52,21 @@ public:
         proc_.waitForStarted();
     }
 
+    void startDetached(const std::vector<std::string> &command) override
+    {
+        const auto program = QString::fromStdString(command[0]);
+        QStringList args;
+        for (size_t i = 1; i < command.size(); i++) {
+            args.append(QString::fromStdString(command[i]));
+        }
+
+        // Detached processes can't be tracked through proc_
+        is_detached_ = QProcess::startDetached(program, args);
+    }
+
     bool isRunning() const override
     {
-        return proc_.state() == QProcess::Running;
+        return is_detached_ || proc_.state() == QProcess::Running;
     }
 
     void kill() override
@@ -64,6 +76,7 @@ public:
 
 private:
     QProcess proc_;
+    bool is_detached_{false};
 };
 
 void Process::createImpl()
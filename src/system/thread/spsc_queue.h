@@ -0,0 +1,128 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef SYSTEM_SPSC_QUEUE_H_
+#define SYSTEM_SPSC_QUEUE_H_
+
+#include <atomic>
+#include <utility>
+
+/**
+ * Unbounded lock-free queue between exactly one producer thread and one
+ * consumer thread. Consumed nodes are recycled by the producer, so a queue
+ * in steady state doesn't allocate.
+ */
+template <typename T>
+class SpscQueue
+{
+  public:
+    SpscQueue()
+    {
+        Node* dummy = new Node();
+        tail_.store(dummy, std::memory_order_relaxed);
+        head_      = dummy;
+        first_     = dummy;
+        tail_copy_ = dummy;
+    }
+
+    ~SpscQueue()
+    {
+        Node* node = first_;
+        while (node != nullptr) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /**
+     * Producer side
+     */
+    void push(T&& value)
+    {
+        Node* node = allocate_node();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        node->value = std::move(value);
+
+        head_->next.store(node, std::memory_order_release);
+        head_ = node;
+    }
+
+    /**
+     * Consumer side
+     *
+     * @return false if the queue was empty
+     */
+    bool pop(T& value)
+    {
+        Node* tail = tail_.load(std::memory_order_relaxed);
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return false;
+        }
+
+        value = std::move(next->value);
+        tail_.store(next, std::memory_order_release);
+
+        return true;
+    }
+
+  private:
+    struct Node
+    {
+        std::atomic<Node*> next{nullptr};
+        T value;
+    };
+
+    // Last node consumed, which is the dummy node of the queue
+    std::atomic<Node*> tail_;
+
+    // Owned by the producer: the last node pushed, the oldest node that can
+    // be recycled, and the consumed position seen the last time it checked
+    Node* head_;
+    Node* first_;
+    Node* tail_copy_;
+
+    Node* allocate_node()
+    {
+        if (first_ == tail_copy_) {
+            tail_copy_ = tail_.load(std::memory_order_acquire);
+        }
+
+        if (first_ != tail_copy_) {
+            Node* node = first_;
+            first_     = first_->next.load(std::memory_order_relaxed);
+            return node;
+        }
+
+        return new Node();
+    }
+};
+
+#endif // SYSTEM_SPSC_QUEUE_H_
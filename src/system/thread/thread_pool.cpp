@@ -0,0 +1,134 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "thread_pool.h"
+
+#include <algorithm>
+
+
+ThreadPool::ThreadPool(std::size_t num_workers)
+{
+    workers_.reserve(num_workers);
+    for (std::size_t i = 0; i < num_workers; ++i) {
+        workers_.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        is_stopping_ = true;
+    }
+    task_available_.notify_all();
+
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+
+void ThreadPool::parallel_for(std::size_t count, const RangeTask& task)
+{
+    if (count == 0) {
+        return;
+    }
+
+    const std::size_t num_ranges = std::min(count, workers_.size() + 1);
+    const std::size_t range_size = (count + num_ranges - 1) / num_ranges;
+
+    std::mutex done_mutex;
+    std::condition_variable done;
+    std::size_t remaining_ranges = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // The first range is left for the calling thread
+        for (std::size_t begin = range_size; begin < count;
+             begin += range_size) {
+            const std::size_t end = std::min(begin + range_size, count);
+            ++remaining_ranges;
+
+            tasks_.emplace_back(
+                [&task, &done_mutex, &done, &remaining_ranges, begin, end]() {
+                    task(begin, end);
+
+                    std::lock_guard<std::mutex> done_lock(done_mutex);
+                    if (--remaining_ranges == 0) {
+                        done.notify_one();
+                    }
+                });
+        }
+    }
+    task_available_.notify_all();
+
+    task(0, std::min(range_size, count));
+
+    std::unique_lock<std::mutex> done_lock(done_mutex);
+    done.wait(done_lock, [&remaining_ranges]() {
+        return remaining_ranges == 0;
+    });
+}
+
+
+std::size_t ThreadPool::num_workers() const
+{
+    return workers_.size();
+}
+
+
+ThreadPool& ThreadPool::instance()
+{
+    // The calling thread also takes part in the work
+    static ThreadPool pool(
+        std::max(std::thread::hardware_concurrency(), 1u) - 1);
+    return pool;
+}
+
+
+void ThreadPool::worker_loop()
+{
+    for (;;) {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            task_available_.wait(lock, [this]() {
+                return is_stopping_ || !tasks_.empty();
+            });
+
+            if (tasks_.empty()) {
+                return;
+            }
+
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+
+        task();
+    }
+}
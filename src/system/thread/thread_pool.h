@@ -0,0 +1,77 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef SYSTEM_THREAD_POOL_H_
+#define SYSTEM_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of worker threads for splitting data parallel work
+ */
+class ThreadPool
+{
+  public:
+    using RangeTask = std::function<void(std::size_t begin, std::size_t end)>;
+
+    /**
+     * @param num_workers  Number of threads created besides the caller's
+     */
+    explicit ThreadPool(std::size_t num_workers);
+
+    ~ThreadPool();
+
+    /**
+     * Splits [0, count) in contiguous ranges and runs the task on each of
+     * them in parallel. The calling thread processes one of the ranges and
+     * returns once all of them are done.
+     */
+    void parallel_for(std::size_t count, const RangeTask& task);
+
+    std::size_t num_workers() const;
+
+    /**
+     * Pool shared by the whole process, with one thread per hardware thread
+     */
+    static ThreadPool& instance();
+
+  private:
+    void worker_loop();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+
+    std::mutex mutex_;
+    std::condition_variable task_available_;
+    bool is_stopping_ = false;
+};
+
+#endif // SYSTEM_THREAD_POOL_H_
@@ -0,0 +1,284 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "tracer.h"
+
+#include <chrono>
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QDir>
+
+
+using namespace std;
+
+
+namespace
+{
+
+thread_local uint64_t current_correlation_id = 0;
+
+// Small sequential thread ids read better in the timeline than hashes
+atomic<int> thread_counter{0};
+
+
+int trace_thread_id()
+{
+    thread_local const int thread_id = ++thread_counter;
+    return thread_id;
+}
+
+
+string escape_json(const string& value)
+{
+    string escaped;
+    escaped.reserve(value.size());
+
+    for (const char c : value) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+
+    return escaped;
+}
+
+
+string format_id(uint64_t correlation_id)
+{
+    // Ids are written as strings, since JSON numbers lose 64 bit precision
+    char id[24];
+    snprintf(id,
+             sizeof(id),
+             "\"0x%llx\"",
+             static_cast<unsigned long long>(correlation_id));
+    return id;
+}
+
+} // namespace
+
+
+Tracer& Tracer::instance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+
+Tracer::Tracer()
+    : is_enabled_(false)
+    , correlation_counter_(0)
+    , pid_(QCoreApplication::applicationPid())
+    , file_(nullptr)
+    , is_first_event_(true)
+{
+}
+
+
+Tracer::~Tracer()
+{
+    finish();
+}
+
+
+void Tracer::initialize(const char* process_name)
+{
+    const QByteArray trace_dir = qgetenv("OID_TRACE_DIR");
+    if (trace_dir.isEmpty()) {
+        return;
+    }
+
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (file_ != nullptr) {
+            return;
+        }
+
+        const QString path =
+            QDir(QString::fromLocal8Bit(trace_dir))
+                .filePath(QString("%1_%2.json").arg(process_name).arg(pid_));
+
+        file_ = fopen(path.toLocal8Bit().constData(), "w");
+        if (file_ == nullptr) {
+            fprintf(stderr,
+                    "[OpenImageDebugger] Could not write trace to %s\n",
+                    path.toLocal8Bit().constData());
+            return;
+        }
+
+        fputs("[", file_);
+    }
+
+    is_enabled_ = true;
+
+    write_event("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" +
+                to_string(pid_) + ",\"args\":{\"name\":\"" +
+                escape_json(process_name) + "\"}}");
+}
+
+
+void Tracer::finish()
+{
+    lock_guard<mutex> lock(mutex_);
+
+    is_enabled_ = false;
+    if (file_ != nullptr) {
+        fputs("\n]\n", file_);
+        fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+
+int64_t Tracer::now()
+{
+    return chrono::duration_cast<chrono::microseconds>(
+               chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+
+uint64_t Tracer::next_correlation_id()
+{
+    if (!is_enabled()) {
+        return 0;
+    }
+
+    // Both processes create ids, which the pid keeps apart
+    return (static_cast<uint64_t>(pid_) << 32) | ++correlation_counter_;
+}
+
+
+void Tracer::complete_span(const string& name,
+                           uint64_t correlation_id,
+                           int64_t begin,
+                           int64_t end)
+{
+    if (!is_enabled()) {
+        return;
+    }
+
+    string event = "{\"name\":\"" + escape_json(name) +
+                   "\",\"cat\":\"oid\",\"ph\":\"X\",\"ts\":" +
+                   to_string(begin) + ",\"dur\":" + to_string(end - begin) +
+                   ",\"pid\":" + to_string(pid_) +
+                   ",\"tid\":" + to_string(trace_thread_id());
+    if (correlation_id != 0) {
+        event += ",\"args\":{\"correlation_id\":" +
+                 format_id(correlation_id) + "}";
+    }
+    event += "}";
+
+    write_event(event);
+}
+
+
+void Tracer::flow_begin(uint64_t correlation_id, int64_t time)
+{
+    if (!is_enabled() || correlation_id == 0) {
+        return;
+    }
+
+    write_event("{\"name\":\"message\",\"cat\":\"oid\",\"ph\":\"s\",\"id\":" +
+                format_id(correlation_id) + ",\"ts\":" + to_string(time) +
+                ",\"pid\":" + to_string(pid_) +
+                ",\"tid\":" + to_string(trace_thread_id()) + "}");
+}
+
+
+void Tracer::flow_end(uint64_t correlation_id, int64_t time)
+{
+    if (!is_enabled() || correlation_id == 0) {
+        return;
+    }
+
+    write_event("{\"name\":\"message\",\"cat\":\"oid\",\"ph\":\"f\","
+                "\"bp\":\"e\",\"id\":" +
+                format_id(correlation_id) + ",\"ts\":" + to_string(time) +
+                ",\"pid\":" + to_string(pid_) +
+                ",\"tid\":" + to_string(trace_thread_id()) + "}");
+}
+
+
+void Tracer::write_event(const string& event)
+{
+    lock_guard<mutex> lock(mutex_);
+    if (file_ == nullptr) {
+        return;
+    }
+
+    fputs(is_first_event_ ? "\n" : ",\n", file_);
+    fputs(event.c_str(), file_);
+    is_first_event_ = false;
+}
+
+
+TraceCorrelation::TraceCorrelation(uint64_t correlation_id)
+    : previous_(current_correlation_id)
+{
+    current_correlation_id = correlation_id;
+}
+
+
+TraceCorrelation::~TraceCorrelation()
+{
+    current_correlation_id = previous_;
+}
+
+
+uint64_t TraceCorrelation::current()
+{
+    return current_correlation_id;
+}
+
+
+TraceSpan::TraceSpan(const char* name)
+    : TraceSpan(name, TraceCorrelation::current())
+{
+}
+
+
+TraceSpan::TraceSpan(const char* name, uint64_t correlation_id)
+    : name_(name)
+    , correlation_id_(correlation_id)
+    , begin_(Tracer::instance().is_enabled() ? Tracer::now() : 0)
+{
+}
+
+
+TraceSpan::~TraceSpan()
+{
+    if (begin_ != 0) {
+        Tracer::instance().complete_span(
+            name_, correlation_id_, begin_, Tracer::now());
+    }
+}
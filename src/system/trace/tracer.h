@@ -0,0 +1,150 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef SYSTEM_TRACER_H_
+#define SYSTEM_TRACER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+/**
+ * Writes spans in the Chrome trace event format, which chrome://tracing and
+ * Perfetto display as a timeline.
+ *
+ * Tracing is enabled by setting OID_TRACE_DIR to an existing directory, in
+ * which each process writes <process name>_<pid>.json. Timestamps are taken
+ * from the system clock, so the arrays written by the bridge and the window
+ * can be concatenated into a single timeline (e.g. jq -s add *.json).
+ *
+ * Spans carry the correlation id of the buffer message they work on. It
+ * travels in the header of the IPC messages, and flow events link the send
+ * of a message to its decoding by the other process.
+ */
+class Tracer
+{
+  public:
+    static Tracer& instance();
+
+    /**
+     * Starts writing the trace of this process, if OID_TRACE_DIR is set
+     */
+    void initialize(const char* process_name);
+
+    /**
+     * Writes the end of the trace. Later events are dropped.
+     */
+    void finish();
+
+    bool is_enabled() const
+    {
+        return is_enabled_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Microseconds since the epoch, the time base of all events
+     */
+    static std::int64_t now();
+
+    /**
+     * New correlation id, unique across processes. Zero if tracing is
+     * disabled.
+     */
+    std::uint64_t next_correlation_id();
+
+    void complete_span(const std::string& name,
+                       std::uint64_t correlation_id,
+                       std::int64_t begin,
+                       std::int64_t end);
+
+    // Flow events bind to the enclosing span of their thread
+    void flow_begin(std::uint64_t correlation_id, std::int64_t time);
+
+    void flow_end(std::uint64_t correlation_id, std::int64_t time);
+
+  private:
+    Tracer();
+
+    ~Tracer();
+
+    void write_event(const std::string& event);
+
+    std::atomic<bool> is_enabled_;
+    std::atomic<std::uint64_t> correlation_counter_;
+    std::int64_t pid_;
+
+    // Guards the file, which is written by several threads
+    std::mutex mutex_;
+    std::FILE* file_;
+    bool is_first_event_;
+};
+
+
+/**
+ * Makes a correlation id the current one of the calling thread for its
+ * lifetime. Message composers created meanwhile carry it in their header,
+ * and spans are attributed to it.
+ */
+class TraceCorrelation
+{
+  public:
+    explicit TraceCorrelation(std::uint64_t correlation_id);
+
+    ~TraceCorrelation();
+
+    TraceCorrelation(const TraceCorrelation&) = delete;
+    TraceCorrelation& operator=(const TraceCorrelation&) = delete;
+
+    static std::uint64_t current();
+
+  private:
+    std::uint64_t previous_;
+};
+
+
+/**
+ * Records its lifetime as a span, if tracing is enabled
+ */
+class TraceSpan
+{
+  public:
+    explicit TraceSpan(const char* name);
+
+    TraceSpan(const char* name, std::uint64_t correlation_id);
+
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+  private:
+    const char* name_;
+    std::uint64_t correlation_id_;
+    std::int64_t begin_;
+};
+
+#endif // SYSTEM_TRACER_H_
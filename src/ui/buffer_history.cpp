@@ -0,0 +1,286 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "buffer_history.h"
+
+#include "ipc/buffer_tiles.h"
+#include "ipc/compression.h"
+#include "system/thread/thread_pool.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+/**
+ * XORs the rows of a region of two buffers into a packed tile
+ */
+void xor_region(const uint8_t* a,
+                const uint8_t* b,
+                size_t pitch,
+                const BufferRegion& region,
+                size_t pixel_size,
+                uint8_t* dst)
+{
+    const size_t row_length = static_cast<size_t>(region.width) * pixel_size;
+    const size_t offset     = static_cast<size_t>(region.y) * pitch +
+                          static_cast<size_t>(region.x) * pixel_size;
+
+    for (int y = 0; y < region.height; ++y) {
+        const uint8_t* a_row = a + offset + static_cast<size_t>(y) * pitch;
+        const uint8_t* b_row = b + offset + static_cast<size_t>(y) * pitch;
+        uint8_t* dst_row     = dst + static_cast<size_t>(y) * row_length;
+
+        for (size_t i = 0; i < row_length; ++i) {
+            dst_row[i] = a_row[i] ^ b_row[i];
+        }
+    }
+}
+
+
+bool is_region_equal(const uint8_t* a,
+                     const uint8_t* b,
+                     size_t pitch,
+                     const BufferRegion& region,
+                     size_t pixel_size)
+{
+    const size_t row_length = static_cast<size_t>(region.width) * pixel_size;
+    const size_t offset     = static_cast<size_t>(region.y) * pitch +
+                          static_cast<size_t>(region.x) * pixel_size;
+
+    for (int y = 0; y < region.height; ++y) {
+        const size_t row_offset = offset + static_cast<size_t>(y) * pitch;
+        if (memcmp(a + row_offset, b + row_offset, row_length) != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+
+BufferHistory::BufferHistory(size_t max_versions)
+    : viewed_version(0)
+    , max_versions_(max(max_versions, static_cast<size_t>(1)))
+    , metadata_()
+    , pixel_size_(0)
+    , pitch_(0)
+    , deltas_size_(0)
+{
+}
+
+
+void BufferHistory::push(const BufferMetadata& metadata,
+                         const uint8_t* contents)
+{
+    const size_t pixel_size =
+        static_cast<size_t>(metadata.channels) * typesize(metadata.type);
+    const size_t pitch = static_cast<size_t>(metadata.row_stride) * pixel_size;
+    const size_t length = pitch * static_cast<size_t>(metadata.height);
+
+    viewed_version = 0;
+
+    if (latest_.empty() || !has_same_layout(metadata_, metadata)) {
+        metadata_   = metadata;
+        pixel_size_ = pixel_size;
+        pitch_      = pitch;
+        latest_.assign(contents, contents + length);
+        deltas_.clear();
+        deltas_size_ = 0;
+        return;
+    }
+
+    const int tile_count = buffer_tile_count(metadata.width, metadata.height);
+    vector<TileDelta> tile_deltas(static_cast<size_t>(tile_count));
+    vector<uint8_t> changed(static_cast<size_t>(tile_count), 0);
+
+    const CompressionSettings settings{CompressionCodec::Zlib, 1, 0};
+
+    ThreadPool::instance().parallel_for(
+        static_cast<size_t>(tile_count), [&](size_t begin, size_t end) {
+            vector<uint8_t> xored;
+            for (size_t tile = begin; tile < end; ++tile) {
+                const BufferRegion region = buffer_tile_region(
+                    metadata.width, metadata.height, static_cast<int>(tile));
+                if (is_region_equal(
+                        latest_.data(), contents, pitch, region, pixel_size)) {
+                    continue;
+                }
+
+                xored.resize(static_cast<size_t>(region.width) *
+                             static_cast<size_t>(region.height) * pixel_size);
+                xor_region(latest_.data(),
+                           contents,
+                           pitch,
+                           region,
+                           pixel_size,
+                           xored.data());
+
+                TileDelta& delta = tile_deltas[tile];
+                delta.tile       = static_cast<int>(tile);
+                delta.is_compressed =
+                    compress_block(xored.data(),
+                                   xored.size(),
+                                   settings,
+                                   delta.contents);
+                if (!delta.is_compressed) {
+                    delta.contents = xored;
+                }
+                changed[tile] = 1;
+            }
+        });
+
+    // Identical versions aren't stored twice
+    Delta delta;
+    for (int tile = 0; tile < tile_count; ++tile) {
+        if (changed[static_cast<size_t>(tile)] != 0) {
+            delta.push_back(std::move(tile_deltas[static_cast<size_t>(tile)]));
+        }
+    }
+    if (delta.empty()) {
+        return;
+    }
+
+    latest_.assign(contents, contents + length);
+    metadata_ = metadata;
+
+    deltas_size_ += delta_size(delta);
+    deltas_.push_front(std::move(delta));
+
+    while (deltas_.size() + 1 > max_versions_) {
+        drop_oldest_version();
+    }
+}
+
+
+size_t BufferHistory::version_count() const
+{
+    return latest_.empty() ? 0 : deltas_.size() + 1;
+}
+
+
+bool BufferHistory::reconstruct(size_t version, vector<uint8_t>& contents) const
+{
+    if (version >= version_count()) {
+        return false;
+    }
+
+    contents = latest_;
+    for (size_t i = 0; i < version; ++i) {
+        apply(deltas_[i], contents.data());
+    }
+
+    return true;
+}
+
+
+const BufferMetadata& BufferHistory::metadata() const
+{
+    return metadata_;
+}
+
+
+size_t BufferHistory::memory_usage() const
+{
+    return latest_.size() + deltas_size_;
+}
+
+
+bool BufferHistory::drop_oldest_version()
+{
+    if (deltas_.empty()) {
+        return false;
+    }
+
+    deltas_size_ -= delta_size(deltas_.back());
+    deltas_.pop_back();
+
+    if (viewed_version > deltas_.size()) {
+        viewed_version = deltas_.size();
+    }
+
+    return true;
+}
+
+
+size_t BufferHistory::delta_size(const Delta& delta)
+{
+    size_t size = 0;
+    for (const auto& tile_delta : delta) {
+        size += tile_delta.contents.size() + sizeof(TileDelta);
+    }
+
+    return size;
+}
+
+
+void BufferHistory::apply(const Delta& delta, uint8_t* contents) const
+{
+    ThreadPool::instance().parallel_for(
+        delta.size(), [&](size_t begin, size_t end) {
+            vector<uint8_t> xored;
+            for (size_t i = begin; i < end; ++i) {
+                const TileDelta& tile_delta = delta[i];
+                const BufferRegion region   = buffer_tile_region(
+                    metadata_.width, metadata_.height, tile_delta.tile);
+                const size_t row_length =
+                    static_cast<size_t>(region.width) * pixel_size_;
+
+                const uint8_t* xor_ptr = tile_delta.contents.data();
+                if (tile_delta.is_compressed) {
+                    xored.resize(row_length *
+                                 static_cast<size_t>(region.height));
+                    if (!decompress_block(CompressionCodec::Zlib,
+                                          tile_delta.contents.data(),
+                                          tile_delta.contents.size(),
+                                          xored.data(),
+                                          xored.size())) {
+                        continue;
+                    }
+                    xor_ptr = xored.data();
+                }
+
+                const size_t offset =
+                    static_cast<size_t>(region.y) * pitch_ +
+                    static_cast<size_t>(region.x) * pixel_size_;
+                for (int y = 0; y < region.height; ++y) {
+                    uint8_t* row =
+                        contents + offset + static_cast<size_t>(y) * pitch_;
+                    const uint8_t* xor_row =
+                        xor_ptr + static_cast<size_t>(y) * row_length;
+                    for (size_t x = 0; x < row_length; ++x) {
+                        row[x] ^= xor_row[x];
+                    }
+                }
+            }
+        });
+}
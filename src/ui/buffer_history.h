@@ -0,0 +1,106 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef BUFFER_HISTORY_H_
+#define BUFFER_HISTORY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "ipc/raw_data_decode.h"
+
+
+/**
+ * Previous versions of a buffer, kept so the user can flip back to them.
+ *
+ * Only the latest version is stored in full. Each older version is stored
+ * as the tiles that differ from the next newer one, XORed with it and
+ * compressed: unchanged pixels become runs of zeros, so small edits cost
+ * little memory.
+ */
+class BufferHistory
+{
+  public:
+    explicit BufferHistory(std::size_t max_versions);
+
+    /**
+     * Adds the contents as the latest version. The history restarts if the
+     * buffer layout changed.
+     */
+    void push(const BufferMetadata& metadata, const std::uint8_t* contents);
+
+    /**
+     * Number of versions, including the latest one
+     */
+    std::size_t version_count() const;
+
+    /**
+     * Rebuilds a version, 0 being the latest and version_count() - 1 the
+     * oldest
+     */
+    bool reconstruct(std::size_t version,
+                     std::vector<std::uint8_t>& contents) const;
+
+    const BufferMetadata& metadata() const;
+
+    std::size_t memory_usage() const;
+
+    /**
+     * Drops the oldest version, unless only the latest is left
+     */
+    bool drop_oldest_version();
+
+    // Version shown by the viewer, 0 being the latest
+    std::size_t viewed_version;
+
+  private:
+    struct TileDelta
+    {
+        int tile;
+        bool is_compressed;
+        std::vector<std::uint8_t> contents;
+    };
+
+    using Delta = std::vector<TileDelta>;
+
+    std::size_t max_versions_;
+
+    BufferMetadata metadata_;
+    std::size_t pixel_size_;
+    std::size_t pitch_;
+    std::vector<std::uint8_t> latest_;
+
+    // Newest first. Delta i turns version i into version i + 1.
+    std::deque<Delta> deltas_;
+    std::size_t deltas_size_;
+
+    static std::size_t delta_size(const Delta& delta);
+
+    void apply(const Delta& delta, std::uint8_t* contents) const;
+};
+
+#endif // BUFFER_HISTORY_H_
@@ -0,0 +1,401 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "buffer_list_model.h"
+
+#include <algorithm>
+
+#include <QMimeData>
+#include <QStringList>
+
+
+using namespace std;
+
+
+namespace
+{
+
+// Names of the dragged buffers, one per line
+const char* const buffer_names_mime_type = "application/x-oid-buffer-names";
+
+
+// Expression of a buffer, without the context it is evaluated in, which the
+// debugger scripts append to the name of buffers bound to a thread (e.g.
+// "image [thread 1.2, frame 0]")
+string buffer_expression(const string& buffer_name)
+{
+    const size_t context_begin = buffer_name.rfind('[');
+    if (context_begin == string::npos || context_begin == 0 ||
+        buffer_name.back() != ']') {
+        return buffer_name;
+    }
+
+    const size_t keyword =
+        buffer_name.find_first_not_of(' ', context_begin + 1);
+    if (keyword == string::npos ||
+        buffer_name.compare(keyword, 7, "thread ") != 0) {
+        return buffer_name;
+    }
+
+    const size_t expression_end =
+        buffer_name.find_last_not_of(' ', context_begin - 1);
+    if (expression_end == string::npos) {
+        return buffer_name;
+    }
+
+    return buffer_name.substr(0, expression_end + 1);
+}
+
+} // namespace
+
+
+BufferListModel::BufferListModel(QObject* parent)
+    : QAbstractListModel(parent)
+    , icons_(max_cached_icons)
+{
+}
+
+
+void BufferListModel::set_icon_request_handler(
+    const IconRequestHandler& handler)
+{
+    icon_request_handler_ = handler;
+}
+
+
+int BufferListModel::buffer_row(const string& buffer_name) const
+{
+    const auto row = rows_.find(buffer_name);
+    return row != rows_.end() ? row->second : -1;
+}
+
+
+QModelIndex BufferListModel::buffer_index(const string& buffer_name) const
+{
+    const int row = buffer_row(buffer_name);
+    return row >= 0 ? index(row) : QModelIndex();
+}
+
+
+string BufferListModel::buffer_name(const QModelIndex& index) const
+{
+    if (!index.isValid() || index.row() >= static_cast<int>(entries_.size())) {
+        return "";
+    }
+
+    return entries_[index.row()].name;
+}
+
+
+void BufferListModel::add_buffer(const string& buffer_name,
+                                 const QString& label)
+{
+    if (buffer_row(buffer_name) >= 0) {
+        set_label(buffer_name, label);
+        return;
+    }
+
+    // Buffers of the same expression evaluated in other threads are listed
+    // next to each other, so that they can be compared
+    const string expression = buffer_expression(buffer_name);
+    int row                 = static_cast<int>(entries_.size());
+    for (int listed_row = row - 1; listed_row >= 0; --listed_row) {
+        if (buffer_expression(entries_[listed_row].name) == expression) {
+            row = listed_row + 1;
+            break;
+        }
+    }
+
+    beginInsertRows(QModelIndex(), row, row);
+
+    Entry entry;
+    entry.name  = buffer_name;
+    entry.label = label;
+    entries_.insert(entries_.begin() + row, entry);
+    index_rows(row);
+
+    endInsertRows();
+}
+
+
+void BufferListModel::set_label(const string& buffer_name,
+                                const QString& label)
+{
+    const int row = buffer_row(buffer_name);
+    if (row < 0 || entries_[row].label == label) {
+        return;
+    }
+
+    entries_[row].label = label;
+    mark_changed(buffer_name);
+}
+
+
+void BufferListModel::remove_buffer(const string& buffer_name)
+{
+    const int row = buffer_row(buffer_name);
+    if (row < 0) {
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+
+    entries_.erase(entries_.begin() + row);
+    rows_.erase(buffer_name);
+    index_rows(row);
+
+    icons_.remove(QString::fromStdString(buffer_name));
+    changed_buffers_.erase(buffer_name);
+
+    endRemoveRows();
+}
+
+
+void BufferListModel::outdate_icon(const string& buffer_name)
+{
+    const int row = buffer_row(buffer_name);
+    if (row < 0) {
+        return;
+    }
+
+    // The icon is requested again when the view repaints the row
+    Entry& entry = entries_[row];
+    ++entry.icon_revision;
+    entry.is_icon_requested = false;
+    mark_changed(buffer_name);
+}
+
+
+void BufferListModel::set_icon(const string& buffer_name, const QPixmap& icon)
+{
+    const int row = buffer_row(buffer_name);
+    if (row < 0) {
+        return;
+    }
+
+    // Icons requested before the buffer changed are shown until the next
+    // one arrives
+    Entry& entry            = entries_[row];
+    entry.is_icon_requested = false;
+    icons_.insert(QString::fromStdString(buffer_name),
+                  new CachedIcon{icon, entry.requested_revision});
+    mark_changed(buffer_name);
+}
+
+
+void BufferListModel::flush_changes()
+{
+    if (changed_buffers_.empty()) {
+        return;
+    }
+
+    vector<int> rows;
+    for (const auto& buffer_name : changed_buffers_) {
+        rows.push_back(buffer_row(buffer_name));
+    }
+    changed_buffers_.clear();
+    sort(rows.begin(), rows.end());
+
+    // Consecutive rows are notified at once
+    size_t first = 0;
+    for (size_t i = 1; i <= rows.size(); ++i) {
+        if (i < rows.size() && rows[i] == rows[i - 1] + 1) {
+            continue;
+        }
+
+        Q_EMIT dataChanged(index(rows[first]), index(rows[i - 1]));
+        first = i;
+    }
+}
+
+
+int BufferListModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(entries_.size());
+}
+
+
+QVariant BufferListModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= static_cast<int>(entries_.size())) {
+        return QVariant();
+    }
+
+    const Entry& entry = entries_[index.row()];
+
+    if (role == Qt::DisplayRole) {
+        return entry.label;
+    } else if (role == Qt::UserRole) {
+        return QString::fromStdString(entry.name);
+    } else if (role != Qt::DecorationRole) {
+        return QVariant();
+    }
+
+    // Only the icons of the rows being painted are asked for
+    const CachedIcon* icon =
+        icons_.object(QString::fromStdString(entry.name));
+    const bool is_outdated =
+        icon == nullptr || icon->revision != entry.icon_revision;
+    if (is_outdated && !entry.is_icon_requested && icon_request_handler_) {
+        entry.requested_revision = entry.icon_revision;
+        entry.is_icon_requested  = icon_request_handler_(entry.name);
+    }
+
+    if (icon == nullptr) {
+        return QVariant();
+    }
+
+    return icon->pixmap;
+}
+
+
+Qt::ItemFlags BufferListModel::flags(const QModelIndex& index) const
+{
+    // Dragged buffers are dropped between the rows
+    if (!index.isValid()) {
+        return Qt::ItemIsDropEnabled;
+    }
+
+    return Qt::ItemIsSelectable | Qt::ItemIsEnabled | Qt::ItemIsDragEnabled;
+}
+
+
+Qt::DropActions BufferListModel::supportedDropActions() const
+{
+    return Qt::MoveAction;
+}
+
+
+QStringList BufferListModel::mimeTypes() const
+{
+    return QStringList(buffer_names_mime_type);
+}
+
+
+QMimeData* BufferListModel::mimeData(const QModelIndexList& indexes) const
+{
+    QStringList buffer_names;
+    for (const QModelIndex& index : indexes) {
+        if (index.isValid()) {
+            buffer_names.append(QString::fromStdString(buffer_name(index)));
+        }
+    }
+
+    QMimeData* data = new QMimeData();
+    data->setData(buffer_names_mime_type, buffer_names.join("\n").toUtf8());
+
+    return data;
+}
+
+
+bool BufferListModel::dropMimeData(const QMimeData* data,
+                                   Qt::DropAction action,
+                                   int row,
+                                   int,
+                                   const QModelIndex& parent)
+{
+    if (action != Qt::MoveAction || !data->hasFormat(buffer_names_mime_type)) {
+        return false;
+    }
+
+    // Buffers dropped on a row are moved before it
+    int destination = row;
+    if (destination < 0) {
+        destination = parent.isValid() ? parent.row() : rowCount();
+    }
+
+    const QStringList buffer_names =
+        QString::fromUtf8(data->data(buffer_names_mime_type)).split("\n");
+
+    // The rows are moved here, so dropping never removes the dragged rows
+    for (const QString& buffer_name : buffer_names) {
+        const int source = buffer_row(buffer_name.toStdString());
+        if (source < 0) {
+            continue;
+        }
+
+        if (source != destination && source + 1 != destination) {
+            moveRows(QModelIndex(), source, 1, QModelIndex(), destination);
+        }
+
+        // The following buffers are placed after this one
+        destination = buffer_row(buffer_name.toStdString()) + 1;
+    }
+
+    return true;
+}
+
+
+bool BufferListModel::moveRows(const QModelIndex& source_parent,
+                               int source_row,
+                               int count,
+                               const QModelIndex& destination_parent,
+                               int destination_child)
+{
+    const int row_count = static_cast<int>(entries_.size());
+    if (source_parent.isValid() || destination_parent.isValid() ||
+        count <= 0 || source_row < 0 || source_row + count > row_count ||
+        destination_child < 0 || destination_child > row_count) {
+        return false;
+    }
+
+    if (!beginMoveRows(source_parent,
+                       source_row,
+                       source_row + count - 1,
+                       destination_parent,
+                       destination_child)) {
+        return false;
+    }
+
+    const auto source_begin = entries_.begin() + source_row;
+    vector<Entry> moved(source_begin, source_begin + count);
+    entries_.erase(source_begin, source_begin + count);
+
+    // The destination is given before the rows are taken out
+    const int insertion = destination_child > source_row
+                              ? destination_child - count
+                              : destination_child;
+    entries_.insert(entries_.begin() + insertion, moved.begin(), moved.end());
+    index_rows(min(source_row, insertion));
+
+    endMoveRows();
+
+    return true;
+}
+
+
+void BufferListModel::index_rows(int first_row)
+{
+    for (int row = first_row; row < static_cast<int>(entries_.size());
+         ++row) {
+        rows_[entries_[row].name] = row;
+    }
+}
+
+
+void BufferListModel::mark_changed(const string& buffer_name)
+{
+    changed_buffers_.insert(buffer_name);
+}
@@ -0,0 +1,174 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef BUFFER_LIST_MODEL_H_
+#define BUFFER_LIST_MODEL_H_
+
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <QAbstractListModel>
+#include <QCache>
+#include <QPixmap>
+#include <QString>
+
+
+/**
+ * Buffers listed in the left pane, indexed by name.
+ *
+ * The icons are only rendered for the rows the view shows: the view asks
+ * for the icons of the rows it paints, and outdated or missing icons are
+ * then requested from the icon request handler. A bounded number of icons
+ * is kept, and icons dropped from it are requested again once their row is
+ * shown. Changes to the rows are notified to the views at once by
+ * flush_changes, so that a stop updating many buffers repaints the list
+ * once.
+ */
+class BufferListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+  public:
+    // Callback asked to render the icon of a buffer, and hand it back with
+    // set_icon. It returns false if the icon can't be rendered, in which
+    // case the buffer is shown without an icon.
+    using IconRequestHandler =
+        std::function<bool(const std::string& buffer_name)>;
+
+    // Most icons kept at once
+    static const int max_cached_icons = 256;
+
+    explicit BufferListModel(QObject* parent = nullptr);
+
+    void set_icon_request_handler(const IconRequestHandler& handler);
+
+    /**
+     * Row of the buffer, or -1 if it isn't listed
+     */
+    int buffer_row(const std::string& buffer_name) const;
+
+    /**
+     * Index of the buffer, invalid if it isn't listed
+     */
+    QModelIndex buffer_index(const std::string& buffer_name) const;
+
+    /**
+     * Name of the buffer at the index, empty if the index is invalid
+     */
+    std::string buffer_name(const QModelIndex& index) const;
+
+    /**
+     * Lists the buffer after the ones of the same expression evaluated in
+     * another thread, or at the end of the list. Updates its label instead
+     * if it is already listed.
+     */
+    void add_buffer(const std::string& buffer_name, const QString& label);
+
+    /**
+     * Updates the label of a listed buffer, if it differs
+     */
+    void set_label(const std::string& buffer_name, const QString& label);
+
+    void remove_buffer(const std::string& buffer_name);
+
+    /**
+     * Marks the icon of the buffer as outdated. It is shown until the new
+     * one is set, and is only requested again if its row is shown.
+     */
+    void outdate_icon(const std::string& buffer_name);
+
+    void set_icon(const std::string& buffer_name, const QPixmap& icon);
+
+    /**
+     * Notifies the views of the rows changed since the last call
+     */
+    void flush_changes();
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const;
+
+    QVariant data(const QModelIndex& index, int role) const;
+
+    Qt::ItemFlags flags(const QModelIndex& index) const;
+
+    ///
+    // Rows are reordered by dragging them in the view
+    Qt::DropActions supportedDropActions() const;
+
+    QStringList mimeTypes() const;
+
+    QMimeData* mimeData(const QModelIndexList& indexes) const;
+
+    bool dropMimeData(const QMimeData* data,
+                      Qt::DropAction action,
+                      int row,
+                      int column,
+                      const QModelIndex& parent);
+
+    bool moveRows(const QModelIndex& source_parent,
+                  int source_row,
+                  int count,
+                  const QModelIndex& destination_parent,
+                  int destination_child);
+
+  private:
+    struct Entry
+    {
+        std::string name;
+        QString label;
+        // Incremented each time the icon gets outdated
+        uint64_t icon_revision = 0;
+        // Revision the icon being rendered was requested for
+        mutable uint64_t requested_revision = 0;
+        mutable bool is_icon_requested      = false;
+    };
+
+    struct CachedIcon
+    {
+        QPixmap pixmap;
+        uint64_t revision;
+    };
+
+    // Updates the rows of the entries from the given one onwards
+    void index_rows(int first_row);
+
+    void mark_changed(const std::string& buffer_name);
+
+    std::vector<Entry> entries_;
+    std::unordered_map<std::string, int> rows_;
+
+    mutable QCache<QString, CachedIcon> icons_;
+
+    // Buffers changed since the last notification. Their rows are only
+    // looked up then, as they may have moved in the meantime.
+    std::set<std::string> changed_buffers_;
+
+    IconRequestHandler icon_request_handler_;
+};
+
+#endif // BUFFER_LIST_MODEL_H_
@@ -25,8 +25,17 @@
 
 #include "gl_canvas.h"
 
+#include <QOpenGLContext>
+
 #include "main_window/main_window.h"
+#include "ui/gl_icon_readback.h"
+#include "ui/gl_difference_reducer.h"
+#include "ui/gl_frame_timer.h"
+#include "ui/gl_min_max_reducer.h"
+#include "ui/gl_program_cache.h"
 #include "ui/gl_text_renderer.h"
+#include "ui/gl_texture_streamer.h"
+#include "ui/gl_tile_residency.h"
 #include "visualization/components/camera.h"
 #include "visualization/game_object.h"
 
@@ -36,13 +45,31 @@ using namespace std;
 
 GLCanvas::GLCanvas(QWidget* parent)
     : QOpenGLWidget(parent)
-    , QOpenGLFunctions()
+    , QOpenGLExtraFunctions()
     , mouse_x_(0)
     , mouse_y_(0)
+    , is_selecting_region_(false)
+    , region_band_(new QRubberBand(QRubberBand::Rectangle, this))
     , initialized_(false)
+    , is_integer_texture_supported_(false)
+    , program_cache_(new GLProgramCache(this))
     , text_renderer_(new GLTextRenderer(this))
+    , texture_streamer_(new GLTextureStreamer(this))
+    , tile_residency_(new GLTileResidency())
+    , min_max_reducer_(new GLMinMaxReducer(this))
+    , difference_reducer_(new GLDifferenceReducer(this))
+    , icon_readback_(new GLIconReadback(this))
+    , frame_timer_(new GLFrameTimer(this))
+    , hud_label_(new QLabel(this))
 {
     mouse_down_[0] = mouse_down_[1] = false;
+
+    hud_label_->setAttribute(Qt::WA_TransparentForMouseEvents);
+    hud_label_->setStyleSheet("QLabel { background-color: rgba(0, 0, 0, 160);"
+                              " color: white; font-family: monospace;"
+                              " padding: 4px; }");
+    hud_label_->move(0, 0);
+    hud_label_->hide();
 }
 
 
@@ -59,7 +86,18 @@ void GLCanvas::mouseMoveEvent(QMouseEvent* ev)
     mouse_x_ = ev->localPos().x();
     mouse_y_ = ev->localPos().y();
 
-    if (mouse_down_[0]) {
+    if (is_selecting_region_) {
+        const QPoint region_end(mouse_x_, mouse_y_);
+        region_band_->setGeometry(
+            QRect(region_origin_, region_end).normalized());
+
+        // The statistics follow the selection while it is dragged
+        const QRect view = viewport();
+        main_window_->select_region(region_origin_.x() - view.x(),
+                                    region_origin_.y() - view.y(),
+                                    region_end.x() - view.x(),
+                                    region_end.y() - view.y());
+    } else if (mouse_down_[0]) {
         main_window_->mouse_drag_event(mouse_x_ - last_mouse_x,
                                        mouse_y_ - last_mouse_y);
     } else {
@@ -71,8 +109,23 @@ void GLCanvas::mouseMoveEvent(QMouseEvent* ev)
 
 void GLCanvas::mousePressEvent(QMouseEvent* ev)
 {
-    if (ev->button() == Qt::LeftButton)
-        mouse_down_[0] = true;
+    mouse_x_ = ev->localPos().x();
+    mouse_y_ = ev->localPos().y();
+
+    // Clicking a view selects the buffer it shows
+    main_window_->select_view_at(mouse_x_, mouse_y_);
+
+    if (ev->button() == Qt::LeftButton) {
+        if (ev->modifiers() & Qt::ShiftModifier) {
+            is_selecting_region_ = true;
+            region_origin_       = QPoint(mouse_x_, mouse_y_);
+            region_band_->setGeometry(QRect(region_origin_, QSize()));
+            region_band_->show();
+        } else {
+            main_window_->clear_region_selection();
+            mouse_down_[0] = true;
+        }
+    }
 
     if (ev->button() == Qt::RightButton)
         mouse_down_[1] = true;
@@ -81,8 +134,13 @@ void GLCanvas::mousePressEvent(QMouseEvent* ev)
 
 void GLCanvas::mouseReleaseEvent(QMouseEvent* ev)
 {
-    if (ev->button() == Qt::LeftButton)
+    if (ev->button() == Qt::LeftButton) {
+        // The statistics of the selection stay in the status bar until the
+        // next click
+        is_selecting_region_ = false;
+        region_band_->hide();
         mouse_down_[0] = false;
+    }
 
     if (ev->button() == Qt::RightButton)
         mouse_down_[1] = false;
@@ -142,9 +200,32 @@ void GLCanvas::initializeGL()
 
     glBindFramebuffer(GL_FRAMEBUFFER_EXT, 0);
 
+    // Integer textures are core since OpenGL 3.0 and OpenGL ES 3.0
+    is_integer_texture_supported_ =
+        context()->format().version() >= qMakePair(3, 0) ||
+        context()->hasExtension("GL_EXT_texture_integer");
+
+    // Initialize shader programs shared by all stages
+    program_cache_->initialize();
+
     // Initialize text renderer
     text_renderer_->initialize();
 
+    // Initialize buffer texture uploads
+    texture_streamer_->initialize();
+
+    // Initialize auto-contrast computation on the GPU
+    min_max_reducer_->initialize();
+
+    // Initialize buffer comparisons on the GPU
+    difference_reducer_->initialize();
+
+    // Initialize buffer icon readbacks
+    icon_readback_->initialize();
+
+    // Initialize frame time measurements
+    frame_timer_->initialize();
+
     initialized_ = true;
 }
 
@@ -152,30 +233,105 @@ void GLCanvas::initializeGL()
 void GLCanvas::paintGL()
 {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    tile_residency_->begin_frame();
+    frame_timer_->begin_frame();
     main_window_->draw();
+    frame_timer_->end_frame();
 }
 
 
 void GLCanvas::wheelEvent(QWheelEvent* ev)
 {
+    mouse_x_ = ev->pos().x();
+    mouse_y_ = ev->pos().y();
+
+    main_window_->select_view_at(mouse_x_, mouse_y_);
+
     main_window_->scroll_callback(ev->delta() / 120.0f);
 }
 
 
-const GLTextRenderer* GLCanvas::get_text_renderer()
+GLTextRenderer* GLCanvas::get_text_renderer()
 {
     return text_renderer_.get();
 }
 
 
-void GLCanvas::render_buffer_icon(Stage* stage, const int icon_width, const int icon_height)
+GLProgramCache* GLCanvas::get_program_cache()
+{
+    return program_cache_.get();
+}
+
+
+GLMinMaxReducer* GLCanvas::get_min_max_reducer()
+{
+    return min_max_reducer_.get();
+}
+
+
+GLDifferenceReducer* GLCanvas::get_difference_reducer()
+{
+    return difference_reducer_.get();
+}
+
+
+GLTextureStreamer* GLCanvas::get_texture_streamer()
+{
+    return texture_streamer_.get();
+}
+
+
+GLTileResidency* GLCanvas::get_tile_residency()
+{
+    return tile_residency_.get();
+}
+
+
+GLIconReadback* GLCanvas::get_icon_readback()
 {
+    return icon_readback_.get();
+}
+
+
+const GLFrameTimer* GLCanvas::get_frame_timer() const
+{
+    return frame_timer_.get();
+}
+
+
+void GLCanvas::set_hud_visible(bool is_visible)
+{
+    hud_label_->setVisible(is_visible);
+}
+
+
+bool GLCanvas::is_hud_visible() const
+{
+    return hud_label_->isVisible();
+}
+
+
+void GLCanvas::set_hud_text(const QString& text)
+{
+    hud_label_->setText(text);
+    hud_label_->adjustSize();
+}
+
+
+bool GLCanvas::render_buffer_icon(Stage* stage,
+                                  const int icon_width,
+                                  const int icon_height)
+{
+    if (!icon_readback_->has_free_slot()) {
+        return false;
+    }
+
     glBindFramebuffer(GL_FRAMEBUFFER_EXT, icon_fbo_);
 
     glViewport(0, 0, icon_width, icon_height);
 
-    GameObject* camera = stage->get_game_object("camera");
-    Camera* cam        = camera->get_component<Camera>("camera_component");
+    GameObject* camera = stage->get_camera_object();
+    Camera* cam        = stage->get_camera_component();
 
     // Save original camera pose
     Camera original_pose = *cam;
@@ -188,22 +344,18 @@ void GLCanvas::render_buffer_icon(Stage* stage, const int icon_width, const int
     // Reposition buffer in the center of the canvas
     cam->recenter_camera();
 
+    tile_residency_->begin_frame();
     stage->draw();
-    stage->buffer_icon.resize(3 * static_cast<size_t>(icon_width) * static_cast<size_t>(icon_height));
-    glPixelStorei(GL_PACK_ALIGNMENT, 1);
-    glReadPixels(0,
-                 0,
-                 icon_width,
-                 icon_height,
-                 GL_RGB,
-                 GL_UNSIGNED_BYTE,
-                 stage->buffer_icon.data());
+    icon_readback_->read(
+        stage->buffer_metadata.variable_name, icon_width, icon_height);
 
     // Reset stage camera
     glBindFramebuffer(GL_FRAMEBUFFER_EXT, 0);
-    glViewport(0, 0, width(), height());
+    set_draw_region(viewport());
     *cam = original_pose;
-    cam->window_resized(width(), height());
+    cam->window_resized(viewport_width(), viewport_height());
+
+    return true;
 }
 
 
@@ -214,6 +366,25 @@ void GLCanvas::resizeGL(int w, int h)
 }
 
 
+void GLCanvas::set_viewport(const QRect& viewport)
+{
+    viewport_ = viewport;
+}
+
+
+void GLCanvas::set_draw_region(const QRect& region)
+{
+    // The drawable is measured in device pixels, with its origin at the
+    // bottom left corner
+    const qreal scale = devicePixelRatioF();
+    glViewport(static_cast<GLint>(region.x() * scale),
+               static_cast<GLint>((height() - region.y() - region.height()) *
+                                  scale),
+               static_cast<GLsizei>(region.width() * scale),
+               static_cast<GLsizei>(region.height() * scale));
+}
+
+
 void GLCanvas::set_main_window(MainWindow* mw)
 {
     main_window_ = mw;
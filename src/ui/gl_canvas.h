@@ -28,17 +28,27 @@
 
 #include <memory>
 
+#include <QLabel>
 #include <QMouseEvent>
-#include <QOpenGLFunctions>
+#include <QOpenGLExtraFunctions>
 #include <QOpenGLWidget>
+#include <QRect>
+#include <QRubberBand>
 
 
 class MainWindow;
 class Stage;
+class GLDifferenceReducer;
+class GLFrameTimer;
+class GLIconReadback;
+class GLMinMaxReducer;
+class GLProgramCache;
 class GLTextRenderer;
+class GLTextureStreamer;
+class GLTileResidency;
 
 
-class GLCanvas : public QOpenGLWidget, public QOpenGLFunctions
+class GLCanvas : public QOpenGLWidget, public QOpenGLExtraFunctions
 {
     Q_OBJECT
   public:
@@ -60,16 +70,45 @@ class GLCanvas : public QOpenGLWidget, public QOpenGLFunctions
 
     void wheelEvent(QWheelEvent* ev);
 
+    // Mouse position relative to the active viewport
     int mouse_x()
     {
-        return mouse_x_;
+        return mouse_x_ - viewport_.x();
     }
 
     int mouse_y()
     {
-        return mouse_y_;
+        return mouse_y_ - viewport_.y();
     }
 
+    /**
+     * Region of the canvas the selected buffer is drawn to, in widget
+     * coordinates. The cameras and mouse positions are relative to it. It
+     * covers the whole canvas unless the canvas is split into several views.
+     */
+    void set_viewport(const QRect& viewport);
+
+    QRect viewport() const
+    {
+        return viewport_.isEmpty() ? rect() : viewport_;
+    }
+
+    int viewport_width() const
+    {
+        return viewport().width();
+    }
+
+    int viewport_height() const
+    {
+        return viewport().height();
+    }
+
+    /**
+     * Restricts the following draw calls to a region of the canvas, given in
+     * widget coordinates
+     */
+    void set_draw_region(const QRect& region);
+
     bool is_mouse_down()
     {
         return mouse_down_[0];
@@ -80,11 +119,45 @@ class GLCanvas : public QOpenGLWidget, public QOpenGLFunctions
         return initialized_;
     }
 
-    const GLTextRenderer* get_text_renderer();
+    bool is_integer_texture_supported() const
+    {
+        return is_integer_texture_supported_;
+    }
+
+    GLTextRenderer* get_text_renderer();
+
+    GLTextureStreamer* get_texture_streamer();
+
+    GLTileResidency* get_tile_residency();
+
+    GLProgramCache* get_program_cache();
+
+    GLMinMaxReducer* get_min_max_reducer();
+
+    GLDifferenceReducer* get_difference_reducer();
+
+    GLIconReadback* get_icon_readback();
+
+    const GLFrameTimer* get_frame_timer() const;
+
+    /**
+     * Performance overlay drawn over the top left corner of the canvas
+     */
+    void set_hud_visible(bool is_visible);
+
+    bool is_hud_visible() const;
+
+    void set_hud_text(const QString& text);
 
     void set_main_window(MainWindow* mw);
 
-    void render_buffer_icon(Stage* stage, const int icon_width, const int icon_height);
+    /**
+     * Renders the icon of a stage and starts reading it back. Returns false
+     * if all readbacks are in flight, in which case nothing is rendered.
+     */
+    bool render_buffer_icon(Stage* stage,
+                            const int icon_width,
+                            const int icon_height);
 
   private:
     bool mouse_down_[2];
@@ -92,6 +165,14 @@ class GLCanvas : public QOpenGLWidget, public QOpenGLFunctions
     int mouse_x_;
     int mouse_y_;
 
+    // Shift and left button drags select a buffer region instead of moving
+    // the view. The selection starts at the origin, in widget coordinates.
+    bool is_selecting_region_;
+    QPoint region_origin_;
+    QRubberBand* region_band_;
+
+    QRect viewport_;
+
     MainWindow* main_window_;
 
     GLuint icon_texture_;
@@ -99,8 +180,26 @@ class GLCanvas : public QOpenGLWidget, public QOpenGLFunctions
 
     bool initialized_;
 
+    bool is_integer_texture_supported_;
+
+    std::unique_ptr<GLProgramCache> program_cache_;
+
     std::unique_ptr<GLTextRenderer> text_renderer_;
 
+    std::unique_ptr<GLTextureStreamer> texture_streamer_;
+
+    std::unique_ptr<GLTileResidency> tile_residency_;
+
+    std::unique_ptr<GLMinMaxReducer> min_max_reducer_;
+
+    std::unique_ptr<GLDifferenceReducer> difference_reducer_;
+
+    std::unique_ptr<GLIconReadback> icon_readback_;
+
+    std::unique_ptr<GLFrameTimer> frame_timer_;
+
+    QLabel* hud_label_;
+
     void generate_icon_texture();
 };
 
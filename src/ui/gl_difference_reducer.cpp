@@ -0,0 +1,239 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#include <QOpenGLContext>
+
+#include "gl_difference_reducer.h"
+
+#include "ui/gl_program_cache.h"
+#include "visualization/shaders/oid_shaders.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+// Texels covered by each work group of the difference shader, on each axis
+const int work_group_texels = 16 * 4;
+
+// Layout of the Errors block of the shaders
+struct Errors
+{
+    float error_sum[4];
+    uint32_t largest[4];
+    uint32_t mismatches;
+};
+
+} // namespace
+
+
+GLDifferenceReducer::GLDifferenceReducer(GLCanvas* gl_canvas)
+    : gl_canvas_(gl_canvas)
+{
+}
+
+
+GLDifferenceReducer::~GLDifferenceReducer()
+{
+    if (errors_buffer_ != 0) {
+        gl_canvas_->glDeleteBuffers(1, &errors_buffer_);
+        gl_canvas_->glDeleteBuffers(1, &partial_sums_buffer_);
+    }
+}
+
+
+bool GLDifferenceReducer::initialize()
+{
+    QOpenGLContext* context = gl_canvas_->context();
+
+    is_supported_ = !context->isOpenGLES() &&
+                    context->format().version() >= qMakePair(4, 3);
+
+    if (!is_supported_) {
+        return true;
+    }
+
+    gl_canvas_->glGenBuffers(1, &errors_buffer_);
+    gl_canvas_->glBindBuffer(GL_SHADER_STORAGE_BUFFER, errors_buffer_);
+    gl_canvas_->glBufferData(
+        GL_SHADER_STORAGE_BUFFER, sizeof(Errors), nullptr, GL_DYNAMIC_READ);
+
+    // The partial sums never leave the GPU. They are allocated once the
+    // size of the compared buffers is known.
+    gl_canvas_->glGenBuffers(1, &partial_sums_buffer_);
+    gl_canvas_->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    return true;
+}
+
+
+bool GLDifferenceReducer::is_supported() const
+{
+    return is_supported_;
+}
+
+
+bool GLDifferenceReducer::reduce(const vector<GLuint>& textures,
+                                 const vector<GLuint>& reference_textures,
+                                 ShaderProgram::TexelStorage texel_storage,
+                                 ShaderProgram::TexelLayout texel_layout,
+                                 int channels,
+                                 float threshold,
+                                 float* largest,
+                                 float* mean,
+                                 size_t& mismatches)
+{
+    if (!is_supported_ || textures.empty() ||
+        textures.size() != reference_textures.size()) {
+        return false;
+    }
+
+    GLProgramCache* program_cache = gl_canvas_->get_program_cache();
+    const GLuint difference_program = program_cache->get_compute_program(
+        shader::difference_comp_shader, texel_storage, texel_layout);
+    const GLuint sum_program =
+        program_cache->get_compute_program(shader::error_sum_comp_shader,
+                                           ShaderProgram::StorageNormalized,
+                                           ShaderProgram::LayoutInterleaved);
+    if (difference_program == 0 || sum_program == 0) {
+        return false;
+    }
+
+    const GLenum target = texel_layout == ShaderProgram::LayoutPlanar
+                              ? GL_TEXTURE_2D_ARRAY
+                              : GL_TEXTURE_2D;
+
+    // Work groups of each texture, each leaving its own partial sums
+    vector<GLint> texture_widths(textures.size());
+    vector<GLint> texture_heights(textures.size());
+    size_t texel_count = 0;
+    int group_count    = 0;
+    for (size_t i = 0; i < textures.size(); ++i) {
+        gl_canvas_->glBindTexture(target, textures[i]);
+        gl_canvas_->glGetTexLevelParameteriv(
+            target, 0, GL_TEXTURE_WIDTH, &texture_widths[i]);
+        gl_canvas_->glGetTexLevelParameteriv(
+            target, 0, GL_TEXTURE_HEIGHT, &texture_heights[i]);
+
+        texel_count += static_cast<size_t>(texture_widths[i]) *
+                       static_cast<size_t>(texture_heights[i]);
+        group_count +=
+            ((texture_widths[i] + work_group_texels - 1) / work_group_texels) *
+            ((texture_heights[i] + work_group_texels - 1) / work_group_texels);
+    }
+
+    if (texel_count == 0) {
+        return false;
+    }
+
+    gl_canvas_->glBindBuffer(GL_SHADER_STORAGE_BUFFER, partial_sums_buffer_);
+    if (group_count > partial_sums_capacity_) {
+        gl_canvas_->glBufferData(GL_SHADER_STORAGE_BUFFER,
+                                 group_count * 4 * sizeof(float),
+                                 nullptr,
+                                 GL_DYNAMIC_COPY);
+        partial_sums_capacity_ = group_count;
+    }
+
+    const Errors initial_errors = {};
+    gl_canvas_->glBindBuffer(GL_SHADER_STORAGE_BUFFER, errors_buffer_);
+    gl_canvas_->glBufferSubData(
+        GL_SHADER_STORAGE_BUFFER, 0, sizeof(initial_errors), &initial_errors);
+
+    gl_canvas_->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, errors_buffer_);
+    gl_canvas_->glBindBufferBase(
+        GL_SHADER_STORAGE_BUFFER, 1, partial_sums_buffer_);
+
+    gl_canvas_->glUseProgram(difference_program);
+    gl_canvas_->glUniform1i(
+        gl_canvas_->glGetUniformLocation(difference_program, "sampler"), 0);
+    gl_canvas_->glUniform1i(gl_canvas_->glGetUniformLocation(
+                                difference_program, "reference_sampler"),
+                            1);
+    gl_canvas_->glUniform1i(
+        gl_canvas_->glGetUniformLocation(difference_program, "channels"),
+        channels);
+    gl_canvas_->glUniform1f(
+        gl_canvas_->glGetUniformLocation(difference_program, "threshold"),
+        threshold);
+    const GLint first_group_location =
+        gl_canvas_->glGetUniformLocation(difference_program, "first_group");
+
+    int first_group = 0;
+    for (size_t i = 0; i < textures.size(); ++i) {
+        const int groups_x =
+            (texture_widths[i] + work_group_texels - 1) / work_group_texels;
+        const int groups_y =
+            (texture_heights[i] + work_group_texels - 1) / work_group_texels;
+
+        gl_canvas_->glActiveTexture(GL_TEXTURE1);
+        gl_canvas_->glBindTexture(target, reference_textures[i]);
+        gl_canvas_->glActiveTexture(GL_TEXTURE0);
+        gl_canvas_->glBindTexture(target, textures[i]);
+
+        gl_canvas_->glUniform1i(first_group_location, first_group);
+        gl_canvas_->glDispatchCompute(groups_x, groups_y, 1);
+
+        first_group += groups_x * groups_y;
+    }
+
+    // The partial sums are reduced by a single work group
+    gl_canvas_->glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    gl_canvas_->glUseProgram(sum_program);
+    gl_canvas_->glUniform1i(
+        gl_canvas_->glGetUniformLocation(sum_program, "group_count"),
+        group_count);
+    gl_canvas_->glDispatchCompute(1, 1, 1);
+
+    gl_canvas_->glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    // Binding the partial sums buffer replaced the generic binding
+    gl_canvas_->glBindBuffer(GL_SHADER_STORAGE_BUFFER, errors_buffer_);
+
+    Errors errors;
+    const void* mapped_errors = gl_canvas_->glMapBufferRange(
+        GL_SHADER_STORAGE_BUFFER, 0, sizeof(errors), GL_MAP_READ_BIT);
+    if (mapped_errors == nullptr) {
+        gl_canvas_->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        return false;
+    }
+    memcpy(&errors, mapped_errors, sizeof(errors));
+    gl_canvas_->glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    gl_canvas_->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    for (int c = 0; c < channels; ++c) {
+        memcpy(&largest[c], &errors.largest[c], sizeof(float));
+        mean[c] = errors.error_sum[c] / static_cast<float>(texel_count);
+    }
+    mismatches = errors.mismatches;
+
+    return true;
+}
@@ -0,0 +1,82 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef GL_DIFFERENCE_REDUCER_H_
+#define GL_DIFFERENCE_REDUCER_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "ui/gl_canvas.h"
+#include "visualization/shader.h"
+
+
+/**
+ * Computes the errors between two buffers from their textures with compute
+ * shaders, so neither buffer is read back by the CPU.
+ *
+ * Requires OpenGL 4.3, like GLMinMaxReducer.
+ */
+class GLDifferenceReducer
+{
+  public:
+    GLDifferenceReducer(GLCanvas* gl_canvas);
+    ~GLDifferenceReducer();
+
+    bool initialize();
+
+    bool is_supported() const;
+
+    /**
+     * Largest and mean absolute differences per channel between the texels
+     * of each texture and the reference texture of the same size, as sampled
+     * by GLMinMaxReducer. Texels differing by more than the threshold in any
+     * channel are counted as mismatches.
+     *
+     * @return false if the reduction could not run
+     */
+    bool reduce(const std::vector<GLuint>& textures,
+                const std::vector<GLuint>& reference_textures,
+                ShaderProgram::TexelStorage texel_storage,
+                ShaderProgram::TexelLayout texel_layout,
+                int channels,
+                float threshold,
+                float* largest,
+                float* mean,
+                std::size_t& mismatches);
+
+  private:
+    bool is_supported_ = false;
+
+    GLuint errors_buffer_       = 0;
+    GLuint partial_sums_buffer_ = 0;
+
+    // Work groups the partial sums buffer can hold
+    int partial_sums_capacity_ = 0;
+
+    GLCanvas* gl_canvas_;
+};
+
+#endif // GL_DIFFERENCE_REDUCER_H_
@@ -0,0 +1,150 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "gl_frame_timer.h"
+
+#include <QOpenGLContext>
+
+// Timer queries are core since OpenGL 3.3, and only an extension on
+// OpenGL ES
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+
+
+namespace
+{
+
+// Weight of the last frame in the averaged times
+const double frame_time_smoothing = 0.1;
+
+
+double smooth(double average, double sample)
+{
+    return average + frame_time_smoothing * (sample - average);
+}
+
+} // namespace
+
+
+GLFrameTimer::GLFrameTimer(GLCanvas* gl_canvas)
+    : gl_canvas_(gl_canvas)
+{
+}
+
+
+GLFrameTimer::~GLFrameTimer()
+{
+    if (!is_supported_) {
+        return;
+    }
+
+    for (auto& query : queries_) {
+        gl_canvas_->glDeleteQueries(1, &query.id);
+    }
+}
+
+
+bool GLFrameTimer::initialize()
+{
+    QOpenGLContext* context = gl_canvas_->context();
+
+    is_supported_ =
+        context->isOpenGLES()
+            ? context->hasExtension("GL_EXT_disjoint_timer_query")
+            : (context->format().version() >= qMakePair(3, 3) ||
+               context->hasExtension("GL_ARB_timer_query"));
+
+    if (is_supported_) {
+        for (auto& query : queries_) {
+            gl_canvas_->glGenQueries(1, &query.id);
+        }
+    }
+
+    return true;
+}
+
+
+void GLFrameTimer::begin_frame()
+{
+    cpu_timer_.start();
+
+    if (!is_supported_) {
+        return;
+    }
+
+    collect_queries();
+
+    // Frames drawn while all queries are still in flight aren't timed on
+    // the GPU
+    Query& query = queries_[next_query_];
+    if (query.is_pending) {
+        return;
+    }
+
+    gl_canvas_->glBeginQuery(GL_TIME_ELAPSED, query.id);
+    is_query_active_ = true;
+}
+
+
+void GLFrameTimer::end_frame()
+{
+    cpu_frame_time_ =
+        smooth(cpu_frame_time_, cpu_timer_.nsecsElapsed() / 1e6);
+
+    if (!is_query_active_) {
+        return;
+    }
+
+    gl_canvas_->glEndQuery(GL_TIME_ELAPSED);
+    is_query_active_ = false;
+
+    queries_[next_query_].is_pending = true;
+    next_query_                      = (next_query_ + 1) % queries_.size();
+}
+
+
+void GLFrameTimer::collect_queries()
+{
+    // Queries complete in the order they were issued
+    for (std::size_t i = 0; i < queries_.size(); ++i) {
+        Query& query = queries_[(next_query_ + i) % queries_.size()];
+        if (!query.is_pending) {
+            continue;
+        }
+
+        GLuint is_available = GL_FALSE;
+        gl_canvas_->glGetQueryObjectuiv(
+            query.id, GL_QUERY_RESULT_AVAILABLE, &is_available);
+        if (is_available == GL_FALSE) {
+            break;
+        }
+
+        GLuint elapsed_ns = 0;
+        gl_canvas_->glGetQueryObjectuiv(query.id, GL_QUERY_RESULT, &elapsed_ns);
+        gpu_frame_time_  = smooth(gpu_frame_time_, elapsed_ns / 1e6);
+        query.is_pending = false;
+    }
+}
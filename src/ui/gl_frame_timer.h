@@ -0,0 +1,91 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef GL_FRAME_TIMER_H_
+#define GL_FRAME_TIMER_H_
+
+#include <array>
+
+#include <QElapsedTimer>
+
+#include "ui/gl_canvas.h"
+
+
+/**
+ * Measures the time spent drawing each frame, on the CPU and, where timer
+ * queries are supported, on the GPU. GPU times are read back a few frames
+ * later, once available, so measuring never stalls the pipeline.
+ */
+class GLFrameTimer
+{
+  public:
+    GLFrameTimer(GLCanvas* gl_canvas);
+    ~GLFrameTimer();
+
+    bool initialize();
+
+    void begin_frame();
+
+    void end_frame();
+
+    bool is_gpu_time_supported() const
+    {
+        return is_supported_;
+    }
+
+    // Exponential moving averages of the last frames, in milliseconds
+    double cpu_frame_time() const
+    {
+        return cpu_frame_time_;
+    }
+
+    double gpu_frame_time() const
+    {
+        return gpu_frame_time_;
+    }
+
+  private:
+    struct Query
+    {
+        GLuint id       = 0;
+        bool is_pending = false;
+    };
+
+    void collect_queries();
+
+    std::array<Query, 4> queries_;
+    std::size_t next_query_ = 0;
+    bool is_query_active_   = false;
+
+    bool is_supported_ = false;
+
+    QElapsedTimer cpu_timer_;
+    double cpu_frame_time_ = 0.0;
+    double gpu_frame_time_ = 0.0;
+
+    GLCanvas* gl_canvas_;
+};
+
+#endif // GL_FRAME_TIMER_H_
@@ -0,0 +1,205 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstring>
+#include <iostream>
+
+#include <QOpenGLContext>
+
+#include "gl_icon_readback.h"
+
+
+using namespace std;
+
+
+GLIconReadback::GLIconReadback(GLCanvas* gl_canvas)
+    : gl_canvas_(gl_canvas)
+{
+}
+
+
+GLIconReadback::~GLIconReadback()
+{
+    for (auto& readback : readbacks_) {
+        if (readback.fence != nullptr) {
+            gl_canvas_->glDeleteSync(readback.fence);
+        }
+        if (readback.pbo != 0) {
+            gl_canvas_->glDeleteBuffers(1, &readback.pbo);
+        }
+    }
+}
+
+
+bool GLIconReadback::initialize()
+{
+    QOpenGLContext* context       = gl_canvas_->context();
+    const QPair<int, int> version = context->format().version();
+
+    // Pixel buffer objects, glMapBufferRange and fences are core in 3.2
+    is_async_supported_ =
+        !context->isOpenGLES() &&
+        (version >= qMakePair(3, 2) ||
+         (context->hasExtension("GL_ARB_pixel_buffer_object") &&
+          context->hasExtension("GL_ARB_map_buffer_range") &&
+          context->hasExtension("GL_ARB_sync")));
+
+    if (!is_async_supported_) {
+        return true;
+    }
+
+    for (auto& readback : readbacks_) {
+        gl_canvas_->glGenBuffers(1, &readback.pbo);
+    }
+
+    return true;
+}
+
+
+bool GLIconReadback::has_free_slot() const
+{
+    if (!is_async_supported_) {
+        return true;
+    }
+
+    for (const auto& readback : readbacks_) {
+        if (readback.fence == nullptr) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+void GLIconReadback::read(const string& name, int width, int height)
+{
+    const size_t size = static_cast<size_t>(width) * height * 3;
+
+    gl_canvas_->glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    if (!is_async_supported_) {
+        finished_icons_.push_back(
+            Icon{name, width, height, vector<uint8_t>(size)});
+        gl_canvas_->glReadPixels(0,
+                                 0,
+                                 width,
+                                 height,
+                                 GL_RGB,
+                                 GL_UNSIGNED_BYTE,
+                                 finished_icons_.back().pixels.data());
+        return;
+    }
+
+    for (auto& readback : readbacks_) {
+        if (readback.fence != nullptr) {
+            continue;
+        }
+
+        gl_canvas_->glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+        if (readback.capacity < size) {
+            gl_canvas_->glBufferData(
+                GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+            readback.capacity = size;
+        }
+
+        // With a pack buffer bound, the pixels are written to it without
+        // waiting for the icon to be rendered
+        gl_canvas_->glReadPixels(
+            0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+        gl_canvas_->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        readback.fence =
+            gl_canvas_->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        readback.name   = name;
+        readback.width  = width;
+        readback.height = height;
+
+        return;
+    }
+}
+
+
+bool GLIconReadback::has_pending_reads() const
+{
+    if (!finished_icons_.empty()) {
+        return true;
+    }
+
+    for (const auto& readback : readbacks_) {
+        if (readback.fence != nullptr) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+void GLIconReadback::collect(vector<Icon>& finished_icons)
+{
+    while (!finished_icons_.empty()) {
+        finished_icons.push_back(move(finished_icons_.front()));
+        finished_icons_.pop_front();
+    }
+
+    for (auto& readback : readbacks_) {
+        if (readback.fence == nullptr) {
+            continue;
+        }
+
+        GLenum status = gl_canvas_->glClientWaitSync(readback.fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            continue;
+        }
+        gl_canvas_->glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+
+        const size_t size =
+            static_cast<size_t>(readback.width) * readback.height * 3;
+
+        gl_canvas_->glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+        const void* pixels = gl_canvas_->glMapBufferRange(
+            GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+
+        if (pixels != nullptr) {
+            Icon icon{readback.name,
+                      readback.width,
+                      readback.height,
+                      vector<uint8_t>(size)};
+            memcpy(icon.pixels.data(), pixels, size);
+            finished_icons.push_back(move(icon));
+
+            gl_canvas_->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        } else {
+            cerr << "[OpenImageDebugger] Could not map the icon readback "
+                    "buffer of "
+                 << readback.name << endl;
+        }
+
+        gl_canvas_->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        readback.name.clear();
+    }
+}
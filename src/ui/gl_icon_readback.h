@@ -0,0 +1,100 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef GL_ICON_READBACK_H_
+#define GL_ICON_READBACK_H_
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "ui/gl_canvas.h"
+
+
+/**
+ * Reads buffer icons back from the icon framebuffer without stalling the
+ * pipeline. Each read is issued into a pixel buffer object guarded by a
+ * fence, and its pixels are collected in a later frame, once the GPU is
+ * done with it.
+ *
+ * If the OpenGL context doesn't support pixel buffer objects and fences, the
+ * icons are read synchronously and are available at the next collection.
+ */
+class GLIconReadback
+{
+  public:
+    struct Icon
+    {
+        std::string name;
+        int width;
+        int height;
+        // Tightly packed RGB rows, bottom row first
+        std::vector<uint8_t> pixels;
+    };
+
+    GLIconReadback(GLCanvas* gl_canvas);
+    ~GLIconReadback();
+
+    bool initialize();
+
+    bool has_free_slot() const;
+
+    /**
+     * Starts reading the given area of the currently bound framebuffer. The
+     * caller must check that a slot is free beforehand.
+     */
+    void read(const std::string& name, int width, int height);
+
+    bool has_pending_reads() const;
+
+    /**
+     * Moves the icons whose reads have completed to finished_icons
+     */
+    void collect(std::vector<Icon>& finished_icons);
+
+  private:
+    struct Readback
+    {
+        GLuint pbo           = 0;
+        GLsync fence         = nullptr;
+        std::size_t capacity = 0;
+        std::string name;
+        int width  = 0;
+        int height = 0;
+    };
+
+    std::array<Readback, 4> readbacks_;
+
+    // Icons read synchronously, waiting to be collected
+    std::deque<Icon> finished_icons_;
+
+    bool is_async_supported_ = false;
+
+    GLCanvas* gl_canvas_;
+};
+
+#endif // GL_ICON_READBACK_H_
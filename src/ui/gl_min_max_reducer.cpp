@@ -0,0 +1,204 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstring>
+
+#include <QOpenGLContext>
+
+#include "gl_min_max_reducer.h"
+
+#include "ui/gl_program_cache.h"
+#include "visualization/shaders/oid_shaders.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+// Texels covered by each work group of the compute shader, on each axis
+const int work_group_texels = 16 * 4;
+
+
+float float_from_sortable(uint32_t value)
+{
+    uint32_t bits = (value & 0x80000000u) != 0 ? value & 0x7FFFFFFFu : ~value;
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+
+float int_from_sortable(uint32_t value)
+{
+    return static_cast<float>(static_cast<int32_t>(value ^ 0x80000000u));
+}
+
+
+float uint_from_sortable(uint32_t value)
+{
+    return static_cast<float>(value);
+}
+
+} // namespace
+
+
+GLMinMaxReducer::GLMinMaxReducer(GLCanvas* gl_canvas)
+    : gl_canvas_(gl_canvas)
+{
+}
+
+
+GLMinMaxReducer::~GLMinMaxReducer()
+{
+    if (bounds_buffer_ != 0) {
+        gl_canvas_->glDeleteBuffers(1, &bounds_buffer_);
+    }
+}
+
+
+bool GLMinMaxReducer::initialize()
+{
+    QOpenGLContext* context = gl_canvas_->context();
+
+    is_supported_ = !context->isOpenGLES() &&
+                    context->format().version() >= qMakePair(4, 3);
+
+    if (!is_supported_) {
+        return true;
+    }
+
+    gl_canvas_->glGenBuffers(1, &bounds_buffer_);
+    gl_canvas_->glBindBuffer(GL_SHADER_STORAGE_BUFFER, bounds_buffer_);
+    gl_canvas_->glBufferData(GL_SHADER_STORAGE_BUFFER,
+                             8 * sizeof(uint32_t),
+                             nullptr,
+                             GL_DYNAMIC_READ);
+    gl_canvas_->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    return true;
+}
+
+
+bool GLMinMaxReducer::is_supported() const
+{
+    return is_supported_;
+}
+
+
+bool GLMinMaxReducer::reduce(const vector<GLuint>& textures,
+                             ShaderProgram::TexelStorage texel_storage,
+                             ShaderProgram::TexelLayout texel_layout,
+                             int channels,
+                             float* lowest,
+                             float* upper)
+{
+    if (!is_supported_) {
+        return false;
+    }
+
+    const GLuint program = gl_canvas_->get_program_cache()->get_compute_program(
+        shader::min_max_comp_shader, texel_storage, texel_layout);
+    if (program == 0) {
+        return false;
+    }
+
+    // Bounds start empty: lowest at the highest value and vice versa
+    const uint32_t initial_bounds[8] = {0xFFFFFFFFu,
+                                        0xFFFFFFFFu,
+                                        0xFFFFFFFFu,
+                                        0xFFFFFFFFu,
+                                        0,
+                                        0,
+                                        0,
+                                        0};
+
+    gl_canvas_->glBindBuffer(GL_SHADER_STORAGE_BUFFER, bounds_buffer_);
+    gl_canvas_->glBufferSubData(
+        GL_SHADER_STORAGE_BUFFER, 0, sizeof(initial_bounds), initial_bounds);
+    gl_canvas_->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, bounds_buffer_);
+
+    gl_canvas_->glUseProgram(program);
+    gl_canvas_->glUniform1i(
+        gl_canvas_->glGetUniformLocation(program, "sampler"), 0);
+    gl_canvas_->glUniform1i(
+        gl_canvas_->glGetUniformLocation(program, "channels"), channels);
+
+    const GLenum target = texel_layout == ShaderProgram::LayoutPlanar
+                              ? GL_TEXTURE_2D_ARRAY
+                              : GL_TEXTURE_2D;
+
+    gl_canvas_->glActiveTexture(GL_TEXTURE0);
+    for (const GLuint texture : textures) {
+        GLint width;
+        GLint height;
+        gl_canvas_->glBindTexture(target, texture);
+        gl_canvas_->glGetTexLevelParameteriv(
+            target, 0, GL_TEXTURE_WIDTH, &width);
+        gl_canvas_->glGetTexLevelParameteriv(
+            target, 0, GL_TEXTURE_HEIGHT, &height);
+
+        gl_canvas_->glDispatchCompute(
+            (width + work_group_texels - 1) / work_group_texels,
+            (height + work_group_texels - 1) / work_group_texels,
+            1);
+    }
+
+    gl_canvas_->glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    uint32_t bounds[8];
+    const void* mapped_bounds = gl_canvas_->glMapBufferRange(
+        GL_SHADER_STORAGE_BUFFER, 0, sizeof(bounds), GL_MAP_READ_BIT);
+    if (mapped_bounds == nullptr) {
+        gl_canvas_->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        return false;
+    }
+    memcpy(bounds, mapped_bounds, sizeof(bounds));
+    gl_canvas_->glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    gl_canvas_->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    for (int c = 0; c < channels; ++c) {
+        // Channels without a single finite value
+        if (bounds[c] > bounds[4 + c]) {
+            lowest[c] = upper[c] = 0.0f;
+            continue;
+        }
+
+        if (texel_storage == ShaderProgram::StorageInteger) {
+            lowest[c] = int_from_sortable(bounds[c]);
+            upper[c]  = int_from_sortable(bounds[4 + c]);
+        } else if (texel_storage == ShaderProgram::StorageUnsignedInteger) {
+            lowest[c] = uint_from_sortable(bounds[c]);
+            upper[c]  = uint_from_sortable(bounds[4 + c]);
+        } else {
+            lowest[c] = float_from_sortable(bounds[c]);
+            upper[c]  = float_from_sortable(bounds[4 + c]);
+        }
+    }
+
+    return true;
+}
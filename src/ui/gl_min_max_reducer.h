@@ -0,0 +1,75 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef GL_MIN_MAX_REDUCER_H_
+#define GL_MIN_MAX_REDUCER_H_
+
+#include <vector>
+
+#include "ui/gl_canvas.h"
+#include "visualization/shader.h"
+
+
+/**
+ * Computes the per channel bounds of buffers from their textures with a
+ * compute shader, so the buffer contents are not read again by the CPU.
+ *
+ * Requires OpenGL 4.3; callers must fall back to compute_min_max otherwise.
+ */
+class GLMinMaxReducer
+{
+  public:
+    GLMinMaxReducer(GLCanvas* gl_canvas);
+    ~GLMinMaxReducer();
+
+    bool initialize();
+
+    bool is_supported() const;
+
+    /**
+     * Lowest and highest channel values over all the given textures, as
+     * sampled by the shaders: in [0, 1] (or [-1, 1] for signed types) for
+     * normalized textures, and unchanged for integer ones. Channels without
+     * finite values get 0 as both bounds. Planar textures are arrays with
+     * a layer per channel.
+     *
+     * @return false if the reduction could not run
+     */
+    bool reduce(const std::vector<GLuint>& textures,
+                ShaderProgram::TexelStorage texel_storage,
+                ShaderProgram::TexelLayout texel_layout,
+                int channels,
+                float* lowest,
+                float* upper);
+
+  private:
+    bool is_supported_ = false;
+
+    GLuint bounds_buffer_ = 0;
+
+    GLCanvas* gl_canvas_;
+};
+
+#endif // GL_MIN_MAX_REDUCER_H_
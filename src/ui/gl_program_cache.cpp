@@ -0,0 +1,414 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QOpenGLContext>
+#include <QSettings>
+
+#include "gl_program_cache.h"
+
+#include "ipc/content_hash.h"
+
+
+using namespace std;
+
+
+GLProgramCache::GLProgramCache(GLCanvas* gl_canvas)
+    : gl_canvas_(gl_canvas)
+{
+}
+
+
+GLProgramCache::~GLProgramCache()
+{
+    for (const auto& program : programs_) {
+        gl_canvas_->glDeleteProgram(program.second);
+    }
+}
+
+
+bool GLProgramCache::initialize()
+{
+    QOpenGLContext* context       = gl_canvas_->context();
+    const QPair<int, int> version = context->format().version();
+
+    GLint num_binary_formats = 0;
+    if (!context->isOpenGLES() &&
+        (version >= qMakePair(4, 1) ||
+         context->hasExtension("GL_ARB_get_program_binary"))) {
+        gl_canvas_->glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS,
+                                  &num_binary_formats);
+    }
+    are_binaries_supported_ = num_binary_formats > 0;
+
+    if (!are_binaries_supported_) {
+        return true;
+    }
+
+    const auto gl_string = [this](GLenum name) {
+        const GLubyte* value = gl_canvas_->glGetString(name);
+        return value != nullptr ? string(reinterpret_cast<const char*>(value))
+                                : string();
+    };
+    driver_id_ = gl_string(GL_VENDOR) + "\n" + gl_string(GL_RENDERER) + "\n" +
+                 gl_string(GL_VERSION);
+
+    // Binaries are stored in the same directory as the settings file
+    QSettings settings(QSettings::Format::IniFormat,
+                       QSettings::Scope::UserScope,
+                       "OpenImageDebugger");
+    binaries_directory_ =
+        QFileInfo(settings.fileName()).absolutePath() + "/program_cache";
+
+    if (!QDir().mkpath(binaries_directory_)) {
+        are_binaries_supported_ = false;
+    }
+
+    return true;
+}
+
+
+GLuint GLProgramCache::get_program(const char* v_source,
+                                   const char* f_source,
+                                   ShaderProgram::TexelChannels texel_format,
+                                   const char* pixel_layout,
+                                   ShaderProgram::TexelStorage texel_storage,
+                                   ShaderProgram::TexelLayout texel_layout)
+{
+    string key = to_string(texel_storage) + "|" + to_string(texel_layout) +
+                 "|" + to_string(texel_format) + "|" +
+                 string(pixel_layout, 4) + "|" + v_source + '\0' + f_source;
+
+    return find_or_build_program(key, [&]() {
+        return build_program(v_source,
+                             f_source,
+                             texel_format,
+                             pixel_layout,
+                             texel_storage,
+                             texel_layout);
+    });
+}
+
+
+GLuint GLProgramCache::get_compute_program(
+    const char* c_source,
+    ShaderProgram::TexelStorage texel_storage,
+    ShaderProgram::TexelLayout texel_layout)
+{
+    string key = "compute|" + to_string(texel_storage) + "|" +
+                 to_string(texel_layout) + "|" + c_source;
+
+    return find_or_build_program(key, [&]() -> GLuint {
+        const char* src[] = {
+            "#version 430\n",
+            texel_storage == ShaderProgram::StorageInteger
+                ? "#define INTEGER_TEXELS\n"
+                : texel_storage == ShaderProgram::StorageUnsignedInteger
+                      ? "#define INTEGER_TEXELS\n"
+                        "#define UNSIGNED_TEXELS\n"
+                      : "",
+            texel_layout == ShaderProgram::LayoutPlanar
+                ? "#define PLANAR_TEXELS\n"
+                : "",
+            c_source};
+
+        GLuint compute_shader = compile_sources(GL_COMPUTE_SHADER, src, 4);
+        if (compute_shader == 0) {
+            return 0;
+        }
+
+        return link_program({compute_shader});
+    });
+}
+
+
+GLuint GLProgramCache::find_or_build_program(
+    const std::string& key,
+    const std::function<GLuint()>& build)
+{
+    auto program = programs_.find(key);
+    if (program != programs_.end()) {
+        return program->second;
+    }
+
+    GLuint program_id = 0;
+
+    QString path;
+    if (are_binaries_supported_) {
+        path       = binary_path(key);
+        program_id = load_program_binary(path);
+    }
+
+    if (program_id == 0) {
+        program_id = build();
+
+        if (program_id == 0) {
+            return 0;
+        }
+
+        if (are_binaries_supported_) {
+            save_program_binary(program_id, path);
+        }
+    }
+
+    programs_[key] = program_id;
+
+    return program_id;
+}
+
+
+GLuint GLProgramCache::build_program(const char* v_source,
+                                     const char* f_source,
+                                     ShaderProgram::TexelChannels texel_format,
+                                     const char* pixel_layout,
+                                     ShaderProgram::TexelStorage texel_storage,
+                                     ShaderProgram::TexelLayout texel_layout)
+{
+    GLuint vertex_shader   = compile(GL_VERTEX_SHADER,
+                                     v_source,
+                                     texel_format,
+                                     pixel_layout,
+                                     texel_storage,
+                                     texel_layout);
+    GLuint fragment_shader = compile(GL_FRAGMENT_SHADER,
+                                     f_source,
+                                     texel_format,
+                                     pixel_layout,
+                                     texel_storage,
+                                     texel_layout);
+
+    if (vertex_shader == 0 || fragment_shader == 0) {
+        gl_canvas_->glDeleteShader(vertex_shader);
+        gl_canvas_->glDeleteShader(fragment_shader);
+        return 0;
+    }
+
+    return link_program({vertex_shader, fragment_shader});
+}
+
+
+GLuint GLProgramCache::link_program(std::initializer_list<GLuint> shaders)
+{
+    GLuint program = gl_canvas_->glCreateProgram();
+    for (const GLuint shader : shaders) {
+        gl_canvas_->glAttachShader(program, shader);
+    }
+    if (are_binaries_supported_) {
+        gl_canvas_->glProgramParameteri(
+            program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    gl_canvas_->glLinkProgram(program);
+
+    // Delete shaders. We don't need them anymore.
+    for (const GLuint shader : shaders) {
+        gl_canvas_->glDeleteShader(shader);
+    }
+
+    GLint linked;
+    gl_canvas_->glGetProgramiv(program, GL_LINK_STATUS, &linked);
+
+    if (!linked) {
+        GLint length;
+        gl_canvas_->glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+        std::string log(length, ' ');
+        gl_canvas_->glGetProgramInfoLog(program, length, &length, &log[0]);
+        std::cerr << "Failed to link shader program" << std::endl
+                  << log << std::endl;
+        gl_canvas_->glDeleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
+
+
+GLuint GLProgramCache::compile(GLuint type,
+                               const char* source,
+                               ShaderProgram::TexelChannels texel_format,
+                               const char* pixel_layout,
+                               ShaderProgram::TexelStorage texel_storage,
+                               ShaderProgram::TexelLayout texel_layout)
+{
+    // Integer and array textures can only be sampled from GLSL 1.30 onwards
+    const bool requires_glsl_130 =
+        texel_storage != ShaderProgram::StorageNormalized ||
+        texel_layout == ShaderProgram::LayoutPlanar;
+
+    const char* src[] = {
+        // clang-format off
+        requires_glsl_130 ? "#version 130\n" : "#version 120\n",
+
+        texel_storage == ShaderProgram::StorageInteger ?
+            "#define INTEGER_TEXELS\n" :
+        texel_storage == ShaderProgram::StorageUnsignedInteger ?
+            "#define INTEGER_TEXELS\n"
+            "#define UNSIGNED_TEXELS\n" :
+            "",
+
+        texel_layout == ShaderProgram::LayoutPlanar ?
+            "#define PLANAR_TEXELS\n" :
+            "",
+
+        texel_format == ShaderProgram::FormatR ?   "#define FORMAT_R\n" :
+        texel_format == ShaderProgram::FormatRG ?  "#define FORMAT_RG\n" :
+        texel_format == ShaderProgram::FormatRGB ? "#define FORMAT_RGB\n" :
+                                                   "",
+        // clang-format on
+
+        "#define PIXEL_LAYOUT ",
+        pixel_layout,
+
+        source};
+
+    return compile_sources(type, src, 7);
+}
+
+
+GLuint GLProgramCache::compile_sources(GLuint type,
+                                       const char* const* sources,
+                                       int count)
+{
+    GLuint shader = gl_canvas_->glCreateShader(type);
+
+    gl_canvas_->glShaderSource(shader, count, sources, NULL);
+    gl_canvas_->glCompileShader(shader);
+
+    GLint compiled;
+    gl_canvas_->glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+
+    if (!compiled) {
+        GLint length;
+        gl_canvas_->glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+        std::string log(length, ' ');
+        gl_canvas_->glGetShaderInfoLog(shader, length, &length, &log[0]);
+        std::cerr << "Failed to compile shadertype: " + get_shader_type(type)
+                  << std::endl
+                  << log << std::endl;
+        gl_canvas_->glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+
+std::string GLProgramCache::get_shader_type(GLuint type)
+{
+    std::string name;
+    switch (type) {
+    case GL_VERTEX_SHADER:
+        name = "Vertex Shader";
+        break;
+    case GL_FRAGMENT_SHADER:
+        name = "Fragment Shader";
+        break;
+    case GL_COMPUTE_SHADER:
+        name = "Compute Shader";
+        break;
+    default:
+        name = "Unknown Shader type";
+        break;
+    }
+    return name;
+}
+
+
+GLuint GLProgramCache::load_program_binary(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+
+    // File layout: binary format, followed by the program binary
+    const QByteArray contents = file.readAll();
+    GLenum format;
+    if (static_cast<size_t>(contents.size()) <= sizeof(format)) {
+        return 0;
+    }
+    memcpy(&format, contents.constData(), sizeof(format));
+
+    GLuint program = gl_canvas_->glCreateProgram();
+    gl_canvas_->glProgramBinary(program,
+                                format,
+                                contents.constData() + sizeof(format),
+                                contents.size() - sizeof(format));
+
+    // Binaries are rejected after driver updates, in which case the program
+    // is built from its sources again
+    GLint linked;
+    gl_canvas_->glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        gl_canvas_->glDeleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
+
+
+void GLProgramCache::save_program_binary(GLuint program, const QString& path)
+{
+    GLint length = 0;
+    gl_canvas_->glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    GLenum format;
+    vector<char> binary(sizeof(format) + static_cast<size_t>(length));
+    gl_canvas_->glGetProgramBinary(
+        program, length, &length, &format, binary.data() + sizeof(format));
+    memcpy(binary.data(), &format, sizeof(format));
+
+    // Write to a temporary file first, so concurrent windows never load a
+    // partially written binary
+    const QString temporary_path = path + ".tmp";
+    QFile file(temporary_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    file.write(binary.data(), sizeof(format) + static_cast<size_t>(length));
+    file.close();
+
+    QFile::remove(path);
+    QFile::rename(temporary_path, path);
+}
+
+
+QString GLProgramCache::binary_path(const std::string& key) const
+{
+    const uint64_t driver_hash =
+        content_hash(driver_id_.data(), driver_id_.size());
+    const uint64_t hash = content_hash(key.data(), key.size(), driver_hash);
+
+    return binaries_directory_ + "/" +
+           QString::number(static_cast<qulonglong>(hash), 16) + ".bin";
+}
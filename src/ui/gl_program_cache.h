@@ -0,0 +1,117 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef GL_PROGRAM_CACHE_H_
+#define GL_PROGRAM_CACHE_H_
+
+#include <functional>
+#include <initializer_list>
+#include <map>
+#include <string>
+
+#include <QString>
+
+#include "ui/gl_canvas.h"
+#include "visualization/shader.h"
+
+
+/**
+ * Linked shader programs shared by all the stages drawn in a GLCanvas.
+ *
+ * Programs are identified by their sources and the preprocessor definitions
+ * that ShaderProgram prepends to them. When the driver supports program
+ * binaries, they are also kept on disk next to the user settings, so programs
+ * are not compiled again when the window is reopened.
+ */
+class GLProgramCache
+{
+  public:
+    GLProgramCache(GLCanvas* gl_canvas);
+    ~GLProgramCache();
+
+    bool initialize();
+
+    /**
+     * Returns the program built from the given sources and definitions,
+     * compiling it if necessary. The program stays owned by the cache.
+     * Returns 0 if the program could not be built.
+     */
+    GLuint get_program(const char* v_source,
+                       const char* f_source,
+                       ShaderProgram::TexelChannels texel_format,
+                       const char* pixel_layout,
+                       ShaderProgram::TexelStorage texel_storage,
+                       ShaderProgram::TexelLayout texel_layout);
+
+    /**
+     * Same as get_program, for a compute program. Requires OpenGL 4.3.
+     */
+    GLuint get_compute_program(const char* c_source,
+                               ShaderProgram::TexelStorage texel_storage,
+                               ShaderProgram::TexelLayout texel_layout);
+
+  private:
+    GLuint find_or_build_program(const std::string& key,
+                                 const std::function<GLuint()>& build);
+
+    GLuint build_program(const char* v_source,
+                         const char* f_source,
+                         ShaderProgram::TexelChannels texel_format,
+                         const char* pixel_layout,
+                         ShaderProgram::TexelStorage texel_storage,
+                         ShaderProgram::TexelLayout texel_layout);
+
+    GLuint compile(GLuint type,
+                   const char* source,
+                   ShaderProgram::TexelChannels texel_format,
+                   const char* pixel_layout,
+                   ShaderProgram::TexelStorage texel_storage,
+                   ShaderProgram::TexelLayout texel_layout);
+
+    GLuint compile_sources(GLuint type, const char* const* sources, int count);
+
+    GLuint link_program(std::initializer_list<GLuint> shaders);
+
+    std::string get_shader_type(GLuint type);
+
+    GLuint load_program_binary(const QString& path);
+
+    void save_program_binary(GLuint program, const QString& path);
+
+    QString binary_path(const std::string& key) const;
+
+    std::map<std::string, GLuint> programs_;
+
+    bool are_binaries_supported_ = false;
+
+    // Identifies the driver, whose binaries can't be loaded by other drivers
+    std::string driver_id_;
+
+    QString binaries_directory_;
+
+    GLCanvas* gl_canvas_;
+};
+
+#endif // GL_PROGRAM_CACHE_H_
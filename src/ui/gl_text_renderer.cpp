@@ -23,17 +23,137 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <QImage>
+#include <QOpenGLContext>
 #include <QPainter>
-#include <QPixmap>
 
 #include "gl_text_renderer.h"
+#include "system/trace/tracer.h"
 #include "visualization/shaders/oid_shaders.h"
 
 
+namespace
+{
+
+// Squared distance of the pixels that are not seeds. Kept finite, since the
+// parabolas of two such pixels are intersected.
+const double unreached_distance = 1e20;
+
+
+/**
+ * Squared euclidean distance transform of the n values of 'values', spaced by
+ * 'stride', as the lower envelope of the parabolas rooted at each of them
+ * (Felzenszwalb and Huttenlocher). The work vectors are reused between calls.
+ */
+void squared_distance_transform(double* values,
+                                int n,
+                                int stride,
+                                std::vector<double>& roots,
+                                std::vector<int>& envelope,
+                                std::vector<double>& bounds)
+{
+    roots.resize(n);
+    envelope.resize(n);
+    bounds.resize(n + 1);
+
+    for (int i = 0; i < n; ++i) {
+        roots[i] = values[i * stride];
+    }
+
+    int k       = 0;
+    envelope[0] = 0;
+    bounds[0]   = -std::numeric_limits<double>::infinity();
+    bounds[1]   = std::numeric_limits<double>::infinity();
+
+    for (int q = 1; q < n; ++q) {
+        double s;
+        for (;;) {
+            const int r = envelope[k];
+            s           = ((roots[q] + q * q) - (roots[r] + r * r)) /
+                (2.0 * (q - r));
+            if (s > bounds[k]) {
+                break;
+            }
+            --k;
+        }
+
+        ++k;
+        envelope[k]   = q;
+        bounds[k]     = s;
+        bounds[k + 1] = std::numeric_limits<double>::infinity();
+    }
+
+    k = 0;
+    for (int q = 0; q < n; ++q) {
+        while (bounds[k + 1] < q) {
+            ++k;
+        }
+        const int r        = envelope[k];
+        values[q * stride] = (q - r) * (q - r) + roots[r];
+    }
+}
+
+
+/**
+ * Squared distance of every pixel of a width x height grid to the nearest
+ * pixel for which is_seed is true
+ */
+template <typename IsSeed>
+std::vector<double>
+squared_distance_field(int width, int height, IsSeed is_seed)
+{
+    std::vector<double> field(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            field[static_cast<size_t>(y) * width + x] =
+                is_seed(x, y) ? 0.0 : unreached_distance;
+        }
+    }
+
+    std::vector<double> roots;
+    std::vector<int> envelope;
+    std::vector<double> bounds;
+
+    for (int x = 0; x < width; ++x) {
+        squared_distance_transform(
+            &field[x], height, width, roots, envelope, bounds);
+    }
+    for (int y = 0; y < height; ++y) {
+        squared_distance_transform(&field[static_cast<size_t>(y) * width],
+                                   width,
+                                   1,
+                                   roots,
+                                   envelope,
+                                   bounds);
+    }
+
+    return field;
+}
+
+
+int next_power_of_two(int value)
+{
+    int power = 1;
+    while (power < value) {
+        power *= 2;
+    }
+    return power;
+}
+
+} // namespace
+
+
 GLTextRenderer::GLTextRenderer(GLCanvas* gl_canvas)
     : font("Times New Roman", font_size)
+    , text_tex(0)
     , text_prog(gl_canvas)
     , gl_canvas_(gl_canvas)
+    , is_glyph_atlas_ready_(false)
 {
 }
 
@@ -51,167 +171,166 @@ bool GLTextRenderer::initialize()
                      shader::text_frag_shader,
                      ShaderProgram::FormatR,
                      "rgba",
-                     {"mvp",
-                      "buff_sampler",
-                      "text_sampler",
-                      "pix_coord",
-                      "brightness_contrast"});
+                     {"mvp", "text_sampler", "brightness_contrast"});
 
-    gl_canvas_->glGenTextures(1, &text_tex);
-    gl_canvas_->glActiveTexture(GL_TEXTURE0);
-    gl_canvas_->glBindTexture(GL_TEXTURE_2D, text_tex);
     gl_canvas_->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    gl_canvas_->glGenBuffers(1, &text_vbo);
-    generate_glyphs_texture();
+    // clang-format off
+    static const GLfloat quad_corners[] = {
+        0.0f, 0.0f,
+        1.0f, 0.0f,
+        0.0f, 1.0f,
+        1.0f, 1.0f,
+    };
+    // clang-format on
 
+    gl_canvas_->glGenBuffers(1, &text_vbo);
+    gl_canvas_->glBindBuffer(GL_ARRAY_BUFFER, text_vbo);
+    gl_canvas_->glBufferData(
+        GL_ARRAY_BUFFER, sizeof(quad_corners), quad_corners, GL_STATIC_DRAW);
+
+    // Instanced arrays are core since OpenGL 3.3 and OpenGL ES 3.0
+    QOpenGLContext* context       = gl_canvas_->context();
+    const QPair<int, int> version = context->format().version();
+    is_instancing_supported =
+        version >= (context->isOpenGLES() ? qMakePair(3, 0)
+                                          : qMakePair(3, 3));
+
+    // The glyph atlas is only needed once a buffer is zoomed enough for its
+    // values to be labeled
     return true;
 }
 
 
-void GLTextRenderer::generate_glyphs_texture()
+void GLTextRenderer::prepare_glyph_atlas()
+{
+    if (!is_glyph_atlas_ready_) {
+        generate_glyph_atlas();
+        is_glyph_atlas_ready_ = true;
+    }
+}
+
+
+void GLTextRenderer::generate_glyph_atlas()
 {
+    TraceSpan span("glyph atlas");
+
     // Required characters for numbers, scientific notation (e), nan, inf
     const char text[] = "0123456789., -+enaif";
     const unsigned char* p;
-    const int border_size = 0;
 
-    QFontMetrics g(font);
+    const int k = glyph_atlas_downsampling;
 
-    gl_canvas_->glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, text_tex);
+    QFontMetrics g(font);
 
-    // Generate text bitmap
-    QSize texture_size(g.size(Qt::TextSingleLine, text));
+    // Ink box of the characters, relative to their baseline. Each glyph is
+    // drawn in a cell of its own, separated from its neighbours by the
+    // padding over which distances are stored.
+    const QRect ink       = g.tightBoundingRect(text);
+    const int ink_height  = ink.height();
+    const int cell_height = ink_height + 2 * glyph_padding;
+    int used_width        = 0;
+    for (p = reinterpret_cast<const unsigned char*>(text); *p; p++) {
+        used_width += g.width(*p) + 2 * glyph_padding;
+    }
 
-    text_texture_width = text_texture_height = 1.0f;
-    while (text_texture_width < texture_size.width())
-        text_texture_width *= 2.f;
-    while (text_texture_height < texture_size.height())
-        text_texture_height *= 2.f;
+    const int atlas_width  = next_power_of_two((used_width + k - 1) / k);
+    const int atlas_height = next_power_of_two((cell_height + k - 1) / k);
+    text_texture_width     = static_cast<float>(atlas_width * k);
+    text_texture_height    = static_cast<float>(atlas_height * k);
 
-    const int mipmap_levels = 5;
+    // The glyphs are rasterized at the font size, and then reduced to their
+    // distance field at a k times lower resolution
+    const int raster_width  = (used_width + k - 1) / k * k;
+    const int raster_height = (cell_height + k - 1) / k * k;
 
+    QImage raster(raster_width, raster_height, QImage::Format_RGB32);
+    raster.fill(QColor(0, 0, 0));
     {
-        int tex_level_width = text_texture_width;
-        int tex_level_height = text_texture_height;
-
-        for (int i = 0; i < mipmap_levels; ++i) {
-            gl_canvas_->glTexImage2D(GL_TEXTURE_2D,
-                                     i,
-                                     GL_R8,
-                                     tex_level_width,
-                                     tex_level_height,
-                                     0,
-                                     GL_RED,
-                                     GL_UNSIGNED_BYTE,
-                                     nullptr);
-
-            tex_level_width = std::max(1, tex_level_width / 2);
-            tex_level_height = std::max(1, tex_level_height / 2);
+        QPainter painter(&raster);
+        painter.setPen(QColor(255, 255, 255));
+        painter.setFont(font);
+
+        int x = 0;
+        for (p = reinterpret_cast<const unsigned char*>(text); *p; p++) {
+            const int advance_x = g.width(*p);
+
+            painter.drawText(x + glyph_padding,
+                             glyph_padding - ink.top(),
+                             QString(QChar(*p)));
+
+            text_texture_advances[*p][0] = advance_x;
+            text_texture_advances[*p][1] = 0;
+            text_texture_sizes[*p][0]    = advance_x;
+            text_texture_sizes[*p][1]    = ink_height;
+            text_texture_tls[*p][0]      = 0;
+            text_texture_tls[*p][1]      = ink_height;
+            text_texture_offsets[*p][0]  = x + glyph_padding;
+            text_texture_offsets[*p][1]  = glyph_padding;
+
+            x += advance_x + 2 * glyph_padding;
         }
     }
-
-    QPixmap pixmap(texture_size);
-    pixmap.fill(QColor(0, 0, 0));
-    QPainter painter(&pixmap);
-    painter.setPen(QColor(255, 255, 255));
-    painter.setFont(font);
-    painter.drawText(0, g.ascent(), text);
-    QImage img = pixmap.toImage().convertToFormat(QImage::Format_Grayscale8);
-
-    std::vector<uint8_t> packed_texture(text_texture_width *
-                                        text_texture_height);
-    uint8_t* packed_texture_ptr = packed_texture.data();
-
-    int real_ascent  = texture_size.height() - 1;
-    int real_descent = 0;
-
-    bool found_real_descent = false;
-    bool found_real_ascent  = false;
-    // Pack bitmap and compute real ascent and descent lines
-    for (int y = 0; y < texture_size.height(); ++y) {
-        uint8_t* imgptr = img.scanLine(y);
-        int x;
-
-        bool found_filled_pixel = false;
-        for (x = 0; x < texture_size.width(); ++x) {
-            packed_texture_ptr[x] = imgptr[x];
-
-            found_filled_pixel = found_filled_pixel || imgptr[x] > 0;
-        }
-
-        // If the row was completely empty...
-        if (!found_filled_pixel) {
-            if (!found_real_descent) {
-                real_descent = y;
-            } else if (!found_real_ascent) {
-                real_ascent       = y;
-                found_real_ascent = true;
+    raster = raster.convertToFormat(QImage::Format_Grayscale8);
+
+    const auto is_inside = [&raster](int x, int y) {
+        return raster.constScanLine(y)[x] >= 128;
+    };
+    const std::vector<double> outer_field = squared_distance_field(
+        raster_width, raster_height, is_inside);
+    const std::vector<double> inner_field =
+        squared_distance_field(raster_width,
+                               raster_height,
+                               [&is_inside](int x, int y) {
+                                   return !is_inside(x, y);
+                               });
+
+    // Each texel holds the mean distance of its k x k raster pixels to the
+    // outline, mapped from [-glyph_padding, glyph_padding] to [1, 0]. The
+    // texels outside of the rasterized cells are far from any glyph.
+    std::vector<uint8_t> atlas(static_cast<size_t>(atlas_width) *
+                               atlas_height);
+    for (int ty = 0; ty < raster_height / k; ++ty) {
+        for (int tx = 0; tx < raster_width / k; ++tx) {
+            double distance = 0.0;
+            for (int y = ty * k; y < (ty + 1) * k; ++y) {
+                for (int x = tx * k; x < (tx + 1) * k; ++x) {
+                    const size_t i =
+                        static_cast<size_t>(y) * raster_width + x;
+                    distance += std::sqrt(outer_field[i]) -
+                                std::sqrt(inner_field[i]);
+                }
             }
-        } else {
-            found_real_descent = true;
-        }
+            distance /= k * k;
 
-        for (; x < text_texture_width; ++x) {
-            packed_texture_ptr[x] = 0;
+            const double level =
+                0.5 - 0.5 * distance / static_cast<double>(glyph_padding);
+            atlas[static_cast<size_t>(ty) * atlas_width + tx] =
+                static_cast<uint8_t>(
+                    std::round(255.0 * std::min(std::max(level, 0.0), 1.0)));
         }
-        packed_texture_ptr += static_cast<int>(text_texture_width);
-    }
-
-
-    // Compute text box size
-    float box_w = 0;
-    float box_h = 0;
-
-    const int cropped_bitmap_height = real_ascent - real_descent;
-
-    for (p = reinterpret_cast<const unsigned char*>(text); *p; p++) {
-        int advance_x     = g.width(*p);
-        int bitmap_height = g.height();
-
-        text_texture_advances[*p][0] = advance_x;
-        text_texture_advances[*p][1] = 0;
-        text_texture_sizes[*p][0]    = advance_x;
-        text_texture_sizes[*p][1]    = cropped_bitmap_height;
-        text_texture_tls[*p][0]      = 0;
-        text_texture_tls[*p][1]      = cropped_bitmap_height;
-
-        box_w += advance_x + 2 * border_size;
-        box_h = std::max(box_h, (float)bitmap_height + 2 * border_size);
-    }
-
-    // Clears generated buffer
-    {
-        gl_canvas_->glTexSubImage2D(GL_TEXTURE_2D,
-                                    0,
-                                    0,
-                                    0,
-                                    text_texture_width,
-                                    text_texture_height,
-                                    GL_RED,
-                                    GL_UNSIGNED_BYTE,
-                                    packed_texture.data());
     }
 
-    int x = 0;
-    for (p = reinterpret_cast<const unsigned char*>(text); *p; p++) {
-        int advance_x = g.width(*p);
-
-        text_texture_offsets[*p][0] = x + border_size;
-        text_texture_offsets[*p][1] = real_descent + border_size;
-
-        x += advance_x + border_size * 2;
-    }
-
-    gl_canvas_->glGenerateMipmap(GL_TEXTURE_2D);
+    gl_canvas_->glGenTextures(1, &text_tex);
+    gl_canvas_->glActiveTexture(GL_TEXTURE0);
+    gl_canvas_->glBindTexture(GL_TEXTURE_2D, text_tex);
+    gl_canvas_->glTexImage2D(GL_TEXTURE_2D,
+                             0,
+                             GL_R8,
+                             atlas_width,
+                             atlas_height,
+                             0,
+                             GL_RED,
+                             GL_UNSIGNED_BYTE,
+                             atlas.data());
+
+    // Distances are interpolated linearly at every zoom level, so no mipmaps
+    // are required
     gl_canvas_->glTexParameteri(
         GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     gl_canvas_->glTexParameteri(
-        GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    gl_canvas_->glTexParameteri(
-        GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     gl_canvas_->glTexParameteri(
-        GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     gl_canvas_->glTexParameteri(
-        GL_TEXTURE_2D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_BORDER);
+        GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 }
@@ -36,10 +36,24 @@ class GLTextRenderer
   public:
     static constexpr float font_size = 96.0f;
 
+    // Margin around each glyph in the atlas, in font pixels, over which the
+    // distance to its outline is stored. Glyph quads are enlarged by it.
+    static constexpr int glyph_padding = 16;
+
+    // Font pixels per texel of the glyph atlas
+    static constexpr int glyph_atlas_downsampling = 4;
+
     QFont font;
+    // Corners of the quad instanced for each glyph
     GLuint text_vbo;
+    // Signed distance field of the glyphs, created by prepare_glyph_atlas()
     GLuint text_tex;
 
+    // Whether glyphs can be drawn as instances of a single quad
+    bool is_instancing_supported;
+
+    // Glyph metrics, in font pixels. They are only valid once the glyph atlas
+    // has been prepared.
     int text_texture_offsets[256][2];
     int text_texture_advances[256][2];
     int text_texture_sizes[256][2];
@@ -50,15 +64,24 @@ class GLTextRenderer
 
     bool initialize();
 
-    void generate_glyphs_texture();
+    /**
+     * Generates the glyph atlas on its first call. Since it stores distances
+     * instead of coverage, the same atlas is valid at every zoom level.
+     */
+    void prepare_glyph_atlas();
 
     ShaderProgram text_prog;
 
+    // Size of the glyph atlas, in font pixels
     float text_texture_width;
     float text_texture_height;
 
   private:
     GLCanvas* gl_canvas_;
+
+    bool is_glyph_atlas_ready_;
+
+    void generate_glyph_atlas();
 };
 
 #endif // GL_TEXT_RENDERER_H_
@@ -0,0 +1,648 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QThread>
+
+#include "gl_texture_streamer.h"
+
+#include "system/trace/tracer.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+using PFNBUFFERSTORAGE = void(QOPENGLF_APIENTRYP)(GLenum target,
+                                                  GLsizeiptr size,
+                                                  const void* data,
+                                                  GLbitfield flags);
+
+
+GLenum texture_target(const GLTextureStreamer::TextureUpload& upload)
+{
+    return upload.layer < 0 ? GL_TEXTURE_2D : GL_TEXTURE_2D_ARRAY;
+}
+
+
+/**
+ * Uploads the given rows of the region, from the bound unpack buffer if
+ * pixels is an offset in it
+ */
+void upload_region_rows(QOpenGLExtraFunctions* gl,
+                        const GLTextureStreamer::TextureUpload& upload,
+                        int rows,
+                        const void* pixels)
+{
+    if (upload.layer < 0) {
+        gl->glTexSubImage2D(GL_TEXTURE_2D,
+                            0,
+                            upload.x,
+                            upload.y,
+                            upload.width,
+                            rows,
+                            upload.format,
+                            upload.type,
+                            pixels);
+    } else {
+        gl->glTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+                            0,
+                            upload.x,
+                            upload.y,
+                            upload.layer,
+                            upload.width,
+                            rows,
+                            1,
+                            upload.format,
+                            upload.type,
+                            pixels);
+    }
+}
+
+} // namespace
+
+
+class GLTextureStreamer::UploadThread : public QThread
+{
+  public:
+    explicit UploadThread(GLTextureStreamer* texture_streamer)
+        : texture_streamer_(texture_streamer)
+    {
+    }
+
+  protected:
+    void run() override
+    {
+        texture_streamer_->run_upload_thread();
+    }
+
+  private:
+    GLTextureStreamer* texture_streamer_;
+};
+
+
+GLTextureStreamer::GLTextureStreamer(GLCanvas* gl_canvas)
+    : gl_canvas_(gl_canvas)
+{
+}
+
+
+GLTextureStreamer::~GLTextureStreamer()
+{
+    stop_upload_thread();
+
+    for (auto& staging : staging_buffers_) {
+        if (staging.fence != nullptr) {
+            gl_canvas_->glDeleteSync(staging.fence);
+        }
+        if (staging.pbo != 0) {
+            gl_canvas_->glDeleteBuffers(1, &staging.pbo);
+        }
+    }
+}
+
+
+bool GLTextureStreamer::initialize()
+{
+    is_threaded_ = initialize_upload_thread();
+    if (is_threaded_) {
+        return true;
+    }
+
+    QOpenGLContext* context       = gl_canvas_->context();
+    const QPair<int, int> version = context->format().version();
+
+    // Pixel buffer objects, glMapBufferRange and fences are core in 3.2
+    is_streaming_supported_ =
+        !context->isOpenGLES() &&
+        (version >= qMakePair(3, 2) ||
+         (context->hasExtension("GL_ARB_pixel_buffer_object") &&
+          context->hasExtension("GL_ARB_map_buffer_range") &&
+          context->hasExtension("GL_ARB_sync")));
+
+    if (!is_streaming_supported_) {
+        return true;
+    }
+
+    PFNBUFFERSTORAGE buffer_storage = nullptr;
+    if (version >= qMakePair(4, 4) ||
+        context->hasExtension("GL_ARB_buffer_storage")) {
+        buffer_storage = reinterpret_cast<PFNBUFFERSTORAGE>(
+            context->getProcAddress("glBufferStorage"));
+    }
+    is_persistently_mapped_ = buffer_storage != nullptr;
+
+    const GLbitfield persistent_flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    for (auto& staging : staging_buffers_) {
+        gl_canvas_->glGenBuffers(1, &staging.pbo);
+        gl_canvas_->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.pbo);
+
+        if (is_persistently_mapped_) {
+            // The staging buffers stay mapped for the whole session, so
+            // uploads are a plain memcpy
+            buffer_storage(GL_PIXEL_UNPACK_BUFFER,
+                           staging_buffer_size,
+                           nullptr,
+                           persistent_flags);
+            staging.data = static_cast<uint8_t*>(
+                gl_canvas_->glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,
+                                             0,
+                                             staging_buffer_size,
+                                             persistent_flags));
+            if (staging.data == nullptr) {
+                cerr << "[OpenImageDebugger] Could not map the texture "
+                        "staging buffers; uploading textures synchronously"
+                     << endl;
+                is_streaming_supported_ = false;
+                break;
+            }
+        } else {
+            gl_canvas_->glBufferData(GL_PIXEL_UNPACK_BUFFER,
+                                     staging_buffer_size,
+                                     nullptr,
+                                     GL_STREAM_DRAW);
+        }
+    }
+
+    gl_canvas_->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    return true;
+}
+
+
+void GLTextureStreamer::upload(TextureUpload upload)
+{
+    upload.correlation_id = TraceCorrelation::current();
+
+    if (is_threaded_) {
+        const uint64_t id = next_upload_id_++;
+        new_uploads_.push_back({id, upload, nullptr});
+        incomplete_uploads_[id] = upload.texture;
+        return;
+    }
+
+    if (!is_streaming_supported_) {
+        upload_directly(upload);
+        return;
+    }
+
+    pending_uploads_.push_back(upload);
+}
+
+
+void GLTextureStreamer::cancel(GLuint texture)
+{
+    if (is_threaded_) {
+        new_uploads_.erase(remove_if(new_uploads_.begin(),
+                                     new_uploads_.end(),
+                                     [texture](const ThreadedUpload& queued) {
+                                         return queued.upload.texture ==
+                                                texture;
+                                     }),
+                           new_uploads_.end());
+
+        unique_lock<mutex> lock(upload_mutex_);
+
+        for (auto queued = queued_uploads_.begin();
+             queued != queued_uploads_.end();) {
+            if (queued->upload.texture != texture) {
+                ++queued;
+                continue;
+            }
+
+            // The next upload inherits the fence it must wait on
+            GLsync ready_fence = queued->ready_fence;
+            queued             = queued_uploads_.erase(queued);
+            if (ready_fence != nullptr) {
+                if (queued != queued_uploads_.end() &&
+                    queued->ready_fence == nullptr) {
+                    queued->ready_fence = ready_fence;
+                } else {
+                    gl_canvas_->glDeleteSync(ready_fence);
+                }
+            }
+        }
+
+        // The source of the upload being transferred must not be read
+        // after returning
+        if (current_texture_ == texture) {
+            is_current_upload_canceled_ = true;
+            upload_finished_.wait(lock, [this, texture]() {
+                return current_texture_ != texture;
+            });
+        }
+        lock.unlock();
+
+        for (auto it = incomplete_uploads_.begin();
+             it != incomplete_uploads_.end();) {
+            if (it->second == texture) {
+                it = incomplete_uploads_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return;
+    }
+
+    pending_uploads_.erase(remove_if(pending_uploads_.begin(),
+                                     pending_uploads_.end(),
+                                     [texture](const TextureUpload& upload) {
+                                         return upload.texture == texture;
+                                     }),
+                           pending_uploads_.end());
+}
+
+
+bool GLTextureStreamer::is_pending(GLuint texture) const
+{
+    if (is_threaded_) {
+        return any_of(incomplete_uploads_.begin(),
+                      incomplete_uploads_.end(),
+                      [texture](const pair<const uint64_t, GLuint>& upload) {
+                          return upload.second == texture;
+                      });
+    }
+
+    return any_of(pending_uploads_.begin(),
+                  pending_uploads_.end(),
+                  [texture](const TextureUpload& upload) {
+                      return upload.texture == texture;
+                  });
+}
+
+
+bool GLTextureStreamer::has_pending_uploads() const
+{
+    return !pending_uploads_.empty() || !incomplete_uploads_.empty();
+}
+
+
+uint64_t GLTextureStreamer::uploaded_bytes() const
+{
+    return uploaded_bytes_;
+}
+
+
+void GLTextureStreamer::process_pending_uploads()
+{
+    if (is_threaded_) {
+        hand_over_uploads();
+        collect_completed_uploads();
+        return;
+    }
+
+    for (size_t i = 0;
+         i < staging_buffers_.size() && !pending_uploads_.empty();
+         ++i) {
+        StagingBuffer& staging = staging_buffers_[next_staging_buffer_];
+
+        // Stop if the GPU is still reading from the next staging buffer;
+        // the remaining uploads will be issued in the next frame
+        if (staging.fence != nullptr) {
+            GLenum status =
+                gl_canvas_->glClientWaitSync(staging.fence, 0, 0);
+            if (status == GL_TIMEOUT_EXPIRED) {
+                break;
+            }
+            gl_canvas_->glDeleteSync(staging.fence);
+            staging.fence = nullptr;
+        }
+
+        TextureUpload& upload = pending_uploads_.front();
+        upload_rows(staging, upload);
+        if (upload.height == 0) {
+            pending_uploads_.pop_front();
+        }
+
+        staging.fence =
+            gl_canvas_->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        next_staging_buffer_ = (next_staging_buffer_ + 1) %
+                               staging_buffers_.size();
+    }
+}
+
+
+void GLTextureStreamer::upload_directly(const TextureUpload& upload)
+{
+    TraceSpan span("texture upload", upload.correlation_id);
+
+    gl_canvas_->glBindTexture(texture_target(upload), upload.texture);
+
+    gl_canvas_->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    gl_canvas_->glPixelStorei(GL_UNPACK_ROW_LENGTH, upload.source_row_length);
+
+    upload_region_rows(gl_canvas_, upload, upload.height, upload.source);
+
+    gl_canvas_->glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+    uploaded_bytes_ += static_cast<uint64_t>(upload.width) * upload.height *
+                       upload.pixel_size;
+}
+
+
+void GLTextureStreamer::upload_rows(StagingBuffer& staging,
+                                    TextureUpload& upload)
+{
+    TraceSpan span("texture upload", upload.correlation_id);
+
+    const size_t row_size =
+        static_cast<size_t>(upload.width) * upload.pixel_size;
+    const size_t source_pitch =
+        static_cast<size_t>(upload.source_row_length) * upload.pixel_size;
+
+    // Upload as many rows as fit in the staging buffer
+    const int rows = static_cast<int>(
+        min(static_cast<size_t>(upload.height),
+            max(staging_buffer_size / row_size, static_cast<size_t>(1))));
+    const size_t upload_size = row_size * static_cast<size_t>(rows);
+
+    gl_canvas_->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.pbo);
+
+    uint8_t* dst = staging.data;
+    if (!is_persistently_mapped_) {
+        dst = static_cast<uint8_t*>(gl_canvas_->glMapBufferRange(
+            GL_PIXEL_UNPACK_BUFFER,
+            0,
+            upload_size,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+
+        if (dst == nullptr) {
+            gl_canvas_->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            upload_directly(upload);
+            upload.height = 0;
+            return;
+        }
+    }
+
+    const uint8_t* src = upload.source;
+    for (int row = 0; row < rows; ++row) {
+        memcpy(dst, src, row_size);
+        dst += row_size;
+        src += source_pitch;
+    }
+
+    if (!is_persistently_mapped_) {
+        gl_canvas_->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+
+    gl_canvas_->glBindTexture(texture_target(upload), upload.texture);
+
+    gl_canvas_->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    upload_region_rows(gl_canvas_, upload, rows, nullptr);
+
+    gl_canvas_->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    uploaded_bytes_ += upload_size;
+
+    // Advance to the rows left for the next staging buffer
+    upload.source += source_pitch * static_cast<size_t>(rows);
+    upload.y += rows;
+    upload.height -= rows;
+}
+
+
+bool GLTextureStreamer::initialize_upload_thread()
+{
+    if (!QOpenGLContext::supportsThreadedOpenGL()) {
+        return false;
+    }
+
+    // Fences are needed to hand textures over between the contexts
+    QOpenGLContext* context       = gl_canvas_->context();
+    const QPair<int, int> version = context->format().version();
+    const bool has_fences = context->isOpenGLES()
+                                ? version >= qMakePair(3, 0)
+                                : version >= qMakePair(3, 2) ||
+                                      context->hasExtension("GL_ARB_sync");
+    if (!has_fences) {
+        return false;
+    }
+
+    upload_surface_.reset(new QOffscreenSurface());
+    upload_surface_->setFormat(context->format());
+    upload_surface_->create();
+
+    upload_context_.reset(new QOpenGLContext());
+    upload_context_->setFormat(context->format());
+    upload_context_->setShareContext(context);
+
+    if (!upload_surface_->isValid() || !upload_context_->create() ||
+        !QOpenGLContext::areSharing(upload_context_.get(), context)) {
+        cerr << "[OpenImageDebugger] Could not create a shared OpenGL "
+                "context for uploading textures"
+             << endl;
+        upload_context_.reset();
+        upload_surface_.reset();
+        return false;
+    }
+
+    upload_thread_.reset(new UploadThread(this));
+    upload_context_->moveToThread(upload_thread_.get());
+    upload_thread_->start();
+
+    return true;
+}
+
+
+void GLTextureStreamer::stop_upload_thread()
+{
+    if (upload_thread_ == nullptr) {
+        return;
+    }
+
+    {
+        lock_guard<mutex> lock(upload_mutex_);
+        is_stopping_ = true;
+    }
+    upload_available_.notify_one();
+    upload_thread_->wait();
+
+    for (const auto& queued : queued_uploads_) {
+        if (queued.ready_fence != nullptr) {
+            gl_canvas_->glDeleteSync(queued.ready_fence);
+        }
+    }
+    move(completed_uploads_.begin(),
+         completed_uploads_.end(),
+         back_inserter(signaling_uploads_));
+    for (const auto& completed : signaling_uploads_) {
+        gl_canvas_->glDeleteSync(completed.fence);
+    }
+
+    queued_uploads_.clear();
+    completed_uploads_.clear();
+    signaling_uploads_.clear();
+    new_uploads_.clear();
+    incomplete_uploads_.clear();
+
+    upload_thread_.reset();
+    upload_context_.reset();
+    upload_surface_.reset();
+}
+
+
+void GLTextureStreamer::hand_over_uploads()
+{
+    if (new_uploads_.empty()) {
+        return;
+    }
+
+    // The textures were allocated in this context; the upload thread must
+    // not write to them before the allocation reaches the GPU
+    new_uploads_.front().ready_fence =
+        gl_canvas_->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    gl_canvas_->glFlush();
+
+    {
+        lock_guard<mutex> lock(upload_mutex_);
+        move(new_uploads_.begin(),
+             new_uploads_.end(),
+             back_inserter(queued_uploads_));
+    }
+    new_uploads_.clear();
+
+    upload_available_.notify_one();
+}
+
+
+void GLTextureStreamer::collect_completed_uploads()
+{
+    {
+        lock_guard<mutex> lock(upload_mutex_);
+        move(completed_uploads_.begin(),
+             completed_uploads_.end(),
+             back_inserter(signaling_uploads_));
+        completed_uploads_.clear();
+    }
+
+    // Uploads run in order, so their fences are signaled in order too
+    while (!signaling_uploads_.empty()) {
+        const CompletedUpload& completed = signaling_uploads_.front();
+
+        GLenum status = gl_canvas_->glClientWaitSync(completed.fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            break;
+        }
+        gl_canvas_->glDeleteSync(completed.fence);
+
+        // Canceled uploads are no longer tracked
+        incomplete_uploads_.erase(completed.id);
+        signaling_uploads_.pop_front();
+    }
+}
+
+
+void GLTextureStreamer::run_upload_thread()
+{
+    upload_context_->makeCurrent(upload_surface_.get());
+    QOpenGLExtraFunctions* gl = upload_context_->extraFunctions();
+
+    while (true) {
+        ThreadedUpload threaded;
+
+        {
+            unique_lock<mutex> lock(upload_mutex_);
+            upload_available_.wait(lock, [this]() {
+                return is_stopping_ || !queued_uploads_.empty();
+            });
+            if (is_stopping_) {
+                break;
+            }
+
+            threaded = queued_uploads_.front();
+            queued_uploads_.pop_front();
+
+            current_texture_            = threaded.upload.texture;
+            is_current_upload_canceled_ = false;
+        }
+
+        if (threaded.ready_fence != nullptr) {
+            gl->glWaitSync(threaded.ready_fence, 0, GL_TIMEOUT_IGNORED);
+            gl->glDeleteSync(threaded.ready_fence);
+        }
+
+        TextureUpload& upload = threaded.upload;
+
+        TraceSpan span("texture upload", upload.correlation_id);
+
+        const size_t row_size =
+            static_cast<size_t>(upload.width) * upload.pixel_size;
+        const size_t source_pitch =
+            static_cast<size_t>(upload.source_row_length) * upload.pixel_size;
+        const int slice_rows = static_cast<int>(
+            max(staging_buffer_size / row_size, static_cast<size_t>(1)));
+
+        gl->glBindTexture(texture_target(upload), upload.texture);
+        gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        gl->glPixelStorei(GL_UNPACK_ROW_LENGTH, upload.source_row_length);
+
+        // Transferred in slices, so that canceling doesn't have to wait for
+        // the whole buffer
+        while (upload.height > 0) {
+            {
+                lock_guard<mutex> lock(upload_mutex_);
+                if (is_current_upload_canceled_) {
+                    break;
+                }
+            }
+
+            const int rows = min(slice_rows, upload.height);
+            upload_region_rows(gl, upload, rows, upload.source);
+
+            uploaded_bytes_ += row_size * static_cast<size_t>(rows);
+
+            upload.source += source_pitch * static_cast<size_t>(rows);
+            upload.y += rows;
+            upload.height -= rows;
+        }
+
+        gl->glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        gl->glBindTexture(texture_target(upload), 0);
+
+        GLsync fence = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        gl->glFlush();
+
+        {
+            lock_guard<mutex> lock(upload_mutex_);
+            completed_uploads_.push_back(
+                {threaded.id, upload.texture, fence});
+            current_texture_ = 0;
+        }
+        upload_finished_.notify_all();
+    }
+
+    upload_context_->doneCurrent();
+}
@@ -0,0 +1,191 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef GL_TEXTURE_STREAMER_H_
+#define GL_TEXTURE_STREAMER_H_
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "ui/gl_canvas.h"
+
+class QOffscreenSurface;
+class QOpenGLContext;
+class QThread;
+
+
+/**
+ * Uploads buffer contents to textures without stalling the frames drawn in
+ * the meantime. The textures already uploaded can be drawn while the
+ * remaining ones are still being transferred.
+ *
+ * Where the platform supports threaded OpenGL, the uploads are performed by
+ * a thread with its own context, shared with the canvas. Each upload is
+ * handed over to the canvas through a fence once the GPU has completed it.
+ * Otherwise, they are spread across several frames through a ring of pixel
+ * buffer objects. If the OpenGL context doesn't support pixel buffer objects
+ * and fences either, the uploads are performed synchronously.
+ */
+class GLTextureStreamer
+{
+  public:
+    struct TextureUpload
+    {
+        GLuint texture;
+        // First pixel of the uploaded region
+        const uint8_t* source;
+        // Distance between the source rows, in pixels
+        int source_row_length;
+        int x;
+        int y;
+        int width;
+        int height;
+        int pixel_size;
+        GLenum format;
+        GLenum type;
+        // Layer of the array texture the region is uploaded to, or -1 for a
+        // 2D texture
+        int layer = -1;
+        // Traced plot the upload belongs to, set when it is scheduled
+        std::uint64_t correlation_id = 0;
+    };
+
+    GLTextureStreamer(GLCanvas* gl_canvas);
+    ~GLTextureStreamer();
+
+    bool initialize();
+
+    /**
+     * Schedules the upload of a texture region. The source memory must remain
+     * valid until the upload completes or is canceled.
+     */
+    void upload(TextureUpload upload);
+
+    /**
+     * Drops the pending uploads to the given texture
+     */
+    void cancel(GLuint texture);
+
+    bool is_pending(GLuint texture) const;
+
+    bool has_pending_uploads() const;
+
+    /**
+     * Transfers as many pending uploads as there are staging buffers
+     * available. Must be called once per frame while uploads are pending.
+     */
+    void process_pending_uploads();
+
+    // Bytes transferred to textures so far, by the canvas and the upload
+    // thread
+    std::uint64_t uploaded_bytes() const;
+
+  private:
+    class UploadThread;
+
+    struct StagingBuffer
+    {
+        GLuint pbo    = 0;
+        GLsync fence  = nullptr;
+        uint8_t* data = nullptr;
+    };
+
+    struct ThreadedUpload
+    {
+        std::uint64_t id;
+        TextureUpload upload;
+        // Set for the first upload handed over in a frame. The upload thread
+        // waits on it before touching textures created by the canvas.
+        GLsync ready_fence;
+    };
+
+    struct CompletedUpload
+    {
+        std::uint64_t id;
+        GLuint texture;
+        // Signaled once the GPU has finished the upload
+        GLsync fence;
+    };
+
+    static constexpr std::size_t staging_buffer_size = 8 << 20;
+
+    void upload_directly(const TextureUpload& upload);
+
+    void upload_rows(StagingBuffer& staging, TextureUpload& upload);
+
+    bool initialize_upload_thread();
+
+    void stop_upload_thread();
+
+    void hand_over_uploads();
+
+    void collect_completed_uploads();
+
+    void run_upload_thread();
+
+    std::array<StagingBuffer, 4> staging_buffers_;
+    std::size_t next_staging_buffer_ = 0;
+
+    std::deque<TextureUpload> pending_uploads_;
+
+    bool is_streaming_supported_ = false;
+    bool is_persistently_mapped_ = false;
+    bool is_threaded_            = false;
+
+    // Threaded uploads, as seen by the canvas: those not handed over to the
+    // upload thread yet, those not completed yet, and the completed ones
+    // whose fence hasn't been signaled yet
+    std::deque<ThreadedUpload> new_uploads_;
+    std::map<std::uint64_t, GLuint> incomplete_uploads_;
+    std::deque<CompletedUpload> signaling_uploads_;
+    std::uint64_t next_upload_id_ = 1;
+
+    std::unique_ptr<QOffscreenSurface> upload_surface_;
+    std::unique_ptr<QOpenGLContext> upload_context_;
+    std::unique_ptr<UploadThread> upload_thread_;
+
+    // Shared with the upload thread, guarded by upload_mutex_
+    std::mutex upload_mutex_;
+    std::condition_variable upload_available_;
+    std::condition_variable upload_finished_;
+    std::deque<ThreadedUpload> queued_uploads_;
+    std::deque<CompletedUpload> completed_uploads_;
+    // Texture being uploaded, and whether it was canceled meanwhile
+    GLuint current_texture_          = 0;
+    bool is_current_upload_canceled_ = false;
+    bool is_stopping_                = false;
+
+    std::atomic<std::uint64_t> uploaded_bytes_{0};
+
+    GLCanvas* gl_canvas_;
+};
+
+#endif // GL_TEXTURE_STREAMER_H_
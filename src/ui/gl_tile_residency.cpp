@@ -0,0 +1,127 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <utility>
+
+#include "gl_tile_residency.h"
+
+
+using namespace std;
+
+
+void GLTileResidency::set_budget(size_t bytes)
+{
+    budget_ = bytes;
+}
+
+
+size_t GLTileResidency::budget() const
+{
+    return budget_;
+}
+
+
+size_t GLTileResidency::resident_size() const
+{
+    return resident_size_;
+}
+
+
+void GLTileResidency::begin_frame()
+{
+    ++frame_;
+}
+
+
+bool GLTileResidency::add(GLuint texture,
+                          size_t bytes,
+                          const EvictCallback& evict)
+{
+    if (!make_room(bytes)) {
+        return false;
+    }
+
+    tiles_.push_front(Tile{texture, bytes, frame_, evict});
+    tile_by_texture_[texture] = tiles_.begin();
+    resident_size_ += bytes;
+
+    return true;
+}
+
+
+void GLTileResidency::grow(GLuint texture, size_t bytes)
+{
+    const auto tile = tile_by_texture_.find(texture);
+    if (tile == tile_by_texture_.end()) {
+        return;
+    }
+
+    // The level is already allocated, so it's accounted for even if the
+    // budget can't accommodate it
+    make_room(bytes);
+
+    tile->second->bytes += bytes;
+    resident_size_ += bytes;
+}
+
+
+void GLTileResidency::touch(GLuint texture)
+{
+    const auto tile = tile_by_texture_.find(texture);
+    if (tile == tile_by_texture_.end()) {
+        return;
+    }
+
+    tile->second->last_used_frame = frame_;
+    tiles_.splice(tiles_.begin(), tiles_, tile->second);
+}
+
+
+void GLTileResidency::remove(GLuint texture)
+{
+    const auto tile = tile_by_texture_.find(texture);
+    if (tile == tile_by_texture_.end()) {
+        return;
+    }
+
+    resident_size_ -= tile->second->bytes;
+    tiles_.erase(tile->second);
+    tile_by_texture_.erase(tile);
+}
+
+
+bool GLTileResidency::make_room(size_t bytes)
+{
+    while (resident_size_ + bytes > budget_ && !tiles_.empty() &&
+           tiles_.back().last_used_frame < frame_) {
+        // The tile is unregistered before its callback runs, since the
+        // callback may release the texture name
+        EvictCallback evict = std::move(tiles_.back().evict);
+        remove(tiles_.back().texture);
+        evict();
+    }
+
+    return resident_size_ + bytes <= budget_;
+}
@@ -0,0 +1,115 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef GL_TILE_RESIDENCY_H_
+#define GL_TILE_RESIDENCY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+
+#include <QOpenGLFunctions>
+
+
+/**
+ * Keeps the memory taken by the buffer textures under a budget, evicting the
+ * least recently drawn ones when new tiles must be made resident.
+ *
+ * Tiles drawn during the current frame are never evicted, so that a view
+ * requiring more memory than the budget degrades to missing tiles instead
+ * of uploading the same tiles over and over.
+ */
+class GLTileResidency
+{
+  public:
+    using EvictCallback = std::function<void()>;
+
+    static const std::size_t default_budget = std::size_t(2048) << 20;
+
+    void set_budget(std::size_t bytes);
+
+    std::size_t budget() const;
+
+    std::size_t resident_size() const;
+
+    /**
+     * Starts a new frame. Tiles touched in earlier frames become candidates
+     * for eviction.
+     */
+    void begin_frame();
+
+    /**
+     * Registers a tile texture taking the given amount of memory, evicting
+     * other tiles if needed. Returns false, leaving the texture unregistered,
+     * if the budget can't accommodate it.
+     *
+     * @param evict  Called when the tile is evicted. It must release the
+     *               texture storage; the tile is already unregistered.
+     */
+    bool add(GLuint texture, std::size_t bytes, const EvictCallback& evict);
+
+    /**
+     * Accounts for additional memory taken by a resident texture, such as
+     * levels of detail
+     */
+    void grow(GLuint texture, std::size_t bytes);
+
+    /**
+     * Marks a resident texture as used in the current frame
+     */
+    void touch(GLuint texture);
+
+    /**
+     * Unregisters a texture without calling its eviction callback
+     */
+    void remove(GLuint texture);
+
+  private:
+    struct Tile
+    {
+        GLuint texture;
+        std::size_t bytes;
+        uint64_t last_used_frame;
+        EvictCallback evict;
+    };
+
+    /**
+     * Evicts tiles not used in the current frame until the given amount of
+     * memory fits in the budget
+     */
+    bool make_room(std::size_t bytes);
+
+    // Most recently used tiles first
+    std::list<Tile> tiles_;
+    std::unordered_map<GLuint, std::list<Tile>::iterator> tile_by_texture_;
+
+    std::size_t budget_        = default_budget;
+    std::size_t resident_size_ = 0;
+    uint64_t frame_            = 0;
+};
+
+#endif // GL_TILE_RESIDENCY_H_
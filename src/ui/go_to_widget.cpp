@@ -46,8 +46,14 @@ GoToWidget::GoToWidget(QWidget* parent)
         ":resources/icons/y.svg", "Vertical coordinate", this);
     y_coordinate_->setValidator(new QIntValidator(y_coordinate_));
 
+    pixel_search_ = new DecoratedLineEdit(
+        ":resources/icons/find.svg",
+        "Find pixel: min, max, nan, inf, or a value (=, > or <)",
+        this);
+
     layout->addWidget(x_coordinate_);
     layout->addWidget(y_coordinate_);
+    layout->addWidget(pixel_search_);
 
     setVisible(false);
 }
@@ -55,6 +61,10 @@ GoToWidget::GoToWidget(QWidget* parent)
 
 void GoToWidget::keyPressEvent(QKeyEvent* e)
 {
+    // Hiding the widget moves the focus away
+    const bool is_search_requested =
+        pixel_search_->hasFocus() && !pixel_search_->text().isEmpty();
+
     switch (e->key()) {
     case Qt::Key_Escape:
         toggle_visible();
@@ -65,8 +75,12 @@ void GoToWidget::keyPressEvent(QKeyEvent* e)
     case Qt::Key_Return:
         toggle_visible();
         e->accept();
-        Q_EMIT(go_to_requested(x_coordinate_->text().toFloat() + 0.5f,
-                               y_coordinate_->text().toFloat() + 0.5f));
+        if (is_search_requested) {
+            Q_EMIT(pixel_search_requested(pixel_search_->text()));
+        } else {
+            Q_EMIT(go_to_requested(x_coordinate_->text().toFloat() + 0.5f,
+                                   y_coordinate_->text().toFloat() + 0.5f));
+        }
         return; // Let the completer do default behavior
     }
 }
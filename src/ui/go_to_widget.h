@@ -44,6 +44,10 @@ class GoToWidget : public QWidget
   Q_SIGNALS:
     void go_to_requested(float x, float y);
 
+    // Search for a pixel typed instead of the coordinates: min, max, nan,
+    // inf, or a value optionally preceded by =, > or <
+    void pixel_search_requested(const QString& query);
+
   public Q_SLOTS:
 
   protected:
@@ -53,6 +57,7 @@ class GoToWidget : public QWidget
   private:
     DecoratedLineEdit* x_coordinate_;
     DecoratedLineEdit* y_coordinate_;
+    DecoratedLineEdit* pixel_search_;
 };
 
 #endif // GO_TO_WIDGET_H_
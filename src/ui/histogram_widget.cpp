@@ -0,0 +1,144 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include <QPainter>
+
+#include "histogram_widget.h"
+
+
+HistogramWidget::HistogramWidget(QWidget* parent)
+    : QWidget(parent)
+    , channels_(0)
+{
+}
+
+
+void HistogramWidget::set_histogram(const Histogram& histogram,
+                                    const float* lowest,
+                                    const float* upper)
+{
+    channels_ = histogram.channels();
+
+    for (int c = 0; c < channels_; ++c) {
+        const std::vector<uint32_t>& bins = histogram.bins(c);
+        const size_t num_bins             = bins.size();
+
+        columns_[c].assign(plot_columns, 0.f);
+        if (num_bins == 0) {
+            lowest_marker_[c] = upper_marker_[c] = 0.f;
+            continue;
+        }
+
+        // Merge neighbouring bins into the plot columns, keeping the
+        // largest count so that isolated peaks remain visible
+        for (size_t b = 0; b < num_bins; ++b) {
+            const size_t col = b * plot_columns / num_bins;
+            columns_[c][col] =
+                std::max(columns_[c][col], static_cast<float>(bins[b]));
+        }
+
+        float largest = 0.f;
+        for (float& column : columns_[c]) {
+            column  = std::log1p(column);
+            largest = std::max(largest, column);
+        }
+        if (largest > 0.f) {
+            for (float& column : columns_[c]) {
+                column /= largest;
+            }
+        }
+
+        // Map the contrast levels to the plot coordinates
+        const float first = histogram.bin_value(c, 0.f);
+        const float range =
+            histogram.bin_value(c, static_cast<float>(num_bins)) - first;
+        const auto to_plot = [first, range](float value) {
+            return range > 0.f
+                       ? std::min(std::max((value - first) / range, 0.f), 1.f)
+                       : 0.f;
+        };
+        lowest_marker_[c] = to_plot(lowest[c]);
+        upper_marker_[c]  = to_plot(upper[c]);
+    }
+
+    update();
+}
+
+
+void HistogramWidget::clear()
+{
+    channels_ = 0;
+    update();
+}
+
+
+void HistogramWidget::paintEvent(QPaintEvent*)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+
+    if (channels_ == 0) {
+        return;
+    }
+
+    const QColor single_channel_color(160, 160, 160);
+    const QColor channel_colors[] = {QColor(220, 60, 60),
+                                     QColor(60, 180, 60),
+                                     QColor(70, 110, 230),
+                                     QColor(160, 160, 160)};
+
+    const qreal plot_width  = width();
+    const qreal plot_height = height();
+    const qreal col_width   = plot_width / plot_columns;
+
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    for (int c = 0; c < channels_; ++c) {
+        QColor color = channels_ == 1 ? single_channel_color
+                                      : channel_colors[c];
+
+        // Overlapping channels are blended together
+        color.setAlpha(channels_ == 1 ? 255 : 110);
+
+        for (int col = 0; col < plot_columns; ++col) {
+            const qreal bar_height = columns_[c][col] * plot_height;
+            painter.fillRect(QRectF(col * col_width,
+                                    plot_height - bar_height,
+                                    col_width,
+                                    bar_height),
+                             color);
+        }
+
+        color.setAlpha(255);
+        painter.setPen(QPen(color, 1.0, Qt::DashLine));
+        const qreal lowest_x = lowest_marker_[c] * (plot_width - 1);
+        const qreal upper_x  = upper_marker_[c] * (plot_width - 1);
+        painter.drawLine(QPointF(lowest_x, 0), QPointF(lowest_x, plot_height));
+        painter.drawLine(QPointF(upper_x, 0), QPointF(upper_x, plot_height));
+    }
+}
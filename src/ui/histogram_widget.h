@@ -0,0 +1,70 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef HISTOGRAM_WIDGET_H_
+#define HISTOGRAM_WIDGET_H_
+
+#include <vector>
+
+#include <QWidget>
+
+#include "math/histogram.h"
+
+
+/**
+ * Log scaled plot of the histogram of the selected buffer, with markers at
+ * its auto contrast levels
+ */
+class HistogramWidget : public QWidget
+{
+    Q_OBJECT
+
+  public:
+    explicit HistogramWidget(QWidget* parent = 0);
+
+    void set_histogram(const Histogram& histogram,
+                       const float* lowest,
+                       const float* upper);
+
+    void clear();
+
+  protected:
+    void paintEvent(QPaintEvent*);
+
+  private:
+    static const int plot_columns = 128;
+
+    int channels_;
+
+    // Downsampled bins of each channel, normalized to [0, 1]
+    std::vector<float> columns_[4];
+
+    // Position of the contrast levels over the plot, in [0, 1]
+    float lowest_marker_[4];
+    float upper_marker_[4];
+};
+
+
+#endif // HISTOGRAM_WIDGET_H_
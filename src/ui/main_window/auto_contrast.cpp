@@ -53,8 +53,7 @@ void disable_inputs(const initializer_list<QLineEdit*>& inputs)
 
 void MainWindow::reset_ac_min_labels()
 {
-    GameObject* buffer_obj = currently_selected_stage_->get_game_object("buffer");
-    Buffer* buffer = buffer_obj->get_component<Buffer>("buffer_component");
+    Buffer* buffer = currently_selected_stage_->get_buffer_component();
     float* ac_min  = buffer->min_buffer_values();
 
     ui_->ac_red_min->setText(QString::number(ac_min[0]));
@@ -82,13 +81,14 @@ void MainWindow::reset_ac_min_labels()
         disable_inputs(
             {ui_->ac_green_min, ui_->ac_blue_min, ui_->ac_alpha_min});
     }
+
+    update_ac_histogram();
 }
 
 
 void MainWindow::reset_ac_max_labels()
 {
-    GameObject* buffer_obj = currently_selected_stage_->get_game_object("buffer");
-    Buffer* buffer = buffer_obj->get_component<Buffer>("buffer_component");
+    Buffer* buffer = currently_selected_stage_->get_buffer_component();
     float* ac_max  = buffer->max_buffer_values();
 
     ui_->ac_red_max->setText(QString::number(ac_max[0]));
@@ -115,6 +115,28 @@ void MainWindow::reset_ac_max_labels()
         disable_inputs(
             {ui_->ac_green_max, ui_->ac_blue_max, ui_->ac_alpha_max});
     }
+
+    update_ac_histogram();
+}
+
+
+void MainWindow::update_ac_histogram()
+{
+    if (currently_selected_stage_ == nullptr) {
+        ui_->acHistogram->clear();
+        return;
+    }
+
+    // The histogram is computed lazily, so skip it while nobody can see it
+    if (!ui_->minMaxEditor->isVisible()) {
+        return;
+    }
+
+    Buffer* buffer = currently_selected_stage_->get_buffer_component();
+
+    ui_->acHistogram->set_histogram(buffer->histogram(),
+                                    buffer->min_buffer_values(),
+                                    buffer->max_buffer_values());
 }
 
 
@@ -169,16 +191,14 @@ void MainWindow::ac_alpha_max_update()
 void MainWindow::ac_min_reset()
 {
     if (currently_selected_stage_ != nullptr) {
-        GameObject* buffer_obj =
-            currently_selected_stage_->get_game_object("buffer");
-        Buffer* buff = buffer_obj->get_component<Buffer>("buffer_component");
+        Buffer* buff = currently_selected_stage_->get_buffer_component();
         buff->recompute_min_color_values();
         buff->compute_contrast_brightness_parameters();
 
         // Update inputs
         reset_ac_min_labels();
 
-        request_render_update_ = true;
+        request_render_update();
     }
 }
 
@@ -186,16 +206,29 @@ void MainWindow::ac_min_reset()
 void MainWindow::ac_max_reset()
 {
     if (currently_selected_stage_ != nullptr) {
-        GameObject* buffer_obj =
-            currently_selected_stage_->get_game_object("buffer");
-        Buffer* buff = buffer_obj->get_component<Buffer>("buffer_component");
+        Buffer* buff = currently_selected_stage_->get_buffer_component();
         buff->recompute_max_color_values();
         buff->compute_contrast_brightness_parameters();
 
         // Update inputs
         reset_ac_max_labels();
 
-        request_render_update_ = true;
+        request_render_update();
+    }
+}
+
+
+void MainWindow::ac_fit_view()
+{
+    if (currently_selected_stage_ != nullptr) {
+        Buffer* buff = currently_selected_stage_->get_buffer_component();
+        buff->reset_contrast_to_viewed_region();
+
+        // Update inputs
+        reset_ac_min_labels();
+        reset_ac_max_labels();
+
+        request_render_update();
     }
 }
 
@@ -206,20 +239,28 @@ void MainWindow::ac_toggle()
     for (auto& stage : stages_)
         stage.second->contrast_enabled = ac_enabled_;
 
-    request_render_update_ = true;
+    request_render_update();
+}
+
+
+void MainWindow::ac_edit_toggled(bool checked)
+{
+    if (checked) {
+        update_ac_histogram();
+    }
 }
 
 
 void MainWindow::set_ac_min_value(int idx, float value)
 {
     if (currently_selected_stage_ != nullptr) {
-        GameObject* buffer_obj =
-            currently_selected_stage_->get_game_object("buffer");
-        Buffer* buff = buffer_obj->get_component<Buffer>("buffer_component");
+        Buffer* buff = currently_selected_stage_->get_buffer_component();
         buff->min_buffer_values()[idx] = value;
         buff->compute_contrast_brightness_parameters();
 
-        request_render_update_ = true;
+        update_ac_histogram();
+
+        request_render_update();
     }
 }
 
@@ -227,12 +268,12 @@ void MainWindow::set_ac_min_value(int idx, float value)
 void MainWindow::set_ac_max_value(int idx, float value)
 {
     if (currently_selected_stage_ != nullptr) {
-        GameObject* buffer_obj =
-            currently_selected_stage_->get_game_object("buffer");
-        Buffer* buff = buffer_obj->get_component<Buffer>("buffer_component");
+        Buffer* buff = currently_selected_stage_->get_buffer_component();
         buff->max_buffer_values()[idx] = value;
         buff->compute_contrast_brightness_parameters();
 
-        request_render_update_ = true;
+        update_ac_histogram();
+
+        request_render_update();
     }
 }
@@ -0,0 +1,325 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstring>
+#include <iostream>
+
+#include <QFileInfo>
+
+#include "main_window.h"
+
+#include "io/array_file.h"
+#include "ipc/compression.h"
+#include "math/float_conversion.h"
+#include "ui_main_window.h"
+
+
+using namespace std;
+
+
+void MainWindow::open_buffer_files(const QStringList& paths)
+{
+    for (const QString& path : paths) {
+        open_buffer_file(path);
+    }
+
+    // Show the first buffer right away, unless one is already selected
+    if (currently_selected_stage_ == nullptr && buffer_list_->rowCount() > 0) {
+        ui_->imageList->setCurrentIndex(buffer_list_->index(0));
+    }
+}
+
+
+void MainWindow::timeline_position_selected(int position)
+{
+    if (currently_selected_stage_ == nullptr || position < 0) {
+        return;
+    }
+
+    const string& buffer_name =
+        currently_selected_stage_->buffer_metadata.variable_name;
+
+    // The latest version of a buffer is at the right end of its timeline
+    if (buffer_files_.find(buffer_name) != buffer_files_.end()) {
+        plot_recording_frame(buffer_name, static_cast<size_t>(position));
+    } else {
+        auto history = histories_.find(buffer_name);
+        if (history != histories_.end() &&
+            static_cast<size_t>(position) < history->second.version_count()) {
+            show_history_version(buffer_name,
+                                 history->second.version_count() - 1 -
+                                     static_cast<size_t>(position));
+        }
+    }
+}
+
+
+bool MainWindow::is_buffer_file(const QString& path) const
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    return suffix == "npy" || suffix == "oct" || suffix == "oidrec";
+}
+
+
+void MainWindow::open_buffer_file(const QString& path)
+{
+    const QFileInfo file_info(path);
+    const string buffer_name = file_info.absoluteFilePath().toStdString();
+    const QString suffix     = file_info.suffix().toLower();
+
+    BufferFile& buffer_file = buffer_files_[buffer_name];
+    buffer_file.path        = file_info.absoluteFilePath();
+    if (suffix == "npy") {
+        buffer_file.format = BufferFile::Format::NumpyArray;
+    } else if (suffix == "oct") {
+        buffer_file.format = BufferFile::Format::OctaveMatrix;
+    } else {
+        buffer_file.format = BufferFile::Format::Recording;
+    }
+
+    // Files opened again are reloaded if they are already being visualized
+    if (stages_.find(buffer_name) != stages_.end()) {
+        buffer_file.frame = 0;
+        load_buffer_file(buffer_name);
+        return;
+    }
+
+    if (buffer_list_->buffer_row(buffer_name) >= 0) {
+        return;
+    }
+
+    buffer_file.frame = 0;
+
+    // Nothing is read until the buffer is selected
+    buffer_list_->add_buffer(buffer_name,
+                             file_info.fileName() + "\n[not loaded]");
+}
+
+
+bool MainWindow::load_buffer_file(const string& buffer_name)
+{
+    auto buffer_file = buffer_files_.find(buffer_name);
+    if (buffer_file == buffer_files_.end()) {
+        return false;
+    }
+
+    BufferFile& entry = buffer_file->second;
+
+    unique_ptr<QFile> file(new QFile(entry.path));
+    const uint8_t* contents = nullptr;
+    if (file->open(QIODevice::ReadOnly)) {
+        contents = file->map(0, file->size());
+    }
+    const size_t length = static_cast<size_t>(file->size());
+
+    // The previous mapping is released once the stage stops referencing it
+    unique_ptr<QFile> previous_file;
+
+    if (entry.format == BufferFile::Format::Recording) {
+        RecordingReader recording;
+        if (contents == nullptr || !recording.open(contents, length) ||
+            recording.frame_count() == 0) {
+            cerr << "[OpenImageDebugger] Could not open recording "
+                 << entry.path.toStdString() << endl;
+            return false;
+        }
+
+        previous_file   = std::move(entry.file);
+        entry.file      = std::move(file);
+        entry.recording = recording;
+
+        return plot_recording_frame(
+            buffer_name, min(entry.frame, recording.frame_count() - 1));
+    }
+
+    ArrayFileHeader header;
+    const bool is_header_valid =
+        contents != nullptr &&
+        (entry.format == BufferFile::Format::NumpyArray
+             ? parse_npy_header(contents, length, header)
+             : parse_octave_matrix_header(contents, length, header));
+    if (!is_header_valid) {
+        cerr << "[OpenImageDebugger] Could not open buffer file "
+             << entry.path.toStdString() << endl;
+        return false;
+    }
+
+    BufferMetadata metadata;
+    metadata.variable_name    = buffer_name;
+    metadata.display_name     = QFileInfo(entry.path).fileName().toStdString();
+    metadata.pixel_layout     = "rgba";
+    metadata.transpose_buffer = false;
+    metadata.is_planar        = header.is_planar;
+    metadata.width            = header.width;
+    metadata.height           = header.height;
+    metadata.channels         = header.channels;
+    metadata.row_stride       = header.width;
+    metadata.type             = header.type;
+
+    previous_file = std::move(entry.file);
+    entry.file    = std::move(file);
+
+    plot_buffer_file_contents(metadata,
+                              contents + header.data_offset,
+                              static_cast<size_t>(header.width) *
+                                  static_cast<size_t>(header.height) *
+                                  static_cast<size_t>(header.channels) *
+                                  typesize(header.type));
+
+    return true;
+}
+
+
+bool MainWindow::plot_recording_frame(const string& buffer_name, size_t frame)
+{
+    auto buffer_file = buffer_files_.find(buffer_name);
+    if (buffer_file == buffer_files_.end() ||
+        buffer_file->second.format != BufferFile::Format::Recording) {
+        return false;
+    }
+
+    BufferFile& entry = buffer_file->second;
+
+    BufferRecorder::FrameRecord record;
+    const uint8_t* payload;
+    if (!entry.recording.read_frame(frame, record, payload)) {
+        return false;
+    }
+
+    BufferMetadata metadata;
+    metadata.variable_name = buffer_name;
+    metadata.display_name  = entry.recording.variable_name();
+    metadata.pixel_layout.assign(
+        record.pixel_layout,
+        strnlen(record.pixel_layout, sizeof(record.pixel_layout)));
+    metadata.transpose_buffer = record.transpose != 0;
+    metadata.is_planar        = record.planar != 0;
+    metadata.width            = record.width;
+    metadata.height           = record.height;
+    metadata.channels         = record.channels;
+    metadata.row_stride       = record.row_stride;
+    metadata.type             = static_cast<BufferType>(record.type);
+
+    const auto codec = static_cast<CompressionCodec>(record.codec);
+    if (codec == CompressionCodec::None) {
+        plot_buffer_file_contents(
+            metadata, payload, static_cast<size_t>(record.length));
+    } else {
+        // Compressed frames are decoded only when shown
+        HostBuffer decompressed(static_cast<size_t>(record.length));
+        if (!decompress_block(codec,
+                              payload,
+                              static_cast<size_t>(record.stored_length),
+                              decompressed.data(),
+                              decompressed.size())) {
+            cerr << "[OpenImageDebugger] Could not decode frame " << frame
+                 << " of recording " << entry.path.toStdString() << endl;
+            return false;
+        }
+
+        if (is_converted_to_float(metadata.type)) {
+            decompressed = make_float_buffer(
+                decompressed.data(), metadata.type, decompressed.size());
+        }
+        hold_buffer_contents(metadata, std::move(decompressed));
+    }
+
+    entry.frame = frame;
+    update_timeline();
+
+    return true;
+}
+
+
+void MainWindow::plot_buffer_file_contents(const BufferMetadata& metadata,
+                                           const uint8_t* contents,
+                                           size_t length)
+{
+    // The contents can only be displayed in place if they are aligned to
+    // their type, which Octave matrices don't guarantee
+    const bool is_aligned =
+        reinterpret_cast<uintptr_t>(contents) % typesize(metadata.type) == 0;
+
+    if (is_converted_to_float(metadata.type)) {
+        hold_buffer_contents(
+            metadata, make_float_buffer(contents, metadata.type, length));
+    } else if (!is_aligned) {
+        HostBuffer aligned_contents(length);
+        memcpy(aligned_contents.data(), contents, length);
+        hold_buffer_contents(metadata, std::move(aligned_contents));
+    } else {
+        compressed_buffers_.erase(metadata.variable_name);
+
+        plot_buffer(metadata, contents);
+
+        held_buffers_.erase(metadata.variable_name);
+        shared_buffers_.erase(metadata.variable_name);
+
+        enforce_memory_budget();
+    }
+}
+
+
+void MainWindow::update_timeline()
+{
+    if (currently_selected_stage_ == nullptr) {
+        ui_->timeline->hide();
+        return;
+    }
+
+    const string& buffer_name =
+        currently_selected_stage_->buffer_metadata.variable_name;
+    auto buffer_file = buffer_files_.find(buffer_name);
+    auto history     = histories_.find(buffer_name);
+
+    int frame_count = 0;
+    int frame       = 0;
+    if (buffer_file != buffer_files_.end()) {
+        if (buffer_file->second.format == BufferFile::Format::Recording) {
+            frame_count =
+                static_cast<int>(buffer_file->second.recording.frame_count());
+            frame = static_cast<int>(buffer_file->second.frame);
+        }
+    } else if (history != histories_.end()) {
+        frame_count = static_cast<int>(history->second.version_count());
+        frame       = frame_count - 1 -
+                static_cast<int>(history->second.viewed_version);
+    }
+
+    if (frame_count < 2) {
+        ui_->timeline->hide();
+        return;
+    }
+
+    // Only user changes of the slider select a frame
+    ui_->timelineSlider->blockSignals(true);
+    ui_->timelineSlider->setRange(0, frame_count - 1);
+    ui_->timelineSlider->setValue(frame);
+    ui_->timelineSlider->blockSignals(false);
+
+    ui_->timelineLabel->setText(
+        QString("%1 / %2").arg(frame + 1).arg(frame_count));
+    ui_->timeline->show();
+}
@@ -0,0 +1,233 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include <QAction>
+#include <QStatusBar>
+
+#include "main_window.h"
+
+#include "visualization/game_object.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+Buffer* get_buffer_component(Stage* stage)
+{
+    return stage->get_buffer_component();
+}
+
+} // namespace
+
+
+void MainWindow::compare_with_buffer()
+{
+    auto sender_action(static_cast<QAction*>(sender()));
+    const string reference_name =
+        sender_action->data().toString().toStdString();
+
+    if (currently_selected_stage_ == nullptr) {
+        return;
+    }
+
+    const string buffer_name =
+        currently_selected_stage_->buffer_metadata.variable_name;
+
+    // Buffer files get their stage once they are first needed
+    if (stages_.find(reference_name) == stages_.end() &&
+        buffer_files_.find(reference_name) != buffer_files_.end()) {
+        load_buffer_file(reference_name);
+    }
+
+    auto reference = stages_.find(reference_name);
+    if (reference == stages_.end()) {
+        return;
+    }
+
+    if (!get_buffer_component(currently_selected_stage_)
+             ->is_comparable(get_buffer_component(reference->second.get()))) {
+        statusBar()->showMessage(
+            QString("%1 and %2 can't be compared: their sizes, channels or "
+                    "types differ")
+                .arg(buffer_name.c_str())
+                .arg(reference_name.c_str()),
+            5000);
+        return;
+    }
+
+    // The reference textures are uploaded from its host copy
+    restore_held_buffer(reference_name);
+
+    comparisons_[buffer_name] = reference_name;
+    apply_comparison(buffer_name);
+
+    update_comparison_widgets();
+    request_render_update();
+}
+
+
+void MainWindow::stop_comparing()
+{
+    if (currently_selected_stage_ == nullptr) {
+        return;
+    }
+
+    const string& buffer_name =
+        currently_selected_stage_->buffer_metadata.variable_name;
+    get_buffer_component(currently_selected_stage_)
+        ->set_comparison(nullptr, Buffer::CompareMode::None, 0.f);
+    comparisons_.erase(buffer_name);
+
+    update_comparison_widgets();
+    request_render_update();
+}
+
+
+void MainWindow::comparison_mode_selected(int index)
+{
+    compare_mode_ = static_cast<Buffer::CompareMode>(index + 1);
+
+    // The threshold only applies to the mismatches
+    compare_threshold_box_->setEnabled(compare_mode_ ==
+                                       Buffer::CompareMode::Mismatches);
+
+    for (const auto& comparison : comparisons_) {
+        apply_comparison(comparison.first);
+    }
+
+    request_render_update();
+}
+
+
+void MainWindow::comparison_threshold_changed(double)
+{
+    for (const auto& comparison : comparisons_) {
+        apply_comparison(comparison.first);
+    }
+
+    update_comparison_widgets();
+    request_render_update();
+}
+
+
+void MainWindow::apply_comparison(const string& buffer_name)
+{
+    auto comparison = comparisons_.find(buffer_name);
+    auto stage      = stages_.find(buffer_name);
+    if (comparison == comparisons_.end() || stage == stages_.end()) {
+        return;
+    }
+
+    auto reference = stages_.find(comparison->second);
+    if (reference == stages_.end()) {
+        return;
+    }
+
+    get_buffer_component(stage->second.get())
+        ->set_comparison(get_buffer_component(reference->second.get()),
+                         compare_mode_,
+                         static_cast<float>(compare_threshold_box_->value()));
+}
+
+
+void MainWindow::forget_comparisons_with(const string& buffer_name)
+{
+    for (auto comparison = comparisons_.begin();
+         comparison != comparisons_.end();) {
+        if (comparison->first != buffer_name &&
+            comparison->second != buffer_name) {
+            ++comparison;
+            continue;
+        }
+
+        auto stage = stages_.find(comparison->first);
+        if (stage != stages_.end()) {
+            get_buffer_component(stage->second.get())
+                ->set_comparison(nullptr, Buffer::CompareMode::None, 0.f);
+        }
+
+        comparison = comparisons_.erase(comparison);
+    }
+
+    update_comparison_widgets();
+}
+
+
+void MainWindow::update_comparison_widgets()
+{
+    auto comparison =
+        currently_selected_stage_ == nullptr
+            ? comparisons_.end()
+            : comparisons_.find(
+                  currently_selected_stage_->buffer_metadata.variable_name);
+
+    const bool is_comparing = comparison != comparisons_.end();
+    compare_mode_box_->setVisible(is_comparing);
+    compare_threshold_box_->setVisible(is_comparing);
+    compare_errors_label_->setVisible(is_comparing);
+
+    if (!is_comparing) {
+        return;
+    }
+
+    Buffer* buffer = get_buffer_component(currently_selected_stage_);
+
+    float largest[4];
+    float mean[4];
+    size_t mismatches;
+    if (!buffer->comparison_errors(largest, mean, mismatches)) {
+        compare_errors_label_->setText(
+            QString("Comparing with %1").arg(comparison->second.c_str()));
+        return;
+    }
+
+    // Channels are reported together, by their largest errors
+    float largest_error = 0.f;
+    float mean_error    = 0.f;
+    for (int c = 0; c < buffer->channels; ++c) {
+        largest_error = std::max(largest_error, largest[c]);
+        mean_error    = std::max(mean_error, mean[c]);
+    }
+
+    const size_t pixel_count = static_cast<size_t>(buffer->buffer_width_f) *
+                               static_cast<size_t>(buffer->buffer_height_f);
+
+    compare_errors_label_->setText(
+        QString("vs %1: max %2, mean %3, %4 px over threshold (%5%)")
+            .arg(comparison->second.c_str())
+            .arg(static_cast<double>(largest_error), 0, 'g', 4)
+            .arg(static_cast<double>(mean_error), 0, 'g', 4)
+            .arg(mismatches)
+            .arg(100.0 * static_cast<double>(mismatches) /
+                     static_cast<double>(pixel_count),
+                 0,
+                 'f',
+                 2));
+}
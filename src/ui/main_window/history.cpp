@@ -0,0 +1,163 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "main_window.h"
+
+
+using namespace std;
+
+
+void MainWindow::push_buffer_history(const string& buffer_name)
+{
+    // Buffer files have their own timeline, and previous versions being
+    // shown aren't new versions
+    if (history_length_ <= 0 || is_showing_history_ ||
+        buffer_files_.find(buffer_name) != buffer_files_.end()) {
+        return;
+    }
+
+    BufferMetadata metadata;
+    size_t length;
+    const uint8_t* contents =
+        get_displayed_contents(buffer_name, metadata, length);
+    if (contents == nullptr) {
+        return;
+    }
+
+    // The stage now shows the new contents
+    if (history_buffer_name_ == buffer_name) {
+        history_buffer_name_.clear();
+        history_contents_.clear();
+        history_contents_.shrink_to_fit();
+    }
+
+    auto history = histories_.find(buffer_name);
+    if (history == histories_.end()) {
+        history = histories_
+                      .emplace(buffer_name,
+                               BufferHistory(
+                                   static_cast<size_t>(history_length_) + 1))
+                      .first;
+    }
+    history->second.push(metadata, contents);
+
+    enforce_history_budget();
+
+    if (currently_selected_stage_ != nullptr &&
+        currently_selected_stage_->buffer_metadata.variable_name ==
+            buffer_name) {
+        update_timeline();
+    }
+}
+
+
+void MainWindow::show_history_version(const string& buffer_name,
+                                      size_t version)
+{
+    auto history = histories_.find(buffer_name);
+    auto stage   = stages_.find(buffer_name);
+    if (history == histories_.end() || stage == stages_.end() ||
+        version >= history->second.version_count() ||
+        version == history->second.viewed_version) {
+        return;
+    }
+
+    // A previous version shown in another buffer is dropped first, as its
+    // contents are replaced
+    if (version != 0 && !history_buffer_name_.empty() &&
+        history_buffer_name_ != buffer_name) {
+        show_history_version(history_buffer_name_, 0);
+    }
+
+    const BufferMetadata metadata = stage->second->buffer_metadata;
+
+    is_showing_history_ = true;
+
+    if (version == 0) {
+        // Back to the live contents of the buffer
+        restore_held_buffer(buffer_name);
+
+        auto held_buffer = held_buffers_.find(buffer_name);
+        auto segment     = shared_buffers_.find(buffer_name);
+        if (held_buffer != held_buffers_.end()) {
+            plot_buffer(metadata, held_buffer->second.data());
+        } else if (segment != shared_buffers_.end()) {
+            segment->second->lock();
+            plot_buffer(metadata,
+                        reinterpret_cast<const uint8_t*>(
+                            segment->second->constData()));
+            segment->second->unlock();
+        }
+
+        history_buffer_name_.clear();
+        history_contents_.clear();
+        history_contents_.shrink_to_fit();
+    } else if (history->second.reconstruct(version, history_contents_)) {
+        plot_buffer(metadata, history_contents_.data());
+        history_buffer_name_ = buffer_name;
+    }
+
+    is_showing_history_ = false;
+
+    history->second.viewed_version = version;
+
+    if (currently_selected_stage_ == stage->second.get()) {
+        update_timeline();
+    }
+}
+
+
+void MainWindow::enforce_history_budget()
+{
+    const size_t budget = static_cast<size_t>(history_memory_budget_) << 20;
+
+    for (;;) {
+        size_t usage = 0;
+        auto largest = histories_.end();
+        for (auto history = histories_.begin(); history != histories_.end();
+             ++history) {
+            usage += history->second.memory_usage();
+            if (history->second.version_count() > 1 &&
+                (largest == histories_.end() ||
+                 history->second.memory_usage() >
+                     largest->second.memory_usage())) {
+                largest = history;
+            }
+        }
+
+        if (usage <= budget || largest == histories_.end()) {
+            return;
+        }
+
+        // The oldest version can't be dropped while it is being shown
+        BufferHistory& history = largest->second;
+        if (history.viewed_version + 1 == history.version_count() &&
+            history.viewed_version != 0) {
+            show_history_version(largest->first, 0);
+        }
+
+        history.drop_oldest_version();
+    }
+}
@@ -23,12 +23,14 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
 #include <QDateTime>
 #include <QDebug>
 #include <QFontDatabase>
+#include <QHeaderView>
 #include <QSettings>
 #include <QShortcut>
 #include <QHostAddress>
@@ -36,6 +38,7 @@
 #include "main_window.h"
 
 #include "ui_main_window.h"
+#include "ui/gl_tile_residency.h"
 
 
 void MainWindow::initialize_settings()
@@ -58,6 +61,85 @@ void MainWindow::initialize_settings()
         render_framerate_ = 1.0;
     }
 
+    // Load auto contrast percentiles. The defaults make the auto contrast
+    // levels match the buffer extrema.
+    ac_percentiles_[0] =
+        settings.value("Rendering/auto_contrast_lower_percentile", 0.0)
+            .toFloat();
+    ac_percentiles_[1] =
+        settings.value("Rendering/auto_contrast_upper_percentile", 100.0)
+            .toFloat();
+    ac_percentiles_[0] = std::min(std::max(ac_percentiles_[0], 0.f), 100.f);
+    ac_percentiles_[1] =
+        std::min(std::max(ac_percentiles_[1], ac_percentiles_[0]), 100.f);
+
+    // Load the reduction used for the levels of detail of zoomed out buffers
+    const QString lod_filter =
+        settings.value("Rendering/lod_filter", "average").toString();
+    lod_filter_ = lod_filter == "extremum" ? DownsampleFilter::Extremum
+                                           : DownsampleFilter::Average;
+
+    // Load the number of decimal digits of the pixel value labels
+    value_label_precision_ =
+        settings.value("Rendering/value_label_precision", 3).toInt();
+    value_label_precision_ = std::min(std::max(value_label_precision_, -1), 9);
+
+    // Load the texture memory budget. Tiles beyond it are evicted, least
+    // recently displayed first.
+    texture_memory_budget_ =
+        settings.value("Rendering/texture_memory_budget", 2048).toInt();
+    if (texture_memory_budget_ <= 0) {
+        texture_memory_budget_ = 2048;
+    }
+    gl_canvas()->get_tile_residency()->set_budget(
+        static_cast<size_t>(texture_memory_budget_) << 20);
+
+    // Load the host memory budget. Host copies of the buffers beyond it are
+    // compressed, least recently selected first.
+    host_memory_budget_ =
+        settings.value("Memory/host_budget", 8192).toInt();
+    if (host_memory_budget_ <= 0) {
+        host_memory_budget_ = 8192;
+    }
+
+    // Reserved huge pages must be set aside by the system beforehand, so
+    // large host copies only request them if told to
+    HostBufferPool::instance().set_reserved_huge_pages(
+        settings.value("Memory/reserved_huge_pages", false).toBool());
+
+    // Load the number of previous versions kept per buffer, and the memory
+    // available to them
+    history_length_ = settings.value("History/versions", 8).toInt();
+    history_length_ = std::min(std::max(history_length_, 0), 256);
+
+    history_memory_budget_ =
+        settings.value("History/memory_budget", 512).toInt();
+    if (history_memory_budget_ <= 0) {
+        history_memory_budget_ = 512;
+    }
+
+    // Load payload compression settings. Only used for TCP transfers, which
+    // are the ones used by remote sessions.
+    const QString compression_codec =
+        settings.value("Transport/compression_codec", "zlib").toString();
+    compression_settings_.codec = compression_codec == "zlib"
+                                      ? CompressionCodec::Zlib
+                                      : CompressionCodec::None;
+    compression_settings_.level =
+        settings.value("Transport/compression_level", 1).toInt();
+    compression_settings_.threshold = static_cast<size_t>(
+        settings.value("Transport/compression_threshold", 64 * 1024)
+            .toULongLong());
+
+    // Load the size from which buffers are sent progressively
+    progressive_threshold_ = static_cast<size_t>(
+        settings.value("Transport/progressive_threshold", 32 << 20)
+            .toULongLong());
+
+    // Load the size from which buffers are fetched as they are viewed
+    lazy_threshold_ = static_cast<size_t>(
+        settings.value("Transport/lazy_threshold", 1ull << 30).toULongLong());
+
     // Default save suffix: Image
     if (settings.contains("Export/default_export_suffix")) {
         default_export_suffix_ =
@@ -153,6 +235,11 @@ void MainWindow::initialize_timers()
     settings_persist_timer_.setSingleShot(true);
 
     connect(&update_timer_, SIGNAL(timeout()), this, SLOT(loop()));
+
+    connect(&metrics_timer_,
+            SIGNAL(timeout()),
+            this,
+            SLOT(update_performance_metrics()));
 }
 
 
@@ -180,14 +267,61 @@ void MainWindow::initialize_shortcuts()
             SIGNAL(go_to_requested(float, float)),
             this,
             SLOT(go_to_pixel(float, float)));
+    connect(go_to_widget_,
+            SIGNAL(pixel_search_requested(QString)),
+            this,
+            SLOT(search_pixel(QString)));
+
+    QShortcut* pixel_search_shortcut =
+        new QShortcut(QKeySequence(Qt::Key_F3), this);
+    connect(pixel_search_shortcut,
+            SIGNAL(activated()),
+            this,
+            SLOT(repeat_pixel_search()));
+
+    QShortcut* hud_shortcut =
+        new QShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_H), this);
+    connect(hud_shortcut,
+            SIGNAL(activated()),
+            this,
+            SLOT(toggle_performance_hud()));
+
+    QShortcut* metrics_panel_shortcut =
+        new QShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_M), this);
+    connect(metrics_panel_shortcut,
+            SIGNAL(activated()),
+            this,
+            SLOT(toggle_metrics_panel()));
+
+    QShortcut* ac_fit_view_shortcut =
+        new QShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_A), this);
+    connect(ac_fit_view_shortcut,
+            SIGNAL(activated()),
+            this,
+            SLOT(ac_fit_view()));
+
+    QShortcut* view_layout_shortcut =
+        new QShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_V), this);
+    connect(view_layout_shortcut,
+            SIGNAL(activated()),
+            this,
+            SLOT(cycle_view_layout()));
 }
 
 
 void MainWindow::initialize_networking()
 {
-    socket_.connectToHost(QString(host_settings_.url.c_str()),
-                          host_settings_.port);
-    socket_.waitForConnected();
+    // Without a bridge, there are no symbols to look up
+    if (host_settings_.is_offline) {
+        ui_->symbolList->setEnabled(false);
+        return;
+    }
+
+    if (host_settings_.is_daemon) {
+        initialize_window_daemon();
+    }
+
+    connect_to_bridge(host_settings_.url, host_settings_.port);
 }
 
 
@@ -197,23 +331,34 @@ void MainWindow::initialize_symbol_completer()
 
     symbol_completer_->setCaseSensitivity(Qt::CaseSensitivity::CaseInsensitive);
     symbol_completer_->setCompletionMode(QCompleter::PopupCompletion);
-    symbol_completer_->setModelSorting(
-        QCompleter::CaseInsensitivelySortedModel);
+    // Completions are listed by relevance
+    symbol_completer_->setModelSorting(QCompleter::UnsortedModel);
 
     ui_->symbolList->set_completer(symbol_completer_);
     connect(ui_->symbolList->completer(),
             SIGNAL(activated(QString)),
             this,
             SLOT(symbol_completed(QString)));
+    connect(symbol_completer_,
+            SIGNAL(completions_shown(QStringList)),
+            this,
+            SLOT(prefetch_completions(QStringList)));
 }
 
 
 void MainWindow::initialize_left_pane()
 {
-    connect(ui_->imageList,
-            SIGNAL(currentItemChanged(QListWidgetItem*, QListWidgetItem*)),
+    buffer_list_ = new BufferListModel(this);
+    buffer_list_->set_icon_request_handler(
+        [this](const std::string& buffer_name) {
+            return queue_buffer_icon(buffer_name);
+        });
+    ui_->imageList->setModel(buffer_list_);
+
+    connect(ui_->imageList->selectionModel(),
+            SIGNAL(currentChanged(const QModelIndex&, const QModelIndex&)),
             this,
-            SLOT(buffer_selected(QListWidgetItem*)));
+            SLOT(buffer_selected(const QModelIndex&)));
 
     connect(ui_->symbolList,
             SIGNAL(editingFinished()),
@@ -281,6 +426,11 @@ void MainWindow::initialize_toolbar()
 {
     connect(ui_->acToggle, SIGNAL(clicked()), this, SLOT(ac_toggle()));
 
+    connect(ui_->acEdit,
+            SIGNAL(toggled(bool)),
+            this,
+            SLOT(ac_edit_toggled(bool)));
+
     connect(ui_->reposition_buffer,
             SIGNAL(clicked()),
             this,
@@ -302,6 +452,25 @@ void MainWindow::initialize_toolbar()
 void MainWindow::initialize_visualization_pane()
 {
     ui_->bufferPreview->set_main_window(this);
+
+    // Buffer files can be opened by dropping them into the window
+    setAcceptDrops(true);
+
+    ui_->timeline->hide();
+    connect(ui_->timelineSlider,
+            SIGNAL(valueChanged(int)),
+            this,
+            SLOT(timeline_position_selected(int)));
+
+    ui_->tensorSlice->hide();
+    connect(ui_->tensorAxis,
+            SIGNAL(currentIndexChanged(int)),
+            this,
+            SLOT(tensor_axis_selected(int)));
+    connect(ui_->tensorSliceSlider,
+            SIGNAL(valueChanged(int)),
+            this,
+            SLOT(tensor_slice_selected(int)));
 }
 
 
@@ -311,6 +480,52 @@ void MainWindow::initialize_status_bar()
     status_bar_->setAlignment(Qt::AlignRight);
 
     statusBar()->addWidget(status_bar_, 1);
+
+    memory_usage_label_ = new QLabel(this);
+    memory_usage_label_->setToolTip(
+        "Memory used by the buffers, and the budgets beyond which the "
+        "unselected buffers are released");
+    statusBar()->addPermanentWidget(memory_usage_label_);
+
+    export_progress_bar_ = new QProgressBar(this);
+    export_progress_bar_->setRange(0, 0);
+    export_progress_bar_->setMaximumWidth(100);
+    export_progress_bar_->setToolTip("Exporting buffers");
+    export_progress_bar_->hide();
+    statusBar()->addPermanentWidget(export_progress_bar_);
+
+    // Comparison settings, only shown while the selected buffer is compared
+    // with another one. The modes follow Buffer::CompareMode.
+    compare_errors_label_ = new QLabel(this);
+    compare_errors_label_->hide();
+    statusBar()->addPermanentWidget(compare_errors_label_);
+
+    compare_mode_box_ = new QComboBox(this);
+    compare_mode_box_->addItems(
+        {"Absolute difference", "Signed difference", "Mismatches"});
+    compare_mode_box_->setToolTip("How the difference with the reference "
+                                  "buffer is displayed");
+    compare_mode_box_->hide();
+    statusBar()->addPermanentWidget(compare_mode_box_);
+
+    compare_threshold_box_ = new QDoubleSpinBox(this);
+    compare_threshold_box_->setRange(0.0, 1e9);
+    compare_threshold_box_->setDecimals(4);
+    compare_threshold_box_->setToolTip(
+        "Pixels differing by more than this value in any channel are "
+        "mismatches");
+    compare_threshold_box_->setEnabled(false);
+    compare_threshold_box_->hide();
+    statusBar()->addPermanentWidget(compare_threshold_box_);
+
+    connect(compare_mode_box_,
+            SIGNAL(currentIndexChanged(int)),
+            this,
+            SLOT(comparison_mode_selected(int)));
+    connect(compare_threshold_box_,
+            SIGNAL(valueChanged(double)),
+            this,
+            SLOT(comparison_threshold_changed(double)));
 }
 
 
@@ -318,3 +533,21 @@ void MainWindow::initialize_go_to_widget()
 {
     go_to_widget_ = new GoToWidget(ui_->bufferPreview);
 }
+
+
+void MainWindow::initialize_metrics_panel()
+{
+    metrics_table_ = new QTableWidget(0, 5, this);
+    metrics_table_->setHorizontalHeaderLabels(
+        {"Buffer", "State", "Host MB", "GPU MB", "Updated"});
+    metrics_table_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    metrics_table_->setSelectionMode(QAbstractItemView::NoSelection);
+    metrics_table_->verticalHeader()->hide();
+    metrics_table_->horizontalHeader()->setStretchLastSection(true);
+
+    metrics_dock_ = new QDockWidget("Buffer memory", this);
+    metrics_dock_->setObjectName("metricsDock");
+    metrics_dock_->setWidget(metrics_table_);
+    addDockWidget(Qt::RightDockWidgetArea, metrics_dock_);
+    metrics_dock_->hide();
+}
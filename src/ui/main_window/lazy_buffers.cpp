@@ -0,0 +1,316 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "main_window.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+#include "ipc/buffer_tiles.h"
+#include "math/downsample.h"
+#include "math/float_conversion.h"
+#include "visualization/components/buffer.h"
+#include "visualization/game_object.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+// Level of the tiles not fetched yet
+const int unfetched_tile_level = numeric_limits<int>::max();
+
+// Tiles requested in a single frame. The remaining ones are requested in
+// the next frames.
+const size_t max_requested_tiles = 1024;
+
+
+Buffer* get_buffer_component(Stage* stage)
+{
+    return stage->get_buffer_component();
+}
+
+} // namespace
+
+
+void MainWindow::decode_plot_buffer_lazy(MessageDecoder& message_decoder)
+{
+    BufferMetadata metadata;
+    message_decoder.read(metadata);
+
+    const size_t pixel_size =
+        static_cast<size_t>(metadata.channels) *
+        (is_converted_to_float(metadata.type) ? sizeof(float)
+                                              : typesize(metadata.type));
+
+    // Tiles are blank until fetched. The zeroed contents only take memory
+    // once written to.
+    HostBuffer contents(static_cast<size_t>(metadata.row_stride) *
+                            static_cast<size_t>(metadata.height) * pixel_size,
+                        true);
+
+    const size_t tile_count = static_cast<size_t>(
+        buffer_tile_count(metadata.width, metadata.height));
+
+    LazyBuffer& lazy_buffer = lazy_buffers_[metadata.variable_name];
+    lazy_buffer.tile_levels.assign(tile_count, unfetched_tile_level);
+    lazy_buffer.requested_levels.assign(tile_count, unfetched_tile_level);
+
+    refining_buffers_.erase(metadata.variable_name);
+    hold_buffer_contents(metadata, std::move(contents));
+}
+
+
+void MainWindow::decode_plot_buffer_level_tiles(
+    MessageDecoder& message_decoder)
+{
+    BufferMetadata metadata;
+    int level;
+    size_t tile_count;
+
+    message_decoder.read(metadata).read(level).read(tile_count);
+
+    // Tiles of a buffer replaced since they were requested are dropped
+    auto lazy_buffer = lazy_buffers_.find(metadata.variable_name);
+    auto held_buffer = held_buffers_.find(metadata.variable_name);
+    auto stage       = stages_.find(metadata.variable_name);
+    if (lazy_buffer == lazy_buffers_.end() ||
+        held_buffer == held_buffers_.end() || stage == stages_.end() ||
+        !has_same_layout(stage->second->buffer_metadata,
+                         displayed_metadata(metadata))) {
+        return;
+    }
+
+    level              = min(max(level, 0), buffer_tile_max_level);
+    const int sampling = 1 << level;
+
+    const bool is_converted = is_converted_to_float(metadata.type);
+    const size_t src_pixel_size =
+        static_cast<size_t>(metadata.channels) * typesize(metadata.type);
+    const size_t dst_pixel_size =
+        is_converted ? static_cast<size_t>(metadata.channels) * sizeof(float)
+                     : src_pixel_size;
+    const size_t dst_pitch =
+        static_cast<size_t>(metadata.row_stride) * dst_pixel_size;
+
+    vector<int>& tile_levels = lazy_buffer->second.tile_levels;
+
+    vector<BufferRegion> regions;
+    HostBuffer tile_contents;
+    for (size_t i = 0; i < tile_count; ++i) {
+        int tile;
+        message_decoder.read(tile).read_compressed(tile_contents);
+
+        if (tile < 0 || static_cast<size_t>(tile) >= tile_levels.size()) {
+            break;
+        }
+
+        const BufferRegion region =
+            buffer_tile_region(metadata.width, metadata.height, tile);
+        const int reduced_width  = (region.width + sampling - 1) / sampling;
+        const int reduced_height = (region.height + sampling - 1) / sampling;
+        const size_t reduced_length = static_cast<size_t>(reduced_width) *
+                                      static_cast<size_t>(reduced_height) *
+                                      src_pixel_size;
+
+        if (tile_contents.size() < reduced_length) {
+            cerr << "[OpenImageDebugger] Received truncated tile for buffer "
+                 << metadata.variable_name << endl;
+            break;
+        }
+
+        // A finer version of the tile may have arrived meanwhile
+        if (tile_levels[static_cast<size_t>(tile)] <= level) {
+            continue;
+        }
+
+        if (is_converted) {
+            tile_contents = make_float_buffer(
+                tile_contents.data(), metadata.type, reduced_length);
+        }
+
+        uint8_t* dst = held_buffer->second.data() +
+                       static_cast<size_t>(region.y) * dst_pitch +
+                       static_cast<size_t>(region.x) * dst_pixel_size;
+
+        if (level == 0) {
+            copy_buffer_region(tile_contents.data(),
+                               static_cast<size_t>(region.width) *
+                                   dst_pixel_size,
+                               dst,
+                               dst_pitch,
+                               region,
+                               dst_pixel_size);
+        } else {
+            upsample(tile_contents.data(),
+                     reduced_width,
+                     reduced_height,
+                     dst_pixel_size,
+                     region.width,
+                     region.height,
+                     metadata.row_stride,
+                     dst);
+        }
+
+        tile_levels[static_cast<size_t>(tile)] = level;
+        regions.push_back(region);
+    }
+
+    plot_buffer_regions(metadata, regions);
+
+    if (stage->second.get() == currently_selected_stage_) {
+        update_status_bar();
+    }
+}
+
+
+void MainWindow::fetch_viewed_tiles(Stage* stage)
+{
+    const BufferMetadata& metadata = stage->buffer_metadata;
+
+    auto lazy_buffer = lazy_buffers_.find(metadata.variable_name);
+    if (lazy_buffer == lazy_buffers_.end()) {
+        return;
+    }
+
+    int level;
+    const BufferRegion region =
+        get_buffer_component(stage)->viewed_region(level);
+    if (region.width <= 0 || region.height <= 0) {
+        return;
+    }
+
+    level = min(level, buffer_tile_max_level);
+
+    // Tiles around the view are fetched ahead, as their textures are
+    const int tiles_x =
+        (metadata.width + buffer_tile_size - 1) / buffer_tile_size;
+    const int tiles_y =
+        (metadata.height + buffer_tile_size - 1) / buffer_tile_size;
+    const int first_tx = max(region.x / buffer_tile_size - 1, 0);
+    const int first_ty = max(region.y / buffer_tile_size - 1, 0);
+    const int last_tx = min(
+        (region.x + region.width - 1) / buffer_tile_size + 1, tiles_x - 1);
+    const int last_ty = min(
+        (region.y + region.height - 1) / buffer_tile_size + 1, tiles_y - 1);
+
+    LazyBuffer& lazy = lazy_buffer->second;
+
+    vector<int> tiles;
+    for (int ty = first_ty; ty <= last_ty; ++ty) {
+        for (int tx = first_tx; tx <= last_tx; ++tx) {
+            const size_t tile = static_cast<size_t>(ty * tiles_x + tx);
+            if (lazy.tile_levels[tile] <= level ||
+                lazy.requested_levels[tile] <= level) {
+                continue;
+            }
+
+            lazy.requested_levels[tile] = level;
+            tiles.push_back(static_cast<int>(tile));
+
+            if (tiles.size() == max_requested_tiles) {
+                request_buffer_tiles(metadata.variable_name, level, tiles);
+                return;
+            }
+        }
+    }
+
+    if (!tiles.empty()) {
+        request_buffer_tiles(metadata.variable_name, level, tiles);
+    }
+}
+
+
+bool MainWindow::fetch_pixel(const string& buffer_name, int x, int y)
+{
+    auto lazy_buffer = lazy_buffers_.find(buffer_name);
+    auto stage       = stages_.find(buffer_name);
+    if (lazy_buffer == lazy_buffers_.end() || stage == stages_.end()) {
+        return true;
+    }
+
+    const BufferMetadata& metadata = stage->second->buffer_metadata;
+    if (x < 0 || x >= metadata.width || y < 0 || y >= metadata.height) {
+        return true;
+    }
+
+    const int tiles_x =
+        (metadata.width + buffer_tile_size - 1) / buffer_tile_size;
+    const size_t tile = static_cast<size_t>(
+        (y / buffer_tile_size) * tiles_x + x / buffer_tile_size);
+
+    LazyBuffer& lazy = lazy_buffer->second;
+    if (lazy.tile_levels[tile] == 0) {
+        return true;
+    }
+
+    if (lazy.requested_levels[tile] > 0) {
+        lazy.requested_levels[tile] = 0;
+        request_buffer_tiles(buffer_name, 0, {static_cast<int>(tile)});
+    }
+
+    return false;
+}
+
+
+void MainWindow::request_buffer_tiles(const string& buffer_name,
+                                      int level,
+                                      const vector<int>& tiles)
+{
+    if (host_settings_.is_offline) {
+        return;
+    }
+
+    MessageComposer message_composer;
+    message_composer.push(MessageType::PlotBufferTilesRequest)
+        .push(buffer_name)
+        .push(level)
+        .push(tiles.size());
+    for (int tile : tiles) {
+        message_composer.push(tile);
+    }
+    network_worker_->send(message_composer);
+}
+
+
+size_t MainWindow::lazy_buffer_memory_usage(const LazyBuffer& lazy_buffer,
+                                            size_t length) const
+{
+    // Zeroed pages are only committed once a tile is written to them.
+    // Fetched tiles are written in full, whatever their level.
+    const size_t fetched_tiles = static_cast<size_t>(
+        count_if(lazy_buffer.tile_levels.begin(),
+                 lazy_buffer.tile_levels.end(),
+                 [](int level) { return level != unfetched_tile_level; }));
+
+    if (lazy_buffer.tile_levels.empty()) {
+        return length;
+    }
+
+    return length / lazy_buffer.tile_levels.size() * fetched_tiles;
+}
@@ -33,7 +33,11 @@
 #include "main_window.h"
 
 #include "ui_main_window.h"
+#include "ui/gl_icon_readback.h"
+#include "system/trace/tracer.h"
+#include "ui/gl_texture_streamer.h"
 #include "visualization/components/camera.h"
+#include "visualization/events.h"
 #include "visualization/game_object.h"
 #include "ipc/message_exchange.h"
 
@@ -41,6 +45,11 @@
 using namespace std;
 
 
+// Longest time a batch of plots may hold back the rendering, in case the
+// bridge never finishes it
+const qint64 max_plot_batch_wait_ms = 1000;
+
+
 Q_DECLARE_METATYPE(QList<QString>)
 
 
@@ -50,13 +59,32 @@ MainWindow::MainWindow(const ConnectionSettings& host_settings,
     , is_window_ready_(false)
     , request_render_update_(true)
     , completer_updated_(false)
+    , is_receiving_plot_batch_(false)
     , ac_enabled_(true)
     , link_views_enabled_(false)
     , icon_width_base_(100)
     , icon_height_base_(50)
+    , is_showing_history_(false)
+    , selection_counter_(0)
+    , progressive_threshold_(0)
+    , lazy_threshold_(0)
     , currently_selected_stage_(nullptr)
+    , view_columns_(1)
+    , view_rows_(1)
+    , active_view_(0)
+    , view_buffers_(1)
+    , compare_mode_(Buffer::CompareMode::AbsoluteDifference)
+    , painted_correlation_id_(0)
+    , running_exports_(0)
+    , available_vars_version_(0)
+    , is_stop_displayed_(true)
+    , has_stop_batch_ended_(false)
+    , stop_display_latency_ms_(-1)
+    , metered_uploaded_bytes_(0)
+    , metered_received_bytes_(0)
     , ui_(new Ui::MainWindowUi)
     , host_settings_(host_settings)
+    , session_server_(nullptr)
 {
     QCoreApplication::instance()->installEventFilter(this);
 
@@ -72,6 +100,7 @@ MainWindow::MainWindow(const ConnectionSettings& host_settings,
     initialize_visualization_pane();
     initialize_settings();
     initialize_go_to_widget();
+    initialize_metrics_panel();
     initialize_shortcuts();
     initialize_networking();
 
@@ -81,7 +110,24 @@ MainWindow::MainWindow(const ConnectionSettings& host_settings,
 
 MainWindow::~MainWindow()
 {
+    // Recordings are closed with their frame index
+    recorders_.clear();
+
+    histories_.clear();
+
+    // The exports only touch their own copies of the buffers, but must not
+    // outlive the window they report to
+    pending_exports_.clear();
+
     held_buffers_.clear();
+    compressed_buffers_.clear();
+    refining_buffers_.clear();
+    lazy_buffers_.clear();
+    superseded_buffers_.clear();
+    traced_plots_.clear();
+    buffer_update_times_.clear();
+    shared_buffers_.clear();
+    buffer_files_.clear();
     is_window_ready_ = false;
 
     delete ui_;
@@ -90,15 +136,34 @@ MainWindow::~MainWindow()
 
 void MainWindow::show()
 {
-    update_timer_.start(static_cast<int>(1000.0 / render_framerate_));
+    // Runs the loop at least once, so that a failed connection to the
+    // debugger bridge closes the window
+    schedule_loop();
     QMainWindow::show();
 }
 
 
 void MainWindow::draw()
 {
-    if (currently_selected_stage_ != nullptr) {
-        currently_selected_stage_->draw();
+    const int64_t begin = Tracer::now();
+
+    draw_views();
+
+    if (currently_selected_stage_ == nullptr) {
+        return;
+    }
+
+    update_stop_latency();
+
+    // The first frame showing a traced plot completes its timeline
+    const string& buffer_name =
+        currently_selected_stage_->buffer_metadata.variable_name;
+    auto traced = traced_plots_.find(buffer_name);
+    if (traced != traced_plots_.end() &&
+        traced->second != painted_correlation_id_) {
+        painted_correlation_id_ = traced->second;
+        Tracer::instance().complete_span(
+            "first paint", traced->second, begin, Tracer::now());
     }
 }
 
@@ -125,7 +190,26 @@ bool MainWindow::is_window_ready()
 
 void MainWindow::loop()
 {
-    decode_incoming_messages();
+    // Close application if server has disconnected. Daemons wait for the
+    // next session instead.
+    if (!host_settings_.is_offline && !host_settings_.is_daemon &&
+        !network_worker_->is_connected()) {
+        QApplication::quit();
+    }
+
+    // Float copies of the received buffers are made by the network worker
+    if (network_worker_ != nullptr) {
+        network_worker_->set_int32_converted_to_float(
+            is_converted_to_float(BufferType::Int32));
+    }
+
+    // The buffers of a batch are only shown once all of them have arrived
+    if (is_receiving_plot_batch_) {
+        if (plot_batch_timer_.elapsed() < max_plot_batch_wait_ms) {
+            return;
+        }
+        is_receiving_plot_batch_ = false;
+    }
 
     if (completer_updated_) {
         // Update auto-complete suggestion list
@@ -133,23 +217,83 @@ void MainWindow::loop()
         completer_updated_ = false;
     }
 
+    // Stream pending buffer contents to the GPU
+    GLTextureStreamer* texture_streamer =
+        ui_->bufferPreview->get_texture_streamer();
+    if (texture_streamer->has_pending_uploads()) {
+        texture_streamer->process_pending_uploads();
+
+        request_render_update_ = true;
+    }
+
+    // Refresh the buffer icons without waiting for their readback
+    update_finished_icons();
+    repaint_outdated_icons();
+
+    // The buffer list is repainted once for all the buffers changed since
+    // the last iteration, such as those of a whole stop
+    buffer_list_->flush_changes();
+
     // Run update for current stage
     if (currently_selected_stage_ != nullptr) {
         currently_selected_stage_->update();
     }
 
+    // Lazy buffers are fetched around the region drawn last
+    for (Stage* stage : viewed_stages()) {
+        fetch_viewed_tiles(stage);
+    }
+
+    update_memory_usage_label();
+    update_comparison_widgets();
+
     if (request_render_update_) {
         // Update visualization pane
         ui_->bufferPreview->update();
 
         request_render_update_ = false;
     }
+
+    // Idle windows don't poll; the loop only runs again once an event
+    // requests it
+    if (!is_animating()) {
+        update_timer_.stop();
+    }
 }
 
 
 void MainWindow::request_render_update()
 {
     request_render_update_ = true;
+    schedule_loop();
+}
+
+
+void MainWindow::schedule_loop()
+{
+    if (!update_timer_.isActive()) {
+        update_timer_.start(static_cast<int>(1000.0 / render_framerate_));
+    }
+}
+
+
+bool MainWindow::is_animating()
+{
+    using Key = KeyboardState::Key;
+
+    // The camera keeps moving while its navigation keys are held
+    const bool is_camera_moving =
+        KeyboardState::is_modifier_key_pressed(
+            KeyboardState::ModifierKey::Control) &&
+        (KeyboardState::is_key_pressed(Key::Up) ||
+         KeyboardState::is_key_pressed(Key::Down) ||
+         KeyboardState::is_key_pressed(Key::Left) ||
+         KeyboardState::is_key_pressed(Key::Right));
+
+    return is_camera_moving || completer_updated_ ||
+           !outdated_icons_.empty() ||
+           ui_->bufferPreview->get_icon_readback()->has_pending_reads() ||
+           ui_->bufferPreview->get_texture_streamer()->has_pending_uploads();
 }
 
 
@@ -177,7 +321,7 @@ void MainWindow::persist_settings()
         const string buff_name_std_str = prev_buff.first.toStdString();
 
         const bool being_viewed =
-            held_buffers_.find(buff_name_std_str) != held_buffers_.end();
+            stages_.find(buff_name_std_str) != stages_.end();
         const bool was_removed =
             removed_buffer_names_.find(buff_name_std_str) !=
             removed_buffer_names_.end();
@@ -189,9 +333,15 @@ void MainWindow::persist_settings()
         }
     }
 
-    for (const auto& held_buffer : held_buffers_) {
+    for (const auto& stage : stages_) {
+        // Opened files can't be requested from the debugger bridge, and
+        // prefetched buffers weren't requested at all
+        if (buffer_files_.find(stage.first) != buffer_files_.end() ||
+            is_prefetched_buffer(stage.first)) {
+            continue;
+        }
         persisted_session_buffers.append(
-            BufferExpiration(held_buffer.first.c_str(), next_expiration));
+            BufferExpiration(stage.first.c_str(), next_expiration));
     }
 
     // Write default suffix for buffer export
@@ -200,6 +350,47 @@ void MainWindow::persist_settings()
     // Write maximum framerate
     settings.setValue("Rendering/maximum_framerate", render_framerate_);
 
+    // Write auto contrast percentiles
+    settings.setValue("Rendering/auto_contrast_lower_percentile",
+                      ac_percentiles_[0]);
+    settings.setValue("Rendering/auto_contrast_upper_percentile",
+                      ac_percentiles_[1]);
+
+    // Write level of detail reduction
+    settings.setValue("Rendering/lod_filter",
+                      lod_filter_ == DownsampleFilter::Extremum ? "extremum"
+                                                                : "average");
+
+    // Write pixel value label precision
+    settings.setValue("Rendering/value_label_precision",
+                      value_label_precision_);
+
+    // Write texture memory budget
+    settings.setValue("Rendering/texture_memory_budget",
+                      texture_memory_budget_);
+
+    // Write host memory budget
+    settings.setValue("Memory/host_budget", host_memory_budget_);
+
+    // Write buffer history settings
+    settings.setValue("History/versions", history_length_);
+    settings.setValue("History/memory_budget", history_memory_budget_);
+
+    // Write compression settings
+    settings.setValue("Transport/compression_codec",
+                      compression_settings_.codec == CompressionCodec::Zlib
+                          ? "zlib"
+                          : "none");
+    settings.setValue("Transport/compression_level",
+                      compression_settings_.level);
+    settings.setValue(
+        "Transport/compression_threshold",
+        static_cast<qulonglong>(compression_settings_.threshold));
+    settings.setValue("Transport/progressive_threshold",
+                      static_cast<qulonglong>(progressive_threshold_));
+    settings.setValue("Transport/lazy_threshold",
+                      static_cast<qulonglong>(lazy_threshold_));
+
     // Write previous session symbols
     settings.setValue("PreviousSession/buffers",
                       QVariant::fromValue(persisted_session_buffers));
@@ -218,22 +409,21 @@ void MainWindow::persist_settings()
 
 vec4 MainWindow::get_stage_coordinates(float pos_window_x, float pos_window_y)
 {
-    GameObject* cam_obj = currently_selected_stage_->get_game_object("camera");
-    Camera* cam         = cam_obj->get_component<Camera>("camera_component");
+    GameObject* cam_obj = currently_selected_stage_->get_camera_object();
+    Camera* cam         = currently_selected_stage_->get_camera_component();
 
-    GameObject* buffer_obj =
-        currently_selected_stage_->get_game_object("buffer");
-    Buffer* buffer = buffer_obj->get_component<Buffer>("buffer_component");
+    GameObject* buffer_obj = currently_selected_stage_->get_buffer_object();
+    Buffer* buffer         = currently_selected_stage_->get_buffer_component();
 
-    float win_w = ui_->bufferPreview->width();
-    float win_h = ui_->bufferPreview->height();
+    float win_w = ui_->bufferPreview->viewport_width();
+    float win_h = ui_->bufferPreview->viewport_height();
     vec4 mouse_pos_ndc(2.0f * (pos_window_x - win_w / 2) / win_w,
                        -2.0f * (pos_window_y - win_h / 2) / win_h,
                        0,
                        1);
-    mat4 view      = cam_obj->get_pose().inv();
+    mat4 view      = cam_obj->get_pose().affine_inv();
     mat4 buff_pose = buffer_obj->get_pose();
-    mat4 vp_inv    = (cam->projection * view * buff_pose).inv();
+    mat4 vp_inv    = (cam->projection * view * buff_pose).affine_inv();
 
     vec4 mouse_pos = vp_inv * mouse_pos_ndc;
     mouse_pos +=
@@ -248,13 +438,9 @@ void MainWindow::update_status_bar()
     if (currently_selected_stage_ != nullptr) {
         stringstream message;
 
-        GameObject* cam_obj =
-            currently_selected_stage_->get_game_object("camera");
-        Camera* cam = cam_obj->get_component<Camera>("camera_component");
+        Camera* cam = currently_selected_stage_->get_camera_component();
 
-        GameObject* buffer_obj =
-            currently_selected_stage_->get_game_object("buffer");
-        Buffer* buffer = buffer_obj->get_component<Buffer>("buffer_component");
+        Buffer* buffer = currently_selected_stage_->get_buffer_component();
 
         float mouse_x = ui_->bufferPreview->mouse_x();
         float mouse_y = ui_->bufferPreview->mouse_y();
@@ -267,10 +453,18 @@ void MainWindow::update_status_bar()
                 << cam->compute_zoom() * 100.0f << "%";
         message << " val=";
 
-        buffer->get_pixel_info(
-            message,
-            static_cast<int>(floor(mouse_pos.x())),
-            static_cast<int>(floor(mouse_pos.y())));
+        const int pixel_x = static_cast<int>(floor(mouse_pos.x()));
+        const int pixel_y = static_cast<int>(floor(mouse_pos.y()));
+
+        // Lazy buffers may only show an approximation of the pixel so far
+        buffer->get_pixel_info(message, pixel_x, pixel_y);
+        const string& buffer_name =
+            currently_selected_stage_->buffer_metadata.variable_name;
+        if (!fetch_pixel(buffer_name, pixel_x, pixel_y)) {
+            message << " [fetching]";
+        }
+
+        append_region_statistics(message);
 
         status_bar_->setText(message.str().c_str());
     }
@@ -298,6 +492,14 @@ string MainWindow::get_type_label(BufferType type, int channels)
         result << "int32";
     } else if (type == BufferType::Float64) {
         result << "float64";
+    } else if (type == BufferType::Float16) {
+        result << "float16";
+    } else if (type == BufferType::Int8) {
+        result << "int8";
+    } else if (type == BufferType::UInt32) {
+        result << "uint32";
+    } else if (type == BufferType::Bool) {
+        result << "bool";
     }
     result << "x" << channels;
 
@@ -311,8 +513,62 @@ void MainWindow::persist_settings_deferred()
 }
 
 
+const uint8_t* MainWindow::get_displayed_contents(const string& buffer_name,
+                                                  BufferMetadata& metadata,
+                                                  size_t& length)
+{
+    auto stage = stages_.find(buffer_name);
+    if (stage == stages_.end()) {
+        return nullptr;
+    }
+
+    const Buffer* buffer = stage->second->get_buffer_component();
+    if (buffer->buffer == nullptr) {
+        return nullptr;
+    }
+
+    metadata = displayed_metadata(stage->second->buffer_metadata);
+    if (metadata.type == BufferType::Float64) {
+        metadata.type = BufferType::Float32;
+    }
+
+    length = static_cast<size_t>(metadata.row_stride) *
+             static_cast<size_t>(metadata.height) *
+             static_cast<size_t>(metadata.channels) *
+             typesize(metadata.type);
+
+    return buffer->buffer;
+}
+
+
 void MainWindow::set_currently_selected_stage(Stage* stage)
 {
+    if (stage != nullptr) {
+        // A previous version shown in the deselected buffer is dropped
+        if (!history_buffer_name_.empty() &&
+            history_buffer_name_ != stage->buffer_metadata.variable_name) {
+            show_history_version(history_buffer_name_, 0);
+        }
+
+
+        stage->selection_order = ++selection_counter_;
+        restore_held_buffer(stage->buffer_metadata.variable_name);
+
+        // The buffer it is compared with is displayed along
+        auto comparison =
+            comparisons_.find(stage->buffer_metadata.variable_name);
+        if (comparison != comparisons_.end()) {
+            restore_held_buffer(comparison->second);
+        }
+    }
+
     currently_selected_stage_ = stage;
-    request_render_update_    = true;
+    show_in_active_view(stage);
+    report_displayed_buffers();
+    request_render_update();
+
+    update_timeline();
+    update_tensor_slice_widgets();
+
+    enforce_memory_budget();
 }
@@ -27,19 +27,39 @@
 #define MAIN_WINDOW_H_
 
 #include <deque>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <set>
+#include <sstream>
 #include <string>
+#include <vector>
 
+#include <QComboBox>
+#include <QDateTime>
+#include <QDockWidget>
+#include <QDoubleSpinBox>
+#include <QElapsedTimer>
 #include <QLabel>
-#include <QListWidgetItem>
+#include <QLocalServer>
 #include <QMainWindow>
+#include <QFile>
+#include <QPixmap>
+#include <QProgressBar>
+#include <QRect>
+#include <QSharedMemory>
+#include <QTableWidget>
 #include <QTimer>
-#include <QTcpSocket>
 
+#include "io/buffer_recorder.h"
+#include "io/recording_reader.h"
+#include "ipc/message_exchange.h"
 #include "math/linear_algebra.h"
+#include "system/memory/host_buffer_pool.h"
+#include "ui/buffer_list_model.h"
+#include "ui/buffer_history.h"
 #include "ui/go_to_widget.h"
+#include "ui/network_worker.h"
 #include "ui/symbol_completer.h"
 #include "visualization/stage.h"
 
@@ -51,7 +71,12 @@ class MainWindowUi;
 
 struct ConnectionSettings {
     std::string url;
+    // Zero if a daemon must wait for the first session to attach
     uint16_t port;
+    // Only buffer files are visualized, without a debugger bridge
+    bool is_offline = false;
+    // The window outlives the debugging sessions, which attach to it
+    bool is_daemon = false;
 };
 
 
@@ -86,6 +111,14 @@ class MainWindow : public QMainWindow
 
     void reset_ac_max_labels();
 
+    void update_ac_histogram();
+
+    ///
+    // Buffer files - implemented in buffer_files.cpp
+    // Lists recordings and exported buffers. They are only read once
+    // selected.
+    void open_buffer_files(const QStringList& paths);
+
     ///
     // General UI Events - implemented in ui_events.cpp
     void resize_callback(int w, int h);
@@ -96,6 +129,21 @@ class MainWindow : public QMainWindow
 
     void mouse_move_event(int mouse_x, int mouse_y);
 
+    ///
+    // Multiple views - implemented in view_layout.cpp
+    // Makes the view under the given canvas position the active one, and
+    // selects the buffer it shows
+    void select_view_at(int x, int y);
+
+    ///
+    // Region statistics - implemented in region_statistics.cpp
+    // Selects the region of the selected buffer under the rectangle between
+    // two positions of the active view, whose statistics are then shown in
+    // the status bar
+    void select_region(int x0, int y0, int x1, int y1);
+
+    void clear_region_selection();
+
     // Window change events - only called after the event is finished
     bool eventFilter(QObject* target, QEvent* event);
 
@@ -105,6 +153,10 @@ class MainWindow : public QMainWindow
 
     void closeEvent(QCloseEvent*);
 
+    void dragEnterEvent(QDragEnterEvent* event);
+
+    void dropEvent(QDropEvent* event);
+
 public Q_SLOTS:
     ///
     // Assorted methods - slots - implemented in main_window.cpp
@@ -134,8 +186,12 @@ public Q_SLOTS:
 
     void ac_max_reset();
 
+    void ac_fit_view();
+
     void ac_toggle();
 
+    void ac_edit_toggled(bool checked);
+
     ///
     // General UI Events - slots - implemented in ui_events.cpp
     void recenter_buffer();
@@ -146,7 +202,7 @@ public Q_SLOTS:
 
     void rotate_90_ccw();
 
-    void buffer_selected(QListWidgetItem* item);
+    void buffer_selected(const QModelIndex& index);
 
     void remove_selected_buffer();
 
@@ -162,15 +218,84 @@ public Q_SLOTS:
 
     void go_to_pixel(float x, float y);
 
+    ///
+    // Pixel search - slots - implemented in pixel_search.cpp
+    // Moves the view to the pixel found by the query given to the go-to
+    // widget
+    void search_pixel(const QString& query);
+
+    // Searches again with the last query, for its next pixel
+    void repeat_pixel_search();
+
+    ///
+    // Buffer recording - slots - implemented in recording.cpp
+    void toggle_buffer_recording();
+
+    ///
+    // Buffer comparison - slots - implemented in comparison.cpp
+    void compare_with_buffer();
+
+    void stop_comparing();
+
+    void comparison_mode_selected(int index);
+
+    void comparison_threshold_changed(double threshold);
+
+    ///
+    // Performance metrics - slots - implemented in performance.cpp
+    void toggle_performance_hud();
+
+    void toggle_metrics_panel();
+
+    ///
+    // Multiple views - slots - implemented in view_layout.cpp
+    // Splits the canvas into one, two or four views
+    void cycle_view_layout();
+
   private Q_SLOTS:
     ///
     // Assorted methods - private slots - implemented in main_window.cpp
     void persist_settings();
 
+    ///
+    // General UI Events - private slots - implemented in ui_events.cpp
+    void buffer_export_finished(QString file_name, bool succeeded);
+
+    ///
+    // Buffer files - private slots - implemented in buffer_files.cpp
+    // Shows the recording frame or previous version picked in the timeline
+    void timeline_position_selected(int position);
+
+    ///
+    // Communication with debugger bridge - private slots - implemented in
+    // message_processing.cpp
+    void decode_incoming_messages();
+
+    ///
+    // Tensor slices - private slots - implemented in tensor_slices.cpp
+    void tensor_axis_selected(int axis);
+
+    void tensor_slice_selected(int position);
+
+    ///
+    // Performance metrics - private slots - implemented in performance.cpp
+    void update_performance_metrics();
+
+    ///
+    // Window daemon - private slots - implemented in window_daemon.cpp
+    void accept_session_requests();
+
+    void read_session_request();
+
+    ///
+    // Symbol prefetch - private slots - implemented in prefetch.cpp
+    void prefetch_completions(const QStringList& completions);
+
   private:
     bool is_window_ready_;
     bool request_render_update_;
     bool completer_updated_;
+    bool is_receiving_plot_batch_;
     bool ac_enabled_;
     bool link_views_enabled_;
 
@@ -179,32 +304,204 @@ public Q_SLOTS:
 
     double render_framerate_;
 
+    // Time since the current batch of plots started arriving
+    QElapsedTimer plot_batch_timer_;
+
+    // Percentiles of the buffer values used as auto contrast bounds
+    float ac_percentiles_[2];
+
+    DownsampleFilter lod_filter_;
+
+    // Decimal digits of the pixel value labels, -1 for shortest round-trip
+    int value_label_precision_;
+
+    // Memory available to the buffer textures, in megabytes
+    int texture_memory_budget_;
+
+    // Memory available to the host copies of the buffers, in megabytes
+    int host_memory_budget_;
+
+    // Previous versions kept per buffer, 0 to keep none
+    int history_length_;
+
+    // Memory available to the previous versions of the buffers, in megabytes
+    int history_memory_budget_;
+
+    // Set while a buffer is replotted from its history, which must not be
+    // recorded as a new version
+    bool is_showing_history_;
+
+    uint64_t selection_counter_;
+
+    CompressionSettings compression_settings_;
+    // Buffers at least this large are sent as a preview first, with their
+    // full resolution tiles following. Zero disables it.
+    std::size_t progressive_threshold_;
+    // Buffers at least this large are fetched tile by tile as they are
+    // viewed. Zero disables it.
+    std::size_t lazy_threshold_;
+
     QTimer settings_persist_timer_;
     QTimer update_timer_;
+    // Refreshes the performance overlay and the metrics panel while shown
+    QTimer metrics_timer_;
 
     QString default_export_suffix_;
 
+    // Last query typed in the go-to widget, repeated with F3
+    QString last_pixel_search_;
+
+    // Region selected in the buffer, in buffer coordinates, and the buffer
+    // it was selected in
+    QRect selected_region_;
+    std::string selected_region_buffer_;
+
     Stage* currently_selected_stage_;
 
-    std::map<std::string, std::vector<uint8_t>> held_buffers_;
+    // The canvas is split into a grid of views, each showing a buffer, all
+    // drawn in the same frame from the same textures. The active view shows
+    // the selected buffer, and views without a buffer have an empty name.
+    int view_columns_;
+    int view_rows_;
+    int active_view_;
+    std::vector<std::string> view_buffers_;
+    // Displayed buffers last reported to the bridge, the selected one first
+    std::vector<std::string> reported_displayed_buffers_;
+
+    // Host copies of the buffers, allocated from the host buffer pool
+    std::map<std::string, HostBuffer> held_buffers_;
+    std::map<std::string, std::unique_ptr<QSharedMemory>> shared_buffers_;
+    // Recordings and exported buffers opened from disk. They are keyed by
+    // their path, aren't debugger symbols, and are mapped for as long as
+    // they are visualized.
+    struct BufferFile
+    {
+        enum class Format { NumpyArray, OctaveMatrix, Recording };
+
+        Format format;
+        QString path;
+        std::unique_ptr<QFile> file;
+        RecordingReader recording;
+        std::size_t frame;
+    };
+    std::map<std::string, BufferFile> buffer_files_;
+    // Buffers whose updates are being appended to a recording file
+    std::map<std::string, std::unique_ptr<BufferRecorder>> recorders_;
+    // Previous versions of the buffers received from the debugger
+    std::map<std::string, BufferHistory> histories_;
+    // Reference buffer of each buffer displayed as a difference
+    std::map<std::string, std::string> comparisons_;
+    Buffer::CompareMode compare_mode_;
+    // Buffer showing a previous version, if any, and its contents
+    std::string history_buffer_name_;
+    std::vector<uint8_t> history_contents_;
+
+    // Host copies of unselected buffers, compressed to stay under the host
+    // memory budget. Their stages don't reference them until restored.
+    struct CompressedBuffer
+    {
+        CompressionCodec codec;
+        std::size_t length;
+        std::vector<uint8_t> contents;
+        // Incompressible copies are kept as they are
+        HostBuffer uncompressed;
+    };
+    std::map<std::string, CompressedBuffer> compressed_buffers_;
+    // Buffers shown from a preview, and the number of full resolution tiles
+    // still to come
+    std::map<std::string, std::size_t> refining_buffers_;
+    // Buffers too large to be sent at once, whose tiles are fetched from
+    // the bridge as they are viewed. Levels are those of LOD tiles, and
+    // are unfetched_tile_level until a tile is requested.
+    struct LazyBuffer
+    {
+        std::vector<int> tile_levels;
+        std::vector<int> requested_levels;
+    };
+    std::map<std::string, LazyBuffer> lazy_buffers_;
+    // Slices of the tensor buffers viewed since the last stop, most recently
+    // viewed first, and the axis scrolled through in the window. Cached
+    // slices are shown again without a round trip to the debugger.
+    struct TensorSlice
+    {
+        BufferMetadata metadata;
+        std::vector<uint8_t> contents;
+    };
+    struct TensorSlices
+    {
+        int axis = 0;
+        std::deque<TensorSlice> cached;
+    };
+    std::map<std::string, TensorSlices> tensor_slices_;
+    // Buffers whose plot was dropped as superseded by a newer stop, and
+    // whether they were requested again. Deltas the bridge based on the
+    // dropped contents can't be applied until the buffer is sent in full.
+    std::map<std::string, bool> superseded_buffers_;
+    // Correlation id of the last traced plot of each buffer, and of the
+    // last one painted
+    std::map<std::string, std::uint64_t> traced_plots_;
+    std::uint64_t painted_correlation_id_;
+    // Last time each buffer was plotted
+    std::map<std::string, QDateTime> buffer_update_times_;
     std::map<std::string, std::shared_ptr<Stage>> stages_;
+    // Buffers plotted ahead of being requested, while their name is typed
+    // in the symbol search box, the oldest first. Their stages are listed
+    // once they are requested, and are evicted at the next stop.
+    std::deque<std::string> prefetched_buffers_;
 
     std::set<std::string> previous_session_buffers_;
     std::set<std::string> removed_buffer_names_;
+    // Buffers whose icons must be rendered again. Buffers updated several
+    // times before the next frame get a single icon refresh.
+    std::set<std::string> outdated_icons_;
+
+    // Exports being encoded and written in the background, each from its
+    // own copy of the buffer contents
+    std::vector<std::future<void>> pending_exports_;
+    int running_exports_;
 
     QStringList available_vars_;
+    // Version of available_vars_ in the bridge's symbol update sequence
+    size_t available_vars_version_;
+
+    // Time from the last debugger stop being announced to its buffers being
+    // displayed, with all their textures uploaded
+    QElapsedTimer stop_timer_;
+    bool is_stop_displayed_;
+    bool has_stop_batch_ended_;
+    qint64 stop_display_latency_ms_;
+
+    // Transfer counters at the last metrics refresh, from which the rates
+    // are computed
+    QElapsedTimer metrics_interval_timer_;
+    std::uint64_t metered_uploaded_bytes_;
+    std::uint64_t metered_received_bytes_;
 
     std::mutex ui_mutex_;
 
     SymbolCompleter* symbol_completer_;
 
+    // Model of the buffer list in the left pane
+    BufferListModel* buffer_list_;
+
     Ui::MainWindowUi* ui_;
 
     QLabel* status_bar_;
+    QLabel* memory_usage_label_;
+    QProgressBar* export_progress_bar_;
+    QComboBox* compare_mode_box_;
+    QDoubleSpinBox* compare_threshold_box_;
+    QLabel* compare_errors_label_;
     GoToWidget* go_to_widget_;
+    QDockWidget* metrics_dock_;
+    QTableWidget* metrics_table_;
 
     ConnectionSettings host_settings_;
-    QTcpSocket socket_;
+    // Connection to the bridge, absent in offline sessions. Replaced at each
+    // session attached to a daemon.
+    std::unique_ptr<NetworkWorker> network_worker_;
+    // Where debugging sessions attach to a daemon
+    QLocalServer* session_server_;
 
     ///
     // Assorted methods - private - implemented in main_window.cpp
@@ -220,24 +517,266 @@ public Q_SLOTS:
 
     vec4 get_stage_coordinates(float pos_window_x, float pos_window_y);
 
+    // Starts the update loop if it is not already running
+    void schedule_loop();
+
+    // Whether the loop must keep running without further events
+    bool is_animating();
+
+    // Contents of the buffer as uploaded to its stage, in which Float64
+    // buffers have been converted to floats. Returns nullptr if the stage
+    // has no contents.
+    const uint8_t* get_displayed_contents(const std::string& buffer_name,
+                                          BufferMetadata& metadata,
+                                          std::size_t& length);
+
     ///
     // Communication with debugger bridge
-    void decode_set_available_symbols();
+    void decode_set_available_symbols(MessageDecoder& message_decoder);
+
+    void decode_update_available_symbols(MessageDecoder& message_decoder);
 
     void respond_get_observed_symbols();
 
-    void decode_plot_buffer_contents();
+    // Drops the plots of the previous stops which have not been uploaded
+    // yet, and the deltas based on them. Returns whether it was dropped.
+    bool drop_superseded_plot(const ReceivedMessage& message);
 
-    void decode_incoming_messages();
+    void decode_plot_buffer_contents(ReceivedMessage& message);
+
+    void hold_buffer_contents(const BufferMetadata& metadata,
+                              HostBuffer&& buff_contents);
+
+    void decode_plot_buffer_shared_contents(MessageDecoder& message_decoder);
+
+    void decode_plot_buffer_tiles(MessageDecoder& message_decoder);
+
+    void decode_plot_buffer_shared_tiles(MessageDecoder& message_decoder);
+
+    void decode_plot_buffer_unchanged(MessageDecoder& message_decoder);
+
+    void decode_plot_buffer_batch(MessageDecoder& message_decoder);
+
+    void decode_plot_buffer_preview(MessageDecoder& message_decoder);
+
+    void plot_buffer(const BufferMetadata& metadata, const uint8_t* buffer);
+
+    // Adds the buffer to the buffer list, or updates its label
+    QModelIndex list_buffer(const BufferMetadata& metadata);
+
+    // Whether all the contents of the buffer have arrived, so that it can
+    // be recorded as a new version
+    bool is_buffer_complete(const std::string& buffer_name) const;
+
+    void plot_buffer_regions(const BufferMetadata& metadata,
+                             const std::vector<BufferRegion>& regions);
+
+    // Whether buffers of the given type are displayed from a float copy
+    bool is_converted_to_float(BufferType type);
+
+    BufferMetadata displayed_metadata(const BufferMetadata& metadata);
+
+    void request_buffer_icon(const std::string& buffer_name);
+
+    // Queues the icon of a buffer shown by the buffer list to be rendered.
+    // Returns false if the buffer has no stage to render it from.
+    bool queue_buffer_icon(const std::string& buffer_name);
+
+    void repaint_outdated_icons();
+
+    void update_finished_icons();
+
+    void send_transport_settings();
 
     void request_plot_buffer(const char* buffer_name);
 
+    ///
+    // Lazy buffers - private - implemented in lazy_buffers.cpp
+    void decode_plot_buffer_lazy(MessageDecoder& message_decoder);
+
+    void decode_plot_buffer_level_tiles(MessageDecoder& message_decoder);
+
+    // Requests the tiles of the buffer in view, at the level they are
+    // displayed at
+    void fetch_viewed_tiles(Stage* stage);
+
+    // Requests the tile of a pixel at full resolution. Returns whether its
+    // value is already known.
+    bool fetch_pixel(const std::string& buffer_name, int x, int y);
+
+    void request_buffer_tiles(const std::string& buffer_name,
+                              int level,
+                              const std::vector<int>& tiles);
+
+    std::size_t lazy_buffer_memory_usage(const LazyBuffer& lazy_buffer,
+                                         std::size_t length) const;
+
+    ///
+    // Tensor slices - private - implemented in tensor_slices.cpp
+    // Keeps the slice displayed by a tensor buffer for when it is selected
+    // again
+    void cache_tensor_slice(const std::string& buffer_name);
+
+    // Drops the cached slices, once the debugger stops again
+    void clear_tensor_slices();
+
+    // Shows the slice of the tensor buffer at the given index, from the
+    // cache if possible, and has the bridge read it from then on
+    void select_tensor_slice(const std::string& buffer_name,
+                             const std::vector<int>& tensor_index);
+
+    void request_tensor_slice(const std::string& buffer_name,
+                              const std::vector<int>& tensor_index,
+                              bool is_cached);
+
+    // Shows the slice selector of the selected buffer, if it is a tensor
+    void update_tensor_slice_widgets();
+
+    ///
+    // Symbol prefetch - private - implemented in prefetch.cpp
+    bool is_prefetched_buffer(const std::string& buffer_name) const;
+
+    // Lists and selects the prefetched buffer, unless it hasn't arrived yet
+    bool show_prefetched_buffer(const std::string& buffer_name);
+
+    // Evicts the prefetched buffers exceeding their budget, the oldest first
+    void enforce_prefetch_budget();
+
+    // Evicts all prefetched buffers, once the debugger stops again
+    void evict_prefetched_buffers();
+
+    ///
+    // General UI Events - private - implemented in ui_events.cpp
+    // Drops everything held for the buffer, whose list item is removed by
+    // the caller
+    void forget_buffer(const std::string& buffer_name);
+
     ///
     // Auto contrast pane - private - implemented in auto_contrast.cpp
     void set_ac_min_value(int idx, float value);
 
     void set_ac_max_value(int idx, float value);
 
+    ///
+    // Memory budget - private - implemented in memory_budget.cpp
+    void enforce_memory_budget();
+
+    void compress_held_buffer(const std::string& buffer_name);
+
+    void restore_held_buffer(const std::string& buffer_name);
+
+    std::size_t host_memory_usage() const;
+
+    // Host memory taken by the contents of a single buffer, whether held,
+    // compressed or shared
+    std::size_t buffer_host_memory_usage(const std::string& buffer_name) const;
+
+    void update_memory_usage_label();
+
+    ///
+    // Performance metrics - private - implemented in performance.cpp
+    // Starts measuring the latency of a debugger stop
+    void begin_stop_latency();
+
+    // Completes the latency of the last stop once it is fully displayed
+    void update_stop_latency();
+
+    void update_metrics_panel();
+
+    ///
+    // Window daemon - private - implemented in window_daemon.cpp
+    void initialize_window_daemon();
+
+    // Replaces the connection to the bridge, and connects it unless port is
+    // zero
+    void connect_to_bridge(const std::string& url, std::uint16_t port);
+
+    // Drops the buffers of the previous session, which are plotted again
+    // once the new one has them available
+    void reset_session();
+
+    ///
+    // Multiple views - private - implemented in view_layout.cpp
+    // Region of the canvas covered by a view, in widget coordinates
+    QRect view_rect(int view) const;
+
+    // Stages shown in the views, the active one first
+    std::vector<Stage*> viewed_stages();
+
+    // Sizes the cameras of all stages to the views, which are all alike
+    void resize_views();
+
+    void draw_views();
+
+    // Shows the selected stage in the active view
+    void show_in_active_view(Stage* stage);
+
+    // Aligns the cameras of the views with the one of the active view
+    void sync_linked_views();
+
+    // Whether the buffer is shown in a view, or compared with one that is
+    bool is_buffer_displayed(const std::string& buffer_name) const;
+
+    void forget_viewed_buffer(const std::string& buffer_name);
+
+    // Tells the bridge which buffers are displayed if they changed, so that
+    // it plots them before any other at the next stop
+    void report_displayed_buffers();
+
+    ///
+    // Region statistics - private - implemented in region_statistics.cpp
+    // Appends the mean, deviation and bounds of the selected region to the
+    // status bar message, if it belongs to the selected buffer
+    void append_region_statistics(std::stringstream& message);
+
+    ///
+    // Buffer recording - private - implemented in recording.cpp
+    // Appends the current contents of the buffer to its recording, if any
+    void record_buffer_frame(const std::string& buffer_name);
+
+    ///
+    // Buffer comparison - private - implemented in comparison.cpp
+    // Sends the comparison settings to the buffer component
+    void apply_comparison(const std::string& buffer_name);
+
+    // Stops the comparisons involving the buffer, before it is removed
+    void forget_comparisons_with(const std::string& buffer_name);
+
+    // Shows the comparison settings and errors of the selected buffer
+    void update_comparison_widgets();
+
+    ///
+    // Buffer history - private - implemented in history.cpp
+    // Adds the current contents of the buffer as its latest version
+    void push_buffer_history(const std::string& buffer_name);
+
+    // Shows a previous version of the buffer, 0 returning to the latest
+    void show_history_version(const std::string& buffer_name,
+                              std::size_t version);
+
+    // Drops the oldest versions until the histories fit in their budget
+    void enforce_history_budget();
+
+    ///
+    // Buffer files - private - implemented in buffer_files.cpp
+    bool is_buffer_file(const QString& path) const;
+
+    void open_buffer_file(const QString& path);
+
+    // Maps the file of a listed buffer, and creates or updates its stage
+    bool load_buffer_file(const std::string& buffer_name);
+
+    bool plot_recording_frame(const std::string& buffer_name,
+                              std::size_t frame);
+
+    void plot_buffer_file_contents(const BufferMetadata& metadata,
+                                   const uint8_t* contents,
+                                   std::size_t length);
+
+    // Shows the timeline of the selected buffer, if it is a recording or has
+    // previous versions
+    void update_timeline();
+
     ///
     // Initialization - private - implemented in initialization.cpp
     void initialize_ui_icons();
@@ -262,6 +801,8 @@ public Q_SLOTS:
 
     void initialize_go_to_widget();
 
+    void initialize_metrics_panel();
+
     void initialize_networking();
 };
 
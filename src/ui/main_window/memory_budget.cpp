@@ -0,0 +1,276 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <iostream>
+
+#include <QString>
+
+#include "main_window.h"
+
+#include "ipc/compression.h"
+#include "ui_main_window.h"
+#include "ui/gl_tile_residency.h"
+#include "visualization/game_object.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+Buffer* get_buffer_component(Stage* stage)
+{
+    return stage->get_buffer_component();
+}
+
+
+QString format_megabytes(size_t bytes)
+{
+    return QString::number(static_cast<double>(bytes) / (1 << 20), 'f', 0);
+}
+
+} // namespace
+
+
+void MainWindow::enforce_memory_budget()
+{
+    // Host copies of the least recently selected buffers are compressed
+    // until they fit in the budget. Buffers mapped from shared memory are
+    // owned by the debugger bridge and can't be released.
+    const size_t host_budget = static_cast<size_t>(host_memory_budget_) << 20;
+
+    enforce_prefetch_budget();
+
+    // Blocks cached for reuse are given up first
+    if (host_memory_usage() > host_budget) {
+        HostBufferPool::instance().trim();
+    }
+
+    while (host_memory_usage() > host_budget) {
+        const string* released_name = nullptr;
+        uint64_t released_order     = 0;
+
+        for (const auto& stage : stages_) {
+            // Lazy buffers would lose the tiles fetched so far
+            if (is_buffer_displayed(stage.first) ||
+                held_buffers_.find(stage.first) == held_buffers_.end() ||
+                lazy_buffers_.find(stage.first) != lazy_buffers_.end()) {
+                continue;
+            }
+
+            if (released_name == nullptr ||
+                stage.second->selection_order < released_order) {
+                released_name  = &stage.first;
+                released_order = stage.second->selection_order;
+            }
+        }
+
+        if (released_name == nullptr) {
+            break;
+        }
+
+        compress_held_buffer(*released_name);
+    }
+
+    // Buffers out of view give their textures up when the viewed ones
+    // couldn't be fully resident otherwise, instead of having their tiles
+    // evicted one at a time as they become visible
+    const vector<Stage*> viewed = viewed_stages();
+    if (viewed.empty()) {
+        return;
+    }
+
+    GLTileResidency* residency = ui_->bufferPreview->get_tile_residency();
+    size_t viewed_size = 0;
+    for (Stage* stage : viewed) {
+        viewed_size += get_buffer_component(stage)->texture_memory_size();
+    }
+
+    if (residency->resident_size() + viewed_size > residency->budget()) {
+        for (const auto& stage : stages_) {
+            if (!is_buffer_displayed(stage.first)) {
+                get_buffer_component(stage.second.get())
+                    ->release_resident_tiles();
+            }
+        }
+    }
+}
+
+
+void MainWindow::compress_held_buffer(const string& buffer_name)
+{
+    auto held_buffer = held_buffers_.find(buffer_name);
+    auto stage       = stages_.find(buffer_name);
+    if (held_buffer == held_buffers_.end() || stage == stages_.end()) {
+        return;
+    }
+
+    // The textures can no longer be uploaded from the host copy, so they
+    // are released with it. The buffer icon is kept.
+    Buffer* buffer = get_buffer_component(stage->second.get());
+    buffer->release_resident_tiles();
+    buffer->buffer = nullptr;
+    outdated_icons_.erase(buffer_name);
+
+    CompressedBuffer& compressed = compressed_buffers_[buffer_name];
+    compressed.length            = held_buffer->second.size();
+
+    const CompressionSettings settings{CompressionCodec::Zlib, 1, 0};
+    if (compress_block(held_buffer->second.data(),
+                       compressed.length,
+                       settings,
+                       compressed.contents)) {
+        compressed.codec = CompressionCodec::Zlib;
+    } else {
+        // Incompressible contents are kept as they are, so that the buffer
+        // isn't picked again
+        compressed.codec        = CompressionCodec::None;
+        compressed.uncompressed = std::move(held_buffer->second);
+    }
+
+    held_buffers_.erase(held_buffer);
+}
+
+
+void MainWindow::restore_held_buffer(const string& buffer_name)
+{
+    auto compressed = compressed_buffers_.find(buffer_name);
+    auto stage      = stages_.find(buffer_name);
+    if (compressed == compressed_buffers_.end() || stage == stages_.end()) {
+        return;
+    }
+
+    HostBuffer& held_buffer = held_buffers_[buffer_name];
+
+    if (compressed->second.codec == CompressionCodec::None) {
+        held_buffer = std::move(compressed->second.uncompressed);
+    } else {
+        held_buffer.resize(compressed->second.length);
+        if (!decompress_block(compressed->second.codec,
+                              compressed->second.contents.data(),
+                              compressed->second.contents.size(),
+                              held_buffer.data(),
+                              held_buffer.size())) {
+            cerr << "[OpenImageDebugger] Could not restore contents of buffer "
+                 << buffer_name << endl;
+
+            // The bridge sends the buffer again
+            held_buffers_.erase(buffer_name);
+            compressed_buffers_.erase(compressed);
+            request_plot_buffer(buffer_name.c_str());
+            return;
+        }
+    }
+
+    compressed_buffers_.erase(compressed);
+
+    // The tiles are uploaded again as they become visible
+    get_buffer_component(stage->second.get())->buffer = held_buffer.data();
+}
+
+
+size_t MainWindow::host_memory_usage() const
+{
+    size_t usage = 0;
+
+    for (const auto& held_buffer : held_buffers_) {
+        auto lazy_buffer = lazy_buffers_.find(held_buffer.first);
+        if (lazy_buffer != lazy_buffers_.end()) {
+            usage += lazy_buffer_memory_usage(lazy_buffer->second,
+                                              held_buffer.second.size());
+        } else {
+            usage += held_buffer.second.size();
+        }
+    }
+
+    for (const auto& compressed : compressed_buffers_) {
+        usage += compressed.second.contents.size() +
+                 compressed.second.uncompressed.size();
+    }
+
+    for (const auto& segment : shared_buffers_) {
+        usage += static_cast<size_t>(segment.second->size());
+    }
+
+    return usage;
+}
+
+
+size_t MainWindow::buffer_host_memory_usage(const string& buffer_name) const
+{
+    size_t usage = 0;
+
+    auto held_buffer = held_buffers_.find(buffer_name);
+    if (held_buffer != held_buffers_.end()) {
+        auto lazy_buffer = lazy_buffers_.find(buffer_name);
+        usage += lazy_buffer != lazy_buffers_.end()
+                     ? lazy_buffer_memory_usage(lazy_buffer->second,
+                                                held_buffer->second.size())
+                     : held_buffer->second.size();
+    }
+
+    auto compressed = compressed_buffers_.find(buffer_name);
+    if (compressed != compressed_buffers_.end()) {
+        usage += compressed->second.contents.size() +
+                 compressed->second.uncompressed.size();
+    }
+
+    auto segment = shared_buffers_.find(buffer_name);
+    if (segment != shared_buffers_.end()) {
+        usage += static_cast<size_t>(segment->second->size());
+    }
+
+    return usage;
+}
+
+
+void MainWindow::update_memory_usage_label()
+{
+    const GLTileResidency* residency =
+        ui_->bufferPreview->get_tile_residency();
+
+    const size_t host_budget = static_cast<size_t>(host_memory_budget_) << 20;
+
+    memory_usage_label_->setText(
+        QString("Host %1/%2 MB  GPU %3/%4 MB")
+            .arg(format_megabytes(host_memory_usage()))
+            .arg(format_megabytes(host_budget))
+            .arg(format_megabytes(residency->resident_size()))
+            .arg(format_megabytes(residency->budget())));
+
+    const HostBufferPoolStats pool = HostBufferPool::instance().stats();
+    memory_usage_label_->setToolTip(
+        QString("Memory used by the buffers, and the budgets beyond which "
+                "the unselected buffers are released\n"
+                "Host buffer pool: %1 MB in use, %2 MB cached, "
+                "%3 MB on huge pages\n"
+                "%4 allocations, %5 reused")
+            .arg(format_megabytes(pool.used_bytes))
+            .arg(format_megabytes(pool.cached_bytes))
+            .arg(format_megabytes(pool.huge_page_bytes))
+            .arg(pool.allocations)
+            .arg(pool.reuses));
+}
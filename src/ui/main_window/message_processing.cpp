@@ -25,16 +25,25 @@
 
 #include "main_window.h"
 
+#include <QSet>
+
 #include "ui_main_window.h"
+#include "ipc/buffer_tiles.h"
+#include "math/downsample.h"
+#include "math/float_conversion.h"
+#include "system/trace/tracer.h"
+#include "ui/gl_icon_readback.h"
 
 using namespace std;
 
 
-void MainWindow::decode_set_available_symbols()
+void MainWindow::decode_set_available_symbols(
+    MessageDecoder& message_decoder)
 {
     std::unique_lock<std::mutex> lock(ui_mutex_);
-    MessageDecoder message_decoder(&socket_);
+    available_vars_.clear();
     message_decoder.read<QStringList, QString>(available_vars_);
+    available_vars_version_ = 0;
 
     for (const auto& symbol_value : available_vars_) {
         // Plot buffer if it was available in the previous session
@@ -45,62 +54,276 @@ void MainWindow::decode_set_available_symbols()
     }
 
     completer_updated_ = true;
+    schedule_loop();
+}
+
+
+void MainWindow::decode_update_available_symbols(
+    MessageDecoder& message_decoder)
+{
+    size_t base_version;
+    size_t version;
+    QStringList removed_symbols;
+    QStringList added_symbols;
+    message_decoder.read(base_version)
+        .read(version)
+        .read<QStringList, QString>(removed_symbols)
+        .read<QStringList, QString>(added_symbols);
+
+    // Same frame as the previous stop: nothing to rebuild
+    if (base_version == version && removed_symbols.isEmpty() &&
+        added_symbols.isEmpty()) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(ui_mutex_);
+
+    const bool is_consistent = base_version == available_vars_version_;
+    if (!is_consistent) {
+        cerr << "[OpenImageDebugger] Symbol update " << version
+             << " expected version " << base_version << " but version "
+             << available_vars_version_ << " is loaded" << endl;
+    }
+
+    if (base_version == 0) {
+        available_vars_.clear();
+    } else if (!removed_symbols.isEmpty()) {
+        const QSet<QString> removed_set = removed_symbols.toSet();
+        QStringList kept_symbols;
+        kept_symbols.reserve(available_vars_.size());
+        for (const auto& symbol_value : available_vars_) {
+            if (!removed_set.contains(symbol_value)) {
+                kept_symbols.append(symbol_value);
+            }
+        }
+        available_vars_.swap(kept_symbols);
+    }
+
+    available_vars_.append(added_symbols);
+    if (!is_consistent) {
+        available_vars_.removeDuplicates();
+    }
+    available_vars_version_ = version;
+
+    for (const auto& symbol_value : added_symbols) {
+        // Plot buffer if it was available in the previous session
+        if (previous_session_buffers_.find(symbol_value.toStdString()) !=
+            previous_session_buffers_.end()) {
+            request_plot_buffer(symbol_value.toStdString().data());
+        }
+    }
+
+    completer_updated_ = true;
+    schedule_loop();
 }
 
 
 void MainWindow::respond_get_observed_symbols()
 {
+    // Buffer files can't be fetched by the bridge, and prefetched buffers
+    // aren't observed until requested
+    vector<string> observed_symbols;
+    for (const auto& name : stages_) {
+        if (buffer_files_.find(name.first) == buffer_files_.end() &&
+            !is_prefetched_buffer(name.first)) {
+            observed_symbols.push_back(name.first);
+        }
+    }
+
     MessageComposer message_composer;
     message_composer.push(MessageType::GetObservedSymbolsResponse)
-        .push(held_buffers_.size());
-    for (const auto& name : held_buffers_) {
-        message_composer.push(name.first);
+        .push(observed_symbols.size());
+    for (const auto& name : observed_symbols) {
+        message_composer.push(name);
     }
-    message_composer.send(&socket_);
+    network_worker_->send(message_composer);
 }
 
 
-void MainWindow::decode_plot_buffer_contents()
+bool MainWindow::drop_superseded_plot(const ReceivedMessage& message)
 {
-    // Buffer icon dimensions
-    QSizeF icon_size         = get_icon_size();
-    int icon_width           = static_cast<int>(icon_size.width());
-    int icon_height          = static_cast<int>(icon_size.height());
-    const int bytes_per_line = icon_width * 3;
-
-    // Read buffer info
-    string variable_name_str;
-    string display_name_str;
-    string pixel_layout_str;
-    bool transpose_buffer;
-    int buff_width;
-    int buff_height;
-    int buff_channels;
-    int buff_stride;
-    BufferType buff_type;
-    vector<uint8_t> buff_contents;
-
-    MessageDecoder message_decoder(&socket_);
-    message_decoder.read(variable_name_str)
-        .read(display_name_str)
-        .read(pixel_layout_str)
-        .read(transpose_buffer)
-        .read(buff_width)
-        .read(buff_height)
-        .read(buff_channels)
-        .read(buff_stride)
-        .read(buff_type)
-        .read(buff_contents);
+    bool is_full_plot;
+    switch (message.type) {
+    case MessageType::PlotBufferContents:
+    case MessageType::PlotBufferCompressedContents:
+    case MessageType::PlotBufferSharedContents:
+    case MessageType::PlotBufferPreview:
+    case MessageType::PlotBufferLazy:
+        is_full_plot = true;
+        break;
+    case MessageType::PlotBufferTiles:
+    case MessageType::PlotBufferSharedTiles:
+    case MessageType::PlotBufferUnchanged:
+        is_full_plot = false;
+        break;
+    default:
+        return false;
+    }
 
-    auto buffer_stage = stages_.find(variable_name_str);
+    string buffer_name;
+    if (message.is_decoded_plot) {
+        buffer_name = message.metadata.variable_name;
+    } else {
+        MessageDecoder message_decoder(message.body.data(),
+                                       message.body.size());
+        if (message.type == MessageType::PlotBufferUnchanged) {
+            message_decoder.read(buffer_name);
+        } else {
+            BufferMetadata metadata;
+            message_decoder.read(metadata);
+            buffer_name = metadata.variable_name;
+        }
+    }
+
+    // The current stop plots the buffer again, so its contents would only
+    // be uploaded to be replaced. Unchanged buffers carry no contents.
+    if (message.stop_generation < network_worker_->stop_generation() &&
+        message.type != MessageType::PlotBufferUnchanged) {
+        superseded_buffers_.emplace(buffer_name, false);
+        return true;
+    }
+
+    auto superseded = superseded_buffers_.find(buffer_name);
+    if (superseded == superseded_buffers_.end()) {
+        return false;
+    }
+
+    if (is_full_plot) {
+        superseded_buffers_.erase(superseded);
+        return false;
+    }
+
+    if (!superseded->second) {
+        superseded->second = true;
+        request_plot_buffer(buffer_name.c_str());
+    }
+
+    return true;
+}
+
+
+void MainWindow::decode_plot_buffer_contents(ReceivedMessage& message)
+{
+    const BufferMetadata& metadata = message.metadata;
+
+    if (message.type == MessageType::PlotBufferCompressedContents &&
+        message.contents.empty()) {
+        cerr << "[OpenImageDebugger] Could not decompress contents of buffer "
+             << metadata.variable_name << endl;
+        return;
+    }
+
+    refining_buffers_.erase(metadata.variable_name);
+    lazy_buffers_.erase(metadata.variable_name);
+
+    // The worker may have decoded the buffer before the texture formats
+    // supported by the canvas were known
+    if (message.is_float_copy != is_converted_to_float(metadata.type)) {
+        if (message.is_float_copy) {
+            request_plot_buffer(metadata.variable_name.c_str());
+            return;
+        }
+
+        message.contents = make_float_buffer(
+            message.contents.data(), metadata.type, message.contents.size());
+    }
+
+    hold_buffer_contents(metadata, std::move(message.contents));
+}
 
-    if (buff_type == BufferType::Float64) {
-        held_buffers_[variable_name_str] =
-            make_float_buffer_from_double(buff_contents);
+
+void MainWindow::hold_buffer_contents(const BufferMetadata& metadata,
+                                      HostBuffer&& buff_contents)
+{
+    // The new contents replace any compressed copy of the buffer
+    compressed_buffers_.erase(metadata.variable_name);
+
+    // The replaced contents go back to the pool, where the next update of
+    // the buffer picks them up again
+    HostBuffer& held_buffer = held_buffers_[metadata.variable_name];
+    held_buffer.swap(buff_contents);
+    buff_contents.clear();
+
+    plot_buffer(displayed_metadata(metadata), held_buffer.data());
+
+    // The stage no longer references a previously mapped segment
+    shared_buffers_.erase(metadata.variable_name);
+
+    enforce_memory_budget();
+}
+
+
+void MainWindow::decode_plot_buffer_shared_contents(
+    MessageDecoder& message_decoder)
+{
+    BufferMetadata metadata;
+    string segment_key;
+    size_t buff_length;
+
+    message_decoder.read(metadata).read(segment_key).read(buff_length);
+
+    // Reuse the current mapping if the bridge wrote into the same segment
+    unique_ptr<QSharedMemory> segment;
+    auto held_segment = shared_buffers_.find(metadata.variable_name);
+    if (held_segment != shared_buffers_.end() &&
+        held_segment->second->key().toStdString() == segment_key) {
+        segment = std::move(held_segment->second);
+    } else {
+        segment.reset(new QSharedMemory(segment_key.c_str()));
+        if (!segment->attach(QSharedMemory::ReadOnly)) {
+            cerr << "[OpenImageDebugger] Could not attach to shared buffer "
+                 << segment_key << ": "
+                 << segment->errorString().toStdString() << endl;
+            return;
+        }
+    }
+
+    compressed_buffers_.erase(metadata.variable_name);
+    refining_buffers_.erase(metadata.variable_name);
+    lazy_buffers_.erase(metadata.variable_name);
+
+    segment->lock();
+
+    const uint8_t* buff_contents =
+        reinterpret_cast<const uint8_t*>(segment->constData());
+
+    if (is_converted_to_float(metadata.type)) {
+        // These buffers are displayed from a float copy owned by the UI. The
+        // segment stays mapped, as later tile updates are patched into it.
+        HostBuffer& held_buffer = held_buffers_[metadata.variable_name];
+        held_buffer =
+            make_float_buffer(buff_contents, metadata.type, buff_length);
+
+        plot_buffer(displayed_metadata(metadata), held_buffer.data());
     } else {
-        held_buffers_[variable_name_str] = std::move(buff_contents);
+        plot_buffer(metadata, buff_contents);
+        held_buffers_.erase(metadata.variable_name);
     }
 
+    segment->unlock();
+
+    shared_buffers_[metadata.variable_name] = std::move(segment);
+
+    enforce_memory_budget();
+}
+
+
+void MainWindow::plot_buffer(const BufferMetadata& metadata,
+                             const uint8_t* buffer)
+{
+    const string& variable_name_str = metadata.variable_name;
+    const string& display_name_str  = metadata.display_name;
+    const string& pixel_layout_str  = metadata.pixel_layout;
+    const bool transpose_buffer     = metadata.transpose_buffer;
+    const bool is_planar            = metadata.is_planar;
+    const int buff_width            = metadata.width;
+    const int buff_height           = metadata.height;
+    const int buff_channels         = metadata.channels;
+    const int buff_stride           = metadata.row_stride;
+    const BufferType buff_type      = metadata.type;
+
+    auto buffer_stage = stages_.find(variable_name_str);
+
     // Human readable dimensions
     int visualized_width;
     int visualized_height;
@@ -114,77 +337,52 @@ void MainWindow::decode_plot_buffer_contents()
 
     if (buffer_stage == stages_.end()) { // New buffer request
         shared_ptr<Stage> stage = make_shared<Stage>(this);
-        if (!stage->initialize(held_buffers_[variable_name_str].data(),
+        stage->contrast_percentiles[0] = ac_percentiles_[0];
+        stage->contrast_percentiles[1] = ac_percentiles_[1];
+        stage->lod_filter              = lod_filter_;
+        stage->value_label_precision   = value_label_precision_;
+        if (!stage->initialize(buffer,
                                buff_width,
                                buff_height,
                                buff_channels,
                                buff_type,
                                buff_stride,
                                pixel_layout_str,
-                               transpose_buffer)) {
+                               transpose_buffer,
+                               is_planar)) {
             cerr << "[error] Could not initialize opengl canvas!" << endl;
         }
         stage->contrast_enabled    = ac_enabled_;
+        stage->buffer_metadata     = metadata;
         stages_[variable_name_str] = stage;
 
-        ui_->bufferPreview->render_buffer_icon(
-            stage.get(), icon_width, icon_height);
-
-        QImage bufferIcon(stage->buffer_icon.data(),
-                          icon_width,
-                          icon_height,
-                          bytes_per_line,
-                          QImage::Format_RGB888);
-
-        stringstream label;
-        label << display_name_str << "\n[" << visualized_width << "x"
-              << visualized_height << "]\n"
-              << get_type_label(buff_type, buff_channels);
-        QListWidgetItem* item =
-            new QListWidgetItem(QPixmap::fromImage(bufferIcon),
-                                label.str().c_str(),
-                                ui_->imageList);
-        item->setData(Qt::UserRole, QString(variable_name_str.c_str()));
-        item->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled |
-                       Qt::ItemIsDragEnabled);
-        ui_->imageList->addItem(item);
-
-        persist_settings_deferred();
+        // Prefetched buffers are listed once requested
+        if (!is_prefetched_buffer(variable_name_str)) {
+            list_buffer(metadata);
+        }
     } else { // Update buffer request
-        buffer_stage->second->buffer_update(
-            held_buffers_[variable_name_str].data(),
-            buff_width,
-            buff_height,
-            buff_channels,
-            buff_type,
-            buff_stride,
-            pixel_layout_str,
-            transpose_buffer);
+        buffer_stage->second->buffer_update(buffer,
+                                            buff_width,
+                                            buff_height,
+                                            buff_channels,
+                                            buff_type,
+                                            buff_stride,
+                                            pixel_layout_str,
+                                            transpose_buffer,
+                                            is_planar);
 
         // Update buffer icon
         shared_ptr<Stage>& stage = stages_[variable_name_str];
-        ui_->bufferPreview->render_buffer_icon(
-            stage.get(), icon_width, icon_height);
+        stage->buffer_metadata   = metadata;
+        request_buffer_icon(variable_name_str);
 
         // Looking for corresponding item...
-        QImage bufferIcon(stage->buffer_icon.data(),
-                          icon_width,
-                          icon_height,
-                          bytes_per_line,
-                          QImage::Format_RGB888);
         stringstream label;
         label << display_name_str << "\n[" << visualized_width << "x"
               << visualized_height << "]\n"
               << get_type_label(buff_type, buff_channels);
 
-        for (int i = 0; i < ui_->imageList->count(); ++i) {
-            QListWidgetItem* item = ui_->imageList->item(i);
-            if (item->data(Qt::UserRole) == variable_name_str.c_str()) {
-                item->setIcon(QPixmap::fromImage(bufferIcon));
-                item->setText(label.str().c_str());
-                break;
-            }
-        }
+        buffer_list_->set_label(variable_name_str, label.str().c_str());
 
         // Update AC values
         if (currently_selected_stage_ != nullptr) {
@@ -193,51 +391,565 @@ void MainWindow::decode_plot_buffer_contents()
         }
     }
 
-    request_render_update_ = true;
+    // Previews aren't versions of the buffer
+    if (is_buffer_complete(variable_name_str)) {
+        record_buffer_frame(variable_name_str);
+        push_buffer_history(variable_name_str);
+        cache_tensor_slice(variable_name_str);
+    }
+
+    request_render_update();
 }
 
 
-void MainWindow::decode_incoming_messages()
+QModelIndex MainWindow::list_buffer(const BufferMetadata& metadata)
 {
-    // Close application if server has disconnected
-    if(socket_.state() == QTcpSocket::UnconnectedState) {
-        QApplication::quit();
+    const string& variable_name_str = metadata.variable_name;
+
+    stringstream label;
+    label << metadata.display_name << "\n[";
+    if (!metadata.transpose_buffer) {
+        label << metadata.width << "x" << metadata.height;
+    } else {
+        label << metadata.height << "x" << metadata.width;
     }
+    label << "]\n" << get_type_label(metadata.type, metadata.channels);
+
+    // Buffer files are listed before their stage is created
+    buffer_list_->add_buffer(variable_name_str, label.str().c_str());
+    request_buffer_icon(variable_name_str);
+
+    persist_settings_deferred();
+
+    return buffer_list_->buffer_index(variable_name_str);
+}
 
-    available_vars_.clear();
 
-    if (socket_.bytesAvailable() == 0) {
+void MainWindow::decode_plot_buffer_preview(MessageDecoder& message_decoder)
+{
+    BufferMetadata metadata;
+    int preview_width;
+    int preview_height;
+    size_t tile_count;
+    HostBuffer preview;
+
+    message_decoder.read(metadata)
+        .read(preview_width)
+        .read(preview_height)
+        .read(tile_count)
+        .read_compressed(preview);
+
+    const size_t preview_length =
+        static_cast<size_t>(preview_width) *
+        static_cast<size_t>(preview_height) *
+        static_cast<size_t>(metadata.channels) * typesize(metadata.type);
+    if (preview_width <= 0 || preview_height <= 0 ||
+        preview.size() < preview_length) {
+        cerr << "[OpenImageDebugger] Could not decode preview of buffer "
+             << metadata.variable_name << endl;
+        request_plot_buffer(metadata.variable_name.c_str());
         return;
     }
 
-    MessageType header;
-    if (!socket_.read(reinterpret_cast<char*>(&header),
-                      static_cast<qint64>(sizeof(header)))) {
+    const bool is_converted = is_converted_to_float(metadata.type);
+    if (is_converted) {
+        preview =
+            make_float_buffer(preview.data(), metadata.type, preview_length);
+    }
+
+    // The preview is shown at full size, so that the tiles that follow
+    // patch it as any other update
+    const size_t pixel_size =
+        static_cast<size_t>(metadata.channels) *
+        (is_converted ? sizeof(float) : typesize(metadata.type));
+    HostBuffer contents(static_cast<size_t>(metadata.row_stride) *
+                        static_cast<size_t>(metadata.height) * pixel_size);
+    upsample(preview.data(),
+             preview_width,
+             preview_height,
+             pixel_size,
+             metadata.width,
+             metadata.height,
+             metadata.row_stride,
+             contents.data());
+
+    refining_buffers_[metadata.variable_name] = tile_count;
+    lazy_buffers_.erase(metadata.variable_name);
+    hold_buffer_contents(metadata, std::move(contents));
+}
+
+
+void MainWindow::decode_plot_buffer_tiles(MessageDecoder& message_decoder)
+{
+    BufferMetadata metadata;
+    size_t tile_count;
+
+    message_decoder.read(metadata).read(tile_count);
+
+    restore_held_buffer(metadata.variable_name);
+
+    // Tiles can only patch the copy held by a buffer with the same layout
+    auto held_buffer = held_buffers_.find(metadata.variable_name);
+    auto stage       = stages_.find(metadata.variable_name);
+    if (held_buffer == held_buffers_.end() || stage == stages_.end() ||
+        !has_same_layout(stage->second->buffer_metadata,
+                         displayed_metadata(metadata))) {
         return;
     }
 
-    socket_.waitForReadyRead(100);
+    const bool is_converted = is_converted_to_float(metadata.type);
+    const size_t src_pixel_size =
+        static_cast<size_t>(metadata.channels) * typesize(metadata.type);
+    const size_t dst_pixel_size =
+        is_converted ? static_cast<size_t>(metadata.channels) * sizeof(float)
+                     : src_pixel_size;
+    const size_t dst_pitch =
+        static_cast<size_t>(metadata.row_stride) * dst_pixel_size;
+
+    const int buffer_tiles = buffer_tile_count(metadata.width, metadata.height);
+
+    // Tiles that can't be patched leave the held copy outdated, so the
+    // buffer is then requested in full
+    bool is_patched = true;
+
+    vector<BufferRegion> regions;
+    vector<uint8_t> tile_contents;
+    for (size_t i = 0; i < tile_count; ++i) {
+        int tile;
+        message_decoder.read(tile).read_compressed(tile_contents);
+
+        if (tile < 0 || tile >= buffer_tiles) {
+            cerr << "[OpenImageDebugger] Received invalid tile for buffer "
+                 << metadata.variable_name << endl;
+            is_patched = false;
+            break;
+        }
 
-    switch (header) {
-    case MessageType::SetAvailableSymbols:
-        decode_set_available_symbols();
-        break;
-    case MessageType::GetObservedSymbols:
-        respond_get_observed_symbols();
-        break;
-    case MessageType::PlotBufferContents:
-        decode_plot_buffer_contents();
-        break;
-    default:
-        break;
+        const BufferRegion region =
+            buffer_tile_region(metadata.width, metadata.height, tile);
+        const size_t src_pitch =
+            static_cast<size_t>(region.width) * src_pixel_size;
+
+        if (tile_contents.size() < src_pitch * region.height) {
+            cerr << "[OpenImageDebugger] Received truncated tile for buffer "
+                 << metadata.variable_name << endl;
+            is_patched = false;
+            break;
+        }
+
+        uint8_t* dst = held_buffer->second.data() +
+                       static_cast<size_t>(region.y) * dst_pitch +
+                       static_cast<size_t>(region.x) * dst_pixel_size;
+
+        if (is_converted) {
+            convert_region_to_float(tile_contents.data(),
+                                    src_pitch,
+                                    dst,
+                                    dst_pitch,
+                                    region,
+                                    metadata.channels,
+                                    metadata.type);
+        } else {
+            copy_buffer_region(tile_contents.data(),
+                               src_pitch,
+                               dst,
+                               dst_pitch,
+                               region,
+                               src_pixel_size);
+        }
+
+        regions.push_back(region);
+    }
+
+    plot_buffer_regions(metadata, regions);
+
+    if (!is_patched) {
+        request_plot_buffer(metadata.variable_name.c_str());
+    }
+}
+
+
+void MainWindow::decode_plot_buffer_shared_tiles(
+    MessageDecoder& message_decoder)
+{
+    BufferMetadata metadata;
+    string segment_key;
+    size_t buff_length;
+    size_t tile_count;
+
+    message_decoder.read(metadata)
+        .read(segment_key)
+        .read(buff_length)
+        .read(tile_count);
+
+    // The bridge patched the segment the window already has mapped
+    auto segment = shared_buffers_.find(metadata.variable_name);
+    auto stage   = stages_.find(metadata.variable_name);
+    if (segment == shared_buffers_.end() || stage == stages_.end() ||
+        segment->second->key().toStdString() != segment_key ||
+        !has_same_layout(stage->second->buffer_metadata,
+                         displayed_metadata(metadata))) {
+        return;
+    }
+
+    // The tiles are read through the row stride of the mapped segment
+    const size_t src_pixel_size =
+        static_cast<size_t>(metadata.channels) * typesize(metadata.type);
+    const size_t src_pitch =
+        static_cast<size_t>(metadata.row_stride) * src_pixel_size;
+    const size_t segment_size =
+        static_cast<size_t>(segment->second->size());
+    if (metadata.row_stride < metadata.width ||
+        buff_length > segment_size ||
+        src_pitch * static_cast<size_t>(metadata.height) > buff_length) {
+        cerr << "[OpenImageDebugger] Received invalid tiles for buffer "
+             << metadata.variable_name << endl;
+        request_plot_buffer(metadata.variable_name.c_str());
+        return;
+    }
+
+    const int buffer_tiles = buffer_tile_count(metadata.width, metadata.height);
+
+    vector<BufferRegion> regions;
+    for (size_t i = 0; i < tile_count; ++i) {
+        int tile;
+        message_decoder.read(tile);
+
+        if (tile < 0 || tile >= buffer_tiles) {
+            cerr << "[OpenImageDebugger] Received invalid tile for buffer "
+                 << metadata.variable_name << endl;
+            request_plot_buffer(metadata.variable_name.c_str());
+            return;
+        }
+
+        regions.push_back(
+            buffer_tile_region(metadata.width, metadata.height, tile));
+    }
+
+    segment->second->lock();
+
+    restore_held_buffer(metadata.variable_name);
+
+    // Buffers displayed from a float copy must have it patched from the
+    // segment before uploading
+    auto held_buffer = held_buffers_.find(metadata.variable_name);
+    if (is_converted_to_float(metadata.type) &&
+        held_buffer != held_buffers_.end()) {
+        const uint8_t* src =
+            reinterpret_cast<const uint8_t*>(segment->second->constData());
+        const size_t dst_pixel_size =
+            static_cast<size_t>(metadata.channels) * sizeof(float);
+        const size_t dst_pitch =
+            static_cast<size_t>(metadata.row_stride) * dst_pixel_size;
+
+        for (const auto& region : regions) {
+            const size_t src_offset =
+                region.y * src_pitch + region.x * src_pixel_size;
+            const size_t dst_offset =
+                region.y * dst_pitch + region.x * dst_pixel_size;
+
+            convert_region_to_float(src + src_offset,
+                                    src_pitch,
+                                    held_buffer->second.data() + dst_offset,
+                                    dst_pitch,
+                                    region,
+                                    metadata.channels,
+                                    metadata.type);
+        }
+    }
+
+    plot_buffer_regions(metadata, regions);
+
+    segment->second->unlock();
+}
+
+
+void MainWindow::decode_plot_buffer_unchanged(MessageDecoder& message_decoder)
+{
+    string variable_name;
+    message_decoder.read(variable_name);
+
+    // The buffer may have been removed since the bridge last checked which
+    // buffers are observed, in which case its contents must be sent again
+    if (stages_.find(variable_name) == stages_.end()) {
+        request_plot_buffer(variable_name.c_str());
+    }
+}
+
+
+void MainWindow::decode_plot_buffer_batch(MessageDecoder& message_decoder)
+{
+    bool batch_begins;
+    message_decoder.read(batch_begins);
+
+    is_receiving_plot_batch_ = batch_begins;
+    if (batch_begins) {
+        plot_batch_timer_.start();
+    } else {
+        // The buffers of the pending stop have all arrived
+        has_stop_batch_ended_ = !is_stop_displayed_;
+        request_render_update();
+    }
+}
+
+
+void MainWindow::plot_buffer_regions(const BufferMetadata& metadata,
+                                     const vector<BufferRegion>& regions)
+{
+    Stage* stage = stages_[metadata.variable_name].get();
+
+    // Buffers refined from a preview become a new version once all of
+    // their tiles have arrived
+    auto refining = refining_buffers_.find(metadata.variable_name);
+    if (refining != refining_buffers_.end()) {
+        refining->second -= min(refining->second, regions.size());
+        if (refining->second == 0) {
+            refining_buffers_.erase(refining);
+        }
+    }
+
+    if (!regions.empty()) {
+        // A stage showing a previous version is uploaded again in full from
+        // the updated contents
+        auto history = histories_.find(metadata.variable_name);
+        if (history != histories_.end() &&
+            history->second.viewed_version != 0) {
+            show_history_version(metadata.variable_name, 0);
+        } else {
+            stage->buffer_update_regions(regions);
+            request_buffer_icon(metadata.variable_name);
+        }
+        if (is_buffer_complete(metadata.variable_name)) {
+            record_buffer_frame(metadata.variable_name);
+            push_buffer_history(metadata.variable_name);
+            cache_tensor_slice(metadata.variable_name);
+        }
+
+        // Update AC values
+        if (currently_selected_stage_ != nullptr) {
+            reset_ac_min_labels();
+            reset_ac_max_labels();
+        }
+    }
+
+    request_render_update();
+}
+
+
+bool MainWindow::is_buffer_complete(const string& buffer_name) const
+{
+    return refining_buffers_.find(buffer_name) == refining_buffers_.end() &&
+           lazy_buffers_.find(buffer_name) == lazy_buffers_.end();
+}
+
+
+bool MainWindow::is_converted_to_float(BufferType type)
+{
+    // Double buffers have no texture format, and 32 bit integers require
+    // integer textures
+    return type == BufferType::Float64 ||
+           ((type == BufferType::Int32 || type == BufferType::UInt32) &&
+            !ui_->bufferPreview->is_integer_texture_supported());
+}
+
+
+BufferMetadata MainWindow::displayed_metadata(const BufferMetadata& metadata)
+{
+    // Converted integer buffers are displayed as regular float buffers
+    BufferMetadata displayed = metadata;
+    if ((displayed.type == BufferType::Int32 ||
+         displayed.type == BufferType::UInt32) &&
+        is_converted_to_float(displayed.type)) {
+        displayed.type = BufferType::Float32;
+    }
+
+    return displayed;
+}
+
+
+void MainWindow::request_buffer_icon(const string& buffer_name)
+{
+    buffer_update_times_[buffer_name] = QDateTime::currentDateTime();
+
+    // Icons are rendered from the update loop, so that the main view is
+    // updated first, and only once the buffer list shows them
+    buffer_list_->outdate_icon(buffer_name);
+    schedule_loop();
+
+    // The icon and the next frame showing the buffer are the last spans of
+    // the plot being traced
+    const uint64_t correlation_id = TraceCorrelation::current();
+    if (correlation_id != 0) {
+        traced_plots_[buffer_name] = correlation_id;
+    }
+}
+
+
+bool MainWindow::queue_buffer_icon(const string& buffer_name)
+{
+    // Buffer files get their stage once they are first selected
+    if (stages_.find(buffer_name) == stages_.end()) {
+        return false;
     }
+
+    outdated_icons_.insert(buffer_name);
+    schedule_loop();
+
+    return true;
+}
+
+
+void MainWindow::repaint_outdated_icons()
+{
+    // Buffer icon dimensions
+    QSizeF icon_size = get_icon_size();
+    int icon_width   = static_cast<int>(icon_size.width());
+    int icon_height  = static_cast<int>(icon_size.height());
+
+    for (auto name = outdated_icons_.begin(); name != outdated_icons_.end();) {
+        auto stage = stages_.find(*name);
+        if (stage == stages_.end()) {
+            name = outdated_icons_.erase(name);
+            continue;
+        }
+
+        // The icon is rendered once the buffer textures are complete
+        if (stage->second->has_pending_uploads()) {
+            ++name;
+            continue;
+        }
+
+        auto traced = traced_plots_.find(*name);
+        TraceSpan span("render buffer icon",
+                       traced != traced_plots_.end() ? traced->second : 0);
+
+        // The remaining icons are rendered once readbacks complete
+        if (!ui_->bufferPreview->render_buffer_icon(
+                stage->second.get(), icon_width, icon_height)) {
+            break;
+        }
+
+        name = outdated_icons_.erase(name);
+    }
+}
+
+
+void MainWindow::update_finished_icons()
+{
+    vector<GLIconReadback::Icon> finished_icons;
+    ui_->bufferPreview->get_icon_readback()->collect(finished_icons);
+
+    for (const auto& icon : finished_icons) {
+        // Icons of buffers removed during their readback are dropped
+        if (stages_.find(icon.name) == stages_.end()) {
+            continue;
+        }
+
+        QImage buffer_icon(icon.pixels.data(),
+                           icon.width,
+                           icon.height,
+                           icon.width * 3,
+                           QImage::Format_RGB888);
+
+        buffer_list_->set_icon(icon.name, QPixmap::fromImage(buffer_icon));
+    }
+}
+
+
+void MainWindow::decode_incoming_messages()
+{
+    // The worker already decoded the buffer contents, only the messages
+    // that touch the stages and widgets are decoded here
+    ReceivedMessage message;
+    while (network_worker_->pop_message(message)) {
+        // Uploads scheduled meanwhile are attributed to the message
+        TraceCorrelation correlation(message.correlation_id);
+        TraceSpan span("process message");
+
+        if (drop_superseded_plot(message)) {
+            network_worker_->recycle_buffer(std::move(message.body));
+            continue;
+        }
+
+        if (message.is_decoded_plot) {
+            decode_plot_buffer_contents(message);
+            continue;
+        }
+
+        MessageDecoder message_decoder(message.body.data(),
+                                       message.body.size());
+
+        switch (message.type) {
+        case MessageType::SetAvailableSymbols:
+            decode_set_available_symbols(message_decoder);
+            break;
+        case MessageType::UpdateAvailableSymbols:
+            decode_update_available_symbols(message_decoder);
+            break;
+        case MessageType::GetObservedSymbols:
+            respond_get_observed_symbols();
+            break;
+        case MessageType::PlotBufferSharedContents:
+            decode_plot_buffer_shared_contents(message_decoder);
+            break;
+        case MessageType::PlotBufferTiles:
+            decode_plot_buffer_tiles(message_decoder);
+            break;
+        case MessageType::PlotBufferSharedTiles:
+            decode_plot_buffer_shared_tiles(message_decoder);
+            break;
+        case MessageType::PlotBufferUnchanged:
+            decode_plot_buffer_unchanged(message_decoder);
+            break;
+        case MessageType::PlotBufferBatch:
+            decode_plot_buffer_batch(message_decoder);
+            break;
+        case MessageType::PlotBufferPreview:
+            decode_plot_buffer_preview(message_decoder);
+            break;
+        case MessageType::PlotBufferLazy:
+            decode_plot_buffer_lazy(message_decoder);
+            break;
+        case MessageType::PlotBufferLevelTiles:
+            decode_plot_buffer_level_tiles(message_decoder);
+            break;
+        case MessageType::PlotBufferStop:
+            begin_stop_latency();
+            // The inferior may have written to the cached slices since, and
+            // to the prefetched buffers
+            clear_tensor_slices();
+            evict_prefetched_buffers();
+            break;
+        default:
+            break;
+        }
+
+        network_worker_->recycle_buffer(std::move(message.body));
+    }
+}
+
+
+void MainWindow::send_transport_settings()
+{
+    MessageComposer message_composer;
+    message_composer.push(MessageType::SetTransportSettings)
+        .push(compression_settings_.codec)
+        .push(compression_settings_.level)
+        .push(compression_settings_.threshold)
+        .push(progressive_threshold_)
+        .push(lazy_threshold_);
+    network_worker_->send(message_composer);
 }
 
 
 void MainWindow::request_plot_buffer(const char* buffer_name)
 {
+    if (host_settings_.is_offline) {
+        return;
+    }
+
     MessageComposer message_composer;
     message_composer.push(MessageType::PlotBufferRequest)
-        .push(std::string(buffer_name))
-        .send(&socket_);
+        .push(std::string(buffer_name));
+    network_worker_->send(message_composer);
 }
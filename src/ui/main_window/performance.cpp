@@ -0,0 +1,240 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include <QString>
+
+#include "main_window.h"
+
+#include "ui_main_window.h"
+#include "ui/gl_frame_timer.h"
+#include "ui/gl_texture_streamer.h"
+#include "visualization/game_object.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+// Refresh period of the performance overlay and the metrics panel
+const int metrics_refresh_ms = 500;
+
+
+Buffer* get_buffer_component(Stage* stage)
+{
+    return stage->get_buffer_component();
+}
+
+
+QString format_megabytes(size_t bytes)
+{
+    return QString::number(static_cast<double>(bytes) / (1 << 20), 'f', 1);
+}
+
+
+QString format_rate(double bytes_per_second)
+{
+    return QString::number(bytes_per_second / (1 << 20), 'f', 1) + " MB/s";
+}
+
+} // namespace
+
+
+void MainWindow::toggle_performance_hud()
+{
+    GLCanvas* canvas = ui_->bufferPreview;
+    canvas->set_hud_visible(!canvas->is_hud_visible());
+
+    update_performance_metrics();
+}
+
+
+void MainWindow::toggle_metrics_panel()
+{
+    metrics_dock_->setVisible(!metrics_dock_->isVisible());
+
+    update_performance_metrics();
+}
+
+
+void MainWindow::update_performance_metrics()
+{
+    GLCanvas* canvas = ui_->bufferPreview;
+
+    const bool is_hud_visible   = canvas->is_hud_visible();
+    const bool is_panel_visible = metrics_dock_->isVisible();
+
+    // Nothing is measured while neither is shown
+    if (!is_hud_visible && !is_panel_visible) {
+        metrics_timer_.stop();
+        metrics_interval_timer_.invalidate();
+        return;
+    }
+
+    if (!metrics_timer_.isActive()) {
+        metrics_timer_.start(metrics_refresh_ms);
+    }
+
+    const uint64_t uploaded_bytes =
+        canvas->get_texture_streamer()->uploaded_bytes();
+    const uint64_t received_bytes =
+        network_worker_ != nullptr ? network_worker_->received_bytes() : 0;
+
+    // Rates are averaged since the last refresh, and unknown on the first
+    double upload_rate  = 0.0;
+    double receive_rate = 0.0;
+    if (metrics_interval_timer_.isValid()) {
+        const double seconds =
+            max(metrics_interval_timer_.restart(), qint64(1)) / 1000.0;
+        upload_rate  = (uploaded_bytes - metered_uploaded_bytes_) / seconds;
+        receive_rate = (received_bytes - metered_received_bytes_) / seconds;
+    } else {
+        metrics_interval_timer_.start();
+    }
+    metered_uploaded_bytes_ = uploaded_bytes;
+    metered_received_bytes_ = received_bytes;
+
+    if (is_hud_visible) {
+        const GLFrameTimer* frame_timer = canvas->get_frame_timer();
+
+        const QString gpu_frame_time =
+            frame_timer->is_gpu_time_supported()
+                ? QString::number(frame_timer->gpu_frame_time(), 'f', 2) +
+                      " ms"
+                : QString("n/a");
+        const QString stop_latency =
+            stop_display_latency_ms_ < 0
+                ? QString("n/a")
+                : QString::number(stop_display_latency_ms_) + " ms";
+
+        QString selected_memory = "n/a";
+        if (currently_selected_stage_ != nullptr) {
+            const string& buffer_name =
+                currently_selected_stage_->buffer_metadata.variable_name;
+            const Buffer* buffer =
+                get_buffer_component(currently_selected_stage_);
+            const size_t host_usage = buffer_host_memory_usage(buffer_name);
+            selected_memory = QString("host %1 MB  GPU %2 MB")
+                                  .arg(format_megabytes(host_usage))
+                                  .arg(format_megabytes(
+                                      buffer->texture_memory_size()));
+        }
+
+        canvas->set_hud_text(
+            QString("Frame     CPU %1 ms  GPU %2\n"
+                    "Uploads   %3\n"
+                    "Received  %4\n"
+                    "Stop      %5 to display\n"
+                    "Selected  %6")
+                .arg(QString::number(frame_timer->cpu_frame_time(), 'f', 2))
+                .arg(gpu_frame_time)
+                .arg(format_rate(upload_rate))
+                .arg(format_rate(receive_rate))
+                .arg(stop_latency)
+                .arg(selected_memory));
+    }
+
+    if (is_panel_visible) {
+        update_metrics_panel();
+    }
+}
+
+
+void MainWindow::begin_stop_latency()
+{
+    // The bridge announces the stop before queuing any of its buffers
+    stop_timer_.start();
+    is_stop_displayed_    = false;
+    has_stop_batch_ended_ = false;
+}
+
+
+void MainWindow::update_stop_latency()
+{
+    if (is_stop_displayed_ || !has_stop_batch_ended_ ||
+        ui_->bufferPreview->get_texture_streamer()->has_pending_uploads()) {
+        return;
+    }
+
+    stop_display_latency_ms_ = stop_timer_.elapsed();
+    is_stop_displayed_       = true;
+}
+
+
+void MainWindow::update_metrics_panel()
+{
+    metrics_table_->setRowCount(static_cast<int>(stages_.size()));
+
+    int row = 0;
+    for (const auto& stage : stages_) {
+        const string& buffer_name = stage.first;
+
+        QString state = "held";
+        if (lazy_buffers_.find(buffer_name) != lazy_buffers_.end()) {
+            state = "lazy";
+        } else if (refining_buffers_.find(buffer_name) !=
+                   refining_buffers_.end()) {
+            state = "refining";
+        } else if (compressed_buffers_.find(buffer_name) !=
+                   compressed_buffers_.end()) {
+            state = "compressed";
+        } else if (shared_buffers_.find(buffer_name) !=
+                   shared_buffers_.end()) {
+            state = "shared";
+        } else if (buffer_files_.find(buffer_name) != buffer_files_.end()) {
+            state = "file";
+        }
+
+        QString updated;
+        auto update_time = buffer_update_times_.find(buffer_name);
+        if (update_time != buffer_update_times_.end()) {
+            updated = update_time->second.toString("hh:mm:ss.zzz");
+        }
+
+        const Buffer* buffer = get_buffer_component(stage.second.get());
+
+        const QString columns[] = {
+            QString::fromStdString(buffer_name),
+            state,
+            format_megabytes(buffer_host_memory_usage(buffer_name)),
+            format_megabytes(buffer->texture_memory_size()),
+            updated};
+
+        for (int column = 0; column < metrics_table_->columnCount();
+             ++column) {
+            QTableWidgetItem* item = metrics_table_->item(row, column);
+            if (item == nullptr) {
+                item = new QTableWidgetItem();
+                metrics_table_->setItem(row, column, item);
+            }
+            item->setText(columns[column]);
+        }
+
+        ++row;
+    }
+}
@@ -0,0 +1,131 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cmath>
+
+#include <QStatusBar>
+
+#include "main_window.h"
+
+#include "math/pixel_search.h"
+#include "visualization/components/buffer.h"
+#include "visualization/components/camera.h"
+#include "visualization/game_object.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+Buffer* get_buffer_component(Stage* stage)
+{
+    return stage->get_buffer_component();
+}
+
+
+Camera* get_camera_component(Stage* stage)
+{
+    return stage->get_camera_component();
+}
+
+} // namespace
+
+
+void MainWindow::search_pixel(const QString& query)
+{
+    last_pixel_search_ = query.trimmed().toLower();
+    repeat_pixel_search();
+}
+
+
+void MainWindow::repeat_pixel_search()
+{
+    if (currently_selected_stage_ == nullptr || last_pixel_search_.isEmpty()) {
+        return;
+    }
+
+    // Lazy and refining buffers don't hold all of their values yet
+    if (!is_buffer_complete(
+            currently_selected_stage_->buffer_metadata.variable_name)) {
+        statusBar()->showMessage(
+            "The buffer can be searched once it is fully received", 5000);
+        return;
+    }
+
+    Buffer* buffer = get_buffer_component(currently_selected_stage_);
+    const PixelIndex& index = buffer->pixel_index();
+
+    // Searches for the next pixel start from the center of the view
+    const vec4 position =
+        get_camera_component(currently_selected_stage_)->get_position();
+    const PixelLocation from = {static_cast<int>(floor(position.x())),
+                                static_cast<int>(floor(position.y()))};
+
+    PixelLocation location;
+    float value;
+    bool is_found;
+    if (last_pixel_search_ == "min") {
+        is_found = index.lowest(location, value);
+    } else if (last_pixel_search_ == "max") {
+        is_found = index.upper(location, value);
+    } else if (last_pixel_search_ == "nan") {
+        is_found = index.next_nan(from, location);
+    } else if (last_pixel_search_ == "inf") {
+        is_found = index.next_inf(from, location);
+    } else {
+        QString reference = last_pixel_search_;
+        PixelComparison comparison = PixelComparison::Equal;
+        if (reference.startsWith('>')) {
+            comparison = PixelComparison::Above;
+        } else if (reference.startsWith('<')) {
+            comparison = PixelComparison::Below;
+        }
+        if (reference.startsWith('>') || reference.startsWith('<') ||
+            reference.startsWith('=')) {
+            reference.remove(0, 1);
+        }
+
+        bool is_valid;
+        value = reference.trimmed().toFloat(&is_valid);
+        if (!is_valid) {
+            statusBar()->showMessage(
+                "Unknown pixel search: " + last_pixel_search_, 5000);
+            return;
+        }
+
+        is_found = index.next_matching(
+            buffer->buffer, comparison, value, from, location);
+    }
+
+    if (!is_found) {
+        statusBar()->showMessage(
+            "No pixel found for " + last_pixel_search_, 5000);
+        return;
+    }
+
+    go_to_pixel(location.x + 0.5f, location.y + 0.5f);
+}
@@ -0,0 +1,146 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "main_window.h"
+
+#include <algorithm>
+
+#include "ui_main_window.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+// Completions are prefetched once narrowed down to this many symbols
+const int max_prefetched_completions = 3;
+
+// Host memory held by the prefetched buffers
+const size_t prefetch_memory_budget = static_cast<size_t>(256) << 20;
+
+} // namespace
+
+
+void MainWindow::prefetch_completions(const QStringList& completions)
+{
+    if (host_settings_.is_offline || network_worker_ == nullptr ||
+        completions.isEmpty() ||
+        completions.size() > max_prefetched_completions) {
+        return;
+    }
+
+    vector<string> buffer_names;
+    for (const QString& completion : completions) {
+        const string buffer_name = completion.toStdString();
+        if (stages_.find(buffer_name) == stages_.end() &&
+            !is_prefetched_buffer(buffer_name)) {
+            buffer_names.push_back(buffer_name);
+            prefetched_buffers_.push_back(buffer_name);
+        }
+    }
+
+    if (buffer_names.empty()) {
+        return;
+    }
+
+    // The bridge plots them after any other work of the stop
+    MessageComposer message_composer;
+    message_composer.push(MessageType::PlotBufferPrefetchRequest)
+        .push(buffer_names);
+    network_worker_->send(message_composer);
+}
+
+
+bool MainWindow::is_prefetched_buffer(const string& buffer_name) const
+{
+    return find(prefetched_buffers_.begin(),
+                prefetched_buffers_.end(),
+                buffer_name) != prefetched_buffers_.end();
+}
+
+
+bool MainWindow::show_prefetched_buffer(const string& buffer_name)
+{
+    auto prefetched = find(
+        prefetched_buffers_.begin(), prefetched_buffers_.end(), buffer_name);
+    if (prefetched == prefetched_buffers_.end()) {
+        return false;
+    }
+
+    // A buffer still on its way is listed as soon as it arrives
+    prefetched_buffers_.erase(prefetched);
+
+    auto stage = stages_.find(buffer_name);
+    if (stage == stages_.end()) {
+        return false;
+    }
+
+    // The copy of the metadata outlives the stage being selected
+    const BufferMetadata metadata = stage->second->buffer_metadata;
+    ui_->imageList->setCurrentIndex(list_buffer(metadata));
+
+    return true;
+}
+
+
+void MainWindow::enforce_prefetch_budget()
+{
+    size_t prefetched_size = 0;
+    for (const string& buffer_name : prefetched_buffers_) {
+        prefetched_size += buffer_host_memory_usage(buffer_name);
+    }
+
+    // Buffers still on their way are kept, or they would be listed once
+    // they arrive
+    for (auto name = prefetched_buffers_.begin();
+         name != prefetched_buffers_.end() &&
+         prefetched_size > prefetch_memory_budget;) {
+        if (stages_.find(*name) == stages_.end()) {
+            ++name;
+            continue;
+        }
+
+        const string buffer_name = *name;
+        prefetched_size -= buffer_host_memory_usage(buffer_name);
+
+        name = prefetched_buffers_.erase(name);
+        forget_buffer(buffer_name);
+    }
+}
+
+
+void MainWindow::evict_prefetched_buffers()
+{
+    deque<string> evicted_buffers;
+    evicted_buffers.swap(prefetched_buffers_);
+
+    for (const string& buffer_name : evicted_buffers) {
+        if (stages_.find(buffer_name) != stages_.end()) {
+            forget_buffer(buffer_name);
+        }
+    }
+}
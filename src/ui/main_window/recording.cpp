@@ -0,0 +1,99 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <iostream>
+
+#include <QAction>
+#include <QFileDialog>
+#include <QStatusBar>
+
+#include "main_window.h"
+
+
+using namespace std;
+
+
+void MainWindow::toggle_buffer_recording()
+{
+    auto sender_action(static_cast<QAction*>(sender()));
+    const string buffer_name = sender_action->data().toString().toStdString();
+
+    auto recorder = recorders_.find(buffer_name);
+    if (recorder != recorders_.end()) {
+        const size_t frame_count = recorder->second->frame_count();
+        const bool succeeded     = recorder->second->stop();
+        recorders_.erase(recorder);
+
+        statusBar()->showMessage(
+            succeeded ? QString("Recorded %1 frames of %2")
+                            .arg(frame_count)
+                            .arg(buffer_name.c_str())
+                      : QString("Could not finish the recording of %1")
+                            .arg(buffer_name.c_str()),
+            5000);
+        return;
+    }
+
+    const QString file_name = QFileDialog::getSaveFileName(
+        this,
+        tr("Record buffer"),
+        QString(),
+        tr("Open Image Debugger Recording (*.oidrec)"));
+    if (file_name.isEmpty()) {
+        return;
+    }
+
+    unique_ptr<BufferRecorder> new_recorder(new BufferRecorder());
+    if (!new_recorder->start(file_name.toStdString(), buffer_name)) {
+        cerr << "[OpenImageDebugger] Could not record buffer " << buffer_name
+             << " to " << file_name.toStdString() << endl;
+        return;
+    }
+
+    recorders_[buffer_name] = std::move(new_recorder);
+
+    // The current contents are the first frame
+    record_buffer_frame(buffer_name);
+}
+
+
+void MainWindow::record_buffer_frame(const string& buffer_name)
+{
+    // Previous versions being shown aren't updates of the buffer
+    auto recorder = recorders_.find(buffer_name);
+    if (recorder == recorders_.end() || is_showing_history_) {
+        return;
+    }
+
+    BufferMetadata metadata;
+    size_t length;
+    const uint8_t* contents =
+        get_displayed_contents(buffer_name, metadata, length);
+    if (contents == nullptr) {
+        return;
+    }
+
+    recorder->second->record(metadata, contents, length);
+}
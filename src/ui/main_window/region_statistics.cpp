@@ -0,0 +1,166 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "main_window.h"
+
+#include "math/block_statistics.h"
+#include "math/summed_area_table.h"
+#include "visualization/components/buffer.h"
+#include "visualization/game_object.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+Buffer* get_buffer_component(Stage* stage)
+{
+    return stage->get_buffer_component();
+}
+
+
+template <typename T>
+void write_channels(stringstream& message, const T* values, int channels)
+{
+    message << "[";
+    for (int c = 0; c < channels; ++c) {
+        message << values[c];
+        if (c < channels - 1) {
+            message << " ";
+        }
+    }
+    message << "]";
+}
+
+} // namespace
+
+
+void MainWindow::select_region(int x0, int y0, int x1, int y1)
+{
+    if (currently_selected_stage_ == nullptr) {
+        return;
+    }
+
+    Buffer* buffer = get_buffer_component(currently_selected_stage_);
+
+    // The view may be rotated, so the region bounds all four corners
+    const vec4 corners[] = {get_stage_coordinates(x0, y0),
+                            get_stage_coordinates(x1, y0),
+                            get_stage_coordinates(x0, y1),
+                            get_stage_coordinates(x1, y1)};
+
+    float lowest_x = corners[0].x();
+    float lowest_y = corners[0].y();
+    float upper_x  = lowest_x;
+    float upper_y  = lowest_y;
+    for (const vec4& corner : corners) {
+        lowest_x = min(lowest_x, corner.x());
+        lowest_y = min(lowest_y, corner.y());
+        upper_x  = max(upper_x, corner.x());
+        upper_y  = max(upper_y, corner.y());
+    }
+
+    const int left   = max(static_cast<int>(floor(lowest_x)), 0);
+    const int top    = max(static_cast<int>(floor(lowest_y)), 0);
+    const int right  = min(static_cast<int>(ceil(upper_x)),
+                           static_cast<int>(buffer->buffer_width_f));
+    const int bottom = min(static_cast<int>(ceil(upper_y)),
+                           static_cast<int>(buffer->buffer_height_f));
+
+    selected_region_ =
+        QRect(left, top, max(right - left, 0), max(bottom - top, 0));
+    selected_region_buffer_ =
+        currently_selected_stage_->buffer_metadata.variable_name;
+
+    update_status_bar();
+}
+
+
+void MainWindow::clear_region_selection()
+{
+    if (selected_region_buffer_.empty()) {
+        return;
+    }
+
+    selected_region_        = QRect();
+    selected_region_buffer_ = "";
+
+    update_status_bar();
+}
+
+
+void MainWindow::append_region_statistics(stringstream& message)
+{
+    if (currently_selected_stage_ == nullptr ||
+        currently_selected_stage_->buffer_metadata.variable_name !=
+            selected_region_buffer_) {
+        return;
+    }
+
+    message << "\tregion " << selected_region_.width() << "x"
+            << selected_region_.height();
+
+    Buffer* buffer = get_buffer_component(currently_selected_stage_);
+
+    // Lazy and refining buffers don't hold all of their values yet, and the
+    // contents of compressed buffers aren't available
+    if (selected_region_.isEmpty() || buffer->buffer == nullptr ||
+        !is_buffer_complete(selected_region_buffer_)) {
+        message << " [unavailable]";
+        return;
+    }
+
+    // The moments are exact, while the bounds are those of the blocks of
+    // the statistics index around the region
+    const RegionMoments moments =
+        buffer->summed_area_table().region_moments(buffer->buffer,
+                                                   selected_region_.x(),
+                                                   selected_region_.y(),
+                                                   selected_region_.width(),
+                                                   selected_region_.height());
+
+    float lowest[4];
+    float upper[4];
+    buffer
+        ->region_statistics(selected_region_.x(),
+                            selected_region_.y(),
+                            selected_region_.width(),
+                            selected_region_.height())
+        .bounds(buffer->channels, lowest, upper);
+
+    message << " mean=";
+    write_channels(message, moments.mean, buffer->channels);
+    message << " std=";
+    write_channels(message, moments.deviation, buffer->channels);
+    message << " min=";
+    write_channels(message, lowest, buffer->channels);
+    message << " max=";
+    write_channels(message, upper, buffer->channels);
+}
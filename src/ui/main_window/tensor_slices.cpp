@@ -0,0 +1,242 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "main_window.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "ipc/buffer_tiles.h"
+#include "ui_main_window.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+// Slices kept per tensor buffer until the debugger stops again
+const size_t max_cached_tensor_slices = 8;
+
+} // namespace
+
+
+void MainWindow::tensor_axis_selected(int axis)
+{
+    if (currently_selected_stage_ == nullptr || axis < 0) {
+        return;
+    }
+
+    const string& buffer_name =
+        currently_selected_stage_->buffer_metadata.variable_name;
+
+    tensor_slices_[buffer_name].axis = axis;
+    update_tensor_slice_widgets();
+}
+
+
+void MainWindow::tensor_slice_selected(int position)
+{
+    if (currently_selected_stage_ == nullptr || position < 0) {
+        return;
+    }
+
+    const BufferMetadata& metadata =
+        currently_selected_stage_->buffer_metadata;
+    const int axis = tensor_slices_[metadata.variable_name].axis;
+    if (static_cast<size_t>(axis) >= metadata.tensor_index.size()) {
+        return;
+    }
+
+    vector<int> tensor_index = metadata.tensor_index;
+    tensor_index[static_cast<size_t>(axis)] = position;
+
+    // Copied, as the stage metadata is replaced by the selected slice
+    const string buffer_name = metadata.variable_name;
+    select_tensor_slice(buffer_name, tensor_index);
+}
+
+
+void MainWindow::cache_tensor_slice(const string& buffer_name)
+{
+    auto stage = stages_.find(buffer_name);
+    if (stage == stages_.end()) {
+        return;
+    }
+
+    const bool is_selected = currently_selected_stage_ == stage->second.get();
+
+    if (stage->second->buffer_metadata.tensor_shape.empty()) {
+        tensor_slices_.erase(buffer_name);
+        if (is_selected) {
+            update_tensor_slice_widgets();
+        }
+        return;
+    }
+
+    BufferMetadata metadata;
+    size_t length;
+    const uint8_t* contents =
+        get_displayed_contents(buffer_name, metadata, length);
+    if (contents == nullptr) {
+        return;
+    }
+
+    // The stage metadata is the one received, and the displayed contents
+    // are plotted with it again, as the held buffer would be
+    metadata = stage->second->buffer_metadata;
+
+    TensorSlices& slices = tensor_slices_[buffer_name];
+    deque<TensorSlice>& cached = slices.cached;
+
+    // Slices of a tensor whose shape or layout changed can't be shown anymore
+    for (auto slice = cached.begin(); slice != cached.end();) {
+        if (slice->metadata.tensor_index == metadata.tensor_index ||
+            slice->metadata.tensor_shape != metadata.tensor_shape ||
+            !has_same_layout(slice->metadata, metadata)) {
+            slice = cached.erase(slice);
+        } else {
+            ++slice;
+        }
+    }
+
+    TensorSlice slice;
+    slice.metadata = metadata;
+    slice.contents.assign(contents, contents + length);
+    cached.push_front(std::move(slice));
+
+    if (cached.size() > max_cached_tensor_slices) {
+        cached.pop_back();
+    }
+
+    if (is_selected) {
+        update_tensor_slice_widgets();
+    }
+}
+
+
+void MainWindow::clear_tensor_slices()
+{
+    for (auto& slices : tensor_slices_) {
+        slices.second.cached.clear();
+    }
+}
+
+
+void MainWindow::select_tensor_slice(const string& buffer_name,
+                                     const vector<int>& tensor_index)
+{
+    auto slices = tensor_slices_.find(buffer_name);
+    if (slices == tensor_slices_.end()) {
+        return;
+    }
+
+    deque<TensorSlice>& cached = slices->second.cached;
+    auto slice = find_if(
+        cached.begin(), cached.end(), [&](const TensorSlice& candidate) {
+            return candidate.metadata.tensor_index == tensor_index;
+        });
+
+    const bool is_cached = slice != cached.end();
+    request_tensor_slice(buffer_name, tensor_index, is_cached);
+
+    if (!is_cached) {
+        return;
+    }
+
+    const TensorSlice& cached_slice = *slice;
+
+    HostBuffer contents(cached_slice.contents.size());
+    memcpy(contents.data(),
+           cached_slice.contents.data(),
+           cached_slice.contents.size());
+
+    // The cached slice replaces everything received for the buffer
+    refining_buffers_.erase(buffer_name);
+    lazy_buffers_.erase(buffer_name);
+
+    // Plotting it moves it back to the front of the cache
+    const BufferMetadata metadata = cached_slice.metadata;
+    hold_buffer_contents(metadata, std::move(contents));
+}
+
+
+void MainWindow::request_tensor_slice(const string& buffer_name,
+                                      const vector<int>& tensor_index,
+                                      bool is_cached)
+{
+    if (host_settings_.is_offline) {
+        return;
+    }
+
+    MessageComposer message_composer;
+    message_composer.push(MessageType::PlotBufferSliceRequest)
+        .push(buffer_name)
+        .push(tensor_index)
+        .push(is_cached);
+    network_worker_->send(message_composer);
+}
+
+
+void MainWindow::update_tensor_slice_widgets()
+{
+    if (currently_selected_stage_ == nullptr ||
+        currently_selected_stage_->buffer_metadata.tensor_shape.empty()) {
+        ui_->tensorSlice->hide();
+        return;
+    }
+
+    const BufferMetadata& metadata =
+        currently_selected_stage_->buffer_metadata;
+    const vector<int>& shape = metadata.tensor_shape;
+    const vector<int>& index = metadata.tensor_index;
+
+    TensorSlices& slices = tensor_slices_[metadata.variable_name];
+    slices.axis = min(max(slices.axis, 0), static_cast<int>(shape.size()) - 1);
+    const size_t axis = static_cast<size_t>(slices.axis);
+
+    // Only user changes of the widgets select a slice
+    ui_->tensorAxis->blockSignals(true);
+    ui_->tensorAxis->clear();
+    for (size_t i = 0; i < shape.size(); ++i) {
+        ui_->tensorAxis->addItem(
+            QString("Axis %1 (%2)").arg(i).arg(shape[i]));
+    }
+    ui_->tensorAxis->setCurrentIndex(slices.axis);
+    ui_->tensorAxis->blockSignals(false);
+
+    ui_->tensorSliceSlider->blockSignals(true);
+    ui_->tensorSliceSlider->setRange(0, shape[axis] - 1);
+    ui_->tensorSliceSlider->setValue(index[axis]);
+    ui_->tensorSliceSlider->blockSignals(false);
+
+    QStringList position;
+    for (int i : index) {
+        position.append(QString::number(i));
+    }
+    ui_->tensorSliceLabel->setText(QString("[%1]").arg(position.join(", ")));
+    ui_->tensorSlice->show();
+}
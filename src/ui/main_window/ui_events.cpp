@@ -23,7 +23,17 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <iostream>
+
+#include <QDragEnterEvent>
+#include <QDropEvent>
 #include <QFileDialog>
+#include <QMimeData>
+#include <QStatusBar>
+#include <QUrl>
 
 #include "main_window.h"
 
@@ -36,10 +46,9 @@
 using namespace std;
 
 
-void MainWindow::resize_callback(int w, int h)
+void MainWindow::resize_callback(int, int)
 {
-    for (auto& stage : stages_)
-        stage.second->resize_callback(w, h);
+    resize_views();
 
     go_to_widget_->move(ui_->bufferPreview->width() - go_to_widget_->width(),
                         ui_->bufferPreview->height() - go_to_widget_->height());
@@ -61,7 +70,7 @@ void MainWindow::scroll_callback(float delta)
 #if defined(Q_OS_DARWIN)
     ui_->bufferPreview->update();
 #endif
-    request_render_update_ = true;
+    request_render_update();
 }
 
 
@@ -79,7 +88,7 @@ void MainWindow::mouse_drag_event(int mouse_x, int mouse_y)
                                                     virtual_motion.y());
     }
 
-    request_render_update_ = true;
+    request_render_update();
 }
 
 
@@ -108,10 +117,38 @@ void MainWindow::closeEvent(QCloseEvent*)
 }
 
 
+void MainWindow::dragEnterEvent(QDragEnterEvent* event)
+{
+    for (const QUrl& url : event->mimeData()->urls()) {
+        if (url.isLocalFile() && is_buffer_file(url.toLocalFile())) {
+            event->acceptProposedAction();
+            return;
+        }
+    }
+}
+
+
+void MainWindow::dropEvent(QDropEvent* event)
+{
+    for (const QUrl& url : event->mimeData()->urls()) {
+        if (url.isLocalFile() && is_buffer_file(url.toLocalFile())) {
+            open_buffer_file(url.toLocalFile());
+        }
+    }
+
+    event->acceptProposedAction();
+}
+
+
 bool MainWindow::eventFilter(QObject* target, QEvent* event)
 {
     KeyboardState::update_keyboard_state(event);
 
+    // Held navigation keys move the camera from the update loop
+    if (is_animating()) {
+        schedule_loop();
+    }
+
     if (event->type() == QEvent::KeyPress) {
         QKeyEvent* key_event = static_cast<QKeyEvent*>(event);
 
@@ -132,7 +169,7 @@ bool MainWindow::eventFilter(QObject* target, QEvent* event)
         }
 
         if (event_intercepted == EventProcessCode::INTERCEPTED) {
-            request_render_update_ = true;
+            request_render_update();
             update_status_bar();
 
             event->accept();
@@ -150,35 +187,35 @@ void MainWindow::recenter_buffer()
 {
     if (link_views_enabled_) {
         for (auto& stage : stages_) {
-            GameObject* cam_obj = stage.second->get_game_object("camera");
-            Camera* cam = cam_obj->get_component<Camera>("camera_component");
+            Camera* cam = stage.second->get_camera_component();
             cam->recenter_camera();
         }
     } else {
         if (currently_selected_stage_ != nullptr) {
-            GameObject* cam_obj =
-                currently_selected_stage_->get_game_object("camera");
-            Camera* cam = cam_obj->get_component<Camera>("camera_component");
+            Camera* cam = currently_selected_stage_->get_camera_component();
             cam->recenter_camera();
         }
     }
 
-    request_render_update_ = true;
+    request_render_update();
 }
 
 
 void MainWindow::link_views_toggle()
 {
     link_views_enabled_ = !link_views_enabled_;
+
+    if (link_views_enabled_) {
+        sync_linked_views();
+        request_render_update();
+    }
 }
 
 
 void MainWindow::rotate_90_cw()
 {
     const auto request_90_cw_rotation = [](Stage* stage) {
-        GameObject* buffer_obj = stage->get_game_object("buffer");
-        Buffer* buffer_comp =
-            buffer_obj->get_component<Buffer>("buffer_component");
+        Buffer* buffer_comp = stage->get_buffer_component();
 
         buffer_comp->rotate(static_cast<float>(90.0 * M_PI / 180.0));
     };
@@ -193,16 +230,14 @@ void MainWindow::rotate_90_cw()
         }
     }
 
-    request_render_update_ = true;
+    request_render_update();
 }
 
 
 void MainWindow::rotate_90_ccw()
 {
     const auto request_90_ccw_rotation = [](Stage* stage) {
-        GameObject* buffer_obj = stage->get_game_object("buffer");
-        Buffer* buffer_comp =
-            buffer_obj->get_component<Buffer>("buffer_component");
+        Buffer* buffer_comp = stage->get_buffer_component();
 
         buffer_comp->rotate(static_cast<float>(-90.0 * M_PI / 180.0));
     };
@@ -217,17 +252,24 @@ void MainWindow::rotate_90_ccw()
         }
     }
 
-    request_render_update_ = true;
+    request_render_update();
 }
 
 
-void MainWindow::buffer_selected(QListWidgetItem* item)
+void MainWindow::buffer_selected(const QModelIndex& index)
 {
-    if (item == nullptr)
+    if (!index.isValid())
         return;
 
-    auto stage =
-        stages_.find(item->data(Qt::UserRole).toString().toStdString());
+    const string buffer_name = buffer_list_->buffer_name(index);
+
+    // Buffer files get their stage once they are first selected
+    if (stages_.find(buffer_name) == stages_.end() &&
+        buffer_files_.find(buffer_name) != buffer_files_.end()) {
+        load_buffer_file(buffer_name);
+    }
+
+    auto stage = stages_.find(buffer_name);
     if (stage != stages_.end()) {
         set_currently_selected_stage(stage->second.get());
         reset_ac_min_labels();
@@ -240,14 +282,12 @@ void MainWindow::buffer_selected(QListWidgetItem* item)
 
 void MainWindow::remove_selected_buffer()
 {
-    if (ui_->imageList->count() > 0 && currently_selected_stage_ != nullptr) {
-        QListWidgetItem* removed_item =
-            ui_->imageList->takeItem(ui_->imageList->currentRow());
-        string buffer_name =
-            removed_item->data(Qt::UserRole).toString().toStdString();
-        stages_.erase(buffer_name);
-        held_buffers_.erase(buffer_name);
-        delete removed_item;
+    const QModelIndex removed_index = ui_->imageList->currentIndex();
+    if (removed_index.isValid() && currently_selected_stage_ != nullptr) {
+        string buffer_name = buffer_list_->buffer_name(removed_index);
+        buffer_list_->remove_buffer(buffer_name);
+
+        forget_buffer(buffer_name);
 
         removed_buffer_names_.insert(buffer_name);
 
@@ -260,12 +300,45 @@ void MainWindow::remove_selected_buffer()
 }
 
 
+void MainWindow::forget_buffer(const string& buffer_name)
+{
+    forget_comparisons_with(buffer_name);
+    forget_viewed_buffer(buffer_name);
+
+    auto stage = stages_.find(buffer_name);
+    if (stage != stages_.end() &&
+        stage->second.get() == currently_selected_stage_) {
+        set_currently_selected_stage(nullptr);
+    }
+
+    stages_.erase(buffer_name);
+    held_buffers_.erase(buffer_name);
+    compressed_buffers_.erase(buffer_name);
+    refining_buffers_.erase(buffer_name);
+    lazy_buffers_.erase(buffer_name);
+    tensor_slices_.erase(buffer_name);
+    superseded_buffers_.erase(buffer_name);
+    traced_plots_.erase(buffer_name);
+    buffer_update_times_.erase(buffer_name);
+    shared_buffers_.erase(buffer_name);
+    buffer_files_.erase(buffer_name);
+    recorders_.erase(buffer_name);
+    histories_.erase(buffer_name);
+    if (history_buffer_name_ == buffer_name) {
+        history_buffer_name_.clear();
+        history_contents_.clear();
+    }
+}
+
+
 void MainWindow::symbol_selected()
 {
     QByteArray symbol_name_qba = ui_->symbolList->text().toLocal8Bit();
     const char* symbol_name    = symbol_name_qba.constData();
     if (ui_->symbolList->text().length() > 0) {
-        request_plot_buffer(symbol_name);
+        if (!show_prefetched_buffer(symbol_name)) {
+            request_plot_buffer(symbol_name);
+        }
         // Clear symbol input
         ui_->symbolList->setText("");
     }
@@ -276,7 +349,9 @@ void MainWindow::symbol_completed(QString str)
 {
     if (str.length() > 0) {
         QByteArray symbol_name_qba = str.toLocal8Bit();
-        request_plot_buffer(symbol_name_qba.constData());
+        if (!show_prefetched_buffer(symbol_name_qba.constData())) {
+            request_plot_buffer(symbol_name_qba.constData());
+        }
         // Clear symbol input
         ui_->symbolList->setText("");
         ui_->symbolList->clearFocus();
@@ -288,11 +363,10 @@ void MainWindow::export_buffer()
 {
     auto sender_action(static_cast<QAction*>(sender()));
 
-    auto stage =
-        stages_.find(sender_action->data().toString().toStdString())->second;
+    const string buffer_name = sender_action->data().toString().toStdString();
+    auto stage = stages_.find(buffer_name)->second;
 
-    GameObject* buffer_obj = stage->get_game_object("buffer");
-    Buffer* component = buffer_obj->get_component<Buffer>("buffer_component");
+    Buffer* component = stage->get_buffer_component();
 
     QFileDialog file_dialog(this);
     file_dialog.setAcceptMode(QFileDialog::AcceptSave);
@@ -303,6 +377,8 @@ void MainWindow::export_buffer()
         BufferExporter::OutputType::Bitmap;
     output_extensions[tr("Octave Raw Matrix (*.oct)")] =
         BufferExporter::OutputType::OctaveMatrix;
+    output_extensions[tr("NumPy Array (*.npy)")] =
+        BufferExporter::OutputType::NumpyArray;
 
     // Generate the save suffix string
     QHashIterator<QString, BufferExporter::OutputType> it(output_extensions);
@@ -323,11 +399,50 @@ void MainWindow::export_buffer()
         string file_name = file_dialog.selectedFiles()[0].toStdString();
         const auto selected_filter = file_dialog.selectedNameFilter();
 
-        // Export buffer
-        BufferExporter::export_buffer(
-            component,
-            file_name,
-            output_extensions[selected_filter]);
+        // Compressed buffers must be restored to be read by the export
+        if (component->buffer == nullptr) {
+            restore_held_buffer(buffer_name);
+        }
+
+        // The bridge rewrites shared segments in place, so their contents
+        // are copied for the export under the segment lock
+        const auto shared_buffer = shared_buffers_.find(buffer_name);
+        QSharedMemory* segment   = shared_buffer != shared_buffers_.end()
+                                     ? shared_buffer->second.get()
+                                     : nullptr;
+        if (segment != nullptr) {
+            segment->lock();
+        }
+
+        // Encode and write the buffer in the background
+        const BufferExporter::ExportTask export_task =
+            BufferExporter::prepare_export(
+                component, file_name, output_extensions[selected_filter]);
+
+        if (segment != nullptr) {
+            segment->unlock();
+        }
+
+        const QString file_name_qstr = file_dialog.selectedFiles()[0];
+
+        // Every export reports back through buffer_export_finished
+        ++running_exports_;
+
+        if (export_task == nullptr) {
+            buffer_export_finished(file_name_qstr, false);
+        } else {
+            export_progress_bar_->show();
+
+            pending_exports_.push_back(
+                async(launch::async, [this, export_task, file_name_qstr]() {
+                    const bool succeeded = export_task();
+                    QMetaObject::invokeMethod(this,
+                                              "buffer_export_finished",
+                                              Qt::QueuedConnection,
+                                              Q_ARG(QString, file_name_qstr),
+                                              Q_ARG(bool, succeeded));
+                }));
+        }
 
         // Update default export suffix to the previously used suffix
         default_export_suffix_ = selected_filter;
@@ -338,9 +453,37 @@ void MainWindow::export_buffer()
 }
 
 
+void MainWindow::buffer_export_finished(QString file_name, bool succeeded)
+{
+    // Release the exports that have already returned
+    pending_exports_.erase(
+        remove_if(pending_exports_.begin(),
+                  pending_exports_.end(),
+                  [](const future<void>& export_future) {
+                      return export_future.wait_for(chrono::seconds(0)) ==
+                             future_status::ready;
+                  }),
+        pending_exports_.end());
+
+    --running_exports_;
+    if (running_exports_ == 0) {
+        export_progress_bar_->hide();
+    }
+
+    if (succeeded) {
+        statusBar()->showMessage("Exported " + file_name, 5000);
+    } else {
+        statusBar()->showMessage("Could not export " + file_name, 5000);
+        cerr << "[OpenImageDebugger] Could not export "
+             << file_name.toStdString() << endl;
+    }
+}
+
+
 void MainWindow::show_context_menu(const QPoint& pos)
 {
-    if (ui_->imageList->itemAt(pos) != nullptr) {
+    const QModelIndex index = ui_->imageList->indexAt(pos);
+    if (index.isValid()) {
         // Handle global position
         QPoint globalPos = ui_->imageList->mapToGlobal(pos);
 
@@ -350,8 +493,37 @@ void MainWindow::show_context_menu(const QPoint& pos)
         QAction* exportAction =
             myMenu.addAction("Export buffer", this, SLOT(export_buffer()));
 
-        // Add parameter to action: buffer name
-        exportAction->setData(ui_->imageList->itemAt(pos)->data(Qt::UserRole));
+        const QVariant buffer_name = index.data(Qt::UserRole);
+        const bool is_recording =
+            recorders_.find(buffer_name.toString().toStdString()) !=
+            recorders_.end();
+
+        QAction* recordAction = myMenu.addAction(
+            is_recording ? "Stop recording" : "Record buffer",
+            this,
+            SLOT(toggle_buffer_recording()));
+
+        // Add parameter to actions: buffer name
+        exportAction->setData(buffer_name);
+        recordAction->setData(buffer_name);
+
+        // Buffers are compared with the selected one
+        if (currently_selected_stage_ != nullptr) {
+            const string selected_name =
+                currently_selected_stage_->buffer_metadata.variable_name;
+
+            if (selected_name != buffer_name.toString().toStdString()) {
+                myMenu
+                    .addAction("Compare selected buffer with this one",
+                               this,
+                               SLOT(compare_with_buffer()))
+                    ->setData(buffer_name);
+            } else if (comparisons_.find(selected_name) !=
+                       comparisons_.end()) {
+                myMenu.addAction(
+                    "Stop comparing", this, SLOT(stop_comparing()));
+            }
+        }
 
         // Show context menu at handling position
         myMenu.exec(globalPos);
@@ -365,9 +537,7 @@ void MainWindow::toggle_go_to_dialog()
         vec4 default_goal(0, 0, 0, 0);
 
         if (currently_selected_stage_ != nullptr) {
-            GameObject* cam_obj =
-                currently_selected_stage_->get_game_object("camera");
-            Camera* cam = cam_obj->get_component<Camera>("camera_component");
+            Camera* cam = currently_selected_stage_->get_camera_component();
 
             default_goal = cam->get_position();
         }
@@ -391,5 +561,5 @@ void MainWindow::go_to_pixel(float x, float y)
 
     update_status_bar();
 
-    request_render_update_ = true;
+    request_render_update();
 }
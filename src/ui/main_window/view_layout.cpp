@@ -0,0 +1,313 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include "main_window.h"
+
+#include "ui_main_window.h"
+#include "visualization/components/camera.h"
+#include "visualization/game_object.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+// Gap between the views, through which the canvas background shows
+const int view_spacing = 2;
+
+
+Camera* get_camera_component(Stage* stage)
+{
+    return stage->get_camera_component();
+}
+
+} // namespace
+
+
+void MainWindow::select_view_at(int x, int y)
+{
+    const int view_count = static_cast<int>(view_buffers_.size());
+    for (int view = 0; view < view_count; ++view) {
+        if (view == active_view_ || !view_rect(view).contains(x, y)) {
+            continue;
+        }
+
+        active_view_ = view;
+        ui_->bufferPreview->set_viewport(view_rect(view));
+
+        // Selecting the list item selects its stage, which the view already
+        // shows. An empty view waits for a buffer to be selected.
+        const QModelIndex view_index =
+            buffer_list_->buffer_index(view_buffers_[view]);
+
+        if (view_index.isValid() &&
+            stages_.find(view_buffers_[view]) != stages_.end()) {
+            ui_->imageList->setCurrentIndex(view_index);
+        } else {
+            ui_->imageList->setCurrentIndex(QModelIndex());
+            set_currently_selected_stage(nullptr);
+        }
+
+        update_status_bar();
+        request_render_update();
+        return;
+    }
+}
+
+
+void MainWindow::cycle_view_layout()
+{
+    if (view_columns_ == 1) {
+        view_columns_ = 2;
+    } else if (view_rows_ == 1) {
+        view_rows_ = 2;
+    } else {
+        view_columns_ = view_rows_ = 1;
+    }
+
+    const size_t previous_count = view_buffers_.size();
+    const size_t view_count = static_cast<size_t>(view_columns_ * view_rows_);
+    view_buffers_.resize(view_count);
+
+    // New views show the most recently selected buffers not in view yet
+    vector<Stage*> candidates;
+    for (const auto& stage : stages_) {
+        if (find(view_buffers_.begin(),
+                 view_buffers_.end(),
+                 stage.first) == view_buffers_.end() &&
+            !is_prefetched_buffer(stage.first)) {
+            candidates.push_back(stage.second.get());
+        }
+    }
+    sort(candidates.begin(), candidates.end(), [](Stage* a, Stage* b) {
+        return a->selection_order > b->selection_order;
+    });
+
+    auto candidate = candidates.begin();
+    for (size_t view = previous_count;
+         view < view_count && candidate != candidates.end();
+         ++view, ++candidate) {
+        view_buffers_[view] = (*candidate)->buffer_metadata.variable_name;
+        restore_held_buffer(view_buffers_[view]);
+    }
+
+    // The selected buffer stays in view
+    if (active_view_ >= static_cast<int>(view_count)) {
+        active_view_ = 0;
+        show_in_active_view(currently_selected_stage_);
+    }
+
+    resize_views();
+    if (link_views_enabled_) {
+        sync_linked_views();
+    }
+
+    report_displayed_buffers();
+    enforce_memory_budget();
+    update_status_bar();
+    request_render_update();
+}
+
+
+QRect MainWindow::view_rect(int view) const
+{
+    const QRect canvas = ui_->bufferPreview->rect();
+
+    const int width =
+        (canvas.width() - (view_columns_ - 1) * view_spacing) / view_columns_;
+    const int height =
+        (canvas.height() - (view_rows_ - 1) * view_spacing) / view_rows_;
+
+    const int column = view % view_columns_;
+    const int row    = view / view_columns_;
+
+    return QRect(column * (width + view_spacing),
+                 row * (height + view_spacing),
+                 max(width, 1),
+                 max(height, 1));
+}
+
+
+vector<Stage*> MainWindow::viewed_stages()
+{
+    vector<Stage*> result;
+    if (currently_selected_stage_ != nullptr) {
+        result.push_back(currently_selected_stage_);
+    }
+
+    for (const string& buffer_name : view_buffers_) {
+        auto stage = stages_.find(buffer_name);
+        if (stage != stages_.end() &&
+            stage->second.get() != currently_selected_stage_) {
+            result.push_back(stage->second.get());
+        }
+    }
+
+    return result;
+}
+
+
+void MainWindow::resize_views()
+{
+    const QRect viewport = view_rect(active_view_);
+    ui_->bufferPreview->set_viewport(viewport);
+
+    for (auto& stage : stages_) {
+        stage.second->resize_callback(viewport.width(), viewport.height());
+    }
+}
+
+
+void MainWindow::draw_views()
+{
+    GLCanvas* canvas = ui_->bufferPreview;
+
+    const int view_count = static_cast<int>(view_buffers_.size());
+    for (int view = 0; view < view_count; ++view) {
+        auto stage = stages_.find(view_buffers_[view]);
+        if (stage == stages_.end()) {
+            continue;
+        }
+
+        // Stages created since the last resize still have the size of the
+        // whole canvas
+        const QRect region = view_rect(view);
+        stage->second->resize_callback(region.width(), region.height());
+
+        canvas->set_draw_region(region);
+        stage->second->draw();
+    }
+
+    canvas->set_draw_region(canvas->viewport());
+}
+
+
+void MainWindow::show_in_active_view(Stage* stage)
+{
+    if (stage == nullptr) {
+        return;
+    }
+
+    const string& buffer_name = stage->buffer_metadata.variable_name;
+
+    // Each buffer is shown by a single view
+    replace(view_buffers_.begin(), view_buffers_.end(), buffer_name, string());
+    view_buffers_[static_cast<size_t>(active_view_)] = buffer_name;
+
+    // Buffers entering a view while linked take the pose of the others
+    if (!link_views_enabled_) {
+        return;
+    }
+
+    for (const string& viewed_name : view_buffers_) {
+        auto viewed = stages_.find(viewed_name);
+        if (viewed != stages_.end() && viewed->second.get() != stage) {
+            *get_camera_component(stage) =
+                *get_camera_component(viewed->second.get());
+            return;
+        }
+    }
+}
+
+
+void MainWindow::sync_linked_views()
+{
+    if (currently_selected_stage_ == nullptr) {
+        return;
+    }
+
+    const Camera* active_camera =
+        get_camera_component(currently_selected_stage_);
+
+    for (Stage* stage : viewed_stages()) {
+        if (stage != currently_selected_stage_) {
+            *get_camera_component(stage) = *active_camera;
+        }
+    }
+}
+
+
+bool MainWindow::is_buffer_displayed(const string& buffer_name) const
+{
+    for (const string& viewed_name : view_buffers_) {
+        if (viewed_name.empty()) {
+            continue;
+        }
+
+        if (viewed_name == buffer_name) {
+            return true;
+        }
+
+        // The buffer a viewed one is compared with is displayed along
+        auto comparison = comparisons_.find(viewed_name);
+        if (comparison != comparisons_.end() &&
+            comparison->second == buffer_name) {
+            return true;
+        }
+    }
+
+    return currently_selected_stage_ != nullptr &&
+           currently_selected_stage_->buffer_metadata.variable_name ==
+               buffer_name;
+}
+
+
+void MainWindow::forget_viewed_buffer(const string& buffer_name)
+{
+    replace(view_buffers_.begin(), view_buffers_.end(), buffer_name, string());
+    report_displayed_buffers();
+}
+
+
+void MainWindow::report_displayed_buffers()
+{
+    if (host_settings_.is_offline || network_worker_ == nullptr) {
+        return;
+    }
+
+    // Buffers opened from disk aren't known to the bridge
+    vector<string> displayed_buffers;
+    for (Stage* stage : viewed_stages()) {
+        const string& buffer_name = stage->buffer_metadata.variable_name;
+        if (buffer_files_.find(buffer_name) == buffer_files_.end()) {
+            displayed_buffers.push_back(buffer_name);
+        }
+    }
+
+    if (displayed_buffers == reported_displayed_buffers_) {
+        return;
+    }
+
+    MessageComposer message_composer;
+    message_composer.push(MessageType::SetDisplayedBuffers)
+        .push(displayed_buffers);
+    network_worker_->send(message_composer);
+
+    reported_displayed_buffers_ = move(displayed_buffers);
+}
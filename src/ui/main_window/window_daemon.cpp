@@ -0,0 +1,162 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <iostream>
+
+#include <QLocalSocket>
+
+#include "main_window.h"
+
+#include "ui_main_window.h"
+#include "ipc/window_daemon.h"
+
+
+using namespace std;
+
+
+void MainWindow::initialize_window_daemon()
+{
+    const QString server_name = window_daemon_server_name();
+    if (server_name.isEmpty()) {
+        cerr << "[OpenImageDebugger] Could not listen for debugging sessions: "
+             << "no private runtime directory" << endl;
+        return;
+    }
+
+    session_server_ = new QLocalServer(this);
+    session_server_->setSocketOptions(QLocalServer::UserAccessOption);
+
+    // Daemons are only started once no other one answers, so the socket
+    // could only have been left behind by one which crashed
+    QLocalServer::removeServer(server_name);
+    if (!session_server_->listen(server_name)) {
+        cerr << "[OpenImageDebugger] Could not listen for debugging sessions: "
+             << session_server_->errorString().toStdString() << endl;
+        return;
+    }
+
+    connect(session_server_,
+            SIGNAL(newConnection()),
+            this,
+            SLOT(accept_session_requests()));
+}
+
+
+void MainWindow::connect_to_bridge(const string& url, uint16_t port)
+{
+    network_worker_.reset(new NetworkWorker());
+
+    connect(network_worker_.get(),
+            SIGNAL(messages_received()),
+            this,
+            SLOT(decode_incoming_messages()));
+    // The loop is the one closing the window once the bridge is gone
+    connect(network_worker_.get(), SIGNAL(disconnected()), this, SLOT(loop()));
+
+    if (port != 0 && network_worker_->connect_to_host(url, port)) {
+        send_transport_settings();
+
+        // The bridge of a new session knows nothing about the window yet
+        reported_displayed_buffers_.clear();
+        report_displayed_buffers();
+    }
+}
+
+
+void MainWindow::reset_session()
+{
+    evict_prefetched_buffers();
+
+    // Opened files don't belong to the session, and are kept
+    for (int row = buffer_list_->rowCount() - 1; row >= 0; --row) {
+        const string buffer_name =
+            buffer_list_->buffer_name(buffer_list_->index(row));
+        if (buffer_files_.find(buffer_name) != buffer_files_.end()) {
+            continue;
+        }
+
+        previous_session_buffers_.insert(buffer_name);
+
+        buffer_list_->remove_buffer(buffer_name);
+        forget_buffer(buffer_name);
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(ui_mutex_);
+        available_vars_.clear();
+        available_vars_version_ = 0;
+    }
+    completer_updated_ = true;
+
+    is_receiving_plot_batch_ = false;
+    is_stop_displayed_       = true;
+    has_stop_batch_ended_    = false;
+
+    update_status_bar();
+    request_render_update();
+}
+
+
+void MainWindow::accept_session_requests()
+{
+    while (QLocalSocket* socket = session_server_->nextPendingConnection()) {
+        connect(socket,
+                SIGNAL(readyRead()),
+                this,
+                SLOT(read_session_request()));
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+    }
+}
+
+
+void MainWindow::read_session_request()
+{
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+    if (socket == nullptr || !socket->canReadLine()) {
+        return;
+    }
+
+    uint16_t port;
+    if (!read_window_daemon_request(socket, port)) {
+        socket->disconnectFromServer();
+        return;
+    }
+
+    // Sessions are served one at a time. The others get windows of their
+    // own.
+    const bool is_accepted = !network_worker_->is_connected();
+    answer_window_daemon_request(socket, is_accepted);
+    socket->disconnectFromServer();
+
+    if (!is_accepted) {
+        return;
+    }
+
+    reset_session();
+    connect_to_bridge(host_settings_.url, port);
+
+    raise();
+    activateWindow();
+}
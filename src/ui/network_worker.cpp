@@ -0,0 +1,284 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstring>
+
+#include <QBuffer>
+
+#include "network_worker.h"
+
+#include "math/float_conversion.h"
+#include "system/trace/tracer.h"
+
+
+using namespace std;
+
+
+/**
+ * Buffers kept by the worker for reuse. Larger buffers are released.
+ */
+const size_t max_pooled_buffers     = 4;
+const size_t max_pooled_buffer_size = 64 * 1024 * 1024;
+
+
+NetworkWorker::NetworkWorker()
+    : socket_(nullptr)
+    , is_connected_(false)
+    , is_notification_pending_(false)
+    , is_int32_converted_(true)
+    , stop_generation_(0)
+    , received_bytes_(0)
+{
+    moveToThread(&thread_);
+    thread_.start();
+}
+
+
+NetworkWorker::~NetworkWorker()
+{
+    QMetaObject::invokeMethod(
+        this, "close_socket", Qt::BlockingQueuedConnection);
+
+    thread_.quit();
+    thread_.wait();
+}
+
+
+bool NetworkWorker::connect_to_host(const string& url, uint16_t port)
+{
+    bool is_connected = false;
+    QMetaObject::invokeMethod(this,
+                              "connect_socket",
+                              Qt::BlockingQueuedConnection,
+                              Q_RETURN_ARG(bool, is_connected),
+                              Q_ARG(QString, QString::fromStdString(url)),
+                              Q_ARG(quint16, port));
+
+    return is_connected;
+}
+
+
+bool NetworkWorker::is_connected() const
+{
+    return is_connected_;
+}
+
+
+void NetworkWorker::send(const MessageComposer& message_composer)
+{
+    QByteArray message;
+    QBuffer device(&message);
+    device.open(QIODevice::WriteOnly);
+    message_composer.send(&device);
+
+    QMetaObject::invokeMethod(this,
+                              "write_message",
+                              Qt::QueuedConnection,
+                              Q_ARG(QByteArray, message));
+}
+
+
+bool NetworkWorker::pop_message(ReceivedMessage& message)
+{
+    // Cleared before draining, so messages pushed meanwhile signal again
+    is_notification_pending_ = false;
+
+    return received_messages_.pop(message);
+}
+
+
+void NetworkWorker::recycle_buffer(vector<uint8_t>&& buffer)
+{
+    if (buffer.capacity() > 0 && buffer.capacity() <= max_pooled_buffer_size) {
+        recycled_buffers_.push(std::move(buffer));
+    }
+}
+
+
+void NetworkWorker::set_int32_converted_to_float(bool is_converted)
+{
+    is_int32_converted_ = is_converted;
+}
+
+
+uint64_t NetworkWorker::stop_generation() const
+{
+    return stop_generation_;
+}
+
+
+uint64_t NetworkWorker::received_bytes() const
+{
+    return received_bytes_;
+}
+
+
+bool NetworkWorker::connect_socket(const QString& url, quint16 port)
+{
+    socket_ = new QTcpSocket();
+
+    connect(socket_, SIGNAL(readyRead()), this, SLOT(read_messages()));
+    connect(
+        socket_, SIGNAL(disconnected()), this, SLOT(handle_disconnection()));
+
+    socket_->connectToHost(url, port);
+    is_connected_ = socket_->waitForConnected();
+
+    return is_connected_;
+}
+
+
+void NetworkWorker::close_socket()
+{
+    delete socket_;
+    socket_ = nullptr;
+}
+
+
+void NetworkWorker::read_messages()
+{
+    bool has_received = false;
+
+    // Partial messages stay buffered in the reader until more data arrives
+    while (message_reader_.read_available(socket_)) {
+        ReceivedMessage message;
+        message.type = message_reader_.message_type();
+
+        if (message.type == MessageType::PlotBufferStop) {
+            ++stop_generation_;
+        }
+        message.stop_generation = stop_generation_;
+
+        message.correlation_id = message_reader_.correlation_id();
+        TraceCorrelation correlation(message.correlation_id);
+        TraceSpan span("decode message");
+        Tracer::instance().flow_end(message.correlation_id, Tracer::now());
+
+        MessageDecoder message_decoder = message_reader_.message_decoder();
+        received_bytes_ += sizeof(size_t) + sizeof(uint64_t) +
+                           message_decoder.remaining();
+
+        if (message.type == MessageType::PlotBufferContents ||
+            message.type == MessageType::PlotBufferCompressedContents) {
+            decode_plot(message_decoder, message);
+        } else {
+            const uint8_t* body = message_decoder.unread_data();
+            message.body        = acquire_buffer();
+            message.body.assign(body, body + message_decoder.remaining());
+        }
+
+        message_reader_.pop_message();
+
+        received_messages_.push(std::move(message));
+        has_received = true;
+    }
+
+    if (has_received && !is_notification_pending_.exchange(true)) {
+        Q_EMIT messages_received();
+    }
+}
+
+
+void NetworkWorker::write_message(const QByteArray& message)
+{
+    if (socket_ != nullptr) {
+        socket_->write(message);
+    }
+}
+
+
+void NetworkWorker::handle_disconnection()
+{
+    is_connected_ = false;
+
+    Q_EMIT disconnected();
+}
+
+
+void NetworkWorker::decode_plot(MessageDecoder& message_decoder,
+                                ReceivedMessage& message)
+{
+    BufferMetadata& metadata = message.metadata;
+    message_decoder.read(metadata);
+
+    message.is_decoded_plot = true;
+    message.is_float_copy =
+        metadata.type == BufferType::Float64 ||
+        ((metadata.type == BufferType::Int32 ||
+          metadata.type == BufferType::UInt32) &&
+         is_int32_converted_);
+
+    if (message.type == MessageType::PlotBufferContents) {
+        size_t length;
+        const uint8_t* payload = message_decoder.read_payload(length);
+
+        // Float copies are converted straight from the message
+        if (message.is_float_copy) {
+            message.contents =
+                make_float_buffer(payload, metadata.type, length);
+        } else {
+            message.contents = HostBuffer(length);
+            if (length > 0) {
+                memcpy(message.contents.data(), payload, length);
+            }
+        }
+        return;
+    }
+
+    message_decoder.read_compressed(message.contents);
+
+    if (message.is_float_copy && !message.contents.empty()) {
+        const HostBuffer decompressed = std::move(message.contents);
+
+        message.contents = make_float_buffer(
+            decompressed.data(), metadata.type, decompressed.size());
+    }
+}
+
+
+vector<uint8_t> NetworkWorker::acquire_buffer()
+{
+    vector<uint8_t> recycled;
+    while (recycled_buffers_.pop(recycled)) {
+        release_buffer(std::move(recycled));
+    }
+
+    vector<uint8_t> buffer;
+    if (!buffer_pool_.empty()) {
+        buffer.swap(buffer_pool_.back());
+        buffer_pool_.pop_back();
+    }
+
+    return buffer;
+}
+
+
+void NetworkWorker::release_buffer(vector<uint8_t>&& buffer)
+{
+    if (buffer_pool_.size() < max_pooled_buffers &&
+        buffer.capacity() <= max_pooled_buffer_size) {
+        buffer_pool_.push_back(std::move(buffer));
+    }
+}
@@ -0,0 +1,169 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef NETWORK_WORKER_H_
+#define NETWORK_WORKER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <QByteArray>
+#include <QObject>
+#include <QTcpSocket>
+#include <QThread>
+
+#include "ipc/message_exchange.h"
+#include "system/memory/host_buffer_pool.h"
+#include "system/thread/spsc_queue.h"
+
+
+/**
+ * Message received from the bridge, handed over to the GUI thread
+ */
+struct ReceivedMessage
+{
+    MessageType type = MessageType::PlotBufferUnchanged;
+
+    // Message body, without its header. Left empty for decoded plots.
+    std::vector<uint8_t> body;
+
+    // PlotBufferContents and PlotBufferCompressedContents are decoded by the
+    // worker: contents holds the buffer, converted to float if
+    // is_float_copy is set
+    bool is_decoded_plot = false;
+    bool is_float_copy   = false;
+    BufferMetadata metadata;
+    HostBuffer contents;
+
+    // Debugger stops announced by the bridge before this message
+    uint64_t stop_generation = 0;
+
+    // Traced plot the message belongs to, zero if it isn't traced
+    uint64_t correlation_id = 0;
+};
+
+
+/**
+ * Owns the connection to the bridge in a dedicated thread, which receives
+ * and decodes the incoming messages and writes the outgoing ones. Received
+ * messages are passed to the GUI thread through a lock-free queue, and
+ * messages_received() is emitted whenever new ones are available.
+ */
+class NetworkWorker : public QObject
+{
+    Q_OBJECT
+
+  public:
+    NetworkWorker();
+
+    ~NetworkWorker();
+
+    /**
+     * Blocks until the worker has connected to the bridge, or has given up
+     */
+    bool connect_to_host(const std::string& url, uint16_t port);
+
+    bool is_connected() const;
+
+    /**
+     * Serializes the message in the calling thread and queues it for
+     * writing. Messages are written in the order they are sent.
+     */
+    void send(const MessageComposer& message_composer);
+
+    /**
+     * Consumer side of the received messages. Must be called until it
+     * returns false after each messages_received() signal.
+     */
+    bool pop_message(ReceivedMessage& message);
+
+    /**
+     * Hands a message body the GUI thread no longer needs back to the
+     * worker, which reuses it for the next messages. Only the GUI thread may
+     * call it. Plot contents are returned to the host buffer pool instead.
+     */
+    void recycle_buffer(std::vector<uint8_t>&& buffer);
+
+    /**
+     * Whether Int32 and UInt32 buffers are displayed from a float copy,
+     * which the worker then creates while decoding them
+     */
+    void set_int32_converted_to_float(bool is_converted);
+
+    /**
+     * Debugger stops announced by the bridge so far, including those whose
+     * messages haven't been popped yet. Plots of the previous stops still
+     * queued are superseded.
+     */
+    uint64_t stop_generation() const;
+
+    // Bytes received from the bridge so far, headers included
+    uint64_t received_bytes() const;
+
+  Q_SIGNALS:
+    void messages_received();
+
+    void disconnected();
+
+  private Q_SLOTS:
+    bool connect_socket(const QString& url, quint16 port);
+
+    void close_socket();
+
+    void read_messages();
+
+    void write_message(const QByteArray& message);
+
+    void handle_disconnection();
+
+  private:
+    void decode_plot(MessageDecoder& message_decoder,
+                     ReceivedMessage& message);
+
+    std::vector<uint8_t> acquire_buffer();
+
+    void release_buffer(std::vector<uint8_t>&& buffer);
+
+    QThread thread_;
+
+    // Only used by the worker thread
+    QTcpSocket* socket_;
+    MessageStreamReader message_reader_;
+    std::vector<std::vector<uint8_t>> buffer_pool_;
+
+    SpscQueue<ReceivedMessage> received_messages_;
+    SpscQueue<std::vector<uint8_t>> recycled_buffers_;
+
+    std::atomic<bool> is_connected_;
+    std::atomic<bool> is_notification_pending_;
+    std::atomic<bool> is_int32_converted_;
+    std::atomic<uint64_t> stop_generation_;
+    std::atomic<uint64_t> received_bytes_;
+};
+
+
+#endif // NETWORK_WORKER_H_
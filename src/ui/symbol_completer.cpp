@@ -23,30 +23,75 @@
  * IN THE SOFTWARE.
  */
 
+#include <memory>
+
+#include <QAbstractItemView>
+#include <QWidget>
+
 #include "symbol_completer.h"
 
+#include "ui/symbol_index.h"
+
+
+using namespace std;
+
 
 SymbolCompleter::SymbolCompleter(QObject* parent)
     : QCompleter(parent)
     , list_()
     , model_()
+    , worker_(&SymbolCompleter::worker_loop, this)
 {
     setModel(&model_);
 }
 
 
+SymbolCompleter::~SymbolCompleter()
+{
+    {
+        unique_lock<mutex> lock(mutex_);
+        is_stopping_ = true;
+    }
+    request_available_.notify_one();
+
+    worker_.join();
+}
+
+
 void SymbolCompleter::update(const QString& word)
 {
-    QStringList filtered = list_.filter(word, caseSensitivity());
-    model_.setStringList(filtered);
     word_ = word;
-    complete();
+
+    {
+        unique_lock<mutex> lock(mutex_);
+        pending_word_     = word.toStdString();
+        has_pending_word_ = true;
+    }
+    request_available_.notify_one();
 }
 
 
 void SymbolCompleter::update_symbol_list(const QStringList& symbols)
 {
+    if (symbols == list_) {
+        return;
+    }
+
     list_ = symbols;
+
+    vector<string> symbol_names;
+    symbol_names.reserve(static_cast<size_t>(symbols.size()));
+    for (const QString& symbol : symbols) {
+        symbol_names.push_back(symbol.toStdString());
+    }
+
+    {
+        unique_lock<mutex> lock(mutex_);
+        pending_symbols_           = std::move(symbol_names);
+        has_pending_symbols_       = true;
+        is_pending_case_sensitive_ = caseSensitivity() == Qt::CaseSensitive;
+    }
+    request_available_.notify_one();
 }
 
 
@@ -54,3 +99,103 @@ const QString& SymbolCompleter::word() const
 {
     return word_;
 }
+
+
+void SymbolCompleter::show_completions(const QStringList& completions,
+                                       const QString& word)
+{
+    // Completions of words since replaced, or of an input that lost focus,
+    // are dropped
+    if (word != word_ || widget() == nullptr || !widget()->hasFocus()) {
+        return;
+    }
+
+    model_.setStringList(completions);
+    complete();
+    popup()->setCurrentIndex(completionModel()->index(0, 0));
+
+    Q_EMIT completions_shown(completions);
+}
+
+
+void SymbolCompleter::worker_loop()
+{
+    unique_ptr<SymbolIndex> index(new SymbolIndex({}, false));
+
+    // Matches of the previous word, which contain those of any word
+    // extending it
+    string previous_word;
+    string previous_normalized_word;
+    vector<SymbolIndex::SymbolId> previous_matches;
+    bool has_previous_matches = false;
+
+    for (;;) {
+        vector<string> symbols;
+        bool has_symbols;
+        bool is_case_sensitive;
+        string word;
+        bool has_word;
+
+        {
+            unique_lock<mutex> lock(mutex_);
+            request_available_.wait(lock, [this]() {
+                return is_stopping_ || has_pending_symbols_ ||
+                       has_pending_word_;
+            });
+
+            if (is_stopping_) {
+                return;
+            }
+
+            has_symbols = has_pending_symbols_;
+            symbols.swap(pending_symbols_);
+            is_case_sensitive    = is_pending_case_sensitive_;
+            has_pending_symbols_ = false;
+
+            has_word = has_pending_word_;
+            word.swap(pending_word_);
+            has_pending_word_ = false;
+        }
+
+        if (has_symbols) {
+            index.reset(new SymbolIndex(std::move(symbols), is_case_sensitive));
+
+            // The shown completions are refreshed from the new symbols
+            if (!has_word && has_previous_matches) {
+                word     = previous_word;
+                has_word = true;
+            }
+            has_previous_matches = false;
+        }
+
+        if (!has_word) {
+            continue;
+        }
+
+        const string normalized_word = index->normalize(word);
+        const bool is_word_extended =
+            has_previous_matches &&
+            normalized_word.find(previous_normalized_word) != string::npos;
+
+        vector<SymbolIndex::SymbolId> matches =
+            is_word_extended ? index->refine(previous_matches, word)
+                             : index->find(word);
+
+        QStringList completions;
+        completions.reserve(static_cast<int>(matches.size()));
+        for (const SymbolIndex::SymbolId id : matches) {
+            completions.append(QString::fromStdString(index->symbol(id)));
+        }
+
+        QMetaObject::invokeMethod(this,
+                                  "show_completions",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(QStringList, completions),
+                                  Q_ARG(QString, QString::fromStdString(word)));
+
+        previous_word            = word;
+        previous_normalized_word = normalized_word;
+        previous_matches         = std::move(matches);
+        has_previous_matches     = true;
+    }
+}
@@ -26,11 +26,21 @@
 #ifndef SYMBOL_COMPLETER_H_
 #define SYMBOL_COMPLETER_H_
 
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include <QCompleter>
 #include <QStringList>
 #include <QStringListModel>
 
 
+/**
+ * Completer of the observable symbols. They are indexed and filtered by a
+ * worker thread, so that typing doesn't wait for large symbol lists.
+ */
 class SymbolCompleter : public QCompleter
 {
     Q_OBJECT
@@ -38,16 +48,46 @@ class SymbolCompleter : public QCompleter
   public:
     SymbolCompleter(QObject* parent = nullptr);
 
+    ~SymbolCompleter();
+
+    /**
+     * Shows the symbols containing the word, ranked, once they are filtered
+     */
     void update(const QString& word);
 
+    /**
+     * Replaces the symbols, which are indexed in the background. Lists equal
+     * to the current one are ignored.
+     */
     void update_symbol_list(const QStringList& symbols);
 
     const QString& word() const;
 
+  Q_SIGNALS:
+    // The completions shown for the current word, the most relevant first
+    void completions_shown(const QStringList& completions);
+
+  private Q_SLOTS:
+    void show_completions(const QStringList& completions, const QString& word);
+
   private:
+    void worker_loop();
+
     QStringList list_;
     QStringListModel model_;
     QString word_;
+
+    // Latest requests to the worker. They replace those it hasn't picked.
+    std::mutex mutex_;
+    std::condition_variable request_available_;
+    bool has_pending_symbols_ = false;
+    std::vector<std::string> pending_symbols_;
+    bool is_pending_case_sensitive_ = false;
+    bool has_pending_word_          = false;
+    std::string pending_word_;
+    bool is_stopping_ = false;
+
+    std::thread worker_;
 };
 
 
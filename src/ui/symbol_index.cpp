@@ -0,0 +1,245 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#include "symbol_index.h"
+
+
+using namespace std;
+
+
+namespace
+{
+
+char lower_case(char c)
+{
+    return static_cast<char>(tolower(static_cast<unsigned char>(c)));
+}
+
+
+bool is_word_character(char c)
+{
+    return isalnum(static_cast<unsigned char>(c)) != 0 || c == '_';
+}
+
+} // namespace
+
+
+SymbolIndex::SymbolIndex(vector<string> symbols, bool is_case_sensitive)
+    : is_case_sensitive_(is_case_sensitive)
+    , symbols_(std::move(symbols))
+{
+    size_t text_length = 0;
+    for (const auto& symbol : symbols_) {
+        text_length += symbol.size() + 1;
+    }
+
+    text_.reserve(text_length);
+    symbol_offsets_.reserve(symbols_.size());
+    position_owners_.reserve(text_length);
+    suffixes_.reserve(text_length - symbols_.size());
+
+    for (SymbolId id = 0; id < symbols_.size(); ++id) {
+        symbol_offsets_.push_back(static_cast<uint32_t>(text_.size()));
+
+        for (const char c : symbols_[id]) {
+            suffixes_.push_back(static_cast<uint32_t>(text_.size()));
+            position_owners_.push_back(id);
+            text_.push_back(c);
+        }
+
+        // Symbols can't contain null characters, so the suffixes of a
+        // symbol end with it
+        position_owners_.push_back(id);
+        text_.push_back('\0');
+    }
+
+    text_ = normalize(text_);
+
+    const char* text = text_.c_str();
+    sort(suffixes_.begin(), suffixes_.end(), [text](uint32_t a, uint32_t b) {
+        return strcmp(text + a, text + b) < 0;
+    });
+}
+
+
+vector<SymbolIndex::SymbolId> SymbolIndex::find(const string& query) const
+{
+    vector<SymbolId> ids;
+
+    if (query.empty()) {
+        ids.resize(symbols_.size());
+        for (SymbolId id = 0; id < symbols_.size(); ++id) {
+            ids[id] = id;
+        }
+    } else {
+        // The suffixes starting with the query are contiguous
+        const string normalized_query = normalize(query);
+        const char* text              = text_.c_str();
+        const char* needle            = normalized_query.c_str();
+        const size_t needle_length    = normalized_query.size();
+
+        const auto first = lower_bound(
+            suffixes_.begin(),
+            suffixes_.end(),
+            needle,
+            [text, needle_length](uint32_t suffix, const char* value) {
+                return strncmp(text + suffix, value, needle_length) < 0;
+            });
+        const auto last = upper_bound(
+            first,
+            suffixes_.end(),
+            needle,
+            [text, needle_length](const char* value, uint32_t suffix) {
+                return strncmp(value, text + suffix, needle_length) < 0;
+            });
+
+        // Symbols matching several times are only reported once
+        ids.reserve(static_cast<size_t>(last - first));
+        for (auto suffix = first; suffix != last; ++suffix) {
+            ids.push_back(position_owners_[*suffix]);
+        }
+        sort(ids.begin(), ids.end());
+        ids.erase(unique(ids.begin(), ids.end()), ids.end());
+    }
+
+    rank(ids, query);
+
+    return ids;
+}
+
+
+vector<SymbolIndex::SymbolId>
+SymbolIndex::refine(const vector<SymbolId>& candidates,
+                    const string& query) const
+{
+    const string normalized_query = normalize(query);
+
+    vector<SymbolId> ids;
+    for (const SymbolId id : candidates) {
+        if (id < symbols_.size() &&
+            strstr(normalized_symbol(id), normalized_query.c_str()) !=
+                nullptr) {
+            ids.push_back(id);
+        }
+    }
+
+    rank(ids, query);
+
+    return ids;
+}
+
+
+string SymbolIndex::normalize(const string& query) const
+{
+    if (is_case_sensitive_) {
+        return query;
+    }
+
+    string normalized(query.size(), '\0');
+    transform(query.begin(), query.end(), normalized.begin(), lower_case);
+    return normalized;
+}
+
+
+const string& SymbolIndex::symbol(SymbolId id) const
+{
+    return symbols_[id];
+}
+
+
+size_t SymbolIndex::size() const
+{
+    return symbols_.size();
+}
+
+
+void SymbolIndex::rank(vector<SymbolId>& ids, const string& query) const
+{
+    const string normalized_query = normalize(query);
+    const char* needle            = normalized_query.c_str();
+
+    // Lower scores rank first
+    const auto score = [&](SymbolId id) {
+        const char* symbol = normalized_symbol(id);
+        if (normalized_query.empty()) {
+            return 3;
+        } else if (strcmp(symbol, needle) == 0) {
+            return 0;
+        } else if (strncmp(symbol, needle, normalized_query.size()) == 0) {
+            return 1;
+        }
+
+        for (const char* match = strstr(symbol, needle); match != nullptr;
+             match             = strstr(match + 1, needle)) {
+            if (!is_word_character(match[-1])) {
+                return 2;
+            }
+        }
+
+        return 3;
+    };
+
+    struct RankedSymbol
+    {
+        int score;
+        SymbolId id;
+    };
+
+    vector<RankedSymbol> ranked(ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        ranked[i] = {score(ids[i]), ids[i]};
+    }
+
+    sort(ranked.begin(),
+         ranked.end(),
+         [this](const RankedSymbol& a, const RankedSymbol& b) {
+             if (a.score != b.score) {
+                 return a.score < b.score;
+             }
+
+             const size_t a_length = symbols_[a.id].size();
+             const size_t b_length = symbols_[b.id].size();
+             if (a_length != b_length) {
+                 return a_length < b_length;
+             }
+
+             return strcmp(normalized_symbol(a.id), normalized_symbol(b.id)) <
+                    0;
+         });
+
+    for (size_t i = 0; i < ids.size(); ++i) {
+        ids[i] = ranked[i].id;
+    }
+}
+
+
+const char* SymbolIndex::normalized_symbol(SymbolId id) const
+{
+    return text_.c_str() + symbol_offsets_[id];
+}
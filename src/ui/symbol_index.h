@@ -0,0 +1,91 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef SYMBOL_INDEX_H_
+#define SYMBOL_INDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/**
+ * Substring index of the observable symbols, backed by a suffix array over
+ * all of them, so that a query only visits the symbols it matches.
+ *
+ * Matches are ranked: exact matches first, then prefix matches, then
+ * matches starting a word of the symbol, then any other match. Ties go to
+ * the shortest symbol, then in alphabetical order.
+ */
+class SymbolIndex
+{
+  public:
+    using SymbolId = std::uint32_t;
+
+    SymbolIndex(std::vector<std::string> symbols, bool is_case_sensitive);
+
+    /**
+     * Ranked symbols containing the query
+     */
+    std::vector<SymbolId> find(const std::string& query) const;
+
+    /**
+     * Same as find, among the given candidates only. Results of a query are
+     * valid candidates for any query that contains it.
+     */
+    std::vector<SymbolId> refine(const std::vector<SymbolId>& candidates,
+                                 const std::string& query) const;
+
+    /**
+     * Query as compared against the symbols, i.e. in lower case unless the
+     * index is case sensitive
+     */
+    std::string normalize(const std::string& query) const;
+
+    const std::string& symbol(SymbolId id) const;
+
+    std::size_t size() const;
+
+  private:
+    void rank(std::vector<SymbolId>& ids, const std::string& query) const;
+
+    const char* normalized_symbol(SymbolId id) const;
+
+    bool is_case_sensitive_;
+
+    std::vector<std::string> symbols_;
+
+    // Normalized symbols, each terminated by a null character
+    std::string text_;
+    std::vector<std::uint32_t> symbol_offsets_;
+
+    // Positions in text_ of all suffixes of all symbols, sorted
+    std::vector<std::uint32_t> suffixes_;
+
+    // Symbol each position of text_ belongs to
+    std::vector<SymbolId> position_owners_;
+};
+
+#endif // SYMBOL_INDEX_H_
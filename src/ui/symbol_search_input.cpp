@@ -87,7 +87,6 @@ void SymbolSearchInput::keyPressEvent(QKeyEvent* e)
         return;
     }
 
+    // The completer shows the matching symbols once they are filtered
     completer_->update(text());
-    completer_->popup()->setCurrentIndex(
-        completer_->completionModel()->index(0, 0));
 }
@@ -23,6 +23,8 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 
 #include "GL/gl.h"
@@ -30,6 +32,13 @@
 #include "buffer.h"
 
 #include "camera.h"
+#include "ipc/raw_data_decode.h"
+#include "math/buffer_type_dispatch.h"
+#include "math/min_max.h"
+#include "ui/gl_difference_reducer.h"
+#include "ui/gl_min_max_reducer.h"
+#include "ui/gl_tile_residency.h"
+#include "ui/gl_texture_streamer.h"
 #include "visualization/game_object.h"
 #include "visualization/shaders/oid_shaders.h"
 #include "visualization/stage.h"
@@ -49,24 +58,156 @@ Buffer::Buffer(GameObject* game_object, GLCanvas* gl_canvas)
 
 Buffer::~Buffer()
 {
-    int num_textures = num_textures_x * num_textures_y;
+    release_textures();
 
-    gl_canvas_->glDeleteTextures(num_textures, buff_tex.data());
     gl_canvas_->glDeleteBuffers(1, &vbo);
 }
 
 
 bool Buffer::buffer_update()
 {
-    int num_textures = num_textures_x * num_textures_y;
-    glDeleteTextures(num_textures, buff_tex.data());
+    are_value_bounds_outdated_     = true;
+    is_pixel_index_outdated_       = true;
+    is_summed_area_table_outdated_ = true;
+    ++contents_revision_;
 
+    reset_value_statistics();
+
+    // The shader program is only recompiled if its channels, pixel layout or
+    // texel storage changed
     create_shader_program();
+
+    // The previous buffer contents may no longer be available
+    cancel_pending_uploads();
+
+    if (is_texture_storage_compatible()) {
+        // Same textures geometry and format: upload the new contents in place
+        upload_region(0,
+                      0,
+                      static_cast<int>(buffer_width_f),
+                      static_cast<int>(buffer_height_f));
+        reset_contrast_brightness_parameters();
+        return true;
+    }
+
+    release_textures();
+
     setup_gl_buffer();
     return true;
 }
 
 
+void Buffer::update_region(int x, int y, int width, int height)
+{
+    are_value_bounds_outdated_     = true;
+    is_pixel_index_outdated_       = true;
+    is_summed_area_table_outdated_ = true;
+    ++contents_revision_;
+
+    // Only the statistics of the changed blocks are computed again
+    value_statistics_.invalidate(x, y, width, height);
+    is_partially_updated_ = true;
+
+    upload_region(x, y, width, height);
+}
+
+
+void Buffer::upload_region(int x, int y, int width, int height)
+{
+    const int first_tx = x / max_texture_size;
+    const int first_ty = y / max_texture_size;
+    const int last_tx  = (x + width - 1) / max_texture_size;
+    const int last_ty  = (y + height - 1) / max_texture_size;
+
+    for (int ty = first_ty; ty <= last_ty; ++ty) {
+        const int tex_y0 = ty * max_texture_size;
+        const int y0     = std::max(y, tex_y0);
+        const int y1     = std::min(y + height, tex_y0 + max_texture_size);
+
+        for (int tx = first_tx; tx <= last_tx; ++tx) {
+            const int tex_x0 = tx * max_texture_size;
+            const int x0     = std::max(x, tex_x0);
+            const int x1     = std::min(x + width, tex_x0 + max_texture_size);
+
+            int tex_id = ty * num_textures_x + tx;
+
+            // Tiles that aren't resident are uploaded with the new contents
+            // once they become visible
+            if (!tile_resident_[tex_id]) {
+                continue;
+            }
+
+            // The levels of detail are rebuilt from the new contents
+            tile_built_levels_[tex_id] = 1;
+
+            upload_texture_region(buff_tex[tex_id],
+                                  x0,
+                                  y0,
+                                  x1 - x0,
+                                  y1 - y0,
+                                  x0 - tex_x0,
+                                  y0 - tex_y0);
+        }
+    }
+}
+
+
+void Buffer::cancel_pending_uploads()
+{
+    GLTextureStreamer* texture_streamer = gl_canvas_->get_texture_streamer();
+
+    for (const GLuint tex : buff_tex) {
+        texture_streamer->cancel(tex);
+    }
+}
+
+
+bool Buffer::has_pending_uploads() const
+{
+    GLTextureStreamer* texture_streamer = gl_canvas_->get_texture_streamer();
+
+    for (const GLuint tex : buff_tex) {
+        if (texture_streamer->is_pending(tex)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+uint64_t Buffer::contents_revision() const
+{
+    return contents_revision_;
+}
+
+
+void Buffer::release_resident_tiles()
+{
+    GLTileResidency* residency = gl_canvas_->get_tile_residency();
+
+    for (size_t tex_id = 0; tex_id < buff_tex.size(); ++tex_id) {
+        if (tile_resident_[tex_id]) {
+            residency->remove(buff_tex[tex_id]);
+            evict_tile(static_cast<int>(tex_id));
+        }
+    }
+}
+
+
+size_t Buffer::texture_memory_size() const
+{
+    return static_cast<size_t>(tex_width_) * tex_height_ * texel_size();
+}
+
+
+BufferRegion Buffer::viewed_region(int& level) const
+{
+    level = viewed_level_;
+    return viewed_region_;
+}
+
+
 void Buffer::get_pixel_info(stringstream& message, int x, int y)
 {
     if (x < 0 || x >= buffer_width_f || y < 0 || y >= buffer_height_f) {
@@ -74,139 +215,398 @@ void Buffer::get_pixel_info(stringstream& message, int x, int y)
         return;
     }
 
-    int pos = channels * (y * step + x);
-
     message << "[";
 
-    for (int c = 0; c < channels; ++c) {
-        if (type == BufferType::Float32 ||
-            type == BufferType::Float64) {
-            float fpix = reinterpret_cast<const float*>(buffer)[pos + c];
-            message << fpix;
-        } else if (type == BufferType::UnsignedByte) {
-            short fpix = buffer[pos + c];
-            message << fpix;
-        } else if (type == BufferType::Short) {
-            short fpix = reinterpret_cast<const short*>(buffer)[pos + c];
-            message << fpix;
-        } else if (type == BufferType::UnsignedShort) {
-            unsigned short fpix =
-                reinterpret_cast<const unsigned short*>(buffer)[pos + c];
-            message << fpix;
-        } else if (type == BufferType::Int32) {
-            int fpix = reinterpret_cast<const int*>(buffer)[pos + c];
-            message << fpix;
-        }
-        if (c < channels - 1) {
-            message << " ";
+    // Double buffers are converted to float by the UI
+    visit_held_value_type(type, [&](auto value_type) {
+        using T = typename decltype(value_type)::type;
+        const T* values = reinterpret_cast<const T*>(buffer);
+
+        for (int c = 0; c < channels; ++c) {
+            message << printable_value(values[value_index(x, y, c)]);
+            if (c < channels - 1) {
+                message << " ";
+            }
         }
-    }
+    });
+
     message << "]";
 }
 
 
+size_t Buffer::value_index(int x, int y, int c) const
+{
+    if (is_planar) {
+        const size_t plane_values =
+            static_cast<size_t>(step) * static_cast<int>(buffer_height_f);
+        return c * plane_values + static_cast<size_t>(y) * step + x;
+    }
+
+    return (static_cast<size_t>(y) * step + x) * channels + c;
+}
+
+
 void Buffer::rotate(float angle)
 {
     angle_ += angle;
 }
 
 
-void Buffer::recompute_min_color_values()
+void Buffer::set_comparison(Buffer* reference,
+                            CompareMode mode,
+                            float threshold)
 {
-    int buffer_width_i  = static_cast<int>(buffer_width_f);
-    int buffer_height_i = static_cast<int>(buffer_height_f);
+    if (reference == nullptr || mode == CompareMode::None) {
+        reference = nullptr;
+        mode      = CompareMode::None;
+    }
 
-    float* lowest = min_buffer_values();
+    if (reference != compare_reference_ || threshold != compare_threshold_) {
+        are_comparison_errors_outdated_ = true;
+    }
 
-    for (int i = 0; i < 4; ++i)
-        lowest[i] = std::numeric_limits<float>::max();
+    compare_reference_ = reference;
+    compare_mode_      = mode;
+    compare_threshold_ = threshold;
+}
 
-    for (int y = 0; y < buffer_height_i; ++y) {
-        for (int x = 0; x < buffer_width_i; ++x) {
-            int i = y * step + x;
-            for (int c = 0; c < channels; ++c) {
-                if (type == BufferType::Float32 || type == BufferType::Float64)
-                    lowest[c] = std::min(
-                        lowest[c],
-                        reinterpret_cast<const float*>(buffer)[channels * i + c]);
-                else if (type == BufferType::UnsignedByte)
-                    lowest[c] =
-                        std::min(lowest[c],
-                                 static_cast<float>(buffer[channels * i + c]));
-                else if (type == BufferType::Short)
-                    lowest[c] =
-                        std::min(lowest[c],
-                                 static_cast<float>(reinterpret_cast<const short*>(
-                                     buffer)[channels * i + c]));
-                else if (type == BufferType::UnsignedShort)
-                    lowest[c] = std::min(
-                        lowest[c],
-                        static_cast<float>(reinterpret_cast<const unsigned short*>(
-                            buffer)[channels * i + c]));
-                else if (type == BufferType::Int32)
-                    lowest[c] =
-                        std::min(lowest[c],
-                                 static_cast<float>(reinterpret_cast<const int*>(
-                                     buffer)[channels * i + c]));
+
+bool Buffer::is_comparable(const Buffer* other) const
+{
+    return other != nullptr && other != this && !buff_tex.empty() &&
+           other->buff_tex.size() == buff_tex.size() &&
+           other->buffer_width_f == buffer_width_f &&
+           other->buffer_height_f == buffer_height_f &&
+           other->channels == channels && other->is_planar == is_planar &&
+           other->texture_internal_format() == texture_internal_format();
+}
+
+
+bool Buffer::comparison_errors(float* largest,
+                               float* mean,
+                               size_t& mismatches)
+{
+    if (!is_comparing()) {
+        return false;
+    }
+
+    Buffer* reference = compare_reference_;
+
+    if (are_comparison_errors_outdated_ ||
+        compared_revisions_[0] != contents_revision_ ||
+        compared_revisions_[1] != reference->contents_revision_) {
+        // Both buffers must be fully resident, which is only attempted if
+        // they fit in the texture budget together
+        GLDifferenceReducer* reducer = gl_canvas_->get_difference_reducer();
+        GLTileResidency* residency   = gl_canvas_->get_tile_residency();
+        if (!reducer->is_supported() ||
+            texture_memory_size() + reference->texture_memory_size() >
+                residency->budget()) {
+            return false;
+        }
+
+        bool are_tiles_ready = true;
+        for (int ty = 0; ty < num_textures_y; ++ty) {
+            for (int tx = 0; tx < num_textures_x; ++tx) {
+                const int tex_id = ty * num_textures_x + tx;
+                are_tiles_ready &= prepare_tile(tex_id, tx, ty);
+                are_tiles_ready &= reference->prepare_tile(tex_id, tx, ty);
             }
         }
+        if (!are_tiles_ready) {
+            return false;
+        }
+
+        reset_tile_levels();
+        reference->reset_tile_levels();
+
+        // Integer textures are reduced without being normalized
+        const float scale = has_integer_texels() ? 1.0f : texel_value_scale();
+        if (!reducer->reduce(buff_tex,
+                             reference->buff_tex,
+                             texel_storage(),
+                             texel_layout(),
+                             channels,
+                             compare_threshold_ / scale,
+                             compare_largest_,
+                             compare_mean_,
+                             compare_mismatches_)) {
+            return false;
+        }
+
+        for (int c = 0; c < channels; ++c) {
+            compare_largest_[c] *= scale;
+            compare_mean_[c] *= scale;
+        }
+        for (int c = channels; c < 4; ++c) {
+            compare_largest_[c] = compare_mean_[c] = 0.0f;
+        }
+
+        compared_revisions_[0]          = contents_revision_;
+        compared_revisions_[1]          = reference->contents_revision_;
+        are_comparison_errors_outdated_ = false;
+    }
+
+    std::copy(compare_largest_, compare_largest_ + 4, largest);
+    std::copy(compare_mean_, compare_mean_ + 4, mean);
+    mismatches = compare_mismatches_;
+
+    return true;
+}
+
+
+bool Buffer::is_comparing() const
+{
+    return compare_mode_ != CompareMode::None &&
+           is_comparable(compare_reference_);
+}
+
+
+bool Buffer::prepare_tile(int tex_id, int tx, int ty)
+{
+    if (tile_resident_[tex_id]) {
+        gl_canvas_->get_tile_residency()->touch(buff_tex[tex_id]);
+    } else if (!make_tile_resident(tex_id, tx, ty)) {
+        return false;
     }
 
-    // For single channel buffers: fill with 0
-    for (int c = channels; c < 4; ++c)
-        lowest[c] = 0.0;
+    return is_tile_uploaded(tex_id);
+}
+
+
+void Buffer::recompute_min_color_values()
+{
+    compute_contrast_bounds(game_object_->stage->contrast_percentiles[0],
+                            value_lowest_,
+                            min_buffer_values());
 }
 
 
 void Buffer::recompute_max_color_values()
 {
-    int buffer_width_i  = static_cast<int>(buffer_width_f);
-    int buffer_height_i = static_cast<int>(buffer_height_f);
+    compute_contrast_bounds(game_object_->stage->contrast_percentiles[1],
+                            value_upper_,
+                            max_buffer_values());
+}
+
+
+void Buffer::recompute_min_max_color_values()
+{
+    recompute_min_color_values();
+    recompute_max_color_values();
+}
+
+
+const Histogram& Buffer::histogram()
+{
+    update_value_bounds();
+
+    if (is_histogram_outdated_) {
+        histogram_.compute(buffer,
+                           type,
+                           static_cast<int>(buffer_width_f),
+                           static_cast<int>(buffer_height_f),
+                           channels,
+                           step,
+                           plane_size() / (texel_size() / channels),
+                           value_lowest_,
+                           value_upper_);
+        is_histogram_outdated_ = false;
+    }
+
+    return histogram_;
+}
+
+
+const PixelIndex& Buffer::pixel_index()
+{
+    if (is_pixel_index_outdated_) {
+        pixel_index_.compute(buffer,
+                             type,
+                             static_cast<int>(buffer_width_f),
+                             static_cast<int>(buffer_height_f),
+                             channels,
+                             step,
+                             plane_size() / (texel_size() / channels));
+        is_pixel_index_outdated_ = false;
+    }
+
+    return pixel_index_;
+}
+
+
+const SummedAreaTable& Buffer::summed_area_table()
+{
+    if (is_summed_area_table_outdated_) {
+        summed_area_table_.compute(buffer,
+                                   type,
+                                   static_cast<int>(buffer_width_f),
+                                   static_cast<int>(buffer_height_f),
+                                   channels,
+                                   step,
+                                   plane_size() / (texel_size() / channels));
+        is_summed_area_table_outdated_ = false;
+    }
+
+    return summed_area_table_;
+}
+
+
+ValueStatistics Buffer::region_statistics(int x, int y, int width, int height)
+{
+    if (buffer == nullptr) {
+        return ValueStatistics();
+    }
+
+    return value_statistics_.region_statistics(buffer, x, y, width, height);
+}
+
+
+void Buffer::reset_value_statistics()
+{
+    // New contents are reduced as a whole
+    value_statistics_.reset(type,
+                            static_cast<int>(buffer_width_f),
+                            static_cast<int>(buffer_height_f),
+                            channels,
+                            step,
+                            plane_size() / (texel_size() / channels));
+    is_partially_updated_ = false;
+}
+
+
+void Buffer::update_value_bounds()
+{
+    if (are_value_bounds_outdated_) {
+        compute_color_bounds(value_lowest_, value_upper_);
+        are_value_bounds_outdated_ = false;
+        is_histogram_outdated_     = true;
+    }
+}
 
-    float* upper = max_buffer_values();
-    for (int i = 0; i < 4; ++i)
-        upper[i] = std::numeric_limits<float>::lowest();
 
-    for (int y = 0; y < buffer_height_i; ++y) {
-        for (int x = 0; x < buffer_width_i; ++x) {
-            int i = y * step + x;
+void Buffer::compute_contrast_bounds(float percentile,
+                                     const float* value_bounds,
+                                     float* bounds)
+{
+    update_value_bounds();
+
+    // The histogram is only needed when outliers are discarded
+    const bool use_histogram = percentile > 0.f && percentile < 100.f;
+
+    for (int c = 0; c < 4; ++c) {
+        if (c >= channels) {
+            bounds[c] = 0.0f;
+        } else if (use_histogram) {
+            bounds[c] = histogram().percentile(c, percentile);
+        } else {
+            bounds[c] = value_bounds[c];
+        }
+    }
+}
+
+
+void Buffer::compute_color_bounds(float* lowest, float* upper)
+{
+    if (is_partially_updated_) {
+        value_statistics_.statistics(buffer).bounds(channels, lowest, upper);
+        return;
+    }
+
+    // The textures can only be reduced once they hold the whole buffer
+    GLMinMaxReducer* reducer = gl_canvas_->get_min_max_reducer();
+    const bool can_reduce_textures =
+        reducer->is_supported() && !buff_tex.empty() &&
+        std::all_of(tile_resident_.begin(),
+                    tile_resident_.end(),
+                    [](bool is_resident) { return is_resident; }) &&
+        !has_pending_uploads();
+    if (can_reduce_textures) {
+        reset_tile_levels();
+    }
+
+    if (can_reduce_textures &&
+        reducer->reduce(buff_tex,
+                        texel_storage(),
+                        texel_layout(),
+                        channels,
+                        lowest,
+                        upper)) {
+        // Normalized textures are sampled in [0, 1], or [-1, 1] for signed
+        // types, so their bounds are brought back to the buffer range
+        const float scale = has_integer_texels() ? 1.0f : texel_value_scale();
+
+        if (scale != 1.0f) {
             for (int c = 0; c < channels; ++c) {
-                if (type == BufferType::Float32 || type == BufferType::Float64)
-                    upper[c] = std::max(
-                        upper[c],
-                        reinterpret_cast<const float*>(buffer)[channels * i + c]);
-                else if (type == BufferType::UnsignedByte)
-                    upper[c] = std::max(
-                        upper[c], static_cast<float>(buffer[channels * i + c]));
-                else if (type == BufferType::Short)
-                    upper[c] =
-                        std::max(upper[c],
-                                 static_cast<float>(reinterpret_cast<const short*>(
-                                     buffer)[channels * i + c]));
-                else if (type == BufferType::UnsignedShort)
-                    upper[c] = std::max(
-                        upper[c],
-                        static_cast<float>(reinterpret_cast<const unsigned short*>(
-                            buffer)[channels * i + c]));
-                else if (type == BufferType::Int32)
-                    upper[c] =
-                        std::max(upper[c],
-                                 static_cast<float>(reinterpret_cast<const int*>(
-                                     buffer)[channels * i + c]));
+                lowest[c] = std::round(lowest[c] * scale);
+                upper[c]  = std::round(upper[c] * scale);
             }
         }
+
+        for (int c = channels; c < 4; ++c) {
+            lowest[c] = upper[c] = 0.0f;
+        }
+
+        return;
+    }
+
+    if (is_planar) {
+        // Each plane is a single channel buffer of its own
+        for (int c = 0; c < channels; ++c) {
+            compute_min_max(buffer + c * plane_size(),
+                            type,
+                            static_cast<int>(buffer_width_f),
+                            static_cast<int>(buffer_height_f),
+                            1,
+                            step,
+                            &lowest[c],
+                            &upper[c]);
+        }
+        for (int c = channels; c < 4; ++c) {
+            lowest[c] = upper[c] = 0.0f;
+        }
+
+        return;
     }
 
-    // For single channel buffers: fill with 0
-    for (int c = channels; c < 4; ++c)
-        upper[c] = 0.0;
+    compute_min_max(buffer,
+                    type,
+                    static_cast<int>(buffer_width_f),
+                    static_cast<int>(buffer_height_f),
+                    channels,
+                    step,
+                    lowest,
+                    upper);
 }
 
 
 void Buffer::reset_contrast_brightness_parameters()
 {
-    recompute_min_color_values();
-    recompute_max_color_values();
+    recompute_min_max_color_values();
+
+    compute_contrast_brightness_parameters();
+}
+
+
+void Buffer::reset_contrast_to_viewed_region()
+{
+    // The contents of compressed buffers aren't available
+    if (buffer == nullptr) {
+        return;
+    }
+
+    if (viewed_region_.width <= 0 || viewed_region_.height <= 0) {
+        reset_contrast_brightness_parameters();
+        return;
+    }
+
+    value_statistics_
+        .region_statistics(buffer,
+                           viewed_region_.x,
+                           viewed_region_.y,
+                           viewed_region_.width,
+                           viewed_region_.height)
+        .bounds(channels, min_buffer_values(), max_buffer_values());
 
     compute_contrast_brightness_parameters();
 }
@@ -221,19 +621,8 @@ void Buffer::compute_contrast_brightness_parameters()
     float* auto_buffer_brightness = auto_buffer_contrast_brightness_ + 4;
 
     for (int c = 0; c < channels; ++c) {
-        float maxIntensity = 1.0f;
-        if (type == BufferType::UnsignedByte) {
-            maxIntensity = 255.0f;
-        } else if (type ==
-                 BufferType::Short) {// All non-real values have max color 255
-            maxIntensity = static_cast<float>(std::numeric_limits<short>::max());
-        } else if (type == BufferType::UnsignedShort) {
-            maxIntensity = static_cast<float>(std::numeric_limits<unsigned short>::max());
-        } else if (type == BufferType::Int32) {
-            maxIntensity = static_cast<float>(std::numeric_limits<int>::max());
-        } else if (type == BufferType::Float32 || type == BufferType::Float64) {
-            maxIntensity = 1.0f;
-        }
+        // Value sampled as 1 from the buffer textures
+        const float maxIntensity = texel_value_scale();
         float upp_minus_low = upper[c] - lowest[c];
 
         if (upp_minus_low == 0) {
@@ -291,6 +680,16 @@ void Buffer::set_pixel_layout(const string& pixel_layout)
 }
 
 
+bool Buffer::is_texture_storage_compatible() const
+{
+    return !buff_tex.empty() &&
+           tex_width_ == static_cast<int>(buffer_width_f) &&
+           tex_height_ == static_cast<int>(buffer_height_f) &&
+           tex_channels_ == channels && tex_type_ == type &&
+           tex_planar_ == is_planar;
+}
+
+
 const char* Buffer::get_pixel_layout() const
 {
     return pixel_layout_;
@@ -321,9 +720,8 @@ float Buffer::tile_coord_y(int y)
 
 void Buffer::update()
 {
-    GameObject* cam_obj = game_object_->stage->get_game_object("camera");
-    Camera* camera      = cam_obj->get_component<Camera>("camera_component");
-    float zoom          = camera->compute_zoom();
+    Camera* camera = game_object_->stage->get_camera_component();
+    float zoom     = camera->compute_zoom();
 
     buff_prog.use();
     if (zoom > 40) {
@@ -359,6 +757,15 @@ void Buffer::update_object_pose()
 }
 
 
+float Buffer::texel_value_scale() const
+{
+    // Integer textures are normalized by the buffer shader itself
+    return visit_held_value_type(type, [](auto value_type) {
+        return normalized_value_scale<typename decltype(value_type)::type>();
+    });
+}
+
+
 void Buffer::create_shader_program()
 {
     // Buffer Shaders
@@ -380,9 +787,15 @@ void Buffer::create_shader_program()
                      pixel_layout_,
                      {"mvp",
                       "sampler",
+                      "reference_sampler",
                       "brightness_contrast",
-                      "buffer_dimension",
-                      "enable_borders"});
+                      "tile_rect",
+                      "enable_borders",
+                      "compare_mode",
+                      "compare_scale",
+                      "compare_threshold"},
+                     texel_storage(),
+                     texel_layout());
 }
 
 
@@ -409,6 +822,8 @@ bool Buffer::initialize()
                              g_vertex_buffer_data,
                              GL_STATIC_DRAW);
 
+    reset_value_statistics();
+
     setup_gl_buffer();
 
     update_object_pose();
@@ -427,7 +842,31 @@ void Buffer::draw(const mat4& projection, const mat4& viewInv)
     gl_canvas_->glActiveTexture(GL_TEXTURE0);
 
     buff_prog.uniform1i("sampler", 0);
-    if (game_object_->stage->contrast_enabled) {
+    buff_prog.uniform1i("reference_sampler", 1);
+
+    // Differences are shown as they are, brought to the full intensity
+    // range by the largest error once it is known
+    const bool is_comparing_buffers = is_comparing();
+    if (is_comparing_buffers) {
+        float largest_error = 0.0f;
+        if (!are_comparison_errors_outdated_) {
+            largest_error =
+                *std::max_element(compare_largest_, compare_largest_ + 4) /
+                texel_value_scale();
+        }
+
+        buff_prog.uniform1i("compare_mode", static_cast<int>(compare_mode_));
+        buff_prog.uniform1f("compare_scale",
+                            largest_error > 0.0f && std::isfinite(largest_error)
+                                ? 1.0f / largest_error
+                                : 1.0f);
+        buff_prog.uniform1f("compare_threshold",
+                            compare_threshold_ / texel_value_scale());
+    } else {
+        buff_prog.uniform1i("compare_mode", 0);
+    }
+
+    if (game_object_->stage->contrast_enabled && !is_comparing_buffers) {
         buff_prog.uniform4fv(
             "brightness_contrast", 2, auto_buffer_contrast_brightness_);
     } else {
@@ -437,56 +876,101 @@ void Buffer::draw(const mat4& projection, const mat4& viewInv)
     int buffer_width_i  = static_cast<int>(buffer_width_f);
     int buffer_height_i = static_cast<int>(buffer_height_f);
 
-    int remaining_h = buffer_height_i;
-
-    float py = -buffer_height_i / 2;
-    if (buffer_height_i % 2 == 1) {
-        py -= 0.5;
-    }
+    Camera* camera   = game_object_->stage->get_camera_component();
+    const float zoom = camera->compute_zoom();
+
+    // Tiles close to the view are made resident ahead of being displayed
+    int first_tx, first_ty, last_tx, last_ty;
+    int prefetch_tx0, prefetch_ty0, prefetch_tx1, prefetch_ty1;
+    visible_tiles(
+        projection, viewInv, 0, first_tx, first_ty, last_tx, last_ty);
+    visible_tiles(projection,
+                  viewInv,
+                  prefetch_tile_margin,
+                  prefetch_tx0,
+                  prefetch_ty0,
+                  prefetch_tx1,
+                  prefetch_ty1);
+
+    float min_x, min_y, max_x, max_y;
+    view_bounds(projection, viewInv, min_x, min_y, max_x, max_y);
+
+    const auto clamp_coord = [](float coord, float size) {
+        return static_cast<int>(std::min(std::max(coord, 0.f), size));
+    };
+    viewed_region_.x = clamp_coord(std::floor(min_x), buffer_width_f);
+    viewed_region_.y = clamp_coord(std::floor(min_y), buffer_height_f);
+    viewed_region_.width =
+        clamp_coord(std::ceil(max_x), buffer_width_f) - viewed_region_.x;
+    viewed_region_.height =
+        clamp_coord(std::ceil(max_y), buffer_height_f) - viewed_region_.y;
+    viewed_level_ = lod_level(zoom, max_texture_size, max_texture_size);
+
+    GLTileResidency* residency = gl_canvas_->get_tile_residency();
+
+    // All tiles share the buffer transform and the unit quad; only their
+    // texture and placement change from one tile to the next
+    buff_prog.uniform_matrix4fv("mvp", 1, GL_FALSE, mvp.data());
+    gl_canvas_->glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    gl_canvas_->glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
 
-    for (int ty = 0; ty < num_textures_y; ++ty) {
-        int buff_h = std::min(remaining_h, max_texture_size);
-        remaining_h -= buff_h;
+    // Only the tiles around the view are visited, so the cost of a frame
+    // doesn't grow with the number of tiles of the buffer
+    for (int ty = prefetch_ty0; ty <= prefetch_ty1; ++ty) {
+        const int buff_h =
+            std::min(buffer_height_i - ty * max_texture_size, max_texture_size);
 
-        py += buff_h / 2;
-        if (buff_h % 2 == 1) {
-            py += 0.5;
-        }
+        for (int tx = prefetch_tx0; tx <= prefetch_tx1; ++tx) {
+            const int buff_w = std::min(buffer_width_i - tx * max_texture_size,
+                                        max_texture_size);
 
-        int remaining_w = buffer_width_i;
+            const int tex_id = ty * num_textures_x + tx;
 
-        float px = -buffer_width_i / 2;
-        if (buffer_width_i % 2 == 1) {
-            px -= 0.5;
-        }
+            if (tile_resident_[tex_id]) {
+                residency->touch(buff_tex[tex_id]);
+            } else {
+                make_tile_resident(tex_id, tx, ty);
+            }
 
-        for (int tx = 0; tx < num_textures_x; ++tx) {
-            int buff_w = std::min(remaining_w, max_texture_size);
-            remaining_w -= buff_w;
+            // The reference tile covering the same pixels is sampled along
+            const bool is_reference_ready =
+                !is_comparing_buffers ||
+                compare_reference_->prepare_tile(tex_id, tx, ty);
+
+            // Tiles out of view, not resident or whose contents are still
+            // being streamed are left out
+            const bool is_visible = tx >= first_tx && tx <= last_tx &&
+                                    ty >= first_ty && ty <= last_ty;
+            if (!is_visible || !tile_resident_[tex_id] ||
+                !is_tile_uploaded(tex_id) || !is_reference_ready) {
+                continue;
+            }
 
-            glBindTexture(GL_TEXTURE_2D, buff_tex[ty * num_textures_x + tx]);
+            const int level = lod_level(zoom, buff_w, buff_h);
+            select_tile_level(tex_id, tx, ty, level);
 
-            mat4 tile_model;
+            if (is_comparing_buffers) {
+                compare_reference_->select_tile_level(tex_id, tx, ty, level);
 
-            px += buff_w / 2;
-            if (buff_w % 2 == 1) {
-                px += 0.5;
+                gl_canvas_->glActiveTexture(GL_TEXTURE1);
+                glBindTexture(texture_target(),
+                              compare_reference_->buff_tex[tex_id]);
+                gl_canvas_->glActiveTexture(GL_TEXTURE0);
             }
 
-            tile_model.set_from_st(buff_w, buff_h, 1.0, px, py, 0.0f);
-            buff_prog.uniform_matrix4fv(
-                "mvp", 1, GL_FALSE, (mvp * tile_model).data());
-            buff_prog.uniform2f("buffer_dimension", buff_w, buff_h);
+            glBindTexture(texture_target(), buff_tex[tex_id]);
 
-            px += buff_w / 2;
+            // Center and size of the tile, with the buffer centered at the
+            // origin
+            const float tile_rect[] = {
+                tx * max_texture_size + buff_w / 2.f - buffer_width_f / 2.f,
+                ty * max_texture_size + buff_h / 2.f - buffer_height_f / 2.f,
+                static_cast<float>(buff_w),
+                static_cast<float>(buff_h)};
+            buff_prog.uniform4fv("tile_rect", 1, tile_rect);
 
-            gl_canvas_->glBindBuffer(GL_ARRAY_BUFFER, vbo);
-            gl_canvas_->glVertexAttribPointer(
-                0, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
             gl_canvas_->glDrawArrays(GL_TRIANGLES, 0, 6);
         }
-
-        py += buff_h / 2;
     }
 }
 
@@ -514,99 +998,545 @@ void Buffer::setup_gl_buffer()
     int buffer_width_i  = static_cast<int>(buffer_width_f);
     int buffer_height_i = static_cast<int>(buffer_height_f);
 
-    // Initialize contrast parameters
-    reset_contrast_brightness_parameters();
-
     // Buffer texture
     num_textures_x = ceil(((float)buffer_width_i) / ((float)max_texture_size));
     num_textures_y = ceil(((float)buffer_height_i) / ((float)max_texture_size));
     int num_textures = num_textures_x * num_textures_y;
 
     buff_tex.resize(num_textures);
+    tile_resident_.assign(num_textures, false);
+    tile_uploaded_.assign(num_textures, false);
+    tile_built_levels_.assign(num_textures, 1);
+    tile_selected_level_.assign(num_textures, 0);
     glGenTextures(num_textures, buff_tex.data());
 
-    GLuint tex_type   = GL_UNSIGNED_BYTE;
-    GLuint tex_format = GL_RED;
+    tex_width_    = buffer_width_i;
+    tex_height_   = buffer_height_i;
+    tex_channels_ = channels;
+    tex_type_     = type;
+    tex_planar_   = is_planar;
+
+    // The tiles storage is only allocated once they get close to the view
+    for (const GLuint tex : buff_tex) {
+        initialize_tile_texture(tex);
+    }
+
+    // Initialize contrast parameters
+    reset_contrast_brightness_parameters();
+}
+
+
+void Buffer::initialize_tile_texture(GLuint texture)
+{
+    // Integer textures can't be filtered. A single level of detail is
+    // sampled at a time, so no mipmap filtering is needed.
+    const GLint min_filter = has_integer_texels() ? GL_NEAREST : GL_LINEAR;
+
+    const GLenum target = texture_target();
+
+    gl_canvas_->glBindTexture(target, texture);
+
+    gl_canvas_->glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    gl_canvas_->glTexParameteri(target, GL_TEXTURE_MIN_FILTER, min_filter);
+    gl_canvas_->glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl_canvas_->glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl_canvas_->glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    gl_canvas_->glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+    gl_canvas_->glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, 0);
+}
+
+
+bool Buffer::make_tile_resident(int tex_id, int tx, int ty)
+{
+    // The host copy of the buffer may have been released to save memory
+    if (buffer == nullptr) {
+        return false;
+    }
+
+    const int width  = tile_width(tx);
+    const int height = tile_height(ty);
+
+    const size_t tile_size =
+        static_cast<size_t>(width) * height * texel_size();
+
+    GLTileResidency* residency = gl_canvas_->get_tile_residency();
+    if (!residency->add(buff_tex[tex_id], tile_size, [this, tex_id]() {
+            evict_tile(tex_id);
+        })) {
+        return false;
+    }
+
+    gl_canvas_->glBindTexture(texture_target(), buff_tex[tex_id]);
+    if (is_planar) {
+        gl_canvas_->glTexImage3D(GL_TEXTURE_2D_ARRAY,
+                                 0,
+                                 texture_internal_format(),
+                                 width,
+                                 height,
+                                 texture_layers(),
+                                 0,
+                                 texture_format(),
+                                 texture_type(),
+                                 nullptr);
+    } else {
+        gl_canvas_->glTexImage2D(GL_TEXTURE_2D,
+                                 0,
+                                 texture_internal_format(),
+                                 width,
+                                 height,
+                                 0,
+                                 texture_format(),
+                                 texture_type(),
+                                 nullptr);
+    }
+
+    tile_resident_[tex_id]     = true;
+    tile_uploaded_[tex_id]     = false;
+    tile_built_levels_[tex_id] = 1;
+
+    // The tile contents are streamed over the next frames, straight from
+    // the buffer held by the main window
+    upload_texture_region(buff_tex[tex_id],
+                          tx * max_texture_size,
+                          ty * max_texture_size,
+                          width,
+                          height,
+                          0,
+                          0);
+
+    return true;
+}
+
+
+void Buffer::evict_tile(int tex_id)
+{
+    gl_canvas_->get_texture_streamer()->cancel(buff_tex[tex_id]);
+
+    // Deleting the texture is the only way of releasing all of its levels
+    gl_canvas_->glDeleteTextures(1, &buff_tex[tex_id]);
+    gl_canvas_->glGenTextures(1, &buff_tex[tex_id]);
+    initialize_tile_texture(buff_tex[tex_id]);
+
+    tile_resident_[tex_id]       = false;
+    tile_uploaded_[tex_id]       = false;
+    tile_built_levels_[tex_id]   = 1;
+    tile_selected_level_[tex_id] = 0;
+}
+
+
+void Buffer::release_textures()
+{
+    cancel_pending_uploads();
+
+    GLTileResidency* residency = gl_canvas_->get_tile_residency();
+    for (const GLuint tex : buff_tex) {
+        residency->remove(tex);
+    }
+
+    gl_canvas_->glDeleteTextures(static_cast<GLsizei>(buff_tex.size()),
+                                 buff_tex.data());
+    buff_tex.clear();
+}
+
+
+void Buffer::visible_tiles(const mat4& projection,
+                           const mat4& view_inv,
+                           int margin,
+                           int& first_tx,
+                           int& first_ty,
+                           int& last_tx,
+                           int& last_ty)
+{
+    float min_x, min_y, max_x, max_y;
+    view_bounds(projection, view_inv, min_x, min_y, max_x, max_y);
+
+    const float tile_size = static_cast<float>(max_texture_size);
+
+    const auto to_tile = [tile_size](float coord, int offset, int count) {
+        const float tile = std::floor(coord / tile_size) + offset;
+        return static_cast<int>(
+            std::min(std::max(tile, 0.f), static_cast<float>(count - 1)));
+    };
+
+    first_tx = to_tile(min_x, -margin, num_textures_x);
+    last_tx  = to_tile(max_x, margin, num_textures_x);
+    first_ty = to_tile(min_y, -margin, num_textures_y);
+    last_ty  = to_tile(max_y, margin, num_textures_y);
+}
+
+
+void Buffer::view_bounds(const mat4& projection,
+                         const mat4& view_inv,
+                         float& min_x,
+                         float& min_y,
+                         float& max_x,
+                         float& max_y)
+{
+    mat4 vp_inv =
+        (projection * view_inv * game_object_->get_pose()).affine_inv();
+    vec4 tl = vp_inv * vec4(-1, 1, 0, 1);
+    vec4 br = vp_inv * vec4(1, -1, 0, 1);
+
+    // Since the clip ROI may be rotated, the bounds are recomputed from the
+    // Xs and Ys of both corners. The buffer is centered at the origin.
+    min_x = std::min(tl.x(), br.x()) + buffer_width_f / 2.f;
+    max_x = std::max(tl.x(), br.x()) + buffer_width_f / 2.f;
+    min_y = std::min(tl.y(), br.y()) + buffer_height_f / 2.f;
+    max_y = std::max(tl.y(), br.y()) + buffer_height_f / 2.f;
+}
+
+
+void Buffer::upload_texture_region(GLuint texture,
+                                   int x,
+                                   int y,
+                                   int width,
+                                   int height,
+                                   int tex_x,
+                                   int tex_y)
+{
+    const size_t first_pixel = static_cast<size_t>(y) * step + x;
+
+    GLTextureStreamer::TextureUpload upload;
+
+    upload.pixel_size        = texel_size() / texture_layers();
+    upload.texture           = texture;
+    upload.source_row_length = step;
+    upload.x                 = tex_x;
+    upload.y                 = tex_y;
+    upload.width             = width;
+    upload.height            = height;
+    upload.format            = texture_format();
+    upload.type              = texture_type();
+
+    // Each plane is streamed to its own layer
+    for (int layer = 0; layer < texture_layers(); ++layer) {
+        upload.source =
+            buffer + layer * plane_size() + first_pixel * upload.pixel_size;
+        upload.layer = is_planar ? layer : -1;
+
+        gl_canvas_->get_texture_streamer()->upload(upload);
+    }
+}
+
+
+bool Buffer::is_tile_uploaded(int tex_id)
+{
+    if (!tile_uploaded_[tex_id]) {
+        GLTextureStreamer* texture_streamer =
+            gl_canvas_->get_texture_streamer();
+        tile_uploaded_[tex_id] =
+            !texture_streamer->is_pending(buff_tex[tex_id]);
+    }
+
+    return tile_uploaded_[tex_id];
+}
+
+
+int Buffer::lod_level(float zoom, int tile_width, int tile_height)
+{
+    if (zoom >= 1.0f) {
+        return 0;
+    }
+
+    // Rounded down so that the sampled level is never coarser than the
+    // screen resolution
+    const int level = static_cast<int>(std::floor(std::log2(1.0f / zoom)));
+    const int max_level =
+        static_cast<int>(std::log2(std::max(tile_width, tile_height)));
 
+    return std::min(level, max_level);
+}
+
+
+void Buffer::select_tile_level(int tex_id, int tx, int ty, int level)
+{
+    if ((tile_built_levels_[tex_id] & (1u << level)) == 0) {
+        // Partial updates of the base level are still being streamed
+        GLTextureStreamer* texture_streamer =
+            gl_canvas_->get_texture_streamer();
+        if (texture_streamer->is_pending(buff_tex[tex_id])) {
+            level = 0;
+        } else {
+            build_tile_level(tex_id, tx, ty, level);
+        }
+    }
+
+    if (tile_selected_level_[tex_id] != level) {
+        gl_canvas_->glTexParameteri(
+            texture_target(), GL_TEXTURE_BASE_LEVEL, level);
+        gl_canvas_->glTexParameteri(
+            texture_target(), GL_TEXTURE_MAX_LEVEL, level);
+        tile_selected_level_[tex_id] = level;
+    }
+}
+
+
+void Buffer::build_tile_level(int tex_id, int tx, int ty, int level)
+{
+    const int width  = tile_width(tx);
+    const int height = tile_height(ty);
+
+    if (can_generate_mipmaps()) {
+        // The whole chain is generated at once from the base level
+        const int max_level =
+            static_cast<int>(std::log2(std::max(width, height)));
+
+        const GLenum target = texture_target();
+        gl_canvas_->glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+        gl_canvas_->glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, max_level);
+        gl_canvas_->glGenerateMipmap(target);
+
+        // The whole chain takes about a third of the base level
+        gl_canvas_->get_tile_residency()->grow(
+            buff_tex[tex_id],
+            static_cast<size_t>(width) * height * texel_size() / 3);
+
+        tile_built_levels_[tex_id]   = (2u << max_level) - 1;
+        tile_selected_level_[tex_id] = -1;
+        return;
+    }
+
+    const int level_width  = std::max(1, width >> level);
+    const int level_height = std::max(1, height >> level);
+
+    // Each level is reduced straight from the buffer, so only the levels
+    // actually displayed are ever built
+    vector<uint8_t> level_data(static_cast<size_t>(level_width) *
+                               level_height * texel_size());
+
+    const size_t first_pixel =
+        static_cast<size_t>(ty * max_texture_size) * step +
+        tx * max_texture_size;
+
+    // Planes are reduced one at a time, into consecutive layers
+    const int layer_texel_size = texel_size() / texture_layers();
+    const size_t layer_size    = level_data.size() / texture_layers();
+    for (int layer = 0; layer < texture_layers(); ++layer) {
+        downsample(buffer + layer * plane_size() +
+                       first_pixel * layer_texel_size,
+                   held_buffer_type(type),
+                   width,
+                   height,
+                   texture_channels(),
+                   step,
+                   level_width,
+                   level_height,
+                   game_object_->stage->lod_filter,
+                   level_data.data() + layer * layer_size);
+    }
+
+    gl_canvas_->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (is_planar) {
+        gl_canvas_->glTexImage3D(GL_TEXTURE_2D_ARRAY,
+                                 level,
+                                 texture_internal_format(),
+                                 level_width,
+                                 level_height,
+                                 texture_layers(),
+                                 0,
+                                 texture_format(),
+                                 texture_type(),
+                                 level_data.data());
+    } else {
+        gl_canvas_->glTexImage2D(GL_TEXTURE_2D,
+                                 level,
+                                 texture_internal_format(),
+                                 level_width,
+                                 level_height,
+                                 0,
+                                 texture_format(),
+                                 texture_type(),
+                                 level_data.data());
+    }
+
+    tile_built_levels_[tex_id] |= 1u << level;
+    gl_canvas_->get_tile_residency()->grow(buff_tex[tex_id], level_data.size());
+}
+
+
+void Buffer::reset_tile_levels()
+{
+    for (size_t tex_id = 0; tex_id < buff_tex.size(); ++tex_id) {
+        if (tile_selected_level_[tex_id] != 0) {
+            const GLenum target = texture_target();
+            gl_canvas_->glBindTexture(target, buff_tex[tex_id]);
+            gl_canvas_->glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+            gl_canvas_->glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, 0);
+            tile_selected_level_[tex_id] = 0;
+        }
+    }
+}
+
+
+bool Buffer::can_generate_mipmaps() const
+{
+    // Signed normalized formats aren't required to be renderable, which
+    // mipmap generation relies on
+    return game_object_->stage->lod_filter == DownsampleFilter::Average &&
+           (type == BufferType::UnsignedByte ||
+            type == BufferType::UnsignedShort);
+}
+
+
+int Buffer::tile_width(int tx) const
+{
+    const int buffer_width_i = static_cast<int>(buffer_width_f);
+    return std::min(buffer_width_i - tx * max_texture_size, max_texture_size);
+}
+
+
+int Buffer::tile_height(int ty) const
+{
+    const int buffer_height_i = static_cast<int>(buffer_height_f);
+    return std::min(buffer_height_i - ty * max_texture_size,
+                    max_texture_size);
+}
+
+
+GLint Buffer::texture_internal_format() const
+{
+    // Textures are stored with the precision of the buffer, and integer
+    // types are normalized on sampling the same way as in a float texture
+    static const GLint formats[][4] = {
+        {GL_R8, GL_RG8, GL_RGB8, GL_RGBA8},
+        {GL_R16, GL_RG16, GL_RGB16, GL_RGBA16},
+        {GL_R16_SNORM, GL_RG16_SNORM, GL_RGB16_SNORM, GL_RGBA16_SNORM},
+        {GL_R32I, GL_RG32I, GL_RGB32I, GL_RGBA32I},
+        {GL_R32F, GL_RG32F, GL_RGB32F, GL_RGBA32F},
+        {GL_R8_SNORM, GL_RG8_SNORM, GL_RGB8_SNORM, GL_RGBA8_SNORM},
+        {GL_R32UI, GL_RG32UI, GL_RGB32UI, GL_RGBA32UI},
+        {GL_R16F, GL_RG16F, GL_RGB16F, GL_RGBA16F}};
+
+    int type_index;
+    if (type == BufferType::UnsignedByte || type == BufferType::Bool) {
+        type_index = 0;
+    } else if (type == BufferType::UnsignedShort) {
+        type_index = 1;
+    } else if (type == BufferType::Short) {
+        type_index = 2;
+    } else if (type == BufferType::Int32) {
+        type_index = 3;
+    } else if (type == BufferType::Int8) {
+        type_index = 5;
+    } else if (type == BufferType::UInt32) {
+        type_index = 6;
+    } else if (type == BufferType::Float16) {
+        type_index = 7;
+    } else {
+        // Double buffers are converted to float by the UI
+        type_index = 4;
+    }
+
+    return formats[type_index]
+                  [std::min(std::max(texture_channels(), 1), 4) - 1];
+}
+
+
+GLuint Buffer::texture_format() const
+{
+    if (has_integer_texels()) {
+        if (texture_channels() == 2) {
+            return GL_RG_INTEGER;
+        } else if (texture_channels() == 3) {
+            return GL_RGB_INTEGER;
+        } else if (texture_channels() == 4) {
+            return GL_RGBA_INTEGER;
+        }
+
+        return GL_RED_INTEGER;
+    }
+
+    if (texture_channels() == 2) {
+        return GL_RG;
+    } else if (texture_channels() == 3) {
+        return GL_RGB;
+    } else if (texture_channels() == 4) {
+        return GL_RGBA;
+    }
+
+    return GL_RED;
+}
+
+
+GLuint Buffer::texture_type() const
+{
     if (type == BufferType::Float32 || type == BufferType::Float64) {
-        tex_type = GL_FLOAT;
-    } else if (type == BufferType::UnsignedByte) {
-        tex_type = GL_UNSIGNED_BYTE;
+        return GL_FLOAT;
+    } else if (type == BufferType::Float16) {
+        return GL_HALF_FLOAT;
+    } else if (type == BufferType::Int8) {
+        return GL_BYTE;
     } else if (type == BufferType::Short) {
-        tex_type = GL_SHORT;
+        return GL_SHORT;
     } else if (type == BufferType::UnsignedShort) {
-        tex_type = GL_UNSIGNED_SHORT;
+        return GL_UNSIGNED_SHORT;
     } else if (type == BufferType::Int32) {
-        tex_type = GL_INT;
+        return GL_INT;
+    } else if (type == BufferType::UInt32) {
+        return GL_UNSIGNED_INT;
     }
 
-    if (channels == 1) {
-        tex_format = GL_RED;
-    } else if (channels == 2) {
-        tex_format = GL_RG;
-    } else if (channels == 3) {
-        tex_format = GL_RGB;
-    } else if (channels == 4) {
-        tex_format = GL_RGBA;
+    return GL_UNSIGNED_BYTE;
+}
+
+
+int Buffer::texel_size() const
+{
+    // Double buffers are converted to float by the UI
+    return channels * static_cast<int>(typesize(held_buffer_type(type)));
+}
+
+
+GLenum Buffer::texture_target() const
+{
+    return is_planar ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+}
+
+
+int Buffer::texture_layers() const
+{
+    return is_planar ? channels : 1;
+}
+
+
+int Buffer::texture_channels() const
+{
+    return is_planar ? 1 : channels;
+}
+
+
+size_t Buffer::plane_size() const
+{
+    if (!is_planar) {
+        return 0;
     }
 
-    int remaining_h = buffer_height_i;
+    return static_cast<size_t>(step) * static_cast<int>(buffer_height_f) *
+           (texel_size() / channels);
+}
 
-    glPixelStoref(GL_UNPACK_ALIGNMENT, 1);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, step);
 
-    for (int ty = 0; ty < num_textures_y; ++ty) {
-        int buff_h = std::min(remaining_h, max_texture_size);
-        remaining_h -= buff_h;
+bool Buffer::has_integer_texels() const
+{
+    // 32 bit integers have no normalized texture format
+    return type == BufferType::Int32 || type == BufferType::UInt32;
+}
 
-        int remaining_w = buffer_width_i;
-        for (int tx = 0; tx < num_textures_x; ++tx) {
-            int buff_w = std::min(remaining_w, max_texture_size);
-            remaining_w -= buff_w;
 
-            int tex_id = ty * num_textures_x + tx;
-            gl_canvas_->glBindTexture(GL_TEXTURE_2D, buff_tex[tex_id]);
-
-            gl_canvas_->glPixelStorei(GL_UNPACK_SKIP_ROWS,
-                                      ty * max_texture_size);
-            gl_canvas_->glPixelStorei(GL_UNPACK_SKIP_PIXELS,
-                                      tx * max_texture_size);
-
-            gl_canvas_->glTexImage2D(GL_TEXTURE_2D,
-                                     0,
-                                     GL_RGBA32F,
-                                     buff_w,
-                                     buff_h,
-                                     0,
-                                     tex_format,
-                                     tex_type,
-                                     nullptr);
-
-            gl_canvas_->glTexSubImage2D(GL_TEXTURE_2D,
-                                        0,
-                                        0,
-                                        0,
-                                        buff_w,
-                                        buff_h,
-                                        tex_format,
-                                        tex_type,
-                                        reinterpret_cast<const GLvoid*>(buffer));
-
-            gl_canvas_->glTexParameteri(
-                GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-            gl_canvas_->glTexParameteri(
-                GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            gl_canvas_->glTexParameteri(
-                GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            gl_canvas_->glTexParameteri(
-                GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            gl_canvas_->glTexParameteri(
-                GL_TEXTURE_2D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-        }
+ShaderProgram::TexelStorage Buffer::texel_storage() const
+{
+    if (type == BufferType::UInt32) {
+        return ShaderProgram::StorageUnsignedInteger;
+    } else if (type == BufferType::Int32) {
+        return ShaderProgram::StorageInteger;
     }
 
-    gl_canvas_->glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-    gl_canvas_->glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
-    gl_canvas_->glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    return ShaderProgram::StorageNormalized;
+}
+
+
+ShaderProgram::TexelLayout Buffer::texel_layout() const
+{
+    return is_planar ? ShaderProgram::LayoutPlanar
+                     : ShaderProgram::LayoutInterleaved;
 }
@@ -30,6 +30,12 @@
 #include <vector>
 
 #include "component.h"
+#include "ipc/buffer_tiles.h"
+#include "math/block_statistics.h"
+#include "math/downsample.h"
+#include "math/histogram.h"
+#include "math/pixel_search.h"
+#include "math/summed_area_table.h"
 #include "visualization/shader.h"
 #include "ipc/message_exchange.h"
 
@@ -37,10 +43,23 @@
 class Buffer : public Component
 {
   public:
+    // How the difference with a reference buffer is displayed
+    enum class CompareMode {
+        None,
+        AbsoluteDifference,
+        // Around mid-gray, darker where the buffer is below the reference
+        SignedDifference,
+        // White where any channel differs by more than the threshold
+        Mismatches
+    };
+
     Buffer(GameObject* game_object, GLCanvas* gl_canvas);
 
     const int max_texture_size = 2048;
 
+    // Tiles around the view made resident before they become visible
+    static const int prefetch_tile_margin = 1;
+
     std::vector<GLuint> buff_tex;
 
     static const float no_ac_params[8];
@@ -57,16 +76,82 @@ class Buffer : public Component
 
     bool transpose;
 
+    // Whether the channels are stored as consecutive planes of step * height
+    // values, instead of being interleaved
+    bool is_planar;
+
     ~Buffer();
 
     bool buffer_update();
 
+    /**
+     * Re-uploads a region of the buffer to the textures that cover it. The
+     * buffer geometry must not have changed since the last buffer_update.
+     */
+    void update_region(int x, int y, int width, int height);
+
+    /**
+     * Whether some of the buffer contents are still being streamed to the
+     * textures
+     */
+    bool has_pending_uploads() const;
+
+    /**
+     * Incremented whenever the buffer contents change
+     */
+    uint64_t contents_revision() const;
+
+    /**
+     * Releases the storage of all resident tiles. They are uploaded again
+     * once they get close to the view.
+     */
+    void release_resident_tiles();
+
+    /**
+     * Texture memory taken by the base level of all tiles
+     */
+    std::size_t texture_memory_size() const;
+
     void recompute_min_color_values();
 
     void recompute_max_color_values();
 
+    void recompute_min_max_color_values();
+
+    /**
+     * Histogram of the buffer values, computed on first use after each
+     * buffer update
+     */
+    const Histogram& histogram();
+
+    /**
+     * Index of the pixels with the lowest, highest, NaN and infinite values
+     * of the buffer, computed on first use after each buffer update
+     */
+    const PixelIndex& pixel_index();
+
+    /**
+     * Summed-area tables of the buffer values, built on first use after each
+     * buffer update. The contents of compressed buffers aren't available, so
+     * their tables are empty.
+     */
+    const SummedAreaTable& summed_area_table();
+
+    /**
+     * Value statistics of the blocks of the statistics index intersecting the
+     * given region, which may thus include values around it
+     */
+    ValueStatistics region_statistics(int x, int y, int width, int height);
+
     void reset_contrast_brightness_parameters();
 
+    /**
+     * Sets the auto-contrast levels to the value bounds of the region covered
+     * by the view when it was last drawn, rounded out to the blocks of the
+     * statistics index
+     */
+    void reset_contrast_to_viewed_region();
+
     void compute_contrast_brightness_parameters();
 
     int sub_texture_id_at_coord(int x, int y);
@@ -98,15 +183,208 @@ class Buffer : public Component
 
     void get_pixel_info(std::stringstream& output, int x, int y);
 
+    /**
+     * Index of a channel value of the given pixel in the buffer
+     */
+    std::size_t value_index(int x, int y, int c) const;
+
+    /**
+     * Region of the buffer covered by the view when it was last drawn, and
+     * the level of detail it was displayed at
+     */
+    BufferRegion viewed_region(int& level) const;
+
     void rotate(float angle);
 
+    /**
+     * Displays the difference between this buffer and the reference, which
+     * must outlive the comparison. The threshold is in buffer units. The
+     * comparison is stopped with a null reference or CompareMode::None.
+     */
+    void set_comparison(Buffer* reference, CompareMode mode, float threshold);
+
+    /**
+     * Whether the buffers have the same dimensions, channels and type
+     */
+    bool is_comparable(const Buffer* other) const;
+
+    /**
+     * Largest and mean absolute differences per channel with the reference,
+     * in buffer units, and the number of pixels differing by more than the
+     * threshold. They are reduced from the textures on the GPU and cached
+     * until either buffer changes.
+     *
+     * @return false if they are not available, e.g. while the textures are
+     * still being uploaded
+     */
+    bool
+    comparison_errors(float* largest, float* mean, std::size_t& mismatches);
+
   private:
     void create_shader_program();
 
     void setup_gl_buffer();
 
+    /**
+     * Per channel bounds of the buffer values, computed from the textures on
+     * the GPU when possible, and from the buffer contents otherwise
+     */
+    void compute_color_bounds(float* lowest, float* upper);
+
+    /**
+     * Outdates the statistics index, for new buffer contents or geometry
+     */
+    void reset_value_statistics();
+
+    void update_value_bounds();
+
+    /**
+     * Uploads a region of the buffer to the resident textures that cover it
+     */
+    void upload_region(int x, int y, int width, int height);
+
+    /**
+     * Auto-contrast bounds at the given percentile of the buffer values.
+     * Bounds at 0% and 100% are the value bounds themselves.
+     */
+    void compute_contrast_bounds(float percentile,
+                                 const float* value_bounds,
+                                 float* bounds);
+
+    void upload_texture_region(GLuint texture,
+                               int x,
+                               int y,
+                               int width,
+                               int height,
+                               int tex_x,
+                               int tex_y);
+
+    void cancel_pending_uploads();
+
+    /**
+     * Sets the sampling parameters of a tile texture, without allocating
+     * its storage
+     */
+    void initialize_tile_texture(GLuint texture);
+
+    /**
+     * Allocates the tile storage and schedules the upload of its contents.
+     * Returns false if the texture memory budget can't accommodate it.
+     */
+    bool make_tile_resident(int tex_id, int tx, int ty);
+
+    void evict_tile(int tex_id);
+
+    void release_textures();
+
+    /**
+     * Bounds of the view, in buffer pixels
+     */
+    void view_bounds(const mat4& projection,
+                     const mat4& view_inv,
+                     float& min_x,
+                     float& min_y,
+                     float& max_x,
+                     float& max_y);
+
+    /**
+     * Range of tiles intersecting the view, extended by the given number of
+     * tiles on each side
+     */
+    void visible_tiles(const mat4& projection,
+                       const mat4& view_inv,
+                       int margin,
+                       int& first_tx,
+                       int& first_ty,
+                       int& last_tx,
+                       int& last_ty);
+
+    bool is_tile_uploaded(int tex_id);
+
+    /**
+     * Level of detail to sample from, matching one buffer pixel per screen
+     * pixel at the given zoom
+     */
+    static int lod_level(float zoom, int tile_width, int tile_height);
+
+    /**
+     * Makes the bound tile texture sample only from the given level,
+     * building it first if needed. Falls back to the base level while the
+     * tile contents are being streamed.
+     */
+    void select_tile_level(int tex_id, int tx, int ty, int level);
+
+    void build_tile_level(int tex_id, int tx, int ty, int level);
+
+    /**
+     * Restores the base level of all tiles, as expected by the texture
+     * reductions
+     */
+    void reset_tile_levels();
+
+    /**
+     * Whether the mipmaps can be generated by OpenGL itself, which only
+     * averages normalized textures
+     */
+    bool can_generate_mipmaps() const;
+
+    int tile_width(int tx) const;
+    int tile_height(int ty) const;
+
+    GLint texture_internal_format() const;
+
+    GLuint texture_format() const;
+
+    GLuint texture_type() const;
+
+    int texel_size() const;
+
+    /**
+     * Planar buffers are stored in array textures, with a layer per channel
+     */
+    GLenum texture_target() const;
+
+    int texture_layers() const;
+
+    /**
+     * Channels of each texel of a texture layer
+     */
+    int texture_channels() const;
+
+    /**
+     * Distance between the channel planes of the buffer, in bytes; 0 if the
+     * channels are interleaved
+     */
+    std::size_t plane_size() const;
+
+    bool has_integer_texels() const;
+
+    ShaderProgram::TexelStorage texel_storage() const;
+
+    ShaderProgram::TexelLayout texel_layout() const;
+
+    /**
+     * Whether the allocated textures can hold the current buffer contents,
+     * i.e. its dimensions, channels and type did not change since they were
+     * created
+     */
+    bool is_texture_storage_compatible() const;
+
     void update_object_pose();
 
+    /**
+     * Value in buffer units of a texel sampled as 1 by the buffer shader
+     */
+    float texel_value_scale() const;
+
+    bool is_comparing() const;
+
+    /**
+     * Makes the tile resident, returning whether its contents are ready to
+     * be sampled
+     */
+    bool prepare_tile(int tex_id, int tx, int ty);
+
     char pixel_layout_[4] = {'r', 'g', 'b', 'a'};
 
     float min_buffer_values_[4];
@@ -115,6 +393,55 @@ class Buffer : public Component
         {1.0, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0, 0.0};
     float angle_ = 0.f;
 
+    // Actual bounds of the buffer values, cached until the buffer changes
+    float value_lowest_[4];
+    float value_upper_[4];
+    bool are_value_bounds_outdated_ = true;
+
+    // Per block statistics of the buffer values, from which the bounds are
+    // taken once the buffer gets partial updates
+    BlockStatistics value_statistics_;
+    bool is_partially_updated_ = false;
+
+    uint64_t contents_revision_ = 0;
+
+    Histogram histogram_;
+    bool is_histogram_outdated_ = true;
+
+    PixelIndex pixel_index_;
+    bool is_pixel_index_outdated_ = true;
+
+    SummedAreaTable summed_area_table_;
+    bool is_summed_area_table_outdated_ = true;
+
+    Buffer* compare_reference_ = nullptr;
+    CompareMode compare_mode_  = CompareMode::None;
+    float compare_threshold_   = 0.f;
+
+    // Errors with the reference, valid for the given contents revisions
+    float compare_largest_[4];
+    float compare_mean_[4];
+    std::size_t compare_mismatches_ = 0;
+    uint64_t compared_revisions_[2];
+    bool are_comparison_errors_outdated_ = true;
+
+    int tex_width_       = 0;
+    int tex_height_      = 0;
+    int tex_channels_    = 0;
+    BufferType tex_type_ = BufferType::UnsignedByte;
+    bool tex_planar_     = false;
+
+    std::vector<bool> tile_resident_;
+    std::vector<bool> tile_uploaded_;
+
+    // Bit mask of the levels of detail built for each tile, the base level
+    // being bit 0
+    std::vector<uint32_t> tile_built_levels_;
+    std::vector<int> tile_selected_level_;
+
+    BufferRegion viewed_region_ = {0, 0, 0, 0};
+    int viewed_level_           = 0;
+
     ShaderProgram buff_prog;
     GLuint vbo;
 };
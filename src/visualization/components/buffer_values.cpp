@@ -23,7 +23,10 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
+#include <limits>
 
 #include <QFontMetrics>
 
@@ -32,6 +35,8 @@
 #include "buffer.h"
 #include "camera.h"
 #include "math/assorted.h"
+#include "math/buffer_type_dispatch.h"
+#include "math/number_format.h"
 #include "visualization/game_object.h"
 #include "visualization/stage.h"
 
@@ -47,6 +52,9 @@ BufferValues::BufferValues(GameObject* game_object, GLCanvas* gl_canvas)
 
 BufferValues::~BufferValues()
 {
+    if (glyphs_vbo_ != 0) {
+        gl_canvas_->glDeleteBuffers(1, &glyphs_vbo_);
+    }
 }
 
 
@@ -56,58 +64,73 @@ int BufferValues::render_index() const
 }
 
 
-inline void pix2str(const BufferType& type,
-                    const uint8_t* buffer,
-                    const int& pos,
-                    const int& channel,
-                    const int label_length,
-                    char* pix_label)
+// Labels longer than this don't fit in their pixel at a readable size
+const int max_label_digits = 7;
+
+
+/**
+ * Formats an integer value, in scientific notation if it doesn't fit in its
+ * pixel
+ */
+template <typename T>
+void pix2str(T value,
+             int,
+             int label_length,
+             char* pix_label,
+             std::true_type /* is_integer */)
 {
-    if (type == BufferType::Float32 ||
-        type == BufferType::Float64) {
-        float fpix = reinterpret_cast<const float*>(buffer)[pos + channel];
-        snprintf(pix_label, label_length, "%.3f", fpix);
-        if (strlen(pix_label) > 7)
-            snprintf(pix_label, label_length, "%.3e", fpix);
-    } else if (type == BufferType::UnsignedByte) {
-        snprintf(pix_label, label_length, "%d", buffer[pos + channel]);
-    } else if (type == BufferType::Short) {
-        short fpix = reinterpret_cast<const short*>(buffer)[pos + channel];
-        snprintf(pix_label, label_length, "%d", fpix);
-    } else if (type == BufferType::UnsignedShort) {
-        unsigned short fpix =
-            reinterpret_cast<const unsigned short*>(buffer)[pos + channel];
-        snprintf(pix_label, label_length, "%d", fpix);
-    } else if (type == BufferType::Int32) {
-        int fpix = reinterpret_cast<const int*>(buffer)[pos + channel];
-        snprintf(pix_label, label_length, "%d", fpix);
-        if (strlen(pix_label) > 7)
-            snprintf(pix_label, label_length, "%.3e", static_cast<float>(fpix));
+    if (format_integer(value, pix_label) > max_label_digits) {
+        format_float(static_cast<float>(value),
+                     3,
+                     max_label_digits,
+                     pix_label,
+                     label_length);
     }
 }
 
 
+template <typename T>
+void pix2str(T value,
+             int precision,
+             int label_length,
+             char* pix_label,
+             std::false_type /* is_integer */)
+{
+    format_float(static_cast<float>(value),
+                 precision,
+                 max_label_digits,
+                 pix_label,
+                 label_length);
+}
+
+
+/**
+ * Value normalized the same way it is sampled from the buffer textures
+ */
+template <typename T>
+float normalized_pixel_value(T value)
+{
+    return static_cast<float>(value) / normalized_value_scale<T>();
+}
+
+
 void BufferValues::draw(const mat4& projection, const mat4& view_inv)
 {
-    GameObject* cam_obj = game_object_->stage->get_game_object("camera");
-    Camera* camera      = cam_obj->get_component<Camera>("camera_component");
-    float zoom          = camera->compute_zoom();
+    Camera* camera = game_object_->stage->get_camera_component();
+    float zoom     = camera->compute_zoom();
 
     if (zoom > 40) {
+        gl_canvas_->get_text_renderer()->prepare_glyph_atlas();
+
         mat4 buffer_pose = game_object_->get_pose();
 
-        Buffer* buffer_component =
-            game_object_->get_component<Buffer>("buffer_component");
-        float buffer_width_f    = buffer_component->buffer_width_f;
-        float buffer_height_f   = buffer_component->buffer_height_f;
-        int step                = buffer_component->step;
-        int channels            = buffer_component->channels;
-        BufferType type = buffer_component->type;
-        const uint8_t* buffer         = buffer_component->buffer;
+        Buffer* buffer_component = game_object_->stage->get_buffer_component();
+        float buffer_width_f  = buffer_component->buffer_width_f;
+        float buffer_height_f = buffer_component->buffer_height_f;
 
         vec4 tl_ndc(-1, 1, 0, 1);
         vec4 br_ndc(1, -1, 0, 1);
-        mat4 vp_inv = (projection * view_inv * buffer_pose).inv();
+        mat4 vp_inv = (projection * view_inv * buffer_pose).affine_inv();
         vec4 tl     = vp_inv * tl_ndc;
         vec4 br     = vp_inv * br_ndc;
 
@@ -133,70 +156,319 @@ void BufferValues::draw(const mat4& projection, const mat4& view_inv)
                             -(buffer_height_f + 1) / 2.0f + 1.f,
                             (buffer_height_f + 1) / 2.0f);
 
-        int pos_center_x = -buffer_width_f / 2;
-        int pos_center_y = -buffer_height_f / 2;
-
-        const int label_length = 30;
-        char pix_label[label_length];
-
-        int pos;
-        float y_off;
-
-        // Offset for vertical channel position to account for padding
-        array<float, 4> recenter_factors;
-
-        if (channels == 1) {
-            recenter_factors = {0.f, 0.f, 0.f, 0.f};
-        } else if (channels == 2) {
-            float rfUp       = padding / 3.0 / channels;
-            recenter_factors = {rfUp, -rfUp, 0.f, 0.f};
-        } else if (channels == 3) {
-            float rfUp       = padding / 2.0 / channels;
-            recenter_factors = {rfUp, 0.f, -rfUp, 0.f};
-        } else if (channels == 4) {
-            float rfUp       = 3.f * padding / 5.f / channels;
-            float rfDown     = padding / 5.f / channels;
-            recenter_factors = {rfUp, rfDown, -rfDown, -rfUp};
+        // The glyphs are laid out in world coordinates, so panning and
+        // zooming only require a new layout once other pixels get visible
+        const int visible_range[4] = {lower_x, upper_x, lower_y, upper_y};
+        if (!equal(visible_range, visible_range + 4, glyphs_range_) ||
+            !equal(buffer_pose.data(),
+                   buffer_pose.data() + 16,
+                   glyphs_pose_.data()) ||
+            glyphs_buffer_ != buffer_component->buffer ||
+            glyphs_revision_ != buffer_component->contents_revision()) {
+            layout_glyphs(buffer_pose, lower_x, upper_x, lower_y, upper_y);
+
+            copy(visible_range, visible_range + 4, glyphs_range_);
+            glyphs_pose_     = buffer_pose;
+            glyphs_buffer_   = buffer_component->buffer;
+            glyphs_revision_ = buffer_component->contents_revision();
+        }
+
+        draw_glyphs(projection, view_inv);
+    }
+}
+
+
+void BufferValues::layout_glyphs(mat4& buffer_pose,
+                                 int lower_x,
+                                 int upper_x,
+                                 int lower_y,
+                                 int upper_y)
+{
+    const GLTextRenderer* text_renderer = gl_canvas_->get_text_renderer();
+
+    Buffer* buffer_component = game_object_->stage->get_buffer_component();
+    float buffer_width_f  = buffer_component->buffer_width_f;
+    float buffer_height_f = buffer_component->buffer_height_f;
+    int step              = buffer_component->step;
+    int channels          = buffer_component->channels;
+    BufferType type       = buffer_component->type;
+    const uint8_t* buffer = buffer_component->buffer;
+
+    glyphs_.clear();
+
+    // The host copy of the buffer may have been released to save memory
+    if (buffer == nullptr) {
+        return;
+    }
+
+    int pos_center_x = -buffer_width_f / 2;
+    int pos_center_y = -buffer_height_f / 2;
+
+    // Offset for vertical channel position to account for padding
+    array<float, 4> recenter_factors;
+
+    if (channels == 1) {
+        recenter_factors = {0.f, 0.f, 0.f, 0.f};
+    } else if (channels == 2) {
+        float rfUp       = padding / 3.0 / channels;
+        recenter_factors = {rfUp, -rfUp, 0.f, 0.f};
+    } else if (channels == 3) {
+        float rfUp       = padding / 2.0 / channels;
+        recenter_factors = {rfUp, 0.f, -rfUp, 0.f};
+    } else if (channels == 4) {
+        float rfUp       = 3.f * padding / 5.f / channels;
+        float rfDown     = padding / 5.f / channels;
+        recenter_factors = {rfUp, rfDown, -rfDown, -rfUp};
+    }
+
+    struct Label
+    {
+        const CachedLabel* cached;
+        float x;
+        float y;
+        float y_offset;
+    };
+
+    const int first_x = lower_x - pos_center_x;
+    const int first_y = lower_y - pos_center_y;
+    const int last_x  = upper_x - pos_center_x;
+    const int last_y  = upper_y - pos_center_y;
+
+    update_label_cache(first_x, first_y, last_x, last_y);
+
+    // Labels are gathered first, so that all of them are laid out with the
+    // scale required by the widest one
+    vector<Label> labels;
+    labels.reserve(static_cast<size_t>(last_x - first_x) *
+                   (last_y - first_y) * channels);
+
+    float paddingScale = 1.f / (1.f - 2.f * padding);
+
+    for (int y = first_y; y < last_y; ++y) {
+        for (int x = first_x; x < last_x; ++x) {
+            for (int c = 0; c < channels; ++c) {
+                Label label;
+                label.cached   = &cached_label(x, y, c);
+                label.x        = x + pos_center_x;
+                label.y        = y + pos_center_y;
+                label.y_offset = (0.5f * (channels - 1) - c) / channels -
+                                 recenter_factors[c];
+
+                text_pixel_scale =
+                    max(text_pixel_scale,
+                        max(label.cached->box_w, label.cached->box_h) *
+                            paddingScale * channels);
+
+                labels.push_back(label);
+            }
         }
+    }
 
-        for (int y = lower_y - pos_center_y; y < upper_y - pos_center_y; ++y) {
-            for (int x = lower_x - pos_center_x; x < upper_x - pos_center_x;
-                 ++x) {
-                pos = (y * step + x) * channels;
+    float sx = 1.0 / text_pixel_scale;
+    float sy = 1.0 / text_pixel_scale;
+
+    for (const Label& label : labels) {
+        vec4 centeredCoord(label.x, label.y, 0, 1);
+
+        if (static_cast<int>(buffer_width_f) % 2 == 0) {
+            centeredCoord.x() += 0.5f;
+        }
+        if (static_cast<int>(buffer_height_f) % 2 == 0) {
+            centeredCoord.y() += 0.5f;
+        }
+
+        centeredCoord = buffer_pose * centeredCoord;
+
+        const CachedLabel& cached = *label.cached;
+
+        float y = centeredCoord.y() + cached.box_h / 2.0 * sy - label.y_offset;
+        float x = centeredCoord.x() - cached.box_w / 2.0 * sx;
+
+        for (auto p = reinterpret_cast<const unsigned char*>(cached.text); *p;
+             p++) {
+            // Quads include the padding of the glyphs in the atlas, so
+            // that their smoothed outline isn't clipped
+            const int pad = GLTextRenderer::glyph_padding;
+
+            float x2 = x + (text_renderer->text_texture_tls[*p][0] - pad) * sx;
+            float y2 = y - (text_renderer->text_texture_tls[*p][1] + pad) * sy;
+
+            int tex_wid = text_renderer->text_texture_sizes[*p][0] + 2 * pad;
+            int tex_hei = text_renderer->text_texture_sizes[*p][1] + 2 * pad;
+
+            float tex_lower_x =
+                ((float)text_renderer->text_texture_offsets[*p][0] - pad) /
+                text_renderer->text_texture_width;
+            float tex_lower_y =
+                ((float)text_renderer->text_texture_offsets[*p][1] - pad) /
+                text_renderer->text_texture_height;
+            float tex_upper_x =
+                tex_lower_x +
+                (float)tex_wid / text_renderer->text_texture_width;
+            float tex_upper_y =
+                tex_lower_y +
+                (float)tex_hei / text_renderer->text_texture_height;
+
+            glyphs_.push_back({{x2, y2, tex_wid * sx, tex_hei * sy},
+                               {tex_lower_x,
+                                tex_lower_y,
+                                tex_upper_x,
+                                tex_upper_y},
+                               cached.intensity});
+
+            x += text_renderer->text_texture_advances[*p][0] * sx;
+            y += text_renderer->text_texture_advances[*p][1] * sy;
+        }
+    }
+
+    if (glyphs_vbo_ == 0) {
+        gl_canvas_->glGenBuffers(1, &glyphs_vbo_);
+    }
+
+    gl_canvas_->glBindBuffer(GL_ARRAY_BUFFER, glyphs_vbo_);
+    gl_canvas_->glBufferData(GL_ARRAY_BUFFER,
+                             glyphs_.size() * sizeof(Glyph),
+                             glyphs_.data(),
+                             GL_DYNAMIC_DRAW);
+}
+
+
+void BufferValues::update_label_cache(int first_x,
+                                      int first_y,
+                                      int last_x,
+                                      int last_y)
+{
+    Buffer* buffer_component = game_object_->stage->get_buffer_component();
+    const int buffer_width_i =
+        static_cast<int>(buffer_component->buffer_width_f);
+    const int buffer_height_i =
+        static_cast<int>(buffer_component->buffer_height_f);
+    const int channels        = buffer_component->channels;
+    const BufferType type     = buffer_component->type;
+    const uint8_t* buffer     = buffer_component->buffer;
+    const int precision       = game_object_->stage->value_label_precision;
+
+    const bool is_cache_valid =
+        label_cache_buffer_ == buffer &&
+        label_cache_revision_ == buffer_component->contents_revision() &&
+        label_cache_precision_ == precision &&
+        label_cache_channels_ == channels;
+
+    const int* window = label_cache_window_;
+    if (is_cache_valid && first_x >= window[0] && first_y >= window[1] &&
+        last_x <= window[0] + window[2] && last_y <= window[1] + window[3]) {
+        return;
+    }
+
+    // The new window covers the visible pixels and a margin around them,
+    // so that panning doesn't format labels again on every pixel step
+    const int new_window[4] = {
+        max(first_x - label_cache_margin, 0),
+        max(first_y - label_cache_margin, 0),
+        0,
+        0};
+    const int window_end_x = min(last_x + label_cache_margin, buffer_width_i);
+    const int window_end_y = min(last_y + label_cache_margin, buffer_height_i);
+
+    vector<CachedLabel> new_cache(
+        static_cast<size_t>(max(window_end_x - new_window[0], 0)) *
+        max(window_end_y - new_window[1], 0) * channels);
+
+    const GLTextRenderer* text_renderer = gl_canvas_->get_text_renderer();
+
+    // Double buffers are converted to float by the UI
+    visit_held_value_type(type, [&](auto value_type) {
+        using T         = typename decltype(value_type)::type;
+        using IsInteger = std::integral_constant<
+            bool,
+            std::numeric_limits<T>::is_integer>;
+
+        const T* values = reinterpret_cast<const T*>(buffer);
+
+        for (int y = new_window[1]; y < window_end_y; ++y) {
+            for (int x = new_window[0]; x < window_end_x; ++x) {
+                CachedLabel* labels =
+                    &new_cache[(static_cast<size_t>(y - new_window[1]) *
+                                    (window_end_x - new_window[0]) +
+                                (x - new_window[0])) *
+                               channels];
+
+                // Labels still valid in the previous window are reused
+                if (is_cache_valid && x >= window[0] && y >= window[1] &&
+                    x < window[0] + window[2] && y < window[1] + window[3]) {
+                    copy(&cached_label(x, y, 0),
+                         &cached_label(x, y, 0) + channels,
+                         labels);
+                    continue;
+                }
 
                 for (int c = 0; c < channels; ++c) {
-                    y_off = (0.5f * (channels - 1) - c) / channels -
-                            recenter_factors[c];
-
-                    pix2str(type, buffer, pos, c, label_length, pix_label);
-                    draw_text(projection,
-                              view_inv,
-                              buffer_pose,
-                              pix_label,
-                              x + pos_center_x,
-                              y + pos_center_y,
-                              y_off,
-                              channels);
+                    CachedLabel& label = labels[c];
+
+                    // Planar buffers don't keep the channels of a pixel
+                    // together
+                    const T value =
+                        values[buffer_component->value_index(x, y, c)];
+
+                    pix2str(value,
+                            precision,
+                            label_length,
+                            label.text,
+                            IsInteger());
+                    label.intensity = normalized_pixel_value(value);
+
+                    // Compute text box size
+                    label.box_w = 0;
+                    label.box_h = 0;
+                    for (auto p = reinterpret_cast<const unsigned char*>(
+                             label.text);
+                         *p;
+                         p++) {
+                        label.box_w +=
+                            text_renderer->text_texture_advances[*p][0];
+                        label.box_h = max(
+                            label.box_h,
+                            (float)text_renderer->text_texture_sizes[*p][1]);
+                    }
                 }
             }
         }
-    }
+    });
+
+    label_cache_.swap(new_cache);
+    label_cache_window_[0] = new_window[0];
+    label_cache_window_[1] = new_window[1];
+    label_cache_window_[2] = window_end_x - new_window[0];
+    label_cache_window_[3] = window_end_y - new_window[1];
+    label_cache_buffer_    = buffer;
+    label_cache_revision_  = buffer_component->contents_revision();
+    label_cache_precision_ = precision;
+    label_cache_channels_  = channels;
 }
 
 
-void BufferValues::draw_text(const mat4& projection,
-                             const mat4& view_inv,
-                             const mat4& buffer_pose,
-                             const char* text,
-                             float x,
-                             float y,
-                             float y_offset,
-                             float channels)
+const BufferValues::CachedLabel&
+BufferValues::cached_label(int x, int y, int channel) const
 {
+    const size_t index =
+        static_cast<size_t>(y - label_cache_window_[1]) *
+            label_cache_window_[2] +
+        (x - label_cache_window_[0]);
+
+    return label_cache_[index * label_cache_channels_ + channel];
+}
+
+
+void BufferValues::draw_glyphs(const mat4& projection, const mat4& view_inv)
+{
+    if (glyphs_.empty()) {
+        return;
+    }
+
     const GLTextRenderer* text_renderer = gl_canvas_->get_text_renderer();
+    const ShaderProgram& text_prog      = text_renderer->text_prog;
 
-    Buffer* buffer_component =
-        game_object_->get_component<Buffer>("buffer_component");
+    Buffer* buffer_component = game_object_->stage->get_buffer_component();
 
     const float* auto_buffer_contrast_brightness;
 
@@ -207,107 +479,64 @@ void BufferValues::draw_text(const mat4& projection,
         auto_buffer_contrast_brightness = Buffer::no_ac_params;
     }
 
-    text_renderer->text_prog.use();
-    gl_canvas_->glEnableVertexAttribArray(0);
-    gl_canvas_->glBindBuffer(GL_ARRAY_BUFFER, text_renderer->text_vbo);
-    gl_canvas_->glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
-
-    gl_canvas_->glActiveTexture(GL_TEXTURE0);
-    GLuint buff_tex = buffer_component->sub_texture_id_at_coord(
-        x + buffer_component->buffer_width_f / 2.f,
-        y + buffer_component->buffer_height_f / 2.f);
-    glBindTexture(GL_TEXTURE_2D, buff_tex);
-    text_renderer->text_prog.uniform1i("buff_sampler", 0);
+    text_prog.use();
 
     gl_canvas_->glActiveTexture(GL_TEXTURE1);
     glBindTexture(GL_TEXTURE_2D, text_renderer->text_tex);
-    text_renderer->text_prog.uniform1i("text_sampler", 1);
+    text_prog.uniform1i("text_sampler", 1);
 
-    text_renderer->text_prog.uniform_matrix4fv(
+    text_prog.uniform_matrix4fv(
         "mvp", 1, GL_FALSE, (projection * view_inv).data());
-    text_renderer->text_prog.uniform2f(
-        "pix_coord",
-        buffer_component->tile_coord_x(x +
-                                       buffer_component->buffer_width_f / 2.f),
-        buffer_component->tile_coord_y(y + buffer_component->buffer_height_f /
-                                               2.f));
-
-    text_renderer->text_prog.uniform4fv(
+    text_prog.uniform4fv(
         "brightness_contrast", 2, auto_buffer_contrast_brightness);
 
-    // Compute text box size
-    float boxW = 0, boxH = 0;
-    for (auto p = reinterpret_cast<const unsigned char*>(text); *p; p++) {
-        boxW += text_renderer->text_texture_advances[*p][0];
-        boxH = max(boxH, (float)text_renderer->text_texture_sizes[*p][1]);
-    }
-
-    float paddingScale = 1.f / (1.f - 2.f * padding);
-    text_pixel_scale =
-        max(text_pixel_scale, max(boxW, boxH) * paddingScale * channels);
-    float sx = 1.0 / text_pixel_scale;
-    float sy = 1.0 / text_pixel_scale;
-
-    vec4 channel_offset(0, y_offset, 0, 0);
+    const GLint corner_location = text_prog.attribute_location("corner");
+    const GLint glyph_locations[] = {
+        text_prog.attribute_location("glyph_rect"),
+        text_prog.attribute_location("glyph_uv"),
+        text_prog.attribute_location("glyph_value")};
+    const GLint glyph_sizes[]    = {4, 4, 1};
+    const size_t glyph_offsets[] = {offsetof(Glyph, rect),
+                                    offsetof(Glyph, uv),
+                                    offsetof(Glyph, value)};
+
+    // Corners of the quad shared by all glyphs
+    gl_canvas_->glEnableVertexAttribArray(corner_location);
+    gl_canvas_->glBindBuffer(GL_ARRAY_BUFFER, text_renderer->text_vbo);
+    gl_canvas_->glVertexAttribPointer(
+        corner_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+    if (text_renderer->is_instancing_supported) {
+        gl_canvas_->glBindBuffer(GL_ARRAY_BUFFER, glyphs_vbo_);
+        for (int i = 0; i < 3; ++i) {
+            gl_canvas_->glEnableVertexAttribArray(glyph_locations[i]);
+            gl_canvas_->glVertexAttribPointer(
+                glyph_locations[i],
+                glyph_sizes[i],
+                GL_FLOAT,
+                GL_FALSE,
+                sizeof(Glyph),
+                reinterpret_cast<const void*>(glyph_offsets[i]));
+            gl_canvas_->glVertexAttribDivisor(glyph_locations[i], 1);
+        }
 
-    vec4 centeredCoord(x, y, 0, 1);
+        gl_canvas_->glDrawArraysInstanced(
+            GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(glyphs_.size()));
 
-    if (static_cast<int>(buffer_component->buffer_width_f) % 2 == 0) {
-        centeredCoord.x() += 0.5f;
-    }
-    if (static_cast<int>(buffer_component->buffer_height_f) % 2 == 0) {
-        centeredCoord.y() += 0.5f;
+        for (int i = 0; i < 3; ++i) {
+            gl_canvas_->glVertexAttribDivisor(glyph_locations[i], 0);
+            gl_canvas_->glDisableVertexAttribArray(glyph_locations[i]);
+        }
+    } else {
+        // Without instanced arrays, the glyph attributes are set as
+        // constants for each quad
+        for (const Glyph& glyph : glyphs_) {
+            gl_canvas_->glVertexAttrib4fv(glyph_locations[0], glyph.rect);
+            gl_canvas_->glVertexAttrib4fv(glyph_locations[1], glyph.uv);
+            gl_canvas_->glVertexAttrib1f(glyph_locations[2], glyph.value);
+            gl_canvas_->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
     }
 
-    centeredCoord = buffer_pose * centeredCoord;
-
-    y = centeredCoord.y() + boxH / 2.0 * sy - channel_offset.y();
-    x = centeredCoord.x() - boxW / 2.0 * sx - channel_offset.x();
-
-    for (auto p = reinterpret_cast<const unsigned char*>(text); *p; p++) {
-        float x2 = x + text_renderer->text_texture_tls[*p][0] * sx;
-        float y2 = y - text_renderer->text_texture_tls[*p][1] * sy;
-
-        int tex_wid = text_renderer->text_texture_sizes[*p][0];
-        int tex_hei = text_renderer->text_texture_sizes[*p][1];
-
-        float w = tex_wid * sx;
-        float h = tex_hei * sy;
-
-        float tex_lower_x =
-            ((float)text_renderer->text_texture_offsets[*p][0]) /
-            text_renderer->text_texture_width;
-        float tex_lower_y =
-            ((float)text_renderer->text_texture_offsets[*p][1]) /
-            text_renderer->text_texture_height;
-        float tex_upper_x = tex_lower_x + ((float)tex_wid - 1.0f) /
-                                              text_renderer->text_texture_width;
-        float tex_upper_y =
-            tex_lower_y +
-            ((float)tex_hei - 1.0f) / text_renderer->text_texture_height;
-
-        /*
-         * box format: <pixel coord x, pixel coord y, texture coord x, texture
-         * coord y>
-         */
-        GLfloat box[4][4] = {
-            {x2, y2, tex_lower_x, tex_lower_y},
-            {x2 + w, y2, tex_upper_x, tex_lower_y},
-            {x2, y2 + h, tex_lower_x, tex_upper_y},
-            {x2 + w, y2 + h, tex_upper_x, tex_upper_y},
-        };
-
-        gl_canvas_->glBufferData(
-            GL_ARRAY_BUFFER, sizeof box, box, GL_DYNAMIC_DRAW);
-        gl_canvas_->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-
-        vec4 char_step_direction(
-            text_renderer->text_texture_advances[*p][0] * sx,
-            text_renderer->text_texture_advances[*p][1] * sy,
-            0.0,
-            1.0);
-
-        x += char_step_direction.x();
-        y += char_step_direction.y();
-    }
+    gl_canvas_->glDisableVertexAttribArray(corner_location);
 }
@@ -27,6 +27,7 @@
 #define BUFFER_VALUES_H_
 
 #include <iostream>
+#include <vector>
 
 #include <QFont>
 
@@ -50,19 +51,76 @@ class BufferValues : public Component
     virtual void draw(const mat4& projection, const mat4& view_inv);
 
   private:
+    // Quad of a single character, drawn as an instance of the text quad
+    struct Glyph
+    {
+        // Lower corner and size, in world coordinates
+        float rect[4];
+        // Lower and upper corners in the glyphs atlas
+        float uv[4];
+        // Normalized value of the labeled channel
+        float value;
+    };
+
+    // Formatted label of a single channel of a pixel
+    struct CachedLabel
+    {
+        char text[30];
+        float box_w;
+        float box_h;
+        // Normalized value of the labeled channel
+        float intensity;
+    };
+
     float text_pixel_scale         = 1.0;
     static float constexpr padding = 0.125f; // Must be smaller than 0.5
+    static const int label_length  = sizeof(CachedLabel::text);
+    // Pixels formatted around the visible ones, so that panning by a few
+    // pixels reuses the cached labels
+    static const int label_cache_margin = 16;
+
+    std::vector<Glyph> glyphs_;
+    GLuint glyphs_vbo_ = 0;
+
+    // Inputs of the current glyphs layout
+    int glyphs_range_[4]          = {0, 0, 0, 0};
+    mat4 glyphs_pose_;
+    const uint8_t* glyphs_buffer_ = nullptr;
+    uint64_t glyphs_revision_     = 0;
+
+    // Labels of the pixels inside label_cache_window_ (x, y, width, height),
+    // stored in row major order
+    std::vector<CachedLabel> label_cache_;
+    int label_cache_window_[4]         = {0, 0, 0, 0};
+    const uint8_t* label_cache_buffer_ = nullptr;
+    uint64_t label_cache_revision_     = 0;
+    int label_cache_precision_         = 0;
+    int label_cache_channels_          = 0;
 
     void generate_glyphs_texture();
 
-    void draw_text(const mat4& projection,
-                   const mat4& view_inv,
-                   const mat4& buffer_pose,
-                   const char* text,
-                   float x,
-                   float y,
-                   float y_offset,
-                   float channels);
+    /**
+     * Makes sure that the labels of all pixels in [first_x, last_x) x
+     * [first_y, last_y) are cached, formatting only the ones that are not
+     */
+    void update_label_cache(int first_x, int first_y, int last_x, int last_y);
+
+    const CachedLabel& cached_label(int x, int y, int channel) const;
+
+    /**
+     * Builds the glyphs of the labels of all pixels in the given range, and
+     * uploads them to the glyphs VBO
+     */
+    void layout_glyphs(mat4& buffer_pose,
+                       int lower_x,
+                       int upper_x,
+                       int lower_y,
+                       int upper_y);
+
+    /**
+     * Draws all glyphs with a single instanced draw call
+     */
+    void draw_glyphs(const mat4& projection, const mat4& view_inv);
 };
 
 #endif // BUFFER_VALUES_H_
@@ -79,8 +79,8 @@ void Camera::scroll_callback(float delta)
 {
     float mouse_x = gl_canvas_->mouse_x();
     float mouse_y = gl_canvas_->mouse_y();
-    float win_w   = gl_canvas_->width();
-    float win_h   = gl_canvas_->height();
+    float win_w   = gl_canvas_->viewport_width();
+    float win_h   = gl_canvas_->viewport_height();
 
     vec4 mouse_pos_ndc(2.0 * (mouse_x - win_w / 2) / win_w,
                        -2.0 * (mouse_y - win_h / 2) / win_h,
@@ -118,7 +118,8 @@ void Camera::update_object_pose()
 
 bool Camera::post_initialize()
 {
-    window_resized(gl_canvas_->width(), gl_canvas_->height());
+    window_resized(gl_canvas_->viewport_width(),
+                   gl_canvas_->viewport_height());
     set_initial_zoom();
     update_object_pose();
 
@@ -201,11 +202,11 @@ EventProcessCode Camera::key_press_event(int)
 
 void Camera::scale_at(const vec4& center_ndc, float delta)
 {
-    mat4 vp_inv = game_object_->get_pose() * projection.inv();
+    mat4 vp_inv = game_object_->get_pose() * projection.affine_inv();
 
     float delta_zoom = std::pow(zoom_factor, -delta);
 
-    vec4 center_pos = scale_.inv() * vp_inv * center_ndc;
+    vec4 center_pos = scale_.affine_inv() * vp_inv * center_ndc;
 
     // Since the view matrix of the camera is inverted before being applied
     // to the world coordinates, the order in which the operations below are
@@ -236,8 +237,8 @@ void Camera::scale_at(const vec4& center_ndc, float delta)
 
 void Camera::set_initial_zoom()
 {
-    GameObject* buffer_obj = game_object_->stage->get_game_object("buffer");
-    Buffer* buff = buffer_obj->get_component<Buffer>("buffer_component");
+    GameObject* buffer_obj = game_object_->stage->get_buffer_object();
+    Buffer* buff           = game_object_->stage->get_buffer_component();
 
     vec4 buf_dim = buffer_obj->get_pose() *
                    vec4(buff->buffer_width_f, buff->buffer_height_f, 0, 1);
@@ -286,9 +287,9 @@ float Camera::compute_zoom()
 
 void Camera::move_to(float x, float y)
 {
-    GameObject* buffer_obj = game_object_->stage->get_game_object("buffer");
+    GameObject* buffer_obj = game_object_->stage->get_buffer_object();
+    Buffer* buff           = game_object_->stage->get_buffer_component();
 
-    Buffer* buff = buffer_obj->get_component<Buffer>("buffer_component");
     vec4 buf_dim = vec4(buff->buffer_width_f, buff->buffer_height_f, 0, 1);
     vec4 centered_coord = buf_dim * 0.5f - vec4(x, y, 0, 0);
 
@@ -297,7 +298,7 @@ void Camera::move_to(float x, float y)
     scale_     = mat4::scale(vec4(zoom, zoom, 1.0, 1.0));
 
     vec4 transformed_goal =
-        scale_.inv() * buffer_obj->get_pose() * centered_coord;
+        scale_.affine_inv() * buffer_obj->get_pose() * centered_coord;
 
     camera_pos_x_ = transformed_goal.x();
     camera_pos_y_ = transformed_goal.y();
@@ -308,13 +309,14 @@ void Camera::move_to(float x, float y)
 
 vec4 Camera::get_position()
 {
-    GameObject* buffer_obj = game_object_->stage->get_game_object("buffer");
+    GameObject* buffer_obj = game_object_->stage->get_buffer_object();
+    Buffer* buff           = game_object_->stage->get_buffer_component();
 
-    Buffer* buff = buffer_obj->get_component<Buffer>("buffer_component");
     vec4 buf_dim = vec4(buff->buffer_width_f, buff->buffer_height_f, 0, 1);
     vec4 pos_vec(camera_pos_x_, camera_pos_y_, 0, 1);
 
-    return (buf_dim * 0.5f) - buffer_obj->get_pose().inv() * scale_ * pos_vec;
+    return (buf_dim * 0.5f) -
+           buffer_obj->get_pose().affine_inv() * scale_ * pos_vec;
 }
 
 
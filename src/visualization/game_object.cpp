@@ -23,8 +23,8 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <cmath>
-#include <map>
 
 #include "game_object.h"
 
@@ -42,8 +42,8 @@ GameObject::GameObject()
 
 bool GameObject::initialize()
 {
-    for (const auto& comp : all_components_) {
-        if (!comp.second->initialize()) {
+    for (const auto& comp : components_) {
+        if (!comp->initialize()) {
             return false;
         }
     }
@@ -53,8 +53,8 @@ bool GameObject::initialize()
 
 bool GameObject::post_initialize()
 {
-    for (const auto& comp : all_components_) {
-        if (!comp.second->post_initialize()) {
+    for (const auto& comp : components_) {
+        if (!comp->post_initialize()) {
             return false;
         }
     }
@@ -64,15 +64,26 @@ bool GameObject::post_initialize()
 
 void GameObject::update()
 {
-    for (const auto& comp : all_components_) {
-        comp.second->update();
+    for (const auto& comp : components_) {
+        comp->update();
     }
 }
 
+
 void GameObject::add_component(const std::string& component_name,
                                std::shared_ptr<Component> component)
 {
-    all_components_[component_name] = component;
+    const auto tag = std::lower_bound(
+        component_tags_.begin(), component_tags_.end(), component_name);
+    const auto index = tag - component_tags_.begin();
+
+    if (tag != component_tags_.end() && *tag == component_name) {
+        components_[index] = component;
+        return;
+    }
+
+    component_tags_.insert(tag, component_name);
+    components_.insert(components_.begin() + index, component);
 }
 
 
@@ -96,16 +107,16 @@ void GameObject::request_render_update()
 
 void GameObject::mouse_drag_event(int mouse_x, int mouse_y)
 {
-    for (const auto& comp : all_components_) {
-        comp.second->mouse_drag_event(mouse_x, mouse_y);
+    for (const auto& comp : components_) {
+        comp->mouse_drag_event(mouse_x, mouse_y);
     }
 }
 
 
 void GameObject::mouse_move_event(int mouse_x, int mouse_y)
 {
-    for (const auto& comp : all_components_) {
-        comp.second->mouse_move_event(mouse_x, mouse_y);
+    for (const auto& comp : components_) {
+        comp->mouse_move_event(mouse_x, mouse_y);
     }
 }
 
@@ -114,9 +125,9 @@ EventProcessCode GameObject::key_press_event(int key_code)
 {
     EventProcessCode event_intercepted = EventProcessCode::IGNORED;
 
-    for (const auto& comp : all_components_) {
+    for (const auto& comp : components_) {
         EventProcessCode event_intercepted_component =
-            comp.second->key_press_event(key_code);
+            comp->key_press_event(key_code);
 
         if (event_intercepted_component == EventProcessCode::INTERCEPTED) {
             event_intercepted = EventProcessCode::INTERCEPTED;
@@ -127,8 +138,7 @@ EventProcessCode GameObject::key_press_event(int key_code)
 }
 
 
-const std::map<std::string, std::shared_ptr<Component>>&
-GameObject::get_components()
+const std::vector<std::shared_ptr<Component>>& GameObject::get_components()
 {
-    return all_components_;
+    return components_;
 }
@@ -27,6 +27,8 @@
 #define GAME_OBJECT_H_
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "events.h"
 #include "math/linear_algebra.h"
@@ -44,12 +46,20 @@ class GameObject
 
     GameObject();
 
+    /**
+     * Component with the given tag, or nullptr if there is none or if it
+     * isn't a T. Components used on hot paths should rather be taken from
+     * the handles cached by the stage.
+     */
     template <typename T>
-    T* get_component(std::string tag)
+    T* get_component(const std::string& tag)
     {
-        if (all_components_.find(tag) == all_components_.end())
-            return nullptr;
-        return dynamic_cast<T*>(all_components_[tag].get());
+        for (std::size_t i = 0; i < component_tags_.size(); ++i) {
+            if (component_tags_[i] == tag) {
+                return dynamic_cast<T*>(components_[i].get());
+            }
+        }
+        return nullptr;
     }
 
     bool initialize();
@@ -73,10 +83,14 @@ class GameObject
 
     EventProcessCode key_press_event(int key_code);
 
-    const std::map<std::string, std::shared_ptr<Component>>& get_components();
+    // Components ordered by tag
+    const std::vector<std::shared_ptr<Component>>& get_components();
 
   private:
-    std::map<std::string, std::shared_ptr<Component>> all_components_;
+    // Few components are held by each object, so they are searched in a
+    // contiguous array rather than in a map. Both arrays are sorted by tag.
+    std::vector<std::string> component_tags_;
+    std::vector<std::shared_ptr<Component>> components_;
     mat4 pose_;
 };
 
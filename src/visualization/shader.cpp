@@ -27,27 +27,34 @@
 
 #include "shader.h"
 
+#include "ui/gl_program_cache.h"
+
 
 ShaderProgram::ShaderProgram(GLCanvas* gl_canvas)
     : program_(0)
     , gl_canvas_(gl_canvas)
+    , texel_storage_(StorageNormalized)
+    , texel_layout_(LayoutInterleaved)
 {
 }
 
 
 ShaderProgram::~ShaderProgram()
 {
-    gl_canvas_->glDeleteProgram(program_);
+    // The program itself is owned by the GLCanvas program cache
 }
 
 
 bool ShaderProgram::is_shader_outdated(TexelChannels texel_format,
+                                       TexelStorage texel_storage,
+                                       TexelLayout texel_layout,
                                        const std::vector<std::string>& uniforms,
                                        const char* pixel_layout)
 {
     // If the texel format or the uniform container size changed,
     // the program must be created again
-    if (texel_format != texel_format_ || uniforms.size() != uniforms_.size()) {
+    if (texel_format != texel_format_ || texel_storage != texel_storage_ ||
+        texel_layout != texel_layout_ || uniforms.size() != uniforms_.size()) {
         return true;
     }
 
@@ -73,37 +80,41 @@ bool ShaderProgram::create(const char* v_source,
                            const char* f_source,
                            TexelChannels texel_format,
                            const char* pixel_layout,
-                           const std::vector<std::string>& uniforms)
+                           const std::vector<std::string>& uniforms,
+                           TexelStorage texel_storage,
+                           TexelLayout texel_layout)
 {
     if (program_ != 0) {
-        // Check if the program needs to be recompiled
-        if (!is_shader_outdated(texel_format, uniforms, pixel_layout)) {
+        // Check if the program needs to be replaced
+        if (!is_shader_outdated(texel_format,
+                                texel_storage,
+                                texel_layout,
+                                uniforms,
+                                pixel_layout)) {
             return true;
         }
-        // Delete old program
-        gl_canvas_->glDeleteProgram(program_);
     }
 
-    texel_format_ = texel_format;
+    texel_format_  = texel_format;
+    texel_storage_ = texel_storage;
+    texel_layout_  = texel_layout;
     memcpy(pixel_layout_, pixel_layout, 4);
-    pixel_layout_[4]       = '\0';
-    GLuint vertex_shader   = compile(GL_VERTEX_SHADER, v_source);
-    GLuint fragment_shader = compile(GL_FRAGMENT_SHADER, f_source);
+    pixel_layout_[4] = '\0';
+
+    // Programs are shared with the other stages using the same definitions
+    program_ = gl_canvas_->get_program_cache()->get_program(v_source,
+                                                            f_source,
+                                                            texel_format_,
+                                                            pixel_layout_,
+                                                            texel_storage_,
+                                                            texel_layout_);
 
-    if (vertex_shader == 0 || fragment_shader == 0) {
+    if (program_ == 0) {
         return false;
     }
 
-    program_ = gl_canvas_->glCreateProgram();
-    gl_canvas_->glAttachShader(program_, vertex_shader);
-    gl_canvas_->glAttachShader(program_, fragment_shader);
-    gl_canvas_->glLinkProgram(program_);
-
-    // Delete shaders. We don't need them anymore.
-    gl_canvas_->glDeleteShader(vertex_shader);
-    gl_canvas_->glDeleteShader(fragment_shader);
-
     // Get uniform locations
+    uniforms_.clear();
     for (const auto& name : uniforms) {
         GLuint loc = gl_canvas_->glGetUniformLocation(program_, name.c_str());
         uniforms_[name] = loc;
@@ -119,6 +130,12 @@ void ShaderProgram::uniform1i(const std::string& name, int value) const
 }
 
 
+void ShaderProgram::uniform1f(const std::string& name, float value) const
+{
+    gl_canvas_->glUniform1f(uniforms_.at(name), value);
+}
+
+
 void ShaderProgram::uniform2f(const std::string& name, float x, float y) const
 {
     gl_canvas_->glUniform2f(uniforms_.at(name), x, y);
@@ -150,64 +167,13 @@ void ShaderProgram::uniform_matrix4fv(const std::string& name,
 }
 
 
-void ShaderProgram::use() const
-{
-    gl_canvas_->glUseProgram(program_);
-}
-
-
-GLuint ShaderProgram::compile(GLuint type, GLchar const* source)
+GLint ShaderProgram::attribute_location(const std::string& name) const
 {
-    GLuint shader = gl_canvas_->glCreateShader(type);
-
-    const char* src[] = {
-        "#version 120\n",
-
-        // clang-format off
-        texel_format_ == FormatR ?   "#define FORMAT_R\n" :
-        texel_format_ == FormatRG ?  "#define FORMAT_RG\n" :
-        texel_format_ == FormatRGB ? "#define FORMAT_RGB\n" :
-                                     "",
-        // clang-format on
-
-        "#define PIXEL_LAYOUT ",
-        pixel_layout_,
-
-        source};
-
-    gl_canvas_->glShaderSource(shader, 5, src, NULL);
-    gl_canvas_->glCompileShader(shader);
-
-    GLint compiled;
-    gl_canvas_->glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
-
-    if (!compiled) {
-        GLint length;
-        gl_canvas_->glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
-        std::string log(length, ' ');
-        gl_canvas_->glGetShaderInfoLog(shader, length, &length, &log[0]);
-        std::cerr << "Failed to compile shadertype: " + get_shader_type(type)
-                  << std::endl
-                  << log << std::endl;
-        return false;
-    }
-    return shader;
+    return gl_canvas_->glGetAttribLocation(program_, name.c_str());
 }
 
 
-std::string ShaderProgram::get_shader_type(GLuint type)
+void ShaderProgram::use() const
 {
-    std::string name;
-    switch (type) {
-    case GL_VERTEX_SHADER:
-        name = "Vertex Shader";
-        break;
-    case GL_FRAGMENT_SHADER:
-        name = "Fragment Shader";
-        break;
-    default:
-        name = "Unknown Shader type";
-        break;
-    }
-    return name;
+    gl_canvas_->glUseProgram(program_);
 }
@@ -41,6 +41,17 @@ class ShaderProgram
   public:
     enum TexelChannels { FormatR, FormatRG, FormatRGB, FormatRGBA };
 
+    // Integer textures can only be sampled from GLSL 1.30 onwards
+    enum TexelStorage {
+        StorageNormalized,
+        StorageInteger,
+        StorageUnsignedInteger
+    };
+
+    // Planar buffers are stored with a layer of an array texture per
+    // channel, which also requires GLSL 1.30
+    enum TexelLayout { LayoutInterleaved, LayoutPlanar };
+
     ShaderProgram(GLCanvas* gl_canvas);
 
     ~ShaderProgram();
@@ -49,11 +60,15 @@ class ShaderProgram
                 const char* f_source,
                 TexelChannels texel_format,
                 const char* pixel_layout,
-                const std::vector<std::string>& uniforms);
+                const std::vector<std::string>& uniforms,
+                TexelStorage texel_storage = StorageNormalized,
+                TexelLayout texel_layout   = LayoutInterleaved);
 
     // Uniform handlers
     void uniform1i(const std::string& name, int value) const;
 
+    void uniform1f(const std::string& name, float value) const;
+
     void uniform2f(const std::string& name, float x, float y) const;
 
     void
@@ -67,6 +82,8 @@ class ShaderProgram
                            GLboolean transpose,
                            const float* value) const;
 
+    GLint attribute_location(const std::string& name) const;
+
     // Program utility
     void use() const;
 
@@ -77,15 +94,17 @@ class ShaderProgram
 
     TexelChannels texel_format_;
 
-    std::map<std::string, GLuint> uniforms_;
+    TexelStorage texel_storage_;
 
-    char pixel_layout_[5];
+    TexelLayout texel_layout_;
 
-    GLuint compile(GLuint type, GLchar const* source);
+    std::map<std::string, GLuint> uniforms_;
 
-    std::string get_shader_type(GLuint type);
+    char pixel_layout_[5];
 
     bool is_shader_outdated(TexelChannels texel_format,
+                            TexelStorage texel_storage,
+                            TexelLayout texel_layout,
                             const std::vector<std::string>& uniforms,
                             const char* pixel_layout);
 };
@@ -28,42 +28,144 @@ namespace shader
 
 const char* buff_frag_shader = R"(
 
-uniform sampler2D sampler;
 uniform vec4 brightness_contrast[2];
-uniform vec2 buffer_dimension;
+// Center (xy) and size (zw) of the drawn tile
+uniform vec4 tile_rect;
 uniform int enable_borders;
 
+// 0 shows the buffer itself. Otherwise, the reference buffer is subtracted
+// from it and shown as: 1, the absolute difference; 2, the signed
+// difference around mid-gray; 3, white where any channel differs by more
+// than compare_threshold.
+uniform int compare_mode;
+uniform float compare_scale;
+uniform float compare_threshold;
+
 // Ouput data
 varying vec2 uv;
 
+#if defined(UNSIGNED_TEXELS) && defined(PLANAR_TEXELS)
+#define TEXEL_SAMPLER usampler2DArray
+#elif defined(UNSIGNED_TEXELS)
+#define TEXEL_SAMPLER usampler2D
+#elif defined(INTEGER_TEXELS) && defined(PLANAR_TEXELS)
+#define TEXEL_SAMPLER isampler2DArray
+#elif defined(INTEGER_TEXELS)
+#define TEXEL_SAMPLER isampler2D
+#elif defined(PLANAR_TEXELS)
+#define TEXEL_SAMPLER sampler2DArray
+#else
+#define TEXEL_SAMPLER sampler2D
+#endif
+
+uniform TEXEL_SAMPLER sampler;
+uniform TEXEL_SAMPLER reference_sampler;
+
+#if defined(PLANAR_TEXELS)
+// Each channel is stored in its own layer of an array texture
+vec4 sample_texel(TEXEL_SAMPLER texture_sampler, vec2 coord)
+{
+    vec4 texel = vec4(0.0, 0.0, 0.0, 1.0);
+    texel.r = float(texture(texture_sampler, vec3(coord, 0.0)).r);
+#if !defined(FORMAT_R)
+    texel.g = float(texture(texture_sampler, vec3(coord, 1.0)).r);
+#endif
+#if !defined(FORMAT_R) && !defined(FORMAT_RG)
+    texel.b = float(texture(texture_sampler, vec3(coord, 2.0)).r);
+#endif
+#if !defined(FORMAT_R) && !defined(FORMAT_RG) && !defined(FORMAT_RGB)
+    texel.a = float(texture(texture_sampler, vec3(coord, 3.0)).r);
+#endif
+    return texel;
+}
+#elif defined(INTEGER_TEXELS)
+vec4 sample_texel(TEXEL_SAMPLER texture_sampler, vec2 coord)
+{
+    return vec4(texture(texture_sampler, coord));
+}
+#else
+vec4 sample_texel(TEXEL_SAMPLER texture_sampler, vec2 coord)
+{
+    return texture2D(texture_sampler, coord);
+}
+#endif
+
+#if defined(INTEGER_TEXELS)
+#if defined(UNSIGNED_TEXELS)
+#define INTEGER_TEXEL_MAX 4294967295.0
+#else
+#define INTEGER_TEXEL_MAX 2147483647.0
+#endif
+
+// Normalizes texels the same way OpenGL converts integers uploaded to float
+// textures, so brightness_contrast is computed alike for all types
+vec4 fetch_texel(TEXEL_SAMPLER texture_sampler, vec2 coord)
+{
+    vec4 texel = sample_texel(texture_sampler, coord) / INTEGER_TEXEL_MAX;
+#if defined(FORMAT_R) || defined(FORMAT_RG) || defined(FORMAT_RGB)
+    texel.a = 1.0;
+#endif
+    return texel;
+}
+#else
+vec4 fetch_texel(TEXEL_SAMPLER texture_sampler, vec2 coord)
+{
+    return sample_texel(texture_sampler, coord);
+}
+#endif
+
+vec4 buffer_texel(vec2 coord)
+{
+    vec4 texel = fetch_texel(sampler, coord);
+    if (compare_mode == 0) {
+        return texel;
+    }
+
+    vec4 difference = texel - fetch_texel(reference_sampler, coord);
+
+    vec4 compared;
+    if (compare_mode == 1) {
+        compared = abs(difference) * compare_scale;
+    } else if (compare_mode == 2) {
+        compared = difference * (0.5 * compare_scale) + 0.5;
+    } else {
+        vec4 error = abs(difference);
+        float largest_error = max(max(error.r, error.g), max(error.b, error.a));
+        compared = vec4(largest_error > compare_threshold ? 1.0 : 0.0);
+    }
+    compared.a = 1.0;
+
+    return compared;
+}
+
 void main()
 {
     vec4 color;
 
 #if defined(FORMAT_R)
     // Output color = grayscale
-    color = texture2D(sampler, uv).rrra;
+    color = buffer_texel(uv).rrra;
     color.rgb = color.rgb * brightness_contrast[0].xxx +
                             brightness_contrast[1].xxx;
 #elif defined(FORMAT_RG)
     // Output color = two channels
-    color = texture2D(sampler, uv);
+    color = buffer_texel(uv);
     color.rg = color.rg * brightness_contrast[0].xy +
                           brightness_contrast[1].xy;
     color.b = 0.0;
 #elif defined(FORMAT_RGB)
     // Output color = rgb
-    color = texture2D(sampler, uv);
+    color = buffer_texel(uv);
     color.rgb = color.rgb * brightness_contrast[0].xyz +
                             brightness_contrast[1].xyz;
 #else
     // Output color = rgba
-    color = texture2D(sampler, uv);
+    color = buffer_texel(uv);
     color = color * brightness_contrast[0] +
                     brightness_contrast[1];
 #endif
 
-    vec2 buffer_position = uv * buffer_dimension;
+    vec2 buffer_position = uv * tile_rect.zw;
 
     if(enable_borders == 1) {
         float alpha = max(abs(dFdx(buffer_position.x)),
@@ -32,10 +32,13 @@ attribute vec2 input_position;
 varying vec2 uv;
 
 uniform mat4 mvp;
+// Center (xy) and size (zw) of the drawn tile
+uniform vec4 tile_rect;
 
 void main(void) {
     uv = input_position + vec2(0.5, 0.5);
-    gl_Position = mvp*vec4(input_position, 0.0, 1.0);
+    gl_Position = mvp*vec4(input_position * tile_rect.zw + tile_rect.xy,
+                           0.0, 1.0);
 }
 
 )";
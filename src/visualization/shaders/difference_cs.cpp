@@ -0,0 +1,219 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+namespace shader
+{
+
+const char* difference_comp_shader = R"(
+
+// Each invocation compares a block of texels of both buffers. The largest
+// errors and the mismatches are merged with atomic operations, while the
+// error sums are reduced per work group, then by error_sum_comp_shader.
+layout(local_size_x = 16, local_size_y = 16) in;
+
+const int block_size = 4;
+
+#if defined(UNSIGNED_TEXELS) && defined(PLANAR_TEXELS)
+#define TEXEL_SAMPLER usampler2DArray
+#elif defined(UNSIGNED_TEXELS)
+#define TEXEL_SAMPLER usampler2D
+#elif defined(INTEGER_TEXELS) && defined(PLANAR_TEXELS)
+#define TEXEL_SAMPLER isampler2DArray
+#elif defined(INTEGER_TEXELS)
+#define TEXEL_SAMPLER isampler2D
+#elif defined(PLANAR_TEXELS)
+#define TEXEL_SAMPLER sampler2DArray
+#else
+#define TEXEL_SAMPLER sampler2D
+#endif
+
+uniform TEXEL_SAMPLER sampler;
+uniform TEXEL_SAMPLER reference_sampler;
+
+uniform int channels;
+
+#if defined(PLANAR_TEXELS)
+// Each channel is stored in its own layer of an array texture
+vec4 fetch_texel(TEXEL_SAMPLER texture_sampler, ivec2 coord)
+{
+    vec4 texel = vec4(0.0);
+    for (int c = 0; c < channels; ++c) {
+        texel[c] = float(texelFetch(texture_sampler, ivec3(coord, c), 0).r);
+    }
+    return texel;
+}
+#else
+vec4 fetch_texel(TEXEL_SAMPLER texture_sampler, ivec2 coord)
+{
+    return vec4(texelFetch(texture_sampler, coord, 0));
+}
+#endif
+
+// Texels differing by more than the threshold in any channel are mismatches
+uniform float threshold;
+
+// Index of the first work group of the dispatch in partial_sums
+uniform int first_group;
+
+// The largest errors are non-negative, so their bits are ordered like them
+layout(std430, binding = 0) buffer Errors
+{
+    vec4 error_sum;
+    uint largest[4];
+    uint mismatches;
+};
+
+layout(std430, binding = 1) buffer PartialSums
+{
+    vec4 partial_sums[];
+};
+
+shared vec4 group_sums[256];
+shared uint group_largest[4];
+shared uint group_mismatches;
+
+void main()
+{
+    uint index = gl_LocalInvocationIndex;
+
+    if (index == 0u) {
+        for (int c = 0; c < 4; ++c) {
+            group_largest[c] = 0u;
+        }
+        group_mismatches = 0u;
+    }
+    barrier();
+
+    vec4 block_sum        = vec4(0.0);
+    vec4 block_largest    = vec4(0.0);
+    uint block_mismatches = 0u;
+
+    ivec2 size   = textureSize(sampler, 0).xy;
+    ivec2 origin = ivec2(gl_GlobalInvocationID.xy) * block_size;
+
+    for (int y = 0; y < block_size; ++y) {
+        for (int x = 0; x < block_size; ++x) {
+            ivec2 coord = origin + ivec2(x, y);
+            if (coord.x >= size.x || coord.y >= size.y) {
+                continue;
+            }
+
+            vec4 error = abs(fetch_texel(sampler, coord) -
+                             fetch_texel(reference_sampler, coord));
+
+            bool is_mismatch = false;
+            for (int c = 0; c < channels; ++c) {
+                // Errors between NaN values are left out
+                if (isnan(error[c])) {
+                    continue;
+                }
+                block_sum[c]     += error[c];
+                block_largest[c] = max(block_largest[c], error[c]);
+                is_mismatch      = is_mismatch || error[c] > threshold;
+            }
+
+            if (is_mismatch) {
+                ++block_mismatches;
+            }
+        }
+    }
+
+    group_sums[index] = block_sum;
+    for (int c = 0; c < channels; ++c) {
+        atomicMax(group_largest[c], floatBitsToUint(block_largest[c]));
+    }
+    atomicAdd(group_mismatches, block_mismatches);
+    barrier();
+
+    // Summing pairs keeps the rounding errors low on large buffers
+    for (uint stride = 128u; stride > 0u; stride >>= 1) {
+        if (index < stride) {
+            group_sums[index] += group_sums[index + stride];
+        }
+        barrier();
+    }
+
+    if (index == 0u) {
+        uint group = uint(first_group) +
+                     gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+        partial_sums[group] = group_sums[0];
+
+        for (int c = 0; c < channels; ++c) {
+            atomicMax(largest[c], group_largest[c]);
+        }
+        atomicAdd(mismatches, group_mismatches);
+    }
+}
+
+)";
+
+
+const char* error_sum_comp_shader = R"(
+
+// Sums the errors of all work groups of difference_comp_shader
+layout(local_size_x = 256) in;
+
+uniform int group_count;
+
+layout(std430, binding = 0) buffer Errors
+{
+    vec4 error_sum;
+    uint largest[4];
+    uint mismatches;
+};
+
+layout(std430, binding = 1) buffer PartialSums
+{
+    vec4 partial_sums[];
+};
+
+shared vec4 sums[256];
+
+void main()
+{
+    uint index = gl_LocalInvocationIndex;
+
+    vec4 sum = vec4(0.0);
+    for (uint group = index; group < uint(group_count); group += 256u) {
+        sum += partial_sums[group];
+    }
+    sums[index] = sum;
+    barrier();
+
+    for (uint stride = 128u; stride > 0u; stride >>= 1) {
+        if (index < stride) {
+            sums[index] += sums[index + stride];
+        }
+        barrier();
+    }
+
+    if (index == 0u) {
+        error_sum = sums[0];
+    }
+}
+
+)";
+
+} // namespace shader
@@ -0,0 +1,161 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 OpenImageDebugger contributors
+ * (https://github.com/OpenImageDebugger/OpenImageDebugger)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+namespace shader
+{
+
+const char* min_max_comp_shader = R"(
+
+// Each invocation reduces a block of texels, and each work group merges the
+// results of its invocations before updating the global bounds
+layout(local_size_x = 16, local_size_y = 16) in;
+
+const int block_size = 4;
+
+#if defined(UNSIGNED_TEXELS)
+#define TEXEL uvec4
+#elif defined(INTEGER_TEXELS)
+#define TEXEL ivec4
+#else
+#define TEXEL vec4
+#endif
+
+#if defined(UNSIGNED_TEXELS) && defined(PLANAR_TEXELS)
+uniform usampler2DArray sampler;
+#elif defined(UNSIGNED_TEXELS)
+uniform usampler2D sampler;
+#elif defined(INTEGER_TEXELS) && defined(PLANAR_TEXELS)
+uniform isampler2DArray sampler;
+#elif defined(INTEGER_TEXELS)
+uniform isampler2D sampler;
+#elif defined(PLANAR_TEXELS)
+uniform sampler2DArray sampler;
+#else
+uniform sampler2D sampler;
+#endif
+
+uniform int channels;
+
+#if defined(PLANAR_TEXELS)
+// Each channel is stored in its own layer of an array texture
+TEXEL fetch_texel(ivec2 coord)
+{
+    TEXEL texel = TEXEL(0);
+    for (int c = 0; c < channels; ++c) {
+        texel[c] = texelFetch(sampler, ivec3(coord, c), 0).r;
+    }
+    return texel;
+}
+#else
+TEXEL fetch_texel(ivec2 coord)
+{
+    return texelFetch(sampler, coord, 0);
+}
+#endif
+
+// Bounds are kept as unsigned integers ordered like the original values, so
+// they can be updated with atomic operations
+layout(std430, binding = 0) buffer Bounds
+{
+    uint lowest[4];
+    uint upper[4];
+};
+
+shared uint group_lowest[4];
+shared uint group_upper[4];
+
+uint sortable_value(float value)
+{
+    uint bits = floatBitsToUint(value);
+    return (bits & 0x80000000u) != 0u ? ~bits : bits | 0x80000000u;
+}
+
+uint sortable_value(int value)
+{
+    return uint(value) ^ 0x80000000u;
+}
+
+uint sortable_value(uint value)
+{
+    return value;
+}
+
+void main()
+{
+    if (gl_LocalInvocationIndex == 0u) {
+        for (int c = 0; c < 4; ++c) {
+            group_lowest[c] = 0xFFFFFFFFu;
+            group_upper[c]  = 0u;
+        }
+    }
+    barrier();
+
+    uint block_lowest[4] = uint[4](0xFFFFFFFFu, 0xFFFFFFFFu,
+                                   0xFFFFFFFFu, 0xFFFFFFFFu);
+    uint block_upper[4]  = uint[4](0u, 0u, 0u, 0u);
+
+    ivec2 size   = textureSize(sampler, 0).xy;
+    ivec2 origin = ivec2(gl_GlobalInvocationID.xy) * block_size;
+
+    for (int y = 0; y < block_size; ++y) {
+        for (int x = 0; x < block_size; ++x) {
+            ivec2 coord = origin + ivec2(x, y);
+            if (coord.x >= size.x || coord.y >= size.y) {
+                continue;
+            }
+
+            TEXEL texel = fetch_texel(coord);
+
+            for (int c = 0; c < channels; ++c) {
+#if !defined(INTEGER_TEXELS)
+                // Infinite and NaN values don't take part in auto-contrast
+                if (isnan(texel[c]) || isinf(texel[c])) {
+                    continue;
+                }
+#endif
+                uint value      = sortable_value(texel[c]);
+                block_lowest[c] = min(block_lowest[c], value);
+                block_upper[c]  = max(block_upper[c], value);
+            }
+        }
+    }
+
+    for (int c = 0; c < channels; ++c) {
+        atomicMin(group_lowest[c], block_lowest[c]);
+        atomicMax(group_upper[c], block_upper[c]);
+    }
+    barrier();
+
+    if (gl_LocalInvocationIndex == 0u) {
+        for (int c = 0; c < channels; ++c) {
+            atomicMin(lowest[c], group_lowest[c]);
+            atomicMax(upper[c], group_upper[c]);
+        }
+    }
+}
+
+)";
+
+} // namespace shader
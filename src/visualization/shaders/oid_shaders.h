@@ -36,6 +36,9 @@ extern const char* text_frag_shader;
 extern const char* text_vert_shader;
 extern const char* background_vert_shader;
 extern const char* background_frag_shader;
+extern const char* min_max_comp_shader;
+extern const char* difference_comp_shader;
+extern const char* error_sum_comp_shader;
 
 } // namespace shader
 
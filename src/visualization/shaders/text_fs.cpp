@@ -28,14 +28,13 @@ namespace shader
 
 const char* text_frag_shader = R"(
 
-uniform sampler2D buff_sampler;
 uniform sampler2D text_sampler;
-uniform vec2 pix_coord;
 uniform vec4 brightness_contrast[2];
 
 
 // Ouput data
 varying vec2 uv;
+varying float buff_value;
 
 
 float round_float(float f) {
@@ -52,15 +51,19 @@ void main()
 {
     vec4 color;
     // Output color = red
-    float buff_color = texture2D(buff_sampler, pix_coord).r;
-    buff_color = buff_color * brightness_contrast[0].x +
+    float buff_color = buff_value * brightness_contrast[0].x +
                               brightness_contrast[1].x;
 
     if (oid_isnan(buff_color)) {
         buff_color = 0.0;
     }
 
-    float text_color = texture2D(text_sampler, uv).r;
+    // The atlas holds the distance to the glyph outlines, which lie at 0.5.
+    // Their edges are smoothed over about a pixel of the screen, whatever the
+    // zoom level.
+    float distance = texture2D(text_sampler, uv).r;
+    float smoothing = max(0.7 * fwidth(distance), 1e-4);
+    float text_color = smoothstep(0.5 - smoothing, 0.5 + smoothing, distance);
     float pix_intensity = round_float(1.0 - buff_color);
 
     color = vec4(vec3(pix_intensity), text_color);
@@ -28,14 +28,25 @@ namespace shader
 
 const char* text_vert_shader = R"(
 
-attribute vec4 input_position;
+// Corner of the glyph quad, in [0, 1]
+attribute vec2 corner;
+
+// Per glyph attributes: lower corner and size of the quad, its coordinates
+// in the glyphs atlas and the value of the labeled channel
+attribute vec4 glyph_rect;
+attribute vec4 glyph_uv;
+attribute float glyph_value;
+
 varying vec2 uv;
+varying float buff_value;
 
 uniform mat4 mvp;
 
 void main(void) {
-    gl_Position = mvp * vec4(input_position.xy, 0.0, 1.0);
-    uv = input_position.zw;
+    vec2 position = glyph_rect.xy + corner * glyph_rect.zw;
+    gl_Position = mvp * vec4(position, 0.0, 1.0);
+    uv = mix(glyph_uv.xy, glyph_uv.zw, corner);
+    buff_value = glyph_value;
 }
 
 )";
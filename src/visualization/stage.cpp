@@ -23,7 +23,7 @@
  * IN THE SOFTWARE.
  */
 
-#include <set>
+#include <algorithm>
 
 #include "stage.h"
 
@@ -37,15 +37,6 @@
 using namespace std;
 
 
-struct compareRenderOrder
-{
-    bool operator()(const Component* a, const Component* b) const
-    {
-        return a->render_index() < b->render_index();
-    }
-};
-
-
 Stage::Stage(MainWindow* main_wnd)
     : main_window(main_wnd)
 {
@@ -59,7 +50,8 @@ bool Stage::initialize(const uint8_t* buffer,
                        BufferType type,
                        int step,
                        const string& pixel_layout,
-                       bool transpose_buffer)
+                       bool transpose_buffer,
+                       bool is_planar)
 {
     std::shared_ptr<GameObject> camera_obj = std::make_shared<GameObject>();
 
@@ -92,11 +84,30 @@ bool Stage::initialize(const uint8_t* buffer,
     buffer_component->buffer_height_f = static_cast<float>(buffer_height_i);
     buffer_component->step            = step;
     buffer_component->transpose       = transpose_buffer;
+    buffer_component->is_planar       = is_planar;
     buffer_component->set_pixel_layout(pixel_layout);
     buffer_obj->add_component("buffer_component", buffer_component);
 
     all_game_objects["buffer"] = buffer_obj;
 
+    camera_object_    = camera_obj.get();
+    buffer_object_    = buffer_obj.get();
+    camera_component_ = camera_obj->get_component<Camera>("camera_component");
+    buffer_component_ = buffer_component.get();
+
+    // The render indices don't change, so the components are sorted once
+    draw_list_.clear();
+    for (const auto& go : all_game_objects) {
+        for (const auto& component : go.second->get_components()) {
+            draw_list_.push_back(component.get());
+        }
+    }
+    stable_sort(draw_list_.begin(),
+                draw_list_.end(),
+                [](const Component* a, const Component* b) {
+                    return a->render_index() < b->render_index();
+                });
+
     for (const auto& go : all_game_objects) {
         if (!go.second->initialize()) {
             return false;
@@ -120,26 +131,24 @@ bool Stage::buffer_update(const uint8_t* buffer,
                           BufferType type,
                           int step,
                           const string& pixel_layout,
-                          bool transpose_buffer)
+                          bool transpose_buffer,
+                          bool is_planar)
 {
-    GameObject* buffer_obj = all_game_objects["buffer"].get();
-    Buffer* buffer_component =
-        buffer_obj->get_component<Buffer>("buffer_component");
-
-    buffer_component->buffer          = buffer;
-    buffer_component->channels        = channels;
-    buffer_component->type            = type;
-    buffer_component->buffer_width_f  = static_cast<float>(buffer_width_i);
-    buffer_component->buffer_height_f = static_cast<float>(buffer_height_i);
-    buffer_component->step            = step;
-    buffer_component->transpose       = transpose_buffer;
-    buffer_component->set_pixel_layout(pixel_layout);
+    buffer_component_->buffer          = buffer;
+    buffer_component_->channels        = channels;
+    buffer_component_->type            = type;
+    buffer_component_->buffer_width_f  = static_cast<float>(buffer_width_i);
+    buffer_component_->buffer_height_f = static_cast<float>(buffer_height_i);
+    buffer_component_->step            = step;
+    buffer_component_->transpose       = transpose_buffer;
+    buffer_component_->is_planar       = is_planar;
+    buffer_component_->set_pixel_layout(pixel_layout);
 
     for (const auto& game_obj_it : all_game_objects) {
         GameObject* game_obj = game_obj_it.second.get();
         game_obj->stage      = this;
         for (const auto& comp : game_obj->get_components()) {
-            if (!comp.second->buffer_update()) {
+            if (!comp->buffer_update()) {
                 return false;
             }
         }
@@ -148,7 +157,7 @@ bool Stage::buffer_update(const uint8_t* buffer,
     for (const auto& game_obj_it : all_game_objects) {
         GameObject* game_obj = game_obj_it.second.get();
         for (const auto& comp : game_obj->get_components()) {
-            if (!comp.second->post_buffer_update()) {
+            if (!comp->post_buffer_update()) {
                 return false;
             }
         }
@@ -158,13 +167,33 @@ bool Stage::buffer_update(const uint8_t* buffer,
 }
 
 
-GameObject* Stage::get_game_object(string tag)
+bool Stage::buffer_update_regions(const vector<BufferRegion>& regions)
 {
-    if (all_game_objects.find(tag) == all_game_objects.end()) {
+    for (const auto& region : regions) {
+        buffer_component_->update_region(
+            region.x, region.y, region.width, region.height);
+    }
+
+    buffer_component_->reset_contrast_brightness_parameters();
+
+    return true;
+}
+
+
+bool Stage::has_pending_uploads()
+{
+    return buffer_component_->has_pending_uploads();
+}
+
+
+GameObject* Stage::get_game_object(const string& tag)
+{
+    const auto game_obj = all_game_objects.find(tag);
+    if (game_obj == all_game_objects.end()) {
         return nullptr;
     }
 
-    return all_game_objects[tag].get();
+    return game_obj->second.get();
 }
 
 
@@ -178,47 +207,29 @@ void Stage::update()
 
 void Stage::draw()
 {
-    set<Component*, compareRenderOrder> ordered_components;
-
     // TODO use camera tags so I can have multiple cameras (useful for drawing
     // GUI)
 
-    GameObject* camera_obj = all_game_objects["camera"].get();
-    Camera* camera_component =
-        camera_obj->get_component<Camera>("camera_component");
-
-    if (camera_component == nullptr)
+    if (camera_component_ == nullptr)
         return;
 
-    mat4 view_inv = camera_obj->get_pose().inv();
+    mat4 view_inv = camera_object_->get_pose().affine_inv();
 
-    for (const auto& game_obj : all_game_objects) {
-        for (const auto& component : game_obj.second->get_components()) {
-            ordered_components.insert(component.second.get());
-        }
-    }
-
-    for (const auto& component : ordered_components) {
-        component->draw(camera_component->projection, view_inv);
+    for (Component* component : draw_list_) {
+        component->draw(camera_component_->projection, view_inv);
     }
 }
 
 
 void Stage::scroll_callback(float delta)
 {
-    GameObject* cam_obj = all_game_objects["camera"].get();
-    Camera* camera_component =
-        cam_obj->get_component<Camera>("camera_component");
-    camera_component->scroll_callback(delta);
+    camera_component_->scroll_callback(delta);
 }
 
 
 void Stage::resize_callback(int w, int h)
 {
-    GameObject* cam_obj = all_game_objects["camera"].get();
-    Camera* camera_component =
-        cam_obj->get_component<Camera>("camera_component");
-    camera_component->window_resized(w, h);
+    camera_component_->window_resized(w, h);
 }
 
 
@@ -257,9 +268,5 @@ EventProcessCode Stage::key_press_event(int key_code)
 
 void Stage::go_to_pixel(float x, float y)
 {
-    GameObject* cam_obj = all_game_objects["camera"].get();
-    Camera* camera_component =
-        cam_obj->get_component<Camera>("camera_component");
-
-    camera_component->move_to(x, y);
+    camera_component_->move_to(x, y);
 }
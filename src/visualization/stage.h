@@ -28,10 +28,14 @@
 
 #include <map>
 #include <memory>
+#include <vector>
 
+#include "ipc/buffer_tiles.h"
 #include "visualization/components/buffer.h"
 
 
+class Camera;
+class Component;
 class GameObject;
 
 
@@ -39,7 +43,17 @@ class Stage
 {
   public:
     bool contrast_enabled;
-    std::vector<uint8_t> buffer_icon;
+    // Percentiles of the buffer values used as auto-contrast bounds
+    float contrast_percentiles[2] = {0.f, 100.f};
+    // Reduction used to build the levels of detail of zoomed out buffers
+    DownsampleFilter lod_filter = DownsampleFilter::Average;
+    // Decimal digits of the pixel value labels. Negative values select the
+    // shortest representation that round-trips to the same value.
+    int value_label_precision = 3;
+    // Incremented each time the stage gets selected, so that the buffers
+    // unused for the longest are released first under memory pressure
+    uint64_t selection_order = 0;
+    BufferMetadata buffer_metadata;
     MainWindow* main_window;
 
     Stage(MainWindow* main_window);
@@ -51,7 +65,8 @@ class Stage
                     BufferType type,
                     int step,
                     const std::string& pixel_layout,
-                    bool transpose_buffer);
+                    bool transpose_buffer,
+                    bool is_planar);
 
     bool buffer_update(const uint8_t* buffer,
                        int buffer_width_i,
@@ -60,9 +75,38 @@ class Stage
                        BufferType type,
                        int step,
                        const std::string& pixel_layout,
-                       bool transpose_buffer);
+                       bool transpose_buffer,
+                       bool is_planar);
 
-    GameObject* get_game_object(std::string tag);
+    // Refreshes the given regions after the buffer contents were patched in
+    // place. The buffer geometry is left untouched.
+    bool buffer_update_regions(const std::vector<BufferRegion>& regions);
+
+    GameObject* get_game_object(const std::string& tag);
+
+    // Objects and components of the stage, cached once it is initialized
+    GameObject* get_camera_object()
+    {
+        return camera_object_;
+    }
+
+    GameObject* get_buffer_object()
+    {
+        return buffer_object_;
+    }
+
+    Camera* get_camera_component()
+    {
+        return camera_component_;
+    }
+
+    Buffer* get_buffer_component()
+    {
+        return buffer_component_;
+    }
+
+    // Whether the buffer contents are still being uploaded to the GPU
+    bool has_pending_uploads();
 
     void update();
 
@@ -82,6 +126,15 @@ class Stage
 
   private:
     std::map<std::string, std::shared_ptr<GameObject>> all_game_objects;
+
+    GameObject* camera_object_ = nullptr;
+    GameObject* buffer_object_ = nullptr;
+    Camera* camera_component_  = nullptr;
+    Buffer* buffer_component_  = nullptr;
+
+    // Components of all objects by order of render index, sorted when the
+    // stage is initialized
+    std::vector<Component*> draw_list_;
 };
 
 #endif // STAGE_H_
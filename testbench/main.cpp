@@ -2,13 +2,18 @@
  * Minimal OpenCV Mat simulator; for testing purposes only.
  */
 #include <cassert>
+#include <chrono>
 #include <cinttypes>
 #include <cmath>
 #include <cstring>
+#include <dirent.h>
+#include <fstream>
 #include <functional>
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <sstream>
+#include <string>
 #include <thread>
 #include <type_traits>
 #include <unistd.h>
@@ -375,9 +380,94 @@ void bodyCaller()
     t.join();
 }
 
-int main(int, char*[])
+// Reads the CPU time, in clock ticks, used so far by the first running
+// process with the given name
+bool readProcessCpuTicks(const string& name, unsigned long long& ticks)
 {
-    bodyCaller();
+    DIR* proc = opendir("/proc");
+    if (proc == nullptr) {
+        return false;
+    }
+
+    bool found = false;
+    while (dirent* entry = readdir(proc)) {
+        const string pid = entry->d_name;
+        if (pid.find_first_not_of("0123456789") != string::npos) {
+            continue;
+        }
+
+        string comm;
+        ifstream("/proc/" + pid + "/comm") >> comm;
+        if (comm != name) {
+            continue;
+        }
+
+        // The process name may contain spaces, so fields are counted from
+        // the end of the parenthesized name
+        string stat;
+        getline(ifstream("/proc/" + pid + "/stat"), stat);
+        istringstream fields(stat.substr(stat.rfind(')') + 2));
+
+        // Skip fields 3 to 13; utime and stime are fields 14 and 15
+        string skipped;
+        for (int i = 3; i < 14; ++i) {
+            fields >> skipped;
+        }
+
+        unsigned long long utime = 0;
+        unsigned long long stime = 0;
+        fields >> utime >> stime;
+
+        ticks = utime + stime;
+        found = true;
+        break;
+    }
+
+    closedir(proc);
+
+    return found;
+}
+
+// Measures the CPU usage of an idle debugger window
+void idleCpuScenario()
+{
+    const int W = 1024;
+    const int H = 1024;
+    Mat idleField;
+    fillBuffer<uint8_t>(W, H, 3, idleField);
+
+    // Breakpoint should go here! Plot idleField, leave the window alone,
+    // then continue
+    const string window_name = "oidwindow";
+    const int duration_s     = 10;
+
+    unsigned long long start_ticks = 0;
+    if (!readProcessCpuTicks(window_name, start_ticks)) {
+        cout << "No running " << window_name << " process" << endl;
+        return;
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(duration_s));
+
+    unsigned long long end_ticks = 0;
+    if (!readProcessCpuTicks(window_name, end_ticks)) {
+        cout << window_name << " exited during the measurement" << endl;
+        return;
+    }
+
+    const double cpu_time = static_cast<double>(end_ticks - start_ticks) /
+                            sysconf(_SC_CLK_TCK);
+    cout << "Idle " << window_name << " CPU usage: "
+         << 100.0 * cpu_time / duration_s << "%" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "--idle-cpu") == 0) {
+        idleCpuScenario();
+    } else {
+        bodyCaller();
+    }
 
     return 0;
 }